@@ -238,6 +238,7 @@ extern "C" {
 #define STATUS_NET_SET_SOCKET_FLAG_FAILED             STATUS_NET_BASE + 0x0000000B
 #define STATUS_NET_CLOSE_SOCKET_FAILED                STATUS_NET_BASE + 0x0000000C
 #define STATUS_NET_RECV_DATA_FAILED                   STATUS_NET_BASE + 0x0000000D
+#define STATUS_NET_SOCKET_SET_DONT_FRAGMENT_FAILED    STATUS_NET_BASE + 0x0000000E
 /******************************************************************************
  * Socket error codes
  ******************************************************************************/
@@ -367,6 +368,13 @@ extern "C" {
 #define STATUS_RTP_NULL_ARG               STATUS_RTP_BASE + 0x00000005
 #define STATUS_RTP_BUFFER_TOO_SMALL       STATUS_RTP_BASE + 0x00000006
 #define STATUS_RTP_NOT_ENOUGH_MEMORY      STATUS_RTP_BASE + 0x00000007
+#define STATUS_RTP_EXTENSION_NOT_FOUND    STATUS_RTP_BASE + 0x00000008
+#define STATUS_RTP_INVALID_OBU            STATUS_RTP_BASE + 0x00000009
+#define STATUS_RTP_INVALID_RID            STATUS_RTP_BASE + 0x0000000A
+#define STATUS_RTP_MAX_ENCODINGS_EXCEEDED STATUS_RTP_BASE + 0x0000000B
+#define STATUS_RTP_INVALID_FEC_PACKET     STATUS_RTP_BASE + 0x0000000C
+#define STATUS_RTP_INVALID_RED_PACKET     STATUS_RTP_BASE + 0x0000000D
+#define STATUS_RTP_INVALID_OPUS_PACKET    STATUS_RTP_BASE + 0x0000000E
 /******************************************************************************
  * Signaling error codes
  ******************************************************************************/
@@ -479,6 +487,7 @@ extern "C" {
 #define STATUS_RTCP_INPUT_REMB_TOO_SMALL         STATUS_RTCP_BASE + 0x00000007
 #define STATUS_RTCP_INPUT_REMB_INVALID           STATUS_RTCP_BASE + 0x00000008
 #define STATUS_RTCP_NULL_ARG                     STATUS_RTCP_BASE + 0x00000009
+#define STATUS_RTCP_INPUT_TWCC_INVALID           STATUS_RTCP_BASE + 0x0000000A
 /******************************************************************************
  * Rolling buffer error codes
  ******************************************************************************/
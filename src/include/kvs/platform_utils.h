@@ -36,6 +36,8 @@ extern "C" {
 #define WSS_DISPATCH_THREAD_SIZE  10240
 #define PEER_TIMER_NAME           "peerTimer"
 #define PEER_TIMER_SIZE           10240
+#define FRAME_QUEUE_THREAD_NAME   "frameQueue" //!< the parameters of the frame queue workers.
+#define FRAME_QUEUE_THREAD_SIZE   10240
 
 // Tag for the logging
 #ifndef LOG_CLASS
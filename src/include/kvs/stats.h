@@ -117,6 +117,7 @@ typedef enum {
     RTC_STATS_TYPE_TRANSPORT,           //!< Transport statistics related to the RTCPeerConnection object.
     RTC_STATS_TYPE_SCTP_TRANSPORT,      //!< SCTP transport statistics related to an RTCSctpTransport object
     RTC_STATS_TYPE_TRANSCEIVER,         //!< Statistics related to a specific RTCRtpTransceiver
+    RTC_STATS_TYPE_RTP_PACKET_POOL,     //!< Non-standard. Usage of the rtp packet pool shared by the RTP streams of the RTCPeerConnection object
     RTC_STATS_TYPE_RTC_ALL              //!< Report all supported stats
 } RTC_STATS_TYPE;
 
@@ -354,7 +355,7 @@ typedef struct {
     UINT32 sliCount;              //!< Only valid for video. Count the total number of Slice Loss Indication (SLI) packets received by this sender
     UINT32 qualityLimitationResolutionChanges; //!< Only valid for video. The number of times that the resolution has changed because we are quality
                                                //!< limited
-    INT32 fecPacketsSent; //!< TODO Total number of RTP FEC packets sent for this SSRC. Can also be incremented while sending FEC packets in band
+    INT32 fecPacketsSent; //!< Total number of RTP FEC packets sent for this SSRC. Can also be incremented while sending FEC packets in band
     UINT64 lastPacketSentTimestamp;  //!< The timestamp in milliseconds at which the last packet was sent for this SSRC
     UINT64 headerBytesSent;          //!< Total number of RTP header and padding bytes sent for this SSRC
     UINT64 bytesDiscardedOnSend;     //!< Total number of bytes for this SSRC that have been discarded due to socket errors
@@ -368,7 +369,7 @@ typedef struct {
     UINT64 samplesEncodedWithSilk; //!< TODO Only valid for audio and when the audio codec is Opus. Represnets only SILK portion of codec
     UINT64 samplesEncodedWithCelt; //!< TODO Only valid for audio and when the audio codec is Opus. Represnets only CELT portion of codec
     UINT64 totalEncodeTime;        //!< Total number of milliseconds that has been spent encoding the framesEncoded frames of the stream
-    UINT64 totalPacketSendDelay;   //!< Total time (seconds) packets have spent buffered locally before being transmitted onto the network
+    DOUBLE totalPacketSendDelay;   //!< Total time (seconds) packets have spent buffered locally before being transmitted onto the network
     UINT64 averageRtcpInterval;    //!< The average RTCP interval between two consecutive compound RTCP packets
     QualityLimitationDurationsRecord qualityLimitationDurations; //!< Total time (seconds) spent in each reason state
     DscpPacketsSentRecord perDscpPacketsSent;                    //!< Total number of packets sent for this SSRC, per DSCP
@@ -392,13 +393,13 @@ typedef struct {
 typedef struct {
     RTCRtpStreamStats rtpStream;
     UINT64 packetsReceived; //!< Total number of RTP packets received for this SSRC.
-    INT64 packetsLost; //!< TODO Total number of RTP packets lost for this SSRC. Calculated as defined in [RFC3550] section 6.4.1. Note that because
+    INT64 packetsLost; //!< Total number of RTP packets lost for this SSRC. Calculated as defined in [RFC3550] section 6.4.1. Note that because
                        //!< of how this is estimated, it can be negative if more packets are received than sent.
     DOUBLE jitter;     //!< Packet Jitter measured in seconds for this SSRC. Calculated as defined in section 6.4.1. of [RFC3550].
     UINT64 packetsDiscarded; //!< The cumulative number of RTP packets discarded by the jitter buffer due to late or early-arrival, i.e., these
                              //!< packets are not played out. RTP packets discarded due to packet duplication are not reported in this metric
                              //!< [XRBLOCK-STATS]. Calculated as defined in [RFC7002] section 3.2 and Appendix A.a.
-    UINT64 packetsRepaired; //!< TODO The cumulative number of lost RTP packets repaired after applying an error-resilience mechanism [XRBLOCK-STATS].
+    UINT64 packetsRepaired; //!< The cumulative number of lost RTP packets repaired after applying an error-resilience mechanism [XRBLOCK-STATS].
     UINT64 burstPacketsLost;      //!< TODO The cumulative number of RTP packets lost during loss bursts, Appendix A (c) of [RFC6958].
     UINT64 burstPacketsDiscarded; //!< TODO The cumulative number of RTP packets discarded during discard bursts, Appendix A (b) of [RFC7003].
     UINT32 burstLossCount; //!< TODO The cumulative number of bursts of lost RTP packets, Appendix A (e) of [RFC6958].     [RFC3611] recommends a Gmin
@@ -475,10 +476,10 @@ typedef struct {
     UINT64 headerBytesReceived; //!< Total number of RTP header and padding bytes received for this SSRC. This does not include the size of transport
                                 //!< layer headers such as IP or UDP. headerBytesReceived + bytesReceived equals the number of bytes received as
                                 //!< payload over the transport.
-    UINT64 fecPacketsReceived;  //!< TODO Total number of RTP FEC packets received for this SSRC. This counter can also be incremented when receiving
+    UINT64 fecPacketsReceived;  //!< Total number of RTP FEC packets received for this SSRC. This counter can also be incremented when receiving
                                 //!< FEC packets in-band with media packets (e.g., with Opus).
     UINT64
-    fecPacketsDiscarded;  //!< TODO Total number of RTP FEC packets received for this SSRC where the error correction payload was discarded by the
+    fecPacketsDiscarded;  //!< Total number of RTP FEC packets received for this SSRC where the error correction payload was discarded by the
                           //!< application. This may happen 1. if all the source packets protected by the FEC packet were received or already
                           //!< recovered by a separate FEC packet, or 2. if the FEC packet arrived late, i.e., outside the recovery window, and
                           //!< the lost RTP packets have already been skipped during playout. This is a subset of fecPacketsReceived.
@@ -491,15 +492,19 @@ typedef struct {
     //!< packets can be calculated by adding packetsDuplicated to packetsLost; this will always result in a positive number,
     //!< but not the same number as RFC 3550 would calculate.
 
-    UINT32 nackCount; //!< TODO Count the total number of Negative ACKnowledgement (NACK) packets sent by this receiver.
-    UINT32 firCount;  //!< TODO Only valid for video. Count the total number of Full Intra Request (FIR) packets sent by this receiver.
-    UINT32 pliCount;  //!< TODO Only valid for video. Count the total number of Picture Loss Indication (PLI) packets sent by this receiver.
+    UINT32 nackCount; //!< Count the total number of Negative ACKnowledgement (NACK) packets sent by this receiver.
+    UINT32 firCount;  //!< Only valid for video. Count the total number of Full Intra Request (FIR) packets sent by this receiver.
+    UINT32 pliCount;  //!< Only valid for video. Count the total number of Picture Loss Indication (PLI) packets sent by this receiver.
     UINT32 sliCount;  //!< TODO Only valid for video. Count the total number of Slice Loss Indication (SLI) packets sent by this receiver.
     DOMHighResTimeStamp estimatedPlayoutTimestamp; //!< TODO This is the estimated playout time of this receiver's track.
     DOUBLE jitterBufferDelay; //!< TODO It is the sum of the time, in seconds, each audio sample or video frame takes from the time it is received and
                               //!< to the time it exits the jitter buffer.
     UINT64 jitterBufferEmittedCount; //!< TODO The total number of audio samples or video frames that have come out of the jitter buffer (increasing
                                      //!< jitterBufferDelay).
+    DOUBLE jitterBufferTargetDelay;  //!< The sum of the jitter buffer target delay, in seconds, at every emission from the jitter buffer. Only
+                                     //!< grows if KvsRtcConfiguration.enableAdaptiveJitterBuffer is set, otherwise frames are not held.
+    DOUBLE jitterBufferMinimumDelay; //!< The sum of the delay the measured jitter, frame size variance and round trip time call for, in
+                                     //!< seconds, at every emission from the jitter buffer.
     UINT64 totalSamplesReceived; //!< TODO Only valid for audio. The total number of samples that have been received on this RTP stream. This includes
                                  //!< concealedSamples.
     UINT64 samplesDecodedWithSilk; //!< TODO Only valid for audio and when the audio codec is Opus. The total number of samples decoded by the SILK
@@ -553,6 +558,18 @@ typedef struct {
     UINT64 bytesReceived;    //!< Represents the total number of bytes received on this RTCDatachannel, i.e., not including headers or padding.
 } RtcDataChannelStats, *PRtcDataChannelStats;
 
+/**
+ * @brief RtcRtpPacketPoolStats Non-standard stats of the preallocated rtp packets shared by the sender rolling buffers
+ * and the receiver jitter buffers of a peer connection
+ */
+typedef struct {
+    UINT32 capacity;           //!< Number of rtp packets in the pool, it grows with every rolling buffer and jitter buffer created
+    UINT32 packetSize;         //!< Largest raw packet in bytes which fits into a pooled packet
+    UINT32 packetsInUse;       //!< Number of pooled rtp packets currently referenced by a sender, a retransmission or a jitter buffer
+    UINT32 highWaterMark;      //!< Highest packetsInUse seen since the peer connection was created
+    UINT64 poolMisses;         //!< Number of rtp packets which could not be served by the pool and were allocated from the heap instead
+} RtcRtpPacketPoolStats, *PRtcRtpPacketPoolStats;
+
 /**
  * @brief SignalingClientMetrics Represent the stats related to the KVS WebRTC SDK signaling client
  */
@@ -594,6 +611,7 @@ typedef struct {
     RtcRemoteInboundRtpStreamStats remoteInboundRtpStreamStats; //!< Remote Inbound RTP Stream stats object
     RtcInboundRtpStreamStats inboundRtpStreamStats;             //!< Inbound RTP Stream stats object
     RtcDataChannelStats rtcDataChannelStats;
+    RtcRtpPacketPoolStats rtpPacketPoolStats;                   //!< RTP packet pool stats object
 } RtcStatsObject, *PRtcStatsObject;
 /*!@} */
 
@@ -114,6 +114,21 @@ extern "C" {
  */
 #define MAX_MEDIA_STREAM_ID_LEN 64
 
+/**
+ * Maximum number of transceivers in an RtcBroadcastGroup
+ */
+#define MAX_BROADCAST_GROUP_TRANSCEIVER_COUNT 16
+
+/**
+ * Maximum number of simulcast encodings an RtcRtpTransceiver sends
+ */
+#define MAX_SIMULCAST_ENCODING_COUNT 3
+
+/**
+ * Maximum length of the RID of a simulcast encoding, the RID header extension carries up to 16 bytes
+ */
+#define MAX_RTP_STREAM_ID_LEN 16
+
 /**
  * Max certificates an RtcConfiguration can accept
  */
@@ -393,6 +408,8 @@ typedef enum {
     RTC_CODEC_VP8 = 3,                                                            //!< VP8 video codec.
     RTC_CODEC_MULAW = 4,                                                          //!< MULAW audio codec
     RTC_CODEC_ALAW = 5,                                                           //!< ALAW audio codec
+    RTC_CODEC_H265 = 6,                                                           //!< H265 video codec
+    RTC_CODEC_AV1 = 7,                                                            //!< AV1 video codec
 } RTC_CODEC;
 
 /**
@@ -420,6 +437,14 @@ typedef enum {
     RTC_RTP_TRANSCEIVER_DIRECTION_INACTIVE = 4, //!< This indicates that the peer can not send or receive data
 } RTC_RTP_TRANSCEIVER_DIRECTION;
 
+/**
+ * @brief FRAME_QUEUE_DROP_POLICY decides which frames rtp_writeFrameAsync drops once the frame queue of a transceiver is full
+ */
+typedef enum {
+    FRAME_QUEUE_DROP_POLICY_DROP_OLDEST = 0,          //!< Drop the oldest queued frame to make room for the new one
+    FRAME_QUEUE_DROP_POLICY_DROP_UNTIL_KEY_FRAME = 1, //!< Drop every queued frame and the following ones up to the next key frame
+} FRAME_QUEUE_DROP_POLICY;
+
 /**
  * @brief Service call result
  *  https://developer.mozilla.org/en-US/docs/Web/HTTP/Status
@@ -633,6 +658,16 @@ typedef VOID (*RtcOnFrame)(UINT64, PFrame);
  */
 typedef VOID (*RtcOnBandwidthEstimation)(UINT64, DOUBLE);
 
+/**
+ * @brief RtcOnTargetBitrate is fired when the sender side bandwidth estimation, which is driven by the
+ * transport-wide congestion control feedback of the remote peer, moves the target bitrate in bits per second.
+ * The estimate covers every stream of the peer connection, so the encoders should share it.
+ *
+ * NOTE: RtcOnTargetBitrate is a KVS specific method
+ *
+ */
+typedef VOID (*RtcOnTargetBitrate)(UINT64, UINT64);
+
 /**
  * @brief RtcOnPictureLoss is fired everytime a Picture Loss Indication (PLI)
  * feedback message is received. Receiving such message normally indicates that
@@ -752,6 +787,14 @@ typedef struct {
     RtcRtpReceiver receiver;                 //!< RtcRtpReceiver that has track specific information
 } RtcRtpTransceiver, *PRtcRtpTransceiver;
 
+/**
+ * @brief An RtcBroadcastGroup sends the same frames to the transceivers of several RtcPeerConnections,
+ * for example a camera which is watched by several viewers. Every frame is packetized once for the whole group.
+ */
+typedef struct {
+    UINT32 version; //!< Version of broadcast group structure
+} RtcBroadcastGroup, *PRtcBroadcastGroup;
+
 /**
  * @brief RtcIceServer is used to describe the STUN and TURN servers that
  * can be used by the ICE Agent to establish a connection with a peer.
@@ -820,6 +863,73 @@ typedef struct {
 
     UINT32 sendBufSize; //!< Socket send buffer length. Item larger then this size will get dropped. Use system default if 0.
 
+    //!< Send runs of equal sized rtp packets of a frame as a single UDP_SEGMENT (gso) buffer which is segmented by the kernel or the NIC.
+    //!< Only takes effect on Linux kernels which support it, other platforms keep sending one packet at a time.
+    BOOL enableUdpSegmentOffload;
+
+    //!< Queue the video packets of a frame and send them at a multiple of the target bitrate instead of as one burst.
+    //!< The target bitrate is the one reported through rtp_transceiver_updateEncoderStats. Audio is never paced.
+    BOOL enablePacer;
+
+    //!< Multiple of the target bitrate the pacer sends at. If unset DEFAULT_PACING_MULTIPLIER will be used
+    DOUBLE pacingMultiplier;
+
+    //!< Do not stamp the outgoing rtp packets with the transport-wide sequence number, so that the remote peer sends no transport-wide
+    //!< congestion control feedback and RtcOnTargetBitrate never fires.
+    BOOL disableSenderSideBandwidthEstimation;
+
+    //!< Do not report the arrival of the incoming rtp packets to the remote sender in transport-wide congestion control feedback.
+    //!< The header extension is not negotiated at all once both this and disableSenderSideBandwidthEstimation are set.
+    BOOL disableTwccFeedback;
+
+    //!< Number of rtp packets pooled per peer connection on top of the ones reserved for the retransmission buffers of the senders
+    //!< and the jitter buffers of the receivers, rtp packets beyond that are allocated from the heap and counted as pool misses.
+    //!< If unset DEFAULT_RTP_PACKET_POOL_SIZE will be used
+    UINT32 rtpPacketPoolSize;
+
+    //!< Number of frames rtp_writeFrameAsync queues per transceiver. Every sending transceiver gets a worker thread writing its queued frames,
+    //!< and each queued frame keeps a copy of the frame data. rtp_writeFrameAsync can not be used if unset.
+    UINT32 frameQueueSize;
+
+    //!< What rtp_writeFrameAsync drops once the queue of a video transceiver is full. Audio transceivers always drop the oldest frame.
+    FRAME_QUEUE_DROP_POLICY frameQueueDropPolicy;
+
+    //!< Offer and accept flexfec-03, the video senders then follow each frame with XOR repair packets which let the remote peer rebuild
+    //!< a lost packet without waiting for a retransmission. The share of repair packets follows the loss the receiver reports.
+    BOOL enableFlexFec;
+
+    //!< Upper bound of the repair packets in percent of the media packets of a frame. If unset DEFAULT_FLEXFEC_MAX_PROTECTION_PERCENTAGE will be used
+    UINT32 maxFecProtectionPercentage;
+
+    //!< Offer and accept red/48000 for Opus, each audio packet then repeats this many previous frames (RFC 2198) so that the remote peer
+    //!< covers a lost packet with the next one. 0 disables it, the value is capped at RED_MAX_REDUNDANCY.
+    UINT32 opusRedundancy;
+
+    //!< Keep the frames each video transceiver is written since its last key frame until the peer connection is connected, and send
+    //!< them right away then, so that the remote peer shows a picture without waiting for the next key frame.
+    BOOL enableGopCache;
+
+    //!< Upper bound of the bytes the gop cache of a transceiver keeps. If unset DEFAULT_GOP_CACHE_MAX_SIZE will be used
+    UINT32 maxGopCacheSize;
+
+    //!< Probe the candidate pairs which passed their connectivity check with padded STUN binding requests sent with the don't fragment bit,
+    //!< and size the rtp packets to the largest probe the remote peer answered on the selected pair once the connection is up.
+    //!< maximumTransmissionUnit is kept if no probe is answered, e.g. when the remote peer rejects the PADDING attribute.
+    BOOL enablePathMtuDiscovery;
+
+    //!< Let the jitter buffers hold every frame for a target delay after its nominal arrival, as long as the measured interarrival
+    //!< jitter, frame size variance and round trip time call for, so that frames come out evenly paced. An incomplete frame is dropped
+    //!< after the same delay rather than after DEFAULT_JITTER_BUFFER_MAX_LATENCY, which the delay never exceeds.
+    BOOL enableAdaptiveJitterBuffer;
+
+    //!< Lower bound of the adaptive jitter buffer delay in milliseconds. If unset DEFAULT_JITTER_BUFFER_MIN_TARGET_DELAY will be used
+    UINT32 jitterBufferMinimumDelay;
+
+    //!< Least time in milliseconds between two key frame requests of a video receiver, and never less than a round trip time. A receiver
+    //!< asks for a key frame with a PLI, or a FIR if that is all the remote peer takes, once a frame is dropped or a frame no longer
+    //!< follows on from the last one. If unset DEFAULT_KEY_FRAME_REQUEST_MIN_INTERVAL will be used
+    UINT32 keyFrameRequestMinimumInterval;
+
     UINT64 filterCustomData; //!< Custom Data that can be populated by the developer while developing filter function
 
     IceSetInterfaceFilterFunc iceSetInterfaceFilterFunc; //!< Filter function callback to be set when the developer
@@ -1229,6 +1339,17 @@ PUBLIC_API STATUS pc_onDataChannel(PRtcPeerConnection, UINT64, RtcOnDataChannel)
  */
 PUBLIC_API STATUS pc_onConnectionStateChange(PRtcPeerConnection, UINT64, RtcOnConnectionStateChange);
 
+/**
+ * Set a callback for the target bitrate of the sender side bandwidth estimation
+ *
+ * @param[in] PRtcPeerConnection Initialized RtcPeerConnection
+ * @param[in] UINT64 User customData that will be passed along when RtcOnTargetBitrate is called
+ * @param[in] RtcOnTargetBitrate User RtcOnTargetBitrate callback
+ *
+ * @return STATUS code of the execution. STATUS_SUCCESS on success
+ */
+PUBLIC_API STATUS pc_onTargetBitrate(PRtcPeerConnection, UINT64, RtcOnTargetBitrate);
+
 /**
  * Load the sdp field of PRtcSessionDescriptionInit with pending or current local session description
  *
@@ -1465,6 +1586,99 @@ PUBLIC_API STATUS pc_addSupportedCodec(PRtcPeerConnection, RTC_CODEC);
  */
 PUBLIC_API STATUS rtp_writeFrame(PRtcRtpTransceiver, PFrame);
 
+/**
+ * @brief Queues a copy of the frame which is packetized and sent by the worker of the RtcRtpTransceiver,
+ * so that the caller never waits for the network.
+ *
+ * NOTE: KvsRtcConfiguration.frameQueueSize has to be set. Once the queue is full frames are dropped
+ * according to KvsRtcConfiguration.frameQueueDropPolicy, RtcOnPictureLoss fires when a key frame is needed.
+ *
+ * @param[in] PRtcRtpTransceiver Configured and connected RtcRtpTransceiver to send media
+ * @param[in] PFrame Frame of media that will be sent, the frame data can be reused once the call returns
+ *
+ * @return STATUS code of the execution. STATUS_SUCCESS on success
+ */
+PUBLIC_API STATUS rtp_writeFrameAsync(PRtcRtpTransceiver, PFrame);
+
+/**
+ * @brief Adds a simulcast encoding to the RtcRtpTransceiver, https://tools.ietf.org/html/rfc8853
+ *
+ * The first RID names the encoding which rtp_writeFrame sends, every further RID adds an encoding with its own SSRC,
+ * sequence numbers and retransmission buffer. The encodings are offered with a=rid and a=simulcast, and their packets
+ * carry the MID and RID header extensions.
+ *
+ * NOTE: Encodings have to be added before the offer is created or the remote offer is set. If the remote peer does not
+ * receive every encoding only the first one is sent.
+ *
+ * @param[in] PRtcRtpTransceiver RtcRtpTransceiver sending video
+ * @param[in] PCHAR RID of the encoding, up to MAX_RTP_STREAM_ID_LEN alphanumeric characters, '-' or '_'
+ *
+ * @return STATUS code of the execution. STATUS_SUCCESS on success
+ */
+PUBLIC_API STATUS rtp_transceiver_addSimulcastEncoding(PRtcRtpTransceiver, PCHAR);
+
+/**
+ * @brief Packetizes and sends a frame of one simulcast encoding of the RtcRtpTransceiver
+ *
+ * @param[in] PRtcRtpTransceiver Configured and connected RtcRtpTransceiver to send media
+ * @param[in] UINT32 Index of the encoding in the order of rtp_transceiver_addSimulcastEncoding, 0 is the encoding of rtp_writeFrame
+ * @param[in] PFrame Frame of media that will be sent
+ *
+ * @return STATUS code of the execution. STATUS_SUCCESS on success, also when the encoding was not negotiated and the frame is dropped
+ */
+PUBLIC_API STATUS rtp_writeSimulcastFrame(PRtcRtpTransceiver, UINT32, PFrame);
+
+/**
+ * @brief Creates an empty RtcBroadcastGroup
+ *
+ * @param[in,out] PRtcBroadcastGroup* Created RtcBroadcastGroup
+ *
+ * @return STATUS code of the execution. STATUS_SUCCESS on success
+ */
+PUBLIC_API STATUS rtp_broadcast_group_create(PRtcBroadcastGroup*);
+
+/**
+ * @brief Frees the RtcBroadcastGroup. The transceivers of the group are not affected
+ *
+ * @param[in,out] PRtcBroadcastGroup* RtcBroadcastGroup to be freed
+ *
+ * @return STATUS code of the execution. STATUS_SUCCESS on success
+ */
+PUBLIC_API STATUS rtp_broadcast_group_free(PRtcBroadcastGroup*);
+
+/**
+ * @brief Adds a transceiver to the RtcBroadcastGroup. All the transceivers of a group must use the same codec
+ *
+ * NOTE: The transceiver has to be removed from the group before its RtcPeerConnection is freed.
+ *
+ * @param[in] PRtcBroadcastGroup RtcBroadcastGroup
+ * @param[in] PRtcRtpTransceiver RtcRtpTransceiver which will be sent the frames of the group
+ *
+ * @return STATUS code of the execution. STATUS_SUCCESS on success
+ */
+PUBLIC_API STATUS rtp_broadcast_group_addTransceiver(PRtcBroadcastGroup, PRtcRtpTransceiver);
+
+/**
+ * @brief Removes a transceiver from the RtcBroadcastGroup
+ *
+ * @param[in] PRtcBroadcastGroup RtcBroadcastGroup
+ * @param[in] PRtcRtpTransceiver RtcRtpTransceiver to be removed
+ *
+ * @return STATUS code of the execution. STATUS_SUCCESS on success
+ */
+PUBLIC_API STATUS rtp_broadcast_group_removeTransceiver(PRtcBroadcastGroup, PRtcRtpTransceiver);
+
+/**
+ * @brief Packetizes the frame once and sends it through every transceiver of the RtcBroadcastGroup,
+ * like calling rtp_writeFrame for each of them. A transceiver which fails to send does not stop the others
+ *
+ * @param[in] PRtcBroadcastGroup RtcBroadcastGroup
+ * @param[in] PFrame Frame of media that will be sent
+ *
+ * @return STATUS code of the execution. STATUS_SUCCESS on success
+ */
+PUBLIC_API STATUS rtp_broadcast_group_writeFrame(PRtcBroadcastGroup, PFrame);
+
 /** @brief call this function to update stats which depend on external encoder
  *  @param[in] PRtcRtpTransceiver transceiver for which encoder stats will be updated
  *  @param[in] PRtcEncoderStats populated in the application layer which is then consumed as part
@@ -219,6 +219,18 @@ CleanUp:
 }
 #endif
 
+STATUS metrics_getRtpPacketPoolStats(PRtcPeerConnection pRtcPeerConnection, PRtcRtpPacketPoolStats pRtcRtpPacketPoolStats)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+#ifdef ENABLE_STREAMING
+    PKvsPeerConnection pKvsPeerConnection = (PKvsPeerConnection) pRtcPeerConnection;
+    CHK(pRtcPeerConnection != NULL && pRtcRtpPacketPoolStats != NULL, STATUS_METRICS_NULL_ARG);
+    CHK_STATUS(rtp_packet_pool_getStats(pKvsPeerConnection->pRtpPacketPool, pRtcRtpPacketPoolStats));
+CleanUp:
+#endif
+    return retStatus;
+}
+
 STATUS metrics_get(PRtcPeerConnection pRtcPeerConnection, PRtcRtpTransceiver pRtcRtpTransceiver, PRtcStats pRtcMetrics)
 {
     STATUS retStatus = STATUS_SUCCESS;
@@ -260,6 +272,9 @@ STATUS metrics_get(PRtcPeerConnection pRtcPeerConnection, PRtcRtpTransceiver pRt
 #endif
             DLOGD("RTC Data Channel Stats requested at %" PRIu64, pRtcMetrics->timestamp);
             break;
+        case RTC_STATS_TYPE_RTP_PACKET_POOL:
+            CHK_STATUS(metrics_getRtpPacketPoolStats(pRtcPeerConnection, &pRtcMetrics->rtcStatsObject.rtpPacketPoolStats));
+            break;
         case RTC_STATS_TYPE_CERTIFICATE:
         case RTC_STATS_TYPE_CSRC:
         case RTC_STATS_TYPE_REMOTE_OUTBOUND_RTP:
@@ -99,6 +99,15 @@ STATUS metrics_getRtpOutboundStats(PRtcPeerConnection, PRtcRtpTransceiver, PRtcO
  *
  */
 STATUS metrics_getRtpInboundStats(PRtcPeerConnection, PRtcRtpTransceiver, PRtcInboundRtpStreamStats);
+
+/**
+ * @brief Get the stats of the rtp packet pool of the peer connection
+ * @param [in] PRtcPeerConnection
+ * @param [in/out] PRtcRtpPacketPoolStats Fill up the rtp packet pool stats for application consumption
+ * @return Pass/Fail
+ *
+ */
+STATUS metrics_getRtpPacketPoolStats(PRtcPeerConnection, PRtcRtpPacketPoolStats);
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,193 @@
+/*
+ * Copyright 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+/******************************************************************************
+ * HEADERS
+ ******************************************************************************/
+#ifdef ENABLE_STREAMING
+#define LOG_CLASS "BroadcastGroup"
+
+#include "BroadcastGroup.h"
+
+/******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+STATUS rtp_broadcast_group_create(PRtcBroadcastGroup* ppRtcBroadcastGroup)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PKvsBroadcastGroup pKvsBroadcastGroup = NULL;
+
+    CHK(ppRtcBroadcastGroup != NULL, STATUS_RTP_NULL_ARG);
+
+    pKvsBroadcastGroup = (PKvsBroadcastGroup) MEMCALLOC(1, SIZEOF(KvsBroadcastGroup));
+    CHK(pKvsBroadcastGroup != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    pKvsBroadcastGroup->lock = MUTEX_CREATE(FALSE);
+    CHK(IS_VALID_MUTEX_VALUE(pKvsBroadcastGroup->lock), STATUS_INVALID_OPERATION);
+
+CleanUp:
+    if (STATUS_FAILED(retStatus)) {
+        rtp_broadcast_group_free((PRtcBroadcastGroup*) &pKvsBroadcastGroup);
+    }
+
+    if (ppRtcBroadcastGroup != NULL) {
+        *ppRtcBroadcastGroup = (PRtcBroadcastGroup) pKvsBroadcastGroup;
+    }
+    LEAVES();
+    return retStatus;
+}
+
+STATUS rtp_broadcast_group_free(PRtcBroadcastGroup* ppRtcBroadcastGroup)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PKvsBroadcastGroup pKvsBroadcastGroup = NULL;
+
+    CHK(ppRtcBroadcastGroup != NULL, STATUS_RTP_NULL_ARG);
+    pKvsBroadcastGroup = (PKvsBroadcastGroup) *ppRtcBroadcastGroup;
+    // free is idempotent
+    CHK(pKvsBroadcastGroup != NULL, retStatus);
+
+    if (IS_VALID_MUTEX_VALUE(pKvsBroadcastGroup->lock)) {
+        MUTEX_FREE(pKvsBroadcastGroup->lock);
+    }
+    gop_cache_free(&pKvsBroadcastGroup->pGopCache);
+    SAFE_MEMFREE(pKvsBroadcastGroup->payloadArray.payloadBuffer);
+    SAFE_MEMFREE(pKvsBroadcastGroup->payloadArray.payloadSubLength);
+    nalu_index_free(&pKvsBroadcastGroup->payloadArray.naluIndex);
+    SAFE_MEMFREE(*ppRtcBroadcastGroup);
+
+CleanUp:
+    CHK_LOG_ERR(retStatus);
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS rtp_broadcast_group_addTransceiver(PRtcBroadcastGroup pRtcBroadcastGroup, PRtcRtpTransceiver pRtcRtpTransceiver)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PKvsBroadcastGroup pKvsBroadcastGroup = (PKvsBroadcastGroup) pRtcBroadcastGroup;
+    PKvsRtpTransceiver pKvsRtpTransceiver = (PKvsRtpTransceiver) pRtcRtpTransceiver;
+    BOOL locked = FALSE;
+    UINT32 i;
+
+    CHK(pKvsBroadcastGroup != NULL && pKvsRtpTransceiver != NULL, STATUS_RTP_NULL_ARG);
+
+    MUTEX_LOCK(pKvsBroadcastGroup->lock);
+    locked = TRUE;
+
+    for (i = 0; i < pKvsBroadcastGroup->transceiverCount; i++) {
+        CHK(pKvsBroadcastGroup->transceivers[i] != pKvsRtpTransceiver, retStatus);
+    }
+    // The payloads are shared, so they have to come out of the same payloader
+    CHK(pKvsBroadcastGroup->transceiverCount == 0 || pKvsBroadcastGroup->codec == pKvsRtpTransceiver->sender.track.codec, STATUS_INVALID_ARG);
+    CHK(pKvsBroadcastGroup->transceiverCount < MAX_BROADCAST_GROUP_TRANSCEIVER_COUNT, STATUS_INVALID_OPERATION);
+
+    if (pKvsBroadcastGroup->pGopCache != NULL && pKvsBroadcastGroup->codec != pKvsRtpTransceiver->sender.track.codec) {
+        // The group was empty and the source changed its codec, the gop of the old codec does not decode
+        MUTEX_LOCK(pKvsBroadcastGroup->pGopCache->lock);
+        gop_cache_clear(pKvsBroadcastGroup->pGopCache);
+        MUTEX_UNLOCK(pKvsBroadcastGroup->pGopCache->lock);
+    }
+    if (pKvsRtpTransceiver->pGopCache != NULL) {
+        if (pKvsBroadcastGroup->pGopCache == NULL) {
+            CHK_STATUS(gop_cache_create(pKvsRtpTransceiver->pGopCache->maxByteCount, &pKvsBroadcastGroup->pGopCache));
+        } else {
+            // A viewer which joins mid-gop would otherwise wait for the next key frame
+            CHK_STATUS(rtp_transceiver_seedGopCache(pKvsRtpTransceiver, pKvsBroadcastGroup->pGopCache));
+        }
+    }
+
+    pKvsBroadcastGroup->codec = pKvsRtpTransceiver->sender.track.codec;
+    pKvsBroadcastGroup->transceivers[pKvsBroadcastGroup->transceiverCount++] = pKvsRtpTransceiver;
+
+CleanUp:
+    if (locked) {
+        MUTEX_UNLOCK(pKvsBroadcastGroup->lock);
+    }
+    CHK_LOG_ERR(retStatus);
+
+    return retStatus;
+}
+
+STATUS rtp_broadcast_group_removeTransceiver(PRtcBroadcastGroup pRtcBroadcastGroup, PRtcRtpTransceiver pRtcRtpTransceiver)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PKvsBroadcastGroup pKvsBroadcastGroup = (PKvsBroadcastGroup) pRtcBroadcastGroup;
+    BOOL locked = FALSE;
+    UINT32 i;
+
+    CHK(pKvsBroadcastGroup != NULL && pRtcRtpTransceiver != NULL, STATUS_RTP_NULL_ARG);
+
+    MUTEX_LOCK(pKvsBroadcastGroup->lock);
+    locked = TRUE;
+
+    i = 0;
+    while (i < pKvsBroadcastGroup->transceiverCount && pKvsBroadcastGroup->transceivers[i] != (PKvsRtpTransceiver) pRtcRtpTransceiver) {
+        i++;
+    }
+    CHK(i < pKvsBroadcastGroup->transceiverCount, STATUS_NOT_FOUND);
+
+    // The order of the transceivers does not matter
+    pKvsBroadcastGroup->transceivers[i] = pKvsBroadcastGroup->transceivers[--pKvsBroadcastGroup->transceiverCount];
+    pKvsBroadcastGroup->transceivers[pKvsBroadcastGroup->transceiverCount] = NULL;
+
+CleanUp:
+    if (locked) {
+        MUTEX_UNLOCK(pKvsBroadcastGroup->lock);
+    }
+
+    return retStatus;
+}
+
+STATUS rtp_broadcast_group_writeFrame(PRtcBroadcastGroup pRtcBroadcastGroup, PFrame pFrame)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PKvsBroadcastGroup pKvsBroadcastGroup = (PKvsBroadcastGroup) pRtcBroadcastGroup;
+    BOOL locked = FALSE;
+    UINT32 i, mtu = MAX_UINT32;
+
+    CHK(pKvsBroadcastGroup != NULL && pFrame != NULL, STATUS_RTP_NULL_ARG);
+
+    MUTEX_LOCK(pKvsBroadcastGroup->lock);
+    locked = TRUE;
+    if (pKvsBroadcastGroup->pGopCache != NULL) {
+        // The gop is kept while no viewer is connected, for the next one which joins
+        MUTEX_LOCK(pKvsBroadcastGroup->pGopCache->lock);
+        CHK_LOG_ERR(gop_cache_addFrame(pKvsBroadcastGroup->pGopCache, pFrame));
+        MUTEX_UNLOCK(pKvsBroadcastGroup->pGopCache->lock);
+    }
+    CHK(pKvsBroadcastGroup->transceiverCount > 0, retStatus);
+
+    // Payloads which fit the smallest mtu of the group fit every peer connection
+    for (i = 0; i < pKvsBroadcastGroup->transceiverCount; i++) {
+        mtu = MIN(mtu, rtp_transceiver_getPayloadMtu(pKvsBroadcastGroup->transceivers[i], &pKvsBroadcastGroup->transceivers[i]->sender));
+    }
+    CHK_STATUS(rtp_packetizeFrame(pKvsBroadcastGroup->codec, mtu, pFrame, &pKvsBroadcastGroup->payloadArray));
+
+    for (i = 0; i < pKvsBroadcastGroup->transceiverCount; i++) {
+        // Every transceiver logs its own errors, a viewer which is not connected yet must not hold back the others
+        rtp_writePayloadArray((PRtcRtpTransceiver) pKvsBroadcastGroup->transceivers[i], pFrame, &pKvsBroadcastGroup->payloadArray);
+    }
+
+CleanUp:
+    if (locked) {
+        MUTEX_UNLOCK(pKvsBroadcastGroup->lock);
+    }
+    CHK_LOG_ERR(retStatus);
+
+    return retStatus;
+}
+#endif
@@ -0,0 +1,47 @@
+/*
+ * Copyright 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+#ifndef __KINESIS_VIDEO_WEBRTC_CLIENT_PEERCONNECTION_BROADCAST_GROUP__
+#define __KINESIS_VIDEO_WEBRTC_CLIENT_PEERCONNECTION_BROADCAST_GROUP__
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/******************************************************************************
+ * HEADERS
+ ******************************************************************************/
+#include "Rtp.h"
+
+/******************************************************************************
+ * DEFINITIONS
+ ******************************************************************************/
+/**
+ * @brief internal structure for broadcast group.
+ */
+typedef struct {
+    RtcBroadcastGroup broadcastGroup;
+    MUTEX lock;
+    RTC_CODEC codec; //!< the codec of the transceivers, set by the first transceiver added to an empty group.
+    PKvsRtpTransceiver transceivers[MAX_BROADCAST_GROUP_TRANSCEIVER_COUNT];
+    UINT32 transceiverCount;
+    PayloadArray payloadArray; //!< the payloads of the current frame shared by the transceivers, reused from frame to frame.
+    PGopCache pGopCache;       //!< the gop of the source, seeds the transceivers which join mid-gop. Created by the first one with a gop cache.
+} KvsBroadcastGroup, *PKvsBroadcastGroup;
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __KINESIS_VIDEO_WEBRTC_CLIENT_PEERCONNECTION_BROADCAST_GROUP__ */
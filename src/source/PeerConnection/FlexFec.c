@@ -0,0 +1,437 @@
+/*
+ * Copyright 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+/******************************************************************************
+ * HEADERS
+ ******************************************************************************/
+#ifdef ENABLE_STREAMING
+#define LOG_CLASS "FlexFec"
+
+#include "FlexFec.h"
+
+/******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+static STATUS flexfec_reserve(PBYTE* ppBuffer, PUINT32 pBufferLen, UINT32 size)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PBYTE pBuffer;
+
+    if (size > *pBufferLen) {
+        pBuffer = (PBYTE) MEMREALLOC(*ppBuffer, size);
+        CHK(pBuffer != NULL, STATUS_NOT_ENOUGH_MEMORY);
+        *ppBuffer = pBuffer;
+        *pBufferLen = size;
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS flexfec_encoder_create(UINT32 ssrc, UINT32 protectedSsrc, UINT32 maxProtectionPercentage, PFlexFecEncoder* ppFlexFecEncoder)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PFlexFecEncoder pFlexFecEncoder = NULL;
+
+    CHK(ppFlexFecEncoder != NULL, STATUS_NULL_ARG);
+    CHK(maxProtectionPercentage <= 100, STATUS_INVALID_ARG);
+
+    pFlexFecEncoder = (PFlexFecEncoder) MEMCALLOC(1, SIZEOF(FlexFecEncoder));
+    CHK(pFlexFecEncoder != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    pFlexFecEncoder->ssrc = ssrc;
+    pFlexFecEncoder->protectedSsrc = protectedSsrc;
+    pFlexFecEncoder->sequenceNumber = (UINT16) RAND();
+    pFlexFecEncoder->minProtectionPercentage = MIN(DEFAULT_FLEXFEC_MIN_PROTECTION_PERCENTAGE, maxProtectionPercentage);
+    pFlexFecEncoder->maxProtectionPercentage = maxProtectionPercentage;
+    pFlexFecEncoder->protectionPercentage = pFlexFecEncoder->minProtectionPercentage;
+
+CleanUp:
+
+    if (STATUS_FAILED(retStatus)) {
+        flexfec_encoder_free(&pFlexFecEncoder);
+    }
+
+    if (ppFlexFecEncoder != NULL) {
+        *ppFlexFecEncoder = pFlexFecEncoder;
+    }
+
+    return retStatus;
+}
+
+STATUS flexfec_encoder_free(PFlexFecEncoder* ppFlexFecEncoder)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PFlexFecEncoder pFlexFecEncoder;
+    UINT32 i;
+
+    CHK(ppFlexFecEncoder != NULL, STATUS_NULL_ARG);
+    pFlexFecEncoder = *ppFlexFecEncoder;
+    // free is idempotent
+    CHK(pFlexFecEncoder != NULL, retStatus);
+
+    for (i = 0; i < pFlexFecEncoder->maxRepairCount; i++) {
+        SAFE_MEMFREE(pFlexFecEncoder->pRepairPackets[i].pBuffer);
+    }
+    SAFE_MEMFREE(pFlexFecEncoder->pRepairPackets);
+    SAFE_MEMFREE(pFlexFecEncoder);
+    *ppFlexFecEncoder = NULL;
+
+CleanUp:
+
+    return retStatus;
+}
+
+VOID flexfec_encoder_onLossReport(PFlexFecEncoder pFlexFecEncoder, DOUBLE fractionLost)
+{
+    UINT32 protectionPercentage;
+
+    if (pFlexFecEncoder == NULL || fractionLost < 0.0) {
+        return;
+    }
+
+    protectionPercentage = (UINT32) (fractionLost * 100 * FLEXFEC_PROTECTION_PER_LOSS + 0.5);
+    protectionPercentage = MAX(protectionPercentage, pFlexFecEncoder->minProtectionPercentage);
+    // Read once per frame by the sending thread
+    pFlexFecEncoder->protectionPercentage = MIN(protectionPercentage, pFlexFecEncoder->maxProtectionPercentage);
+}
+
+static UINT32 flexfec_encoder_getBlockRepairCount(UINT32 protectionPercentage, UINT32 blockSize)
+{
+    // Rounded up, so that any protection covers even a single packet frame
+    return MIN(blockSize, (blockSize * protectionPercentage + 99) / 100);
+}
+
+STATUS flexfec_encoder_beginFrame(PFlexFecEncoder pFlexFecEncoder, UINT32 packetCount)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PFlexFecRepairPacket pRepairPackets;
+    UINT32 i, repairCount = 0, remaining;
+
+    CHK(pFlexFecEncoder != NULL, STATUS_NULL_ARG);
+
+    pFlexFecEncoder->frameProtection = pFlexFecEncoder->protectionPercentage;
+    for (remaining = packetCount; remaining > 0; remaining -= MIN(remaining, FLEXFEC_MAX_BLOCK_SIZE)) {
+        repairCount += flexfec_encoder_getBlockRepairCount(pFlexFecEncoder->frameProtection, MIN(remaining, FLEXFEC_MAX_BLOCK_SIZE));
+    }
+
+    if (repairCount > pFlexFecEncoder->maxRepairCount) {
+        pRepairPackets = (PFlexFecRepairPacket) MEMREALLOC(pFlexFecEncoder->pRepairPackets, repairCount * SIZEOF(FlexFecRepairPacket));
+        CHK(pRepairPackets != NULL, STATUS_NOT_ENOUGH_MEMORY);
+        MEMSET(pRepairPackets + pFlexFecEncoder->maxRepairCount, 0x00, (repairCount - pFlexFecEncoder->maxRepairCount) * SIZEOF(FlexFecRepairPacket));
+        pFlexFecEncoder->pRepairPackets = pRepairPackets;
+        pFlexFecEncoder->maxRepairCount = repairCount;
+    }
+
+    for (i = 0; i < repairCount; i++) {
+        pFlexFecEncoder->pRepairPackets[i].packetLen = 0;
+        pFlexFecEncoder->pRepairPackets[i].mask = 0;
+    }
+    pFlexFecEncoder->repairCount = repairCount;
+    pFlexFecEncoder->packetCount = packetCount;
+    pFlexFecEncoder->packetIndex = 0;
+    pFlexFecEncoder->blockRepairIndex = 0;
+    pFlexFecEncoder->blockRepairCount = 0;
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS flexfec_encoder_addPacket(PFlexFecEncoder pFlexFecEncoder, PBYTE pRawPacket, UINT32 packetLen)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PFlexFecRepairPacket pRepairPacket;
+    UINT32 i, offset, blockSize, protectedLen;
+    PBYTE pHeader, pPayload;
+
+    CHK(pFlexFecEncoder != NULL && pRawPacket != NULL, STATUS_NULL_ARG);
+    CHK(packetLen >= MIN_HEADER_LENGTH && pFlexFecEncoder->packetIndex < pFlexFecEncoder->packetCount, STATUS_INVALID_ARG);
+
+    offset = pFlexFecEncoder->packetIndex % FLEXFEC_MAX_BLOCK_SIZE;
+    if (offset == 0) {
+        blockSize = MIN(FLEXFEC_MAX_BLOCK_SIZE, pFlexFecEncoder->packetCount - pFlexFecEncoder->packetIndex);
+        pFlexFecEncoder->blockRepairIndex += pFlexFecEncoder->blockRepairCount;
+        pFlexFecEncoder->blockRepairCount = flexfec_encoder_getBlockRepairCount(pFlexFecEncoder->frameProtection, blockSize);
+        pFlexFecEncoder->blockSnBase = getUnalignedInt16BigEndian(pRawPacket + SEQ_NUMBER_OFFSET);
+        pFlexFecEncoder->blockHeaderLen = blockSize > FLEXFEC_SHORT_MASK_BITS ? FLEXFEC_LONG_HEADER_LEN : FLEXFEC_HEADER_LEN;
+    }
+    pFlexFecEncoder->packetIndex++;
+    CHK(pFlexFecEncoder->blockRepairCount > 0, retStatus);
+
+    // Neighbouring packets go to different repair packets
+    pRepairPacket = &pFlexFecEncoder->pRepairPackets[pFlexFecEncoder->blockRepairIndex + offset % pFlexFecEncoder->blockRepairCount];
+    protectedLen = packetLen - MIN_HEADER_LENGTH;
+    if (pRepairPacket->mask == 0) {
+        pRepairPacket->headerLen = pFlexFecEncoder->blockHeaderLen;
+        pRepairPacket->snBase = pFlexFecEncoder->blockSnBase;
+        pRepairPacket->payloadLen = 0;
+        pRepairPacket->lengthRecovery = 0;
+        CHK_STATUS(flexfec_reserve(&pRepairPacket->pBuffer, &pRepairPacket->bufferLen, MIN_HEADER_LENGTH + pRepairPacket->headerLen));
+        MEMSET(pRepairPacket->pBuffer, 0x00, MIN_HEADER_LENGTH + pRepairPacket->headerLen);
+    }
+    if (protectedLen > pRepairPacket->payloadLen) {
+        CHK_STATUS(
+            flexfec_reserve(&pRepairPacket->pBuffer, &pRepairPacket->bufferLen, MIN_HEADER_LENGTH + pRepairPacket->headerLen + protectedLen));
+        MEMSET(pRepairPacket->pBuffer + MIN_HEADER_LENGTH + pRepairPacket->headerLen + pRepairPacket->payloadLen, 0x00,
+               protectedLen - pRepairPacket->payloadLen);
+        pRepairPacket->payloadLen = protectedLen;
+    }
+
+    // The recovery fields protect the first two bytes and the timestamp, the payload protects everything after the fixed header
+    pHeader = pRepairPacket->pBuffer + MIN_HEADER_LENGTH;
+    pHeader[0] ^= pRawPacket[0];
+    pHeader[1] ^= pRawPacket[1];
+    for (i = 0; i < SIZEOF(UINT32); i++) {
+        pHeader[FLEXFEC_TS_RECOVERY_OFFSET + i] ^= pRawPacket[TIMESTAMP_OFFSET + i];
+    }
+    pRepairPacket->lengthRecovery ^= (UINT16) protectedLen;
+    pPayload = pHeader + pRepairPacket->headerLen;
+    for (i = 0; i < protectedLen; i++) {
+        pPayload[i] ^= pRawPacket[MIN_HEADER_LENGTH + i];
+    }
+    pRepairPacket->mask |= ((UINT64) 1) << offset;
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS flexfec_encoder_endFrame(PFlexFecEncoder pFlexFecEncoder, UINT8 payloadType, UINT32 timestamp, PUINT32 pRepairCount)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PFlexFecRepairPacket pRepairPacket;
+    PBYTE pHeader;
+    UINT32 i, n, longMask;
+    UINT16 shortMask;
+
+    CHK(pFlexFecEncoder != NULL && pRepairCount != NULL, STATUS_NULL_ARG);
+
+    for (i = 0; i < pFlexFecEncoder->repairCount; i++) {
+        pRepairPacket = &pFlexFecEncoder->pRepairPackets[i];
+        if (pRepairPacket->mask == 0) {
+            continue;
+        }
+
+        // https://tools.ietf.org/html/draft-ietf-payload-flexible-fec-scheme-03#section-4.1, a regular rtp header on the repair stream
+        pRepairPacket->pBuffer[0] = 0x80;
+        pRepairPacket->pBuffer[1] = payloadType & 0x7F;
+        putUnalignedInt16BigEndian(pRepairPacket->pBuffer + SEQ_NUMBER_OFFSET, pFlexFecEncoder->sequenceNumber);
+        putUnalignedInt32BigEndian(pRepairPacket->pBuffer + TIMESTAMP_OFFSET, timestamp);
+        putUnalignedInt32BigEndian(pRepairPacket->pBuffer + SSRC_OFFSET, pFlexFecEncoder->ssrc);
+        pFlexFecEncoder->sequenceNumber = GET_UINT16_SEQ_NUM(pFlexFecEncoder->sequenceNumber + 1);
+
+        pHeader = pRepairPacket->pBuffer + MIN_HEADER_LENGTH;
+        // R and F are 0 for the flexible mask
+        pHeader[0] &= FLEXFEC_RECOVERY_BITS_MASK;
+        putUnalignedInt16BigEndian(pHeader + FLEXFEC_LENGTH_RECOVERY_OFFSET, pRepairPacket->lengthRecovery);
+        pHeader[FLEXFEC_SSRC_COUNT_OFFSET] = 1;
+        putUnalignedInt32BigEndian(pHeader + FLEXFEC_SSRC_OFFSET, pFlexFecEncoder->protectedSsrc);
+        putUnalignedInt16BigEndian(pHeader + FLEXFEC_SN_BASE_OFFSET, pRepairPacket->snBase);
+
+        // The k bit marks the last mask chunk, the first packet of the block is the most significant bit
+        shortMask = pRepairPacket->headerLen == FLEXFEC_HEADER_LEN ? FLEXFEC_SHORT_MASK_K_BIT : 0;
+        longMask = FLEXFEC_LONG_MASK_K_BIT;
+        for (n = 0; n < FLEXFEC_MAX_BLOCK_SIZE; n++) {
+            if ((pRepairPacket->mask & (((UINT64) 1) << n)) == 0) {
+                continue;
+            }
+            if (n < FLEXFEC_SHORT_MASK_BITS) {
+                shortMask |= (UINT16) (1 << (FLEXFEC_SHORT_MASK_BITS - 1 - n));
+            } else {
+                longMask |= ((UINT32) 1) << (FLEXFEC_MAX_BLOCK_SIZE - 1 - n);
+            }
+        }
+        putUnalignedInt16BigEndian(pHeader + FLEXFEC_SHORT_MASK_OFFSET, shortMask);
+        if (pRepairPacket->headerLen == FLEXFEC_LONG_HEADER_LEN) {
+            putUnalignedInt32BigEndian(pHeader + FLEXFEC_LONG_MASK_OFFSET, longMask);
+        }
+
+        pRepairPacket->packetLen = MIN_HEADER_LENGTH + pRepairPacket->headerLen + pRepairPacket->payloadLen;
+    }
+
+    *pRepairCount = pFlexFecEncoder->repairCount;
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS flexfec_receiver_create(UINT32 protectedSsrc, PFlexFecReceiver* ppFlexFecReceiver)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PFlexFecReceiver pFlexFecReceiver = NULL;
+
+    CHK(ppFlexFecReceiver != NULL, STATUS_NULL_ARG);
+
+    pFlexFecReceiver = (PFlexFecReceiver) MEMCALLOC(1, SIZEOF(FlexFecReceiver));
+    CHK(pFlexFecReceiver != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    pFlexFecReceiver->protectedSsrc = protectedSsrc;
+
+CleanUp:
+
+    if (ppFlexFecReceiver != NULL) {
+        *ppFlexFecReceiver = pFlexFecReceiver;
+    }
+
+    return retStatus;
+}
+
+STATUS flexfec_receiver_free(PFlexFecReceiver* ppFlexFecReceiver)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PFlexFecReceiver pFlexFecReceiver;
+    UINT32 i;
+
+    CHK(ppFlexFecReceiver != NULL, STATUS_NULL_ARG);
+    pFlexFecReceiver = *ppFlexFecReceiver;
+    // free is idempotent
+    CHK(pFlexFecReceiver != NULL, retStatus);
+
+    for (i = 0; i < FLEXFEC_RECEIVE_WINDOW; i++) {
+        SAFE_MEMFREE(pFlexFecReceiver->packets[i].pBuffer);
+    }
+    SAFE_MEMFREE(pFlexFecReceiver);
+    *ppFlexFecReceiver = NULL;
+
+CleanUp:
+
+    return retStatus;
+}
+
+static PFlexFecMediaPacket flexfec_receiver_findPacket(PFlexFecReceiver pFlexFecReceiver, UINT16 sequenceNumber)
+{
+    PFlexFecMediaPacket pPacket = &pFlexFecReceiver->packets[sequenceNumber % FLEXFEC_RECEIVE_WINDOW];
+
+    return pPacket->packetLen > 0 && pPacket->sequenceNumber == sequenceNumber ? pPacket : NULL;
+}
+
+STATUS flexfec_receiver_onMediaPacket(PFlexFecReceiver pFlexFecReceiver, PBYTE pRawPacket, UINT32 packetLen)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PFlexFecMediaPacket pPacket;
+    UINT16 sequenceNumber;
+
+    CHK(pFlexFecReceiver != NULL && pRawPacket != NULL, STATUS_NULL_ARG);
+    CHK(packetLen >= MIN_HEADER_LENGTH, STATUS_INVALID_ARG);
+
+    sequenceNumber = getUnalignedInt16BigEndian(pRawPacket + SEQ_NUMBER_OFFSET);
+    pPacket = &pFlexFecReceiver->packets[sequenceNumber % FLEXFEC_RECEIVE_WINDOW];
+    pPacket->packetLen = 0;
+    CHK_STATUS(flexfec_reserve(&pPacket->pBuffer, &pPacket->bufferLen, packetLen));
+    MEMCPY(pPacket->pBuffer, pRawPacket, packetLen);
+    pPacket->packetLen = packetLen;
+    pPacket->sequenceNumber = sequenceNumber;
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS flexfec_receiver_onRepairPacket(PFlexFecReceiver pFlexFecReceiver, PBYTE pPayload, UINT32 payloadLen, PBYTE* ppRecoveredPacket,
+                                       PUINT32 pRecoveredLen)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PFlexFecMediaPacket pPacket, pRecovered;
+    UINT64 mask = 0;
+    UINT32 i, n, headerLen = FLEXFEC_HEADER_LEN, longMask, missingCount = 0, protectedLen, xorLen;
+    UINT16 shortMask, snBase, missingSequenceNumber = 0, lengthRecovery;
+    PBYTE pXor;
+
+    CHK(pFlexFecReceiver != NULL && pPayload != NULL && ppRecoveredPacket != NULL && pRecoveredLen != NULL, STATUS_NULL_ARG);
+    *pRecoveredLen = 0;
+    CHK(payloadLen >= FLEXFEC_HEADER_LEN && (pPayload[0] & (FLEXFEC_R_BIT | FLEXFEC_F_BIT)) == 0 && pPayload[FLEXFEC_SSRC_COUNT_OFFSET] == 1,
+        STATUS_RTP_INVALID_FEC_PACKET);
+    // Protects another stream of the media section
+    CHK((UINT32) getUnalignedInt32BigEndian(pPayload + FLEXFEC_SSRC_OFFSET) == pFlexFecReceiver->protectedSsrc, retStatus);
+
+    snBase = getUnalignedInt16BigEndian(pPayload + FLEXFEC_SN_BASE_OFFSET);
+    shortMask = (UINT16) getUnalignedInt16BigEndian(pPayload + FLEXFEC_SHORT_MASK_OFFSET);
+    for (n = 0; n < FLEXFEC_SHORT_MASK_BITS; n++) {
+        if ((shortMask & (1 << (FLEXFEC_SHORT_MASK_BITS - 1 - n))) != 0) {
+            mask |= ((UINT64) 1) << n;
+        }
+    }
+    if ((shortMask & FLEXFEC_SHORT_MASK_K_BIT) == 0) {
+        headerLen = FLEXFEC_LONG_HEADER_LEN;
+        CHK(payloadLen >= headerLen, STATUS_RTP_INVALID_FEC_PACKET);
+        longMask = (UINT32) getUnalignedInt32BigEndian(pPayload + FLEXFEC_LONG_MASK_OFFSET);
+        // The third mask chunk, for blocks beyond FLEXFEC_MAX_BLOCK_SIZE packets, is not supported
+        CHK((longMask & FLEXFEC_LONG_MASK_K_BIT) != 0, STATUS_RTP_INVALID_FEC_PACKET);
+        for (n = FLEXFEC_SHORT_MASK_BITS; n < FLEXFEC_MAX_BLOCK_SIZE; n++) {
+            if ((longMask & (((UINT32) 1) << (FLEXFEC_MAX_BLOCK_SIZE - 1 - n))) != 0) {
+                mask |= ((UINT64) 1) << n;
+            }
+        }
+    }
+
+    // XOR recovers a single packet, a repair packet is of no use once none or several of its packets are missing
+    lengthRecovery = getUnalignedInt16BigEndian(pPayload + FLEXFEC_LENGTH_RECOVERY_OFFSET);
+    for (n = 0; n < FLEXFEC_MAX_BLOCK_SIZE && missingCount < 2; n++) {
+        if ((mask & (((UINT64) 1) << n)) == 0) {
+            continue;
+        }
+        pPacket = flexfec_receiver_findPacket(pFlexFecReceiver, GET_UINT16_SEQ_NUM(snBase + n));
+        if (pPacket == NULL) {
+            missingSequenceNumber = GET_UINT16_SEQ_NUM(snBase + n);
+            missingCount++;
+        } else {
+            lengthRecovery ^= (UINT16) (pPacket->packetLen - MIN_HEADER_LENGTH);
+        }
+    }
+    CHK(missingCount == 1, retStatus);
+
+    pXor = pPayload + headerLen;
+    xorLen = payloadLen - headerLen;
+    protectedLen = lengthRecovery;
+    CHK(protectedLen <= xorLen, STATUS_RTP_INVALID_FEC_PACKET);
+
+    pRecovered = &pFlexFecReceiver->packets[missingSequenceNumber % FLEXFEC_RECEIVE_WINDOW];
+    pRecovered->packetLen = 0;
+    CHK_STATUS(flexfec_reserve(&pRecovered->pBuffer, &pRecovered->bufferLen, MIN_HEADER_LENGTH + protectedLen));
+    MEMSET(pRecovered->pBuffer, 0x00, MIN_HEADER_LENGTH);
+    pRecovered->pBuffer[0] = pPayload[0];
+    pRecovered->pBuffer[1] = pPayload[1];
+    MEMCPY(pRecovered->pBuffer + TIMESTAMP_OFFSET, pPayload + FLEXFEC_TS_RECOVERY_OFFSET, SIZEOF(UINT32));
+    MEMCPY(pRecovered->pBuffer + MIN_HEADER_LENGTH, pXor, protectedLen);
+
+    for (n = 0; n < FLEXFEC_MAX_BLOCK_SIZE; n++) {
+        if ((mask & (((UINT64) 1) << n)) == 0 || (pPacket = flexfec_receiver_findPacket(pFlexFecReceiver, GET_UINT16_SEQ_NUM(snBase + n))) == NULL) {
+            continue;
+        }
+        pRecovered->pBuffer[0] ^= pPacket->pBuffer[0];
+        pRecovered->pBuffer[1] ^= pPacket->pBuffer[1];
+        for (i = 0; i < SIZEOF(UINT32); i++) {
+            pRecovered->pBuffer[TIMESTAMP_OFFSET + i] ^= pPacket->pBuffer[TIMESTAMP_OFFSET + i];
+        }
+        for (i = 0; i < protectedLen && MIN_HEADER_LENGTH + i < pPacket->packetLen; i++) {
+            pRecovered->pBuffer[MIN_HEADER_LENGTH + i] ^= pPacket->pBuffer[MIN_HEADER_LENGTH + i];
+        }
+    }
+
+    // The version, the sequence number and the ssrc are not protected, they follow from the repair packet
+    pRecovered->pBuffer[0] = (pRecovered->pBuffer[0] & FLEXFEC_RECOVERY_BITS_MASK) | 0x80;
+    putUnalignedInt16BigEndian(pRecovered->pBuffer + SEQ_NUMBER_OFFSET, missingSequenceNumber);
+    putUnalignedInt32BigEndian(pRecovered->pBuffer + SSRC_OFFSET, pFlexFecReceiver->protectedSsrc);
+    pRecovered->sequenceNumber = missingSequenceNumber;
+    pRecovered->packetLen = MIN_HEADER_LENGTH + protectedLen;
+
+    *ppRecoveredPacket = pRecovered->pBuffer;
+    *pRecoveredLen = pRecovered->packetLen;
+
+CleanUp:
+
+    return retStatus;
+}
+#endif
@@ -0,0 +1,216 @@
+/*
+ * Copyright 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+#ifndef __KINESIS_VIDEO_WEBRTC_CLIENT_PEERCONNECTION_FLEXFEC__
+#define __KINESIS_VIDEO_WEBRTC_CLIENT_PEERCONNECTION_FLEXFEC__
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/******************************************************************************
+ * HEADERS
+ ******************************************************************************/
+#include "kvs/error.h"
+#include "kvs/common_defs.h"
+#include "kvs/platform_utils.h"
+#include "RtpPacket.h"
+
+/******************************************************************************
+ * DEFINITIONS
+ ******************************************************************************/
+/*
+ * https://tools.ietf.org/html/draft-ietf-payload-flexible-fec-scheme-03#section-4.2, the version browsers negotiate as flexfec-03
+ *
+ *  0                   1                   2                   3
+ *  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * |R|F|P|X|  CC   |M| PT recovery |        length recovery        |
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * |                          TS recovery                          |
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * |   SSRCCount   |                    reserved                   |
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * |                             SSRC_i                            |
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * |           SN base_i           |k|          Mask [0-14]        |
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * |k|                   Mask [15-45] (optional)                   |
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *
+ * Only the flexible mask with a single protected ssrc is produced and understood, which caps a block at 46 packets.
+ */
+#define FLEXFEC_HEADER_LEN             20
+#define FLEXFEC_LONG_HEADER_LEN        24
+#define FLEXFEC_SHORT_MASK_BITS        15
+#define FLEXFEC_MAX_BLOCK_SIZE         46
+#define FLEXFEC_R_BIT                  0x80
+#define FLEXFEC_F_BIT                  0x40
+#define FLEXFEC_RECOVERY_BITS_MASK     0x3F
+#define FLEXFEC_SHORT_MASK_K_BIT       0x8000
+#define FLEXFEC_LONG_MASK_K_BIT        0x80000000
+#define FLEXFEC_LENGTH_RECOVERY_OFFSET 2
+#define FLEXFEC_TS_RECOVERY_OFFSET     4
+#define FLEXFEC_SSRC_COUNT_OFFSET      8
+#define FLEXFEC_SSRC_OFFSET            12
+#define FLEXFEC_SN_BASE_OFFSET         16
+#define FLEXFEC_SHORT_MASK_OFFSET      18
+#define FLEXFEC_LONG_MASK_OFFSET       20
+
+// The receiver keeps this many media packets around to rebuild a lost one, it has to span a whole block
+#define FLEXFEC_RECEIVE_WINDOW 64
+
+// Without reported loss no repair packets are sent
+#define DEFAULT_FLEXFEC_MIN_PROTECTION_PERCENTAGE 0
+#define DEFAULT_FLEXFEC_MAX_PROTECTION_PERCENTAGE 50
+// Percent of repair packets per percent of reported loss, XOR repair packets only recover one loss each
+#define FLEXFEC_PROTECTION_PER_LOSS 2
+
+typedef struct {
+    PBYTE pBuffer;         //!< the repair packet, it only grows so that steady state sending does not touch the heap.
+    UINT32 bufferLen;
+    UINT32 packetLen;      //!< the length of the finished repair packet, 0 if it protects nothing.
+    UINT32 headerLen;      //!< FLEXFEC_HEADER_LEN or FLEXFEC_LONG_HEADER_LEN, the xor of the payloads follows it.
+    UINT32 payloadLen;     //!< the longest protected packet without its fixed rtp header.
+    UINT16 lengthRecovery; //!< xor of the lengths of the protected packets without their fixed rtp header.
+    UINT16 snBase;
+    UINT64 mask;           //!< bit n protects the packet snBase + n.
+} FlexFecRepairPacket, *PFlexFecRepairPacket;
+
+/**
+ * Generates the XOR repair packets of the frames of one media stream. The packets of a frame are split into blocks of at most
+ * FLEXFEC_MAX_BLOCK_SIZE packets, and the repair packets of a block protect its packets interleaved, so that a burst of lost
+ * packets up to the number of repair packets of the block is still recoverable.
+ */
+typedef struct __FlexFecEncoder {
+    UINT32 ssrc;          //!< the ssrc of the repair packets.
+    UINT32 protectedSsrc; //!< the ssrc of the media packets.
+    UINT16 sequenceNumber;
+    UINT32 protectionPercentage; //!< repair packets in percent of the media packets, follows the reported loss.
+    UINT32 minProtectionPercentage;
+    UINT32 maxProtectionPercentage;
+
+    UINT32 packetCount;      //!< the media packets of the current frame.
+    UINT32 packetIndex;      //!< the media packets of the current frame added so far.
+    UINT32 frameProtection;  //!< protectionPercentage latched for the current frame.
+    UINT16 blockSnBase;      //!< the sequence number of the first packet of the current block.
+    UINT32 blockHeaderLen;   //!< the fec header length of the repair packets of the current block.
+    UINT32 blockRepairIndex; //!< the first repair packet of the current block.
+    UINT32 blockRepairCount; //!< the repair packets of the current block.
+
+    PFlexFecRepairPacket pRepairPackets;
+    UINT32 repairCount;    //!< the repair packets of the current frame.
+    UINT32 maxRepairCount; //!< the repair packets allocated so far.
+} FlexFecEncoder, *PFlexFecEncoder;
+
+typedef struct {
+    PBYTE pBuffer;
+    UINT32 bufferLen;
+    UINT32 packetLen; //!< 0 while the slot is empty.
+    UINT16 sequenceNumber;
+} FlexFecMediaPacket, *PFlexFecMediaPacket;
+
+/**
+ * Rebuilds the lost packets of one media stream from the repair packets and the media packets received around them.
+ */
+typedef struct __FlexFecReceiver {
+    UINT32 protectedSsrc;
+    FlexFecMediaPacket packets[FLEXFEC_RECEIVE_WINDOW]; //!< the recent media packets indexed by their sequence number.
+} FlexFecReceiver, *PFlexFecReceiver;
+
+/******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+/**
+ * @brief create an encoder.
+ *
+ * @param[in] ssrc the ssrc of the repair packets.
+ * @param[in] protectedSsrc the ssrc of the media packets.
+ * @param[in] maxProtectionPercentage the upper bound of the protection, see KvsRtcConfiguration.maxFecProtectionPercentage.
+ * @param[out] ppFlexFecEncoder the created encoder.
+ *
+ * @return STATUS status of execution
+ */
+STATUS flexfec_encoder_create(UINT32, UINT32, UINT32, PFlexFecEncoder*);
+STATUS flexfec_encoder_free(PFlexFecEncoder*);
+/**
+ * @brief adapt the protection to the fraction lost of a receiver report.
+ *
+ * @param[in] pFlexFecEncoder the encoder.
+ * @param[in] fractionLost the fraction of lost packets between 0 and 1.
+ */
+VOID flexfec_encoder_onLossReport(PFlexFecEncoder, DOUBLE);
+/**
+ * @brief start protecting a frame.
+ *
+ * @param[in] pFlexFecEncoder the encoder.
+ * @param[in] packetCount the number of media packets of the frame.
+ *
+ * @return STATUS status of execution
+ */
+STATUS flexfec_encoder_beginFrame(PFlexFecEncoder, UINT32);
+/**
+ * @brief add the next media packet of the frame, in sending order and before it is encrypted.
+ *
+ * @param[in] pFlexFecEncoder the encoder.
+ * @param[in] pRawPacket the serialized rtp packet.
+ * @param[in] packetLen the length of the packet.
+ *
+ * @return STATUS status of execution
+ */
+STATUS flexfec_encoder_addPacket(PFlexFecEncoder, PBYTE, UINT32);
+/**
+ * @brief finish the repair packets of the frame, pRepairPackets then holds repairCount packets, the ones with a packetLen of 0
+ *        are to be skipped.
+ *
+ * @param[in] pFlexFecEncoder the encoder.
+ * @param[in] payloadType the negotiated payload type of the repair packets.
+ * @param[in] timestamp the rtp timestamp of the frame.
+ * @param[out] pRepairCount the number of repair packets.
+ *
+ * @return STATUS status of execution
+ */
+STATUS flexfec_encoder_endFrame(PFlexFecEncoder, UINT8, UINT32, PUINT32);
+
+STATUS flexfec_receiver_create(UINT32, PFlexFecReceiver*);
+STATUS flexfec_receiver_free(PFlexFecReceiver*);
+/**
+ * @brief keep a copy of a decrypted media packet for the repair packets which follow it.
+ *
+ * @param[in] pFlexFecReceiver the receiver.
+ * @param[in] pRawPacket the decrypted rtp packet.
+ * @param[in] packetLen the length of the packet.
+ *
+ * @return STATUS status of execution
+ */
+STATUS flexfec_receiver_onMediaPacket(PFlexFecReceiver, PBYTE, UINT32);
+/**
+ * @brief rebuild the media packet a repair packet protects, as long as it is the only one of them which is missing.
+ *        The rebuilt packet is kept like a received one.
+ *
+ * @param[in] pFlexFecReceiver the receiver.
+ * @param[in] pPayload the payload of the decrypted repair packet, the fec header and the xor of the protected packets.
+ * @param[in] payloadLen the length of the payload.
+ * @param[out] ppRecoveredPacket the rebuilt rtp packet, owned by the receiver and valid until the next call.
+ * @param[out] pRecoveredLen the length of the rebuilt packet, 0 if nothing could be or had to be rebuilt.
+ *
+ * @return STATUS status of execution, STATUS_RTP_INVALID_FEC_PACKET if the repair packet can not be parsed.
+ */
+STATUS flexfec_receiver_onRepairPacket(PFlexFecReceiver, PBYTE, UINT32, PBYTE*, PUINT32);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __KINESIS_VIDEO_WEBRTC_CLIENT_PEERCONNECTION_FLEXFEC__ */
@@ -0,0 +1,270 @@
+/*
+ * Copyright 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+/******************************************************************************
+ * HEADERS
+ ******************************************************************************/
+#ifdef ENABLE_STREAMING
+#define LOG_CLASS "FrameQueue"
+
+#include "FrameQueue.h"
+
+/******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+static PVOID frame_queue_workerRoutine(PVOID pArg)
+{
+    PFrameQueue pFrameQueue = (PFrameQueue) pArg;
+    BOOL written = FALSE;
+
+    DLOGD("Frame queue worker is up.");
+    while (!ATOMIC_LOAD_BOOL(&pFrameQueue->terminate)) {
+        MUTEX_LOCK(pFrameQueue->lock);
+        if (pFrameQueue->frameCount == 0 && !ATOMIC_LOAD_BOOL(&pFrameQueue->terminate)) {
+            // Signaled by frame_queue_enqueue and frame_queue_free, the timeout is only a safety net
+            CVAR_WAIT(pFrameQueue->cvar, pFrameQueue->lock, FRAME_QUEUE_WAIT_INTERVAL);
+        }
+        MUTEX_UNLOCK(pFrameQueue->lock);
+
+        if (!ATOMIC_LOAD_BOOL(&pFrameQueue->terminate)) {
+            // The write logs its own errors
+            frame_queue_writeNext(pFrameQueue, &written);
+        }
+    }
+
+    // As TID is 64 bit we can't atomically update it and need to do it under the lock
+    MUTEX_LOCK(pFrameQueue->lock);
+    pFrameQueue->workerTid = INVALID_TID_VALUE;
+    MUTEX_UNLOCK(pFrameQueue->lock);
+
+    DLOGD("Frame queue worker is down.");
+    THREAD_EXIT(NULL);
+    return NULL;
+}
+
+STATUS frame_queue_create(UINT32 queueSize, FRAME_QUEUE_DROP_POLICY dropPolicy, FrameQueueWriteFunc writeFn, FrameQueueOnDropFunc onDropFn,
+                          UINT64 customData, PFrameQueue* ppFrameQueue)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PFrameQueue pFrameQueue = NULL;
+
+    CHK(ppFrameQueue != NULL && writeFn != NULL, STATUS_NULL_ARG);
+    CHK(queueSize != 0 && dropPolicy <= FRAME_QUEUE_DROP_POLICY_DROP_UNTIL_KEY_FRAME, STATUS_INVALID_ARG);
+
+    pFrameQueue = (PFrameQueue) MEMCALLOC(1, SIZEOF(FrameQueue));
+    CHK(pFrameQueue != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    ATOMIC_STORE_BOOL(&pFrameQueue->terminate, FALSE);
+    pFrameQueue->workerTid = INVALID_TID_VALUE;
+    pFrameQueue->lock = MUTEX_CREATE(FALSE);
+    CHK(IS_VALID_MUTEX_VALUE(pFrameQueue->lock), STATUS_INVALID_OPERATION);
+    pFrameQueue->cvar = CVAR_CREATE();
+    CHK(IS_VALID_CVAR_VALUE(pFrameQueue->cvar), STATUS_INVALID_OPERATION);
+    pFrameQueue->pQueue = (PQueuedFrame) MEMCALLOC(queueSize, SIZEOF(QueuedFrame));
+    CHK(pFrameQueue->pQueue != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    pFrameQueue->queueSize = queueSize;
+    pFrameQueue->dropPolicy = dropPolicy;
+    pFrameQueue->writeFn = writeFn;
+    pFrameQueue->onDropFn = onDropFn;
+    pFrameQueue->customData = customData;
+
+CleanUp:
+    if (STATUS_FAILED(retStatus)) {
+        frame_queue_free(&pFrameQueue);
+    }
+
+    if (ppFrameQueue != NULL) {
+        *ppFrameQueue = pFrameQueue;
+    }
+    LEAVES();
+    return retStatus;
+}
+
+STATUS frame_queue_free(PFrameQueue* ppFrameQueue)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PFrameQueue pFrameQueue = NULL;
+    UINT64 timeToWait;
+    TID threadId = INVALID_TID_VALUE;
+    UINT32 i;
+
+    CHK(ppFrameQueue != NULL, STATUS_NULL_ARG);
+    pFrameQueue = *ppFrameQueue;
+    CHK(pFrameQueue != NULL, retStatus);
+
+    ATOMIC_STORE_BOOL(&pFrameQueue->terminate, TRUE);
+    if (IS_VALID_MUTEX_VALUE(pFrameQueue->lock)) {
+        // Wake the worker up and await for it to finish the frame it is writing
+        // NOTE: As TID is not atomic we need to wrap the read in locks
+        MUTEX_LOCK(pFrameQueue->lock);
+        threadId = pFrameQueue->workerTid;
+        if (IS_VALID_CVAR_VALUE(pFrameQueue->cvar)) {
+            CVAR_BROADCAST(pFrameQueue->cvar);
+        }
+        MUTEX_UNLOCK(pFrameQueue->lock);
+
+        timeToWait = GETTIME() + FRAME_QUEUE_SHUTDOWN_TIMEOUT;
+        while (IS_VALID_TID_VALUE(threadId) && GETTIME() < timeToWait) {
+            THREAD_SLEEP(FRAME_QUEUE_SHUTDOWN_CHECK_DELAY);
+            MUTEX_LOCK(pFrameQueue->lock);
+            threadId = pFrameQueue->workerTid;
+            MUTEX_UNLOCK(pFrameQueue->lock);
+        }
+        if (IS_VALID_TID_VALUE(threadId)) {
+            DLOGW("Frame queue worker shutdown timed out");
+        }
+    }
+
+    if (pFrameQueue->pQueue != NULL) {
+        for (i = 0; i < pFrameQueue->queueSize; i++) {
+            SAFE_MEMFREE(pFrameQueue->pQueue[i].pBuffer);
+        }
+        MEMFREE(pFrameQueue->pQueue);
+    }
+    SAFE_MEMFREE(pFrameQueue->writingFrame.pBuffer);
+    if (IS_VALID_CVAR_VALUE(pFrameQueue->cvar)) {
+        CVAR_FREE(pFrameQueue->cvar);
+    }
+    if (IS_VALID_MUTEX_VALUE(pFrameQueue->lock)) {
+        MUTEX_FREE(pFrameQueue->lock);
+    }
+    SAFE_MEMFREE(*ppFrameQueue);
+
+CleanUp:
+    CHK_LOG_ERR(retStatus);
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS frame_queue_start(PFrameQueue pFrameQueue)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    BOOL locked = FALSE;
+
+    CHK(pFrameQueue != NULL, STATUS_NULL_ARG);
+    CHK(!ATOMIC_LOAD_BOOL(&pFrameQueue->terminate), STATUS_INVALID_OPERATION);
+
+    MUTEX_LOCK(pFrameQueue->lock);
+    locked = TRUE;
+
+    CHK(!IS_VALID_TID_VALUE(pFrameQueue->workerTid), retStatus);
+    CHK_STATUS(THREAD_CREATE_EX(&pFrameQueue->workerTid, FRAME_QUEUE_THREAD_NAME, FRAME_QUEUE_THREAD_SIZE, FALSE, frame_queue_workerRoutine,
+                                (PVOID) pFrameQueue));
+
+CleanUp:
+    if (locked) {
+        MUTEX_UNLOCK(pFrameQueue->lock);
+    }
+
+    return retStatus;
+}
+
+STATUS frame_queue_enqueue(PFrameQueue pFrameQueue, PFrame pFrame)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    BOOL locked = FALSE, keyFrame, keyFrameNeeded = FALSE;
+    UINT32 droppedCount = 0;
+    UINT64 droppedBytes = 0;
+    PQueuedFrame pQueuedFrame = NULL;
+    PBYTE pBuffer = NULL;
+
+    CHK(pFrameQueue != NULL && pFrame != NULL, STATUS_NULL_ARG);
+    CHK(pFrame->frameData != NULL || pFrame->size == 0, STATUS_NULL_ARG);
+    keyFrame = (pFrame->flags & FRAME_FLAG_KEY_FRAME) != 0;
+
+    MUTEX_LOCK(pFrameQueue->lock);
+    locked = TRUE;
+
+    if (pFrameQueue->frameCount == pFrameQueue->queueSize) {
+        if (pFrameQueue->dropPolicy == FRAME_QUEUE_DROP_POLICY_DROP_UNTIL_KEY_FRAME) {
+            // The queued frames can not be decoded once one of them is missing, so they all go
+            pFrameQueue->waitForKeyFrame = TRUE;
+            keyFrameNeeded = !keyFrame;
+        }
+        do {
+            droppedBytes += pFrameQueue->pQueue[pFrameQueue->headIndex].frame.size;
+            droppedCount++;
+            pFrameQueue->headIndex = (pFrameQueue->headIndex + 1) % pFrameQueue->queueSize;
+            pFrameQueue->frameCount--;
+        } while (pFrameQueue->waitForKeyFrame && pFrameQueue->frameCount > 0);
+    }
+
+    if (pFrameQueue->waitForKeyFrame && !keyFrame) {
+        droppedBytes += pFrame->size;
+        droppedCount++;
+    } else {
+        pFrameQueue->waitForKeyFrame = FALSE;
+        pQueuedFrame = &pFrameQueue->pQueue[(pFrameQueue->headIndex + pFrameQueue->frameCount) % pFrameQueue->queueSize];
+        if (pFrame->size > pQueuedFrame->bufferLen) {
+            pBuffer = (PBYTE) MEMALLOC(pFrame->size);
+            CHK(pBuffer != NULL, STATUS_NOT_ENOUGH_MEMORY);
+            SAFE_MEMFREE(pQueuedFrame->pBuffer);
+            pQueuedFrame->pBuffer = pBuffer;
+            pQueuedFrame->bufferLen = pFrame->size;
+        }
+        pQueuedFrame->frame = *pFrame;
+        pQueuedFrame->frame.frameData = pQueuedFrame->pBuffer;
+        MEMCPY(pQueuedFrame->pBuffer, pFrame->frameData, pFrame->size);
+        pFrameQueue->frameCount++;
+        CVAR_SIGNAL(pFrameQueue->cvar);
+    }
+
+CleanUp:
+    if (locked) {
+        MUTEX_UNLOCK(pFrameQueue->lock);
+    }
+    if (droppedCount > 0) {
+        DLOGW("Frame queue dropped %u frames", droppedCount);
+        if (pFrameQueue->onDropFn != NULL) {
+            pFrameQueue->onDropFn(pFrameQueue->customData, droppedCount, droppedBytes, keyFrameNeeded);
+        }
+    }
+
+    return retStatus;
+}
+
+STATUS frame_queue_writeNext(PFrameQueue pFrameQueue, PBOOL pWritten)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    BOOL written = FALSE;
+    QueuedFrame queuedFrame;
+
+    CHK(pFrameQueue != NULL, STATUS_NULL_ARG);
+
+    MUTEX_LOCK(pFrameQueue->lock);
+    if (pFrameQueue->frameCount > 0) {
+        // The slot gets the buffer of the previously written frame, so the producer never touches the frame being written
+        queuedFrame = pFrameQueue->pQueue[pFrameQueue->headIndex];
+        pFrameQueue->pQueue[pFrameQueue->headIndex] = pFrameQueue->writingFrame;
+        pFrameQueue->writingFrame = queuedFrame;
+        pFrameQueue->headIndex = (pFrameQueue->headIndex + 1) % pFrameQueue->queueSize;
+        pFrameQueue->frameCount--;
+        written = TRUE;
+    }
+    MUTEX_UNLOCK(pFrameQueue->lock);
+
+    if (written) {
+        retStatus = pFrameQueue->writeFn(pFrameQueue->customData, &pFrameQueue->writingFrame.frame);
+    }
+
+CleanUp:
+    if (pWritten != NULL) {
+        *pWritten = written;
+    }
+
+    return retStatus;
+}
+#endif
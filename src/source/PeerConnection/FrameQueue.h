@@ -0,0 +1,126 @@
+/*
+ * Copyright 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+#ifndef __KINESIS_VIDEO_WEBRTC_CLIENT_PEERCONNECTION_FRAME_QUEUE__
+#define __KINESIS_VIDEO_WEBRTC_CLIENT_PEERCONNECTION_FRAME_QUEUE__
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/******************************************************************************
+ * HEADERS
+ ******************************************************************************/
+#include "kvs/error.h"
+#include "kvs/common_defs.h"
+#include "kvs/platform_utils.h"
+#include "kvs/webrtc_client.h"
+#include "atomics.h"
+#include "mutex.h"
+#include "thread.h"
+
+/******************************************************************************
+ * DEFINITIONS
+ ******************************************************************************/
+// The worker wakes up this often to check whether it has to terminate
+#define FRAME_QUEUE_WAIT_INTERVAL        (100 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+#define FRAME_QUEUE_SHUTDOWN_TIMEOUT     (1000 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+#define FRAME_QUEUE_SHUTDOWN_CHECK_DELAY (10 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+
+/**
+ * @brief write a dequeued frame, same contract as rtp_writeFrame.
+ */
+typedef STATUS (*FrameQueueWriteFunc)(UINT64, PFrame);
+/**
+ * @brief called outside of the queue lock after frames were dropped with the number of frames, their total size
+ *        and whether the queue has just started to drop everything up to the next key frame.
+ */
+typedef VOID (*FrameQueueOnDropFunc)(UINT64, UINT32, UINT64, BOOL);
+
+typedef struct {
+    Frame frame;      //!< frame.frameData points into pBuffer.
+    PBYTE pBuffer;    //!< owned by the slot, it only grows so that steady state queueing does not touch the heap.
+    UINT32 bufferLen;
+} QueuedFrame, *PQueuedFrame;
+
+/**
+ * Bounded queue of frame copies which are written by a worker thread, so that the thread producing the frames never waits for the network.
+ */
+typedef struct __FrameQueue {
+    MUTEX lock;
+    CVAR cvar;
+    volatile ATOMIC_BOOL terminate;
+    TID workerTid;
+    FRAME_QUEUE_DROP_POLICY dropPolicy;
+    BOOL waitForKeyFrame; //!< the queue was flushed by FRAME_QUEUE_DROP_POLICY_DROP_UNTIL_KEY_FRAME and has not seen a key frame since.
+    PQueuedFrame pQueue;
+    UINT32 queueSize;
+    UINT32 headIndex;
+    UINT32 frameCount;
+    QueuedFrame writingFrame; //!< swapped with the head of the queue, so that the frame can be written outside of the lock.
+
+    FrameQueueWriteFunc writeFn;
+    FrameQueueOnDropFunc onDropFn;
+    UINT64 customData;
+} FrameQueue, *PFrameQueue;
+
+/******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+/**
+ * @brief create the queue. The worker is not running until frame_queue_start.
+ *
+ * @param[in] queueSize the max number of queued frames.
+ * @param[in] dropPolicy what to drop once the queue is full.
+ * @param[in] writeFn the callback writing the frames.
+ * @param[in] onDropFn the callback for the stats of the dropped frames.
+ * @param[in] customData the custom data of the callbacks.
+ * @param[out] ppFrameQueue the created queue.
+ *
+ * @return STATUS status of execution
+ */
+STATUS frame_queue_create(UINT32, FRAME_QUEUE_DROP_POLICY, FrameQueueWriteFunc, FrameQueueOnDropFunc, UINT64, PFrameQueue*);
+/**
+ * @brief stop the worker and release the frames which are still queued.
+ */
+STATUS frame_queue_free(PFrameQueue*);
+/**
+ * @brief start the worker thread which writes the queued frames in order.
+ */
+STATUS frame_queue_start(PFrameQueue);
+/**
+ * @brief queue a copy of the frame, the caller keeps the ownership of the frame data.
+ *        A full queue drops frames according to its drop policy, which is not an error.
+ *
+ * @param[in] pFrameQueue the queue.
+ * @param[in] pFrame the frame.
+ *
+ * @return STATUS status of execution
+ */
+STATUS frame_queue_enqueue(PFrameQueue, PFrame);
+/**
+ * @brief write the oldest queued frame. Called by the worker.
+ *
+ * @param[in] pFrameQueue the queue.
+ * @param[out] pWritten whether there was a frame to write.
+ *
+ * @return STATUS the status of the write.
+ */
+STATUS frame_queue_writeNext(PFrameQueue, PBOOL);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __KINESIS_VIDEO_WEBRTC_CLIENT_PEERCONNECTION_FRAME_QUEUE__ */
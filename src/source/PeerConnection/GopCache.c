@@ -0,0 +1,197 @@
+/*
+ * Copyright 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+/******************************************************************************
+ * HEADERS
+ ******************************************************************************/
+#ifdef ENABLE_STREAMING
+#define LOG_CLASS "GopCache"
+
+#include "GopCache.h"
+#include "Rtp.h"
+
+/******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+STATUS gop_cache_create(UINT32 maxByteCount, PGopCache* ppGopCache)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PGopCache pGopCache = NULL;
+
+    CHK(ppGopCache != NULL, STATUS_NULL_ARG);
+    CHK(maxByteCount != 0, STATUS_INVALID_ARG);
+
+    pGopCache = (PGopCache) MEMCALLOC(1, SIZEOF(GopCache));
+    CHK(pGopCache != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    pGopCache->lock = MUTEX_CREATE(FALSE);
+    CHK(IS_VALID_MUTEX_VALUE(pGopCache->lock), STATUS_INVALID_OPERATION);
+    pGopCache->pFrames = (PCachedFrame) MEMCALLOC(GOP_CACHE_MAX_FRAME_COUNT, SIZEOF(CachedFrame));
+    CHK(pGopCache->pFrames != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    pGopCache->maxByteCount = maxByteCount;
+
+CleanUp:
+    if (STATUS_FAILED(retStatus)) {
+        gop_cache_free(&pGopCache);
+    }
+
+    if (ppGopCache != NULL) {
+        *ppGopCache = pGopCache;
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS gop_cache_free(PGopCache* ppGopCache)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PGopCache pGopCache;
+
+    CHK(ppGopCache != NULL, STATUS_NULL_ARG);
+    pGopCache = *ppGopCache;
+    // free is idempotent
+    CHK(pGopCache != NULL, retStatus);
+
+    if (pGopCache->pFrames != NULL) {
+        gop_cache_clear(pGopCache);
+        SAFE_MEMFREE(pGopCache->pFrames);
+    }
+    if (IS_VALID_MUTEX_VALUE(pGopCache->lock)) {
+        MUTEX_FREE(pGopCache->lock);
+    }
+    SAFE_MEMFREE(*ppGopCache);
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS gop_cache_addFrame(PGopCache pGopCache, PFrame pFrame)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PCachedFrame pCachedFrame;
+    PBYTE pFrameData;
+    BOOL keyFrame;
+
+    CHK(pGopCache != NULL && pFrame != NULL, STATUS_NULL_ARG);
+    CHK(pFrame->frameData != NULL || pFrame->size == 0, STATUS_INVALID_ARG);
+
+    keyFrame = (pFrame->flags & FRAME_FLAG_KEY_FRAME) != 0;
+    if (keyFrame) {
+        pGopCache->frameCount = 0;
+        pGopCache->byteCount = 0;
+    }
+    // Without its key frame the rest of the gop does not decode
+    CHK(pGopCache->frameCount > 0 || keyFrame, retStatus);
+    if (pGopCache->frameCount == GOP_CACHE_MAX_FRAME_COUNT) {
+        DLOGW("The gop is longer than %u frames, it is not cached", GOP_CACHE_MAX_FRAME_COUNT);
+        pGopCache->frameCount = 0;
+        pGopCache->byteCount = 0;
+        CHK(FALSE, retStatus);
+    }
+
+    if (pGopCache->byteCount + pFrame->size > pGopCache->maxByteCount) {
+        DLOGW("The gop is larger than %u bytes, it is not cached", pGopCache->maxByteCount);
+        pGopCache->frameCount = 0;
+        pGopCache->byteCount = 0;
+        CHK(FALSE, retStatus);
+    }
+
+    pCachedFrame = &pGopCache->pFrames[pGopCache->frameCount];
+    pFrameData = pCachedFrame->frame.frameData;
+    if (pFrame->size > pCachedFrame->capacity) {
+        SAFE_MEMFREE(pFrameData);
+        pCachedFrame->capacity = 0;
+        pFrameData = (PBYTE) MEMALLOC(pFrame->size);
+        CHK(pFrameData != NULL, STATUS_NOT_ENOUGH_MEMORY);
+        pCachedFrame->capacity = pFrame->size;
+    }
+    if (pFrame->size > 0) {
+        MEMCPY(pFrameData, pFrame->frameData, pFrame->size);
+    }
+    pCachedFrame->frame = *pFrame;
+    pCachedFrame->frame.frameData = pFrameData;
+    pGopCache->byteCount += pFrame->size;
+    pGopCache->frameCount++;
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS gop_cache_copyFrames(PGopCache pGopCache, PGopCache pSourceGopCache)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 i;
+
+    CHK(pGopCache != NULL && pSourceGopCache != NULL, STATUS_NULL_ARG);
+
+    for (i = 0; i < pSourceGopCache->frameCount; i++) {
+        CHK_STATUS(gop_cache_addFrame(pGopCache, &pSourceGopCache->pFrames[i].frame));
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS gop_cache_takeFrames(PGopCache pGopCache, PCachedFrame pFrames, PUINT32 pFrameCount)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+
+    CHK(pGopCache != NULL && pFrames != NULL && pFrameCount != NULL, STATUS_NULL_ARG);
+
+    // The buffers go with the frames, the cache allocates new ones for the frames which come next
+    *pFrameCount = pGopCache->frameCount;
+    MEMCPY(pFrames, pGopCache->pFrames, pGopCache->frameCount * SIZEOF(CachedFrame));
+    MEMSET(pGopCache->pFrames, 0x00, pGopCache->frameCount * SIZEOF(CachedFrame));
+    pGopCache->frameCount = 0;
+    pGopCache->byteCount = 0;
+
+CleanUp:
+
+    return retStatus;
+}
+
+VOID gop_cache_freeFrames(PCachedFrame pFrames, UINT32 frameCount)
+{
+    UINT32 i;
+
+    if (pFrames == NULL) {
+        return;
+    }
+    for (i = 0; i < frameCount; i++) {
+        SAFE_MEMFREE(pFrames[i].frame.frameData);
+        pFrames[i].capacity = 0;
+    }
+}
+
+STATUS gop_cache_clear(PGopCache pGopCache)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+
+    CHK(pGopCache != NULL, STATUS_NULL_ARG);
+
+    gop_cache_freeFrames(pGopCache->pFrames, GOP_CACHE_MAX_FRAME_COUNT);
+    pGopCache->frameCount = 0;
+    pGopCache->byteCount = 0;
+
+CleanUp:
+
+    return retStatus;
+}
+#endif
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+#ifndef __KINESIS_VIDEO_WEBRTC_CLIENT_PEERCONNECTION_GOP_CACHE__
+#define __KINESIS_VIDEO_WEBRTC_CLIENT_PEERCONNECTION_GOP_CACHE__
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/******************************************************************************
+ * HEADERS
+ ******************************************************************************/
+#include "kvs/error.h"
+#include "kvs/common_defs.h"
+#include "kvs/platform_utils.h"
+#include "kvs/webrtc_client.h"
+#include "mutex.h"
+#include "RtpPacket.h"
+
+/******************************************************************************
+ * DEFINITIONS
+ ******************************************************************************/
+#define DEFAULT_GOP_CACHE_MAX_SIZE (1024 * 1024)
+// A gop of a few seconds at 60 fps
+#define GOP_CACHE_MAX_FRAME_COUNT 300
+// The cached frames are sent back to back, their presentation timestamps this far apart
+#define GOP_CACHE_REPLAY_FRAME_INTERVAL (1 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+
+typedef struct {
+    Frame frame;     //!< the frame, frame.frameData points at the copy of the frame data owned by the cache.
+    UINT32 capacity; //!< the size of the frame data buffer, kept for the next gop.
+} CachedFrame, *PCachedFrame;
+
+/**
+ * The frames of a video source since its last key frame. A sender keeps them until the srtp session is up, so that the remote peer gets
+ * a decodable picture right away instead of waiting for the next key frame. A broadcast group keeps the gop of its source for the
+ * viewers which join mid-gop. The frames are kept unpacketized, every sender packetizes them for its own mtu.
+ */
+typedef struct {
+    MUTEX lock;    //!< held while frames are added or taken out, never while they are sent.
+    BOOL flushed;  //!< the cache was sent, the frames are written as they come from then on.
+    BOOL flushing; //!< a flush is sending the frames it took out, the frames which come meanwhile are cached behind them.
+    PCachedFrame pFrames;
+    UINT32 frameCount;
+    UINT32 byteCount;    //!< the frame bytes of the cached frames.
+    UINT32 maxByteCount; //!< the gop is dropped once it grows beyond this, the cache then waits for the next key frame.
+} GopCache, *PGopCache;
+
+/******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+/**
+ * @brief create an empty cache.
+ *
+ * @param[in] maxByteCount the max frame bytes of the cached gop.
+ * @param[out] ppGopCache the created cache.
+ *
+ * @return STATUS status of execution
+ */
+STATUS gop_cache_create(UINT32, PGopCache*);
+STATUS gop_cache_free(PGopCache*);
+/**
+ * @brief copy a frame into the cache. A key frame replaces the cached gop, the frames before the first key frame are dropped.
+ *        Called with the cache lock held.
+ *
+ * @param[in] pGopCache the cache.
+ * @param[in] pFrame the frame, the caller keeps the ownership of the frame data.
+ *
+ * @return STATUS status of execution
+ */
+STATUS gop_cache_addFrame(PGopCache, PFrame);
+/**
+ * @brief add the frames of a cache to another one, see gop_cache_addFrame. Called with both cache locks held.
+ *
+ * @param[in] pGopCache the destination cache.
+ * @param[in] pSourceGopCache the cache to copy.
+ *
+ * @return STATUS status of execution
+ */
+STATUS gop_cache_copyFrames(PGopCache, PGopCache);
+/**
+ * @brief move the cached frames out, the cache is left empty. The caller sends them without the lock and releases them with
+ *        gop_cache_freeFrames. Called with the cache lock held.
+ *
+ * @param[in] pGopCache the cache.
+ * @param[out] pFrames the frames, an array of GOP_CACHE_MAX_FRAME_COUNT entries.
+ * @param[out] pFrameCount the number of frames moved.
+ *
+ * @return STATUS status of execution
+ */
+STATUS gop_cache_takeFrames(PGopCache, PCachedFrame, PUINT32);
+/**
+ * @brief release the frame data of frames taken out of a cache.
+ */
+VOID gop_cache_freeFrames(PCachedFrame, UINT32);
+/**
+ * @brief drop the cached frames and release their buffers. Called with the cache lock held.
+ */
+STATUS gop_cache_clear(PGopCache);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __KINESIS_VIDEO_WEBRTC_CLIENT_PEERCONNECTION_GOP_CACHE__ */
@@ -3,17 +3,167 @@
 
 #include "JitterBuffer.h"
 
+static VOID jitter_buffer_resetHeadFrame(PJitterBuffer pJitterBuffer)
+{
+    MEMSET(&pJitterBuffer->headFrame, 0x00, SIZEOF(JitterBufferFrame));
+    pJitterBuffer->headFrame.startIndex = pJitterBuffer->lastRemovedSequenceNumber + 1;
+    pJitterBuffer->headFrame.nextIndex = pJitterBuffer->headFrame.startIndex;
+}
+
+// Take sequenceNumber as the first packet of the stream
+static VOID jitter_buffer_restart(PJitterBuffer pJitterBuffer, UINT16 sequenceNumber)
+{
+    pJitterBuffer->started = TRUE;
+    pJitterBuffer->lastRemovedSequenceNumber = UINT16_DEC(sequenceNumber);
+    pJitterBuffer->highestSequenceNumber = sequenceNumber;
+    pJitterBuffer->delayEstimator.nominalArrival = 0;
+    jitter_buffer_resetHeadFrame(pJitterBuffer);
+}
+
+// When the frame at timestamp would have arrived without jitter, 0 before the first complete frame
+static UINT64 jitter_buffer_getNominalArrival(PJitterBuffer pJitterBuffer, UINT32 timestamp)
+{
+    PJitterBufferDelayEstimator pEstimator = &pJitterBuffer->delayEstimator;
+    INT64 offset;
+
+    if (pEstimator->nominalArrival == 0) {
+        return 0;
+    }
+    offset = (INT64) (INT32) (timestamp - pEstimator->nominalTimestamp) * HUNDREDS_OF_NANOS_IN_A_SECOND / pJitterBuffer->clockRate;
+    return offset < 0 && (UINT64) -offset >= pEstimator->nominalArrival ? 1 : (UINT64) ((INT64) pEstimator->nominalArrival + offset);
+}
+
+static PJitterBufferSlot jitter_buffer_getSlot(PJitterBuffer pJitterBuffer, UINT16 sequenceNumber)
+{
+    PJitterBufferSlot pSlot = &pJitterBuffer->pPacketRing[sequenceNumber & pJitterBuffer->ringMask];
+
+    return pSlot->pRtpPacket != NULL && pSlot->pRtpPacket->header.sequenceNumber == sequenceNumber ? pSlot : NULL;
+}
+
+static STATUS jitter_buffer_removePackets(PJitterBuffer pJitterBuffer, UINT16 startIndex, UINT16 endIndex, UINT32 nextTimestamp)
+{
+    UINT16 index = startIndex, count;
+    UINT32 i;
+    PJitterBufferSlot pSlot = NULL;
+
+    // An end right before the start is an empty range
+    count = (UINT16) (endIndex + 1 - startIndex);
+    if (count <= pJitterBuffer->ringMask) {
+        for (; UINT16_DEC(index) != endIndex; index++) {
+            if ((pSlot = jitter_buffer_getSlot(pJitterBuffer, index)) != NULL) {
+                rtp_packet_free(&pSlot->pRtpPacket);
+            }
+        }
+    } else {
+        // The range covers the whole ring, so walk the slots instead of the sequence numbers
+        for (i = 0; i <= pJitterBuffer->ringMask; i++) {
+            pSlot = &pJitterBuffer->pPacketRing[i];
+            if (pSlot->pRtpPacket != NULL && (UINT16) (pSlot->pRtpPacket->header.sequenceNumber - startIndex) < count) {
+                rtp_packet_free(&pSlot->pRtpPacket);
+            }
+        }
+    }
+    pJitterBuffer->lastPopTimestamp = nextTimestamp;
+    pJitterBuffer->lastRemovedSequenceNumber = endIndex;
+
+    return STATUS_SUCCESS;
+}
+
+// Double the ring, the packets keep distinct slots as their sequence numbers were distinct modulo the smaller size already
+static STATUS jitter_buffer_growRing(PJitterBuffer pJitterBuffer)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PJitterBufferSlot pPacketRing = NULL;
+    UINT32 i, ringMask = (pJitterBuffer->ringMask << 1) | 1;
+
+    CHK(pJitterBuffer->ringMask + 1 < JITTER_BUFFER_MAX_RING_SIZE, STATUS_INVALID_OPERATION);
+    pPacketRing = (PJitterBufferSlot) MEMCALLOC(ringMask + 1, SIZEOF(JitterBufferSlot));
+    CHK(pPacketRing != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    for (i = 0; i <= pJitterBuffer->ringMask; i++) {
+        if (pJitterBuffer->pPacketRing[i].pRtpPacket != NULL) {
+            pPacketRing[pJitterBuffer->pPacketRing[i].pRtpPacket->header.sequenceNumber & ringMask] = pJitterBuffer->pPacketRing[i];
+        }
+    }
+    MEMFREE(pJitterBuffer->pPacketRing);
+    pJitterBuffer->pPacketRing = pPacketRing;
+    pJitterBuffer->ringMask = ringMask;
+    DLOGI("Jitter buffer ring grown to %u packets", ringMask + 1);
+
+CleanUp:
+    return retStatus;
+}
+
+// Fold a complete frame into the estimates and move the target delay towards what they call for
+static VOID jitter_buffer_updateTargetDelay(PJitterBuffer pJitterBuffer, UINT32 timestamp, UINT32 frameSize, UINT64 arrival)
+{
+    PJitterBufferDelayEstimator pEstimator = &pJitterBuffer->delayEstimator;
+    DOUBLE frameDelay, sizeChange, delayPerByte = 0, sizeDeviation;
+    UINT64 minimumDelay, targetDelay, nominalArrival;
+
+    if (arrival == 0) {
+        return;
+    }
+
+    sizeDeviation = (DOUBLE) frameSize - pEstimator->sizeMean;
+    pEstimator->sizeMean += JITTER_BUFFER_ESTIMATE_WEIGHT * sizeDeviation;
+    pEstimator->sizeVariance += JITTER_BUFFER_ESTIMATE_WEIGHT * (sizeDeviation * sizeDeviation - pEstimator->sizeVariance);
+    // A frame behind the last one says nothing about the delay a larger frame adds
+    if (pEstimator->lastArrival != 0 && (INT32) (timestamp - pEstimator->lastTimestamp) > 0) {
+        frameDelay = (DOUBLE) (INT64) (arrival - pEstimator->lastArrival) -
+            (DOUBLE) (timestamp - pEstimator->lastTimestamp) * HUNDREDS_OF_NANOS_IN_A_SECOND / pJitterBuffer->clockRate;
+        sizeChange = (DOUBLE) frameSize - (DOUBLE) pEstimator->lastSize;
+        pEstimator->delaySizeCovariance += JITTER_BUFFER_ESTIMATE_WEIGHT * (frameDelay * sizeChange - pEstimator->delaySizeCovariance);
+        pEstimator->sizeChangeVariance += JITTER_BUFFER_ESTIMATE_WEIGHT * (sizeChange * sizeChange - pEstimator->sizeChangeVariance);
+    }
+    pEstimator->lastArrival = arrival;
+    pEstimator->lastTimestamp = timestamp;
+    pEstimator->lastSize = frameSize;
+
+    // The frames are played out from the earliest arrivals, the floor creeps up after later ones to follow a drifting clock
+    nominalArrival = jitter_buffer_getNominalArrival(pJitterBuffer, timestamp);
+    if (nominalArrival == 0 || arrival <= nominalArrival ||
+        arrival - nominalArrival > (UINT64) pJitterBuffer->maxLatency * HUNDREDS_OF_NANOS_IN_A_SECOND / pJitterBuffer->clockRate) {
+        nominalArrival = arrival;
+    } else {
+        nominalArrival += (arrival - nominalArrival) / JITTER_BUFFER_TARGET_DELAY_DECAY;
+    }
+    pEstimator->nominalArrival = nominalArrival;
+    pEstimator->nominalTimestamp = timestamp;
+
+    if (pEstimator->sizeChangeVariance > 0 && pEstimator->delaySizeCovariance > 0) {
+        delayPerByte = pEstimator->delaySizeCovariance / pEstimator->sizeChangeVariance;
+    }
+    minimumDelay = (UINT64) (JITTER_BUFFER_JITTER_MULTIPLIER * pJitterBuffer->jitter * HUNDREDS_OF_NANOS_IN_A_SECOND / pJitterBuffer->clockRate +
+                             delayPerByte * JITTER_BUFFER_FRAME_SIZE_DEVIATIONS * SQRT(pEstimator->sizeVariance));
+    if (pJitterBuffer->nackEnabled) {
+        minimumDelay += pJitterBuffer->roundTripTime;
+    }
+    // maxLatency is in clock units
+    pJitterBuffer->minimumDelay = MIN(minimumDelay, (UINT64) pJitterBuffer->maxLatency * HUNDREDS_OF_NANOS_IN_A_SECOND / pJitterBuffer->clockRate);
+
+    if (pJitterBuffer->adaptive) {
+        targetDelay = MAX(pJitterBuffer->minimumDelay, pJitterBuffer->minimumTargetDelay);
+        if (targetDelay < pJitterBuffer->targetDelay) {
+            targetDelay = pJitterBuffer->targetDelay - (pJitterBuffer->targetDelay - targetDelay + JITTER_BUFFER_TARGET_DELAY_DECAY - 1) /
+                    JITTER_BUFFER_TARGET_DELAY_DECAY;
+        }
+        pJitterBuffer->targetDelay = MIN(targetDelay, (UINT64) pJitterBuffer->maxLatency * HUNDREDS_OF_NANOS_IN_A_SECOND / pJitterBuffer->clockRate);
+    }
+}
+
 STATUS jitter_buffer_create(FrameReadyFunc onFrameReadyFunc, FrameDroppedFunc onFrameDroppedFunc, DepayRtpPayloadFunc depayRtpPayloadFunc,
                             UINT32 maxLatency, UINT32 clockRate, UINT64 customData, PJitterBuffer* ppJitterBuffer)
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
     PJitterBuffer pJitterBuffer = NULL;
+    UINT64 packetCount;
+    UINT32 ringSize = JITTER_BUFFER_MIN_RING_SIZE;
 
     CHK(ppJitterBuffer != NULL && onFrameReadyFunc != NULL && onFrameDroppedFunc != NULL && depayRtpPayloadFunc != NULL, STATUS_NULL_ARG);
     CHK(clockRate != 0, STATUS_INVALID_ARG);
 
-    pJitterBuffer = (PJitterBuffer) MEMALLOC(SIZEOF(JitterBuffer));
+    pJitterBuffer = (PJitterBuffer) MEMCALLOC(1, SIZEOF(JitterBuffer));
     CHK(pJitterBuffer != NULL, STATUS_NOT_ENOUGH_MEMORY);
 
     pJitterBuffer->onFrameReadyFn = onFrameReadyFunc;
@@ -25,16 +175,24 @@ STATUS jitter_buffer_create(FrameReadyFunc onFrameReadyFunc, FrameDroppedFunc on
     if (pJitterBuffer->maxLatency == 0) {
         pJitterBuffer->maxLatency = DEFAULT_JITTER_BUFFER_MAX_LATENCY;
     }
+    pJitterBuffer->targetDelay = pJitterBuffer->maxLatency;
     pJitterBuffer->maxLatency = pJitterBuffer->maxLatency * pJitterBuffer->clockRate / HUNDREDS_OF_NANOS_IN_A_SECOND;
 
     pJitterBuffer->lastPushTimestamp = 0;
     pJitterBuffer->lastPopTimestamp = MAX_UINT32;
     pJitterBuffer->lastRemovedSequenceNumber = MAX_SEQUENCE_NUM;
     pJitterBuffer->started = FALSE;
+    jitter_buffer_resetHeadFrame(pJitterBuffer);
 
     pJitterBuffer->customData = customData;
-    CHK_STATUS(hash_table_createWithParams(JITTER_BUFFER_HASH_TABLE_BUCKET_COUNT, JITTER_BUFFER_HASH_TABLE_BUCKET_LENGTH,
-                                           &pJitterBuffer->pPkgBufferHashTable));
+
+    packetCount = JITTER_BUFFER_EXPECTED_PACKET_COUNT(maxLatency);
+    while (ringSize < packetCount && ringSize < JITTER_BUFFER_MAX_RING_SIZE) {
+        ringSize <<= 1;
+    }
+    pJitterBuffer->pPacketRing = (PJitterBufferSlot) MEMCALLOC(ringSize, SIZEOF(JitterBufferSlot));
+    CHK(pJitterBuffer->pPacketRing != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    pJitterBuffer->ringMask = ringSize - 1;
 
 CleanUp:
     if (STATUS_FAILED(retStatus) && pJitterBuffer != NULL) {
@@ -56,6 +214,7 @@ STATUS jitter_buffer_free(PJitterBuffer* ppJitterBuffer)
 
     STATUS retStatus = STATUS_SUCCESS;
     PJitterBuffer pJitterBuffer = NULL;
+    UINT32 i;
 
     CHK(ppJitterBuffer != NULL, STATUS_NULL_ARG);
     // jitter_buffer_free is idempotent
@@ -63,10 +222,13 @@ STATUS jitter_buffer_free(PJitterBuffer* ppJitterBuffer)
 
     pJitterBuffer = *ppJitterBuffer;
 
-    jitter_buffer_pop(pJitterBuffer, TRUE);
-    jitter_buffer_dropBufferData(pJitterBuffer, 0, MAX_SEQUENCE_NUM, 0);
-    hash_table_free(pJitterBuffer->pPkgBufferHashTable);
-    pJitterBuffer->pPkgBufferHashTable = NULL;
+    if (pJitterBuffer->pPacketRing != NULL) {
+        jitter_buffer_pop(pJitterBuffer, TRUE);
+        for (i = 0; i <= pJitterBuffer->ringMask; i++) {
+            rtp_packet_free(&pJitterBuffer->pPacketRing[i].pRtpPacket);
+        }
+        SAFE_MEMFREE(pJitterBuffer->pPacketRing);
+    }
 
     MEMFREE(*ppJitterBuffer);
 
@@ -80,18 +242,36 @@ CleanUp:
 STATUS jitter_buffer_push(PJitterBuffer pJitterBuffer, PRtpPacket pRtpPacket, PBOOL pPacketDiscarded)
 {
     ENTERS();
-    STATUS retStatus = STATUS_SUCCESS, status = STATUS_SUCCESS;
-    UINT64 hashValue = 0;
-    PRtpPacket pCurPacket = NULL;
+    STATUS retStatus = STATUS_SUCCESS;
+    PJitterBufferSlot pSlot = NULL;
+    PJitterBufferFrame pFrame = NULL;
+    UINT16 sequenceNumber, counted;
+    UINT32 payloadSize = 0, lastPopTimestamp;
+    BOOL isStart = FALSE;
 
     CHK(pJitterBuffer != NULL && pRtpPacket != NULL, STATUS_NULL_ARG);
+    sequenceNumber = pRtpPacket->header.sequenceNumber;
+    pFrame = &pJitterBuffer->headFrame;
+    pJitterBuffer->latestArrival = MAX(pJitterBuffer->latestArrival, pRtpPacket->receivedTime);
 
     if (!pJitterBuffer->started ||
-        (pJitterBuffer->lastPopTimestamp == pRtpPacket->header.sequenceNumber &&
-         pJitterBuffer->lastRemovedSequenceNumber >= pRtpPacket->header.sequenceNumber)) {
-        // Set to started and initialize the sequence number
-        pJitterBuffer->started = TRUE;
-        pJitterBuffer->lastRemovedSequenceNumber = UINT16_DEC(pRtpPacket->header.sequenceNumber);
+        (pJitterBuffer->lastPopTimestamp == sequenceNumber && pJitterBuffer->lastRemovedSequenceNumber >= sequenceNumber)) {
+        jitter_buffer_restart(pJitterBuffer, sequenceNumber);
+    } else if ((INT16) (sequenceNumber - pFrame->startIndex) < 0) {
+        // Pop never looks behind the head frame. A packet there with an older timestamp belongs to a frame which is gone, a newer one means
+        // the sender started over or jumped more than half the sequence number space, so the frames buffered so far are flushed.
+        if (pRtpPacket->header.timestamp <= pJitterBuffer->lastPopTimestamp) {
+            DLOGS("jitter_buffer_push discard late packet seqNum %u", sequenceNumber);
+            rtp_packet_free(&pRtpPacket);
+            if (pPacketDiscarded != NULL) {
+                *pPacketDiscarded = TRUE;
+            }
+            CHK(FALSE, retStatus);
+        }
+        DLOGW("Sequence number jumped from %u to %u, restarting the jitter buffer", pFrame->startIndex, sequenceNumber);
+        CHK_STATUS(jitter_buffer_pop(pJitterBuffer, TRUE));
+        pJitterBuffer->lastPopTimestamp = MAX_UINT32;
+        jitter_buffer_restart(pJitterBuffer, sequenceNumber);
     }
 
     if (pJitterBuffer->lastPushTimestamp < pRtpPacket->header.timestamp) {
@@ -100,18 +280,45 @@ STATUS jitter_buffer_push(PJitterBuffer pJitterBuffer, PRtpPacket pRtpPacket, PB
 
     if ((pRtpPacket->header.timestamp < pJitterBuffer->maxLatency && pJitterBuffer->lastPushTimestamp <= pJitterBuffer->maxLatency) ||
         pRtpPacket->header.timestamp >= pJitterBuffer->lastPushTimestamp - pJitterBuffer->maxLatency) {
-        // check the same sequence number is existed or not.
-        status = hash_table_get(pJitterBuffer->pPkgBufferHashTable, pRtpPacket->header.sequenceNumber, &hashValue);
-        pCurPacket = (PRtpPacket) hashValue;
-        // remove the old sequence number.
-        if (STATUS_SUCCEEDED(status) && pCurPacket != NULL) {
-            rtp_packet_free(&pCurPacket);
-            CHK_STATUS(hash_table_remove(pJitterBuffer->pPkgBufferHashTable, pRtpPacket->header.sequenceNumber));
+        // The size and the start flag are all pop needs, so the payload is looked at once
+        retStatus = pJitterBuffer->depayPayloadFn(pRtpPacket->payload, pRtpPacket->payloadLength, NULL, &payloadSize, &isStart);
+        if (STATUS_FAILED(retStatus)) {
+            rtp_packet_free(&pRtpPacket);
+            if (pPacketDiscarded != NULL) {
+                *pPacketDiscarded = TRUE;
+            }
+            CHK(FALSE, retStatus);
         }
-        // push the new sequence number.
-        CHK_STATUS(hash_table_put(pJitterBuffer->pPkgBufferHashTable, pRtpPacket->header.sequenceNumber, (UINT64) pRtpPacket));
+
+        // The ring grows rather than lose a packet which has not been popped yet
+        pSlot = &pJitterBuffer->pPacketRing[sequenceNumber & pJitterBuffer->ringMask];
+        while (pSlot->pRtpPacket != NULL && pSlot->pRtpPacket->header.sequenceNumber != sequenceNumber &&
+               (INT16) (pSlot->pRtpPacket->header.sequenceNumber - pJitterBuffer->lastRemovedSequenceNumber) > 0 &&
+               STATUS_SUCCEEDED(jitter_buffer_growRing(pJitterBuffer))) {
+            pSlot = &pJitterBuffer->pPacketRing[sequenceNumber & pJitterBuffer->ringMask];
+        }
+        // A duplicate replaces the buffered packet, so does a packet a whole ring newer than a stale one
+        counted = pFrame->nextIndex - pFrame->startIndex;
+        if (pSlot->pRtpPacket != NULL) {
+            if ((UINT16) (pSlot->pRtpPacket->header.sequenceNumber - pFrame->startIndex) < counted) {
+                jitter_buffer_resetHeadFrame(pJitterBuffer);
+            }
+            rtp_packet_free(&pSlot->pRtpPacket);
+        }
+        pSlot->pRtpPacket = pRtpPacket;
+        pSlot->payloadSize = payloadSize;
+        pSlot->isStart = isStart;
+
+        lastPopTimestamp = pJitterBuffer->lastPopTimestamp;
         pJitterBuffer->lastPopTimestamp = MIN(pJitterBuffer->lastPopTimestamp, pRtpPacket->header.timestamp);
-        DLOGS("jitter_buffer_push get packet timestamp %lu seqNum %lu", pRtpPacket->header.timestamp, pRtpPacket->header.sequenceNumber);
+        // The head frame was counted against the packets before it and the timestamp it expects, a change to either counts it again
+        if ((UINT16) (sequenceNumber - pFrame->startIndex) < counted || lastPopTimestamp != pJitterBuffer->lastPopTimestamp) {
+            jitter_buffer_resetHeadFrame(pJitterBuffer);
+        }
+        if ((INT16) (sequenceNumber - pJitterBuffer->highestSequenceNumber) > 0) {
+            pJitterBuffer->highestSequenceNumber = sequenceNumber;
+        }
+        DLOGS("jitter_buffer_push get packet timestamp %lu seqNum %lu", pRtpPacket->header.timestamp, sequenceNumber);
     } else {
         // Free the packet if it is out of range, jitter buffer need to own the packet and do free
         rtp_packet_free(&pRtpPacket);
@@ -134,109 +341,97 @@ STATUS jitter_buffer_pop(PJitterBuffer pJitterBuffer, BOOL bufferClosed)
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
-    UINT16 index;
-    UINT16 lastIndex;
-    UINT32 earliestTimestamp = 0;
-    BOOL isFrameDataContinuous = TRUE;
-    UINT32 curTimestamp = 0;
-    UINT16 startDropIndex = 0;
-    UINT32 curFrameSize = 0;
-    UINT32 partialFrameSize = 0;
-    UINT64 hashValue = 0;
-    BOOL isStart = FALSE, containStartForEarliestFrame = FALSE, hasEntry = FALSE;
-    UINT16 lastNonNullIndex = 0;
-    PRtpPacket pCurPacket = NULL;
+    UINT16 index = 0, endIndex;
+    UINT32 earliestTimestamp = 0, curTimestamp, latency;
+    UINT64 playoutTime;
+    BOOL expired, complete;
+    PJitterBufferSlot pSlot = NULL;
+    PJitterBufferFrame pFrame = NULL;
+    JitterBufferFrame frame;
 
     CHK(pJitterBuffer != NULL && pJitterBuffer->onFrameDroppedFn != NULL && pJitterBuffer->onFrameReadyFn != NULL, STATUS_NULL_ARG);
     CHK(pJitterBuffer->lastPushTimestamp != 0, retStatus);
 
-    if (pJitterBuffer->lastPushTimestamp > pJitterBuffer->maxLatency) {
-        earliestTimestamp = pJitterBuffer->lastPushTimestamp - pJitterBuffer->maxLatency;
+    // An adaptive buffer waits for the rest of a frame as long as its target delay, which never exceeds maxLatency
+    latency = pJitterBuffer->maxLatency;
+    if (pJitterBuffer->adaptive) {
+        latency = (UINT32) (pJitterBuffer->targetDelay * pJitterBuffer->clockRate / HUNDREDS_OF_NANOS_IN_A_SECOND);
+    }
+    if (pJitterBuffer->lastPushTimestamp > latency) {
+        earliestTimestamp = pJitterBuffer->lastPushTimestamp - latency;
     }
 
-    lastIndex = pJitterBuffer->lastRemovedSequenceNumber;
-    index = pJitterBuffer->lastRemovedSequenceNumber + 1;
-    startDropIndex = index;
-    for (; index != lastIndex; index++) {
-        CHK_STATUS(hash_table_contains(pJitterBuffer->pPkgBufferHashTable, index, &hasEntry));
-        if (!hasEntry) {
-            isFrameDataContinuous = FALSE;
-            CHK(pJitterBuffer->lastPopTimestamp < earliestTimestamp || bufferClosed, retStatus);
-        } else {
-            lastNonNullIndex = index;
-            retStatus = hash_table_get(pJitterBuffer->pPkgBufferHashTable, index, &hashValue);
-            pCurPacket = (PRtpPacket) hashValue;
-            if (retStatus == STATUS_SUCCESS || retStatus == STATUS_HASH_KEY_NOT_PRESENT) {
-                retStatus = STATUS_SUCCESS;
-            } else {
-                CHK(FALSE, retStatus);
+    // Pick up where the last pop stopped, the packets before index are already counted into the head frame
+    pFrame = &pJitterBuffer->headFrame;
+    frame = *pFrame;
+    index = frame.nextIndex;
+    endIndex = pJitterBuffer->highestSequenceNumber + 1;
+    for (; index != endIndex; index++) {
+        // The head frame goes once it is complete, while it is expired or the buffer is closed it goes anyway and the next one is the head
+        expired = pJitterBuffer->lastPopTimestamp < earliestTimestamp || bufferClosed;
+        pSlot = jitter_buffer_getSlot(pJitterBuffer, index);
+        if (pSlot == NULL) {
+            CHK(expired, retStatus);
+            continue;
+        }
+
+        curTimestamp = pSlot->pRtpPacket->header.timestamp;
+        if (curTimestamp != pJitterBuffer->lastPopTimestamp) {
+            complete = frame.hasStart && frame.packetCount == (UINT16) (index - frame.startIndex);
+            // Nothing after a frame that is neither complete nor expired can go before it
+            CHK(complete || expired, retStatus);
+            if (complete && !expired && pJitterBuffer->adaptive && frame.lastArrival != 0) {
+                // The first frame is held from its own arrival
+                playoutTime = jitter_buffer_getNominalArrival(pJitterBuffer, pJitterBuffer->lastPopTimestamp);
+                playoutTime = (playoutTime == 0 ? frame.lastArrival : playoutTime) + pJitterBuffer->targetDelay;
+                CHK(pJitterBuffer->latestArrival >= playoutTime, retStatus);
             }
-            curTimestamp = pCurPacket->header.timestamp;
-            if (curTimestamp != pJitterBuffer->lastPopTimestamp) {
-                if (pJitterBuffer->lastPopTimestamp < earliestTimestamp || bufferClosed) {
-                    if (containStartForEarliestFrame && isFrameDataContinuous) {
-                        // TODO: if switch to curBuffer, need to carefully calculate ptr of UINT16_DEC(index) as it is a circulate buffer
-                        CHK_STATUS(pJitterBuffer->onFrameReadyFn(pJitterBuffer->customData, startDropIndex, UINT16_DEC(index), curFrameSize));
-                        CHK_STATUS(jitter_buffer_dropBufferData(pJitterBuffer, startDropIndex, UINT16_DEC(index), curTimestamp));
-                        curFrameSize = 0;
-                        containStartForEarliestFrame = FALSE;
-                    } else {
-                        CHK_STATUS(pJitterBuffer->onFrameDroppedFn(pJitterBuffer->customData, startDropIndex, UINT16_DEC(index),
-                                                                   pJitterBuffer->lastPopTimestamp));
-                        CHK_STATUS(jitter_buffer_dropBufferData(pJitterBuffer, startDropIndex, UINT16_DEC(index), curTimestamp));
-                        curFrameSize = 0;
-                        isFrameDataContinuous = TRUE;
-                    }
-                    startDropIndex = index;
-                } else {
-                    if (containStartForEarliestFrame) {
-                        CHK(!bufferClosed, retStatus);
-                        if (isFrameDataContinuous) {
-                            // TODO: if switch to curBuffer, need to carefully calculate ptr of UINT16_DEC(index) as it is a circulate buffer
-                            CHK_STATUS(pJitterBuffer->onFrameReadyFn(pJitterBuffer->customData, startDropIndex, UINT16_DEC(index), curFrameSize));
-                            CHK_STATUS(jitter_buffer_dropBufferData(pJitterBuffer, startDropIndex, UINT16_DEC(index), curTimestamp));
-                            startDropIndex = index;
-                            curFrameSize = 0;
-                        }
-                        containStartForEarliestFrame = FALSE;
-                    }
-                }
+            if (complete) {
+                jitter_buffer_updateTargetDelay(pJitterBuffer, pJitterBuffer->lastPopTimestamp, frame.frameSize, frame.lastArrival);
+                CHK_STATUS(pJitterBuffer->onFrameReadyFn(pJitterBuffer->customData, frame.startIndex, UINT16_DEC(index), frame.frameSize));
+            } else {
+                CHK_STATUS(pJitterBuffer->onFrameDroppedFn(pJitterBuffer->customData, frame.startIndex, UINT16_DEC(index),
+                                                           pJitterBuffer->lastPopTimestamp));
             }
+            CHK_STATUS(jitter_buffer_removePackets(pJitterBuffer, frame.startIndex, UINT16_DEC(index), curTimestamp));
+            frame.startIndex = index;
+            frame.packetCount = 0;
+            frame.frameSize = 0;
+            frame.hasStart = FALSE;
+            frame.lastArrival = 0;
+        }
 
-            CHK_STATUS(pJitterBuffer->depayPayloadFn(pCurPacket->payload, pCurPacket->payloadLength, NULL, &partialFrameSize, &isStart));
-            curFrameSize += partialFrameSize;
-            if (isStart && pJitterBuffer->lastPopTimestamp == curTimestamp) {
-                containStartForEarliestFrame = TRUE;
-            }
+        frame.lastIndex = index;
+        frame.packetCount++;
+        frame.frameSize += pSlot->payloadSize;
+        frame.lastArrival = MAX(frame.lastArrival, pSlot->pRtpPacket->receivedTime);
+        if (pSlot->isStart && pJitterBuffer->lastPopTimestamp == curTimestamp) {
+            frame.hasStart = TRUE;
         }
     }
 
     // Deal with last frame
-    if (bufferClosed && curFrameSize > 0) {
-        curFrameSize = 0;
-        hasEntry = TRUE;
-        for (index = startDropIndex; UINT16_DEC(index) != lastNonNullIndex && hasEntry; index++) {
-            CHK_STATUS(hash_table_contains(pJitterBuffer->pPkgBufferHashTable, index, &hasEntry));
-            if (hasEntry) {
-                CHK_STATUS(hash_table_get(pJitterBuffer->pPkgBufferHashTable, index, &hashValue));
-                pCurPacket = (PRtpPacket) hashValue;
-                CHK_STATUS(pJitterBuffer->depayPayloadFn(pCurPacket->payload, pCurPacket->payloadLength, NULL, &partialFrameSize, NULL));
-                curFrameSize += partialFrameSize;
+    if (bufferClosed && frame.frameSize > 0) {
+        if (frame.packetCount == (UINT16) (frame.lastIndex + 1 - frame.startIndex)) {
+            CHK_STATUS(pJitterBuffer->onFrameReadyFn(pJitterBuffer->customData, frame.startIndex, frame.lastIndex, frame.frameSize));
+        } else {
+            // Report up to the first gap
+            for (index = frame.startIndex; jitter_buffer_getSlot(pJitterBuffer, index) != NULL; index++) {
             }
+            CHK_STATUS(pJitterBuffer->onFrameDroppedFn(pJitterBuffer->customData, frame.startIndex, index, pJitterBuffer->lastPopTimestamp));
         }
+        CHK_STATUS(jitter_buffer_removePackets(pJitterBuffer, frame.startIndex, frame.lastIndex, pJitterBuffer->lastPopTimestamp));
+    }
 
-        // There is no NULL between startIndex and lastNonNullIndex
-        if (UINT16_DEC(index) == lastNonNullIndex) {
-            CHK_STATUS(pJitterBuffer->onFrameReadyFn(pJitterBuffer->customData, startDropIndex, lastNonNullIndex, curFrameSize));
-            CHK_STATUS(jitter_buffer_dropBufferData(pJitterBuffer, startDropIndex, lastNonNullIndex, pJitterBuffer->lastPopTimestamp));
+CleanUp:
+    if (pFrame != NULL) {
+        if (STATUS_FAILED(retStatus) || bufferClosed) {
+            jitter_buffer_resetHeadFrame(pJitterBuffer);
         } else {
-            CHK_STATUS(
-                pJitterBuffer->onFrameDroppedFn(pJitterBuffer->customData, startDropIndex, UINT16_DEC(index), pJitterBuffer->lastPopTimestamp));
-            CHK_STATUS(jitter_buffer_dropBufferData(pJitterBuffer, startDropIndex, lastNonNullIndex, pJitterBuffer->lastPopTimestamp));
+            frame.nextIndex = index;
+            *pFrame = frame;
         }
     }
-
-CleanUp:
     CHK_LOG_ERR(retStatus);
 
     LEAVES();
@@ -247,23 +442,10 @@ STATUS jitter_buffer_dropBufferData(PJitterBuffer pJitterBuffer, UINT16 startInd
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
-    UINT16 index = startIndex;
-    UINT64 hashValue;
-    PRtpPacket pCurPacket = NULL;
-    BOOL hasEntry = FALSE;
 
     CHK(pJitterBuffer != NULL, STATUS_NULL_ARG);
-    for (; UINT16_DEC(index) != endIndex; index++) {
-        CHK_STATUS(hash_table_contains(pJitterBuffer->pPkgBufferHashTable, index, &hasEntry));
-        if (hasEntry) {
-            CHK_STATUS(hash_table_get(pJitterBuffer->pPkgBufferHashTable, index, &hashValue));
-            pCurPacket = (PRtpPacket) hashValue;
-            rtp_packet_free(&pCurPacket);
-            CHK_STATUS(hash_table_remove(pJitterBuffer->pPkgBufferHashTable, index));
-        }
-    }
-    pJitterBuffer->lastPopTimestamp = nextTimestamp;
-    pJitterBuffer->lastRemovedSequenceNumber = endIndex;
+    CHK_STATUS(jitter_buffer_removePackets(pJitterBuffer, startIndex, endIndex, nextTimestamp));
+    jitter_buffer_resetHeadFrame(pJitterBuffer);
 
 CleanUp:
     CHK_LOG_ERR(retStatus);
@@ -278,7 +460,6 @@ STATUS jitter_buffer_fillFrameData(PJitterBuffer pJitterBuffer, PBYTE pFrame, UI
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
     UINT16 index = startIndex;
-    UINT64 hashValue;
     PRtpPacket pCurPacket = NULL;
     PBYTE pCurPtrInFrame = pFrame;
     UINT32 remainingFrameSize = frameSize;
@@ -286,14 +467,7 @@ STATUS jitter_buffer_fillFrameData(PJitterBuffer pJitterBuffer, PBYTE pFrame, UI
 
     CHK(pJitterBuffer != NULL && pFrame != NULL && pFilledSize != NULL, STATUS_NULL_ARG);
     for (; UINT16_DEC(index) != endIndex; index++) {
-        hashValue = 0;
-        retStatus = hash_table_get(pJitterBuffer->pPkgBufferHashTable, index, &hashValue);
-        pCurPacket = (PRtpPacket) hashValue;
-        if (retStatus == STATUS_SUCCESS || retStatus == STATUS_HASH_KEY_NOT_PRESENT) {
-            retStatus = STATUS_SUCCESS;
-        } else {
-            CHK(FALSE, retStatus);
-        }
+        pCurPacket = jitter_buffer_getPacket(pJitterBuffer, index);
         CHK(pCurPacket != NULL, STATUS_NULL_ARG);
         partialFrameSize = remainingFrameSize;
         CHK_STATUS(pJitterBuffer->depayPayloadFn(pCurPacket->payload, pCurPacket->payloadLength, pCurPtrInFrame, &partialFrameSize, NULL));
@@ -310,4 +484,31 @@ CleanUp:
     LEAVES();
     return retStatus;
 }
+
+STATUS jitter_buffer_enableAdaptiveDelay(PJitterBuffer pJitterBuffer, UINT64 minimumTargetDelay)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+
+    CHK(pJitterBuffer != NULL, STATUS_NULL_ARG);
+    pJitterBuffer->adaptive = TRUE;
+    pJitterBuffer->minimumTargetDelay = minimumTargetDelay == 0 ? DEFAULT_JITTER_BUFFER_MIN_TARGET_DELAY : minimumTargetDelay;
+    // Every frame is held for the target delay, so it starts low and rises with the first measurements
+    pJitterBuffer->targetDelay = MIN(pJitterBuffer->minimumTargetDelay,
+                                     (UINT64) pJitterBuffer->maxLatency * HUNDREDS_OF_NANOS_IN_A_SECOND / pJitterBuffer->clockRate);
+
+CleanUp:
+    return retStatus;
+}
+
+PRtpPacket jitter_buffer_getPacket(PJitterBuffer pJitterBuffer, UINT16 sequenceNumber)
+{
+    PJitterBufferSlot pSlot;
+
+    if (pJitterBuffer == NULL) {
+        return NULL;
+    }
+
+    pSlot = jitter_buffer_getSlot(pJitterBuffer, sequenceNumber);
+    return pSlot != NULL ? pSlot->pRtpPacket : NULL;
+}
 #endif
@@ -27,7 +27,6 @@ extern "C" {
 #include "kvs/common_defs.h"
 #include "kvs/platform_utils.h"
 #include "kvs/webrtc_client.h"
-#include "hash_table.h"
 #include "RtpPacket.h"
 
 /******************************************************************************
@@ -37,8 +36,60 @@ typedef STATUS (*FrameReadyFunc)(UINT64, UINT16, UINT16, UINT32);
 typedef STATUS (*FrameDroppedFunc)(UINT64, UINT16, UINT16, UINT32);
 #define UINT16_DEC(a) ((UINT16)((a) -1))
 
-#define JITTER_BUFFER_HASH_TABLE_BUCKET_COUNT  3000
-#define JITTER_BUFFER_HASH_TABLE_BUCKET_LENGTH 2
+// The ring starts with the packets of the max latency at the expected bit rate, it doubles whenever a packet not popped yet would be
+// overwritten. Its size is a power of two
+#define JITTER_BUFFER_EXPECTED_BIT_RATE    (2 * 1024 * 1024)
+#define JITTER_BUFFER_EXPECTED_PACKET_SIZE 1200
+#define JITTER_BUFFER_MIN_RING_SIZE        512
+#define JITTER_BUFFER_MAX_RING_SIZE        (MAX_SEQUENCE_NUM + 1)
+#define JITTER_BUFFER_EXPECTED_PACKET_COUNT(maxLatency)                                                                                            \
+    ((UINT64) ((maxLatency) == 0 ? DEFAULT_JITTER_BUFFER_MAX_LATENCY : (maxLatency)) * JITTER_BUFFER_EXPECTED_BIT_RATE / 8 /                       \
+     JITTER_BUFFER_EXPECTED_PACKET_SIZE / HUNDREDS_OF_NANOS_IN_A_SECOND)
+
+// The adaptive target delay covers this many times the interarrival jitter, and this many standard deviations of the frame size at the
+// delay a byte adds to a frame. It follows a rise at once and a fall by this fraction of the difference per frame. The nominal arrival
+// a frame is held from follows the earliest arrivals at once and later ones by the same fraction
+#define JITTER_BUFFER_JITTER_MULTIPLIER        3
+#define JITTER_BUFFER_FRAME_SIZE_DEVIATIONS    2
+#define JITTER_BUFFER_TARGET_DELAY_DECAY       32
+#define JITTER_BUFFER_ESTIMATE_WEIGHT          (1. / 32.)
+#define DEFAULT_JITTER_BUFFER_MIN_TARGET_DELAY (20 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+
+typedef struct {
+    PRtpPacket pRtpPacket;
+    UINT32 payloadSize; //!< the depayloaded size of the packet, worked out once when it is pushed.
+    BOOL isStart;       //!< whether the packet starts a frame.
+} JitterBufferSlot, *PJitterBufferSlot;
+
+/**
+ * The frame at the head of the buffer as far as pop has looked at it. Pop resumes from nextIndex, so a packet is counted once unless a
+ * packet lands before nextIndex or the head moves, and then the frame is counted again from startIndex.
+ */
+typedef struct {
+    UINT16 startIndex;  //!< the first sequence number of the frame, right after lastRemovedSequenceNumber.
+    UINT16 nextIndex;   //!< the next sequence number to look at.
+    UINT16 lastIndex;   //!< the last buffered sequence number looked at.
+    UINT32 packetCount; //!< the buffered packets from startIndex to nextIndex, the frame has no gap if that is all of them.
+    UINT32 frameSize;   //!< the depayloaded size of these packets.
+    BOOL hasStart;      //!< whether a start packet of lastPopTimestamp has been seen.
+    UINT64 lastArrival; //!< when the last of these packets was received, 0 if unknown.
+} JitterBufferFrame, *PJitterBufferFrame;
+
+/**
+ * Running estimates over the complete frames. The delay a frame arrives with beyond its timestamp is regressed on how much larger it is
+ * than the frame before, which gives the delay per byte a large frame adds.
+ */
+typedef struct {
+    UINT64 lastArrival;          //!< when the last complete frame was received, 0 before the first one.
+    UINT32 lastTimestamp;        //!< the timestamp of the last complete frame.
+    UINT32 lastSize;             //!< the size of the last complete frame.
+    DOUBLE sizeMean;             //!< the mean frame size.
+    DOUBLE sizeVariance;         //!< the variance of the frame size.
+    DOUBLE delaySizeCovariance;  //!< the covariance of the frame delay and the frame size change, in 100ns bytes.
+    DOUBLE sizeChangeVariance;   //!< the variance of the frame size change.
+    UINT64 nominalArrival;       //!< when the frame at nominalTimestamp would have arrived without jitter, 0 before the first frame.
+    UINT32 nominalTimestamp;     //!< the timestamp nominalArrival is for.
+} JitterBufferDelayEstimator, *PJitterBufferDelayEstimator;
 
 typedef struct __JitterBuffer {
     FrameReadyFunc onFrameReadyFn;
@@ -59,7 +110,19 @@ typedef struct __JitterBuffer {
     UINT64 customData;
     UINT32 clockRate;
     BOOL started;
-    PHashTable pPkgBufferHashTable;
+    UINT16 highestSequenceNumber; //!< the newest sequence number buffered, pop looks no further.
+    JitterBufferFrame headFrame;
+    PJitterBufferSlot pPacketRing; //!< the buffered packets at their sequence number masked by ringMask, a newer packet takes over the slot.
+    UINT32 ringMask;
+    BOOL adaptive;              //!< whether frames are played out targetDelay after their nominal arrival rather than when complete.
+    UINT64 minimumTargetDelay;  //!< the floor of targetDelay in adaptive mode, in 100ns.
+    UINT64 targetDelay;         //!< how long after its nominal arrival a frame is handed over in adaptive mode, in 100ns. An incomplete
+                                //!< frame is dropped then.
+    UINT64 latestArrival;       //!< when the newest packet was received, the clock frames are held against.
+    UINT64 minimumDelay;        //!< the delay the measured jitter, frame sizes and round trip time call for, in 100ns.
+    UINT64 roundTripTime;       //!< the time a retransmission takes, in 100ns.
+    BOOL nackEnabled;           //!< whether lost packets are asked for again, a retransmission adds a round trip time to the delay then.
+    JitterBufferDelayEstimator delayEstimator;
 } JitterBuffer, *PJitterBuffer;
 
 /******************************************************************************
@@ -71,6 +134,24 @@ STATUS jitter_buffer_push(PJitterBuffer, PRtpPacket, PBOOL);
 STATUS jitter_buffer_pop(PJitterBuffer, BOOL);
 STATUS jitter_buffer_dropBufferData(PJitterBuffer, UINT16, UINT16, UINT32);
 STATUS jitter_buffer_fillFrameData(PJitterBuffer, PBYTE, UINT32, PUINT32, UINT16, UINT16);
+/**
+ * @brief the buffered packet of a sequence number.
+ *
+ * @return the packet, NULL if it is not buffered.
+ */
+PRtpPacket jitter_buffer_getPacket(PJitterBuffer, UINT16);
+/**
+ * @brief hand a complete frame over a target delay after its nominal arrival, the arrival its timestamp calls for without jitter,
+ *        rather than as soon as it is complete, and drop an incomplete frame then rather than after the max latency. The target delay
+ *        follows the interarrival jitter, the frame size variance and the round trip time, it starts at its floor and never exceeds the
+ *        max latency. The buffer has no timer, a held frame goes on the first push at or after its time or when the buffer is freed.
+ *
+ * @param[in] pJitterBuffer the jitter buffer.
+ * @param[in] minimumTargetDelay the floor of the target delay in 100ns, DEFAULT_JITTER_BUFFER_MIN_TARGET_DELAY if 0.
+ *
+ * @return STATUS status of execution
+ */
+STATUS jitter_buffer_enableAdaptiveDelay(PJitterBuffer, UINT64);
 
 #ifdef __cplusplus
 }
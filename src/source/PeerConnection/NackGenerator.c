@@ -0,0 +1,228 @@
+/*
+ * Copyright 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+/******************************************************************************
+ * HEADERS
+ ******************************************************************************/
+#ifdef ENABLE_STREAMING
+#define LOG_CLASS "NackGenerator"
+
+#include "endianness.h"
+#include "NackGenerator.h"
+
+/******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+STATUS nack_generator_create(UINT32 senderSsrc, UINT32 mediaSsrc, PNackGenerator* ppNackGenerator)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PNackGenerator pNackGenerator = NULL;
+
+    CHK(ppNackGenerator != NULL, STATUS_NULL_ARG);
+
+    pNackGenerator = (PNackGenerator) MEMCALLOC(1, SIZEOF(NackGenerator));
+    CHK(pNackGenerator != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    pNackGenerator->lock = MUTEX_CREATE(FALSE);
+    CHK(IS_VALID_MUTEX_VALUE(pNackGenerator->lock), STATUS_INVALID_OPERATION);
+    pNackGenerator->senderSsrc = senderSsrc;
+    pNackGenerator->mediaSsrc = mediaSsrc;
+
+CleanUp:
+    if (STATUS_FAILED(retStatus)) {
+        nack_generator_free(&pNackGenerator);
+    }
+
+    if (ppNackGenerator != NULL) {
+        *ppNackGenerator = pNackGenerator;
+    }
+    LEAVES();
+    return retStatus;
+}
+
+STATUS nack_generator_free(PNackGenerator* ppNackGenerator)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PNackGenerator pNackGenerator = NULL;
+
+    CHK(ppNackGenerator != NULL, STATUS_NULL_ARG);
+    pNackGenerator = *ppNackGenerator;
+    CHK(pNackGenerator != NULL, retStatus);
+
+    if (IS_VALID_MUTEX_VALUE(pNackGenerator->lock)) {
+        MUTEX_FREE(pNackGenerator->lock);
+    }
+    SAFE_MEMFREE(*ppNackGenerator);
+
+CleanUp:
+    CHK_LOG_ERR(retStatus);
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS nack_generator_onPacketReceived(PNackGenerator pNackGenerator, UINT16 seqNum, UINT64 arrivalTime)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT16 distance, lostSeqNum;
+    UINT32 i;
+    UINT64 sample;
+    PNackMissingPacket pMissingPacket;
+
+    CHK(pNackGenerator != NULL, STATUS_NULL_ARG);
+
+    MUTEX_LOCK(pNackGenerator->lock);
+    if (!pNackGenerator->started) {
+        pNackGenerator->started = TRUE;
+        pNackGenerator->highestSeqNum = seqNum;
+    }
+
+    distance = GET_UINT16_SEQ_NUM(seqNum - pNackGenerator->highestSeqNum);
+    if (distance != 0 && distance < MAX_INT16) {
+        if (distance > NACK_MAX_MISSING_PACKETS) {
+            // Too many to ask for, and the ones before them are behind the gap
+            pNackGenerator->missingCount = 0;
+        } else {
+            for (lostSeqNum = GET_UINT16_SEQ_NUM(pNackGenerator->highestSeqNum + 1); lostSeqNum != seqNum; lostSeqNum++) {
+                if (pNackGenerator->missingCount == NACK_MAX_MISSING_PACKETS) {
+                    // The oldest one is the least likely to still be of use
+                    MEMMOVE(pNackGenerator->missingPackets, pNackGenerator->missingPackets + 1,
+                            (NACK_MAX_MISSING_PACKETS - 1) * SIZEOF(NackMissingPacket));
+                    pNackGenerator->missingCount--;
+                }
+                pMissingPacket = &pNackGenerator->missingPackets[pNackGenerator->missingCount++];
+                pMissingPacket->sequenceNumber = lostSeqNum;
+                pMissingPacket->retries = 0;
+                pMissingPacket->missedTime = arrivalTime;
+                pMissingPacket->lastNackTime = 0;
+            }
+        }
+        pNackGenerator->highestSeqNum = seqNum;
+    } else {
+        // Reordered, retransmitted or repaired
+        for (i = 0; i < pNackGenerator->missingCount; i++) {
+            if (pNackGenerator->missingPackets[i].sequenceNumber == seqNum) {
+                pMissingPacket = &pNackGenerator->missingPackets[i];
+                if (pMissingPacket->retries == 1 && pMissingPacket->lastNackTime != 0 && arrivalTime > pMissingPacket->lastNackTime) {
+                    sample = arrivalTime - pMissingPacket->lastNackTime;
+                    if (pNackGenerator->roundTripTime == 0) {
+                        pNackGenerator->roundTripTime = sample;
+                    } else {
+                        pNackGenerator->roundTripTime =
+                            (pNackGenerator->roundTripTime * (NACK_ROUND_TRIP_TIME_WEIGHT - 1) + sample) / NACK_ROUND_TRIP_TIME_WEIGHT;
+                    }
+                }
+                pNackGenerator->missingCount--;
+                MEMMOVE(pNackGenerator->missingPackets + i, pNackGenerator->missingPackets + i + 1,
+                        (pNackGenerator->missingCount - i) * SIZEOF(NackMissingPacket));
+                break;
+            }
+        }
+    }
+    MUTEX_UNLOCK(pNackGenerator->lock);
+
+CleanUp:
+    return retStatus;
+}
+
+STATUS nack_generator_createNack(PNackGenerator pNackGenerator, UINT64 currentTime, UINT64 roundTripTime, PBYTE pBuffer, PUINT32 pPacketLen)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    BOOL locked = FALSE;
+    UINT32 i, keptCount = 0, packetLen = 0, itemCount = 0;
+    UINT64 retryInterval;
+    UINT16 pid = 0, blp = 0, distance;
+    PNackMissingPacket pMissingPacket;
+
+    CHK(pNackGenerator != NULL && pBuffer != NULL && pPacketLen != NULL, STATUS_NULL_ARG);
+
+    if (roundTripTime == 0) {
+        roundTripTime = NACK_DEFAULT_ROUND_TRIP_TIME;
+    }
+    retryInterval = MAX(roundTripTime, NACK_MIN_RETRY_INTERVAL);
+
+    MUTEX_LOCK(pNackGenerator->lock);
+    locked = TRUE;
+
+    packetLen = RTCP_PACKET_HEADER_LEN + NACK_HEADER_LEN;
+    for (i = 0; i < pNackGenerator->missingCount; i++) {
+        pMissingPacket = &pNackGenerator->missingPackets[i];
+        if (pMissingPacket->retries >= NACK_MAX_RETRIES || currentTime + roundTripTime > pMissingPacket->missedTime + NACK_MAX_PACKET_AGE) {
+            continue;
+        }
+        pNackGenerator->missingPackets[keptCount++] = *pMissingPacket;
+        pMissingPacket = &pNackGenerator->missingPackets[keptCount - 1];
+        if (currentTime < pMissingPacket->missedTime + NACK_REORDER_GRACE_TIME ||
+            (pMissingPacket->lastNackTime != 0 && currentTime < pMissingPacket->lastNackTime + retryInterval)) {
+            continue;
+        }
+
+        // The packets are in order, so a packet shares the item of the one before it if it is among the next 16
+        distance = GET_UINT16_SEQ_NUM(pMissingPacket->sequenceNumber - pid);
+        if (itemCount > 0 && distance > 0 && distance <= NACK_BLP_BITS) {
+            blp |= (UINT16) (1 << (distance - 1));
+        } else {
+            if (itemCount > 0) {
+                putUnalignedInt16BigEndian(pBuffer + packetLen, pid);
+                putUnalignedInt16BigEndian(pBuffer + packetLen + 2, blp);
+                packetLen += NACK_ITEM_LEN;
+            }
+            pid = pMissingPacket->sequenceNumber;
+            blp = 0;
+            itemCount++;
+        }
+        pMissingPacket->retries++;
+        pMissingPacket->lastNackTime = currentTime;
+    }
+    pNackGenerator->missingCount = keptCount;
+    if (itemCount == 0) {
+        packetLen = 0;
+        CHK(FALSE, retStatus);
+    }
+    putUnalignedInt16BigEndian(pBuffer + packetLen, pid);
+    putUnalignedInt16BigEndian(pBuffer + packetLen + 2, blp);
+    packetLen += NACK_ITEM_LEN;
+
+    pBuffer[0] = (RTCP_PACKET_VERSION_VAL << 6) | RTCP_FEEDBACK_MESSAGE_TYPE_NACK;
+    pBuffer[RTCP_PACKET_TYPE_OFFSET] = RTCP_PACKET_TYPE_GENERIC_RTP_FEEDBACK;
+    putUnalignedInt16BigEndian(pBuffer + RTCP_PACKET_LEN_OFFSET, (UINT16) (packetLen / RTCP_PACKET_LEN_WORD_SIZE - 1));
+    putUnalignedInt32BigEndian(pBuffer + RTCP_PACKET_HEADER_LEN, pNackGenerator->senderSsrc);
+    putUnalignedInt32BigEndian(pBuffer + RTCP_PACKET_HEADER_LEN + 4, pNackGenerator->mediaSsrc);
+
+CleanUp:
+    if (locked) {
+        MUTEX_UNLOCK(pNackGenerator->lock);
+    }
+    if (pPacketLen != NULL) {
+        *pPacketLen = packetLen;
+    }
+
+    return retStatus;
+}
+
+STATUS nack_generator_getRoundTripTime(PNackGenerator pNackGenerator, PUINT64 pRoundTripTime)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+
+    CHK(pNackGenerator != NULL && pRoundTripTime != NULL, STATUS_NULL_ARG);
+
+    MUTEX_LOCK(pNackGenerator->lock);
+    *pRoundTripTime = pNackGenerator->roundTripTime;
+    MUTEX_UNLOCK(pNackGenerator->lock);
+
+CleanUp:
+    return retStatus;
+}
+#endif
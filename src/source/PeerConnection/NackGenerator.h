@@ -0,0 +1,144 @@
+/*
+ * Copyright 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+#ifndef __KINESIS_VIDEO_WEBRTC_CLIENT_PEERCONNECTION_NACK_GENERATOR__
+#define __KINESIS_VIDEO_WEBRTC_CLIENT_PEERCONNECTION_NACK_GENERATOR__
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/******************************************************************************
+ * HEADERS
+ ******************************************************************************/
+#include "kvs/error.h"
+#include "kvs/common_defs.h"
+#include "kvs/platform_utils.h"
+#include "RtpPacket.h"
+#include "RtcpPacket.h"
+
+/******************************************************************************
+ * DEFINITIONS
+ ******************************************************************************/
+// RTCP generic NACK, https://tools.ietf.org/html/rfc4585#section-6.2.1
+/*
+ *  0                   1                   2                   3
+ *  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * |V=2|P|  FMT=1  |    PT=205     |           length              |
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * |                  SSRC of packet sender                        |
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * |                  SSRC of media source                         |
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * |            PID                |             BLP               |
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *
+ * The PID is a lost packet, bit n of the BLP the packet PID + n + 1.
+ */
+#define NACK_HEADER_LEN   8  //!< sender ssrc and media ssrc.
+#define NACK_ITEM_LEN     4
+#define NACK_BLP_BITS     16
+#define NACK_INTERVAL     (20 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+// A packet behind a higher one is only asked for once it is this late, so that a reordered packet is not asked for
+#define NACK_REORDER_GRACE_TIME (10 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+// A packet is asked for again a round trip time after the last ask, at least this much later. Before a round trip time is measured
+// the default one is assumed
+#define NACK_MIN_RETRY_INTERVAL (10 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+#define NACK_DEFAULT_ROUND_TRIP_TIME (100 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+#define NACK_MAX_RETRIES        10
+// A retransmission arriving later than this is of no use to the jitter buffer any more
+#define NACK_MAX_PACKET_AGE (1000 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+// The lost packets tracked at once, a larger gap is left to a key frame request
+#define NACK_MAX_MISSING_PACKETS 128
+// A packet arriving after its first nack measures the time a retransmission takes, the samples are smoothed by this weight
+#define NACK_ROUND_TRIP_TIME_WEIGHT 8
+#define NACK_MAX_LEN             (RTCP_PACKET_HEADER_LEN + NACK_HEADER_LEN + NACK_MAX_MISSING_PACKETS * NACK_ITEM_LEN)
+
+typedef struct {
+    UINT16 sequenceNumber;
+    UINT32 retries;      //!< the nacks sent for the packet so far.
+    UINT64 missedTime;   //!< when a higher packet showed the packet missing.
+    UINT64 lastNackTime; //!< when the packet was last asked for, 0 if never.
+} NackMissingPacket, *PNackMissingPacket;
+
+/**
+ * Receiving side of the retransmissions of one media stream. Finds the gaps in the sequence numbers of the received packets and asks
+ * the sender for the lost ones in generic nacks until they arrive, retransmitted or reordered, or are too old to be of use.
+ */
+typedef struct __NackGenerator {
+    MUTEX lock;
+    UINT32 senderSsrc; //!< the ssrc of the nack packets.
+    UINT32 mediaSsrc;  //!< the ssrc of the media packets.
+    BOOL started;      //!< a packet has been received.
+    UINT16 highestSeqNum;
+    NackMissingPacket missingPackets[NACK_MAX_MISSING_PACKETS]; //!< the lost packets in the order of their sequence numbers.
+    UINT32 missingCount;
+    UINT64 roundTripTime; //!< the smoothed time from the first nack of a packet to its arrival, 0 until a nacked packet arrives.
+} NackGenerator, *PNackGenerator;
+
+/******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+/**
+ * @brief create a nack generator.
+ *
+ * @param[in] senderSsrc the ssrc of the nack packets.
+ * @param[in] mediaSsrc the ssrc of the media packets.
+ * @param[out] ppNackGenerator the created generator.
+ *
+ * @return STATUS status of execution
+ */
+STATUS nack_generator_create(UINT32, UINT32, PNackGenerator*);
+STATUS nack_generator_free(PNackGenerator*);
+/**
+ * @brief remember the arrival of a media packet, be it sent, retransmitted or repaired. The packets it skips are lost until they arrive.
+ *
+ * @param[in] pNackGenerator the generator.
+ * @param[in] seqNum the sequence number of the packet.
+ * @param[in] arrivalTime the time the packet arrived.
+ *
+ * @return STATUS status of execution
+ */
+STATUS nack_generator_onPacketReceived(PNackGenerator, UINT16, UINT64);
+/**
+ * @brief build a generic nack of the lost packets which are due to be asked for, past the reordering grace time and a round trip
+ *        time after the last ask. A packet is given up after NACK_MAX_RETRIES nacks or once a retransmission would arrive later than
+ *        NACK_MAX_PACKET_AGE.
+ *
+ * @param[in] pNackGenerator the generator.
+ * @param[in] currentTime the current time.
+ * @param[in] roundTripTime the round trip time in 100ns, 0 if not measured yet.
+ * @param[in] pBuffer the buffer of the packet, at least NACK_MAX_LEN bytes.
+ * @param[out] pPacketLen the length of the packet, 0 if no packet is due.
+ *
+ * @return STATUS status of execution
+ */
+STATUS nack_generator_createNack(PNackGenerator, UINT64, UINT64, PBYTE, PUINT32);
+/**
+ * @brief the time a lost packet takes to arrive after it is asked for, measured on the packets that arrive after a single nack so that
+ *        a sample is not taken against the wrong nack.
+ *
+ * @param[in] pNackGenerator the generator.
+ * @param[out] pRoundTripTime the round trip time in 100ns, 0 until a nacked packet arrives.
+ *
+ * @return STATUS status of execution
+ */
+STATUS nack_generator_getRoundTripTime(PNackGenerator, PUINT64);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __KINESIS_VIDEO_WEBRTC_CLIENT_PEERCONNECTION_NACK_GENERATOR__ */
@@ -0,0 +1,228 @@
+/*
+ * Copyright 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+/******************************************************************************
+ * HEADERS
+ ******************************************************************************/
+#ifdef ENABLE_STREAMING
+#define LOG_CLASS "Pacer"
+
+#include "Pacer.h"
+
+/******************************************************************************
+ * DEFINITIONS
+ ******************************************************************************/
+#define PACER_BYTES_FOR_DURATION(bitrate, multiplier, duration)                                                                                      \
+    ((INT64) ((DOUBLE) (bitrate) * (multiplier) * (DOUBLE) (duration) / (8.0 * HUNDREDS_OF_NANOS_IN_A_SECOND)))
+
+/******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+static STATUS pacer_drainCallback(UINT32 timerId, UINT64 currentTime, UINT64 customData)
+{
+    UNUSED_PARAM(timerId);
+    return pacer_drain((PPacer) customData, currentTime);
+}
+
+STATUS pacer_create(UINT32 queueSize, DOUBLE pacingMultiplier, TIMER_QUEUE_HANDLE timerQueueHandle, PacerSendFunc sendFn,
+                    PacerOnPacketSentFunc onPacketSentFn, UINT64 customData, PPacer* ppPacer)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PPacer pPacer = NULL;
+
+    CHK(ppPacer != NULL && sendFn != NULL, STATUS_NULL_ARG);
+    CHK(IS_VALID_TIMER_QUEUE_HANDLE(timerQueueHandle) && queueSize != 0 && pacingMultiplier > 0, STATUS_INVALID_ARG);
+
+    pPacer = (PPacer) MEMCALLOC(1, SIZEOF(Pacer));
+    CHK(pPacer != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    pPacer->timerId = MAX_UINT32;
+    pPacer->lock = MUTEX_CREATE(FALSE);
+    CHK(IS_VALID_MUTEX_VALUE(pPacer->lock), STATUS_INVALID_OPERATION);
+    pPacer->pQueue = (PPacedPacket) MEMCALLOC(queueSize, SIZEOF(PacedPacket));
+    CHK(pPacer->pQueue != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    pPacer->queueSize = queueSize;
+    pPacer->pacingMultiplier = pacingMultiplier;
+    pPacer->targetBitrate = DEFAULT_PACER_BITRATE;
+    pPacer->timerQueueHandle = timerQueueHandle;
+    pPacer->sendFn = sendFn;
+    pPacer->onPacketSentFn = onPacketSentFn;
+    pPacer->customData = customData;
+
+    CHK_STATUS(timer_queue_addTimer(timerQueueHandle, PACER_DRAIN_INTERVAL, PACER_DRAIN_INTERVAL, pacer_drainCallback, (UINT64) pPacer,
+                                    &pPacer->timerId));
+
+CleanUp:
+    if (STATUS_FAILED(retStatus)) {
+        pacer_free(&pPacer);
+    }
+
+    if (ppPacer != NULL) {
+        *ppPacer = pPacer;
+    }
+    LEAVES();
+    return retStatus;
+}
+
+STATUS pacer_free(PPacer* ppPacer)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PPacer pPacer = NULL;
+    UINT32 i;
+
+    CHK(ppPacer != NULL, STATUS_NULL_ARG);
+    pPacer = *ppPacer;
+    CHK(pPacer != NULL, retStatus);
+
+    if (pPacer->timerId != MAX_UINT32) {
+        CHK_LOG_ERR(timer_queue_cancelTimer(pPacer->timerQueueHandle, pPacer->timerId, (UINT64) pPacer));
+    }
+
+    if (pPacer->pQueue != NULL) {
+        for (i = 0; i < pPacer->packetCount; i++) {
+            rtp_packet_free(&pPacer->pQueue[(pPacer->headIndex + i) % pPacer->queueSize].pRtpPacket);
+        }
+        MEMFREE(pPacer->pQueue);
+    }
+    if (IS_VALID_MUTEX_VALUE(pPacer->lock)) {
+        MUTEX_FREE(pPacer->lock);
+    }
+    SAFE_MEMFREE(*ppPacer);
+
+CleanUp:
+    CHK_LOG_ERR(retStatus);
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS pacer_setTargetBitrate(PPacer pPacer, UINT64 targetBitrate)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+
+    CHK(pPacer != NULL, STATUS_NULL_ARG);
+    CHK(targetBitrate != 0, STATUS_INVALID_ARG);
+
+    MUTEX_LOCK(pPacer->lock);
+    pPacer->targetBitrate = targetBitrate;
+    MUTEX_UNLOCK(pPacer->lock);
+
+CleanUp:
+    return retStatus;
+}
+
+STATUS pacer_enqueue(PPacer pPacer, UINT64 streamCustomData, PRtpPacket* ppRtpPackets, PUINT32 pPacketLens, UINT32 count, PUINT32 pQueuedCount)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    BOOL locked = FALSE;
+    UINT32 queuedCount = 0;
+    UINT64 now = GETTIME();
+    PPacedPacket pPacedPacket = NULL;
+
+    CHK(pPacer != NULL && ppRtpPackets != NULL && pPacketLens != NULL, STATUS_NULL_ARG);
+
+    MUTEX_LOCK(pPacer->lock);
+    locked = TRUE;
+
+    for (; queuedCount < count && pPacer->packetCount < pPacer->queueSize; queuedCount++) {
+        CHK(ppRtpPackets[queuedCount] != NULL, STATUS_NULL_ARG);
+        pPacedPacket = &pPacer->pQueue[(pPacer->headIndex + pPacer->packetCount) % pPacer->queueSize];
+        CHK_STATUS(rtp_packet_addRef(ppRtpPackets[queuedCount]));
+        pPacedPacket->pRtpPacket = ppRtpPackets[queuedCount];
+        pPacedPacket->packetLen = pPacketLens[queuedCount];
+        pPacedPacket->enqueueTime = now;
+        pPacedPacket->streamCustomData = streamCustomData;
+        pPacer->packetCount++;
+    }
+
+    if (queuedCount < count) {
+        DLOGW("Pacer queue is full, %u packets are not queued", count - queuedCount);
+    }
+
+CleanUp:
+    if (locked) {
+        MUTEX_UNLOCK(pPacer->lock);
+    }
+    if (pQueuedCount != NULL) {
+        *pQueuedCount = queuedCount;
+    }
+
+    return retStatus;
+}
+
+STATUS pacer_drain(PPacer pPacer, UINT64 currentTime)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    BOOL locked = FALSE;
+    UINT32 i, batchCount = 0, sentCount = 0, discardedCount = 0;
+    UINT64 now;
+    PPacedPacket pPacedPacket = NULL;
+    PacedPacket batch[PACER_SEND_BATCH_SIZE];
+    PBYTE ppBufs[PACER_SEND_BATCH_SIZE];
+    UINT32 bufLens[PACER_SEND_BATCH_SIZE];
+
+    CHK(pPacer != NULL, STATUS_NULL_ARG);
+
+    MUTEX_LOCK(pPacer->lock);
+    locked = TRUE;
+    if (pPacer->lastDrainTime != 0 && currentTime > pPacer->lastDrainTime) {
+        pPacer->budget += PACER_BYTES_FOR_DURATION(pPacer->targetBitrate, pPacer->pacingMultiplier, currentTime - pPacer->lastDrainTime);
+    } else {
+        pPacer->budget += PACER_BYTES_FOR_DURATION(pPacer->targetBitrate, pPacer->pacingMultiplier, PACER_DRAIN_INTERVAL);
+    }
+    pPacer->budget = MIN(pPacer->budget, PACER_BYTES_FOR_DURATION(pPacer->targetBitrate, pPacer->pacingMultiplier, PACER_MAX_BURST_DURATION));
+    pPacer->lastDrainTime = currentTime;
+
+    do {
+        // Take a batch out of the queue, it is sent without holding the lock so that writers are not blocked by the socket
+        for (batchCount = 0; batchCount < PACER_SEND_BATCH_SIZE && pPacer->packetCount > 0 && pPacer->budget > 0; batchCount++) {
+            pPacedPacket = &pPacer->pQueue[pPacer->headIndex];
+            batch[batchCount] = *pPacedPacket;
+            ppBufs[batchCount] = pPacedPacket->pRtpPacket->pRawPacket;
+            bufLens[batchCount] = pPacedPacket->packetLen;
+            pPacer->budget -= pPacedPacket->packetLen;
+            pPacedPacket->pRtpPacket = NULL;
+            pPacer->headIndex = (pPacer->headIndex + 1) % pPacer->queueSize;
+            pPacer->packetCount--;
+        }
+        MUTEX_UNLOCK(pPacer->lock);
+        locked = FALSE;
+
+        if (batchCount > 0) {
+            sentCount = 0;
+            discardedCount = 0;
+            CHK_LOG_ERR(pPacer->sendFn(pPacer->customData, ppBufs, bufLens, batchCount, &sentCount, &discardedCount));
+            now = GETTIME();
+            for (i = 0; i < batchCount; i++) {
+                if (pPacer->onPacketSentFn != NULL) {
+                    pPacer->onPacketSentFn(batch[i].streamCustomData, batch[i].pRtpPacket, batch[i].packetLen, now - batch[i].enqueueTime,
+                                           i < sentCount, i >= sentCount && i < sentCount + discardedCount);
+                }
+                rtp_packet_free(&batch[i].pRtpPacket);
+            }
+
+            MUTEX_LOCK(pPacer->lock);
+            locked = TRUE;
+        }
+    } while (batchCount == PACER_SEND_BATCH_SIZE);
+
+CleanUp:
+    if (locked) {
+        MUTEX_UNLOCK(pPacer->lock);
+    }
+
+    return retStatus;
+}
+#endif
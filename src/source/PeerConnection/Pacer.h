@@ -0,0 +1,134 @@
+/*
+ * Copyright 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+#ifndef __KINESIS_VIDEO_WEBRTC_CLIENT_PEERCONNECTION_PACER__
+#define __KINESIS_VIDEO_WEBRTC_CLIENT_PEERCONNECTION_PACER__
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/******************************************************************************
+ * HEADERS
+ ******************************************************************************/
+#include "kvs/error.h"
+#include "kvs/common_defs.h"
+#include "kvs/platform_utils.h"
+#include "timer_queue.h"
+#include "RtpPacket.h"
+
+/******************************************************************************
+ * DEFINITIONS
+ ******************************************************************************/
+#define PACER_DRAIN_INTERVAL     (5 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+#define DEFAULT_PACER_QUEUE_SIZE 1024
+// Pace at a multiple of the target bitrate so that the queue drains between frames
+#define DEFAULT_PACING_MULTIPLIER 2.5
+// Used until the application reports a target bitrate through rtp_updateEncoderStats
+#define DEFAULT_PACER_BITRATE (2 * 1024 * 1024)
+// The budget never grows beyond what this window allows, so an idle pacer does not turn into a burst
+#define PACER_MAX_BURST_DURATION (10 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+// Max number of packets handed to a single send call
+#define PACER_SEND_BATCH_SIZE 32
+
+/**
+ * @brief send the encrypted packets, same contract as ice_agent_sendBatch.
+ */
+typedef STATUS (*PacerSendFunc)(UINT64, PBYTE*, PUINT32, UINT32, PUINT32, PUINT32);
+/**
+ * @brief called once for every packet which leaves the queue with the stream custom data it was queued with,
+ *        the packet, its length, the time it spent in the queue, whether it was sent and whether the transport failed to send it.
+ *        A packet which leaves the queue while there is no transport to send it on is neither sent nor discarded.
+ */
+typedef VOID (*PacerOnPacketSentFunc)(UINT64, PRtpPacket, UINT32, UINT64, BOOL, BOOL);
+
+typedef struct {
+    PRtpPacket pRtpPacket; //!< the packet holding the encrypted bytes, the queue owns one reference.
+    UINT32 packetLen;      //!< the length of the encrypted bytes.
+    UINT64 enqueueTime;
+    UINT64 streamCustomData;
+} PacedPacket, *PPacedPacket;
+
+/**
+ * Leaky bucket pacer. The queued packets are drained by a timer at the target bitrate times the pacing multiplier.
+ */
+typedef struct __Pacer {
+    MUTEX lock;
+    DOUBLE pacingMultiplier;
+    UINT64 targetBitrate; //!< bits per second
+    INT64 budget;         //!< bytes which can be sent right away, goes negative when a packet overshoots it.
+    UINT64 lastDrainTime;
+    PPacedPacket pQueue;
+    UINT32 queueSize;
+    UINT32 headIndex;
+    UINT32 packetCount;
+
+    TIMER_QUEUE_HANDLE timerQueueHandle;
+    UINT32 timerId;
+    PacerSendFunc sendFn;
+    PacerOnPacketSentFunc onPacketSentFn;
+    UINT64 customData;
+} Pacer, *PPacer;
+
+/******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+/**
+ * @brief create the pacer and start its drain timer.
+ *
+ * @param[in] queueSize the max number of queued packets.
+ * @param[in] pacingMultiplier the multiple of the target bitrate the queue is drained at.
+ * @param[in] timerQueueHandle the timer queue which drives the pacer.
+ * @param[in] sendFn the callback sending the packets.
+ * @param[in] onPacketSentFn the callback for the stats of every packet leaving the queue.
+ * @param[in] customData the custom data of sendFn.
+ * @param[out] ppPacer the created pacer.
+ *
+ * @return STATUS status of execution
+ */
+STATUS pacer_create(UINT32, DOUBLE, TIMER_QUEUE_HANDLE, PacerSendFunc, PacerOnPacketSentFunc, UINT64, PPacer*);
+/**
+ * @brief stop the drain timer and release the packets which are still queued.
+ */
+STATUS pacer_free(PPacer*);
+STATUS pacer_setTargetBitrate(PPacer, UINT64);
+/**
+ * @brief queue encrypted packets. The pacer takes its own reference on every queued packet.
+ *
+ * @param[in] pPacer the pacer.
+ * @param[in] streamCustomData handed back to onPacketSentFn.
+ * @param[in] ppRtpPackets the packets holding the encrypted bytes in pRawPacket.
+ * @param[in] pPacketLens the length of the encrypted bytes.
+ * @param[in] count the number of packets.
+ * @param[out] pQueuedCount the number of queued packets, the ones beyond a full queue are not queued.
+ *
+ * @return STATUS status of execution
+ */
+STATUS pacer_enqueue(PPacer, UINT64, PRtpPacket*, PUINT32, UINT32, PUINT32);
+/**
+ * @brief refill the budget for the time elapsed since the last drain and send as many queued packets as it allows.
+ *        Called by the drain timer.
+ *
+ * @param[in] pPacer the pacer.
+ * @param[in] currentTime the current time.
+ *
+ * @return STATUS status of execution
+ */
+STATUS pacer_drain(PPacer, UINT64);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __KINESIS_VIDEO_WEBRTC_CLIENT_PEERCONNECTION_PACER__ */
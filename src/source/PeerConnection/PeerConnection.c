@@ -31,6 +31,8 @@
 #include "DataChannel.h"
 #include "RtpVP8Payloader.h"
 #include "RtpH264Payloader.h"
+#include "RtpH265Payloader.h"
+#include "RtpAV1Payloader.h"
 #include "RtpOpusPayloader.h"
 #include "RtpG711Payloader.h"
 #include "timer_queue.h"
@@ -180,6 +182,62 @@ CleanUp:
  *
  * @return STATUS status of execution
  */
+#ifdef ENABLE_STREAMING
+/**
+ * @brief sizes the rtp packets to the path mtu the ice agent found for the selected candidate pair, called again whenever another pair is
+ * selected. The configured mtu is used if no path mtu probe of the pair was answered. The media payloads leave room for the repair
+ * packets, see rtp_getPayloadMtu, so a path mtu which does not fit them is not taken either.
+ *
+ * @param[in] pKvsPeerConnection the peer connection.
+ */
+static VOID pc_updatePathMtu(PKvsPeerConnection pKvsPeerConnection)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT16 pathMtu = 0;
+    UINT32 mtu;
+
+    CHK_STATUS(ice_agent_getPathMtu(pKvsPeerConnection->pIceAgent, &pathMtu));
+
+    mtu = pKvsPeerConnection->configuredMtu;
+    if (pathMtu > PATH_MTU_RTP_OVERHEAD + RTP_REPAIR_MAX_OVERHEAD) {
+        // The pooled packets were sized for the largest probe
+        mtu = MIN(pathMtu - PATH_MTU_RTP_OVERHEAD,
+                  pKvsPeerConnection->pRtpPacketPool->slotSize - RTP_PACKET_SLOT_HEADER_ROOM - SRTP_AUTH_TAG_OVERHEAD);
+    }
+    pKvsPeerConnection->MTU = (UINT16) mtu;
+    DLOGI("path mtu is %u bytes, the rtp payloads are up to %u bytes and the media payloads up to %u bytes", pathMtu, pKvsPeerConnection->MTU,
+          rtp_getPayloadMtu(pKvsPeerConnection));
+
+CleanUp:
+
+    CHK_LOG_ERR(retStatus);
+}
+
+/**
+ * @brief send the gops the video transceivers cached while the srtp session was not up.
+ *
+ * @param[in] pKvsPeerConnection the peer connection.
+ */
+static VOID pc_flushGopCaches(PKvsPeerConnection pKvsPeerConnection)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PDoubleListNode pCurNode = NULL;
+    UINT64 data;
+
+    CHK_STATUS(double_list_getHeadNode(pKvsPeerConnection->pTransceivers, &pCurNode));
+    while (pCurNode != NULL) {
+        CHK_STATUS(double_list_getNodeData(pCurNode, &data));
+        pCurNode = pCurNode->pNext;
+        // The error is logged, the other transceivers still get their cache sent
+        rtp_transceiver_flushGopCache((PKvsRtpTransceiver) data);
+    }
+
+CleanUp:
+
+    CHK_LOG_ERR(retStatus);
+}
+#endif
+
 VOID pc_onInboundPacket(UINT64 customData, PBYTE buff, UINT32 buffLen)
 {
     PC_ENTER();
@@ -215,6 +273,8 @@ VOID pc_onInboundPacket(UINT64 customData, PBYTE buff, UINT32 buffLen)
 #ifdef ENABLE_STREAMING
             if (pKvsPeerConnection->pSrtpSession == NULL) {
                 CHK_STATUS(pc_allocateSrtp(pKvsPeerConnection));
+                pc_updatePathMtu(pKvsPeerConnection);
+                pc_flushGopCaches(pKvsPeerConnection);
             }
 #endif
 
@@ -255,17 +315,265 @@ CleanUp:
 }
 
 #ifdef ENABLE_STREAMING
+static VOID pc_onTwccPacketReceived(PKvsPeerConnection pKvsPeerConnection, PRtpPacket pRtpPacket, UINT64 arrivalTime)
+{
+    RtpExtensionElements elements;
+
+    if (pKvsPeerConnection->pTwccReceiver != NULL && pKvsPeerConnection->extensionMap.ids[RTP_EXTENSION_TWCC] != 0 &&
+        STATUS_SUCCEEDED(rtp_extension_parse(&pKvsPeerConnection->extensionMap, pRtpPacket, &elements)) &&
+        elements.length[RTP_EXTENSION_TWCC] >= SIZEOF(UINT16)) {
+        CHK_LOG_ERR(twcc_receiver_onPacketReceived(pKvsPeerConnection->pTwccReceiver, pRtpPacket->header.ssrc,
+                                                   getUnalignedInt16BigEndian(elements.pData[RTP_EXTENSION_TWCC]), arrivalTime));
+    }
+}
+
+/**
+ * @brief rebuild a lost media packet from a flexfec repair packet and hand it to the jitter buffer like a received one.
+ *
+ * @param[in] pKvsPeerConnection the peer connection.
+ * @param[in] pTransceiver the transceiver the repair packet protects.
+ * @param[in] pBuffer the encrypted repair packet.
+ * @param[in] bufferLen the length of the repair packet.
+ *
+ * @return STATUS status of execution
+ */
+static STATUS pc_onFlexFecPacket(PKvsPeerConnection pKvsPeerConnection, PKvsRtpTransceiver pTransceiver, PBYTE pBuffer, UINT32 bufferLen)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    RtpPacket rtpPacket;
+    PRtpPacket pRtpPacket = NULL;
+    PBYTE pRecoveredPacket = NULL;
+    UINT32 recoveredLen = 0;
+    UINT64 now, fecPacketsReceived = 0, fecPacketsDiscarded = 0, packetsRepaired = 0;
+    BOOL ownedByJitterBuffer = FALSE, discarded = FALSE;
+
+    CHK_STATUS(srtp_session_decryptSrtpPacket(pKvsPeerConnection->pSrtpSession, pBuffer, (PINT32) &bufferLen));
+    now = GETTIME();
+    fecPacketsReceived++;
+    CHK_STATUS(rtp_packet_setPacketFromBytes(pBuffer, bufferLen, &rtpPacket));
+    pc_onTwccPacketReceived(pKvsPeerConnection, &rtpPacket, now);
+
+    retStatus = flexfec_receiver_onRepairPacket(pTransceiver->pFlexFecReceiver, rtpPacket.payload, rtpPacket.payloadLength, &pRecoveredPacket,
+                                                &recoveredLen);
+    if (STATUS_FAILED(retStatus) || recoveredLen == 0) {
+        // nothing was lost, or the repair packet came too late or too early to rebuild what was lost
+        fecPacketsDiscarded++;
+        CHK(FALSE, retStatus);
+    }
+
+    CHK_STATUS(rtp_packet_pool_get(pKvsPeerConnection->pRtpPacketPool, recoveredLen, &pRtpPacket));
+    MEMCPY(pRtpPacket->pRawPacket, pRecoveredPacket, recoveredLen);
+    pRtpPacket->rawPacketLength = recoveredLen;
+    CHK_STATUS(rtp_packet_setPacketFromBytes(pRtpPacket->pRawPacket, recoveredLen, pRtpPacket));
+    pRtpPacket->receivedTime = now;
+    packetsRepaired++;
+    if (pTransceiver->pNackGenerator != NULL) {
+        CHK_LOG_ERR(nack_generator_onPacketReceived(pTransceiver->pNackGenerator, pRtpPacket->header.sequenceNumber, now));
+    }
+    ownedByJitterBuffer = TRUE;
+    CHK_STATUS(jitter_buffer_push(pTransceiver->pJitterBuffer, pRtpPacket, &discarded));
+
+CleanUp:
+    if (fecPacketsReceived > 0) {
+        MUTEX_LOCK(pTransceiver->statsLock);
+        pTransceiver->inboundStats.fecPacketsReceived += fecPacketsReceived;
+        pTransceiver->inboundStats.fecPacketsDiscarded += fecPacketsDiscarded;
+        pTransceiver->inboundStats.received.packetsRepaired += packetsRepaired;
+        MUTEX_UNLOCK(pTransceiver->statsLock);
+    }
+    if (!ownedByJitterBuffer) {
+        rtp_packet_free(&pRtpPacket);
+    }
+
+    return retStatus;
+}
+
+/**
+ * @brief restore the media packet a retransmission of the remote carries and hand it to the jitter buffer like a received one.
+ *        https://tools.ietf.org/html/rfc4588#section-4
+ *
+ * @param[in] pKvsPeerConnection the peer connection.
+ * @param[in] pTransceiver the transceiver the retransmission is for.
+ * @param[in] pBuffer the encrypted rtx packet.
+ * @param[in] bufferLen the length of the rtx packet.
+ *
+ * @return STATUS status of execution
+ */
+static STATUS pc_onRtxPacket(PKvsPeerConnection pKvsPeerConnection, PKvsRtpTransceiver pTransceiver, PBYTE pBuffer, UINT32 bufferLen)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PJitterBuffer pJitterBuffer = pTransceiver->pJitterBuffer;
+    RtpPacket rtxPacket;
+    PRtpPacket pRtpPacket = NULL;
+    PBYTE pRawPacket;
+    UINT32 payloadLength, packetLength;
+    UINT16 sequenceNumber;
+    UINT64 now, payloadType = 0;
+    BOOL ownedByJitterBuffer = FALSE, discarded = FALSE;
+
+    CHK_STATUS(srtp_session_decryptSrtpPacket(pKvsPeerConnection->pSrtpSession, pBuffer, (PINT32) &bufferLen));
+    now = GETTIME();
+    CHK_STATUS(rtp_packet_setPacketFromBytes(pBuffer, bufferLen, &rtxPacket));
+    pc_onTwccPacketReceived(pKvsPeerConnection, &rtxPacket, now);
+
+    payloadLength = rtxPacket.payloadLength;
+    if (rtxPacket.header.padding && payloadLength > 0) {
+        payloadLength -= MIN(rtxPacket.payload[payloadLength - 1], payloadLength);
+    }
+    // A padding only packet probes the bandwidth, it carries no original sequence number
+    CHK(payloadLength > SIZEOF(UINT16), retStatus);
+    sequenceNumber = getUnalignedInt16BigEndian(rtxPacket.payload);
+    if (pTransceiver->pNackGenerator != NULL) {
+        CHK_LOG_ERR(nack_generator_onPacketReceived(pTransceiver->pNackGenerator, sequenceNumber, now));
+    }
+    // Already played out or already there, a nack may be answered more than once
+    CHK(pJitterBuffer->started && (INT16) (sequenceNumber - pJitterBuffer->lastRemovedSequenceNumber) > 0 &&
+            jitter_buffer_getPacket(pJitterBuffer, sequenceNumber) == NULL,
+        retStatus);
+
+    // The payload type of the rtx packet only maps back to the original one in the rtx table, the codec is that of the receiver
+    hash_table_get(pKvsPeerConnection->pCodecTable, pTransceiver->transceiver.receiver.track.codec, &payloadType);
+    packetLength = MIN_HEADER_LENGTH + payloadLength - SIZEOF(UINT16);
+    CHK_STATUS(rtp_packet_pool_get(pKvsPeerConnection->pRtpPacketPool, packetLength, &pRtpPacket));
+    pRawPacket = pRtpPacket->pRawPacket;
+    // version 2, without padding, header extension and csrcs
+    pRawPacket[0] = 2 << VERSION_SHIFT;
+    pRawPacket[1] = (rtxPacket.header.marker ? 1 << MARKER_SHIFT : 0) | ((UINT8) payloadType & PAYLOAD_TYPE_MASK);
+    putUnalignedInt16BigEndian(pRawPacket + SEQ_NUMBER_OFFSET, sequenceNumber);
+    putUnalignedInt32BigEndian(pRawPacket + TIMESTAMP_OFFSET, rtxPacket.header.timestamp);
+    putUnalignedInt32BigEndian(pRawPacket + SSRC_OFFSET, pTransceiver->jitterBufferSsrc);
+    MEMCPY(pRawPacket + MIN_HEADER_LENGTH, rtxPacket.payload + SIZEOF(UINT16), payloadLength - SIZEOF(UINT16));
+    pRtpPacket->rawPacketLength = packetLength;
+    CHK_STATUS(rtp_packet_setPacketFromBytes(pRawPacket, packetLength, pRtpPacket));
+    pRtpPacket->receivedTime = now;
+    ownedByJitterBuffer = TRUE;
+    CHK_STATUS(jitter_buffer_push(pJitterBuffer, pRtpPacket, &discarded));
+
+CleanUp:
+    if (!ownedByJitterBuffer) {
+        rtp_packet_free(&pRtpPacket);
+    }
+
+    return retStatus;
+}
+
+/**
+ * @brief split a red packet of the remote into the Opus packets of its blocks and push them into the jitter buffer.
+ *
+ *  The redundant blocks only fill the holes which lost packets left, the copies of packets which already arrived or were already
+ *  played out are dropped. The packet a redundant block repairs follows from its timestamp offset and the duration of the Opus packets,
+ *  the sender leaves out the blocks which do not fit so their position tells nothing.
+ *
+ * @param[in] pKvsPeerConnection the peer connection.
+ * @param[in] pTransceiver the transceiver the red packet is for.
+ * @param[in] pRedPacket the red packet, owned by this function.
+ * @param[in, out] pPacketsDiscarded the count of packets the jitter buffer discarded.
+ *
+ * @return STATUS status of execution
+ */
+static STATUS pc_pushRedPacket(PKvsPeerConnection pKvsPeerConnection, PKvsRtpTransceiver pTransceiver, PRtpPacket pRedPacket,
+                               PUINT64 pPacketsDiscarded)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PJitterBuffer pJitterBuffer = pTransceiver->pJitterBuffer;
+    PRedBlock blocks = NULL;
+    UINT32 i, blockCount = 0, packetLength, duration = 0, blockDuration, timestamp;
+    UINT16 sequenceNumber;
+    PRtpPacket pRtpPacket = NULL, pNeighbour;
+    PBYTE pRawPacket;
+    BOOL primary, discarded = FALSE;
+
+    CHK_STATUS(depayRedFromRtpPayload(pRedPacket->payload, pRedPacket->payloadLength, NULL, &blockCount));
+    if (blockCount > pTransceiver->redBlockCapacity) {
+        SAFE_MEMFREE(pTransceiver->pRedBlocks);
+        pTransceiver->redBlockCapacity = 0;
+        pTransceiver->pRedBlocks = (PRedBlock) MEMALLOC(blockCount * SIZEOF(RedBlock));
+        CHK(pTransceiver->pRedBlocks != NULL, STATUS_NOT_ENOUGH_MEMORY);
+        pTransceiver->redBlockCapacity = blockCount;
+    }
+    blocks = pTransceiver->pRedBlocks;
+    CHK_STATUS(depayRedFromRtpPayload(pRedPacket->payload, pRedPacket->payloadLength, blocks, &blockCount));
+    // The redundant blocks are placed by the duration of the primary one, they are only pushed if they last as long
+    if (blocks[blockCount - 1].payloadType != pTransceiver->sender.payloadType ||
+        STATUS_FAILED(getOpusPacketDuration(blocks[blockCount - 1].pData, blocks[blockCount - 1].length, &duration))) {
+        duration = 0;
+    }
+
+    for (i = 0; i < blockCount; i++) {
+        primary = (i == blockCount - 1);
+        if (blocks[i].payloadType != pTransceiver->sender.payloadType || blocks[i].length == 0) {
+            continue;
+        }
+        sequenceNumber = pRedPacket->header.sequenceNumber;
+        timestamp = pRedPacket->header.timestamp - blocks[i].timestampOffset;
+        if (!primary) {
+            // A block n packet durations before the primary one went out n packets before
+            if (duration == 0 || blocks[i].timestampOffset == 0 || blocks[i].timestampOffset % duration != 0 ||
+                STATUS_FAILED(getOpusPacketDuration(blocks[i].pData, blocks[i].length, &blockDuration)) || blockDuration != duration) {
+                continue;
+            }
+            sequenceNumber = GET_UINT16_SEQ_NUM(sequenceNumber - blocks[i].timestampOffset / duration);
+            if (!pJitterBuffer->started || (INT16) (sequenceNumber - pJitterBuffer->lastRemovedSequenceNumber) <= 0) {
+                continue;
+            }
+            if (jitter_buffer_getPacket(pJitterBuffer, sequenceNumber) != NULL) {
+                continue;
+            }
+            // The packets around the hole must agree with the timestamp of the block, the timestamps of a sender which went silent
+            // jump ahead of its sequence numbers
+            pNeighbour = jitter_buffer_getPacket(pJitterBuffer, GET_UINT16_SEQ_NUM(sequenceNumber - 1));
+            if (pNeighbour != NULL && pNeighbour->header.timestamp != timestamp - duration) {
+                continue;
+            }
+            pNeighbour = jitter_buffer_getPacket(pJitterBuffer, GET_UINT16_SEQ_NUM(sequenceNumber + 1));
+            if (pNeighbour != NULL && pNeighbour->header.timestamp != timestamp + duration) {
+                continue;
+            }
+        }
+
+        packetLength = MIN_HEADER_LENGTH + blocks[i].length;
+        CHK_STATUS(rtp_packet_pool_get(pKvsPeerConnection->pRtpPacketPool, packetLength, &pRtpPacket));
+        pRawPacket = pRtpPacket->pRawPacket;
+        // version 2, without padding, header extension and csrcs
+        pRawPacket[0] = 2 << VERSION_SHIFT;
+        pRawPacket[1] = (primary && pRedPacket->header.marker ? 1 << MARKER_SHIFT : 0) | blocks[i].payloadType;
+        putUnalignedInt16BigEndian(pRawPacket + SEQ_NUMBER_OFFSET, sequenceNumber);
+        putUnalignedInt32BigEndian(pRawPacket + TIMESTAMP_OFFSET, timestamp);
+        putUnalignedInt32BigEndian(pRawPacket + SSRC_OFFSET, pRedPacket->header.ssrc);
+        MEMCPY(pRawPacket + MIN_HEADER_LENGTH, blocks[i].pData, blocks[i].length);
+        pRtpPacket->rawPacketLength = packetLength;
+        CHK_STATUS(rtp_packet_setPacketFromBytes(pRawPacket, packetLength, pRtpPacket));
+        pRtpPacket->receivedTime = pRedPacket->receivedTime;
+
+        // the jitter buffer owns the packet even when the push fails
+        discarded = FALSE;
+        retStatus = jitter_buffer_push(pJitterBuffer, pRtpPacket, &discarded);
+        pRtpPacket = NULL;
+        CHK_STATUS(retStatus);
+        if (discarded) {
+            (*pPacketsDiscarded)++;
+        }
+    }
+
+CleanUp:
+    rtp_packet_free(&pRtpPacket);
+    rtp_packet_free(&pRedPacket);
+
+    return retStatus;
+}
+
 STATUS pc_sendPacketToRtpReceiver(PKvsPeerConnection pKvsPeerConnection, PBYTE pBuffer, UINT32 bufferLen)
 {
     PC_ENTER();
     STATUS retStatus = STATUS_SUCCESS;
     PDoubleListNode pCurNode = NULL;
     PKvsRtpTransceiver pTransceiver;
-    UINT64 item, now;
+    UINT64 item, now, roundTripTime;
     UINT32 ssrc;
+    UINT16 sequenceNumber = 0;
     PRtpPacket pRtpPacket = NULL;
-    PBYTE pPayload = NULL;
-    BOOL ownedByJitterBuffer = FALSE, discarded = FALSE;
+    RtpPacket rtpPacket;
+    BOOL ownedByJitterBuffer = FALSE, discarded = FALSE, counted = FALSE;
     UINT64 packetsReceived = 0, packetsFailedDecryption = 0, lastPacketReceivedTimestamp = 0, headerBytesReceived = 0, bytesReceived = 0,
            packetsDiscarded = 0;
     INT64 arrival, r_ts, transit, delta;
@@ -288,10 +596,20 @@ STATUS pc_sendPacketToRtpReceiver(PKvsPeerConnection pKvsPeerConnection, PBYTE p
                 CHK(FALSE, STATUS_SUCCESS);
             }
             now = GETTIME();
-            CHK(NULL != (pPayload = (PBYTE) MEMALLOC(bufferLen)), STATUS_PEER_CONN_NOT_ENOUGH_MEMORY);
-            MEMCPY(pPayload, pBuffer, bufferLen);
-            CHK_STATUS(rtp_packet_createFromBytes(pPayload, bufferLen, &pRtpPacket));
+            CHK_STATUS(rtp_packet_pool_get(pKvsPeerConnection->pRtpPacketPool, bufferLen, &pRtpPacket));
+            MEMCPY(pRtpPacket->pRawPacket, pBuffer, bufferLen);
+            pRtpPacket->rawPacketLength = bufferLen;
+            CHK_STATUS(rtp_packet_setPacketFromBytes(pRtpPacket->pRawPacket, bufferLen, pRtpPacket));
             pRtpPacket->receivedTime = now;
+            sequenceNumber = pRtpPacket->header.sequenceNumber;
+            counted = TRUE;
+            pc_onTwccPacketReceived(pKvsPeerConnection, pRtpPacket, now);
+            if (pTransceiver->pNackGenerator != NULL) {
+                CHK_LOG_ERR(nack_generator_onPacketReceived(pTransceiver->pNackGenerator, pRtpPacket->header.sequenceNumber, now));
+            }
+            if (pTransceiver->pFlexFecReceiver != NULL) {
+                CHK_LOG_ERR(flexfec_receiver_onMediaPacket(pTransceiver->pFlexFecReceiver, pRtpPacket->pRawPacket, bufferLen));
+            }
 
             // https://tools.ietf.org/html/rfc3550#section-6.4.1
             // https://tools.ietf.org/html/rfc3550#appendix-A.8
@@ -304,19 +622,48 @@ STATUS pc_sendPacketToRtpReceiver(PKvsPeerConnection pKvsPeerConnection, PBYTE p
             delta = transit - pTransceiver->pJitterBuffer->transit;
             pTransceiver->pJitterBuffer->transit = transit;
             pTransceiver->pJitterBuffer->jitter += (1. / 16.) * ((DOUBLE) ABS(delta) - pTransceiver->pJitterBuffer->jitter);
-            CHK_STATUS(jitter_buffer_push(pTransceiver->pJitterBuffer, pRtpPacket, &discarded));
-            if (discarded) {
-                packetsDiscarded++;
+            // A retransmission takes as long as the nacks measure, the round trip time of the selected pair stands in until then
+            roundTripTime = 0;
+            if (pTransceiver->pNackGenerator != NULL) {
+                CHK_LOG_ERR(nack_generator_getRoundTripTime(pTransceiver->pNackGenerator, &roundTripTime));
+            }
+            if (roundTripTime == 0) {
+                roundTripTime = (UINT64) ATOMIC_LOAD(&pKvsPeerConnection->roundTripTime);
             }
+            pTransceiver->pJitterBuffer->roundTripTime = roundTripTime;
+            // the jitter buffer may release the packet right away, so account for it before pushing
             lastPacketReceivedTimestamp = KVS_CONVERT_TIMESCALE(now, HUNDREDS_OF_NANOS_IN_A_SECOND, 1000);
             headerBytesReceived += RTP_HEADER_LEN(pRtpPacket);
             bytesReceived += pRtpPacket->rawPacketLength - RTP_HEADER_LEN(pRtpPacket);
             ownedByJitterBuffer = TRUE;
+            if (pKvsPeerConnection->redPayloadType != 0 && pRtpPacket->header.payloadType == pKvsPeerConnection->redPayloadType) {
+                CHK_STATUS(pc_pushRedPacket(pKvsPeerConnection, pTransceiver, pRtpPacket, &packetsDiscarded));
+                CHK(FALSE, STATUS_SUCCESS);
+            }
+            CHK_STATUS(jitter_buffer_push(pTransceiver->pJitterBuffer, pRtpPacket, &discarded));
+            if (discarded) {
+                packetsDiscarded++;
+            }
             CHK(FALSE, STATUS_SUCCESS);
         }
+        if (pTransceiver->pFlexFecReceiver != NULL && pTransceiver->remoteFecSsrc == ssrc) {
+            // the stats of the repair stream are the ones of the media stream it protects
+            retStatus = pc_onFlexFecPacket(pKvsPeerConnection, pTransceiver, pBuffer, bufferLen);
+            CHK(FALSE, retStatus);
+        }
+        if (pTransceiver->remoteRtxSsrc != 0 && pTransceiver->remoteRtxSsrc == ssrc) {
+            retStatus = pc_onRtxPacket(pKvsPeerConnection, pTransceiver, pBuffer, bufferLen);
+            CHK(FALSE, retStatus);
+        }
         pCurNode = pCurNode->pNext;
     }
 
+    // Probes of the remote bandwidth estimation carry the transport-wide sequence number too. They are authenticated like any other
+    // packet before their header extension is trusted
+    if (STATUS_SUCCEEDED(srtp_session_decryptSrtpPacket(pKvsPeerConnection->pSrtpSession, pBuffer, (PINT32) &bufferLen)) &&
+        STATUS_SUCCEEDED(rtp_packet_setPacketFromBytes(pBuffer, bufferLen, &rtpPacket))) {
+        pc_onTwccPacketReceived(pKvsPeerConnection, &rtpPacket, GETTIME());
+    }
     DLOGW("No transceiver to handle inbound ssrc %u", ssrc);
 
 CleanUp:
@@ -329,10 +676,14 @@ CleanUp:
         pTransceiver->inboundStats.bytesReceived += bytesReceived;
         pTransceiver->inboundStats.received.jitter = pTransceiver->pJitterBuffer->jitter / pTransceiver->pJitterBuffer->clockRate;
         pTransceiver->inboundStats.received.packetsDiscarded = packetsDiscarded;
+        // the receiver reports count what arrived on the stream, not what was repaired or retransmitted
+        if (counted) {
+            receive_statistics_onPacket(&pTransceiver->receiveStatistics, sequenceNumber);
+            pTransceiver->inboundStats.received.packetsLost = receive_statistics_getPacketsLost(&pTransceiver->receiveStatistics);
+        }
         MUTEX_UNLOCK(pTransceiver->statsLock);
     }
     if (!ownedByJitterBuffer) {
-        SAFE_MEMFREE(pPayload);
         rtp_packet_free(&pRtpPacket);
         CHK_LOG_ERR(retStatus);
     }
@@ -382,6 +733,63 @@ CleanUp:
 }
 
 #ifdef ENABLE_STREAMING
+/**
+ * @brief ask the remote peer for a key frame once the frames of a video receiver lost their references, with a picture loss indication
+ *        https://tools.ietf.org/html/rfc4585#section-6.3.1 or, if that is all the remote peer takes, a full intra request
+ *        https://tools.ietf.org/html/rfc5104#section-4.3.1
+ *        The requests are at least KvsRtcConfiguration.keyFrameRequestMinimumInterval apart and never closer than a round trip time, the
+ *        key frame cannot come any sooner.
+ *
+ * @param[in] pTransceiver the transceiver.
+ * @param[in] currentTime the current time.
+ *
+ * @return STATUS status of execution.
+ */
+static STATUS pc_requestKeyFrame(PKvsRtpTransceiver pTransceiver, UINT64 currentTime)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PKvsPeerConnection pKvsPeerConnection = pTransceiver->pKvsPeerConnection;
+    BOOL locked = FALSE, fir;
+    UINT64 interval;
+    UINT32 packetLen;
+    // srtp_protect_rtcp() in srtp_session_encryptRtcpPacket() writes the authentication tag and the srtcp trailer after the packet
+    BYTE rawPacket[RTCP_PACKET_FIR_LEN + SRTP_AUTH_TAG_OVERHEAD + SRTP_MAX_TRAILER_LEN + 4];
+
+    // The ice agent is gone once the jitter buffers flush while the peer connection is freed
+    CHK(pTransceiver->transceiver.receiver.track.kind == MEDIA_STREAM_TRACK_KIND_VIDEO && pKvsPeerConnection->pIceAgent != NULL, retStatus);
+    interval = MAX(pKvsPeerConnection->keyFrameRequestInterval, (UINT64) ATOMIC_LOAD(&pKvsPeerConnection->roundTripTime));
+    CHK(pTransceiver->lastKeyFrameRequestTime == 0 || currentTime - pTransceiver->lastKeyFrameRequestTime >= interval, retStatus);
+
+    // Like browsers, a pli unless the remote peer only takes firs
+    fir = pTransceiver->remoteAcceptsFir && !pTransceiver->remoteAcceptsPli;
+    CHK_STATUS(rtcp_packet_createKeyFrameRequest(fir, pTransceiver->sender.ssrc, pTransceiver->jitterBufferSsrc, &pTransceiver->firSequenceNumber,
+                                                 rawPacket, &packetLen));
+
+    MUTEX_LOCK(pKvsPeerConnection->pSrtpSessionLock);
+    locked = TRUE;
+    CHK(pKvsPeerConnection->pSrtpSession != NULL, retStatus);
+    CHK_STATUS(srtp_session_encryptRtcpPacket(pKvsPeerConnection->pSrtpSession, rawPacket, (PINT32) &packetLen));
+    MUTEX_UNLOCK(pKvsPeerConnection->pSrtpSessionLock);
+    locked = FALSE;
+
+    CHK_STATUS(ice_agent_send(pKvsPeerConnection->pIceAgent, rawPacket, packetLen));
+    pTransceiver->lastKeyFrameRequestTime = currentTime;
+    MUTEX_LOCK(pTransceiver->statsLock);
+    if (fir) {
+        pTransceiver->inboundStats.firCount++;
+    } else {
+        pTransceiver->inboundStats.pliCount++;
+    }
+    MUTEX_UNLOCK(pTransceiver->statsLock);
+
+CleanUp:
+    if (locked) {
+        MUTEX_UNLOCK(pKvsPeerConnection->pSrtpSessionLock);
+    }
+
+    return retStatus;
+}
+
 STATUS pc_onFrameReady(UINT64 customData, UINT16 startIndex, UINT16 endIndex, UINT32 frameSize)
 {
     PC_ENTER();
@@ -389,23 +797,27 @@ STATUS pc_onFrameReady(UINT64 customData, UINT16 startIndex, UINT16 endIndex, UI
     PKvsRtpTransceiver pTransceiver = (PKvsRtpTransceiver) customData;
     PRtpPacket pPacket = NULL;
     Frame frame;
-    UINT64 hashValue;
     UINT32 filledSize = 0, index;
 
     CHK(pTransceiver != NULL, STATUS_PEER_CONN_NULL_ARG);
 
-    // TODO: handle multi-packet frames
-    retStatus = hash_table_get(pTransceiver->pJitterBuffer->pPkgBufferHashTable, startIndex, &hashValue);
-    pPacket = (PRtpPacket) hashValue;
-    if (retStatus == STATUS_SUCCESS || retStatus == STATUS_HASH_KEY_NOT_PRESENT) {
-        retStatus = STATUS_SUCCESS;
-    } else {
-        CHK(FALSE, retStatus);
+    // A frame which does not follow on from the last one out of the jitter buffer may reference the ones skipped in between
+    if (pTransceiver->frameChainStarted && startIndex != pTransceiver->nextFrameStartIndex) {
+        CHK_LOG_ERR(pc_requestKeyFrame(pTransceiver, GETTIME()));
     }
+    pTransceiver->frameChainStarted = TRUE;
+    pTransceiver->nextFrameStartIndex = endIndex + 1;
+
+    // TODO: handle multi-packet frames
+    pPacket = jitter_buffer_getPacket(pTransceiver->pJitterBuffer, startIndex);
     CHK(pPacket != NULL, STATUS_PEER_CONN_NULL_ARG);
     MUTEX_LOCK(pTransceiver->statsLock);
     // https://www.w3.org/TR/webrtc-stats/#dom-rtcinboundrtpstreamstats-jitterbufferdelay
     pTransceiver->inboundStats.jitterBufferDelay += (DOUBLE) (GETTIME() - pPacket->receivedTime) / HUNDREDS_OF_NANOS_IN_A_SECOND;
+    // https://www.w3.org/TR/webrtc-stats/#dom-rtcinboundrtpstreamstats-jitterbuffertargetdelay
+    pTransceiver->inboundStats.jitterBufferTargetDelay +=
+        pTransceiver->pJitterBuffer->adaptive ? (DOUBLE) pTransceiver->pJitterBuffer->targetDelay / HUNDREDS_OF_NANOS_IN_A_SECOND : 0;
+    pTransceiver->inboundStats.jitterBufferMinimumDelay += (DOUBLE) pTransceiver->pJitterBuffer->minimumDelay / HUNDREDS_OF_NANOS_IN_A_SECOND;
     index = pTransceiver->inboundStats.jitterBufferEmittedCount;
     pTransceiver->inboundStats.jitterBufferEmittedCount++;
     if (MEDIA_STREAM_TRACK_KIND_VIDEO == pTransceiver->transceiver.receiver.track.kind) {
@@ -422,6 +834,10 @@ STATUS pc_onFrameReady(UINT64 customData, UINT16 startIndex, UINT16 endIndex, UI
 
     CHK_STATUS(jitter_buffer_fillFrameData(pTransceiver->pJitterBuffer, pTransceiver->peerFrameBuffer, frameSize, &filledSize, startIndex, endIndex));
     CHK(frameSize == filledSize, STATUS_INVALID_ARG_LEN);
+    if (pTransceiver->transceiver.receiver.track.codec == RTC_CODEC_AV1) {
+        // The fragments of an OBU can only be put back together once the whole temporal unit is there
+        CHK_STATUS(mergeAV1ObuFragments(pTransceiver->peerFrameBuffer, filledSize, &frameSize));
+    }
 
     frame.version = FRAME_CURRENT_VERSION;
     frame.decodingTs = pPacket->header.timestamp * HUNDREDS_OF_NANOS_IN_A_MILLISECOND;
@@ -444,28 +860,28 @@ CleanUp:
 STATUS pc_onFrameDrop(UINT64 customData, UINT16 startIndex, UINT16 endIndex, UINT32 timestamp)
 {
     PC_ENTER();
-    UNUSED_PARAM(endIndex);
     STATUS retStatus = STATUS_SUCCESS;
-    UINT64 hashValue = 0;
     PRtpPacket pPacket = NULL;
     PKvsRtpTransceiver pTransceiver = (PKvsRtpTransceiver) customData;
 
     DLOGW("Frame with timestamp %u is dropped!", timestamp);
     CHK(pTransceiver != NULL, STATUS_PEER_CONN_NULL_ARG);
 
-    retStatus = hash_table_get(pTransceiver->pJitterBuffer->pPkgBufferHashTable, startIndex, &hashValue);
-    pPacket = (PRtpPacket) hashValue;
-    if (retStatus == STATUS_SUCCESS || retStatus == STATUS_HASH_KEY_NOT_PRESENT) {
-        retStatus = STATUS_SUCCESS;
-    } else {
-        CHK(FALSE, retStatus);
-    }
+    // The frames which reference the dropped one cannot be decoded until the next key frame
+    CHK_LOG_ERR(pc_requestKeyFrame(pTransceiver, GETTIME()));
+    pTransceiver->frameChainStarted = TRUE;
+    pTransceiver->nextFrameStartIndex = endIndex + 1;
+
+    pPacket = jitter_buffer_getPacket(pTransceiver->pJitterBuffer, startIndex);
 
     // TODO: handle multi-packet frames
     CHK(pPacket != NULL, STATUS_PEER_CONN_NULL_ARG);
     MUTEX_LOCK(pTransceiver->statsLock);
     // https://www.w3.org/TR/webrtc-stats/#dom-rtcinboundrtpstreamstats-jitterbufferdelay
     pTransceiver->inboundStats.jitterBufferDelay += (DOUBLE) (GETTIME() - pPacket->receivedTime) / HUNDREDS_OF_NANOS_IN_A_SECOND;
+    pTransceiver->inboundStats.jitterBufferTargetDelay +=
+        pTransceiver->pJitterBuffer->adaptive ? (DOUBLE) pTransceiver->pJitterBuffer->targetDelay / HUNDREDS_OF_NANOS_IN_A_SECOND : 0;
+    pTransceiver->inboundStats.jitterBufferMinimumDelay += (DOUBLE) pTransceiver->pJitterBuffer->minimumDelay / HUNDREDS_OF_NANOS_IN_A_SECOND;
     pTransceiver->inboundStats.jitterBufferEmittedCount++;
     pTransceiver->inboundStats.received.framesDropped++;
     pTransceiver->inboundStats.received.fullFramesLost++;
@@ -527,6 +943,14 @@ static VOID pc_onIceAgentStateChange(UINT64 customData, UINT64 newIceAgentState)
     }
 
     if (startDtlsSession) {
+#ifdef ENABLE_STREAMING
+        // Every state from connected on comes with a selected pair, which may be another one than the srtp session started on
+        MUTEX_LOCK(pKvsPeerConnection->pSrtpSessionLock);
+        if (pKvsPeerConnection->pSrtpSession != NULL) {
+            pc_updatePathMtu(pKvsPeerConnection);
+        }
+        MUTEX_UNLOCK(pKvsPeerConnection->pSrtpSessionLock);
+#endif
         CHK_STATUS(dtls_session_isConnected(pKvsPeerConnection->pDtlsSession, &isDtlsConnected));
 
         if (isDtlsConnected) {
@@ -738,11 +1162,13 @@ CleanUp:
 //#TBD
 #ifdef ENABLE_STREAMING
 /**
- * @brief
+ * @brief send the sender report of every encoding the transceiver sends and the receiver report block of the stream it receives. The
+ *        block rides along with the first sender report as a compound packet, or goes out in a receiver report of its own while the
+ *        transceiver does not send. https://tools.ietf.org/html/rfc3550#section-6.4
  *
  * @param[in] timerId
  * @param[in] currentTime
- * @param[in] customData
+ * @param[in] customData the transceiver.
  *
  * @return STATUS status of execution.
  */
@@ -750,52 +1176,98 @@ STATUS pc_rtcpReportsCallback(UINT32 timerId, UINT64 currentTime, UINT64 customD
 {
     UNUSED_PARAM(timerId);
     STATUS retStatus = STATUS_SUCCESS;
-    BOOL ready = FALSE;
-    UINT64 ntpTime, rtpTime, delay;
-    UINT32 packetCount, octetCount, packetLen, allocSize, ssrc;
-    PBYTE rawPacket = NULL;
+    BOOL ready = FALSE, locked = FALSE;
+    UINT64 ntpTime, rtpTime, delay, rtt = 0;
+    UINT32 packetCount, octetCount, packetLen, ssrc, reportCount = 0, i;
+    // srtp_protect_rtcp() in srtp_session_encryptRtcpPacket() assumes memory availability to write 10 bytes of authentication tag and
+    // SRTP_MAX_TRAILER_LEN + 4 following the actual rtcp Packet payload
+    BYTE rawPacket[RTCP_PACKET_HEADER_LEN + RTCP_PACKET_SENDER_REPORT_MINLEN + RTCP_PACKET_RECEIVER_REPORT_BLOCK_LEN + SRTP_AUTH_TAG_OVERHEAD +
+                   SRTP_MAX_TRAILER_LEN + 4];
+    BYTE reportBlock[RTCP_PACKET_RECEIVER_REPORT_BLOCK_LEN];
     PKvsPeerConnection pKvsPeerConnection = NULL;
+    PRtcRtpSender pRtcRtpSender = NULL;
 
     PKvsRtpTransceiver pKvsRtpTransceiver = (PKvsRtpTransceiver) customData;
     CHK(pKvsRtpTransceiver != NULL && pKvsRtpTransceiver->pJitterBuffer != NULL && pKvsRtpTransceiver->pKvsPeerConnection != NULL,
         STATUS_PEER_CONN_NULL_ARG);
     pKvsPeerConnection = pKvsRtpTransceiver->pKvsPeerConnection;
 
+    // The jitter buffers of the receiving thread wait a round trip longer for a retransmission
+    if (STATUS_SUCCEEDED(ice_agent_getRoundTripTime(pKvsPeerConnection->pIceAgent, &rtt))) {
+        ATOMIC_STORE(&pKvsPeerConnection->roundTripTime, (SIZE_T) rtt);
+    }
+
     ssrc = pKvsRtpTransceiver->sender.ssrc;
     DLOGS("pc_rtcpReportsCallback %" PRIu64 " ssrc: %u rtxssrc: %u", currentTime, ssrc, pKvsRtpTransceiver->sender.rtxSsrc);
 
-    // check if ice agent is connected, reschedule in 200msec if not
-    ready = pKvsPeerConnection->pSrtpSession != NULL &&
-        (currentTime - pKvsRtpTransceiver->sender.firstFrameWallClockTime >= 2500 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
-    if (!ready) {
-        DLOGV("sender report no frames sent %u", ssrc);
-    } else {
+    // https://tools.ietf.org/html/rfc3550#section-6.4.2 the reception of the stream of the remote peer, once it has sent something
+    MUTEX_LOCK(pKvsRtpTransceiver->statsLock);
+    if (pKvsPeerConnection->pSrtpSession != NULL && pKvsRtpTransceiver->receiveStatistics.started &&
+        STATUS_SUCCEEDED(receive_statistics_createReportBlock(&pKvsRtpTransceiver->receiveStatistics, pKvsRtpTransceiver->jitterBufferSsrc,
+                                                              (UINT32) pKvsRtpTransceiver->pJitterBuffer->jitter, currentTime, reportBlock))) {
+        reportCount = 1;
+    }
+    MUTEX_UNLOCK(pKvsRtpTransceiver->statsLock);
+
+    // Every simulcast encoding is its own rtp stream with its own sender report
+    for (i = 0; i < rtp_transceiver_getEncodingCount(pKvsRtpTransceiver); i++) {
+        pRtcRtpSender = rtp_transceiver_getSender(pKvsRtpTransceiver, i);
+        // check if ice agent is connected, reschedule in 200msec if not
+        ready = pKvsPeerConnection->pSrtpSession != NULL && pRtcRtpSender->firstFrameWallClockTime != 0 &&
+            (currentTime - pRtcRtpSender->firstFrameWallClockTime >= 2500 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+        if (!ready) {
+            DLOGV("sender report no frames sent %u", pRtcRtpSender->ssrc);
+            continue;
+        }
+
         // create rtcp sender report packet
         // https://tools.ietf.org/html/rfc3550#section-6.4.1
         ntpTime = rtcp_packet_convertTimestampToNTP(currentTime);
-        rtpTime = pKvsRtpTransceiver->sender.rtpTimeOffset +
-            CONVERT_TIMESTAMP_TO_RTP(pKvsRtpTransceiver->pJitterBuffer->clockRate, currentTime - pKvsRtpTransceiver->sender.firstFrameWallClockTime);
+        rtpTime = pRtcRtpSender->rtpTimeOffset +
+            CONVERT_TIMESTAMP_TO_RTP(pKvsRtpTransceiver->pJitterBuffer->clockRate, currentTime - pRtcRtpSender->firstFrameWallClockTime);
         MUTEX_LOCK(pKvsRtpTransceiver->statsLock);
-        packetCount = pKvsRtpTransceiver->outboundStats.sent.packetsSent;
-        octetCount = pKvsRtpTransceiver->outboundStats.sent.bytesSent;
+        packetCount = pRtcRtpSender->packetCount;
+        octetCount = pRtcRtpSender->octetCount;
         MUTEX_UNLOCK(pKvsRtpTransceiver->statsLock);
-        DLOGV("sender report %u %" PRIu64 " %" PRIu64 " : %u packets %u bytes", ssrc, ntpTime, rtpTime, packetCount, octetCount);
-        packetLen = RTCP_PACKET_HEADER_LEN + 24;
-
-        // srtp_protect_rtcp() in srtp_session_encryptRtcpPacket() assumes memory availability to write 10 bytes of authentication tag and
-        // SRTP_MAX_TRAILER_LEN + 4 following the actual rtcp Packet payload
-        allocSize = packetLen + SRTP_AUTH_TAG_OVERHEAD + SRTP_MAX_TRAILER_LEN + 4;
-        CHK(NULL != (rawPacket = (PBYTE) MEMALLOC(allocSize)), STATUS_PEER_CONN_NOT_ENOUGH_MEMORY);
-        rawPacket[0] = RTCP_PACKET_VERSION_VAL << 6;
+        DLOGV("sender report %u %" PRIu64 " %" PRIu64 " : %u packets %u bytes", pRtcRtpSender->ssrc, ntpTime, rtpTime, packetCount, octetCount);
+        packetLen = RTCP_PACKET_HEADER_LEN + RTCP_PACKET_SENDER_REPORT_MINLEN + reportCount * RTCP_PACKET_RECEIVER_REPORT_BLOCK_LEN;
+
+        rawPacket[0] = (RTCP_PACKET_VERSION_VAL << 6) | reportCount;
         rawPacket[RTCP_PACKET_TYPE_OFFSET] = RTCP_PACKET_TYPE_SENDER_REPORT;
         putUnalignedInt16BigEndian(rawPacket + RTCP_PACKET_LEN_OFFSET,
                                    (packetLen / RTCP_PACKET_LEN_WORD_SIZE) - 1); // The length of this RTCP packet in 32-bit words minus one
-        putUnalignedInt32BigEndian(rawPacket + 4, ssrc);
+        putUnalignedInt32BigEndian(rawPacket + 4, pRtcRtpSender->ssrc);
         putUnalignedInt64BigEndian(rawPacket + 8, ntpTime);
         putUnalignedInt32BigEndian(rawPacket + 16, rtpTime);
         putUnalignedInt32BigEndian(rawPacket + 20, packetCount);
         putUnalignedInt32BigEndian(rawPacket + 24, octetCount);
+        MEMCPY(rawPacket + RTCP_PACKET_HEADER_LEN + RTCP_PACKET_SENDER_REPORT_MINLEN, reportBlock,
+               reportCount * RTCP_PACKET_RECEIVER_REPORT_BLOCK_LEN);
+        // the other encodings report on the same stream, once is enough
+        reportCount = 0;
+
+        MUTEX_LOCK(pKvsPeerConnection->pSrtpSessionLock);
+        locked = TRUE;
         CHK_STATUS(srtp_session_encryptRtcpPacket(pKvsPeerConnection->pSrtpSession, rawPacket, (PINT32) &packetLen));
+        MUTEX_UNLOCK(pKvsPeerConnection->pSrtpSessionLock);
+        locked = FALSE;
+        CHK_STATUS(ice_agent_send(pKvsPeerConnection->pIceAgent, rawPacket, packetLen));
+    }
+
+    // Nothing is sent, the block goes out in a receiver report from the ssrc of the sender
+    if (reportCount > 0) {
+        packetLen = RTCP_PACKET_HEADER_LEN + SIZEOF(UINT32) + RTCP_PACKET_RECEIVER_REPORT_BLOCK_LEN;
+        rawPacket[0] = (RTCP_PACKET_VERSION_VAL << 6) | reportCount;
+        rawPacket[RTCP_PACKET_TYPE_OFFSET] = RTCP_PACKET_TYPE_RECEIVER_REPORT;
+        putUnalignedInt16BigEndian(rawPacket + RTCP_PACKET_LEN_OFFSET, (packetLen / RTCP_PACKET_LEN_WORD_SIZE) - 1);
+        putUnalignedInt32BigEndian(rawPacket + 4, ssrc);
+        MEMCPY(rawPacket + RTCP_PACKET_HEADER_LEN + SIZEOF(UINT32), reportBlock, RTCP_PACKET_RECEIVER_REPORT_BLOCK_LEN);
+
+        MUTEX_LOCK(pKvsPeerConnection->pSrtpSessionLock);
+        locked = TRUE;
+        CHK_STATUS(srtp_session_encryptRtcpPacket(pKvsPeerConnection->pSrtpSession, rawPacket, (PINT32) &packetLen));
+        MUTEX_UNLOCK(pKvsPeerConnection->pSrtpSessionLock);
+        locked = FALSE;
         CHK_STATUS(ice_agent_send(pKvsPeerConnection->pIceAgent, rawPacket, packetLen));
     }
 
@@ -807,10 +1279,167 @@ STATUS pc_rtcpReportsCallback(UINT32 timerId, UINT64 currentTime, UINT64 customD
                                     &pKvsRtpTransceiver->rtcpReportsTimerId));
 
 CleanUp:
+    if (locked) {
+        MUTEX_UNLOCK(pKvsPeerConnection->pSrtpSessionLock);
+    }
+    CHK_LOG_ERR(retStatus);
+    return retStatus;
+}
+#endif
+
+#ifdef ENABLE_STREAMING
+static STATUS pc_sendPacedPackets(UINT64 customData, PBYTE* ppBuffers, PUINT32 pBufferLens, UINT32 count, PUINT32 pSentCount,
+                                  PUINT32 pDiscardedCount)
+{
+    PKvsPeerConnection pKvsPeerConnection = (PKvsPeerConnection) customData;
+
+    return ice_agent_sendBatch(pKvsPeerConnection->pIceAgent, ppBuffers, pBufferLens, count, pSentCount, pDiscardedCount);
+}
+
+/**
+ * @brief send the transport-wide congestion control feedback on the packets received since the last feedback.
+ *
+ * @param[in] timerId
+ * @param[in] currentTime
+ * @param[in] customData the peer connection.
+ *
+ * @return STATUS status of execution.
+ */
+static STATUS pc_twccFeedbackCallback(UINT32 timerId, UINT64 currentTime, UINT64 customData)
+{
+    UNUSED_PARAM(timerId);
+    UNUSED_PARAM(currentTime);
+    STATUS retStatus = STATUS_SUCCESS;
+    PKvsPeerConnection pKvsPeerConnection = (PKvsPeerConnection) customData;
+    BOOL locked = FALSE, more = TRUE;
+    UINT32 packetLen = 0;
+    // srtp_protect_rtcp() in srtp_session_encryptRtcpPacket() writes the authentication tag and the srtcp trailer after the packet
+    BYTE rawPacket[TWCC_FEEDBACK_MAX_LEN + SRTP_AUTH_TAG_OVERHEAD + SRTP_MAX_TRAILER_LEN + 4];
+
+    CHK(pKvsPeerConnection != NULL && pKvsPeerConnection->pTwccReceiver != NULL, STATUS_PEER_CONN_NULL_ARG);
+    CHK(pKvsPeerConnection->extensionMap.ids[RTP_EXTENSION_TWCC] != 0, retStatus);
+
+    while (more) {
+        CHK_STATUS(twcc_receiver_createFeedback(pKvsPeerConnection->pTwccReceiver, rawPacket, &packetLen, &more));
+        CHK(packetLen > 0, retStatus);
+
+        MUTEX_LOCK(pKvsPeerConnection->pSrtpSessionLock);
+        locked = TRUE;
+        CHK(pKvsPeerConnection->pSrtpSession != NULL, retStatus);
+        CHK_STATUS(srtp_session_encryptRtcpPacket(pKvsPeerConnection->pSrtpSession, rawPacket, (PINT32) &packetLen));
+        MUTEX_UNLOCK(pKvsPeerConnection->pSrtpSessionLock);
+        locked = FALSE;
+
+        CHK_STATUS(ice_agent_send(pKvsPeerConnection->pIceAgent, rawPacket, packetLen));
+    }
+
+CleanUp:
+    if (locked) {
+        MUTEX_UNLOCK(pKvsPeerConnection->pSrtpSessionLock);
+    }
     CHK_LOG_ERR(retStatus);
-    SAFE_MEMFREE(rawPacket);
     return retStatus;
 }
+
+/**
+ * @brief send the generic nack which is due for the packets a transceiver lost on the way in.
+ *
+ * @param[in] pKvsPeerConnection the peer connection.
+ * @param[in] pKvsRtpTransceiver the transceiver.
+ * @param[in] currentTime the current time.
+ * @param[in] roundTripTime the round trip time in 100ns, 0 if not measured yet.
+ *
+ * @return STATUS status of execution.
+ */
+static STATUS pc_sendNack(PKvsPeerConnection pKvsPeerConnection, PKvsRtpTransceiver pKvsRtpTransceiver, UINT64 currentTime, UINT64 roundTripTime)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    BOOL locked = FALSE;
+    UINT32 packetLen = 0;
+    // srtp_protect_rtcp() in srtp_session_encryptRtcpPacket() writes the authentication tag and the srtcp trailer after the packet
+    BYTE rawPacket[NACK_MAX_LEN + SRTP_AUTH_TAG_OVERHEAD + SRTP_MAX_TRAILER_LEN + 4];
+
+    CHK_STATUS(nack_generator_createNack(pKvsRtpTransceiver->pNackGenerator, currentTime, roundTripTime, rawPacket, &packetLen));
+    CHK(packetLen > 0, retStatus);
+
+    MUTEX_LOCK(pKvsPeerConnection->pSrtpSessionLock);
+    locked = TRUE;
+    CHK(pKvsPeerConnection->pSrtpSession != NULL, STATUS_INVALID_OPERATION);
+    CHK_STATUS(srtp_session_encryptRtcpPacket(pKvsPeerConnection->pSrtpSession, rawPacket, (PINT32) &packetLen));
+    MUTEX_UNLOCK(pKvsPeerConnection->pSrtpSessionLock);
+    locked = FALSE;
+
+    CHK_STATUS(ice_agent_send(pKvsPeerConnection->pIceAgent, rawPacket, packetLen));
+    MUTEX_LOCK(pKvsRtpTransceiver->statsLock);
+    pKvsRtpTransceiver->inboundStats.nackCount++;
+    MUTEX_UNLOCK(pKvsRtpTransceiver->statsLock);
+
+CleanUp:
+    if (locked) {
+        MUTEX_UNLOCK(pKvsPeerConnection->pSrtpSessionLock);
+    }
+
+    return retStatus;
+}
+
+STATUS pc_nackCallback(UINT32 timerId, UINT64 currentTime, UINT64 customData)
+{
+    UNUSED_PARAM(timerId);
+    STATUS retStatus = STATUS_SUCCESS;
+    PKvsPeerConnection pKvsPeerConnection = (PKvsPeerConnection) customData;
+    PDoubleListNode pCurNode = NULL;
+    PKvsRtpTransceiver pKvsRtpTransceiver;
+    UINT64 item, roundTripTime;
+    BOOL ready = FALSE;
+
+    CHK(pKvsPeerConnection != NULL, STATUS_PEER_CONN_NULL_ARG);
+    roundTripTime = ATOMIC_LOAD(&pKvsPeerConnection->roundTripTime);
+
+    // Building a nack uses up a retry of every packet in it, so none is built before it can be encrypted and sent
+    MUTEX_LOCK(pKvsPeerConnection->pSrtpSessionLock);
+    ready = pKvsPeerConnection->pSrtpSession != NULL;
+    MUTEX_UNLOCK(pKvsPeerConnection->pSrtpSessionLock);
+    CHK(ready, retStatus);
+    CHK_STATUS(ice_agent_isReadyToSend(pKvsPeerConnection->pIceAgent, &ready));
+    CHK(ready, retStatus);
+
+    CHK_STATUS(double_list_getHeadNode(pKvsPeerConnection->pTransceivers, &pCurNode));
+    while (pCurNode != NULL) {
+        CHK_STATUS(double_list_getNodeData(pCurNode, &item));
+        pCurNode = pCurNode->pNext;
+        pKvsRtpTransceiver = (PKvsRtpTransceiver) item;
+        if (pKvsRtpTransceiver->pNackGenerator == NULL) {
+            continue;
+        }
+        // A transceiver failing to send its nack does not hold back the others
+        CHK_LOG_ERR(pc_sendNack(pKvsPeerConnection, pKvsRtpTransceiver, currentTime, roundTripTime));
+    }
+
+CleanUp:
+    CHK_LOG_ERR(retStatus);
+    return retStatus;
+}
+
+static VOID pc_onTwccTargetBitrate(UINT64 customData, UINT64 targetBitrate)
+{
+    PKvsPeerConnection pKvsPeerConnection = (PKvsPeerConnection) customData;
+    RtcOnTargetBitrate onTargetBitrate = NULL;
+    UINT64 onTargetBitrateCustomData = 0;
+
+    DLOGV("sender side target bitrate %" PRIu64 " bps", targetBitrate);
+    if (pKvsPeerConnection->pPacer != NULL) {
+        CHK_LOG_ERR(pacer_setTargetBitrate(pKvsPeerConnection->pPacer, targetBitrate));
+    }
+
+    MUTEX_LOCK(pKvsPeerConnection->peerConnectionObjLock);
+    onTargetBitrate = pKvsPeerConnection->onTargetBitrate;
+    onTargetBitrateCustomData = pKvsPeerConnection->onTargetBitrateCustomData;
+    MUTEX_UNLOCK(pKvsPeerConnection->peerConnectionObjLock);
+
+    if (onTargetBitrate != NULL) {
+        onTargetBitrate(onTargetBitrateCustomData, targetBitrate);
+    }
+}
 #endif
 
 STATUS pc_create(PRtcConfiguration pConfiguration, PRtcPeerConnection* ppPeerConnection)
@@ -856,6 +1485,34 @@ STATUS pc_create(PRtcConfiguration pConfiguration, PRtcPeerConnection* ppPeerCon
     pKvsPeerConnection->MTU = pConfiguration->kvsRtcConfiguration.maximumTransmissionUnit == 0
         ? DEFAULT_MTU_SIZE
         : pConfiguration->kvsRtcConfiguration.maximumTransmissionUnit;
+    pKvsPeerConnection->configuredMtu = pKvsPeerConnection->MTU;
+#ifdef ENABLE_STREAMING
+    CHK_STATUS(rtp_packet_pool_create(pConfiguration->kvsRtcConfiguration.rtpPacketPoolSize == 0
+                                          ? DEFAULT_RTP_PACKET_POOL_SIZE
+                                          : pConfiguration->kvsRtcConfiguration.rtpPacketPoolSize,
+                                      RTP_PACKET_SLOT_SIZE(pConfiguration->kvsRtcConfiguration.enablePathMtuDiscovery
+                                                               ? MAX(pKvsPeerConnection->MTU, PATH_MTU_MAX_PAYLOAD)
+                                                               : pKvsPeerConnection->MTU),
+                                      &pKvsPeerConnection->pRtpPacketPool));
+    pKvsPeerConnection->frameQueueSize = pConfiguration->kvsRtcConfiguration.frameQueueSize;
+    pKvsPeerConnection->frameQueueDropPolicy = pConfiguration->kvsRtcConfiguration.frameQueueDropPolicy;
+    pKvsPeerConnection->enableFlexFec = pConfiguration->kvsRtcConfiguration.enableFlexFec;
+    pKvsPeerConnection->maxFecProtectionPercentage = pConfiguration->kvsRtcConfiguration.maxFecProtectionPercentage == 0
+        ? DEFAULT_FLEXFEC_MAX_PROTECTION_PERCENTAGE
+        : MIN(pConfiguration->kvsRtcConfiguration.maxFecProtectionPercentage, 100);
+    pKvsPeerConnection->opusRedundancy = MIN(pConfiguration->kvsRtcConfiguration.opusRedundancy, RED_MAX_REDUNDANCY);
+    if (pConfiguration->kvsRtcConfiguration.enableGopCache) {
+        pKvsPeerConnection->gopCacheSize = pConfiguration->kvsRtcConfiguration.maxGopCacheSize == 0
+            ? DEFAULT_GOP_CACHE_MAX_SIZE
+            : pConfiguration->kvsRtcConfiguration.maxGopCacheSize;
+    }
+    pKvsPeerConnection->enableAdaptiveJitterBuffer = pConfiguration->kvsRtcConfiguration.enableAdaptiveJitterBuffer;
+    pKvsPeerConnection->jitterBufferMinimumDelay =
+        (UINT64) pConfiguration->kvsRtcConfiguration.jitterBufferMinimumDelay * HUNDREDS_OF_NANOS_IN_A_MILLISECOND;
+    pKvsPeerConnection->keyFrameRequestInterval = pConfiguration->kvsRtcConfiguration.keyFrameRequestMinimumInterval == 0
+        ? DEFAULT_KEY_FRAME_REQUEST_MIN_INTERVAL
+        : (UINT64) pConfiguration->kvsRtcConfiguration.keyFrameRequestMinimumInterval * HUNDREDS_OF_NANOS_IN_A_MILLISECOND;
+#endif
     pKvsPeerConnection->sctpIsEnabled = FALSE;
 
     iceAgentCallbacks.customData = (UINT64) pKvsPeerConnection;
@@ -867,6 +1524,26 @@ STATUS pc_create(PRtcConfiguration pConfiguration, PRtcPeerConnection* ppPeerCon
     CHK_STATUS(ice_agent_create(pKvsPeerConnection->localIceUfrag, pKvsPeerConnection->localIcePwd, &iceAgentCallbacks, pConfiguration,
                                 pKvsPeerConnection->timerQueueHandle, pConnectionListener, &pKvsPeerConnection->pIceAgent));
 
+#ifdef ENABLE_STREAMING
+    if (pConfiguration->kvsRtcConfiguration.enablePacer) {
+        CHK_STATUS(pacer_create(DEFAULT_PACER_QUEUE_SIZE,
+                                pConfiguration->kvsRtcConfiguration.pacingMultiplier > 0 ? pConfiguration->kvsRtcConfiguration.pacingMultiplier
+                                                                                         : DEFAULT_PACING_MULTIPLIER,
+                                pKvsPeerConnection->timerQueueHandle, pc_sendPacedPackets, rtp_onPacedPacketSent, (UINT64) pKvsPeerConnection,
+                                &pKvsPeerConnection->pPacer));
+    }
+    if (!pConfiguration->kvsRtcConfiguration.disableSenderSideBandwidthEstimation) {
+        CHK_STATUS(twcc_manager_create(pc_onTwccTargetBitrate, (UINT64) pKvsPeerConnection, &pKvsPeerConnection->pTwccManager));
+    }
+    pKvsPeerConnection->nackTimerId = MAX_UINT32;
+    if (!pConfiguration->kvsRtcConfiguration.disableTwccFeedback) {
+        CHK_STATUS(twcc_receiver_create(&pKvsPeerConnection->pTwccReceiver));
+        // the timer queue is shut down before the receiver is freed
+        CHK_STATUS(timer_queue_addTimer(pKvsPeerConnection->timerQueueHandle, TWCC_FEEDBACK_INTERVAL, TWCC_FEEDBACK_INTERVAL, pc_twccFeedbackCallback,
+                                        (UINT64) pKvsPeerConnection, &pKvsPeerConnection->twccFeedbackTimerId));
+    }
+#endif
+
     NULLABLE_SET_EMPTY(pKvsPeerConnection->canTrickleIce);
 
     *ppPeerConnection = (PRtcPeerConnection) pKvsPeerConnection;
@@ -903,6 +1580,16 @@ STATUS pc_free(PRtcPeerConnection* ppPeerConnection)
 
     CHK(pKvsPeerConnection != NULL, retStatus);
 
+#ifdef ENABLE_STREAMING
+    // Stop the frame queue workers before anything they write through goes away
+    CHK_LOG_ERR(double_list_getHeadNode(pKvsPeerConnection->pTransceivers, &pCurNode));
+    while (pCurNode != NULL) {
+        CHK_LOG_ERR(double_list_getNodeData(pCurNode, &item));
+        CHK_LOG_ERR(frame_queue_free(&((PKvsRtpTransceiver) item)->pFrameQueue));
+        pCurNode = pCurNode->pNext;
+    }
+#endif
+
     /* Shutdown IceAgent first so there is no more incoming packets which can cause
      * SCTP to be allocated again after SCTP is freed. */
     CHK_LOG_ERR(ice_agent_shutdown(pKvsPeerConnection->pIceAgent));
@@ -918,6 +1605,10 @@ STATUS pc_free(PRtcPeerConnection* ppPeerConnection)
     CHK_LOG_ERR(ice_agent_free(&pKvsPeerConnection->pIceAgent));
 
 #ifdef ENABLE_STREAMING
+    // the queued packets go back to the pool and their stats to the transceivers, both are still alive here
+    CHK_LOG_ERR(pacer_free(&pKvsPeerConnection->pPacer));
+    CHK_LOG_ERR(twcc_manager_free(&pKvsPeerConnection->pTwccManager));
+    CHK_LOG_ERR(twcc_receiver_free(&pKvsPeerConnection->pTwccReceiver));
     // free transceivers
     CHK_LOG_ERR(double_list_getHeadNode(pKvsPeerConnection->pTransceivers, &pCurNode));
     while (pCurNode != NULL) {
@@ -948,6 +1639,8 @@ STATUS pc_free(PRtcPeerConnection* ppPeerConnection)
         MUTEX_FREE(pKvsPeerConnection->pSrtpSessionLock);
         pKvsPeerConnection->pSrtpSessionLock = INVALID_MUTEX_VALUE;
     }
+    // every pooled packet went back to the pool along with the transceivers
+    CHK_LOG_ERR(rtp_packet_pool_free(&pKvsPeerConnection->pRtpPacketPool));
 #endif
 
     if (IS_VALID_MUTEX_VALUE(pKvsPeerConnection->peerConnectionObjLock)) {
@@ -1043,6 +1736,31 @@ CleanUp:
     return retStatus;
 }
 
+STATUS pc_onTargetBitrate(PRtcPeerConnection pRtcPeerConnection, UINT64 customData, RtcOnTargetBitrate rtcOnTargetBitrate)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PKvsPeerConnection pKvsPeerConnection = (PKvsPeerConnection) pRtcPeerConnection;
+    BOOL locked = FALSE;
+
+    CHK(pKvsPeerConnection != NULL && rtcOnTargetBitrate != NULL, STATUS_PEER_CONN_NULL_ARG);
+
+    MUTEX_LOCK(pKvsPeerConnection->peerConnectionObjLock);
+    locked = TRUE;
+
+    pKvsPeerConnection->onTargetBitrate = rtcOnTargetBitrate;
+    pKvsPeerConnection->onTargetBitrateCustomData = customData;
+
+CleanUp:
+
+    if (locked) {
+        MUTEX_UNLOCK(pKvsPeerConnection->peerConnectionObjLock);
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
 STATUS pc_getLocalDescription(PRtcPeerConnection pRtcPeerConnection, PRtcSessionDescriptionInit pRtcSessionDescriptionInit)
 {
     ENTERS();
@@ -1116,12 +1834,154 @@ CleanUp:
     return retStatus;
 }
 
+#ifdef ENABLE_STREAMING
+/**
+ * @brief create the flexfec encoders and receivers of the video transceivers once the remote description negotiated flexfec.
+ *
+ * @param[in] pKvsPeerConnection the peer connection.
+ *
+ * @return STATUS status of execution
+ */
+static STATUS pc_setupFlexFec(PKvsPeerConnection pKvsPeerConnection)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PDoubleListNode pCurNode = NULL;
+    PKvsRtpTransceiver pKvsRtpTransceiver;
+    UINT64 data;
+
+    CHK(pKvsPeerConnection->flexFecPayloadType != 0, retStatus);
+
+    CHK_STATUS(double_list_getHeadNode(pKvsPeerConnection->pTransceivers, &pCurNode));
+    while (pCurNode != NULL) {
+        CHK_STATUS(double_list_getNodeData(pCurNode, &data));
+        pCurNode = pCurNode->pNext;
+        pKvsRtpTransceiver = (PKvsRtpTransceiver) data;
+        if (pKvsRtpTransceiver->sender.track.kind != MEDIA_STREAM_TRACK_KIND_VIDEO) {
+            continue;
+        }
+        if (pKvsRtpTransceiver->sender.pFlexFecEncoder == NULL) {
+            CHK_STATUS(flexfec_encoder_create(pKvsRtpTransceiver->sender.fecSsrc, pKvsRtpTransceiver->sender.ssrc,
+                                              pKvsPeerConnection->maxFecProtectionPercentage, &pKvsRtpTransceiver->sender.pFlexFecEncoder));
+        }
+        if (pKvsRtpTransceiver->pFlexFecReceiver == NULL && pKvsRtpTransceiver->remoteFecSsrc != 0) {
+            CHK_STATUS(flexfec_receiver_create(pKvsRtpTransceiver->jitterBufferSsrc, &pKvsRtpTransceiver->pFlexFecReceiver));
+        }
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * @brief create the nack generators of the receiving transceivers whose media section takes nacks, the jitter buffers then wait a
+ *        round trip longer for a lost packet.
+ *
+ * @param[in] pKvsPeerConnection the peer connection.
+ *
+ * @return STATUS status of execution
+ */
+static STATUS pc_setupNack(PKvsPeerConnection pKvsPeerConnection)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PDoubleListNode pCurNode = NULL;
+    PKvsRtpTransceiver pKvsRtpTransceiver;
+    UINT64 data;
+
+    CHK_STATUS(double_list_getHeadNode(pKvsPeerConnection->pTransceivers, &pCurNode));
+    while (pCurNode != NULL) {
+        CHK_STATUS(double_list_getNodeData(pCurNode, &data));
+        pCurNode = pCurNode->pNext;
+        pKvsRtpTransceiver = (PKvsRtpTransceiver) data;
+        if (pKvsRtpTransceiver->pNackGenerator != NULL || !pKvsRtpTransceiver->remoteAcceptsNack || pKvsRtpTransceiver->jitterBufferSsrc == 0 ||
+            pKvsRtpTransceiver->transceiver.direction == RTC_RTP_TRANSCEIVER_DIRECTION_SENDONLY ||
+            pKvsRtpTransceiver->transceiver.direction == RTC_RTP_TRANSCEIVER_DIRECTION_INACTIVE) {
+            continue;
+        }
+        CHK_STATUS(
+            nack_generator_create(pKvsRtpTransceiver->sender.ssrc, pKvsRtpTransceiver->jitterBufferSsrc, &pKvsRtpTransceiver->pNackGenerator));
+        pKvsRtpTransceiver->pJitterBuffer->nackEnabled = TRUE;
+        if (pKvsPeerConnection->nackTimerId == MAX_UINT32) {
+            // the timer queue is shut down before the transceivers are freed
+            CHK_STATUS(timer_queue_addTimer(pKvsPeerConnection->timerQueueHandle, NACK_INTERVAL, NACK_INTERVAL, pc_nackCallback,
+                                            (UINT64) pKvsPeerConnection, &pKvsPeerConnection->nackTimerId));
+        }
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * @brief create the red encoders of the Opus transceivers once the remote description negotiated red.
+ *
+ * @param[in] pKvsPeerConnection the peer connection.
+ *
+ * @return STATUS status of execution
+ */
+static STATUS pc_setupRed(PKvsPeerConnection pKvsPeerConnection)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PDoubleListNode pCurNode = NULL;
+    PKvsRtpTransceiver pKvsRtpTransceiver;
+    UINT64 data;
+
+    CHK(pKvsPeerConnection->redPayloadType != 0, retStatus);
+
+    CHK_STATUS(double_list_getHeadNode(pKvsPeerConnection->pTransceivers, &pCurNode));
+    while (pCurNode != NULL) {
+        CHK_STATUS(double_list_getNodeData(pCurNode, &data));
+        pCurNode = pCurNode->pNext;
+        pKvsRtpTransceiver = (PKvsRtpTransceiver) data;
+        if (pKvsRtpTransceiver->sender.track.codec == RTC_CODEC_OPUS && pKvsRtpTransceiver->sender.pRedEncoder == NULL) {
+            CHK_STATUS(red_encoder_create(pKvsRtpTransceiver->sender.payloadType, pKvsPeerConnection->opusRedundancy,
+                                          &pKvsRtpTransceiver->sender.pRedEncoder));
+        }
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * @brief lay out the header extensions of the sending transceivers again, whenever the negotiated ids or the simulcast encodings may have
+ *        changed.
+ *
+ * @param[in] pKvsPeerConnection the peer connection.
+ *
+ * @return STATUS status of execution
+ */
+static STATUS pc_updateExtensionLayouts(PKvsPeerConnection pKvsPeerConnection)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PDoubleListNode pCurNode = NULL;
+    UINT64 data;
+
+    CHK_STATUS(double_list_getHeadNode(pKvsPeerConnection->pTransceivers, &pCurNode));
+    while (pCurNode != NULL) {
+        CHK_STATUS(double_list_getNodeData(pCurNode, &data));
+        pCurNode = pCurNode->pNext;
+        CHK_STATUS(rtp_transceiver_updateExtensionLayouts((PKvsRtpTransceiver) data));
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+#endif
+
 STATUS pc_setRemoteDescription(PRtcPeerConnection pPeerConnection, PRtcSessionDescriptionInit pSessionDescriptionInit)
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
     PCHAR remoteIceUfrag = NULL, remoteIcePwd = NULL;
     UINT32 i, j;
+#ifdef ENABLE_STREAMING
+    UINT8 extId;
+    UINT64 opusPayloadType;
+#endif
 
     CHK(pPeerConnection != NULL, STATUS_PEER_CONN_NULL_ARG);
     PKvsPeerConnection pKvsPeerConnection = (PKvsPeerConnection) pPeerConnection;
@@ -1201,8 +2061,38 @@ STATUS pc_setRemoteDescription(PRtcPeerConnection pPeerConnection, PRtcSessionDe
     if (!pKvsPeerConnection->isOffer) {
         CHK_STATUS(sdp_setPayloadTypesFromOffer(pKvsPeerConnection->pCodecTable, pKvsPeerConnection->pRtxTable, pSessionDescription));
     }
-    CHK_STATUS(sdp_setTransceiverPayloadTypes(pKvsPeerConnection->pCodecTable, pKvsPeerConnection->pRtxTable, pKvsPeerConnection->pTransceivers));
+    CHK_STATUS(sdp_setTransceiverPayloadTypes(pKvsPeerConnection->pCodecTable, pKvsPeerConnection->pRtxTable, pKvsPeerConnection->pRtpPacketPool,
+                                              pKvsPeerConnection->pTransceivers));
     CHK_STATUS(sdp_setReceiversSsrc(pSessionDescription, pKvsPeerConnection->pTransceivers));
+    // Every media section shares the transport, so one id covers them all
+    rtp_extension_map_reset(&pKvsPeerConnection->extensionMap);
+    for (i = 0; i < RTP_EXTENSION_COUNT; i++) {
+        for (j = 0, extId = 0; j < pSessionDescription->mediaCount && extId == 0; j++) {
+            extId = sdp_getExtmapId(&pSessionDescription->mediaDescriptions[j], rtp_extension_getUri((RTP_EXTENSION) i));
+        }
+        CHK_STATUS(rtp_extension_map_set(&pKvsPeerConnection->extensionMap, (RTP_EXTENSION) i, extId));
+    }
+    if (pKvsPeerConnection->pTwccManager == NULL && pKvsPeerConnection->pTwccReceiver == NULL) {
+        CHK_STATUS(rtp_extension_map_set(&pKvsPeerConnection->extensionMap, RTP_EXTENSION_TWCC, 0));
+    }
+    if (pKvsPeerConnection->isOffer) {
+        CHK_STATUS(sdp_setTransceiversSimulcast(pKvsPeerConnection, pSessionDescription));
+    }
+    pKvsPeerConnection->flexFecPayloadType = 0;
+    for (i = 0; pKvsPeerConnection->enableFlexFec && i < pSessionDescription->mediaCount && pKvsPeerConnection->flexFecPayloadType == 0; i++) {
+        pKvsPeerConnection->flexFecPayloadType = sdp_getFlexFecPayloadType(&pSessionDescription->mediaDescriptions[i]);
+    }
+    CHK_STATUS(pc_setupFlexFec(pKvsPeerConnection));
+    CHK_STATUS(pc_setupNack(pKvsPeerConnection));
+    pKvsPeerConnection->redPayloadType = 0;
+    if (pKvsPeerConnection->opusRedundancy != 0 &&
+        STATUS_SUCCEEDED(hash_table_get(pKvsPeerConnection->pCodecTable, RTC_CODEC_OPUS, &opusPayloadType))) {
+        for (i = 0; i < pSessionDescription->mediaCount && pKvsPeerConnection->redPayloadType == 0; i++) {
+            pKvsPeerConnection->redPayloadType = sdp_getRedPayloadType(&pSessionDescription->mediaDescriptions[i], opusPayloadType);
+        }
+    }
+    CHK_STATUS(pc_setupRed(pKvsPeerConnection));
+    CHK_STATUS(pc_updateExtensionLayouts(pKvsPeerConnection));
 #endif
 #ifdef KVSWEBRTC_HAVE_GETENV
     if (NULL != GETENV(DEBUG_LOG_SDP)) {
@@ -1236,6 +2126,26 @@ STATUS pc_createOffer(PRtcPeerConnection pPeerConnection, PRtcSessionDescription
 #endif
 #ifdef ENABLE_STREAMING
     CHK_STATUS(sdp_setPayloadTypesForOffer(pKvsPeerConnection->pCodecTable));
+    if ((pKvsPeerConnection->pTwccManager != NULL || pKvsPeerConnection->pTwccReceiver != NULL) &&
+        pKvsPeerConnection->extensionMap.ids[RTP_EXTENSION_TWCC] == 0) {
+        CHK_STATUS(rtp_extension_map_set(&pKvsPeerConnection->extensionMap, RTP_EXTENSION_TWCC, DEFAULT_TWCC_EXT_ID));
+    }
+    // Only offered along with simulcast encodings
+    if (pKvsPeerConnection->extensionMap.ids[RTP_EXTENSION_MID] == 0) {
+        CHK_STATUS(rtp_extension_map_set(&pKvsPeerConnection->extensionMap, RTP_EXTENSION_MID, DEFAULT_MID_EXT_ID));
+    }
+    if (pKvsPeerConnection->extensionMap.ids[RTP_EXTENSION_RID] == 0) {
+        CHK_STATUS(rtp_extension_map_set(&pKvsPeerConnection->extensionMap, RTP_EXTENSION_RID, DEFAULT_RID_EXT_ID));
+    }
+    if (pKvsPeerConnection->extensionMap.ids[RTP_EXTENSION_RRID] == 0) {
+        CHK_STATUS(rtp_extension_map_set(&pKvsPeerConnection->extensionMap, RTP_EXTENSION_RRID, DEFAULT_RRID_EXT_ID));
+    }
+    if (pKvsPeerConnection->enableFlexFec && pKvsPeerConnection->flexFecPayloadType == 0) {
+        pKvsPeerConnection->flexFecPayloadType = DEFAULT_PAYLOAD_FLEXFEC;
+    }
+    if (pKvsPeerConnection->opusRedundancy != 0 && pKvsPeerConnection->redPayloadType == 0) {
+        pKvsPeerConnection->redPayloadType = DEFAULT_PAYLOAD_RED;
+    }
 #endif
 
     CHK_STATUS(sdp_populateSessionDescription(pKvsPeerConnection, &(pKvsPeerConnection->remoteSessionDescription), pSessionDescription));
@@ -1282,6 +2192,10 @@ STATUS pc_setLocalDescription(PRtcPeerConnection pPeerConnection, PRtcSessionDes
     CHK(pKvsPeerConnection != NULL && pSessionDescriptionInit != NULL, STATUS_PEER_CONN_NULL_ARG);
 
     CHK_STATUS(ice_agent_gather(pKvsPeerConnection->pIceAgent));
+#ifdef ENABLE_STREAMING
+    // The answerer only knows the mids and the simulcast encodings once its answer is created
+    CHK_STATUS(pc_updateExtensionLayouts(pKvsPeerConnection));
+#endif
 #ifdef KVSWEBRTC_HAVE_GETENV
     if (NULL != GETENV(DEBUG_LOG_SDP)) {
         DLOGD("LOCAL_SDP:%s", pSessionDescriptionInit->sdp);
@@ -1331,11 +2245,21 @@ STATUS pc_addTransceiver(PRtcPeerConnection pPeerConnection, PRtcMediaStreamTrac
             clockRate = VIDEO_CLOCKRATE;
             break;
 
+        case RTC_CODEC_H265:
+            depayFunc = depayH265FromRtpPayload;
+            clockRate = VIDEO_CLOCKRATE;
+            break;
+
         case RTC_CODEC_VP8:
             depayFunc = depayVP8FromRtpPayload;
             clockRate = VIDEO_CLOCKRATE;
             break;
 
+        case RTC_CODEC_AV1:
+            depayFunc = depayAV1FromRtpPayload;
+            clockRate = VIDEO_CLOCKRATE;
+            break;
+
         default:
             CHK(FALSE, STATUS_NOT_IMPLEMENTED);
     }
@@ -1345,7 +2269,23 @@ STATUS pc_addTransceiver(PRtcPeerConnection pPeerConnection, PRtcMediaStreamTrac
                                      &pKvsRtpTransceiver));
     CHK_STATUS(jitter_buffer_create(pc_onFrameReady, pc_onFrameDrop, depayFunc, DEFAULT_JITTER_BUFFER_MAX_LATENCY, clockRate,
                                     (UINT64) pKvsRtpTransceiver, &pJitterBuffer));
+    if (pKvsPeerConnection->enableAdaptiveJitterBuffer) {
+        CHK_STATUS(jitter_buffer_enableAdaptiveDelay(pJitterBuffer, pKvsPeerConnection->jitterBufferMinimumDelay));
+    }
     CHK_STATUS(rtp_transceiver_setJitterBuffer(pKvsRtpTransceiver, pJitterBuffer));
+    if (direction == RTC_RTP_TRANSCEIVER_DIRECTION_SENDRECV || direction == RTC_RTP_TRANSCEIVER_DIRECTION_RECVONLY) {
+        CHK_STATUS(rtp_packet_pool_reserve(pKvsPeerConnection->pRtpPacketPool,
+                                           (UINT32) JITTER_BUFFER_EXPECTED_PACKET_COUNT(DEFAULT_JITTER_BUFFER_MAX_LATENCY)));
+    }
+    if (pKvsPeerConnection->frameQueueSize != 0 && direction != RTC_RTP_TRANSCEIVER_DIRECTION_RECVONLY &&
+        direction != RTC_RTP_TRANSCEIVER_DIRECTION_INACTIVE) {
+        CHK_STATUS(
+            rtp_transceiver_createFrameQueue(pKvsRtpTransceiver, pKvsPeerConnection->frameQueueSize, pKvsPeerConnection->frameQueueDropPolicy));
+    }
+    if (pKvsPeerConnection->gopCacheSize != 0 && direction != RTC_RTP_TRANSCEIVER_DIRECTION_RECVONLY &&
+        direction != RTC_RTP_TRANSCEIVER_DIRECTION_INACTIVE) {
+        CHK_STATUS(rtp_transceiver_createGopCache(pKvsRtpTransceiver, pKvsPeerConnection->gopCacheSize));
+    }
 
     // after pKvsRtpTransceiver is successfully created, jitterBuffer will be freed by pKvsRtpTransceiver.
     pJitterBuffer = NULL;
@@ -32,6 +32,9 @@ extern "C" {
 #include "network.h"
 #include "srtp_session.h"
 #include "sctp_session.h"
+#include "RtpPacketPool.h"
+#include "Pacer.h"
+#include "TwccManager.h"
 
 /******************************************************************************
  * DEFINITIONS
@@ -61,12 +64,22 @@ extern "C" {
 #define DATA_CHANNEL_HASH_TABLE_BUCKET_COUNT  200
 #define DATA_CHANNEL_HASH_TABLE_BUCKET_LENGTH 2
 
+// The rtp header and the srtp auth tag a path mtu leaves out of the rtp payload, and the payload of the largest path mtu probe.
+// See KvsRtcConfiguration.enablePathMtuDiscovery
+#define PATH_MTU_RTP_OVERHEAD (MIN_HEADER_LENGTH + SRTP_AUTH_TAG_OVERHEAD)
+#define PATH_MTU_MAX_PAYLOAD  (ICE_PATH_MTU_MAX_PROBE_SIZE - ICE_IPV4_HEADER_LEN - ICE_UDP_HEADER_LEN - PATH_MTU_RTP_OVERHEAD)
+
+// The least time between two key frame requests of a video receiver, see KvsRtcConfiguration.keyFrameRequestMinimumInterval
+#define DEFAULT_KEY_FRAME_REQUEST_MIN_INTERVAL (300 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+
 // Environment variable to display SDPs
 #define DEBUG_LOG_SDP ((PCHAR) "DEBUG_LOG_SDP")
 
 typedef enum __RTX_CODEC {
     RTC_RTX_CODEC_H264_PROFILE_42E01F_LEVEL_ASYMMETRY_ALLOWED_PACKETIZATION_MODE = 1,
     RTC_RTX_CODEC_VP8 = 2,
+    RTC_RTX_CODEC_H265 = 3,
+    RTC_RTX_CODEC_AV1 = 4,
 } RTX_CODEC;
 /**
  * @brief internal structure for peer connection.
@@ -79,6 +92,25 @@ typedef struct __KvsPeerConnection {
 #ifdef ENABLE_STREAMING
     MUTEX pSrtpSessionLock; //!< the lock for srtp session.
     PSrtpSession pSrtpSession;
+    PRtpPacketPool pRtpPacketPool; //!< the rtp packets shared by the rolling buffers and the jitter buffers.
+    PPacer pPacer;                 //!< paces the video packets, NULL unless KvsRtcConfiguration.enablePacer is set.
+    PTwccManager pTwccManager;     //!< sender side bandwidth estimation, NULL if KvsRtcConfiguration.disableSenderSideBandwidthEstimation is set.
+    PTwccReceiver pTwccReceiver;   //!< transport-wide congestion control feedback, NULL if KvsRtcConfiguration.disableTwccFeedback is set.
+    UINT32 twccFeedbackTimerId;
+    UINT32 nackTimerId;            //!< MAX_UINT32 until a transceiver creates its nack generator.
+    RtpExtensionMap extensionMap;  //!< the negotiated ids of the header extensions, shared by every media section.
+    UINT32 frameQueueSize;         //!< the frame queue size of the sending transceivers, 0 if rtp_writeFrameAsync is not used.
+    FRAME_QUEUE_DROP_POLICY frameQueueDropPolicy;
+    BOOL enableFlexFec;                //!< KvsRtcConfiguration.enableFlexFec.
+    UINT32 maxFecProtectionPercentage; //!< KvsRtcConfiguration.maxFecProtectionPercentage or its default.
+    UINT8 flexFecPayloadType;          //!< the negotiated payload type of the flexfec repair packets, 0 if not negotiated.
+    UINT32 opusRedundancy;             //!< KvsRtcConfiguration.opusRedundancy, capped at RED_MAX_REDUNDANCY.
+    UINT8 redPayloadType;              //!< the negotiated payload type of red, 0 if not negotiated.
+    UINT32 gopCacheSize;               //!< the max size of the gop caches, 0 unless KvsRtcConfiguration.enableGopCache is set.
+    BOOL enableAdaptiveJitterBuffer;   //!< KvsRtcConfiguration.enableAdaptiveJitterBuffer.
+    UINT64 jitterBufferMinimumDelay;   //!< KvsRtcConfiguration.jitterBufferMinimumDelay in 100ns, 0 for the default.
+    UINT64 keyFrameRequestInterval;    //!< KvsRtcConfiguration.keyFrameRequestMinimumInterval in 100ns or its default.
+    volatile SIZE_T roundTripTime;     //!< the round trip time of the selected candidate pair in 100ns, read by the receiving thread.
 #endif
 #ifdef ENABLE_DATA_CHANNEL
     PSctpSession pSctpSession;
@@ -124,9 +156,13 @@ typedef struct __KvsPeerConnection {
 
     UINT64 onConnectionStateChangeCustomData;
     RtcOnConnectionStateChange onConnectionStateChange; //!< the callback of peer connection change.
+
+    UINT64 onTargetBitrateCustomData;
+    RtcOnTargetBitrate onTargetBitrate;
     RTC_PEER_CONNECTION_STATE connectionState;
 
-    UINT16 MTU;
+    UINT16 MTU;           //!< the largest rtp payload of any packet, media or repair, see rtp_getPayloadMtu for the media payloads.
+    UINT16 configuredMtu; //!< KvsRtcConfiguration.maximumTransmissionUnit, the MTU while the selected pair has no path mtu.
 
     NullableBool canTrickleIce; //!< indicate the behavior of ice, trickle ice or non-trickle ice.
                                 ///!< https://tools.ietf.org/html/rfc8838
@@ -145,6 +181,17 @@ typedef struct {
  ******************************************************************************/
 STATUS pc_onFrameReady(UINT64, UINT16, UINT16, UINT32);
 STATUS pc_onFrameDrop(UINT64 customData, UINT16 startIndex, UINT16 endIndex, UINT32 timestamp);
+/**
+ * @brief the nack timer, sends the generic nacks which are due for the packets the transceivers lost on the way in. Nothing is asked
+ *        for until the srtp session is set up and ice has a candidate pair to send on.
+ *
+ * @param[in] timerId the timer id.
+ * @param[in] currentTime the current time.
+ * @param[in] customData the peer connection.
+ *
+ * @return STATUS status of execution.
+ */
+STATUS pc_nackCallback(UINT32, UINT64, UINT64);
 /**
  * @brief the callback for dtls socket layer.
  *
@@ -73,7 +73,9 @@ STATUS retransmitter_resendPacketOnNack(PRtcpPacket pRtcpPacket, PKvsPeerConnect
     UINT32 senderSsrc = 0, receiverSsrc = 0;
     UINT32 filledLen = 0, validIndexListLen = 0;
     PKvsRtpTransceiver pSenderTranceiver = NULL;
-    UINT64 item, index;
+    PRtcRtpSender pRtcRtpSender = NULL;
+    UINT64 index;
+    UINT8 ridExtId, rridExtId;
     STATUS tmpStatus = STATUS_SUCCESS;
     PRtpPacket pRtpPacket = NULL, pRtxRtpPacket = NULL;
     PRetransmitter pRetransmitter = NULL;
@@ -83,14 +85,16 @@ STATUS retransmitter_resendPacketOnNack(PRtcpPacket pRtcpPacket, PKvsPeerConnect
     CHK(pKvsPeerConnection != NULL && pRtcpPacket != NULL, STATUS_NULL_ARG);
     CHK_STATUS(rtcp_packet_getNackList(pRtcpPacket->payload, pRtcpPacket->payloadLength, &senderSsrc, &receiverSsrc, NULL, &filledLen));
 
-    tmpStatus = rtp_transceiver_findBySsrc(pKvsPeerConnection, &pSenderTranceiver, receiverSsrc);
+    // Every simulcast encoding keeps its own rolling buffer, the media ssrc of the nack tells which one was lost
+    tmpStatus = rtp_transceiver_findSenderBySsrc(pKvsPeerConnection, receiverSsrc, &pSenderTranceiver, &pRtcRtpSender);
     if (STATUS_NOT_FOUND == tmpStatus) {
-        CHK_STATUS_ERR(rtp_transceiver_findBySsrc(pKvsPeerConnection, &pSenderTranceiver, senderSsrc), STATUS_RTCP_INPUT_SSRC_INVALID,
-                       "Receiving NACK for non existing ssrcs: senderSsrc %lu receiverSsrc %lu", senderSsrc, receiverSsrc);
+        CHK_STATUS_ERR(rtp_transceiver_findSenderBySsrc(pKvsPeerConnection, senderSsrc, &pSenderTranceiver, &pRtcRtpSender),
+                       STATUS_RTCP_INPUT_SSRC_INVALID, "Receiving NACK for non existing ssrcs: senderSsrc %lu receiverSsrc %lu", senderSsrc,
+                       receiverSsrc);
     }
     CHK_STATUS(tmpStatus);
 
-    pRetransmitter = pSenderTranceiver->sender.retransmitter;
+    pRetransmitter = pRtcRtpSender->retransmitter;
     // TODO it is not very clear from the spec whether nackCount is number of packets received or number of rtp packets lost reported in nack packets
     nackCount++;
 
@@ -101,22 +105,29 @@ STATUS retransmitter_resendPacketOnNack(PRtcpPacket pRtcpPacket, PKvsPeerConnect
     CHK_STATUS(rtcp_packet_getNackList(pRtcpPacket->payload, pRtcpPacket->payloadLength, &senderSsrc, &receiverSsrc,
                                        pRetransmitter->sequenceNumberList, &filledLen));
     validIndexListLen = pRetransmitter->validIndexListLen;
-    CHK_STATUS(rtp_rolling_buffer_getValidSeqIndexList(pSenderTranceiver->sender.packetBuffer, pRetransmitter->sequenceNumberList, filledLen,
+    CHK_STATUS(rtp_rolling_buffer_getValidSeqIndexList(pRtcRtpSender->packetBuffer, pRetransmitter->sequenceNumberList, filledLen,
                                                        pRetransmitter->validIndexList, &validIndexListLen));
     for (index = 0; index < validIndexListLen; index++) {
-        retStatus = rolling_buffer_extractData(pSenderTranceiver->sender.packetBuffer->pRollingBuffer, pRetransmitter->validIndexList[index], &item);
-        pRtpPacket = (PRtpPacket) item;
-        CHK(retStatus == STATUS_SUCCESS, retStatus);
+        // The packet stays in the rolling buffer, an extra reference keeps it alive while it is resent
+        CHK_STATUS(rtp_rolling_buffer_getRtpPacket(pRtcRtpSender->packetBuffer, pRetransmitter->validIndexList[index], &pRtpPacket));
 
         if (pRtpPacket != NULL) {
-            if (pSenderTranceiver->sender.payloadType == pSenderTranceiver->sender.rtxPayloadType) {
+            if (pRtcRtpSender->payloadType == pRtcRtpSender->rtxPayloadType) {
                 retStatus = ice_agent_send(pKvsPeerConnection->pIceAgent, pRtpPacket->pRawPacket, pRtpPacket->rawPacketLength);
                 CHK_LOG_ERR(retStatus);
             } else {
-                CHK_STATUS(rtp_packet_constructRetransmitPacketFromBytes(
-                    pRtpPacket->pRawPacket, pRtpPacket->rawPacketLength, pSenderTranceiver->sender.rtxSequenceNumber,
-                    pSenderTranceiver->sender.rtxPayloadType, pSenderTranceiver->sender.rtxSsrc, &pRtxRtpPacket));
-                pSenderTranceiver->sender.rtxSequenceNumber++;
+                CHK_STATUS(rtp_packet_constructRetransmitPacketFromBytes(pRtpPacket->pRawPacket, pRtpPacket->rawPacketLength,
+                                                                         pRtcRtpSender->rtxSequenceNumber, pRtcRtpSender->rtxPayloadType,
+                                                                         pRtcRtpSender->rtxSsrc, &pRtxRtpPacket));
+                pRtcRtpSender->rtxSequenceNumber++;
+                // https://www.rfc-editor.org/rfc/rfc8852#section-3.2 the retransmission stream carries the rid as repaired-rtp-stream-id
+                // The element keeps its place and only its id changes, a one-byte header keeps the rid if the rrid id does not fit in it
+                ridExtId = pKvsPeerConnection->extensionMap.ids[RTP_EXTENSION_RID];
+                rridExtId = pKvsPeerConnection->extensionMap.ids[RTP_EXTENSION_RRID];
+                if (ridExtId != 0 && rridExtId != 0 &&
+                    STATUS_SUCCEEDED(rtp_packet_setPacketFromBytes(pRtxRtpPacket->pRawPacket, pRtxRtpPacket->rawPacketLength, pRtxRtpPacket))) {
+                    rtp_extension_renameElement(pRtxRtpPacket, ridExtId, rridExtId);
+                }
                 retStatus = rtp_writePacket(pKvsPeerConnection, pRtxRtpPacket);
             }
             // resendPacket
@@ -127,38 +138,25 @@ STATUS retransmitter_resendPacketOnNack(PRtcpPacket pRtcpPacket, PKvsPeerConnect
             } else {
                 DLOGV("Resent packet ssrc %lu seq %lu failed 0x%08x", pRtpPacket->header.ssrc, pRtpPacket->header.sequenceNumber, retStatus);
             }
-            // putBackPacketToRollingBuffer
-            retStatus =
-                rolling_buffer_insertData(pSenderTranceiver->sender.packetBuffer->pRollingBuffer, pRetransmitter->sequenceNumberList[index], item);
-            CHK(retStatus == STATUS_SUCCESS || retStatus == STATUS_ROLLING_BUFFER_NOT_IN_RANGE, retStatus);
-
-            // free the packet if it is not in the valid range any more
-            if (retStatus == STATUS_ROLLING_BUFFER_NOT_IN_RANGE) {
-                DLOGS("Retransmit STATUS_ROLLING_BUFFER_NOT_IN_RANGE free %lu by self", pRtpPacket->header.sequenceNumber);
-                rtp_packet_free(&pRtpPacket);
-                retStatus = STATUS_SUCCESS;
-            } else {
-                DLOGS("Retransmit add back to rolling %lu", pRtpPacket->header.sequenceNumber);
-            }
+            retStatus = STATUS_SUCCESS;
 
             rtp_packet_free(&pRtxRtpPacket);
-            pRtpPacket = NULL;
+            rtp_packet_free(&pRtpPacket);
         }
     }
 CleanUp:
 
-    MUTEX_LOCK(pSenderTranceiver->statsLock);
-    pSenderTranceiver->outboundStats.nackCount += nackCount;
-    pSenderTranceiver->outboundStats.retransmittedPacketsSent += retransmittedPacketsSent;
-    pSenderTranceiver->outboundStats.retransmittedBytesSent += retransmittedBytesSent;
-    MUTEX_UNLOCK(pSenderTranceiver->statsLock);
+    if (pSenderTranceiver != NULL) {
+        MUTEX_LOCK(pSenderTranceiver->statsLock);
+        pSenderTranceiver->outboundStats.nackCount += nackCount;
+        pSenderTranceiver->outboundStats.retransmittedPacketsSent += retransmittedPacketsSent;
+        pSenderTranceiver->outboundStats.retransmittedBytesSent += retransmittedBytesSent;
+        MUTEX_UNLOCK(pSenderTranceiver->statsLock);
+    }
 
     CHK_LOG_ERR(retStatus);
-    if (pRtpPacket != NULL) {
-        // free the packet as it is not put back into rolling buffer
-        rtp_packet_free(&pRtpPacket);
-        pRtpPacket = NULL;
-    }
+    rtp_packet_free(&pRtxRtpPacket);
+    rtp_packet_free(&pRtpPacket);
 
     LEAVES();
     return retStatus;
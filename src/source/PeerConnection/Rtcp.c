@@ -76,7 +76,101 @@ CleanUp:
     return retStatus;
 }
 /**
- * @brief TODO better sender report handling https://tools.ietf.org/html/rfc3550#section-6.4.1
+ * @brief update the remote inbound stats of the stream a report block is about, https://tools.ietf.org/html/rfc3550#section-6.4.2
+ *
+ * @param[in] pKvsPeerConnection the context of peer connection.
+ * @param[in] senderSSRC the ssrc of the reporter.
+ * @param[in] pReportBlock the report block.
+ * @param[in] currentTimeNTP the arrival time of the report, in ntp time.
+ *
+ * @return STATUS status of execution
+ */
+static STATUS rtcp_onReportBlock(PKvsPeerConnection pKvsPeerConnection, UINT32 senderSSRC, PBYTE pReportBlock, UINT64 currentTimeNTP)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PKvsRtpTransceiver pTransceiver = NULL;
+    DOUBLE fractionLost;
+    UINT32 rttPropDelayMsec = 0, rttPropDelay, delaySinceLastSR, lastSR, interarrivalJitter, extHiSeqNumReceived, cumulativeLost, ssrc1;
+
+    ssrc1 = getUnalignedInt32BigEndian(pReportBlock);
+
+    if (STATUS_FAILED(rtp_transceiver_findBySsrc(pKvsPeerConnection, &pTransceiver, ssrc1))) {
+        DLOGW("Received receiver report for non existing ssrc: %u", ssrc1);
+        return STATUS_SUCCESS; // not really an error ?
+    }
+    fractionLost = pReportBlock[4] / 255.0;
+    cumulativeLost = ((UINT32) getUnalignedInt32BigEndian(pReportBlock + 4)) & 0x00ffffffu;
+    extHiSeqNumReceived = getUnalignedInt32BigEndian(pReportBlock + 8);
+    interarrivalJitter = getUnalignedInt32BigEndian(pReportBlock + 12);
+    lastSR = getUnalignedInt32BigEndian(pReportBlock + 16);
+    delaySinceLastSR = getUnalignedInt32BigEndian(pReportBlock + 20);
+
+    DLOGS("RTCP_PACKET_TYPE_RECEIVER_REPORT %u %u loss: %u %u seq: %u jit: %u lsr: %u dlsr: %u", senderSSRC, ssrc1, fractionLost, cumulativeLost,
+          extHiSeqNumReceived, interarrivalJitter, lastSR, delaySinceLastSR);
+    if (lastSR != 0) {
+        // https://tools.ietf.org/html/rfc3550#section-6.4.1
+        //      Source SSRC_n can compute the round-trip propagation delay to
+        //      SSRC_r by recording the time A when this reception report block is
+        //      received.  It calculates the total round-trip time A-LSR using the
+        //      last SR timestamp (LSR) field, and then subtracting this field to
+        //      leave the round-trip propagation delay as (A - LSR - DLSR).
+        rttPropDelay = MID_NTP(currentTimeNTP) - lastSR - delaySinceLastSR;
+        rttPropDelayMsec = KVS_CONVERT_TIMESCALE(rttPropDelay, DLSR_TIMESCALE, 1000);
+        DLOGS("RTCP_PACKET_TYPE_RECEIVER_REPORT rttPropDelay %u msec", rttPropDelayMsec);
+    }
+
+    MUTEX_LOCK(pTransceiver->statsLock);
+    pTransceiver->remoteInboundStats.reportsReceived++;
+    if (fractionLost > -1.0) {
+        pTransceiver->remoteInboundStats.fractionLost = fractionLost;
+    }
+    pTransceiver->remoteInboundStats.roundTripTimeMeasurements++;
+    pTransceiver->remoteInboundStats.totalRoundTripTime += rttPropDelayMsec;
+    pTransceiver->remoteInboundStats.roundTripTime = rttPropDelayMsec;
+    MUTEX_UNLOCK(pTransceiver->statsLock);
+
+    // The report on the media stream drives how much of it the repair packets protect
+    if (ssrc1 == pTransceiver->sender.ssrc) {
+        flexfec_encoder_onLossReport(pTransceiver->sender.pFlexFecEncoder, fractionLost);
+    }
+
+    return retStatus;
+}
+
+/**
+ * @brief handle the report blocks which follow the sender ssrc, or the sender info of a sender report.
+ *
+ * @param[in] pRtcpPacket the buffer of rtcp packet.
+ * @param[in] pKvsPeerConnection the context of peer connection.
+ * @param[in] offset the offset of the first report block in the payload.
+ *
+ * @return STATUS status of execution
+ */
+static STATUS rtcp_onReportBlocks(PRtcpPacket pRtcpPacket, PKvsPeerConnection pKvsPeerConnection, UINT32 offset)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 i, senderSSRC;
+    UINT64 currentTimeNTP = rtcp_packet_convertTimestampToNTP(GETTIME());
+
+    if (pRtcpPacket->payloadLength < offset + pRtcpPacket->header.receptionReportCount * RTCP_PACKET_RECEIVER_REPORT_BLOCK_LEN) {
+        DLOGW("unhandled packet type %d size %d with %d report blocks", pRtcpPacket->header.packetType, pRtcpPacket->payloadLength,
+              pRtcpPacket->header.receptionReportCount);
+        return STATUS_SUCCESS;
+    }
+
+    senderSSRC = getUnalignedInt32BigEndian(pRtcpPacket->payload);
+    for (i = 0; i < pRtcpPacket->header.receptionReportCount; i++) {
+        CHK_STATUS(rtcp_onReportBlock(pKvsPeerConnection, senderSSRC, pRtcpPacket->payload + offset + i * RTCP_PACKET_RECEIVER_REPORT_BLOCK_LEN,
+                                      currentTimeNTP));
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * @brief https://tools.ietf.org/html/rfc3550#section-6.4.1
  *        0                   1                   2                   3
  *        0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
  *        +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
@@ -113,6 +207,7 @@ CleanUp:
  *        |                  profile-specific extensions                  |
  *        +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
  *
+ *        The ntp timestamp of the sender report of a stream we receive is echoed by the next receiver report block on it as LSR.
  *
  * @param[in] pRtcpPacket the buffer of rtcp packet.
  * @param[in] pKvsPeerConnection the context of peer connection.
@@ -127,8 +222,7 @@ static STATUS rtcp_onSRPacket(PRtcpPacket pRtcpPacket, PKvsPeerConnection pKvsPe
 
     CHK(pKvsPeerConnection != NULL && pRtcpPacket != NULL, STATUS_RTCP_NULL_ARG);
 
-    if (pRtcpPacket->payloadLength != RTCP_PACKET_SENDER_REPORT_MINLEN) {
-        // TODO: handle sender report containing receiver report blocks
+    if (pRtcpPacket->payloadLength < RTCP_PACKET_SENDER_REPORT_MINLEN) {
         DLOGW("unhandled packet type RTCP_PACKET_SENDER_REPORT size %d", pRtcpPacket->payloadLength);
         return STATUS_SUCCESS;
     }
@@ -140,10 +234,18 @@ static STATUS rtcp_onSRPacket(PRtcpPacket pRtcpPacket, PKvsPeerConnection pKvsPe
         UINT32 packetCnt = getUnalignedInt32BigEndian(pRtcpPacket->payload + 16);
         UINT32 octetCnt = getUnalignedInt32BigEndian(pRtcpPacket->payload + 20);
         DLOGV("RTCP_PACKET_TYPE_SENDER_REPORT %d %" PRIu64 " rtpTs: %u %u pkts %u bytes", senderSSRC, ntpTime, rtpTs, packetCnt, octetCnt);
+        if (pTransceiver->jitterBufferSsrc == senderSSRC) {
+            MUTEX_LOCK(pTransceiver->statsLock);
+            receive_statistics_onSenderReport(&pTransceiver->receiveStatistics, ntpTime, GETTIME());
+            MUTEX_UNLOCK(pTransceiver->statsLock);
+        }
     } else {
         DLOGV("Received sender report for non existing ssrc: %u", senderSSRC);
     }
 
+    // A sender which receives from us too reports on that along with its sender info
+    CHK_STATUS(rtcp_onReportBlocks(pRtcpPacket, pKvsPeerConnection, RTCP_PACKET_SENDER_REPORT_MINLEN));
+
 CleanUp:
 
     return retStatus;
@@ -152,56 +254,10 @@ CleanUp:
 static STATUS rtcp_onRRPacket(PRtcpPacket pRtcpPacket, PKvsPeerConnection pKvsPeerConnection)
 {
     STATUS retStatus = STATUS_SUCCESS;
-    PKvsRtpTransceiver pTransceiver = NULL;
-    DOUBLE fractionLost;
-    UINT32 rttPropDelayMsec = 0, rttPropDelay, delaySinceLastSR, lastSR, interarrivalJitter, extHiSeqNumReceived, cumulativeLost, senderSSRC, ssrc1;
-    UINT64 currentTimeNTP = rtcp_packet_convertTimestampToNTP(GETTIME());
 
     CHK(pKvsPeerConnection != NULL && pRtcpPacket != NULL, STATUS_RTCP_NULL_ARG);
     // https://tools.ietf.org/html/rfc3550#section-6.4.2
-    if (pRtcpPacket->payloadLength != RTCP_PACKET_RECEIVER_REPORT_MINLEN) {
-        // TODO: handle multiple receiver report blocks
-        DLOGS("unhandled packet type RTCP_PACKET_TYPE_RECEIVER_REPORT size %d", pRtcpPacket->payloadLength);
-        return STATUS_SUCCESS;
-    }
-
-    senderSSRC = getUnalignedInt32BigEndian(pRtcpPacket->payload);
-    ssrc1 = getUnalignedInt32BigEndian(pRtcpPacket->payload + 4);
-
-    if (STATUS_FAILED(rtp_transceiver_findBySsrc(pKvsPeerConnection, &pTransceiver, ssrc1))) {
-        DLOGW("Received receiver report for non existing ssrc: %u", ssrc1);
-        return STATUS_SUCCESS; // not really an error ?
-    }
-    fractionLost = pRtcpPacket->payload[8] / 255.0;
-    cumulativeLost = ((UINT32) getUnalignedInt32BigEndian(pRtcpPacket->payload + 8)) & 0x00ffffffu;
-    extHiSeqNumReceived = getUnalignedInt32BigEndian(pRtcpPacket->payload + 12);
-    interarrivalJitter = getUnalignedInt32BigEndian(pRtcpPacket->payload + 16);
-    lastSR = getUnalignedInt32BigEndian(pRtcpPacket->payload + 20);
-    delaySinceLastSR = getUnalignedInt32BigEndian(pRtcpPacket->payload + 24);
-
-    DLOGS("RTCP_PACKET_TYPE_RECEIVER_REPORT %u %u loss: %u %u seq: %u jit: %u lsr: %u dlsr: %u", senderSSRC, ssrc1, fractionLost, cumulativeLost,
-          extHiSeqNumReceived, interarrivalJitter, lastSR, delaySinceLastSR);
-    if (lastSR != 0) {
-        // https://tools.ietf.org/html/rfc3550#section-6.4.1
-        //      Source SSRC_n can compute the round-trip propagation delay to
-        //      SSRC_r by recording the time A when this reception report block is
-        //      received.  It calculates the total round-trip time A-LSR using the
-        //      last SR timestamp (LSR) field, and then subtracting this field to
-        //      leave the round-trip propagation delay as (A - LSR - DLSR).
-        rttPropDelay = MID_NTP(currentTimeNTP) - lastSR - delaySinceLastSR;
-        rttPropDelayMsec = KVS_CONVERT_TIMESCALE(rttPropDelay, DLSR_TIMESCALE, 1000);
-        DLOGS("RTCP_PACKET_TYPE_RECEIVER_REPORT rttPropDelay %u msec", rttPropDelayMsec);
-    }
-
-    MUTEX_LOCK(pTransceiver->statsLock);
-    pTransceiver->remoteInboundStats.reportsReceived++;
-    if (fractionLost > -1.0) {
-        pTransceiver->remoteInboundStats.fractionLost = fractionLost;
-    }
-    pTransceiver->remoteInboundStats.roundTripTimeMeasurements++;
-    pTransceiver->remoteInboundStats.totalRoundTripTime += rttPropDelayMsec;
-    pTransceiver->remoteInboundStats.roundTripTime = rttPropDelayMsec;
-    MUTEX_UNLOCK(pTransceiver->statsLock);
+    CHK_STATUS(rtcp_onReportBlocks(pRtcpPacket, pKvsPeerConnection, SIZEOF(UINT32)));
 
 CleanUp:
 
@@ -226,6 +282,8 @@ STATUS rtcp_onInboundPacket(PKvsPeerConnection pKvsPeerConnection, PBYTE pBuff,
             case RTCP_PACKET_TYPE_GENERIC_RTP_FEEDBACK:
                 if (rtcpPacket.header.receptionReportCount == RTCP_FEEDBACK_MESSAGE_TYPE_NACK) {
                     CHK_STATUS(retransmitter_resendPacketOnNack(&rtcpPacket, pKvsPeerConnection));
+                } else if (rtcpPacket.header.receptionReportCount == RTCP_FEEDBACK_MESSAGE_TYPE_TWCC) {
+                    CHK_STATUS(rtcp_onInboundTwccPacket(&rtcpPacket, pKvsPeerConnection));
                 } else {
                     DLOGW("unhandled RTCP_PACKET_TYPE_GENERIC_RTP_FEEDBACK %d", rtcpPacket.header.receptionReportCount);
                 }
@@ -295,6 +353,21 @@ CleanUp:
     return retStatus;
 }
 
+STATUS rtcp_onInboundTwccPacket(PRtcpPacket pRtcpPacket, PKvsPeerConnection pKvsPeerConnection)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+
+    CHK(pKvsPeerConnection != NULL && pRtcpPacket != NULL, STATUS_RTCP_NULL_ARG);
+    // Not offered, the feedback is not ours to process
+    CHK(pKvsPeerConnection->pTwccManager != NULL, retStatus);
+
+    CHK_STATUS(twcc_manager_onFeedback(pKvsPeerConnection->pTwccManager, pRtcpPacket->payload, pRtcpPacket->payloadLength, GETTIME()));
+
+CleanUp:
+
+    return retStatus;
+}
+
 STATUS rtcp_onPLIPacket(PRtcpPacket pRtcpPacket, PKvsPeerConnection pKvsPeerConnection)
 {
     STATUS retStatus = STATUS_SUCCESS;
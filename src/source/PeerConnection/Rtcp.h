@@ -35,6 +35,15 @@ extern "C" {
 STATUS rtcp_onInboundPacket(PKvsPeerConnection pKvsPeerConnection, PBYTE pBuff, UINT32 buffLen);
 STATUS rtcp_onInboundRembPacket(PRtcpPacket, PKvsPeerConnection);
 STATUS rtcp_onPLIPacket(PRtcpPacket, PKvsPeerConnection);
+/**
+ * @brief hand the transport-wide congestion control feedback to the sender side bandwidth estimation.
+ *
+ * @param[in] pRtcpPacket the transport feedback packet.
+ * @param[in] pKvsPeerConnection the context of peer connection.
+ *
+ * @return STATUS status of execution
+ */
+STATUS rtcp_onInboundTwccPacket(PRtcpPacket, PKvsPeerConnection);
 
 #ifdef __cplusplus
 }
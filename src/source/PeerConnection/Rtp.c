@@ -23,6 +23,8 @@
 #include "Rtp.h"
 #include "RtpVP8Payloader.h"
 #include "RtpH264Payloader.h"
+#include "RtpH265Payloader.h"
+#include "RtpAV1Payloader.h"
 #include "RtpOpusPayloader.h"
 #include "RtpG711Payloader.h"
 #include "time_port.h"
@@ -31,6 +33,10 @@
  * DEFINITIONS
  ******************************************************************************/
 typedef STATUS (*RtpPayloadFunc)(UINT32, PBYTE, UINT32, PBYTE, PUINT32, PUINT32, PUINT32);
+typedef STATUS (*RtpNaluIndexPayloadFunc)(UINT32, PNaluIndex, PBYTE, PUINT32, PUINT32, PUINT32);
+
+static STATUS rtp_writeEncoding(PKvsRtpTransceiver, PRtcRtpSender, PFrame, PPayloadArray);
+static STATUS rtp_sendEncoding(PKvsRtpTransceiver, PRtcRtpSender, PFrame, PPayloadArray);
 /******************************************************************************
  * FUNCTIONS
  ******************************************************************************/
@@ -53,6 +59,7 @@ STATUS rtp_createTransceiver(RTC_RTP_TRANSCEIVER_DIRECTION direction, PKvsPeerCo
     pKvsRtpTransceiver->statsLock = MUTEX_CREATE(FALSE);
     pKvsRtpTransceiver->sender.ssrc = ssrc;
     pKvsRtpTransceiver->sender.rtxSsrc = rtxSsrc;
+    pKvsRtpTransceiver->sender.fecSsrc = (UINT32) RAND();
     pKvsRtpTransceiver->sender.track = *pRtcMediaStreamTrack;
     pKvsRtpTransceiver->sender.packetBuffer = NULL;
     pKvsRtpTransceiver->sender.retransmitter = NULL;
@@ -85,33 +92,55 @@ STATUS rtp_freeTransceiver(PRtcRtpTransceiver* pRtcRtpTransceiver)
     return STATUS_NOT_IMPLEMENTED;
 }
 
+static VOID rtp_sender_free(PRtcRtpSender pRtcRtpSender)
+{
+    if (pRtcRtpSender->packetBuffer != NULL) {
+        rtp_rolling_buffer_free(&pRtcRtpSender->packetBuffer);
+    }
+
+    if (pRtcRtpSender->retransmitter != NULL) {
+        retransmitter_free(&pRtcRtpSender->retransmitter);
+    }
+
+    flexfec_encoder_free(&pRtcRtpSender->pFlexFecEncoder);
+    red_encoder_free(&pRtcRtpSender->pRedEncoder);
+
+    SAFE_MEMFREE(pRtcRtpSender->payloadArray.payloadBuffer);
+    SAFE_MEMFREE(pRtcRtpSender->payloadArray.payloadSubLength);
+    nalu_index_free(&pRtcRtpSender->payloadArray.naluIndex);
+    SAFE_MEMFREE(pRtcRtpSender->pPacketList);
+    SAFE_MEMFREE(pRtcRtpSender->pEncryptBuffer);
+}
+
 STATUS rtp_transceiver_free(PKvsRtpTransceiver* ppKvsRtpTransceiver)
 {
     STATUS retStatus = STATUS_SUCCESS;
     PKvsRtpTransceiver pKvsRtpTransceiver = NULL;
+    UINT32 i;
 
     CHK(ppKvsRtpTransceiver != NULL, STATUS_RTP_NULL_ARG);
     pKvsRtpTransceiver = *ppKvsRtpTransceiver;
     // free is idempotent
     CHK(pKvsRtpTransceiver != NULL, retStatus);
 
+    // The worker writes through the rest of the transceiver
+    CHK_LOG_ERR(frame_queue_free(&pKvsRtpTransceiver->pFrameQueue));
+    gop_cache_free(&pKvsRtpTransceiver->pGopCache);
+
     if (pKvsRtpTransceiver->pJitterBuffer != NULL) {
         jitter_buffer_free(&pKvsRtpTransceiver->pJitterBuffer);
     }
+    flexfec_receiver_free(&pKvsRtpTransceiver->pFlexFecReceiver);
+    SAFE_MEMFREE(pKvsRtpTransceiver->pRedBlocks);
+    nack_generator_free(&pKvsRtpTransceiver->pNackGenerator);
 
-    if (pKvsRtpTransceiver->sender.packetBuffer != NULL) {
-        rtp_rolling_buffer_free(&pKvsRtpTransceiver->sender.packetBuffer);
-    }
-
-    if (pKvsRtpTransceiver->sender.retransmitter != NULL) {
-        retransmitter_free(&pKvsRtpTransceiver->sender.retransmitter);
+    for (i = 0; i < rtp_transceiver_getEncodingCount(pKvsRtpTransceiver); i++) {
+        rtp_sender_free(rtp_transceiver_getSender(pKvsRtpTransceiver, i));
     }
     MUTEX_FREE(pKvsRtpTransceiver->statsLock);
     pKvsRtpTransceiver->statsLock = INVALID_MUTEX_VALUE;
 
     SAFE_MEMFREE(pKvsRtpTransceiver->peerFrameBuffer);
-    SAFE_MEMFREE(pKvsRtpTransceiver->sender.payloadArray.payloadBuffer);
-    SAFE_MEMFREE(pKvsRtpTransceiver->sender.payloadArray.payloadSubLength);
 
     SAFE_MEMFREE(pKvsRtpTransceiver);
 
@@ -134,6 +163,244 @@ CleanUp:
     return retStatus;
 }
 
+UINT32 rtp_transceiver_getEncodingCount(PKvsRtpTransceiver pKvsRtpTransceiver)
+{
+    return MAX(1, pKvsRtpTransceiver->simulcastEncodingCount);
+}
+
+PRtcRtpSender rtp_transceiver_getSender(PKvsRtpTransceiver pKvsRtpTransceiver, UINT32 encodingIndex)
+{
+    if (encodingIndex == 0) {
+        return &pKvsRtpTransceiver->sender;
+    }
+
+    return encodingIndex < pKvsRtpTransceiver->simulcastEncodingCount ? &pKvsRtpTransceiver->simulcastSenders[encodingIndex - 1] : NULL;
+}
+
+static BOOL rtp_isValidRid(PCHAR rid)
+{
+    UINT32 i, length = (UINT32) STRNLEN(rid, MAX_RTP_STREAM_ID_LEN + 1);
+
+    // rid-id = 1*(alpha-numeric / "-" / "_") https://tools.ietf.org/html/rfc8851#section-10
+    if (length == 0 || length > MAX_RTP_STREAM_ID_LEN) {
+        return FALSE;
+    }
+    for (i = 0; i < length; i++) {
+        if (!((rid[i] >= 'a' && rid[i] <= 'z') || (rid[i] >= 'A' && rid[i] <= 'Z') || (rid[i] >= '0' && rid[i] <= '9') || rid[i] == '-' ||
+              rid[i] == '_')) {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+}
+
+STATUS rtp_transceiver_addSimulcastEncoding(PRtcRtpTransceiver pRtcRtpTransceiver, PCHAR rid)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PKvsRtpTransceiver pKvsRtpTransceiver = (PKvsRtpTransceiver) pRtcRtpTransceiver;
+    PRtcRtpSender pRtcRtpSender = NULL;
+    UINT32 i;
+
+    CHK(pKvsRtpTransceiver != NULL && rid != NULL, STATUS_RTP_NULL_ARG);
+    // The rolling buffers of the encodings are created once the payload types are negotiated
+    CHK(pKvsRtpTransceiver->sender.track.kind == MEDIA_STREAM_TRACK_KIND_VIDEO && pKvsRtpTransceiver->sender.packetBuffer == NULL,
+        STATUS_INVALID_OPERATION);
+    CHK(pKvsRtpTransceiver->simulcastEncodingCount < MAX_SIMULCAST_ENCODING_COUNT, STATUS_RTP_MAX_ENCODINGS_EXCEEDED);
+    CHK(rtp_isValidRid(rid), STATUS_RTP_INVALID_RID);
+    for (i = 0; i < pKvsRtpTransceiver->simulcastEncodingCount; i++) {
+        CHK(STRCMP(rtp_transceiver_getSender(pKvsRtpTransceiver, i)->rid, rid) != 0, STATUS_RTP_INVALID_RID);
+    }
+
+    pRtcRtpSender = pKvsRtpTransceiver->simulcastEncodingCount == 0
+        ? &pKvsRtpTransceiver->sender
+        : &pKvsRtpTransceiver->simulcastSenders[pKvsRtpTransceiver->simulcastEncodingCount - 1];
+    if (pRtcRtpSender != &pKvsRtpTransceiver->sender) {
+        MEMSET(pRtcRtpSender, 0x00, SIZEOF(RtcRtpSender));
+        pRtcRtpSender->ssrc = (UINT32) RAND();
+        pRtcRtpSender->rtxSsrc = (UINT32) RAND();
+        pRtcRtpSender->track = pKvsRtpTransceiver->sender.track;
+    }
+    STRNCPY(pRtcRtpSender->rid, rid, MAX_RTP_STREAM_ID_LEN);
+    pKvsRtpTransceiver->simulcastEncodingCount++;
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
+static STATUS rtp_writeQueuedFrame(UINT64 customData, PFrame pFrame)
+{
+    return rtp_writeFrame((PRtcRtpTransceiver) customData, pFrame);
+}
+
+static VOID rtp_onQueuedFramesDropped(UINT64 customData, UINT32 frameCount, UINT64 frameBytes, BOOL keyFrameNeeded)
+{
+    PKvsRtpTransceiver pKvsRtpTransceiver = (PKvsRtpTransceiver) customData;
+
+    MUTEX_LOCK(pKvsRtpTransceiver->statsLock);
+    pKvsRtpTransceiver->outboundStats.framesDiscardedOnSend += frameCount;
+    pKvsRtpTransceiver->outboundStats.bytesDiscardedOnSend += frameBytes;
+    MUTEX_UNLOCK(pKvsRtpTransceiver->statsLock);
+
+    // Ask the encoder for a key frame right away instead of dropping frames until the next periodic one
+    if (keyFrameNeeded && pKvsRtpTransceiver->onPictureLoss != NULL) {
+        pKvsRtpTransceiver->onPictureLoss(pKvsRtpTransceiver->onPictureLossCustomData);
+    }
+}
+
+STATUS rtp_transceiver_createFrameQueue(PKvsRtpTransceiver pKvsRtpTransceiver, UINT32 queueSize, FRAME_QUEUE_DROP_POLICY dropPolicy)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+
+    CHK(pKvsRtpTransceiver != NULL, STATUS_RTP_NULL_ARG);
+    CHK(pKvsRtpTransceiver->pFrameQueue == NULL, STATUS_INVALID_OPERATION);
+
+    // Every audio frame decodes on its own
+    if (pKvsRtpTransceiver->sender.track.kind == MEDIA_STREAM_TRACK_KIND_AUDIO) {
+        dropPolicy = FRAME_QUEUE_DROP_POLICY_DROP_OLDEST;
+    }
+    CHK_STATUS(frame_queue_create(queueSize, dropPolicy, rtp_writeQueuedFrame, rtp_onQueuedFramesDropped, (UINT64) pKvsRtpTransceiver,
+                                  &pKvsRtpTransceiver->pFrameQueue));
+    CHK_STATUS(frame_queue_start(pKvsRtpTransceiver->pFrameQueue));
+
+CleanUp:
+    if (STATUS_FAILED(retStatus) && pKvsRtpTransceiver != NULL) {
+        frame_queue_free(&pKvsRtpTransceiver->pFrameQueue);
+    }
+
+    return retStatus;
+}
+
+STATUS rtp_transceiver_createGopCache(PKvsRtpTransceiver pKvsRtpTransceiver, UINT32 maxByteCount)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+
+    CHK(pKvsRtpTransceiver != NULL, STATUS_RTP_NULL_ARG);
+    CHK(pKvsRtpTransceiver->pGopCache == NULL, STATUS_INVALID_OPERATION);
+    // Every audio frame decodes on its own
+    CHK(pKvsRtpTransceiver->sender.track.kind == MEDIA_STREAM_TRACK_KIND_VIDEO, retStatus);
+    CHK_STATUS(gop_cache_create(maxByteCount, &pKvsRtpTransceiver->pGopCache));
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS rtp_transceiver_seedGopCache(PKvsRtpTransceiver pKvsRtpTransceiver, PGopCache pSourceGopCache)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PKvsPeerConnection pKvsPeerConnection;
+    PGopCache pGopCache;
+    BOOL srtpReady;
+
+    CHK(pKvsRtpTransceiver != NULL && pSourceGopCache != NULL, STATUS_RTP_NULL_ARG);
+    pKvsPeerConnection = pKvsRtpTransceiver->pKvsPeerConnection;
+    pGopCache = pKvsRtpTransceiver->pGopCache;
+    CHK(pGopCache != NULL, retStatus);
+
+    MUTEX_LOCK(pSourceGopCache->lock);
+    MUTEX_LOCK(pGopCache->lock);
+    // The frames the transceiver cached before it joined the source are not part of its gop
+    gop_cache_clear(pGopCache);
+    pGopCache->flushed = FALSE;
+    retStatus = gop_cache_copyFrames(pGopCache, pSourceGopCache);
+    MUTEX_UNLOCK(pGopCache->lock);
+    MUTEX_UNLOCK(pSourceGopCache->lock);
+    CHK_STATUS(retStatus);
+
+    MUTEX_LOCK(pKvsPeerConnection->pSrtpSessionLock);
+    srtpReady = pKvsPeerConnection->pSrtpSession != NULL;
+    MUTEX_UNLOCK(pKvsPeerConnection->pSrtpSessionLock);
+    if (srtpReady) {
+        // The viewer is already connected, it gets the gop right away instead of with the next live frame
+        CHK_STATUS(rtp_transceiver_flushGopCache(pKvsRtpTransceiver));
+    }
+
+CleanUp:
+    CHK_LOG_ERR(retStatus);
+
+    return retStatus;
+}
+
+STATUS rtp_transceiver_flushGopCache(PKvsRtpTransceiver pKvsRtpTransceiver)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PGopCache pGopCache = NULL;
+    PCachedFrame pFrames = NULL;
+    Frame frame;
+    UINT64 newestPresentationTs = 0, offset;
+    UINT32 i, frameCount = 0;
+    BOOL locked = FALSE, claimed = FALSE, firstBatch = TRUE;
+
+    CHK(pKvsRtpTransceiver != NULL, STATUS_RTP_NULL_ARG);
+    pGopCache = pKvsRtpTransceiver->pGopCache;
+    CHK(pGopCache != NULL, retStatus);
+
+    MUTEX_LOCK(pGopCache->lock);
+    locked = TRUE;
+    // Another flush is sending the cache, the frames cached meanwhile go out behind the ones it took
+    CHK(!pGopCache->flushed && !pGopCache->flushing, retStatus);
+    pGopCache->flushing = TRUE;
+    claimed = TRUE;
+    MUTEX_UNLOCK(pGopCache->lock);
+    locked = FALSE;
+
+    pFrames = (PCachedFrame) MEMCALLOC(GOP_CACHE_MAX_FRAME_COUNT, SIZEOF(CachedFrame));
+    CHK(pFrames != NULL, STATUS_NOT_ENOUGH_MEMORY);
+
+    while (TRUE) {
+        // The frames are taken out under the lock and sent without it. The live frames which come meanwhile are cached behind them,
+        // the cache is flushed once a pass finds it empty
+        MUTEX_LOCK(pGopCache->lock);
+        locked = TRUE;
+        CHK_STATUS(gop_cache_takeFrames(pGopCache, pFrames, &frameCount));
+        CHK(frameCount > 0, retStatus);
+        MUTEX_UNLOCK(pGopCache->lock);
+        locked = FALSE;
+
+        if (firstBatch) {
+            DLOGI("Sending the %u cached frames of the last gop", frameCount);
+            newestPresentationTs = pFrames[frameCount - 1].frame.presentationTs;
+        }
+        for (i = 0; i < frameCount; i++) {
+            frame = pFrames[i].frame;
+            // The gop is sent back to back, the frames cached while it was sent keep their timestamps
+            if (firstBatch) {
+                offset = (UINT64) (frameCount - 1 - i) * GOP_CACHE_REPLAY_FRAME_INTERVAL;
+                frame.presentationTs = newestPresentationTs - MIN(offset, newestPresentationTs);
+                frame.decodingTs = frame.presentationTs;
+            }
+            CHK_STATUS(rtp_sendEncoding(pKvsRtpTransceiver, &pKvsRtpTransceiver->sender, &frame, NULL));
+        }
+        gop_cache_freeFrames(pFrames, frameCount);
+        frameCount = 0;
+        firstBatch = FALSE;
+    }
+
+CleanUp:
+    if (claimed) {
+        if (!locked) {
+            MUTEX_LOCK(pGopCache->lock);
+            locked = TRUE;
+        }
+        // Nothing is cached once the cache was sent, a failed flush drops the rest of the gop
+        gop_cache_clear(pGopCache);
+        pGopCache->flushing = FALSE;
+        pGopCache->flushed = TRUE;
+    }
+    if (locked) {
+        MUTEX_UNLOCK(pGopCache->lock);
+    }
+    gop_cache_freeFrames(pFrames, frameCount);
+    SAFE_MEMFREE(pFrames);
+    CHK_LOG_ERR(retStatus);
+
+    return retStatus;
+}
+
 STATUS rtp_transceiver_onFrame(PRtcRtpTransceiver pRtcRtpTransceiver, UINT64 customData, RtcOnFrame rtcOnFrame)
 {
     ENTERS();
@@ -194,6 +461,10 @@ STATUS rtp_transceiver_updateEncoderStats(PRtcRtpTransceiver pRtcRtpTransceiver,
     MUTEX_LOCK(pKvsRtpTransceiver->statsLock);
     pKvsRtpTransceiver->outboundStats.totalEncodeTime += encoderStats->encodeTimeMsec;
     pKvsRtpTransceiver->outboundStats.targetBitrate = encoderStats->targetBitrate;
+    if (pKvsRtpTransceiver->pKvsPeerConnection->pPacer != NULL && pKvsRtpTransceiver->sender.track.kind == MEDIA_STREAM_TRACK_KIND_VIDEO &&
+        encoderStats->targetBitrate != 0) {
+        CHK_LOG_ERR(pacer_setTargetBitrate(pKvsRtpTransceiver->pKvsPeerConnection->pPacer, encoderStats->targetBitrate));
+    }
     if (encoderStats->width < pKvsRtpTransceiver->outboundStats.frameWidth || encoderStats->height < pKvsRtpTransceiver->outboundStats.frameHeight) {
         pKvsRtpTransceiver->outboundStats.qualityLimitationResolutionChanges++;
     }
@@ -213,36 +484,400 @@ CleanUp:
     return retStatus;
 }
 
-STATUS rtp_writeFrame(PRtcRtpTransceiver pRtcRtpTransceiver, PFrame pFrame)
+static STATUS rtp_getPayloadFunc(RTC_CODEC codec, RtpPayloadFunc* pRtpPayloadFunc, PUINT64 pClockRate)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+
+    switch (codec) {
+        case RTC_CODEC_H264_PROFILE_42E01F_LEVEL_ASYMMETRY_ALLOWED_PACKETIZATION_MODE:
+            *pRtpPayloadFunc = createPayloadForH264;
+            *pClockRate = VIDEO_CLOCKRATE;
+            break;
+
+        case RTC_CODEC_H265:
+            *pRtpPayloadFunc = createPayloadForH265;
+            *pClockRate = VIDEO_CLOCKRATE;
+            break;
+
+        case RTC_CODEC_OPUS:
+            *pRtpPayloadFunc = createPayloadForOpus;
+            *pClockRate = OPUS_CLOCKRATE;
+            break;
+
+        case RTC_CODEC_MULAW:
+        case RTC_CODEC_ALAW:
+            *pRtpPayloadFunc = createPayloadForG711;
+            *pClockRate = PCM_CLOCKRATE;
+            break;
+
+        case RTC_CODEC_VP8:
+            *pRtpPayloadFunc = createPayloadForVP8;
+            *pClockRate = VIDEO_CLOCKRATE;
+            break;
+
+        case RTC_CODEC_AV1:
+            *pRtpPayloadFunc = createPayloadForAV1;
+            *pClockRate = VIDEO_CLOCKRATE;
+            break;
+
+        default:
+            CHK(FALSE, STATUS_NOT_IMPLEMENTED);
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+static RtpNaluIndexPayloadFunc rtp_getNaluIndexPayloadFunc(RTC_CODEC codec)
+{
+    switch (codec) {
+        case RTC_CODEC_H264_PROFILE_42E01F_LEVEL_ASYMMETRY_ALLOWED_PACKETIZATION_MODE:
+            return createPayloadForH264FromNaluIndex;
+
+        case RTC_CODEC_H265:
+            return createPayloadForH265FromNaluIndex;
+
+        default:
+            return NULL;
+    }
+}
+
+UINT32 rtp_getPayloadMtu(PKvsPeerConnection pKvsPeerConnection)
+{
+    // Leave room for the transport-wide sequence number so that the packets stay within the mtu.
+    // The extension may be negotiated only for the feedback on the packets we receive
+    return pKvsPeerConnection->MTU -
+        (pKvsPeerConnection->pTwccManager != NULL && pKvsPeerConnection->extensionMap.ids[RTP_EXTENSION_TWCC] != 0 ? TWCC_EXT_OVERHEAD : 0) -
+        RTX_OSN_LEN - (pKvsPeerConnection->enableFlexFec ? FLEXFEC_HEADER_LEN : 0);
+}
+
+/**
+ * The room the repair packets of an encoding take on top of the media packets they repair: the original sequence number in front of the
+ * payload of a retransmission, and the flexfec header in front of the xor of the protected packets. Only the first encoding is protected.
+ */
+static UINT32 rtp_sender_getRepairOverhead(PKvsRtpTransceiver pKvsRtpTransceiver, PRtcRtpSender pRtcRtpSender)
+{
+    UINT32 overhead = 0;
+
+    // Without rtx the packets are resent as they are
+    if (pRtcRtpSender->rtxPayloadType != pRtcRtpSender->payloadType) {
+        overhead += RTX_OSN_LEN;
+    }
+    if (pRtcRtpSender->pFlexFecEncoder != NULL && pKvsRtpTransceiver->pKvsPeerConnection->flexFecPayloadType != 0) {
+        overhead += FLEXFEC_HEADER_LEN;
+    }
+
+    return overhead;
+}
+
+/**
+ * Lays out the header extension of the packets of an encoding, the transport-wide sequence number is patched per packet and the mid and
+ * the rid only go along with simulcast.
+ */
+static STATUS rtp_sender_updateExtensionLayout(PKvsRtpTransceiver pKvsRtpTransceiver, PRtcRtpSender pRtcRtpSender)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PKvsPeerConnection pKvsPeerConnection = pKvsRtpTransceiver->pKvsPeerConnection;
+    RtpExtensionElements elements;
+
+    MEMSET(&elements, 0x00, SIZEOF(RtpExtensionElements));
+    // The extension may be negotiated only for the feedback on the packets we receive
+    if (pKvsPeerConnection->pTwccManager != NULL) {
+        elements.length[RTP_EXTENSION_TWCC] = SIZEOF(UINT16);
+    }
+    if (pKvsRtpTransceiver->simulcastNegotiated) {
+        elements.pData[RTP_EXTENSION_MID] = (PBYTE) pKvsRtpTransceiver->mid;
+        elements.length[RTP_EXTENSION_MID] = (UINT8) STRLEN(pKvsRtpTransceiver->mid);
+        elements.pData[RTP_EXTENSION_RID] = (PBYTE) pRtcRtpSender->rid;
+        elements.length[RTP_EXTENSION_RID] = (UINT8) STRLEN(pRtcRtpSender->rid);
+    }
+    CHK_STATUS(rtp_extension_layout_build(&pKvsPeerConnection->extensionMap, &elements, &pRtcRtpSender->extensionLayout));
+
+CleanUp:
+    return retStatus;
+}
+
+STATUS rtp_transceiver_updateExtensionLayouts(PKvsRtpTransceiver pKvsRtpTransceiver)
 {
     STATUS retStatus = STATUS_SUCCESS;
     PKvsPeerConnection pKvsPeerConnection = NULL;
+    PRtcRtpSender pRtcRtpSender;
+    UINT32 i;
+    BOOL locked = FALSE;
+
+    CHK(pKvsRtpTransceiver != NULL, STATUS_NULL_ARG);
+    pKvsPeerConnection = pKvsRtpTransceiver->pKvsPeerConnection;
+
+    // The layouts are read by rtp_writeEncoding under the srtp session lock
+    MUTEX_LOCK(pKvsPeerConnection->pSrtpSessionLock);
+    locked = TRUE;
+    for (i = 0; (pRtcRtpSender = rtp_transceiver_getSender(pKvsRtpTransceiver, i)) != NULL; i++) {
+        CHK_STATUS(rtp_sender_updateExtensionLayout(pKvsRtpTransceiver, pRtcRtpSender));
+    }
+
+CleanUp:
+    if (locked) {
+        MUTEX_UNLOCK(pKvsPeerConnection->pSrtpSessionLock);
+    }
+
+    return retStatus;
+}
+
+UINT32 rtp_transceiver_getPayloadMtu(PKvsRtpTransceiver pKvsRtpTransceiver, PRtcRtpSender pRtcRtpSender)
+{
+    PRtpExtensionLayout pRtpExtensionLayout = &pRtcRtpSender->extensionLayout;
+
+    // Until the session is negotiated, leave the room the transport-wide sequence number would take
+    if (pRtpExtensionLayout->profile == 0) {
+        return rtp_getPayloadMtu(pKvsRtpTransceiver->pKvsPeerConnection);
+    }
+
+    return pKvsRtpTransceiver->pKvsPeerConnection->MTU - (pRtpExtensionLayout->length > 0 ? 4 + pRtpExtensionLayout->length : 0) -
+        rtp_sender_getRepairOverhead(pKvsRtpTransceiver, pRtcRtpSender);
+}
+
+/**
+ * Grows the buffers of a payload array to the lengths of its sizing pass, they are kept from frame to frame
+ */
+static STATUS rtp_reservePayloadArray(PPayloadArray pPayloadArray)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+
+    if (pPayloadArray->payloadLength > pPayloadArray->maxPayloadLength) {
+        SAFE_MEMFREE(pPayloadArray->payloadBuffer);
+        pPayloadArray->maxPayloadLength = 0;
+        pPayloadArray->payloadBuffer = (PBYTE) MEMALLOC(pPayloadArray->payloadLength);
+        CHK(pPayloadArray->payloadBuffer != NULL, STATUS_NOT_ENOUGH_MEMORY);
+        pPayloadArray->maxPayloadLength = pPayloadArray->payloadLength;
+    }
+    if (pPayloadArray->payloadSubLenSize > pPayloadArray->maxPayloadSubLenSize) {
+        SAFE_MEMFREE(pPayloadArray->payloadSubLength);
+        pPayloadArray->maxPayloadSubLenSize = 0;
+        pPayloadArray->payloadSubLength = (PUINT32) MEMALLOC(pPayloadArray->payloadSubLenSize * SIZEOF(UINT32));
+        CHK(pPayloadArray->payloadSubLength != NULL, STATUS_NOT_ENOUGH_MEMORY);
+        pPayloadArray->maxPayloadSubLenSize = pPayloadArray->payloadSubLenSize;
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * The Opus frame and the previous ones the red encoder keeps, in a single packet
+ */
+static STATUS rtp_packetizeRedFrame(PRedEncoder pRedEncoder, UINT32 mtu, UINT32 timestamp, PFrame pFrame, PPayloadArray pPayloadArray)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+
+    CHK_STATUS(createPayloadForRed(pRedEncoder, mtu, timestamp, (PBYTE) pFrame->frameData, pFrame->size, NULL, &(pPayloadArray->payloadLength),
+                                   NULL, &(pPayloadArray->payloadSubLenSize)));
+    CHK_STATUS(rtp_reservePayloadArray(pPayloadArray));
+    CHK_STATUS(createPayloadForRed(pRedEncoder, mtu, timestamp, (PBYTE) pFrame->frameData, pFrame->size, pPayloadArray->payloadBuffer,
+                                   &(pPayloadArray->payloadLength), pPayloadArray->payloadSubLength, &(pPayloadArray->payloadSubLenSize)));
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS rtp_packetizeFrame(RTC_CODEC codec, UINT32 mtu, PFrame pFrame, PPayloadArray pPayloadArray)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    RtpPayloadFunc rtpPayloadFunc = NULL;
+    RtpNaluIndexPayloadFunc rtpNaluIndexPayloadFunc = NULL;
+    UINT64 clockRate = 0;
+
+    CHK(pFrame != NULL && pPayloadArray != NULL, STATUS_RTP_NULL_ARG);
+    CHK_STATUS(rtp_getPayloadFunc(codec, &rtpPayloadFunc, &clockRate));
+
+    // Annex-B frames are scanned for their NALUs once, both passes below walk the index
+    rtpNaluIndexPayloadFunc = rtp_getNaluIndexPayloadFunc(codec);
+    if (rtpNaluIndexPayloadFunc != NULL) {
+        CHK_STATUS(nalu_index_build(&pPayloadArray->naluIndex, (PBYTE) pFrame->frameData, pFrame->size));
+        CHK_STATUS(rtpNaluIndexPayloadFunc(mtu, &pPayloadArray->naluIndex, NULL, &(pPayloadArray->payloadLength), NULL,
+                                           &(pPayloadArray->payloadSubLenSize)));
+    } else {
+        CHK_STATUS(rtpPayloadFunc(mtu, (PBYTE) pFrame->frameData, pFrame->size, NULL, &(pPayloadArray->payloadLength), NULL,
+                                  &(pPayloadArray->payloadSubLenSize)));
+    }
+    CHK_STATUS(rtp_reservePayloadArray(pPayloadArray));
+    if (rtpNaluIndexPayloadFunc != NULL) {
+        CHK_STATUS(rtpNaluIndexPayloadFunc(mtu, &pPayloadArray->naluIndex, pPayloadArray->payloadBuffer, &(pPayloadArray->payloadLength),
+                                           pPayloadArray->payloadSubLength, &(pPayloadArray->payloadSubLenSize)));
+    } else {
+        CHK_STATUS(rtpPayloadFunc(mtu, (PBYTE) pFrame->frameData, pFrame->size, pPayloadArray->payloadBuffer, &(pPayloadArray->payloadLength),
+                                  pPayloadArray->payloadSubLength, &(pPayloadArray->payloadSubLenSize)));
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS rtp_writeFrame(PRtcRtpTransceiver pRtcRtpTransceiver, PFrame pFrame)
+{
+    return rtp_writePayloadArray(pRtcRtpTransceiver, pFrame, NULL);
+}
+
+STATUS rtp_writePayloadArray(PRtcRtpTransceiver pRtcRtpTransceiver, PFrame pFrame, PPayloadArray pPayloadArray)
+{
     PKvsRtpTransceiver pKvsRtpTransceiver = (PKvsRtpTransceiver) pRtcRtpTransceiver;
-    PRtcRtpSender pRtcRtpSender = NULL;
-    BOOL locked = FALSE, bufferAfterEncrypt = FALSE;
-    PRtpPacket pPacketList = NULL, pRtpPacket = NULL;
-    UINT32 i = 0, packetLen = 0, headerLen = 0, allocSize;
+
+    if (pKvsRtpTransceiver == NULL || pFrame == NULL) {
+        return STATUS_RTP_NULL_ARG;
+    }
+
+    return rtp_writeEncoding(pKvsRtpTransceiver, &pKvsRtpTransceiver->sender, pFrame, pPayloadArray);
+}
+
+STATUS rtp_writeSimulcastFrame(PRtcRtpTransceiver pRtcRtpTransceiver, UINT32 encodingIndex, PFrame pFrame)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PKvsRtpTransceiver pKvsRtpTransceiver = (PKvsRtpTransceiver) pRtcRtpTransceiver;
+
+    CHK(pKvsRtpTransceiver != NULL && pFrame != NULL, STATUS_RTP_NULL_ARG);
+    CHK(encodingIndex < rtp_transceiver_getEncodingCount(pKvsRtpTransceiver), STATUS_INVALID_ARG);
+    // Without simulcast in the answer the remote peer only gets the first encoding
+    CHK(encodingIndex == 0 || pKvsRtpTransceiver->simulcastNegotiated, retStatus);
+    CHK_STATUS(rtp_writeEncoding(pKvsRtpTransceiver, rtp_transceiver_getSender(pKvsRtpTransceiver, encodingIndex), pFrame, NULL));
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * Sends the repair packets of a frame behind its media packets, through the pacer if the media packets went through it.
+ * Called with the srtp session lock held.
+ */
+static STATUS rtp_sendRepairPackets(PKvsRtpTransceiver pKvsRtpTransceiver, PFlexFecEncoder pFlexFecEncoder, UINT32 rtpTimestamp, BOOL paced,
+                                    PUINT32 pSentCount)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PKvsPeerConnection pKvsPeerConnection = pKvsRtpTransceiver->pKvsPeerConnection;
+    PFlexFecRepairPacket pRepairPacket;
+    PRtpPacket pRtpPacket = NULL;
+    UINT32 i, repairCount = 0, packetLen;
+
+    CHK_STATUS(flexfec_encoder_endFrame(pFlexFecEncoder, pKvsPeerConnection->flexFecPayloadType, rtpTimestamp, &repairCount));
+    for (i = 0; i < repairCount; i++) {
+        pRepairPacket = &pFlexFecEncoder->pRepairPackets[i];
+        if (pRepairPacket->packetLen == 0) {
+            continue;
+        }
+        packetLen = pRepairPacket->packetLen;
+        CHK_STATUS(rtp_packet_pool_get(pKvsPeerConnection->pRtpPacketPool, packetLen + SRTP_AUTH_TAG_OVERHEAD, &pRtpPacket));
+        MEMCPY(pRtpPacket->pRawPacket, pRepairPacket->pBuffer, packetLen);
+        CHK_STATUS(srtp_session_encryptRtpPacket(pKvsPeerConnection->pSrtpSession, pRtpPacket->pRawPacket, (PINT32) &packetLen));
+        if (paced) {
+            // Accounted by rtp_onPacedPacketSent once it leaves the pacer
+            pRtpPacket->rawPacketLength = packetLen;
+            CHK_STATUS(rtp_packet_setPacketFromBytes(pRtpPacket->pRawPacket, packetLen, pRtpPacket));
+            CHK_STATUS(pacer_enqueue(pKvsPeerConnection->pPacer, (UINT64) pKvsRtpTransceiver, &pRtpPacket, &packetLen, 1, NULL));
+        } else if (STATUS_SUCCEEDED(ice_agent_send(pKvsPeerConnection->pIceAgent, pRtpPacket->pRawPacket, packetLen))) {
+            (*pSentCount)++;
+        }
+        rtp_packet_free(&pRtpPacket);
+    }
+
+CleanUp:
+    rtp_packet_free(&pRtpPacket);
+
+    return retStatus;
+}
+
+/**
+ * Keeps the frame in the gop cache of the transceiver until rtp_transceiver_flushGopCache sent the cache.
+ */
+static STATUS rtp_cacheFrame(PKvsRtpTransceiver pKvsRtpTransceiver, PFrame pFrame, PBOOL pCached)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PKvsPeerConnection pKvsPeerConnection = pKvsRtpTransceiver->pKvsPeerConnection;
+    PGopCache pGopCache = pKvsRtpTransceiver->pGopCache;
+    BOOL flushed, flushing, srtpReady;
+
+    *pCached = FALSE;
+    MUTEX_LOCK(pGopCache->lock);
+    flushed = pGopCache->flushed;
+    flushing = pGopCache->flushing;
+    MUTEX_UNLOCK(pGopCache->lock);
+    CHK(!flushed, retStatus);
+
+    MUTEX_LOCK(pKvsPeerConnection->pSrtpSessionLock);
+    srtpReady = pKvsPeerConnection->pSrtpSession != NULL;
+    MUTEX_UNLOCK(pKvsPeerConnection->pSrtpSessionLock);
+    if (srtpReady && !flushing) {
+        // The transceiver was added once the srtp session was up, or the frame came before the peer connection sent the cache
+        CHK_LOG_ERR(rtp_transceiver_flushGopCache(pKvsRtpTransceiver));
+    }
+
+    // The flush sets flushed under the lock once it finds the cache empty, a frame cached before that is sent by the flush
+    MUTEX_LOCK(pGopCache->lock);
+    *pCached = !pGopCache->flushed;
+    if (*pCached) {
+        retStatus = gop_cache_addFrame(pGopCache, pFrame);
+    }
+    MUTEX_UNLOCK(pGopCache->lock);
+
+CleanUp:
+
+    return retStatus;
+}
+
+static STATUS rtp_writeEncoding(PKvsRtpTransceiver pKvsRtpTransceiver, PRtcRtpSender pRtcRtpSender, PFrame pFrame, PPayloadArray pPayloadArray)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    BOOL cached = FALSE;
+
+    if (pKvsRtpTransceiver->pGopCache != NULL && pRtcRtpSender == &pKvsRtpTransceiver->sender) {
+        // The cached frames are accounted once rtp_transceiver_flushGopCache sends them. The cache keeps the frame data, the frames of a
+        // broadcast group are packetized again when the cache is sent as the shared payloads are gone by then
+        CHK_STATUS(rtp_cacheFrame(pKvsRtpTransceiver, pFrame, &cached));
+        CHK(!cached, STATUS_SRTP_NOT_READY_YET);
+    }
+    CHK_STATUS(rtp_sendEncoding(pKvsRtpTransceiver, pRtcRtpSender, pFrame, pPayloadArray));
+
+CleanUp:
+
+    return retStatus;
+}
+
+static STATUS rtp_sendEncoding(PKvsRtpTransceiver pKvsRtpTransceiver, PRtcRtpSender pRtcRtpSender, PFrame pFrame, PPayloadArray pPayloadArray)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PKvsPeerConnection pKvsPeerConnection = NULL;
+    BOOL locked = FALSE, bufferAfterEncrypt = FALSE, paced = FALSE, firstEncoding = FALSE;
+    PRtpPacket pPacketList = NULL, pRtpPacket = NULL, pSlotPacket = NULL;
+    PRtpPacket* ppPendingPackets = NULL;
+    PBYTE* ppSendBuffers = NULL;
+    PUINT32 pSendBufferLens = NULL;
+    UINT32 i = 0, packetLen = 0, headerLen = 0, allocSize, encryptSize, packetCount = 0, pendingCount = 0, sentCount = 0,
+           discardedCount = 0, queuedCount = 0;
+    UINT8 payloadType;
+    UINT16 twccSequenceNumber = 0;
+    PBYTE pTwccValue = NULL;
     PBYTE rawPacket = NULL;
-    PPayloadArray pPayloadArray = NULL;
     RtpPayloadFunc rtpPayloadFunc = NULL;
+    UINT64 clockRate = 0;
+    PFlexFecEncoder pFlexFecEncoder = NULL;
     UINT64 randomRtpTimeoffset = 0; // TODO: spec requires random rtp time offset
     UINT64 rtpTimestamp = 0;
     UINT64 now = GETTIME();
     // stats updates
     DOUBLE fps = 0.0;
     UINT32 frames = 0, keyframes = 0, bytesSent = 0, packetsSent = 0, headerBytesSent = 0, framesSent = 0;
-    UINT32 packetsDiscardedOnSend = 0, bytesDiscardedOnSend = 0, framesDiscardedOnSend = 0;
+    UINT32 packetsDiscardedOnSend = 0, bytesDiscardedOnSend = 0, framesDiscardedOnSend = 0, fecPacketsSent = 0;
     UINT64 lastPacketSentTimestamp = 0;
     // temp vars :(
     UINT64 tmpFrames, tmpTime;
-    STATUS sendStatus;
 
-    CHK(pKvsRtpTransceiver != NULL && pFrame != NULL, STATUS_RTP_NULL_ARG);
-    pRtcRtpSender = &(pKvsRtpTransceiver->sender);
     pKvsPeerConnection = pKvsRtpTransceiver->pKvsPeerConnection;
-    pPayloadArray = &(pRtcRtpSender->payloadArray);
+    // The frame counters and the fps of the transceiver follow the first encoding
+    firstEncoding = (pRtcRtpSender == &pKvsRtpTransceiver->sender);
 
-    if (MEDIA_STREAM_TRACK_KIND_VIDEO == pRtcRtpSender->track.kind) {
+    if (MEDIA_STREAM_TRACK_KIND_VIDEO == pRtcRtpSender->track.kind && firstEncoding) {
         frames++;
         if (0 != (pFrame->flags & FRAME_FLAG_KEY_FRAME)) {
             keyframes++;
@@ -260,101 +895,173 @@ STATUS rtp_writeFrame(PRtcRtpTransceiver pRtcRtpTransceiver, PFrame pFrame)
     MUTEX_LOCK(pKvsPeerConnection->pSrtpSessionLock);
     locked = TRUE;
     CHK(pKvsPeerConnection->pSrtpSession != NULL, STATUS_SRTP_NOT_READY_YET); // Discard packets till SRTP is ready
-    switch (pRtcRtpSender->track.codec) {
-        case RTC_CODEC_H264_PROFILE_42E01F_LEVEL_ASYMMETRY_ALLOWED_PACKETIZATION_MODE:
-            rtpPayloadFunc = createPayloadForH264;
-            rtpTimestamp = CONVERT_TIMESTAMP_TO_RTP(VIDEO_CLOCKRATE, pFrame->presentationTs);
-            break;
-
-        case RTC_CODEC_OPUS:
-            rtpPayloadFunc = createPayloadForOpus;
-            rtpTimestamp = CONVERT_TIMESTAMP_TO_RTP(OPUS_CLOCKRATE, pFrame->presentationTs);
-            break;
-
-        case RTC_CODEC_MULAW:
-        case RTC_CODEC_ALAW:
-            rtpPayloadFunc = createPayloadForG711;
-            rtpTimestamp = CONVERT_TIMESTAMP_TO_RTP(PCM_CLOCKRATE, pFrame->presentationTs);
-            break;
-
-        case RTC_CODEC_VP8:
-            rtpPayloadFunc = createPayloadForVP8;
-            rtpTimestamp = CONVERT_TIMESTAMP_TO_RTP(VIDEO_CLOCKRATE, pFrame->presentationTs);
-            break;
-
-        default:
-            CHK(FALSE, STATUS_NOT_IMPLEMENTED);
+    // The layout only holds the transport-wide sequence number when the packets we send carry it
+    if (pRtcRtpSender->extensionLayout.offsets[RTP_EXTENSION_TWCC] != 0) {
+        pTwccValue = pRtcRtpSender->extensionLayout.payload + pRtcRtpSender->extensionLayout.offsets[RTP_EXTENSION_TWCC];
     }
-
+    CHK_STATUS(rtp_getPayloadFunc(pRtcRtpSender->track.codec, &rtpPayloadFunc, &clockRate));
+    rtpTimestamp = CONVERT_TIMESTAMP_TO_RTP(clockRate, pFrame->presentationTs);
     rtpTimestamp += randomRtpTimeoffset;
 
-    CHK_STATUS(rtpPayloadFunc(pKvsPeerConnection->MTU, (PBYTE) pFrame->frameData, pFrame->size, NULL, &(pPayloadArray->payloadLength), NULL,
-                              &(pPayloadArray->payloadSubLenSize)));
-    if (pPayloadArray->payloadLength > pPayloadArray->maxPayloadLength) {
-        SAFE_MEMFREE(pPayloadArray->payloadBuffer);
-        pPayloadArray->payloadBuffer = (PBYTE) MEMALLOC(pPayloadArray->payloadLength);
-        pPayloadArray->maxPayloadLength = pPayloadArray->payloadLength;
+    payloadType = pRtcRtpSender->payloadType;
+    if (pPayloadArray == NULL) {
+        pPayloadArray = &(pRtcRtpSender->payloadArray);
+        if (pRtcRtpSender->pRedEncoder != NULL && pKvsPeerConnection->redPayloadType != 0) {
+            payloadType = pKvsPeerConnection->redPayloadType;
+            CHK_STATUS(rtp_packetizeRedFrame(pRtcRtpSender->pRedEncoder, rtp_transceiver_getPayloadMtu(pKvsRtpTransceiver, pRtcRtpSender),
+                                             (UINT32) rtpTimestamp, pFrame, pPayloadArray));
+        } else {
+            CHK_STATUS(rtp_packetizeFrame(pRtcRtpSender->track.codec, rtp_transceiver_getPayloadMtu(pKvsRtpTransceiver, pRtcRtpSender), pFrame,
+                                          pPayloadArray));
+        }
     }
-    if (pPayloadArray->payloadSubLenSize > pPayloadArray->maxPayloadSubLenSize) {
-        SAFE_MEMFREE(pPayloadArray->payloadSubLength);
-        pPayloadArray->payloadSubLength = (PUINT32) MEMALLOC(pPayloadArray->payloadSubLenSize * SIZEOF(UINT32));
-        pPayloadArray->maxPayloadSubLenSize = pPayloadArray->payloadSubLenSize;
+
+    packetCount = pPayloadArray->payloadSubLenSize;
+    if (packetCount > pRtcRtpSender->packetListLen) {
+        SAFE_MEMFREE(pRtcRtpSender->pPacketList);
+        pRtcRtpSender->packetListLen = 0;
+        // One allocation for the packets, the pending pooled packets and the buffers handed to the batch send
+        pRtcRtpSender->pPacketList =
+            (PRtpPacket) MEMALLOC(packetCount * (SIZEOF(RtpPacket) + SIZEOF(PRtpPacket) + SIZEOF(PBYTE) + SIZEOF(UINT32)));
+        CHK(pRtcRtpSender->pPacketList != NULL, STATUS_NOT_ENOUGH_MEMORY);
+        pRtcRtpSender->packetListLen = packetCount;
+    }
+    pPacketList = pRtcRtpSender->pPacketList;
+    ppPendingPackets = (PRtpPacket*) (pPacketList + pRtcRtpSender->packetListLen);
+    ppSendBuffers = (PBYTE*) (ppPendingPackets + pRtcRtpSender->packetListLen);
+    pSendBufferLens = (PUINT32) (ppSendBuffers + pRtcRtpSender->packetListLen);
+
+    CHK_STATUS(rtp_packet_constructPackets(pPayloadArray, payloadType, pRtcRtpSender->sequenceNumber, rtpTimestamp,
+                                           pRtcRtpSender->ssrc, pPacketList, packetCount));
+    pRtcRtpSender->sequenceNumber = GET_UINT16_SEQ_NUM(pRtcRtpSender->sequenceNumber + packetCount);
+    if (pTwccValue != NULL) {
+        // The transport-wide sequence numbers are handed out under the srtp session lock, so they are consecutive within a frame
+        twccSequenceNumber = pKvsPeerConnection->pTwccManager->nextSequenceNumber;
+        pKvsPeerConnection->pTwccManager->nextSequenceNumber = GET_UINT16_SEQ_NUM(twccSequenceNumber + packetCount);
+    }
+    for (i = 0; i < packetCount; i++) {
+        rtp_extension_layout_apply(&pRtcRtpSender->extensionLayout, pPacketList + i);
     }
-    CHK_STATUS(rtpPayloadFunc(pKvsPeerConnection->MTU, (PBYTE) pFrame->frameData, pFrame->size, pPayloadArray->payloadBuffer,
-                              &(pPayloadArray->payloadLength), pPayloadArray->payloadSubLength, &(pPayloadArray->payloadSubLenSize)));
-    pPacketList = (PRtpPacket) MEMALLOC(pPayloadArray->payloadSubLenSize * SIZEOF(RtpPacket));
 
-    CHK_STATUS(rtp_packet_constructPackets(pPayloadArray, pRtcRtpSender->payloadType, pRtcRtpSender->sequenceNumber, rtpTimestamp,
-                                           pRtcRtpSender->ssrc, pPacketList, pPayloadArray->payloadSubLenSize));
-    pRtcRtpSender->sequenceNumber = GET_UINT16_SEQ_NUM(pRtcRtpSender->sequenceNumber + pPayloadArray->payloadSubLenSize);
+    CHK(pRtcRtpSender->packetBuffer != NULL, STATUS_RTP_NULL_ARG);
+    if (pRtcRtpSender->pFlexFecEncoder != NULL && pKvsPeerConnection->flexFecPayloadType != 0) {
+        pFlexFecEncoder = pRtcRtpSender->pFlexFecEncoder;
+        CHK_STATUS(flexfec_encoder_beginFrame(pFlexFecEncoder, packetCount));
+    }
 
     bufferAfterEncrypt = (pRtcRtpSender->payloadType == pRtcRtpSender->rtxPayloadType);
-    for (i = 0; i < pPayloadArray->payloadSubLenSize; i++) {
-        pRtpPacket = pPacketList + i;
+    // Audio is small and latency sensitive, it always bypasses the pacer
+    paced = (pKvsPeerConnection->pPacer != NULL && MEDIA_STREAM_TRACK_KIND_VIDEO == pRtcRtpSender->track.kind);
+    if (!bufferAfterEncrypt && !paced) {
+        // rtx needs the plaintext, so the whole frame is encrypted into copies laid out back to back
+        for (i = 0, encryptSize = 0; i < packetCount; i++) {
+            encryptSize += RTP_GET_RAW_PACKET_SIZE(pPacketList + i) + SRTP_AUTH_TAG_OVERHEAD;
+        }
+        if (encryptSize > pRtcRtpSender->encryptBufferLen) {
+            SAFE_MEMFREE(pRtcRtpSender->pEncryptBuffer);
+            pRtcRtpSender->encryptBufferLen = 0;
+            pRtcRtpSender->pEncryptBuffer = (PBYTE) MEMALLOC(encryptSize);
+            CHK(pRtcRtpSender->pEncryptBuffer != NULL, STATUS_NOT_ENOUGH_MEMORY);
+            pRtcRtpSender->encryptBufferLen = encryptSize;
+        }
+    }
 
-        // Get the required size first
-        CHK_STATUS(rtp_packet_createBytesFromPacket(pRtpPacket, NULL, &packetLen));
+    // Serialize and encrypt the whole frame first so that it goes out with a single send call
+    for (i = 0, encryptSize = 0; i < packetCount; i++) {
+        pRtpPacket = pPacketList + i;
+        packetLen = RTP_GET_RAW_PACKET_SIZE(pRtpPacket);
 
-        // Account for SRTP authentication tag
+        // Account for SRTP authentication tag, the packet is serialized straight into the pooled packet kept by the rolling buffer
         allocSize = packetLen + SRTP_AUTH_TAG_OVERHEAD;
-        CHK(NULL != (rawPacket = (PBYTE) MEMALLOC(allocSize)), STATUS_NOT_ENOUGH_MEMORY);
-        CHK_STATUS(rtp_packet_createBytesFromPacket(pRtpPacket, rawPacket, &packetLen));
+        CHK_STATUS(rtp_packet_pool_get(pKvsPeerConnection->pRtpPacketPool, allocSize, &pSlotPacket));
+        if (pTwccValue != NULL) {
+            putUnalignedInt16BigEndian(pTwccValue, GET_UINT16_SEQ_NUM(twccSequenceNumber + i));
+        }
+        CHK_STATUS(rtp_packet_createBytesFromPacket(pRtpPacket, pSlotPacket->pRawPacket, &packetLen));
+        if (pFlexFecEncoder != NULL) {
+            CHK_STATUS(flexfec_encoder_addPacket(pFlexFecEncoder, pSlotPacket->pRawPacket, packetLen));
+        }
 
         if (!bufferAfterEncrypt) {
-            pRtpPacket->pRawPacket = rawPacket;
-            pRtpPacket->rawPacketLength = packetLen;
-            CHK_STATUS(rtp_rolling_buffer_addRtpPacket(pRtcRtpSender->packetBuffer, pRtpPacket));
+            // rtx needs the plaintext, so encrypt a copy and hand the packet over as is
+            if (paced) {
+                // the queued copy has to outlive this frame
+                CHK_STATUS(rtp_packet_pool_get(pKvsPeerConnection->pRtpPacketPool, allocSize, &ppPendingPackets[pendingCount]));
+                rawPacket = ppPendingPackets[pendingCount++]->pRawPacket;
+            } else {
+                rawPacket = pRtcRtpSender->pEncryptBuffer + encryptSize;
+                encryptSize += allocSize;
+            }
+            MEMCPY(rawPacket, pSlotPacket->pRawPacket, packetLen);
+
+            pSlotPacket->rawPacketLength = packetLen;
+            CHK_STATUS(rtp_packet_setPacketFromBytes(pSlotPacket->pRawPacket, packetLen, pSlotPacket));
+            CHK_STATUS(rtp_rolling_buffer_commitRtpPacket(pRtcRtpSender->packetBuffer, pSlotPacket));
+            pSlotPacket = NULL;
+        } else {
+            // Encrypt in place, the packet has the tailroom for the authentication tag
+            rawPacket = pSlotPacket->pRawPacket;
+            ppPendingPackets[pendingCount++] = pSlotPacket;
+            pSlotPacket = NULL;
         }
 
         CHK_STATUS(srtp_session_encryptRtpPacket(pKvsPeerConnection->pSrtpSession, rawPacket, (PINT32) &packetLen));
-        sendStatus = ice_agent_send(pKvsPeerConnection->pIceAgent, rawPacket, packetLen);
-        if (sendStatus == STATUS_NET_SEND_DATA_FAILED) {
-            packetsDiscardedOnSend++;
-            bytesDiscardedOnSend += packetLen - headerLen;
-            // TODO is frame considered discarded when at least one of its packets is discarded or all of its packets discarded?
-            framesDiscardedOnSend = 1;
-            SAFE_MEMFREE(rawPacket);
-            continue;
+        ppSendBuffers[i] = rawPacket;
+        pSendBufferLens[i] = packetLen;
+        if (bufferAfterEncrypt || paced) {
+            // The srtp header stays in the clear, so the header fields still parse
+            ppPendingPackets[i]->rawPacketLength = packetLen;
+            CHK_STATUS(rtp_packet_setPacketFromBytes(ppPendingPackets[i]->pRawPacket, packetLen, ppPendingPackets[i]));
         }
-        CHK_STATUS(sendStatus);
-        if (bufferAfterEncrypt) {
-            pRtpPacket->pRawPacket = rawPacket;
-            pRtpPacket->rawPacketLength = packetLen;
-            CHK_STATUS(rtp_rolling_buffer_addRtpPacket(pRtcRtpSender->packetBuffer, pRtpPacket));
+    }
+
+    if (paced) {
+        // The stats of the queued packets are accounted by rtp_onPacedPacketSent once they leave the pacer
+        CHK_STATUS(pacer_enqueue(pKvsPeerConnection->pPacer, (UINT64) pKvsRtpTransceiver, ppPendingPackets, pSendBufferLens, packetCount,
+                                 &queuedCount));
+    } else {
+        CHK_STATUS(ice_agent_sendBatch(pKvsPeerConnection->pIceAgent, ppSendBuffers, pSendBufferLens, packetCount, &sentCount, &discardedCount));
+        if (sentCount > 0) {
+            tmpTime = GETTIME();
+            lastPacketSentTimestamp = KVS_CONVERT_TIMESCALE(tmpTime, HUNDREDS_OF_NANOS_IN_A_SECOND, 1000);
+            for (i = 0; pTwccValue != NULL && i < sentCount; i++) {
+                CHK_LOG_ERR(twcc_manager_onPacketSent(pKvsPeerConnection->pTwccManager, GET_UINT16_SEQ_NUM(twccSequenceNumber + i),
+                                                      pSendBufferLens[i], tmpTime));
+            }
         }
+    }
+    if (pFlexFecEncoder != NULL) {
+        CHK_STATUS(rtp_sendRepairPackets(pKvsRtpTransceiver, pFlexFecEncoder, (UINT32) rtpTimestamp, paced, &fecPacketsSent));
+    }
 
-        // https://tools.ietf.org/html/rfc3550#section-6.4.1
-        // The total number of payload octets (i.e., not including header or padding) transmitted in RTP data packets by the sender
+    for (i = 0; i < packetCount; i++) {
+        pRtpPacket = pPacketList + i;
         headerLen = RTP_HEADER_LEN(pRtpPacket);
-        bytesSent += packetLen - headerLen;
-        packetsSent++;
-        lastPacketSentTimestamp = KVS_CONVERT_TIMESCALE(GETTIME(), HUNDREDS_OF_NANOS_IN_A_SECOND, 1000);
-        headerBytesSent += headerLen;
+        if (bufferAfterEncrypt) {
+            // Keep the packets which did not make it out as well, a nack can still recover them
+            CHK_STATUS(rtp_rolling_buffer_commitRtpPacket(pRtcRtpSender->packetBuffer, ppPendingPackets[i]));
+            ppPendingPackets[i] = NULL;
+        } else if (paced) {
+            // the pacer holds its own reference on the encrypted copy
+            rtp_packet_free(&ppPendingPackets[i]);
+        }
 
-        SAFE_MEMFREE(rawPacket);
+        if (i < sentCount) {
+            // https://tools.ietf.org/html/rfc3550#section-6.4.1
+            // The total number of payload octets (i.e., not including header or padding) transmitted in RTP data packets by the sender
+            bytesSent += pSendBufferLens[i] - headerLen;
+            packetsSent++;
+            headerBytesSent += headerLen;
+        } else if (paced ? i >= queuedCount : i < sentCount + discardedCount) {
+            // A frame written before a candidate pair is selected is neither sent nor discarded
+            packetsDiscardedOnSend++;
+            bytesDiscardedOnSend += pSendBufferLens[i] - headerLen;
+            // TODO is frame considered discarded when at least one of its packets is discarded or all of its packets discarded?
+            framesDiscardedOnSend = 1;
+        }
     }
 
-    if (MEDIA_STREAM_TRACK_KIND_VIDEO == pRtcRtpSender->track.kind) {
+    if (MEDIA_STREAM_TRACK_KIND_VIDEO == pRtcRtpSender->track.kind && firstEncoding) {
         framesSent++;
     }
 
@@ -368,14 +1075,18 @@ CleanUp:
         MUTEX_UNLOCK(pKvsPeerConnection->pSrtpSessionLock);
     }
     MUTEX_LOCK(pKvsRtpTransceiver->statsLock);
-    pKvsRtpTransceiver->outboundStats.totalEncodedBytesTarget += pFrame->size;
-    pKvsRtpTransceiver->outboundStats.framesEncoded += frames;
-    pKvsRtpTransceiver->outboundStats.keyFramesEncoded += keyframes;
-    if (fps > 0.0) {
-        pKvsRtpTransceiver->outboundStats.framesPerSecond = fps;
-    }
-    pRtcRtpSender->lastKnownFrameCountTime = now;
-    pRtcRtpSender->lastKnownFrameCount = pKvsRtpTransceiver->outboundStats.framesEncoded;
+    if (firstEncoding) {
+        pKvsRtpTransceiver->outboundStats.totalEncodedBytesTarget += pFrame->size;
+        pKvsRtpTransceiver->outboundStats.framesEncoded += frames;
+        pKvsRtpTransceiver->outboundStats.keyFramesEncoded += keyframes;
+        if (fps > 0.0) {
+            pKvsRtpTransceiver->outboundStats.framesPerSecond = fps;
+        }
+        pRtcRtpSender->lastKnownFrameCountTime = now;
+        pRtcRtpSender->lastKnownFrameCount = pKvsRtpTransceiver->outboundStats.framesEncoded;
+    }
+    pRtcRtpSender->packetCount += packetsSent;
+    pRtcRtpSender->octetCount += bytesSent;
     pKvsRtpTransceiver->outboundStats.sent.bytesSent += bytesSent;
     pKvsRtpTransceiver->outboundStats.sent.packetsSent += packetsSent;
     if (lastPacketSentTimestamp > 0) {
@@ -383,22 +1094,23 @@ CleanUp:
     }
     pKvsRtpTransceiver->outboundStats.headerBytesSent += headerBytesSent;
     pKvsRtpTransceiver->outboundStats.framesSent += framesSent;
-    if (pKvsRtpTransceiver->outboundStats.framesPerSecond > 0.0) {
+    pKvsRtpTransceiver->outboundStats.fecPacketsSent += fecPacketsSent;
+    if (firstEncoding && pKvsRtpTransceiver->outboundStats.framesPerSecond > 0.0) {
         if (pFrame->size >=
             pKvsRtpTransceiver->outboundStats.targetBitrate / pKvsRtpTransceiver->outboundStats.framesPerSecond * HUGE_FRAME_MULTIPLIER) {
             pKvsRtpTransceiver->outboundStats.hugeFramesSent++;
         }
     }
-    // ice_agent_send tries to send packet immediately, explicitly settings totalPacketSendDelay to 0
-    pKvsRtpTransceiver->outboundStats.totalPacketSendDelay = 0;
 
     pKvsRtpTransceiver->outboundStats.framesDiscardedOnSend += framesDiscardedOnSend;
     pKvsRtpTransceiver->outboundStats.packetsDiscardedOnSend += packetsDiscardedOnSend;
     pKvsRtpTransceiver->outboundStats.bytesDiscardedOnSend += bytesDiscardedOnSend;
     MUTEX_UNLOCK(pKvsRtpTransceiver->statsLock);
 
-    SAFE_MEMFREE(rawPacket);
-    SAFE_MEMFREE(pPacketList);
+    rtp_packet_free(&pSlotPacket);
+    for (i = 0; i < pendingCount; i++) {
+        rtp_packet_free(&ppPendingPackets[i]);
+    }
     if (retStatus != STATUS_SRTP_NOT_READY_YET) {
         CHK_LOG_ERR(retStatus);
     }
@@ -406,12 +1118,94 @@ CleanUp:
     return retStatus;
 }
 
+STATUS rtp_writeFrameAsync(PRtcRtpTransceiver pRtcRtpTransceiver, PFrame pFrame)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PKvsRtpTransceiver pKvsRtpTransceiver = (PKvsRtpTransceiver) pRtcRtpTransceiver;
+
+    CHK(pKvsRtpTransceiver != NULL && pFrame != NULL, STATUS_RTP_NULL_ARG);
+    // KvsRtcConfiguration.frameQueueSize is not set or the transceiver does not send
+    CHK(pKvsRtpTransceiver->pFrameQueue != NULL, STATUS_INVALID_OPERATION);
+    CHK_STATUS(frame_queue_enqueue(pKvsRtpTransceiver->pFrameQueue, pFrame));
+
+CleanUp:
+    CHK_LOG_ERR(retStatus);
+
+    return retStatus;
+}
+
+/**
+ * Returns the encoding of the transceiver which sends with the ssrc, either as its media or as its retransmission stream.
+ */
+static PRtcRtpSender rtp_transceiver_matchSender(PKvsRtpTransceiver pKvsRtpTransceiver, UINT32 ssrc)
+{
+    PRtcRtpSender pRtcRtpSender;
+    UINT32 i;
+
+    for (i = 0; i < rtp_transceiver_getEncodingCount(pKvsRtpTransceiver); i++) {
+        pRtcRtpSender = rtp_transceiver_getSender(pKvsRtpTransceiver, i);
+        if (pRtcRtpSender->ssrc == ssrc || pRtcRtpSender->rtxSsrc == ssrc) {
+            return pRtcRtpSender;
+        }
+    }
+
+    return NULL;
+}
+
+VOID rtp_onPacedPacketSent(UINT64 customData, PRtpPacket pRtpPacket, UINT32 packetLen, UINT64 sendDelay, BOOL sent, BOOL discarded)
+{
+    PKvsRtpTransceiver pKvsRtpTransceiver = (PKvsRtpTransceiver) customData;
+    PKvsPeerConnection pKvsPeerConnection = NULL;
+    PRtcRtpSender pRtcRtpSender = NULL;
+    UINT32 headerLen;
+    UINT16 twccSequenceNumber;
+
+    if (pKvsRtpTransceiver == NULL || pRtpPacket == NULL) {
+        return;
+    }
+    headerLen = RTP_HEADER_LEN(pRtpPacket);
+    pKvsPeerConnection = pKvsRtpTransceiver->pKvsPeerConnection;
+
+    if (sent && pKvsPeerConnection->pTwccManager != NULL && pKvsPeerConnection->extensionMap.ids[RTP_EXTENSION_TWCC] != 0 &&
+        STATUS_SUCCEEDED(
+            twcc_manager_getSequenceNumber(pRtpPacket, pKvsPeerConnection->extensionMap.ids[RTP_EXTENSION_TWCC], &twccSequenceNumber))) {
+        CHK_LOG_ERR(twcc_manager_onPacketSent(pKvsPeerConnection->pTwccManager, twccSequenceNumber, packetLen, GETTIME()));
+    }
+
+    pRtcRtpSender = rtp_transceiver_matchSender(pKvsRtpTransceiver, pRtpPacket->header.ssrc);
+
+    MUTEX_LOCK(pKvsRtpTransceiver->statsLock);
+    if (pRtpPacket->header.ssrc == pKvsRtpTransceiver->sender.fecSsrc) {
+        // The repair packets are not part of the media stream
+        if (sent) {
+            pKvsRtpTransceiver->outboundStats.fecPacketsSent++;
+        }
+    } else if (sent) {
+        if (pRtcRtpSender != NULL) {
+            pRtcRtpSender->packetCount++;
+            pRtcRtpSender->octetCount += packetLen - headerLen;
+        }
+        pKvsRtpTransceiver->outboundStats.sent.bytesSent += packetLen - headerLen;
+        pKvsRtpTransceiver->outboundStats.sent.packetsSent++;
+        pKvsRtpTransceiver->outboundStats.headerBytesSent += headerLen;
+        pKvsRtpTransceiver->outboundStats.lastPacketSentTimestamp = KVS_CONVERT_TIMESCALE(GETTIME(), HUNDREDS_OF_NANOS_IN_A_SECOND, 1000);
+        pKvsRtpTransceiver->outboundStats.totalPacketSendDelay += (DOUBLE) sendDelay / HUNDREDS_OF_NANOS_IN_A_SECOND;
+    } else if (discarded) {
+        pKvsRtpTransceiver->outboundStats.packetsDiscardedOnSend++;
+        pKvsRtpTransceiver->outboundStats.bytesDiscardedOnSend += packetLen - headerLen;
+    }
+    MUTEX_UNLOCK(pKvsRtpTransceiver->statsLock);
+}
+
 STATUS rtp_writePacket(PKvsPeerConnection pKvsPeerConnection, PRtpPacket pRtpPacket)
 {
     STATUS retStatus = STATUS_SUCCESS;
-    BOOL locked = FALSE;
-    PBYTE pRawPacket = NULL;
+    BOOL locked = FALSE, twccAssigned = FALSE;
+    PBYTE pRawPacket = NULL, pTwccValue = NULL;
     INT32 rawLen = 0;
+    RtpPacket sentPacket;
+    UINT8 twccExtId = 0, twccValueLen = 0;
+    UINT16 twccSequenceNumber = 0;
 
     CHK(pKvsPeerConnection != NULL && pRtpPacket != NULL && pRtpPacket->pRawPacket != NULL, STATUS_RTP_NULL_ARG);
 
@@ -419,10 +1213,29 @@ STATUS rtp_writePacket(PKvsPeerConnection pKvsPeerConnection, PRtpPacket pRtpPac
     locked = TRUE;
     CHK(pKvsPeerConnection->pSrtpSession != NULL, STATUS_SUCCESS);               // Discard packets till SRTP is ready
     pRawPacket = MEMALLOC(pRtpPacket->rawPacketLength + SRTP_AUTH_TAG_OVERHEAD); // For SRTP authentication tag
+    CHK(pRawPacket != NULL, STATUS_NOT_ENOUGH_MEMORY);
     rawLen = pRtpPacket->rawPacketLength;
     MEMCPY(pRawPacket, pRtpPacket->pRawPacket, pRtpPacket->rawPacketLength);
+
+    // A retransmission is a new packet on the transport, it takes the next transport-wide sequence number rather than the one
+    // of the packet it repairs, so that the feedback on both can be told apart
+    if (pKvsPeerConnection->pTwccManager != NULL) {
+        twccExtId = pKvsPeerConnection->extensionMap.ids[RTP_EXTENSION_TWCC];
+    }
+    MEMSET(&sentPacket, 0x00, SIZEOF(RtpPacket));
+    if (twccExtId != 0 && STATUS_SUCCEEDED(rtp_packet_setPacketFromBytes(pRawPacket, (UINT32) rawLen, &sentPacket)) &&
+        STATUS_SUCCEEDED(rtp_packet_getExtension(&sentPacket, twccExtId, &pTwccValue, &twccValueLen)) && twccValueLen >= SIZEOF(UINT16)) {
+        twccSequenceNumber = pKvsPeerConnection->pTwccManager->nextSequenceNumber;
+        pKvsPeerConnection->pTwccManager->nextSequenceNumber = GET_UINT16_SEQ_NUM(twccSequenceNumber + 1);
+        putUnalignedInt16BigEndian(pTwccValue, twccSequenceNumber);
+        twccAssigned = TRUE;
+    }
+
     CHK_STATUS(srtp_session_encryptRtpPacket(pKvsPeerConnection->pSrtpSession, pRawPacket, &rawLen));
     CHK_STATUS(ice_agent_send(pKvsPeerConnection->pIceAgent, pRawPacket, rawLen));
+    if (twccAssigned) {
+        CHK_LOG_ERR(twcc_manager_onPacketSent(pKvsPeerConnection->pTwccManager, twccSequenceNumber, (UINT32) rawLen, GETTIME()));
+    }
 
 CleanUp:
     if (locked) {
@@ -451,7 +1264,7 @@ STATUS rtp_transceiver_findBySsrc(PKvsPeerConnection pKvsPeerConnection, PKvsRtp
     while (pCurNode != NULL) {
         CHK_STATUS(double_list_getNodeData(pCurNode, &item));
         pTransceiver = (PKvsRtpTransceiver) item;
-        if (pTransceiver->sender.ssrc == ssrc || pTransceiver->sender.rtxSsrc == ssrc || pTransceiver->jitterBufferSsrc == ssrc) {
+        if (rtp_transceiver_matchSender(pTransceiver, ssrc) != NULL || pTransceiver->jitterBufferSsrc == ssrc) {
             break;
         }
         pTransceiver = NULL;
@@ -464,4 +1277,32 @@ CleanUp:
     CHK_LOG_ERR(retStatus);
     return retStatus;
 }
+
+STATUS rtp_transceiver_findSenderBySsrc(PKvsPeerConnection pKvsPeerConnection, UINT32 ssrc, PKvsRtpTransceiver* ppTransceiver,
+                                        PRtcRtpSender* ppRtcRtpSender)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PDoubleListNode pCurNode = NULL;
+    UINT64 item = 0;
+    PKvsRtpTransceiver pTransceiver = NULL;
+    PRtcRtpSender pRtcRtpSender = NULL;
+
+    CHK(pKvsPeerConnection != NULL && ppTransceiver != NULL && ppRtcRtpSender != NULL, STATUS_RTP_NULL_ARG);
+
+    CHK_STATUS(double_list_getHeadNode(pKvsPeerConnection->pTransceivers, &pCurNode));
+    while (pCurNode != NULL && pRtcRtpSender == NULL) {
+        CHK_STATUS(double_list_getNodeData(pCurNode, &item));
+        pTransceiver = (PKvsRtpTransceiver) item;
+        pRtcRtpSender = rtp_transceiver_matchSender(pTransceiver, ssrc);
+        pCurNode = pCurNode->pNext;
+    }
+    // Not logged, the remote ssrc of a report block is looked up first
+    CHK(pRtcRtpSender != NULL, STATUS_NOT_FOUND);
+    *ppTransceiver = pTransceiver;
+    *ppRtcRtpSender = pRtcRtpSender;
+
+CleanUp:
+
+    return retStatus;
+}
 #endif
@@ -24,10 +24,17 @@ extern "C" {
  * HEADERS
  ******************************************************************************/
 #include "RtpPacket.h"
+#include "RtpExtension.h"
 #include "RtpRollingBuffer.h"
 #include "JitterBuffer.h"
 #include "PeerConnection.h"
 #include "Retransmitter.h"
+#include "FrameQueue.h"
+#include "GopCache.h"
+#include "FlexFec.h"
+#include "NackGenerator.h"
+#include "ReceiveStatistics.h"
+#include "RtpRedPayloader.h"
 
 /******************************************************************************
  * DEFINITIONS
@@ -39,9 +46,21 @@ extern "C" {
 #define HIGHEST_EXPECTED_BIT_RATE                  (2 * 1024 * 1024) //(10 * 1024 * 1024)
 #define DEFAULT_SEQ_NUM_BUFFER_SIZE                1000
 #define DEFAULT_VALID_INDEX_BUFFER_SIZE            1000
+#define DEFAULT_ROLLING_BUFFER_CAPACITY            (DEFAULT_ROLLING_BUFFER_DURATION_IN_SECONDS * HIGHEST_EXPECTED_BIT_RATE / 8 / DEFAULT_MTU_SIZE)
 #define DEFAULT_PEER_FRAME_BUFFER_SIZE             (5 * 1024)
 #define SRTP_AUTH_TAG_OVERHEAD                     10
 
+// The room the repair packets take on top of the media packets they repair. The original sequence number a retransmission puts in front
+// of the payload, https://www.rfc-editor.org/rfc/rfc4588#section-4, and the flexfec header in front of the xor of the protected packets
+#define RTX_OSN_LEN             2
+#define RTP_REPAIR_MAX_OVERHEAD (RTX_OSN_LEN + FLEXFEC_HEADER_LEN)
+
+// Room reserved in each pooled packet for the rtp header, csrcs and header extensions
+#define RTP_PACKET_SLOT_HEADER_ROOM       64
+#define RTP_PACKET_SLOT_SIZE(payloadSize) ((payloadSize) + RTP_PACKET_SLOT_HEADER_ROOM + SRTP_AUTH_TAG_OVERHEAD)
+// Number of rtp packets of a peer connection on top of the ones reserved for the rolling buffers and jitter buffers of its transceivers
+#define DEFAULT_RTP_PACKET_POOL_SIZE 256
+
 // https://www.w3.org/TR/webrtc-stats/#dom-rtcoutboundrtpstreamstats-huge
 // Huge frames, by definition, are frames that have an encoded size at least 2.5 times the average size of the frames.
 #define HUGE_FRAME_MULTIPLIER 2.5
@@ -53,11 +72,17 @@ typedef struct {
     UINT16 rtxSequenceNumber;
     UINT32 ssrc;
     UINT32 rtxSsrc;
+    CHAR rid[MAX_RTP_STREAM_ID_LEN + 1]; // the rid of the simulcast encoding, empty without simulcast
     PayloadArray payloadArray;
 
     RtcMediaStreamTrack track;
     PRtpRollingBuffer packetBuffer;
     PRetransmitter retransmitter;
+    UINT32 fecSsrc;                  // the ssrc of the flexfec repair packets
+    PFlexFecEncoder pFlexFecEncoder; // NULL unless flexfec is negotiated, only the first encoding is protected
+    PRedEncoder pRedEncoder;         // NULL unless red is negotiated for an Opus track
+    // the header extension of the packets, the profile is 0 until rtp_transceiver_updateExtensionLayouts lays it out
+    RtpExtensionLayout extensionLayout;
 
     UINT64 rtpTimeOffset;
     UINT64 firstFrameWallClockTime; // 100ns precision
@@ -66,16 +91,43 @@ typedef struct {
     UINT64 lastKnownFrameCount;
     UINT64 lastKnownFrameCountTime; // 100ns precision
 
+    // the sender report counters of this encoding, guarded by the stats lock of the transceiver
+    UINT32 packetCount;
+    UINT32 octetCount;
+
+    // reused from frame to frame so that steady state sending does not touch the heap
+    PRtpPacket pPacketList;
+    UINT32 packetListLen;
+    // encryption scratch used when the rolling buffer keeps the plaintext packet for rtx
+    PBYTE pEncryptBuffer;
+    UINT32 encryptBufferLen;
 } RtcRtpSender, *PRtcRtpSender;
 
 typedef struct {
     RtcRtpTransceiver transceiver;
     RtcRtpSender sender;
+    RtcRtpSender simulcastSenders[MAX_SIMULCAST_ENCODING_COUNT - 1]; //!< the simulcast encodings after the first one, which is sender.
+    UINT32 simulcastEncodingCount;                                  //!< the number of rids, 0 without simulcast.
+    BOOL simulcastNegotiated;                                       //!< the remote peer receives every encoding with the rid extension.
+    CHAR mid[MAX_RTP_STREAM_ID_LEN + 1];                            //!< the mid of the media section of the transceiver.
 
     PKvsPeerConnection pKvsPeerConnection;
 
     UINT32 jitterBufferSsrc;
     PJitterBuffer pJitterBuffer;
+    UINT32 remoteFecSsrc;              //!< the ssrc of the repair packets of the remote peer, from its FEC-FR ssrc group.
+    PFlexFecReceiver pFlexFecReceiver; //!< NULL unless flexfec is negotiated and the remote peer sends repair packets.
+    PRedBlock pRedBlocks;              //!< the blocks of the red packet of the remote peer being split, kept from packet to packet.
+    UINT32 redBlockCapacity;           //!< the number of blocks pRedBlocks holds.
+    UINT32 remoteRtxSsrc;              //!< the ssrc of the retransmissions of the remote peer, from its FID ssrc group.
+    BOOL remoteAcceptsNack;            //!< the remote peer takes generic nacks for the media section.
+    PNackGenerator pNackGenerator;     //!< NULL unless the remote peer takes nacks, asks for the packets lost on the way in.
+    BOOL remoteAcceptsPli;             //!< the remote peer takes picture loss indications, a=rtcp-fb:<payload type> nack pli
+    BOOL remoteAcceptsFir;             //!< the remote peer takes full intra requests, a=rtcp-fb:<payload type> ccm fir
+    UINT64 lastKeyFrameRequestTime;    //!< when a key frame was last asked for in 100ns, 0 before the first request.
+    UINT8 firSequenceNumber;           //!< the command sequence number of the last full intra request.
+    BOOL frameChainStarted;            //!< whether a frame came out of the jitter buffer, nextFrameStartIndex is valid.
+    UINT16 nextFrameStartIndex;        //!< the sequence number the next frame out of the jitter buffer starts at if nothing is lost.
 
     UINT64 onFrameCustomData;
     RtcOnFrame onFrame;
@@ -90,7 +142,11 @@ typedef struct {
 
     UINT32 rtcpReportsTimerId;
 
+    PFrameQueue pFrameQueue; //!< the frames of rtp_writeFrameAsync, NULL unless KvsRtcConfiguration.frameQueueSize is set.
+    PGopCache pGopCache;     //!< the gop of the first encoding until the srtp session is up, NULL unless KvsRtcConfiguration.enableGopCache is set.
+
     MUTEX statsLock;
+    ReceiveStatistics receiveStatistics; //!< the reception of jitterBufferSsrc for the receiver report blocks, guarded by statsLock.
     RtcOutboundRtpStreamStats outboundStats;
     RtcRemoteInboundRtpStreamStats remoteInboundStats;
     RtcInboundRtpStreamStats inboundStats;
@@ -103,13 +159,114 @@ STATUS rtp_createTransceiver(RTC_RTP_TRANSCEIVER_DIRECTION, PKvsPeerConnection,
 STATUS rtp_transceiver_free(PKvsRtpTransceiver*);
 
 STATUS rtp_transceiver_setJitterBuffer(PKvsRtpTransceiver, PJitterBuffer);
+/**
+ * @brief the number of encodings the transceiver sends, 1 without simulcast.
+ */
+UINT32 rtp_transceiver_getEncodingCount(PKvsRtpTransceiver);
+/**
+ * @brief the sender of an encoding, sender for the first one.
+ *
+ * @return the sender, NULL if the index is out of range.
+ */
+PRtcRtpSender rtp_transceiver_getSender(PKvsRtpTransceiver, UINT32);
+/**
+ * @brief create the frame queue of rtp_writeFrameAsync and start its worker.
+ *
+ * @param[in] pKvsRtpTransceiver the transceiver.
+ * @param[in] queueSize the max number of queued frames.
+ * @param[in] dropPolicy the drop policy of video transceivers, audio transceivers always drop the oldest frame.
+ *
+ * @return STATUS status of execution
+ */
+STATUS rtp_transceiver_createFrameQueue(PKvsRtpTransceiver, UINT32, FRAME_QUEUE_DROP_POLICY);
+/**
+ * @brief create the gop cache of a video transceiver, its first encoding then keeps the frames since the last key frame until
+ *        rtp_transceiver_flushGopCache.
+ *
+ * @param[in] pKvsRtpTransceiver the transceiver.
+ * @param[in] maxByteCount the max frame bytes of the cached gop.
+ *
+ * @return STATUS status of execution
+ */
+STATUS rtp_transceiver_createGopCache(PKvsRtpTransceiver, UINT32);
+/**
+ * @brief replace the cached frames of a transceiver with the gop of the source it joined, and send them right away if the srtp session
+ *        is already up. A transceiver without a gop cache is left as it is. Called without the srtp session lock held.
+ *
+ * @param[in] pKvsRtpTransceiver the transceiver.
+ * @param[in] pSourceGopCache the gop cache of the source.
+ *
+ * @return STATUS status of execution
+ */
+STATUS rtp_transceiver_seedGopCache(PKvsRtpTransceiver, PGopCache);
+/**
+ * @brief send the cached gop once the srtp session is up, with the sequence numbers following on from the sender and the timestamps
+ *        squeezed in front of the newest cached frame so that the remote peer shows it right away. The frames are taken out of the cache
+ *        under its lock and sent without it, the frames written meanwhile are cached and sent behind them. The frames are written as
+ *        they come from then on. Called without the srtp session lock held.
+ *
+ * @param[in] pKvsRtpTransceiver the transceiver.
+ *
+ * @return STATUS status of execution
+ */
+STATUS rtp_transceiver_flushGopCache(PKvsRtpTransceiver);
 
 #define CONVERT_TIMESTAMP_TO_RTP(clockRate, pts) (pts * clockRate / HUNDREDS_OF_NANOS_IN_A_SECOND)
 
+/**
+ * @brief the largest rtp payload which keeps the packets of the peer connection within its mtu, along with the retransmissions and the
+ *        flexfec repair packets made of them.
+ */
+UINT32 rtp_getPayloadMtu(PKvsPeerConnection);
+/**
+ * @brief the largest rtp payload which keeps the packets of an encoding within the mtu along with its header extension and its repair
+ *        packets, rtp_getPayloadMtu until the header extension is laid out.
+ */
+UINT32 rtp_transceiver_getPayloadMtu(PKvsRtpTransceiver, PRtcRtpSender);
+/**
+ * @brief lay out the header extension of every encoding of the transceiver from the negotiated ids, so that the packets only patch the
+ *        transport-wide sequence number. Called once the local and the remote descriptions are both known.
+ *
+ * @param[in] pKvsRtpTransceiver the transceiver.
+ *
+ * @return STATUS status of execution
+ */
+STATUS rtp_transceiver_updateExtensionLayouts(PKvsRtpTransceiver);
+/**
+ * @brief split a frame into rtp payloads with the payloader of the codec.
+ *
+ * @param[in] codec the codec of the frame.
+ * @param[in] mtu the max payload size, see rtp_getPayloadMtu.
+ * @param[in] pFrame the frame.
+ * @param[in, out] pPayloadArray the payloads, its buffers grow as needed and are kept for the next frame.
+ *
+ * @return STATUS status of execution
+ */
+STATUS rtp_packetizeFrame(RTC_CODEC, UINT32, PFrame, PPayloadArray);
+/**
+ * @brief rtp_writeFrame with the payloads of the frame created up front by rtp_packetizeFrame, so that they can be shared by several senders.
+ *
+ * @param[in] pRtcRtpTransceiver the transceiver.
+ * @param[in] pFrame the frame, its data is only used when pPayloadArray is NULL or the frame goes into the gop cache.
+ * @param[in] pPayloadArray the payloads of the frame, the frame is packetized into the payload array of the sender if NULL.
+ *
+ * @return STATUS status of execution
+ */
+STATUS rtp_writePayloadArray(PRtcRtpTransceiver, PFrame, PPayloadArray);
 STATUS rtp_writePacket(PKvsPeerConnection pKvsPeerConnection, PRtpPacket pRtpPacket);
+/**
+ * @brief PacerOnPacketSentFunc of the peer connection pacer, accounts a paced packet in the outbound stats of its transceiver.
+ */
+VOID rtp_onPacedPacketSent(UINT64, PRtpPacket, UINT32, UINT64, BOOL, BOOL);
 
 STATUS rtp_findTransceiverByssrc(PKvsPeerConnection pKvsPeerConnection, UINT32 ssrc);
 STATUS rtp_transceiver_findBySsrc(PKvsPeerConnection pKvsPeerConnection, PKvsRtpTransceiver* ppTransceiver, UINT32 ssrc);
+/**
+ * @brief find the transceiver and the encoding which sends the media or the retransmissions of a ssrc.
+ *
+ * @return STATUS_NOT_FOUND if no encoding sends with the ssrc.
+ */
+STATUS rtp_transceiver_findSenderBySsrc(PKvsPeerConnection, UINT32, PKvsRtpTransceiver*, PRtcRtpSender*);
 
 #ifdef __cplusplus
 }
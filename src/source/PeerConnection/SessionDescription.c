@@ -9,7 +9,9 @@
 #endif
 #include "jsmn.h"
 
-#define VIDEO_SUPPPORT_TYPE(codec) (codec == RTC_CODEC_VP8 || codec == RTC_CODEC_H264_PROFILE_42E01F_LEVEL_ASYMMETRY_ALLOWED_PACKETIZATION_MODE)
+#define VIDEO_SUPPPORT_TYPE(codec)                                                                                                                   \
+    (codec == RTC_CODEC_VP8 || codec == RTC_CODEC_H264_PROFILE_42E01F_LEVEL_ASYMMETRY_ALLOWED_PACKETIZATION_MODE || codec == RTC_CODEC_H265 ||        \
+     codec == RTC_CODEC_AV1)
 #define AUDIO_SUPPORT_TYPE(codec)  (codec == RTC_CODEC_MULAW || codec == RTC_CODEC_ALAW || codec == RTC_CODEC_OPUS)
 
 STATUS sdp_serializeInit(PRtcSessionDescriptionInit pSessionDescriptionInit, PCHAR sessionDescriptionJSON, PUINT32 sessionDescriptionJSONLen)
@@ -156,11 +158,41 @@ STATUS sdp_setPayloadTypesForOffer(PHashTable codecTable)
     CHK_STATUS(hashTableUpsert(codecTable, RTC_CODEC_VP8, DEFAULT_PAYLOAD_VP8));
     CHK_STATUS(hashTableUpsert(codecTable, RTC_CODEC_OPUS, DEFAULT_PAYLOAD_OPUS));
     CHK_STATUS(hashTableUpsert(codecTable, RTC_CODEC_H264_PROFILE_42E01F_LEVEL_ASYMMETRY_ALLOWED_PACKETIZATION_MODE, DEFAULT_PAYLOAD_H264));
+    CHK_STATUS(hashTableUpsert(codecTable, RTC_CODEC_H265, DEFAULT_PAYLOAD_H265));
+    CHK_STATUS(hashTableUpsert(codecTable, RTC_CODEC_AV1, DEFAULT_PAYLOAD_AV1));
 
 CleanUp:
     return retStatus;
 }
 
+/*
+ * The rtx table is keyed by the codec the retransmissions are for
+ */
+static STATUS sdp_getRtxCodec(RTC_CODEC codec, RTX_CODEC* pRtxCodec)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+
+    switch (codec) {
+        case RTC_CODEC_H264_PROFILE_42E01F_LEVEL_ASYMMETRY_ALLOWED_PACKETIZATION_MODE:
+            *pRtxCodec = RTC_RTX_CODEC_H264_PROFILE_42E01F_LEVEL_ASYMMETRY_ALLOWED_PACKETIZATION_MODE;
+            break;
+        case RTC_CODEC_VP8:
+            *pRtxCodec = RTC_RTX_CODEC_VP8;
+            break;
+        case RTC_CODEC_H265:
+            *pRtxCodec = RTC_RTX_CODEC_H265;
+            break;
+        case RTC_CODEC_AV1:
+            *pRtxCodec = RTC_RTX_CODEC_AV1;
+            break;
+        default:
+            // Audio is not retransmitted with rtx
+            retStatus = STATUS_NOT_FOUND;
+    }
+
+    return retStatus;
+}
+
 STATUS sdp_setPayloadTypesFromOffer(PHashTable codecTable, PHashTable rtxTable, PSessionDescription pSessionDescription)
 {
     ENTERS();
@@ -204,6 +236,12 @@ STATUS sdp_setPayloadTypesFromOffer(PHashTable codecTable, PHashTable rtxTable,
                 CHK_STATUS(STRTOUI64(attributeValue, end - 1, 10, &parsedPayloadType));
                 CHK_STATUS(hashTableUpsert(codecTable, RTC_CODEC_H264_PROFILE_42E01F_LEVEL_ASYMMETRY_ALLOWED_PACKETIZATION_MODE, parsedPayloadType));
             }
+            // #video.
+            CHK_STATUS(hash_table_contains(codecTable, RTC_CODEC_H265, &supportCodec));
+            if (supportCodec && (end = STRSTR(attributeValue, H265_VALUE)) != NULL) {
+                CHK_STATUS(STRTOUI64(attributeValue, end - 1, 10, &parsedPayloadType));
+                CHK_STATUS(hashTableUpsert(codecTable, RTC_CODEC_H265, parsedPayloadType));
+            }
             // #audio.
             CHK_STATUS(hash_table_contains(codecTable, RTC_CODEC_OPUS, &supportCodec));
             if (supportCodec && (end = STRSTR(attributeValue, OPUS_VALUE)) != NULL) {
@@ -216,6 +254,12 @@ STATUS sdp_setPayloadTypesFromOffer(PHashTable codecTable, PHashTable rtxTable,
                 CHK_STATUS(STRTOUI64(attributeValue, end - 1, 10, &parsedPayloadType));
                 CHK_STATUS(hashTableUpsert(codecTable, RTC_CODEC_VP8, parsedPayloadType));
             }
+            // #video.
+            CHK_STATUS(hash_table_contains(codecTable, RTC_CODEC_AV1, &supportCodec));
+            if (supportCodec && (end = STRSTR(attributeValue, AV1_VALUE)) != NULL) {
+                CHK_STATUS(STRTOUI64(attributeValue, end - 1, 10, &parsedPayloadType));
+                CHK_STATUS(hashTableUpsert(codecTable, RTC_CODEC_AV1, parsedPayloadType));
+            }
             // #audio
             CHK_STATUS(hash_table_contains(codecTable, RTC_CODEC_MULAW, &supportCodec));
             if (supportCodec && (end = STRSTR(attributeValue, MULAW_VALUE)) != NULL) {
@@ -252,6 +296,22 @@ STATUS sdp_setPayloadTypesFromOffer(PHashTable codecTable, PHashTable rtxTable,
                             CHK_STATUS(hashTableUpsert(rtxTable, RTC_RTX_CODEC_VP8, rtxPayloadType));
                         }
                     }
+
+                    CHK_STATUS(hash_table_contains(codecTable, RTC_CODEC_H265, &supportCodec));
+                    if (supportCodec) {
+                        CHK_STATUS(hash_table_get(codecTable, RTC_CODEC_H265, &hashmapPayloadType));
+                        if (parsedPayloadType == hashmapPayloadType) {
+                            CHK_STATUS(hashTableUpsert(rtxTable, RTC_RTX_CODEC_H265, rtxPayloadType));
+                        }
+                    }
+
+                    CHK_STATUS(hash_table_contains(codecTable, RTC_CODEC_AV1, &supportCodec));
+                    if (supportCodec) {
+                        CHK_STATUS(hash_table_get(codecTable, RTC_CODEC_AV1, &hashmapPayloadType));
+                        if (parsedPayloadType == hashmapPayloadType) {
+                            CHK_STATUS(hashTableUpsert(rtxTable, RTC_RTX_CODEC_AV1, rtxPayloadType));
+                        }
+                    }
                 }
             }
         }
@@ -263,13 +323,16 @@ CleanUp:
     return retStatus;
 }
 
-STATUS sdp_setTransceiverPayloadTypes(PHashTable codecTable, PHashTable rtxTable, PDoubleList pTransceivers)
+STATUS sdp_setTransceiverPayloadTypes(PHashTable codecTable, PHashTable rtxTable, PRtpPacketPool pRtpPacketPool, PDoubleList pTransceivers)
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
     PDoubleListNode pCurNode = NULL;
     PKvsRtpTransceiver pKvsRtpTransceiver;
+    PRtcRtpSender pRtcRtpSender;
+    RTX_CODEC rtxCodec;
     UINT64 data;
+    UINT32 i;
 
     // Loop over Transceivers and set the payloadType (which what we got from the other side)
     // If a codec we want to send wasn't supported by the other return an error
@@ -279,22 +342,26 @@ STATUS sdp_setTransceiverPayloadTypes(PHashTable codecTable, PHashTable rtxTable
         pCurNode = pCurNode->pNext;
         pKvsRtpTransceiver = (PKvsRtpTransceiver) data;
 
-        if (pKvsRtpTransceiver != NULL &&
-            (pKvsRtpTransceiver->transceiver.direction == RTC_RTP_TRANSCEIVER_DIRECTION_SENDRECV ||
-             pKvsRtpTransceiver->transceiver.direction == RTC_RTP_TRANSCEIVER_DIRECTION_SENDONLY)) {
-            CHK_STATUS(hash_table_get(codecTable, pKvsRtpTransceiver->sender.track.codec, &data));
-            pKvsRtpTransceiver->sender.payloadType = (UINT8) data;
-            pKvsRtpTransceiver->sender.rtxPayloadType = (UINT8) data;
-
-            // NACKs may have distinct PayloadTypes, look in the rtxTable and check. Otherwise NACKs will just be re-sending the same seqnum
-            if (hash_table_get(rtxTable, pKvsRtpTransceiver->sender.track.codec, &data) == STATUS_SUCCESS) {
-                pKvsRtpTransceiver->sender.rtxPayloadType = (UINT8) data;
+        // The simulcast encodings share the codec of the transceiver, each of them resends from its own buffer
+        for (i = 0; i < rtp_transceiver_getEncodingCount(pKvsRtpTransceiver); i++) {
+            pRtcRtpSender = rtp_transceiver_getSender(pKvsRtpTransceiver, i);
+            if (pKvsRtpTransceiver->transceiver.direction == RTC_RTP_TRANSCEIVER_DIRECTION_SENDRECV ||
+                pKvsRtpTransceiver->transceiver.direction == RTC_RTP_TRANSCEIVER_DIRECTION_SENDONLY) {
+                CHK_STATUS(hash_table_get(codecTable, pRtcRtpSender->track.codec, &data));
+                pRtcRtpSender->payloadType = (UINT8) data;
+                pRtcRtpSender->rtxPayloadType = (UINT8) data;
+
+                // NACKs may have distinct PayloadTypes, look in the rtxTable and check. Otherwise NACKs will just be re-sending the same seqnum
+                if (sdp_getRtxCodec(pRtcRtpSender->track.codec, &rtxCodec) == STATUS_SUCCESS &&
+                    hash_table_get(rtxTable, rtxCodec, &data) == STATUS_SUCCESS) {
+                    pRtcRtpSender->rtxPayloadType = (UINT8) data;
+                }
             }
-        }
 
-        CHK_STATUS(rtp_rolling_buffer_create(DEFAULT_ROLLING_BUFFER_DURATION_IN_SECONDS * HIGHEST_EXPECTED_BIT_RATE / 8 / DEFAULT_MTU_SIZE,
-                                             &pKvsRtpTransceiver->sender.packetBuffer));
-        CHK_STATUS(retransmitter_create(DEFAULT_SEQ_NUM_BUFFER_SIZE, DEFAULT_VALID_INDEX_BUFFER_SIZE, &pKvsRtpTransceiver->sender.retransmitter));
+            CHK_STATUS(rtp_rolling_buffer_create(DEFAULT_ROLLING_BUFFER_CAPACITY, &pRtcRtpSender->packetBuffer));
+            CHK_STATUS(rtp_packet_pool_reserve(pRtpPacketPool, DEFAULT_ROLLING_BUFFER_CAPACITY));
+            CHK_STATUS(retransmitter_create(DEFAULT_SEQ_NUM_BUFFER_SIZE, DEFAULT_VALID_INDEX_BUFFER_SIZE, &pRtcRtpSender->retransmitter));
+        }
     }
 
 CleanUp:
@@ -326,6 +393,40 @@ PCHAR sdp_fmtpForPayloadType(UINT64 payloadType, PSessionDescription pSessionDes
     return NULL;
 }
 
+/**
+ * Whether a remote media section receives every simulcast encoding of the transceiver, https://www.rfc-editor.org/rfc/rfc8853
+ */
+static BOOL sdp_receivesSimulcast(PSdpMediaDescription pMediaDescription, PKvsRtpTransceiver pKvsRtpTransceiver)
+{
+    UINT32 i, j, ridLen;
+    PCHAR rid, pValue;
+    BOOL simulcastFound = FALSE, ridFound = TRUE;
+
+    if (pMediaDescription == NULL || pKvsRtpTransceiver == NULL || pKvsRtpTransceiver->simulcastEncodingCount == 0) {
+        return FALSE;
+    }
+
+    // a=simulcast:recv <rid-id>;<rid-id>
+    for (i = 0; i < pMediaDescription->mediaAttributesCount && !simulcastFound; i++) {
+        simulcastFound = STRCMP(pMediaDescription->sdpAttributes[i].attributeName, "simulcast") == 0 &&
+            STRSTR(pMediaDescription->sdpAttributes[i].attributeValue, "recv") != NULL;
+    }
+
+    // a=rid:<rid-id> recv [<rid-params>], for every encoding
+    for (j = 0; j < pKvsRtpTransceiver->simulcastEncodingCount && simulcastFound && ridFound; j++) {
+        rid = rtp_transceiver_getSender(pKvsRtpTransceiver, j)->rid;
+        ridLen = (UINT32) STRLEN(rid);
+        ridFound = FALSE;
+        for (i = 0; i < pMediaDescription->mediaAttributesCount && !ridFound; i++) {
+            pValue = pMediaDescription->sdpAttributes[i].attributeValue;
+            ridFound = STRCMP(pMediaDescription->sdpAttributes[i].attributeName, "rid") == 0 && STRNCMP(pValue, rid, ridLen) == 0 &&
+                pValue[ridLen] == ' ' && STRNCMP(pValue + ridLen + 1, "recv", SIZEOF("recv") - 1) == 0;
+        }
+    }
+
+    return simulcastFound && ridFound;
+}
+
 // Populate a single media section from a PKvsRtpTransceiver
 STATUS sdp_populateSingleMediaSection(PKvsPeerConnection pKvsPeerConnection, PKvsRtpTransceiver pKvsRtpTransceiver,
                                       PSdpMediaDescription pSdpMediaDescription, PSessionDescription pRemoteSessionDescription,
@@ -335,25 +436,25 @@ STATUS sdp_populateSingleMediaSection(PKvsPeerConnection pKvsPeerConnection, PKv
     STATUS retStatus = STATUS_SUCCESS;
     UINT64 payloadType, rtxPayloadType;
     BOOL containRtx = FALSE;
-    BOOL directionFound = FALSE;
-    UINT32 i, remoteAttributeCount, attributeCount = 0;
+    BOOL directionFound = FALSE, twccNegotiated = FALSE, offerSimulcast = FALSE, flexFecNegotiated = FALSE, redNegotiated = FALSE;
+    UINT32 i, remoteAttributeCount, attributeCount = 0, mediaNameLen;
+    PCHAR pCurr;
+    INT32 written;
+    UINT32 sizeRemaining;
     PRtcMediaStreamTrack pRtcMediaStreamTrack = &(pKvsRtpTransceiver->sender.track);
-    PSdpMediaDescription pSdpMediaDescriptionRemote;
+    PSdpMediaDescription pSdpMediaDescriptionRemote = NULL;
     PCHAR currentFmtp = NULL;
+    RTX_CODEC rtxCodec;
+    PUINT8 pExtIds = pKvsPeerConnection->extensionMap.ids;
 
     CHK_STATUS(hash_table_get(pKvsPeerConnection->pCodecTable, pRtcMediaStreamTrack->codec, &payloadType));
     // get the payload type of audio or video.
     currentFmtp = sdp_fmtpForPayloadType(payloadType, &(pKvsPeerConnection->remoteSessionDescription));
     // video
-    if (pRtcMediaStreamTrack->codec == RTC_CODEC_H264_PROFILE_42E01F_LEVEL_ASYMMETRY_ALLOWED_PACKETIZATION_MODE ||
-        pRtcMediaStreamTrack->codec == RTC_CODEC_VP8) {
+    if (VIDEO_SUPPPORT_TYPE(pRtcMediaStreamTrack->codec)) {
         // get the payload type from rtx table.
-        if (pRtcMediaStreamTrack->codec == RTC_CODEC_H264_PROFILE_42E01F_LEVEL_ASYMMETRY_ALLOWED_PACKETIZATION_MODE) {
-            retStatus = hash_table_get(pKvsPeerConnection->pRtxTable, RTC_RTX_CODEC_H264_PROFILE_42E01F_LEVEL_ASYMMETRY_ALLOWED_PACKETIZATION_MODE,
-                                       &rtxPayloadType);
-        } else {
-            retStatus = hash_table_get(pKvsPeerConnection->pRtxTable, RTC_RTX_CODEC_VP8, &rtxPayloadType);
-        }
+        CHK_STATUS(sdp_getRtxCodec(pRtcMediaStreamTrack->codec, &rtxCodec));
+        retStatus = hash_table_get(pKvsPeerConnection->pRtxTable, rtxCodec, &rtxPayloadType);
         CHK(retStatus == STATUS_SUCCESS || retStatus == STATUS_HASH_KEY_NOT_PRESENT, retStatus);
         containRtx = (retStatus == STATUS_SUCCESS);
         retStatus = STATUS_SUCCESS;
@@ -363,10 +464,28 @@ STATUS sdp_populateSingleMediaSection(PKvsPeerConnection pKvsPeerConnection, PKv
         } else {
             SNPRINTF(pSdpMediaDescription->mediaName, MAX_SDP_MEDIA_NAME_LENGTH, "video 9 UDP/TLS/RTP/SAVPF %" PRId64, payloadType);
         }
+        // the answer only protects the media sections the offer protects
+        flexFecNegotiated = pKvsPeerConnection->flexFecPayloadType != 0 &&
+            (pKvsPeerConnection->isOffer ||
+             sdp_getFlexFecPayloadType(&pRemoteSessionDescription->mediaDescriptions[mediaSectionId]) == pKvsPeerConnection->flexFecPayloadType);
+        if (flexFecNegotiated) {
+            mediaNameLen = (UINT32) STRLEN(pSdpMediaDescription->mediaName);
+            SNPRINTF(pSdpMediaDescription->mediaName + mediaNameLen, MAX_SDP_MEDIA_NAME_LENGTH - mediaNameLen, " %u",
+                     pKvsPeerConnection->flexFecPayloadType);
+        }
         // audio
     } else if (pRtcMediaStreamTrack->codec == RTC_CODEC_OPUS || pRtcMediaStreamTrack->codec == RTC_CODEC_MULAW ||
                pRtcMediaStreamTrack->codec == RTC_CODEC_ALAW) {
         SNPRINTF(pSdpMediaDescription->mediaName, MAX_SDP_MEDIA_NAME_LENGTH, "audio 9 UDP/TLS/RTP/SAVPF %" PRId64, payloadType);
+        // Listed after Opus, so that Opus stays the preferred codec of a peer which does not send red
+        redNegotiated = pRtcMediaStreamTrack->codec == RTC_CODEC_OPUS && pKvsPeerConnection->redPayloadType != 0 &&
+            (pKvsPeerConnection->isOffer ||
+             sdp_getRedPayloadType(&pRemoteSessionDescription->mediaDescriptions[mediaSectionId], payloadType) == pKvsPeerConnection->redPayloadType);
+        if (redNegotiated) {
+            mediaNameLen = (UINT32) STRLEN(pSdpMediaDescription->mediaName);
+            SNPRINTF(pSdpMediaDescription->mediaName + mediaNameLen, MAX_SDP_MEDIA_NAME_LENGTH - mediaNameLen, " %u",
+                     pKvsPeerConnection->redPayloadType);
+        }
     }
     // get the information of ice candidates.
     CHK_STATUS(ice_agent_populateSdpMediaDescriptionCandidates(pKvsPeerConnection->pIceAgent, pSdpMediaDescription, MAX_SDP_ATTRIBUTE_VALUE_LENGTH,
@@ -390,6 +509,13 @@ STATUS sdp_populateSingleMediaSection(PKvsPeerConnection pKvsPeerConnection, PKv
         attributeCount++;
     }
 
+    if (flexFecNegotiated) {
+        STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeName, "ssrc-group", MAX_SDP_ATTRIBUTE_NAME_LENGTH);
+        SNPRINTF(pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue, MAX_SDP_ATTRIBUTE_VALUE_LENGTH, "FEC-FR %u %u",
+                 pKvsRtpTransceiver->sender.ssrc, pKvsRtpTransceiver->sender.fecSsrc);
+        attributeCount++;
+    }
+
     STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeName, "ssrc", MAX_SDP_ATTRIBUTE_NAME_LENGTH);
     SNPRINTF(pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue, MAX_SDP_ATTRIBUTE_VALUE_LENGTH, "%u cname:%s",
              pKvsRtpTransceiver->sender.ssrc, pKvsPeerConnection->localCNAME);
@@ -432,6 +558,18 @@ STATUS sdp_populateSingleMediaSection(PKvsPeerConnection pKvsPeerConnection, PKv
         attributeCount++;
     }
 
+    if (flexFecNegotiated) {
+        STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeName, "ssrc", MAX_SDP_ATTRIBUTE_NAME_LENGTH);
+        SNPRINTF(pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue, MAX_SDP_ATTRIBUTE_VALUE_LENGTH, "%u cname:%s",
+                 pKvsRtpTransceiver->sender.fecSsrc, pKvsPeerConnection->localCNAME);
+        attributeCount++;
+
+        STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeName, "ssrc", MAX_SDP_ATTRIBUTE_NAME_LENGTH);
+        SNPRINTF(pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue, MAX_SDP_ATTRIBUTE_VALUE_LENGTH, "%u msid:%s %s",
+                 pKvsRtpTransceiver->sender.fecSsrc, pRtcMediaStreamTrack->streamId, pRtcMediaStreamTrack->trackId);
+        attributeCount++;
+    }
+
     STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeName, "rtcp", MAX_SDP_ATTRIBUTE_NAME_LENGTH);
     STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue, "9 IN IP4 0.0.0.0", MAX_SDP_ATTRIBUTE_VALUE_LENGTH);
     attributeCount++;
@@ -459,6 +597,8 @@ STATUS sdp_populateSingleMediaSection(PKvsPeerConnection pKvsPeerConnection, PKv
 
     STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeName, "mid", MAX_SDP_ATTRIBUTE_NAME_LENGTH);
     SNPRINTF(pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue, MAX_SDP_ATTRIBUTE_VALUE_LENGTH, "%d", mediaSectionId);
+    // The simulcast encodings carry the mid of their media section in the sdes:mid extension
+    STRNCPY(pKvsRtpTransceiver->mid, pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue, MAX_RTP_STREAM_ID_LEN);
     attributeCount++;
     // setup the direction of offer.
     if (pKvsPeerConnection->isOffer) {
@@ -498,6 +638,56 @@ STATUS sdp_populateSingleMediaSection(PKvsPeerConnection pKvsPeerConnection, PKv
 
     attributeCount++;
 
+    // the answer only carries the extensions of the offer
+    twccNegotiated = pExtIds[RTP_EXTENSION_TWCC] != 0 &&
+        (pKvsPeerConnection->isOffer || sdp_getExtmapId(pSdpMediaDescriptionRemote, TWCC_EXT_URL) == pExtIds[RTP_EXTENSION_TWCC]);
+    if (twccNegotiated) {
+        STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeName, "extmap", MAX_SDP_ATTRIBUTE_NAME_LENGTH);
+        SNPRINTF(pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue, MAX_SDP_ATTRIBUTE_VALUE_LENGTH, "%u %s",
+                 pExtIds[RTP_EXTENSION_TWCC], TWCC_EXT_URL);
+        attributeCount++;
+    }
+
+    // these are only read from received packets, so they are accepted when offered but never offered
+    for (i = RTP_EXTENSION_ABS_SEND_TIME; !pKvsPeerConnection->isOffer && i < RTP_EXTENSION_COUNT; i++) {
+        if (pExtIds[i] != 0 && sdp_getExtmapId(pSdpMediaDescriptionRemote, rtp_extension_getUri((RTP_EXTENSION) i)) == pExtIds[i]) {
+            STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeName, "extmap", MAX_SDP_ATTRIBUTE_NAME_LENGTH);
+            SNPRINTF(pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue, MAX_SDP_ATTRIBUTE_VALUE_LENGTH, "%u %s", pExtIds[i],
+                     rtp_extension_getUri((RTP_EXTENSION) i));
+            attributeCount++;
+        }
+    }
+
+    // https://www.rfc-editor.org/rfc/rfc8853 the offer proposes every encoding, the answer only sends them if the offer receives every rid
+    if (pKvsPeerConnection->isOffer) {
+        offerSimulcast = pKvsRtpTransceiver->simulcastEncodingCount > 0 && pExtIds[RTP_EXTENSION_RID] != 0;
+    } else {
+        pKvsRtpTransceiver->simulcastNegotiated = pKvsRtpTransceiver->simulcastEncodingCount > 0 && pExtIds[RTP_EXTENSION_RID] != 0 &&
+            sdp_getExtmapId(pSdpMediaDescriptionRemote, RID_EXT_URL) == pExtIds[RTP_EXTENSION_RID] &&
+            sdp_receivesSimulcast(pSdpMediaDescriptionRemote, pKvsRtpTransceiver);
+        offerSimulcast = pKvsRtpTransceiver->simulcastNegotiated;
+    }
+    if (offerSimulcast) {
+        if (pExtIds[RTP_EXTENSION_MID] != 0) {
+            STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeName, "extmap", MAX_SDP_ATTRIBUTE_NAME_LENGTH);
+            SNPRINTF(pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue, MAX_SDP_ATTRIBUTE_VALUE_LENGTH, "%u %s",
+                     pExtIds[RTP_EXTENSION_MID], MID_EXT_URL);
+            attributeCount++;
+        }
+
+        STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeName, "extmap", MAX_SDP_ATTRIBUTE_NAME_LENGTH);
+        SNPRINTF(pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue, MAX_SDP_ATTRIBUTE_VALUE_LENGTH, "%u %s",
+                 pExtIds[RTP_EXTENSION_RID], RID_EXT_URL);
+        attributeCount++;
+
+        if (containRtx && pExtIds[RTP_EXTENSION_RRID] != 0) {
+            STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeName, "extmap", MAX_SDP_ATTRIBUTE_NAME_LENGTH);
+            SNPRINTF(pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue, MAX_SDP_ATTRIBUTE_VALUE_LENGTH, "%u %s",
+                     pExtIds[RTP_EXTENSION_RRID], RRID_EXT_URL);
+            attributeCount++;
+        }
+    }
+
     STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeName, "rtcp-mux", MAX_SDP_ATTRIBUTE_NAME_LENGTH);
     attributeCount++;
 
@@ -520,6 +710,33 @@ STATUS sdp_populateSingleMediaSection(PKvsPeerConnection pKvsPeerConnection, PKv
             attributeCount++;
         }
 
+        if (containRtx) {
+            STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeName, "rtpmap", MAX_SDP_ATTRIBUTE_NAME_LENGTH);
+            SNPRINTF(pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue, MAX_SDP_ATTRIBUTE_VALUE_LENGTH, "%" PRId64 " " RTX_VALUE,
+                     rtxPayloadType);
+            attributeCount++;
+
+            STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeName, "fmtp", MAX_SDP_ATTRIBUTE_NAME_LENGTH);
+            SNPRINTF(pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue, MAX_SDP_ATTRIBUTE_VALUE_LENGTH,
+                     "%" PRId64 " apt=%" PRId64 "", rtxPayloadType, payloadType);
+            attributeCount++;
+        }
+    } else if (pRtcMediaStreamTrack->codec == RTC_CODEC_H265) {
+        if (pKvsPeerConnection->isOffer) {
+            currentFmtp = DEFAULT_H265_FMTP;
+        }
+        STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeName, "rtpmap", MAX_SDP_ATTRIBUTE_NAME_LENGTH);
+        SNPRINTF(pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue, MAX_SDP_ATTRIBUTE_VALUE_LENGTH, "%" PRId64 " " H265_VALUE,
+                 payloadType);
+        attributeCount++;
+
+        if (currentFmtp != NULL) {
+            STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeName, "fmtp", MAX_SDP_ATTRIBUTE_NAME_LENGTH);
+            SNPRINTF(pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue, MAX_SDP_ATTRIBUTE_VALUE_LENGTH, "%" PRId64 " %s",
+                     payloadType, currentFmtp);
+            attributeCount++;
+        }
+
         if (containRtx) {
             STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeName, "rtpmap", MAX_SDP_ATTRIBUTE_NAME_LENGTH);
             SNPRINTF(pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue, MAX_SDP_ATTRIBUTE_VALUE_LENGTH, "%" PRId64 " " RTX_VALUE,
@@ -546,6 +763,19 @@ STATUS sdp_populateSingleMediaSection(PKvsPeerConnection pKvsPeerConnection, PKv
                      payloadType, currentFmtp);
             attributeCount++;
         }
+
+        if (redNegotiated) {
+            STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeName, "rtpmap", MAX_SDP_ATTRIBUTE_NAME_LENGTH);
+            SNPRINTF(pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue, MAX_SDP_ATTRIBUTE_VALUE_LENGTH, "%u " RED_VALUE "/2",
+                     pKvsPeerConnection->redPayloadType);
+            attributeCount++;
+
+            // https://tools.ietf.org/html/rfc2198#section-5, the payload types of the blocks
+            STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeName, "fmtp", MAX_SDP_ATTRIBUTE_NAME_LENGTH);
+            SNPRINTF(pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue, MAX_SDP_ATTRIBUTE_VALUE_LENGTH,
+                     "%u %" PRId64 "/%" PRId64, pKvsPeerConnection->redPayloadType, payloadType, payloadType);
+            attributeCount++;
+        }
     } else if (pRtcMediaStreamTrack->codec == RTC_CODEC_VP8) {
         STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeName, "rtpmap", MAX_SDP_ATTRIBUTE_NAME_LENGTH);
         SNPRINTF(pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue, MAX_SDP_ATTRIBUTE_VALUE_LENGTH, "%" PRId64 " " VP8_VALUE,
@@ -559,6 +789,31 @@ STATUS sdp_populateSingleMediaSection(PKvsPeerConnection pKvsPeerConnection, PKv
                      rtxPayloadType);
             attributeCount++;
 
+            STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeName, "fmtp", MAX_SDP_ATTRIBUTE_NAME_LENGTH);
+            SNPRINTF(pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue, MAX_SDP_ATTRIBUTE_VALUE_LENGTH,
+                     "%" PRId64 " apt=%" PRId64 "", rtxPayloadType, payloadType);
+            attributeCount++;
+        }
+    } else if (pRtcMediaStreamTrack->codec == RTC_CODEC_AV1) {
+        STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeName, "rtpmap", MAX_SDP_ATTRIBUTE_NAME_LENGTH);
+        SNPRINTF(pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue, MAX_SDP_ATTRIBUTE_VALUE_LENGTH, "%" PRId64 " " AV1_VALUE,
+                 payloadType);
+        attributeCount++;
+
+        // Without an fmtp the offer stands for profile 0, level 5.1 and the main tier https://aomediacodec.github.io/av1-rtp-spec/#72-sdp-parameters
+        if (!pKvsPeerConnection->isOffer && currentFmtp != NULL) {
+            STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeName, "fmtp", MAX_SDP_ATTRIBUTE_NAME_LENGTH);
+            SNPRINTF(pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue, MAX_SDP_ATTRIBUTE_VALUE_LENGTH, "%" PRId64 " %s",
+                     payloadType, currentFmtp);
+            attributeCount++;
+        }
+
+        if (containRtx) {
+            STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeName, "rtpmap", MAX_SDP_ATTRIBUTE_NAME_LENGTH);
+            SNPRINTF(pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue, MAX_SDP_ATTRIBUTE_VALUE_LENGTH, "%" PRId64 " " RTX_VALUE,
+                     rtxPayloadType);
+            attributeCount++;
+
             STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeName, "fmtp", MAX_SDP_ATTRIBUTE_NAME_LENGTH);
             SNPRINTF(pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue, MAX_SDP_ATTRIBUTE_VALUE_LENGTH,
                      "%" PRId64 " apt=%" PRId64 "", rtxPayloadType, payloadType);
@@ -576,10 +831,51 @@ STATUS sdp_populateSingleMediaSection(PKvsPeerConnection pKvsPeerConnection, PKv
         attributeCount++;
     }
 
+    if (flexFecNegotiated) {
+        STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeName, "rtpmap", MAX_SDP_ATTRIBUTE_NAME_LENGTH);
+        SNPRINTF(pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue, MAX_SDP_ATTRIBUTE_VALUE_LENGTH, "%u " FLEXFEC_VALUE,
+                 pKvsPeerConnection->flexFecPayloadType);
+        attributeCount++;
+
+        STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeName, "fmtp", MAX_SDP_ATTRIBUTE_NAME_LENGTH);
+        SNPRINTF(pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue, MAX_SDP_ATTRIBUTE_VALUE_LENGTH, "%u %s",
+                 pKvsPeerConnection->flexFecPayloadType, DEFAULT_FLEXFEC_FMTP);
+        attributeCount++;
+    }
+
     STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeName, "rtcp-fb", MAX_SDP_ATTRIBUTE_NAME_LENGTH);
     SNPRINTF(pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue, MAX_SDP_ATTRIBUTE_VALUE_LENGTH, "%" PRId64 " nack", payloadType);
     attributeCount++;
 
+    if (twccNegotiated) {
+        // The feedback covers every packet on the transport, whatever its payload type
+        STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeName, "rtcp-fb", MAX_SDP_ATTRIBUTE_NAME_LENGTH);
+        STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue, "* transport-cc", MAX_SDP_ATTRIBUTE_VALUE_LENGTH);
+        attributeCount++;
+    }
+
+    if (offerSimulcast) {
+        // a=rid:<rid-id> send
+        for (i = 0; i < pKvsRtpTransceiver->simulcastEncodingCount; i++) {
+            STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeName, "rid", MAX_SDP_ATTRIBUTE_NAME_LENGTH);
+            SNPRINTF(pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue, MAX_SDP_ATTRIBUTE_VALUE_LENGTH, "%s send",
+                     rtp_transceiver_getSender(pKvsRtpTransceiver, i)->rid);
+            attributeCount++;
+        }
+
+        // a=simulcast:send <rid-id>;<rid-id>, every rid is its own alternative
+        STRNCPY(pSdpMediaDescription->sdpAttributes[attributeCount].attributeName, "simulcast", MAX_SDP_ATTRIBUTE_NAME_LENGTH);
+        pCurr = pSdpMediaDescription->sdpAttributes[attributeCount].attributeValue;
+        sizeRemaining = MAX_SDP_ATTRIBUTE_VALUE_LENGTH;
+        for (i = 0; i < pKvsRtpTransceiver->simulcastEncodingCount; i++) {
+            written = SNPRINTF(pCurr, sizeRemaining, "%s%s", i == 0 ? "send " : ";", rtp_transceiver_getSender(pKvsRtpTransceiver, i)->rid);
+            CHK(written > 0 && (UINT32) written < sizeRemaining, STATUS_BUFFER_TOO_SMALL);
+            pCurr += written;
+            sizeRemaining -= written;
+        }
+        attributeCount++;
+    }
+
     pSdpMediaDescription->mediaAttributesCount = attributeCount;
 
 CleanUp:
@@ -884,6 +1180,9 @@ STATUS sdp_reorderTransceiverByRemoteDescription(PKvsPeerConnection pKvsPeerConn
             if (STRSTR(attributeValue, H264_VALUE) != NULL) {
                 supportCodec = TRUE;
                 rtcCodec = RTC_CODEC_H264_PROFILE_42E01F_LEVEL_ASYMMETRY_ALLOWED_PACKETIZATION_MODE;
+            } else if (STRSTR(attributeValue, H265_VALUE) != NULL) {
+                supportCodec = TRUE;
+                rtcCodec = RTC_CODEC_H265;
             } else if (STRSTR(attributeValue, OPUS_VALUE) != NULL) {
                 supportCodec = TRUE;
                 rtcCodec = RTC_CODEC_OPUS;
@@ -896,6 +1195,9 @@ STATUS sdp_reorderTransceiverByRemoteDescription(PKvsPeerConnection pKvsPeerConn
             } else if (STRSTR(attributeValue, VP8_VALUE) != NULL) {
                 supportCodec = TRUE;
                 rtcCodec = RTC_CODEC_VP8;
+            } else if (STRSTR(attributeValue, AV1_VALUE) != NULL) {
+                supportCodec = TRUE;
+                rtcCodec = RTC_CODEC_AV1;
             } else {
                 supportCodec = FALSE;
             }
@@ -950,6 +1252,53 @@ CleanUp:
     return retStatus;
 }
 
+/**
+ * The repair stream of a media stream, a=ssrc-group:<semantics> <media ssrc> <repair ssrc>. FEC-FR groups the flexfec stream and FID the
+ * rtx stream.
+ */
+static UINT32 sdp_getRepairSsrc(PSdpMediaDescription pMediaDescription, PCHAR semantics, UINT32 ssrc)
+{
+    UINT32 i, mediaSsrc, repairSsrc, semanticsLen = (UINT32) STRLEN(semantics);
+    PCHAR pValue, pEnd;
+
+    for (i = 0; i < pMediaDescription->mediaAttributesCount; i++) {
+        pValue = pMediaDescription->sdpAttributes[i].attributeValue;
+        if (STRCMP(pMediaDescription->sdpAttributes[i].attributeName, "ssrc-group") != 0 || STRNCMP(pValue, semantics, semanticsLen) != 0 ||
+            pValue[semanticsLen] != ' ') {
+            continue;
+        }
+        pValue += semanticsLen + 1;
+        if ((pEnd = STRCHR(pValue, ' ')) != NULL && STATUS_SUCCEEDED(STRTOUI32(pValue, pEnd, 10, &mediaSsrc)) && mediaSsrc == ssrc &&
+            STATUS_SUCCEEDED(STRTOUI32(pEnd + 1, NULL, 10, &repairSsrc))) {
+            return repairSsrc;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Whether the remote peer takes a feedback message for a codec of the media section, a=rtcp-fb:<payload type> <feedback>
+ */
+static BOOL sdp_acceptsFeedback(PSdpMediaDescription pMediaDescription, PCHAR feedback)
+{
+    UINT32 i;
+    PCHAR pValue;
+
+    for (i = 0; i < pMediaDescription->mediaAttributesCount; i++) {
+        pValue = pMediaDescription->sdpAttributes[i].attributeValue;
+        if (STRCMP(pMediaDescription->sdpAttributes[i].attributeName, "rtcp-fb") != 0 || (pValue = STRCHR(pValue, ' ')) == NULL) {
+            continue;
+        }
+        // The whole value has to match, "nack pli" is a picture loss indication rather than a generic nack
+        if (STRCMP(pValue + 1, feedback) == 0) {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
 STATUS sdp_setReceiversSsrc(PSessionDescription pRemoteSessionDescription, PDoubleList pTransceivers)
 {
     STATUS retStatus = STATUS_SUCCESS;
@@ -994,6 +1343,11 @@ STATUS sdp_setReceiversSsrc(PSessionDescription pRemoteSessionDescription, PDoub
                         ((isVideoCodec && isVideoMediaSection) || (isAudioCodec && isAudioMediaSection))) {
                         // Finish iteration, we assigned the ssrc move on to next media section
                         pKvsRtpTransceiver->jitterBufferSsrc = ssrc;
+                        pKvsRtpTransceiver->remoteFecSsrc = isVideoMediaSection ? sdp_getRepairSsrc(pMediaDescription, "FEC-FR", ssrc) : 0;
+                        pKvsRtpTransceiver->remoteRtxSsrc = sdp_getRepairSsrc(pMediaDescription, "FID", ssrc);
+                        pKvsRtpTransceiver->remoteAcceptsNack = sdp_acceptsFeedback(pMediaDescription, "nack");
+                        pKvsRtpTransceiver->remoteAcceptsPli = sdp_acceptsFeedback(pMediaDescription, "nack pli");
+                        pKvsRtpTransceiver->remoteAcceptsFir = sdp_acceptsFeedback(pMediaDescription, "ccm fir");
                         pKvsRtpTransceiver->inboundStats.received.rtpStream.ssrc = ssrc;
                         STRNCPY(pKvsRtpTransceiver->inboundStats.received.rtpStream.kind,
                                 pKvsRtpTransceiver->transceiver.receiver.track.kind == MEDIA_STREAM_TRACK_KIND_VIDEO ? "video" : "audio",
@@ -1012,3 +1366,131 @@ CleanUp:
 
     return retStatus;
 }
+
+STATUS sdp_setTransceiversSimulcast(PKvsPeerConnection pKvsPeerConnection, PSessionDescription pRemoteSessionDescription)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PDoubleListNode pCurNode = NULL;
+    PKvsRtpTransceiver pKvsRtpTransceiver;
+    PSdpMediaDescription pMediaDescription;
+    UINT64 data;
+    UINT32 mediaSectionId = 0;
+
+    CHK(pKvsPeerConnection != NULL && pRemoteSessionDescription != NULL, STATUS_NULL_ARG);
+
+    // The offer has one media section per transceiver in the order of the list, the answer keeps that order
+    CHK_STATUS(double_list_getHeadNode(pKvsPeerConnection->pTransceivers, &pCurNode));
+    while (pCurNode != NULL) {
+        CHK_STATUS(double_list_getNodeData(pCurNode, &data));
+        pCurNode = pCurNode->pNext;
+        pKvsRtpTransceiver = (PKvsRtpTransceiver) data;
+        pMediaDescription =
+            mediaSectionId < pRemoteSessionDescription->mediaCount ? &pRemoteSessionDescription->mediaDescriptions[mediaSectionId] : NULL;
+        pKvsRtpTransceiver->simulcastNegotiated =
+            pKvsPeerConnection->extensionMap.ids[RTP_EXTENSION_RID] != 0 && sdp_receivesSimulcast(pMediaDescription, pKvsRtpTransceiver);
+        mediaSectionId++;
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+UINT8 sdp_getExtmapId(PSdpMediaDescription pMediaDescription, PCHAR extensionUrl)
+{
+    UINT32 i;
+    UINT64 extId = 0;
+    PCHAR pValue, pUrl, pIdEnd;
+
+    if (pMediaDescription == NULL || extensionUrl == NULL) {
+        return 0;
+    }
+
+    // a=extmap:<value>["/"<direction>] <URI> <extensionattributes>
+    for (i = 0; i < pMediaDescription->mediaAttributesCount; i++) {
+        if (STRCMP(pMediaDescription->sdpAttributes[i].attributeName, "extmap") != 0) {
+            continue;
+        }
+        pValue = pMediaDescription->sdpAttributes[i].attributeValue;
+        if ((pUrl = STRCHR(pValue, ' ')) == NULL || STRNCMP(pUrl + 1, extensionUrl, STRLEN(extensionUrl)) != 0) {
+            continue;
+        }
+        if ((pIdEnd = STRCHR(pValue, '/')) == NULL || pIdEnd > pUrl) {
+            pIdEnd = pUrl;
+        }
+        if (STATUS_SUCCEEDED(STRTOUI64(pValue, pIdEnd, 10, &extId)) && extId > 0 && extId <= RTP_TWO_BYTE_EXTENSION_ID_MAX) {
+            return (UINT8) extId;
+        }
+    }
+
+    return 0;
+}
+
+UINT8 sdp_getFlexFecPayloadType(PSdpMediaDescription pMediaDescription)
+{
+    UINT32 i;
+    UINT64 payloadType = 0;
+    PCHAR pValue, pCodec;
+
+    if (pMediaDescription == NULL) {
+        return 0;
+    }
+
+    // a=rtpmap:<payload type> flexfec-03/90000
+    for (i = 0; i < pMediaDescription->mediaAttributesCount; i++) {
+        if (STRCMP(pMediaDescription->sdpAttributes[i].attributeName, "rtpmap") != 0) {
+            continue;
+        }
+        pValue = pMediaDescription->sdpAttributes[i].attributeValue;
+        if ((pCodec = STRSTR(pValue, FLEXFEC_VALUE)) == NULL || pCodec == pValue) {
+            continue;
+        }
+        if (STATUS_SUCCEEDED(STRTOUI64(pValue, pCodec - 1, 10, &payloadType)) && payloadType > 0 && payloadType <= 127) {
+            return (UINT8) payloadType;
+        }
+    }
+
+    return 0;
+}
+
+UINT8 sdp_getRedPayloadType(PSdpMediaDescription pMediaDescription, UINT64 opusPayloadType)
+{
+    UINT32 i;
+    UINT64 payloadType = 0, blockPayloadType;
+    PCHAR pValue, pCodec, pEnd;
+
+    if (pMediaDescription == NULL) {
+        return 0;
+    }
+
+    // a=rtpmap:<payload type> red/48000/2
+    for (i = 0; i < pMediaDescription->mediaAttributesCount && payloadType == 0; i++) {
+        if (STRCMP(pMediaDescription->sdpAttributes[i].attributeName, "rtpmap") != 0) {
+            continue;
+        }
+        pValue = pMediaDescription->sdpAttributes[i].attributeValue;
+        if ((pCodec = STRSTR(pValue, RED_VALUE)) == NULL || pCodec == pValue ||
+            STATUS_FAILED(STRTOUI64(pValue, pCodec - 1, 10, &payloadType)) || payloadType > 127) {
+            payloadType = 0;
+        }
+    }
+
+    // a=fmtp:<payload type> <block payload type>/<block payload type>
+    for (i = 0; i < pMediaDescription->mediaAttributesCount && payloadType != 0; i++) {
+        if (STRCMP(pMediaDescription->sdpAttributes[i].attributeName, "fmtp") != 0) {
+            continue;
+        }
+        pValue = pMediaDescription->sdpAttributes[i].attributeValue;
+        if ((pCodec = STRCHR(pValue, ' ')) == NULL || STATUS_FAILED(STRTOUI64(pValue, pCodec, 10, &blockPayloadType)) ||
+            blockPayloadType != payloadType) {
+            continue;
+        }
+        pCodec++;
+        if ((pEnd = STRCHR(pCodec, '/')) != NULL && STATUS_SUCCEEDED(STRTOUI64(pCodec, pEnd, 10, &blockPayloadType)) &&
+            blockPayloadType == opusPayloadType) {
+            return (UINT8) payloadType;
+        }
+    }
+
+    return 0;
+}
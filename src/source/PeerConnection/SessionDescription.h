@@ -34,18 +34,29 @@ extern "C" {
 #define BUNDLE_KEY    "BUNDLE"
 
 #define H264_VALUE      "H264/90000"
+#define H265_VALUE      "H265/90000"
+#define AV1_VALUE       "AV1/90000"
 #define OPUS_VALUE      "opus/48000"
 #define VP8_VALUE       "VP8/90000"
 #define MULAW_VALUE     "PCMU/8000"
 #define ALAW_VALUE      "PCMA/8000"
 #define RTX_VALUE       "rtx/90000"
 #define RTX_CODEC_VALUE "apt="
+#define FLEXFEC_VALUE   "flexfec-03/90000"
+#define RED_VALUE       "red/48000"
 
 #define DEFAULT_PAYLOAD_MULAW (UINT64) 0
 #define DEFAULT_PAYLOAD_ALAW  (UINT64) 8
 #define DEFAULT_PAYLOAD_OPUS  (UINT64) 111
 #define DEFAULT_PAYLOAD_VP8   (UINT64) 96
 #define DEFAULT_PAYLOAD_H264  (UINT64) 125
+#define DEFAULT_PAYLOAD_H265  (UINT64) 127
+// The payload type browsers offer AV1 with
+#define DEFAULT_PAYLOAD_AV1 (UINT64) 45
+// Dynamic payload type none of the codecs of the offer uses
+#define DEFAULT_PAYLOAD_FLEXFEC 49
+// The payload type browsers offer red for Opus with
+#define DEFAULT_PAYLOAD_RED 63
 /**
  * a=rtpmap:0 PCMU/8000\r\n
  * a=rtpmap:8 PCMA/8000\r\n
@@ -55,7 +66,11 @@ extern "C" {
 #define DEFAULT_PAYLOAD_ALAW_STR  (PCHAR) "8"
 
 #define DEFAULT_H264_FMTP (PCHAR) "level-asymmetry-allowed=1;packetization-mode=1;profile-level-id=42e01f"
+// Main profile, main tier, level 3.1 https://tools.ietf.org/html/rfc7798#section-7.1
+#define DEFAULT_H265_FMTP (PCHAR) "profile-id=1;tier-flag=0;level-id=93;tx-mode=SRST"
 #define DEFAULT_OPUS_FMTP (PCHAR) "minptime=10;useinbandfec=1"
+// The repair window browsers offer, in microseconds https://tools.ietf.org/html/draft-ietf-payload-flexible-fec-scheme-03#section-5.1.1
+#define DEFAULT_FLEXFEC_FMTP (PCHAR) "repair-window=10000000"
 
 #define DTLS_ROLE_ACTPASS (PCHAR) "actpass"
 #define DTLS_ROLE_ACTIVE  (PCHAR) "active"
@@ -76,11 +91,46 @@ extern "C" {
 STATUS sdp_setPayloadTypesFromOffer(PHashTable, PHashTable, PSessionDescription);
 STATUS sdp_setPayloadTypesForOffer(PHashTable);
 
-STATUS sdp_setTransceiverPayloadTypes(PHashTable, PHashTable, PDoubleList);
+STATUS sdp_setTransceiverPayloadTypes(PHashTable, PHashTable, PRtpPacketPool, PDoubleList);
 STATUS sdp_populateSessionDescription(PKvsPeerConnection, PSessionDescription, PSessionDescription);
 STATUS sdp_reorderTransceiverByRemoteDescription(PKvsPeerConnection, PSessionDescription);
 STATUS sdp_setReceiversSsrc(PSessionDescription, PDoubleList);
 PCHAR sdp_fmtpForPayloadType(UINT64, PSessionDescription);
+/**
+ * @brief the id a media section maps a header extension to.
+ *
+ * @param[in] pMediaDescription the media section.
+ * @param[in] extensionUrl the uri of the extension.
+ *
+ * @return the id of the extension, 0 if the media section does not use it.
+ */
+UINT8 sdp_getExtmapId(PSdpMediaDescription, PCHAR);
+/**
+ * @brief latch the outcome of the simulcast negotiation from the answer to our offer.
+ *
+ * @param[in] pKvsPeerConnection the offerer.
+ * @param[in] pRemoteSessionDescription the answer.
+ *
+ * @return STATUS_SUCCESS
+ */
+STATUS sdp_setTransceiversSimulcast(PKvsPeerConnection, PSessionDescription);
+/**
+ * @brief the payload type a media section maps flexfec-03 to.
+ *
+ * @param[in] pMediaDescription the media section.
+ *
+ * @return the payload type, 0 if the media section does not use flexfec.
+ */
+UINT8 sdp_getFlexFecPayloadType(PSdpMediaDescription);
+/**
+ * @brief the payload type a media section maps red to, as long as its blocks are Opus frames.
+ *
+ * @param[in] pMediaDescription the media section.
+ * @param[in] opusPayloadType the payload type of Opus.
+ *
+ * @return the payload type, 0 if the media section does not use red for Opus.
+ */
+UINT8 sdp_getRedPayloadType(PSdpMediaDescription, UINT64);
 
 #ifdef __cplusplus
 }
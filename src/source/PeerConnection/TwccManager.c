@@ -0,0 +1,682 @@
+/*
+ * Copyright 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+/******************************************************************************
+ * HEADERS
+ ******************************************************************************/
+#ifdef ENABLE_STREAMING
+#define LOG_CLASS "TwccManager"
+
+#include "endianness.h"
+#include "TwccManager.h"
+
+/******************************************************************************
+ * DEFINITIONS
+ ******************************************************************************/
+#define TWCC_TIME_TO_MS(t) ((DOUBLE) (t) / HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+
+/******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+/**
+ * @brief the number of packets a status chunk reports.
+ *
+ *        run length chunk                   status vector chunk
+ *        0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5    0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5
+ *       +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *       |T| S |       Run Length        |  |T|S|       symbol list         |
+ *       +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ */
+static UINT32 twcc_manager_getChunkStatusCount(UINT16 chunk)
+{
+    if ((chunk & TWCC_FEEDBACK_CHUNK_TYPE_MASK) == 0) {
+        return chunk & TWCC_FEEDBACK_RUN_LENGTH_MASK;
+    }
+    // 14 one-bit symbols or 7 two-bit symbols
+    return (chunk & TWCC_FEEDBACK_SYMBOL_SIZE_MASK) == 0 ? 14 : 7;
+}
+
+static TWCC_PACKET_STATUS twcc_manager_getChunkStatus(UINT16 chunk, UINT32 index)
+{
+    if ((chunk & TWCC_FEEDBACK_CHUNK_TYPE_MASK) == 0) {
+        return (TWCC_PACKET_STATUS) ((chunk >> 13) & 0x3);
+    }
+    if ((chunk & TWCC_FEEDBACK_SYMBOL_SIZE_MASK) == 0) {
+        return (TWCC_PACKET_STATUS) ((chunk >> (13 - index)) & 0x1);
+    }
+    return (TWCC_PACKET_STATUS) ((chunk >> (12 - 2 * index)) & 0x3);
+}
+
+/**
+ * @brief compare the trend of the queuing delay against an adaptive threshold.
+ *        https://tools.ietf.org/html/draft-ietf-rmcat-gcc-02#section-5.4
+ */
+static VOID twcc_manager_detectOveruse(PTwccManager pTwccManager, DOUBLE sendDeltaMs, UINT64 currentTime)
+{
+    DOUBLE modifiedTrend, absTrend, gain, elapsedMs;
+
+    modifiedTrend = MIN(pTwccManager->numDeltas, TWCC_MAX_TREND_DELTAS) * pTwccManager->trend * TWCC_TRENDLINE_THRESHOLD_GAIN;
+    if (modifiedTrend > pTwccManager->threshold) {
+        // Overuse is signaled only once it lasted for a while and the delay keeps growing
+        pTwccManager->overuseTime += pTwccManager->overuseCount == 0 ? sendDeltaMs / 2 : sendDeltaMs;
+        pTwccManager->overuseCount++;
+        if (pTwccManager->overuseTime > TWCC_OVERUSE_TIME_THRESHOLD_MS && pTwccManager->overuseCount > 1 &&
+            pTwccManager->trend >= pTwccManager->prevTrend) {
+            pTwccManager->overuseTime = 0;
+            pTwccManager->overuseCount = 0;
+            pTwccManager->usage = TWCC_BANDWIDTH_USAGE_OVERUSING;
+        }
+    } else if (modifiedTrend < -pTwccManager->threshold) {
+        pTwccManager->overuseTime = 0;
+        pTwccManager->overuseCount = 0;
+        pTwccManager->usage = TWCC_BANDWIDTH_USAGE_UNDERUSING;
+    } else {
+        pTwccManager->overuseTime = 0;
+        pTwccManager->overuseCount = 0;
+        pTwccManager->usage = TWCC_BANDWIDTH_USAGE_NORMAL;
+    }
+    pTwccManager->prevTrend = pTwccManager->trend;
+
+    // Spikes far above the threshold do not move it, so that a single outlier does not desensitize the detector
+    absTrend = ABS(modifiedTrend);
+    if (absTrend <= pTwccManager->threshold + TWCC_MAX_THRESHOLD_ADAPT_OFFSET) {
+        gain = absTrend < pTwccManager->threshold ? TWCC_THRESHOLD_GAIN_DOWN : TWCC_THRESHOLD_GAIN_UP;
+        elapsedMs = pTwccManager->lastThresholdUpdateTime == 0
+            ? 0
+            : MIN(TWCC_TIME_TO_MS(currentTime - pTwccManager->lastThresholdUpdateTime), TWCC_MAX_THRESHOLD_ADAPT_TIME_MS);
+        pTwccManager->threshold += gain * (absTrend - pTwccManager->threshold) * elapsedMs;
+        pTwccManager->threshold = MAX(TWCC_MIN_THRESHOLD, MIN(pTwccManager->threshold, TWCC_MAX_THRESHOLD));
+    }
+    pTwccManager->lastThresholdUpdateTime = currentTime;
+}
+
+/**
+ * @brief feed the delay variation between two groups into the trendline filter, the slope of the smoothed accumulated
+ *        delay over the arrival time tells whether the queues along the path are growing.
+ */
+static VOID twcc_manager_updateTrendline(PTwccManager pTwccManager, DOUBLE delayVariationMs, DOUBLE sendDeltaMs, INT64 receiveTime,
+                                         UINT64 currentTime)
+{
+    UINT32 i;
+    DOUBLE meanX = 0, meanY = 0, numerator = 0, denominator = 0;
+
+    if (pTwccManager->numDeltas == 0) {
+        pTwccManager->firstReceiveTime = receiveTime;
+    }
+    pTwccManager->numDeltas = MIN(pTwccManager->numDeltas + 1, TWCC_MAX_TREND_DELTAS);
+    pTwccManager->accumulatedDelay += delayVariationMs;
+    pTwccManager->smoothedDelay =
+        TWCC_TRENDLINE_SMOOTHING * pTwccManager->smoothedDelay + (1 - TWCC_TRENDLINE_SMOOTHING) * pTwccManager->accumulatedDelay;
+
+    pTwccManager->trendX[pTwccManager->trendIndex] = TWCC_TIME_TO_MS(receiveTime - pTwccManager->firstReceiveTime);
+    pTwccManager->trendY[pTwccManager->trendIndex] = pTwccManager->smoothedDelay;
+    pTwccManager->trendIndex = (pTwccManager->trendIndex + 1) % TWCC_TRENDLINE_WINDOW_SIZE;
+    pTwccManager->trendCount = MIN(pTwccManager->trendCount + 1, TWCC_TRENDLINE_WINDOW_SIZE);
+
+    if (pTwccManager->trendCount == TWCC_TRENDLINE_WINDOW_SIZE) {
+        // least squares slope
+        for (i = 0; i < pTwccManager->trendCount; i++) {
+            meanX += pTwccManager->trendX[i];
+            meanY += pTwccManager->trendY[i];
+        }
+        meanX /= pTwccManager->trendCount;
+        meanY /= pTwccManager->trendCount;
+        for (i = 0; i < pTwccManager->trendCount; i++) {
+            numerator += (pTwccManager->trendX[i] - meanX) * (pTwccManager->trendY[i] - meanY);
+            denominator += (pTwccManager->trendX[i] - meanX) * (pTwccManager->trendX[i] - meanX);
+        }
+        if (denominator != 0) {
+            pTwccManager->trend = numerator / denominator;
+        }
+    }
+
+    twcc_manager_detectOveruse(pTwccManager, sendDeltaMs, currentTime);
+}
+
+/**
+ * @brief group the packets sent within TWCC_BURST_INTERVAL, the delay variation is measured between the last packets of
+ *        two consecutive groups.
+ */
+static VOID twcc_manager_onPacketArrival(PTwccManager pTwccManager, UINT64 sendTime, INT64 receiveTime, UINT64 currentTime)
+{
+    UINT64 sendDelta;
+    INT64 receiveDelta;
+
+    if (pTwccManager->hasGroup) {
+        // reordered on the way out, it belongs to a group which is gone already
+        if (sendTime < pTwccManager->groupFirstSendTime) {
+            return;
+        }
+        if (sendTime - pTwccManager->groupFirstSendTime <= TWCC_BURST_INTERVAL) {
+            pTwccManager->groupLastSendTime = MAX(pTwccManager->groupLastSendTime, sendTime);
+            pTwccManager->groupLastReceiveTime = MAX(pTwccManager->groupLastReceiveTime, receiveTime);
+            return;
+        }
+
+        if (pTwccManager->hasPrevGroup) {
+            sendDelta = pTwccManager->groupLastSendTime - pTwccManager->prevGroupLastSendTime;
+            receiveDelta = pTwccManager->groupLastReceiveTime - pTwccManager->prevGroupLastReceiveTime;
+            twcc_manager_updateTrendline(pTwccManager, TWCC_TIME_TO_MS(receiveDelta - (INT64) sendDelta), TWCC_TIME_TO_MS(sendDelta),
+                                         pTwccManager->groupLastReceiveTime, currentTime);
+        }
+        pTwccManager->prevGroupLastSendTime = pTwccManager->groupLastSendTime;
+        pTwccManager->prevGroupLastReceiveTime = pTwccManager->groupLastReceiveTime;
+        pTwccManager->hasPrevGroup = TRUE;
+    }
+
+    pTwccManager->groupFirstSendTime = sendTime;
+    pTwccManager->groupLastSendTime = sendTime;
+    pTwccManager->groupLastReceiveTime = receiveTime;
+    pTwccManager->hasGroup = TRUE;
+}
+
+/**
+ * @brief AIMD on the delay-based rate and the loss-based rate of gcc, the target is the smaller of the two.
+ *        https://tools.ietf.org/html/draft-ietf-rmcat-gcc-02#section-5.5
+ *        https://tools.ietf.org/html/draft-ietf-rmcat-gcc-02#section-6
+ */
+static VOID twcc_manager_updateTargetBitrate(PTwccManager pTwccManager, UINT64 currentTime)
+{
+    DOUBLE seconds, bitrate, ackedCap;
+
+    bitrate = (DOUBLE) pTwccManager->delayBasedBitrate;
+    switch (pTwccManager->usage) {
+        case TWCC_BANDWIDTH_USAGE_OVERUSING:
+            if (currentTime - pTwccManager->lastDecreaseTime >= TWCC_MIN_DECREASE_INTERVAL) {
+                // Back off below what actually got through so that the queues drain
+                bitrate = TWCC_DECREASE_FACTOR * (pTwccManager->ackedBitrate > 0 ? pTwccManager->ackedBitrate : bitrate);
+                bitrate = MIN(bitrate, (DOUBLE) pTwccManager->delayBasedBitrate);
+                pTwccManager->lastDecreaseTime = currentTime;
+            }
+            break;
+        case TWCC_BANDWIDTH_USAGE_NORMAL:
+            if (pTwccManager->lastRateUpdateTime != 0 && currentTime > pTwccManager->lastRateUpdateTime) {
+                seconds = (DOUBLE) MIN(currentTime - pTwccManager->lastRateUpdateTime, HUNDREDS_OF_NANOS_IN_A_SECOND) / HUNDREDS_OF_NANOS_IN_A_SECOND;
+                bitrate *= pow(TWCC_INCREASE_FACTOR_PER_SECOND, seconds);
+                // An application limited sender does not probe the path, so do not grow far beyond what it sends
+                if (pTwccManager->ackedBitrate > 0) {
+                    ackedCap = TWCC_ACKED_BITRATE_HEADROOM * pTwccManager->ackedBitrate;
+                    bitrate = MIN(bitrate, MAX(ackedCap, (DOUBLE) pTwccManager->delayBasedBitrate));
+                }
+            }
+            break;
+        case TWCC_BANDWIDTH_USAGE_UNDERUSING:
+            // the queues are draining, hold the rate until they are empty
+            break;
+    }
+    pTwccManager->lastRateUpdateTime = currentTime;
+    pTwccManager->delayBasedBitrate = (UINT64) MAX((DOUBLE) pTwccManager->minBitrate, MIN(bitrate, (DOUBLE) pTwccManager->maxBitrate));
+
+    if (currentTime - pTwccManager->lastLossUpdateTime >= TWCC_LOSS_UPDATE_INTERVAL) {
+        bitrate = (DOUBLE) pTwccManager->lossBasedBitrate;
+        if (pTwccManager->fractionLost > TWCC_HIGH_LOSS_THRESHOLD) {
+            bitrate = pTwccManager->targetBitrate * (1 - 0.5 * pTwccManager->fractionLost);
+        } else if (pTwccManager->fractionLost < TWCC_LOW_LOSS_THRESHOLD) {
+            bitrate *= TWCC_LOSS_BASED_INCREASE_FACTOR;
+        }
+        pTwccManager->lossBasedBitrate = (UINT64) MAX((DOUBLE) pTwccManager->minBitrate, MIN(bitrate, (DOUBLE) pTwccManager->maxBitrate));
+        pTwccManager->lastLossUpdateTime = currentTime;
+    }
+
+    pTwccManager->targetBitrate = MIN(pTwccManager->delayBasedBitrate, pTwccManager->lossBasedBitrate);
+}
+
+STATUS twcc_manager_create(TwccOnTargetBitrateFunc onTargetBitrateFn, UINT64 customData, PTwccManager* ppTwccManager)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PTwccManager pTwccManager = NULL;
+
+    CHK(ppTwccManager != NULL, STATUS_NULL_ARG);
+
+    pTwccManager = (PTwccManager) MEMCALLOC(1, SIZEOF(TwccManager));
+    CHK(pTwccManager != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    pTwccManager->lock = MUTEX_CREATE(FALSE);
+    CHK(IS_VALID_MUTEX_VALUE(pTwccManager->lock), STATUS_INVALID_OPERATION);
+    pTwccManager->threshold = TWCC_INITIAL_THRESHOLD;
+    pTwccManager->usage = TWCC_BANDWIDTH_USAGE_NORMAL;
+    pTwccManager->minBitrate = TWCC_DEFAULT_MIN_BITRATE;
+    pTwccManager->maxBitrate = TWCC_DEFAULT_MAX_BITRATE;
+    pTwccManager->delayBasedBitrate = TWCC_DEFAULT_START_BITRATE;
+    pTwccManager->lossBasedBitrate = TWCC_DEFAULT_START_BITRATE;
+    pTwccManager->targetBitrate = TWCC_DEFAULT_START_BITRATE;
+    pTwccManager->reportedBitrate = TWCC_DEFAULT_START_BITRATE;
+    pTwccManager->onTargetBitrateFn = onTargetBitrateFn;
+    pTwccManager->customData = customData;
+
+CleanUp:
+    if (STATUS_FAILED(retStatus)) {
+        twcc_manager_free(&pTwccManager);
+    }
+
+    if (ppTwccManager != NULL) {
+        *ppTwccManager = pTwccManager;
+    }
+    LEAVES();
+    return retStatus;
+}
+
+STATUS twcc_manager_free(PTwccManager* ppTwccManager)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PTwccManager pTwccManager = NULL;
+
+    CHK(ppTwccManager != NULL, STATUS_NULL_ARG);
+    pTwccManager = *ppTwccManager;
+    CHK(pTwccManager != NULL, retStatus);
+
+    if (IS_VALID_MUTEX_VALUE(pTwccManager->lock)) {
+        MUTEX_FREE(pTwccManager->lock);
+    }
+    SAFE_MEMFREE(*ppTwccManager);
+
+CleanUp:
+    CHK_LOG_ERR(retStatus);
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS twcc_manager_onPacketSent(PTwccManager pTwccManager, UINT16 seqNum, UINT32 packetSize, UINT64 sendTime)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PTwccPacketInfo pPacketInfo = NULL;
+
+    CHK(pTwccManager != NULL, STATUS_NULL_ARG);
+
+    MUTEX_LOCK(pTwccManager->lock);
+    pPacketInfo = &pTwccManager->history[seqNum % TWCC_SEND_HISTORY_SIZE];
+    pPacketInfo->seqNum = seqNum;
+    pPacketInfo->sendTime = sendTime;
+    pPacketInfo->packetSize = packetSize;
+    pPacketInfo->receiveTime = 0;
+    pPacketInfo->received = FALSE;
+    pPacketInfo->reported = FALSE;
+    MUTEX_UNLOCK(pTwccManager->lock);
+
+CleanUp:
+    return retStatus;
+}
+
+/**
+ * @brief https://tools.ietf.org/html/draft-holmer-rmcat-transport-wide-cc-extensions-01#section-3.1
+ *
+ *  0                   1                   2                   3
+ *  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * |V=2|P|  FMT=15 |    PT=205     |           length              |
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * |                     SSRC of packet sender                     |
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * |                      SSRC of media source                     |
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * |      base sequence number     |      packet status count      |
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * |                 reference time                | fb pkt. count |
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * |          packet chunk         |         packet chunk          |
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * .                                                               .
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * |         packet chunk          |  recv delta   |  recv delta   |
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ * .                                                               .
+ * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ */
+STATUS twcc_manager_onFeedback(PTwccManager pTwccManager, PBYTE pPayload, UINT32 payloadLen, UINT64 currentTime)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    BOOL locked = FALSE, notify = FALSE;
+    UINT16 seqNum, chunk;
+    UINT32 statusCount, reportedCount, chunkCount, chunkOffset, deltaOffset, i, lostCount = 0, receivedCount = 0;
+    UINT64 ackedBytes = 0, targetBitrate = 0;
+    INT64 receiveTime, referenceTime, delta, firstReceiveTime = 0, lastReceiveTime = 0;
+    DOUBLE bitrate;
+    TWCC_PACKET_STATUS status;
+    PTwccPacketInfo pPacketInfo = NULL;
+
+    CHK(pTwccManager != NULL && pPayload != NULL, STATUS_NULL_ARG);
+    CHK(payloadLen >= TWCC_FEEDBACK_HEADER_LEN, STATUS_RTCP_INPUT_TWCC_INVALID);
+
+    seqNum = getUnalignedInt16BigEndian(pPayload + 8);
+    statusCount = getUnalignedInt16BigEndian(pPayload + 10);
+    // 24-bit signed multiple of 64ms
+    referenceTime = (INT64) (getUnalignedInt32BigEndian(pPayload + 12) >> 8);
+    if (referenceTime & 0x800000) {
+        referenceTime -= 0x1000000;
+    }
+    receiveTime = referenceTime * TWCC_FEEDBACK_REFERENCE_TIME_UNIT;
+
+    // The receive deltas follow the last chunk
+    for (chunkOffset = TWCC_FEEDBACK_HEADER_LEN, reportedCount = 0; reportedCount < statusCount; chunkOffset += TWCC_FEEDBACK_CHUNK_LEN) {
+        CHK(chunkOffset + TWCC_FEEDBACK_CHUNK_LEN <= payloadLen, STATUS_RTCP_INPUT_TWCC_INVALID);
+        reportedCount += twcc_manager_getChunkStatusCount(getUnalignedInt16BigEndian(pPayload + chunkOffset));
+    }
+    deltaOffset = chunkOffset;
+
+    MUTEX_LOCK(pTwccManager->lock);
+    locked = TRUE;
+
+    for (chunkOffset = TWCC_FEEDBACK_HEADER_LEN, reportedCount = 0; reportedCount < statusCount; chunkOffset += TWCC_FEEDBACK_CHUNK_LEN) {
+        chunk = getUnalignedInt16BigEndian(pPayload + chunkOffset);
+        chunkCount = MIN(twcc_manager_getChunkStatusCount(chunk), statusCount - reportedCount);
+        for (i = 0; i < chunkCount; i++, reportedCount++, seqNum = GET_UINT16_SEQ_NUM(seqNum + 1)) {
+            status = twcc_manager_getChunkStatus(chunk, i);
+            if (status == TWCC_PACKET_STATUS_SMALL_DELTA) {
+                CHK(deltaOffset + 1 <= payloadLen, STATUS_RTCP_INPUT_TWCC_INVALID);
+                delta = pPayload[deltaOffset];
+                deltaOffset += 1;
+            } else if (status == TWCC_PACKET_STATUS_LARGE_DELTA) {
+                CHK(deltaOffset + 2 <= payloadLen, STATUS_RTCP_INPUT_TWCC_INVALID);
+                delta = (INT16) getUnalignedInt16BigEndian(pPayload + deltaOffset);
+                deltaOffset += 2;
+            } else {
+                CHK(status == TWCC_PACKET_STATUS_NOT_RECEIVED, STATUS_RTCP_INPUT_TWCC_INVALID);
+                delta = 0;
+            }
+            receiveTime += delta * TWCC_FEEDBACK_DELTA_UNIT;
+
+            pPacketInfo = &pTwccManager->history[seqNum % TWCC_SEND_HISTORY_SIZE];
+            // Not sent by us, overwritten already or reported by an earlier feedback
+            if (pPacketInfo->sendTime == 0 || pPacketInfo->seqNum != seqNum || pPacketInfo->reported) {
+                continue;
+            }
+            pPacketInfo->reported = TRUE;
+            if (status == TWCC_PACKET_STATUS_NOT_RECEIVED) {
+                lostCount++;
+                continue;
+            }
+
+            pPacketInfo->received = TRUE;
+            pPacketInfo->receiveTime = receiveTime;
+            if (receivedCount == 0 || receiveTime < firstReceiveTime) {
+                firstReceiveTime = receiveTime;
+            }
+            if (receivedCount == 0 || receiveTime > lastReceiveTime) {
+                lastReceiveTime = receiveTime;
+            }
+            receivedCount++;
+            ackedBytes += pPacketInfo->packetSize;
+            twcc_manager_onPacketArrival(pTwccManager, pPacketInfo->sendTime, receiveTime, currentTime);
+        }
+    }
+
+    CHK(receivedCount + lostCount > 0, retStatus);
+    pTwccManager->fractionLost = (DOUBLE) lostCount / (receivedCount + lostCount);
+    if (receivedCount > 1 && lastReceiveTime > firstReceiveTime) {
+        bitrate = (DOUBLE) ackedBytes * 8 * HUNDREDS_OF_NANOS_IN_A_SECOND / (lastReceiveTime - firstReceiveTime);
+        pTwccManager->ackedBitrate = pTwccManager->ackedBitrate == 0
+            ? bitrate
+            : TWCC_ACKED_BITRATE_SMOOTHING * pTwccManager->ackedBitrate + (1 - TWCC_ACKED_BITRATE_SMOOTHING) * bitrate;
+    }
+    twcc_manager_updateTargetBitrate(pTwccManager, currentTime);
+
+    targetBitrate = pTwccManager->targetBitrate;
+    bitrate = (DOUBLE) targetBitrate - (DOUBLE) pTwccManager->reportedBitrate;
+    if (ABS(bitrate) > TWCC_TARGET_BITRATE_REPORT_FRACTION * pTwccManager->reportedBitrate) {
+        pTwccManager->reportedBitrate = targetBitrate;
+        notify = TRUE;
+    }
+
+CleanUp:
+    if (locked) {
+        MUTEX_UNLOCK(pTwccManager->lock);
+    }
+    if (notify && pTwccManager->onTargetBitrateFn != NULL) {
+        pTwccManager->onTargetBitrateFn(pTwccManager->customData, targetBitrate);
+    }
+
+    return retStatus;
+}
+
+STATUS twcc_manager_getSequenceNumber(PRtpPacket pRtpPacket, UINT8 extId, PUINT16 pSeqNum)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PBYTE pData = NULL;
+    UINT8 dataLen = 0;
+
+    CHK(pRtpPacket != NULL && pSeqNum != NULL, STATUS_NULL_ARG);
+    CHK_STATUS(rtp_packet_getExtension(pRtpPacket, extId, &pData, &dataLen));
+    CHK(dataLen >= SIZEOF(UINT16), STATUS_RTP_INVALID_EXTENSION_LEN);
+    *pSeqNum = getUnalignedInt16BigEndian(pData);
+
+CleanUp:
+    return retStatus;
+}
+
+/**
+ * @brief pack the statuses into chunks, long runs into run length chunks and the rest into status vector chunks.
+ *
+ * @return the length of the chunks.
+ */
+static UINT32 twcc_receiver_encodeChunks(PUINT8 pStatuses, UINT32 statusCount, PBYTE pBuffer)
+{
+    UINT32 i = 0, j, runLength, symbolCount, offset = 0;
+    UINT16 chunk;
+
+    while (i < statusCount) {
+        for (runLength = 1; i + runLength < statusCount && pStatuses[i + runLength] == pStatuses[i] && runLength < TWCC_FEEDBACK_RUN_LENGTH_MASK;
+             runLength++) {
+        }
+
+        if (runLength >= TWCC_FEEDBACK_MIN_RUN_LENGTH) {
+            chunk = (UINT16) ((pStatuses[i] << 13) | runLength);
+            i += runLength;
+        } else {
+            // One-bit symbols can not tell a large delta apart
+            symbolCount = 14;
+            for (j = 0; j < 14 && i + j < statusCount; j++) {
+                if (pStatuses[i + j] == TWCC_PACKET_STATUS_LARGE_DELTA) {
+                    symbolCount = 7;
+                }
+            }
+            chunk = symbolCount == 14 ? TWCC_FEEDBACK_CHUNK_TYPE_MASK : TWCC_FEEDBACK_CHUNK_TYPE_MASK | TWCC_FEEDBACK_SYMBOL_SIZE_MASK;
+            for (j = 0; j < symbolCount && i < statusCount; j++, i++) {
+                chunk |= symbolCount == 14 ? pStatuses[i] << (13 - j) : pStatuses[i] << (12 - 2 * j);
+            }
+        }
+
+        putUnalignedInt16BigEndian(pBuffer + offset, chunk);
+        offset += TWCC_FEEDBACK_CHUNK_LEN;
+    }
+
+    return offset;
+}
+
+STATUS twcc_receiver_create(PTwccReceiver* ppTwccReceiver)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PTwccReceiver pTwccReceiver = NULL;
+
+    CHK(ppTwccReceiver != NULL, STATUS_NULL_ARG);
+
+    pTwccReceiver = (PTwccReceiver) MEMCALLOC(1, SIZEOF(TwccReceiver));
+    CHK(pTwccReceiver != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    pTwccReceiver->lock = MUTEX_CREATE(FALSE);
+    CHK(IS_VALID_MUTEX_VALUE(pTwccReceiver->lock), STATUS_INVALID_OPERATION);
+    pTwccReceiver->senderSsrc = (UINT32) RAND();
+
+CleanUp:
+    if (STATUS_FAILED(retStatus)) {
+        twcc_receiver_free(&pTwccReceiver);
+    }
+
+    if (ppTwccReceiver != NULL) {
+        *ppTwccReceiver = pTwccReceiver;
+    }
+    LEAVES();
+    return retStatus;
+}
+
+STATUS twcc_receiver_free(PTwccReceiver* ppTwccReceiver)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PTwccReceiver pTwccReceiver = NULL;
+
+    CHK(ppTwccReceiver != NULL, STATUS_NULL_ARG);
+    pTwccReceiver = *ppTwccReceiver;
+    CHK(pTwccReceiver != NULL, retStatus);
+
+    if (IS_VALID_MUTEX_VALUE(pTwccReceiver->lock)) {
+        MUTEX_FREE(pTwccReceiver->lock);
+    }
+    SAFE_MEMFREE(*ppTwccReceiver);
+
+CleanUp:
+    CHK_LOG_ERR(retStatus);
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS twcc_receiver_onPacketReceived(PTwccReceiver pTwccReceiver, UINT32 mediaSsrc, UINT16 seqNum, UINT64 arrivalTime)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT16 distance;
+
+    CHK(pTwccReceiver != NULL, STATUS_NULL_ARG);
+
+    MUTEX_LOCK(pTwccReceiver->lock);
+    if (!pTwccReceiver->started) {
+        pTwccReceiver->started = TRUE;
+        pTwccReceiver->nextSeqNum = seqNum;
+        pTwccReceiver->highestSeqNum = seqNum;
+    }
+
+    distance = GET_UINT16_SEQ_NUM(seqNum - pTwccReceiver->nextSeqNum);
+    // Older than the last feedback, it was reported as lost already
+    if (distance < MAX_INT16) {
+        if (distance >= TWCC_RECEIVE_HISTORY_SIZE) {
+            // A jump beyond the history, the packets in between are never reported
+            MEMSET(pTwccReceiver->arrivalTimes, 0x00, SIZEOF(pTwccReceiver->arrivalTimes));
+            pTwccReceiver->nextSeqNum = seqNum;
+            pTwccReceiver->highestSeqNum = seqNum;
+        }
+        pTwccReceiver->arrivalTimes[seqNum % TWCC_RECEIVE_HISTORY_SIZE] = arrivalTime;
+        if (GET_UINT16_SEQ_NUM(seqNum - pTwccReceiver->highestSeqNum) < MAX_INT16) {
+            pTwccReceiver->highestSeqNum = seqNum;
+        }
+        pTwccReceiver->mediaSsrc = mediaSsrc;
+    }
+    MUTEX_UNLOCK(pTwccReceiver->lock);
+
+CleanUp:
+    return retStatus;
+}
+
+STATUS twcc_receiver_createFeedback(PTwccReceiver pTwccReceiver, PBYTE pBuffer, PUINT32 pPacketLen, PBOOL pMore)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    BOOL locked = FALSE;
+    UINT8 statuses[TWCC_FEEDBACK_MAX_STATUS_COUNT];
+    BYTE deltas[TWCC_FEEDBACK_MAX_STATUS_COUNT * 2];
+    UINT16 distance;
+    UINT32 i, statusCount, deltaLen = 0, packetLen = 0, paddingLen;
+    UINT64 arrivalTime;
+    INT64 referenceTime = -1, prevTicks = 0, ticks, delta;
+    PUINT64 pArrivalTime;
+
+    CHK(pTwccReceiver != NULL && pBuffer != NULL && pPacketLen != NULL, STATUS_NULL_ARG);
+
+    MUTEX_LOCK(pTwccReceiver->lock);
+    locked = TRUE;
+
+    // Once everything is reported the next sequence number is one past the highest one
+    distance = GET_UINT16_SEQ_NUM(pTwccReceiver->highestSeqNum - pTwccReceiver->nextSeqNum);
+    CHK(pTwccReceiver->started && distance < TWCC_RECEIVE_HISTORY_SIZE, retStatus);
+    statusCount = MIN(distance + 1, TWCC_FEEDBACK_MAX_STATUS_COUNT);
+
+    for (i = 0; i < statusCount; i++) {
+        arrivalTime = pTwccReceiver->arrivalTimes[GET_UINT16_SEQ_NUM(pTwccReceiver->nextSeqNum + i) % TWCC_RECEIVE_HISTORY_SIZE];
+        if (arrivalTime == 0) {
+            statuses[i] = TWCC_PACKET_STATUS_NOT_RECEIVED;
+            continue;
+        }
+
+        ticks = (INT64) (arrivalTime / TWCC_FEEDBACK_DELTA_UNIT);
+        if (referenceTime < 0) {
+            referenceTime = (INT64) (arrivalTime / TWCC_FEEDBACK_REFERENCE_TIME_UNIT);
+            prevTicks = referenceTime * TWCC_FEEDBACK_DELTAS_PER_TICK;
+        }
+        delta = ticks - prevTicks;
+        if (delta >= 0 && delta <= MAX_UINT8) {
+            statuses[i] = TWCC_PACKET_STATUS_SMALL_DELTA;
+            deltas[deltaLen++] = (BYTE) delta;
+        } else if (delta >= MIN_INT16 && delta <= MAX_INT16) {
+            statuses[i] = TWCC_PACKET_STATUS_LARGE_DELTA;
+            putUnalignedInt16BigEndian(deltas + deltaLen, (UINT16) (INT16) delta);
+            deltaLen += 2;
+        } else {
+            // Out of the range of a delta, the next feedback starts over from a reference time of its own
+            break;
+        }
+        prevTicks = ticks;
+    }
+    statusCount = i;
+
+    /*
+     *  0                   1                   2                   3
+     *  0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+     * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+     * |V=2|P|  FMT=15 |    PT=205     |           length              |
+     * +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+     */
+    pBuffer[0] = (RTCP_PACKET_VERSION_VAL << 6) | TWCC_FEEDBACK_FMT;
+    pBuffer[RTCP_PACKET_TYPE_OFFSET] = RTCP_PACKET_TYPE_GENERIC_RTP_FEEDBACK;
+    packetLen = RTCP_PACKET_HEADER_LEN;
+    putUnalignedInt32BigEndian(pBuffer + packetLen, pTwccReceiver->senderSsrc);
+    putUnalignedInt32BigEndian(pBuffer + packetLen + 4, pTwccReceiver->mediaSsrc);
+    putUnalignedInt16BigEndian(pBuffer + packetLen + 8, pTwccReceiver->nextSeqNum);
+    putUnalignedInt16BigEndian(pBuffer + packetLen + 10, (UINT16) statusCount);
+    putUnalignedInt32BigEndian(pBuffer + packetLen + 12, (UINT32) ((MAX(referenceTime, 0) & 0xFFFFFF) << 8) | pTwccReceiver->feedbackCount);
+    packetLen += TWCC_FEEDBACK_HEADER_LEN;
+    packetLen += twcc_receiver_encodeChunks(statuses, statusCount, pBuffer + packetLen);
+    MEMCPY(pBuffer + packetLen, deltas, deltaLen);
+    packetLen += deltaLen;
+
+    // Pad to a multiple of 32 bits, the last byte of the padding holds its length
+    paddingLen = (RTCP_PACKET_LEN_WORD_SIZE - packetLen % RTCP_PACKET_LEN_WORD_SIZE) % RTCP_PACKET_LEN_WORD_SIZE;
+    if (paddingLen > 0) {
+        MEMSET(pBuffer + packetLen, 0x00, paddingLen);
+        packetLen += paddingLen;
+        pBuffer[packetLen - 1] = (BYTE) paddingLen;
+        pBuffer[0] |= 0x20;
+    }
+    putUnalignedInt16BigEndian(pBuffer + RTCP_PACKET_LEN_OFFSET, (UINT16) (packetLen / RTCP_PACKET_LEN_WORD_SIZE - 1));
+
+    for (i = 0; i < statusCount; i++) {
+        pArrivalTime = &pTwccReceiver->arrivalTimes[GET_UINT16_SEQ_NUM(pTwccReceiver->nextSeqNum + i) % TWCC_RECEIVE_HISTORY_SIZE];
+        *pArrivalTime = 0;
+    }
+    pTwccReceiver->nextSeqNum = GET_UINT16_SEQ_NUM(pTwccReceiver->nextSeqNum + statusCount);
+    pTwccReceiver->feedbackCount++;
+
+CleanUp:
+    if (pMore != NULL) {
+        *pMore = pTwccReceiver != NULL && pTwccReceiver->started &&
+            GET_UINT16_SEQ_NUM(pTwccReceiver->highestSeqNum - pTwccReceiver->nextSeqNum) < TWCC_RECEIVE_HISTORY_SIZE;
+    }
+    if (locked) {
+        MUTEX_UNLOCK(pTwccReceiver->lock);
+    }
+    if (pPacketLen != NULL) {
+        *pPacketLen = packetLen;
+    }
+
+    return retStatus;
+}
+#endif
@@ -0,0 +1,269 @@
+/*
+ * Copyright 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+#ifndef __KINESIS_VIDEO_WEBRTC_CLIENT_PEERCONNECTION_TWCC_MANAGER__
+#define __KINESIS_VIDEO_WEBRTC_CLIENT_PEERCONNECTION_TWCC_MANAGER__
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/******************************************************************************
+ * HEADERS
+ ******************************************************************************/
+#include "kvs/error.h"
+#include "kvs/common_defs.h"
+#include "kvs/platform_utils.h"
+#include "RtpPacket.h"
+#include "RtcpPacket.h"
+#include "RtpExtension.h"
+
+/******************************************************************************
+ * DEFINITIONS
+ ******************************************************************************/
+// One-byte header of the element, the 16-bit sequence number and one byte of padding
+#define TWCC_EXT_PAYLOAD_LEN 4
+// The bytes the extension adds to every rtp packet, the extension header and its payload
+#define TWCC_EXT_OVERHEAD (4 + TWCC_EXT_PAYLOAD_LEN)
+
+// Number of sent packets remembered until their feedback arrives, indexed by the low bits of the transport-wide sequence number
+#define TWCC_SEND_HISTORY_SIZE 1024
+
+// RTCP transport feedback, https://tools.ietf.org/html/draft-holmer-rmcat-transport-wide-cc-extensions-01#section-3.1
+#define TWCC_FEEDBACK_FMT                 15
+#define TWCC_FEEDBACK_HEADER_LEN          16 //!< sender ssrc, media ssrc, base sequence number, status count, reference time and fb count.
+#define TWCC_FEEDBACK_CHUNK_LEN           2
+#define TWCC_FEEDBACK_REFERENCE_TIME_UNIT (64 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+#define TWCC_FEEDBACK_DELTA_UNIT          2500 //!< 250 microseconds in 100ns
+#define TWCC_FEEDBACK_CHUNK_TYPE_MASK     0x8000
+#define TWCC_FEEDBACK_RUN_LENGTH_MASK     0x1FFF
+#define TWCC_FEEDBACK_SYMBOL_SIZE_MASK    0x4000
+
+typedef enum {
+    TWCC_PACKET_STATUS_NOT_RECEIVED = 0,
+    TWCC_PACKET_STATUS_SMALL_DELTA = 1,
+    TWCC_PACKET_STATUS_LARGE_DELTA = 2,
+} TWCC_PACKET_STATUS;
+
+// Delay-based estimation, https://tools.ietf.org/html/draft-ietf-rmcat-gcc-02
+// Packets sent within this window form one group, the delay variation is measured between groups
+#define TWCC_BURST_INTERVAL              (5 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+#define TWCC_TRENDLINE_WINDOW_SIZE       20
+#define TWCC_TRENDLINE_SMOOTHING         0.9
+#define TWCC_TRENDLINE_THRESHOLD_GAIN    4.0
+#define TWCC_MAX_TREND_DELTAS            60
+#define TWCC_INITIAL_THRESHOLD           12.5
+#define TWCC_MIN_THRESHOLD               6.0
+#define TWCC_MAX_THRESHOLD               600.0
+#define TWCC_THRESHOLD_GAIN_UP           0.0087
+#define TWCC_THRESHOLD_GAIN_DOWN         0.039
+#define TWCC_MAX_THRESHOLD_ADAPT_OFFSET  15.0
+#define TWCC_MAX_THRESHOLD_ADAPT_TIME_MS 100.0
+#define TWCC_OVERUSE_TIME_THRESHOLD_MS   10.0
+
+// Rate control
+#define TWCC_DEFAULT_MIN_BITRATE            (30 * 1024)
+#define TWCC_DEFAULT_START_BITRATE          (300 * 1024)
+#define TWCC_DEFAULT_MAX_BITRATE            (5 * 1024 * 1024)
+#define TWCC_DECREASE_FACTOR                0.85
+#define TWCC_INCREASE_FACTOR_PER_SECOND     1.08
+#define TWCC_MIN_DECREASE_INTERVAL          (200 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+#define TWCC_ACKED_BITRATE_HEADROOM         1.5
+#define TWCC_ACKED_BITRATE_SMOOTHING        0.8
+#define TWCC_LOSS_UPDATE_INTERVAL           (100 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+#define TWCC_LOW_LOSS_THRESHOLD             0.02
+#define TWCC_HIGH_LOSS_THRESHOLD            0.1
+#define TWCC_LOSS_BASED_INCREASE_FACTOR     1.05
+// The target is reported again only when it moves by more than this fraction
+#define TWCC_TARGET_BITRATE_REPORT_FRACTION 0.05
+
+// Feedback generation on the receiving side
+#define TWCC_FEEDBACK_INTERVAL         (100 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+#define TWCC_RECEIVE_HISTORY_SIZE      1024
+#define TWCC_FEEDBACK_MAX_STATUS_COUNT 256
+// Runs shorter than this are packed into status vector chunks
+#define TWCC_FEEDBACK_MIN_RUN_LENGTH 7
+#define TWCC_FEEDBACK_DELTAS_PER_TICK 256 //!< 250 microsecond deltas in the 64ms of a reference time tick
+// The rtcp header, the fixed fields, a chunk for every 7 packets, a large delta for every packet and the padding
+#define TWCC_FEEDBACK_MAX_LEN                                                                                                                        \
+    (RTCP_PACKET_HEADER_LEN + TWCC_FEEDBACK_HEADER_LEN + (TWCC_FEEDBACK_MAX_STATUS_COUNT / 7 + 1) * TWCC_FEEDBACK_CHUNK_LEN +                         \
+     TWCC_FEEDBACK_MAX_STATUS_COUNT * 2 + RTCP_PACKET_LEN_WORD_SIZE)
+
+typedef enum {
+    TWCC_BANDWIDTH_USAGE_NORMAL,
+    TWCC_BANDWIDTH_USAGE_UNDERUSING,
+    TWCC_BANDWIDTH_USAGE_OVERUSING,
+} TWCC_BANDWIDTH_USAGE;
+
+/**
+ * @brief called with the new target bitrate in bits per second, outside of the lock of the manager.
+ */
+typedef VOID (*TwccOnTargetBitrateFunc)(UINT64, UINT64);
+
+typedef struct {
+    UINT64 sendTime;    //!< 0 if the slot is unused.
+    INT64 receiveTime;  //!< the arrival time in the clock of the remote peer, valid if received is set.
+    UINT32 packetSize;  //!< the bytes on the wire.
+    UINT16 seqNum;      //!< the transport-wide sequence number of the packet in the slot.
+    BOOL received;
+    BOOL reported;      //!< feedback for the packet has been processed.
+} TwccPacketInfo, *PTwccPacketInfo;
+
+/**
+ * Sender side of transport-wide congestion control. Remembers when every packet carrying the transport-wide sequence number
+ * was sent, matches the feedback of the receiver against it and estimates the target bitrate from the delay variation and
+ * the loss, the way google congestion control does.
+ */
+typedef struct __TwccManager {
+    MUTEX lock;
+    UINT16 nextSequenceNumber; //!< handed out by the writer of the packets under the srtp session lock.
+    TwccPacketInfo history[TWCC_SEND_HISTORY_SIZE];
+
+    // Arrival time grouping
+    BOOL hasGroup;
+    BOOL hasPrevGroup;
+    UINT64 groupFirstSendTime;
+    UINT64 groupLastSendTime;
+    INT64 groupLastReceiveTime;
+    UINT64 prevGroupLastSendTime;
+    INT64 prevGroupLastReceiveTime;
+
+    // Trendline filter, in milliseconds
+    INT64 firstReceiveTime;
+    DOUBLE accumulatedDelay;
+    DOUBLE smoothedDelay;
+    DOUBLE trendX[TWCC_TRENDLINE_WINDOW_SIZE];
+    DOUBLE trendY[TWCC_TRENDLINE_WINDOW_SIZE];
+    UINT32 trendCount;
+    UINT32 trendIndex;
+    UINT32 numDeltas;
+    DOUBLE trend;
+    DOUBLE prevTrend;
+
+    // Overuse detector
+    DOUBLE threshold;
+    UINT64 lastThresholdUpdateTime;
+    DOUBLE overuseTime;
+    UINT32 overuseCount;
+    TWCC_BANDWIDTH_USAGE usage;
+
+    // Rate control, bits per second
+    UINT64 minBitrate;
+    UINT64 maxBitrate;
+    UINT64 delayBasedBitrate;
+    UINT64 lossBasedBitrate;
+    UINT64 targetBitrate;
+    UINT64 reportedBitrate;
+    DOUBLE ackedBitrate;
+    UINT64 lastRateUpdateTime;
+    UINT64 lastDecreaseTime;
+    UINT64 lastLossUpdateTime;
+    DOUBLE fractionLost;
+
+    TwccOnTargetBitrateFunc onTargetBitrateFn;
+    UINT64 customData;
+} TwccManager, *PTwccManager;
+
+/**
+ * Receiving side of transport-wide congestion control. Remembers when the packets carrying the transport-wide sequence number
+ * arrived and reports them back to the sender in transport feedback packets.
+ */
+typedef struct __TwccReceiver {
+    MUTEX lock;
+    UINT32 senderSsrc;   //!< the ssrc of the feedback packets.
+    UINT32 mediaSsrc;    //!< the ssrc of the last media packet which carried the extension.
+    BOOL started;        //!< a packet carrying the extension has been received.
+    UINT16 nextSeqNum;   //!< the first sequence number the next feedback reports.
+    UINT16 highestSeqNum;
+    UINT8 feedbackCount; //!< the feedback packet count, wraps at 255.
+    UINT64 arrivalTimes[TWCC_RECEIVE_HISTORY_SIZE]; //!< indexed by the low bits of the sequence number, 0 if not received.
+} TwccReceiver, *PTwccReceiver;
+
+/******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+/**
+ * @brief create the sender side of transport-wide congestion control.
+ *
+ * @param[in] onTargetBitrateFn the callback of the target bitrate, can be NULL.
+ * @param[in] customData the custom data of onTargetBitrateFn.
+ * @param[out] ppTwccManager the created manager.
+ *
+ * @return STATUS status of execution
+ */
+STATUS twcc_manager_create(TwccOnTargetBitrateFunc, UINT64, PTwccManager*);
+STATUS twcc_manager_free(PTwccManager*);
+/**
+ * @brief remember that a packet left the socket.
+ *
+ * @param[in] pTwccManager the manager.
+ * @param[in] seqNum the transport-wide sequence number of the packet.
+ * @param[in] packetSize the bytes on the wire.
+ * @param[in] sendTime the time the packet was sent.
+ *
+ * @return STATUS status of execution
+ */
+STATUS twcc_manager_onPacketSent(PTwccManager, UINT16, UINT32, UINT64);
+/**
+ * @brief process the payload of a transport feedback rtcp packet and update the target bitrate.
+ *
+ * @param[in] pTwccManager the manager.
+ * @param[in] pPayload the rtcp payload, starting at the ssrc of the packet sender.
+ * @param[in] payloadLen the length of the payload.
+ * @param[in] currentTime the current time.
+ *
+ * @return STATUS status of execution
+ */
+STATUS twcc_manager_onFeedback(PTwccManager, PBYTE, UINT32, UINT64);
+/**
+ * @brief read the transport-wide sequence number out of the header extension of a packet.
+ *
+ * @param[in] pRtpPacket the rtp packet.
+ * @param[in] extId the negotiated id of the extension.
+ * @param[out] pSeqNum the transport-wide sequence number.
+ *
+ * @return STATUS_RTP_EXTENSION_NOT_FOUND if the packet does not carry it.
+ */
+STATUS twcc_manager_getSequenceNumber(PRtpPacket, UINT8, PUINT16);
+STATUS twcc_receiver_create(PTwccReceiver*);
+STATUS twcc_receiver_free(PTwccReceiver*);
+/**
+ * @brief remember the arrival of a packet carrying the transport-wide sequence number.
+ *
+ * @param[in] pTwccReceiver the receiver.
+ * @param[in] mediaSsrc the ssrc of the packet.
+ * @param[in] seqNum the transport-wide sequence number of the packet.
+ * @param[in] arrivalTime the time the packet arrived.
+ *
+ * @return STATUS status of execution
+ */
+STATUS twcc_receiver_onPacketReceived(PTwccReceiver, UINT32, UINT16, UINT64);
+/**
+ * @brief build the next transport feedback rtcp packet, it reports the packets from the last reported one up to the highest
+ *        received one, at most TWCC_FEEDBACK_MAX_STATUS_COUNT of them.
+ *
+ * @param[in] pTwccReceiver the receiver.
+ * @param[in] pBuffer the buffer of the packet, at least TWCC_FEEDBACK_MAX_LEN bytes.
+ * @param[out] pPacketLen the length of the packet, 0 if there is nothing to report.
+ * @param[out] pMore whether packets are left for another feedback.
+ *
+ * @return STATUS status of execution
+ */
+STATUS twcc_receiver_createFeedback(PTwccReceiver, PBYTE, PUINT32, PBOOL);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* __KINESIS_VIDEO_WEBRTC_CLIENT_PEERCONNECTION_TWCC_MANAGER__ */
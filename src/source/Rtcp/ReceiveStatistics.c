@@ -0,0 +1,136 @@
+/*
+ * Copyright 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+/******************************************************************************
+ * HEADERS
+ ******************************************************************************/
+#define LOG_CLASS "ReceiveStatistics"
+
+#include "endianness.h"
+#include "ReceiveStatistics.h"
+#include "time_port.h"
+
+/******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+static VOID receive_statistics_start(PReceiveStatistics pReceiveStatistics, UINT16 sequenceNumber)
+{
+    pReceiveStatistics->started = TRUE;
+    pReceiveStatistics->baseSeq = sequenceNumber;
+    pReceiveStatistics->maxSeq = sequenceNumber;
+    pReceiveStatistics->badSeq = RECEIVE_STATISTICS_SEQ_MOD + 1;
+    pReceiveStatistics->cycles = 0;
+    pReceiveStatistics->received = 0;
+    pReceiveStatistics->expectedPrior = 0;
+    pReceiveStatistics->receivedPrior = 0;
+}
+
+VOID receive_statistics_reset(PReceiveStatistics pReceiveStatistics)
+{
+    if (pReceiveStatistics != NULL) {
+        MEMSET(pReceiveStatistics, 0x00, SIZEOF(ReceiveStatistics));
+    }
+}
+
+VOID receive_statistics_onPacket(PReceiveStatistics pReceiveStatistics, UINT16 sequenceNumber)
+{
+    UINT16 delta;
+
+    if (pReceiveStatistics == NULL) {
+        return;
+    }
+    if (!pReceiveStatistics->started) {
+        receive_statistics_start(pReceiveStatistics, sequenceNumber);
+    }
+
+    // https://tools.ietf.org/html/rfc3550#appendix-A.1
+    delta = sequenceNumber - pReceiveStatistics->maxSeq;
+    if (delta < RECEIVE_STATISTICS_MAX_DROPOUT) {
+        // in order, with a permissible gap
+        if (sequenceNumber < pReceiveStatistics->maxSeq) {
+            pReceiveStatistics->cycles += RECEIVE_STATISTICS_SEQ_MOD;
+        }
+        pReceiveStatistics->maxSeq = sequenceNumber;
+    } else if (delta <= RECEIVE_STATISTICS_SEQ_MOD - RECEIVE_STATISTICS_MAX_MISORDER) {
+        // A very large jump is taken for a restart of the sender only once the next packet follows on from it
+        if (sequenceNumber != pReceiveStatistics->badSeq) {
+            pReceiveStatistics->badSeq = (sequenceNumber + 1) & (RECEIVE_STATISTICS_SEQ_MOD - 1);
+            return;
+        }
+        receive_statistics_start(pReceiveStatistics, sequenceNumber);
+    }
+    // else a duplicate or a reordered packet
+    pReceiveStatistics->received++;
+}
+
+VOID receive_statistics_onSenderReport(PReceiveStatistics pReceiveStatistics, UINT64 ntpTime, UINT64 arrivalTime)
+{
+    if (pReceiveStatistics != NULL) {
+        pReceiveStatistics->lastSenderReport = MID_NTP(ntpTime);
+        pReceiveStatistics->lastSenderReportTime = arrivalTime;
+    }
+}
+
+INT64 receive_statistics_getPacketsLost(PReceiveStatistics pReceiveStatistics)
+{
+    if (pReceiveStatistics == NULL || !pReceiveStatistics->started) {
+        return 0;
+    }
+
+    return (INT64) pReceiveStatistics->cycles + pReceiveStatistics->maxSeq - pReceiveStatistics->baseSeq + 1 - pReceiveStatistics->received;
+}
+
+STATUS receive_statistics_createReportBlock(PReceiveStatistics pReceiveStatistics, UINT32 ssrc, UINT32 jitter, UINT64 currentTime,
+                                            PBYTE pReportBlock)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 extendedMax, expected, expectedInterval, receivedInterval, fractionLost = 0, delaySinceLastSR = 0;
+    INT32 lostInterval;
+    INT64 lost;
+
+    CHK(pReceiveStatistics != NULL && pReportBlock != NULL, STATUS_NULL_ARG);
+    CHK(pReceiveStatistics->started, STATUS_INVALID_OPERATION);
+
+    // https://tools.ietf.org/html/rfc3550#appendix-A.3
+    extendedMax = pReceiveStatistics->cycles + pReceiveStatistics->maxSeq;
+    expected = extendedMax - pReceiveStatistics->baseSeq + 1;
+    lost = receive_statistics_getPacketsLost(pReceiveStatistics);
+    lost = MIN(MAX(lost, RECEIVE_STATISTICS_MIN_LOST), RECEIVE_STATISTICS_MAX_LOST);
+
+    expectedInterval = expected - pReceiveStatistics->expectedPrior;
+    pReceiveStatistics->expectedPrior = expected;
+    receivedInterval = pReceiveStatistics->received - pReceiveStatistics->receivedPrior;
+    pReceiveStatistics->receivedPrior = pReceiveStatistics->received;
+    lostInterval = (INT32) (expectedInterval - receivedInterval);
+    if (expectedInterval != 0 && lostInterval > 0) {
+        fractionLost = ((UINT32) lostInterval << RECEIVE_STATISTICS_FRACTION_BITS) / expectedInterval;
+    }
+
+    // https://tools.ietf.org/html/rfc3550#section-6.4.1 the delay is expressed in units of 1/65536 seconds
+    if (pReceiveStatistics->lastSenderReport != 0) {
+        delaySinceLastSR = (UINT32) KVS_CONVERT_TIMESCALE((currentTime - pReceiveStatistics->lastSenderReportTime), HUNDREDS_OF_NANOS_IN_A_SECOND,
+                                                          DLSR_TIMESCALE);
+    }
+
+    putUnalignedInt32BigEndian(pReportBlock, ssrc);
+    putUnalignedInt32BigEndian(pReportBlock + 4, (fractionLost << 24) | ((UINT32) lost & RECEIVE_STATISTICS_LOST_BITMASK));
+    putUnalignedInt32BigEndian(pReportBlock + 8, extendedMax);
+    putUnalignedInt32BigEndian(pReportBlock + 12, jitter);
+    putUnalignedInt32BigEndian(pReportBlock + 16, pReceiveStatistics->lastSenderReport);
+    putUnalignedInt32BigEndian(pReportBlock + 20, delaySinceLastSR);
+
+CleanUp:
+
+    return retStatus;
+}
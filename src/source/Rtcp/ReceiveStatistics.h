@@ -0,0 +1,101 @@
+/*
+ * Copyright 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+#ifndef __KINESIS_VIDEO_WEBRTC_CLIENT_RTCP_RECEIVESTATISTICS_H
+#define __KINESIS_VIDEO_WEBRTC_CLIENT_RTCP_RECEIVESTATISTICS_H
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/******************************************************************************
+ * HEADERS
+ ******************************************************************************/
+#include "kvs/error.h"
+#include "kvs/common_defs.h"
+#include "kvs/platform_utils.h"
+#include "RtcpPacket.h"
+
+/******************************************************************************
+ * DEFINITIONS
+ ******************************************************************************/
+// https://tools.ietf.org/html/rfc3550#appendix-A.1
+#define RECEIVE_STATISTICS_SEQ_MOD       (1 << 16)
+#define RECEIVE_STATISTICS_MAX_DROPOUT   3000
+#define RECEIVE_STATISTICS_MAX_MISORDER  100
+#define RECEIVE_STATISTICS_MAX_LOST      0x7FFFFF
+#define RECEIVE_STATISTICS_MIN_LOST      (-0x800000)
+#define RECEIVE_STATISTICS_LOST_BITMASK  0xFFFFFF
+#define RECEIVE_STATISTICS_FRACTION_BITS 8
+
+/**
+ * The reception of an rtp stream as a receiver report block tells it, https://tools.ietf.org/html/rfc3550#appendix-A.3
+ */
+typedef struct {
+    BOOL started;                //!< whether a packet has been received.
+    UINT16 maxSeq;               //!< the highest sequence number received.
+    UINT32 cycles;               //!< the sequence number cycles, shifted up by 16 bits.
+    UINT32 baseSeq;              //!< the first sequence number received.
+    UINT32 badSeq;               //!< the sequence number after a large jump, the stream restarts if it follows on from it.
+    UINT32 received;             //!< the packets received.
+    UINT32 expectedPrior;        //!< the packets expected at the last report.
+    UINT32 receivedPrior;        //!< the packets received at the last report.
+    UINT32 lastSenderReport;     //!< the middle 32 bits of the ntp timestamp of the last sender report, 0 before the first one.
+    UINT64 lastSenderReportTime; //!< when the last sender report was received, in 100ns.
+} ReceiveStatistics, *PReceiveStatistics;
+
+/******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+/**
+ * @brief forget the stream, the next packet starts it over.
+ */
+VOID receive_statistics_reset(PReceiveStatistics);
+/**
+ * @brief count a packet of the stream.
+ *
+ * @param[in] pReceiveStatistics the statistics of the stream.
+ * @param[in] sequenceNumber the sequence number of the packet.
+ */
+VOID receive_statistics_onPacket(PReceiveStatistics, UINT16);
+/**
+ * @brief remember the last sender report of the stream, the next report block echoes it so that the sender measures the round trip time.
+ *
+ * @param[in] pReceiveStatistics the statistics of the stream.
+ * @param[in] ntpTime the ntp timestamp of the sender report.
+ * @param[in] arrivalTime when the sender report was received, in 100ns.
+ */
+VOID receive_statistics_onSenderReport(PReceiveStatistics, UINT64, UINT64);
+/**
+ * @return the packets lost since the stream started, negative if duplicates were received.
+ */
+INT64 receive_statistics_getPacketsLost(PReceiveStatistics);
+/**
+ * @brief write the report block of the stream, the fraction lost covers the packets since the last report block.
+ *
+ * @param[in] pReceiveStatistics the statistics of the stream.
+ * @param[in] ssrc the ssrc of the stream.
+ * @param[in] jitter the interarrival jitter, in timestamp units.
+ * @param[in] currentTime the current time, in 100ns.
+ * @param[out] pReportBlock RTCP_PACKET_RECEIVER_REPORT_BLOCK_LEN bytes.
+ *
+ * @return STATUS status of execution
+ */
+STATUS receive_statistics_createReportBlock(PReceiveStatistics, UINT32, UINT32, UINT64, PBYTE);
+
+#ifdef __cplusplus
+}
+#endif
+#endif //__KINESIS_VIDEO_WEBRTC_CLIENT_RTCP_RECEIVESTATISTICS_H
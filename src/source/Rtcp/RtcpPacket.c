@@ -169,6 +169,32 @@ CleanUp:
     return retStatus;
 }
 
+STATUS rtcp_packet_createKeyFrameRequest(BOOL fir, UINT32 senderSsrc, UINT32 mediaSsrc, PUINT8 pFirSequenceNumber, PBYTE pBuffer, PUINT32 pPacketLen)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 packetLen;
+
+    CHK(pBuffer != NULL && pPacketLen != NULL && (!fir || pFirSequenceNumber != NULL), STATUS_NULL_ARG);
+
+    packetLen = fir ? RTCP_PACKET_FIR_LEN : RTCP_PACKET_PLI_LEN;
+    pBuffer[0] = (RTCP_PACKET_VERSION_VAL << 6) | (fir ? RTCP_PSFB_FIR : RTCP_PSFB_PLI);
+    pBuffer[RTCP_PACKET_TYPE_OFFSET] = RTCP_PACKET_TYPE_PAYLOAD_SPECIFIC_FEEDBACK;
+    putUnalignedInt16BigEndian(pBuffer + RTCP_PACKET_LEN_OFFSET, packetLen / RTCP_PACKET_LEN_WORD_SIZE - 1);
+    putUnalignedInt32BigEndian(pBuffer + RTCP_PACKET_HEADER_LEN, senderSsrc);
+    if (fir) {
+        // The media source is unused, the fci names the stream and numbers the request
+        putUnalignedInt32BigEndian(pBuffer + 8, 0);
+        putUnalignedInt32BigEndian(pBuffer + 12, mediaSsrc);
+        putUnalignedInt32BigEndian(pBuffer + 16, (UINT32) ++(*pFirSequenceNumber) << 24);
+    } else {
+        putUnalignedInt32BigEndian(pBuffer + 8, mediaSsrc);
+    }
+    *pPacketLen = packetLen;
+
+CleanUp:
+    return retStatus;
+}
+
 // converts 100ns precision time to ntp time
 UINT64 rtcp_packet_convertTimestampToNTP(UINT64 time100ns)
 {
@@ -49,6 +49,10 @@ extern "C" {
 #define RTCP_PACKET_RECEIVER_REPORT_BLOCK_LEN 24
 #define RTCP_PACKET_RECEIVER_REPORT_MINLEN    4 + RTCP_PACKET_RECEIVER_REPORT_BLOCK_LEN
 
+// https://tools.ietf.org/html/rfc4585#section-6.3.1 and https://tools.ietf.org/html/rfc5104#section-4.3.1, with the header
+#define RTCP_PACKET_PLI_LEN 12
+#define RTCP_PACKET_FIR_LEN 20
+
 // https://tools.ietf.org/html/rfc3550#section-4
 // If the participant has not yet sent an RTCP packet (the variable
 // initial is true), the constant Tmin is set to 2.5 seconds, else it
@@ -81,11 +85,13 @@ typedef enum {
 typedef enum {
     // RTPFB
     RTCP_FEEDBACK_MESSAGE_TYPE_NACK = 1,       //!< Generic negative acknowledgement
+    RTCP_FEEDBACK_MESSAGE_TYPE_TWCC = 15,      //!< Transport-wide congestion control feedback, https://tools.ietf.org/html/draft-holmer-rmcat-transport-wide-cc-extensions-01
     RTCP_FEEDBACK_MESSAGE_TYPE_EXTENSION = 31, //!< Generic negative acknowledgement
     // PSFB
     RTCP_PSFB_PLI = 1,                                          //!< Picture Loss Indication, https://tools.ietf.org/html/rfc4585#section-6.3
     RTCP_PSFB_SLI = 2,                                          //!< Slice Loss Indication, https://tools.ietf.org/html/rfc4585#section-6.3.2
     RTCP_PSFB_RPSI = 3,                                         //!< Reference Picture Selection Indication
+    RTCP_PSFB_FIR = 4,                                          //!< Full Intra Request, https://tools.ietf.org/html/rfc5104#section-4.3.1
     RTCP_FEEDBACK_MESSAGE_TYPE_APPLICATION_LAYER_FEEDBACK = 15, //!< Application Layer Feedback, AFB.
 } RTCP_FEEDBACK_MESSAGE_TYPE;
 
@@ -120,6 +126,21 @@ STATUS rtcp_packet_setFromBytes(PBYTE, UINT32, PRtcpPacket);
 STATUS rtcp_packet_getNackList(PBYTE, UINT32, PUINT32, PUINT32, PUINT16, PUINT32);
 STATUS rtcp_packet_getRembValue(PBYTE, UINT32, PDOUBLE, PUINT32, PUINT8);
 STATUS rtcp_packet_isRemb(PBYTE, UINT32);
+/**
+ * @brief build a picture loss indication https://tools.ietf.org/html/rfc4585#section-6.3.1 or a full intra request
+ *        https://tools.ietf.org/html/rfc5104#section-4.3.1 asking the sender of a media stream for a key frame.
+ *
+ * @param[in] fir whether to build a full intra request rather than a picture loss indication.
+ * @param[in] senderSsrc the ssrc of the request.
+ * @param[in] mediaSsrc the ssrc of the media stream a key frame is asked for.
+ * @param[in,out] pFirSequenceNumber the command sequence number of the last full intra request, incremented for the new one. Unused
+ *                for a picture loss indication.
+ * @param[in] pBuffer the buffer of the packet, at least RTCP_PACKET_FIR_LEN bytes.
+ * @param[out] pPacketLen the length of the packet, RTCP_PACKET_FIR_LEN or RTCP_PACKET_PLI_LEN.
+ *
+ * @return STATUS status of execution
+ */
+STATUS rtcp_packet_createKeyFrameRequest(BOOL, UINT32, UINT32, PUINT8, PBYTE, PUINT32);
 
 #define NTP_OFFSET    2208988800ULL
 #define NTP_TIMESCALE 4294967296ULL
@@ -133,7 +154,7 @@ UINT64 rtcp_packet_convertTimestampToNTP(UINT64 time100ns);
 // In some fields where a more compact representation is
 //   appropriate, only the middle 32 bits are used; that is, the low 16
 //   bits of the integer part and the high 16 bits of the fractional part.
-#define MID_NTP(ntp_time) (UINT32)((currentTimeNTP >> 16U) & 0xffffffffULL)
+#define MID_NTP(ntp_time) (UINT32)(((ntp_time) >> 16U) & 0xffffffffULL)
 
 #ifdef __cplusplus
 }
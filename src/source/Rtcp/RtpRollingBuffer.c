@@ -32,11 +32,15 @@ STATUS rtp_rolling_buffer_create(UINT32 capacity, PRtpRollingBuffer* ppRtpRollin
     CHK(capacity != 0, STATUS_INVALID_ARG);
     CHK(ppRtpRollingBuffer != NULL, STATUS_NULL_ARG);
 
-    pRtpRollingBuffer = (PRtpRollingBuffer) MEMALLOC(SIZEOF(RtpRollingBuffer));
+    pRtpRollingBuffer = (PRtpRollingBuffer) MEMCALLOC(1, SIZEOF(RtpRollingBuffer));
     CHK(pRtpRollingBuffer != NULL, STATUS_NOT_ENOUGH_MEMORY);
     CHK_STATUS(rolling_buffer_create(capacity, rtp_rolling_buffer_freeData, &pRtpRollingBuffer->pRollingBuffer));
 
 CleanUp:
+    if (STATUS_FAILED(retStatus)) {
+        rtp_rolling_buffer_free(&pRtpRollingBuffer);
+    }
+
     if (ppRtpRollingBuffer != NULL) {
         *ppRtpRollingBuffer = pRtpRollingBuffer;
     }
@@ -79,7 +83,6 @@ STATUS rtp_rolling_buffer_addRtpPacket(PRtpRollingBuffer pRollingBuffer, PRtpPac
     STATUS retStatus = STATUS_SUCCESS;
     PRtpPacket pRtpPacketCopy = NULL;
     PBYTE pRawPacketCopy = NULL;
-    UINT64 index = 0;
     CHK(pRollingBuffer != NULL && pRtpPacket != NULL, STATUS_RTP_NULL_ARG);
 
     pRawPacketCopy = (PBYTE) MEMALLOC(pRtpPacket->rawPacketLength);
@@ -87,8 +90,7 @@ STATUS rtp_rolling_buffer_addRtpPacket(PRtpRollingBuffer pRollingBuffer, PRtpPac
     MEMCPY(pRawPacketCopy, pRtpPacket->pRawPacket, pRtpPacket->rawPacketLength);
     CHK_STATUS(rtp_packet_createFromBytes(pRawPacketCopy, pRtpPacket->rawPacketLength, &pRtpPacketCopy));
 
-    CHK_STATUS(rolling_buffer_appendData(pRollingBuffer->pRollingBuffer, (UINT64) pRtpPacketCopy, &index));
-    pRollingBuffer->lastIndex = index;
+    CHK_STATUS(rtp_rolling_buffer_commitRtpPacket(pRollingBuffer, pRtpPacketCopy));
 
 CleanUp:
     CHK_LOG_ERR(retStatus);
@@ -97,6 +99,51 @@ CleanUp:
     return retStatus;
 }
 
+STATUS rtp_rolling_buffer_commitRtpPacket(PRtpRollingBuffer pRollingBuffer, PRtpPacket pRtpPacket)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT64 index = 0;
+
+    CHK(pRollingBuffer != NULL && pRtpPacket != NULL, STATUS_RTP_NULL_ARG);
+
+    CHK_STATUS(rolling_buffer_appendData(pRollingBuffer->pRollingBuffer, (UINT64) pRtpPacket, &index));
+    pRollingBuffer->lastIndex = index;
+
+CleanUp:
+    LEAVES();
+    return retStatus;
+}
+
+STATUS rtp_rolling_buffer_getRtpPacket(PRtpRollingBuffer pRollingBuffer, UINT64 index, PRtpPacket* ppRtpPacket)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PRollingBuffer pBuffer = NULL;
+    PRtpPacket pRtpPacket = NULL;
+
+    CHK(pRollingBuffer != NULL && ppRtpPacket != NULL, STATUS_NULL_ARG);
+    pBuffer = pRollingBuffer->pRollingBuffer;
+
+    // Evicted packets are released under the same lock, so the reference has to be taken while holding it
+    MUTEX_LOCK(pBuffer->lock);
+    if (pBuffer->headIndex > index && pBuffer->tailIndex <= index) {
+        pRtpPacket = (PRtpPacket) pBuffer->dataBuffer[ROLLING_BUFFER_MAP_INDEX(pBuffer, index)];
+        if (pRtpPacket != NULL) {
+            rtp_packet_addRef(pRtpPacket);
+        }
+    }
+    MUTEX_UNLOCK(pBuffer->lock);
+
+CleanUp:
+    if (ppRtpPacket != NULL) {
+        *ppRtpPacket = pRtpPacket;
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
 STATUS rtp_rolling_buffer_getValidSeqIndexList(PRtpRollingBuffer pRollingBuffer, PUINT16 pSequenceNumberList, UINT32 sequenceNumberListLen,
                                                PUINT64 pValidSeqIndexList, PUINT32 pValidIndexListLen)
 {
@@ -23,6 +23,15 @@ STATUS rtp_rolling_buffer_create(UINT32, PRtpRollingBuffer*);
 STATUS rtp_rolling_buffer_free(PRtpRollingBuffer*);
 STATUS rtp_rolling_buffer_freeData(PUINT64);
 STATUS rtp_rolling_buffer_addRtpPacket(PRtpRollingBuffer, PRtpPacket);
+/**
+ * @brief append a packet without copying it. The caller's reference moves to the rolling buffer.
+ */
+STATUS rtp_rolling_buffer_commitRtpPacket(PRtpRollingBuffer, PRtpPacket);
+/**
+ * @brief get the packet stored at the index with an extra reference, so it stays valid even if it is evicted meanwhile.
+ *        The reference is dropped with rtp_packet_free. The packet is NULL if the index is not in the rolling buffer any more.
+ */
+STATUS rtp_rolling_buffer_getRtpPacket(PRtpRollingBuffer, UINT64, PRtpPacket*);
 STATUS rtp_rolling_buffer_getValidSeqIndexList(PRtpRollingBuffer, PUINT16, UINT32, PUINT64, PUINT32);
 
 #ifdef __cplusplus
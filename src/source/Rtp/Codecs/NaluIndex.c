@@ -0,0 +1,161 @@
+#define LOG_CLASS "NaluIndex"
+
+#include "../../Include_i.h"
+#include "RtpPacket.h"
+#include "NaluIndex.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+/**
+ * Skips 3 bytes whenever the current byte can not be the last byte of a start code.
+ */
+static UINT32 findStartCodeScalar(PBYTE pBuffer, UINT32 offset, UINT32 length)
+{
+    UINT32 i = offset + 2;
+
+    while (i < length) {
+        if (pBuffer[i] > 1) {
+            i += 3;
+        } else if (pBuffer[i] == 0) {
+            i++;
+        } else if (pBuffer[i - 1] == 0 && pBuffer[i - 2] == 0) {
+            return i - 2;
+        } else {
+            i += 3;
+        }
+    }
+
+    return length;
+}
+
+UINT32 nalu_index_findStartCode(PBYTE pBuffer, UINT32 offset, UINT32 length)
+{
+    UINT32 i = offset;
+
+    if (pBuffer == NULL || offset >= length) {
+        return length;
+    }
+
+    // Every lane compares the byte at i, i + 1 and i + 2, so a block needs 2 bytes past its end
+#if defined(__AVX2__)
+    {
+        __m256i zero = _mm256_setzero_si256(), one = _mm256_set1_epi8(1), match;
+        UINT32 mask;
+
+        for (; i + 32 + 2 <= length; i += 32) {
+            match = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i const*) (pBuffer + i + 2)), one),
+                                     _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i const*) (pBuffer + i)), zero),
+                                                      _mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i const*) (pBuffer + i + 1)), zero)));
+            mask = (UINT32) _mm256_movemask_epi8(match);
+            if (mask != 0) {
+                return i + (UINT32) __builtin_ctz(mask);
+            }
+        }
+    }
+#elif defined(__SSE2__)
+    {
+        __m128i zero = _mm_setzero_si128(), one = _mm_set1_epi8(1), match;
+        UINT32 mask;
+
+        for (; i + 16 + 2 <= length; i += 16) {
+            match = _mm_and_si128(_mm_cmpeq_epi8(_mm_loadu_si128((__m128i const*) (pBuffer + i + 2)), one),
+                                  _mm_and_si128(_mm_cmpeq_epi8(_mm_loadu_si128((__m128i const*) (pBuffer + i)), zero),
+                                                _mm_cmpeq_epi8(_mm_loadu_si128((__m128i const*) (pBuffer + i + 1)), zero)));
+            mask = (UINT32) _mm_movemask_epi8(match);
+            if (mask != 0) {
+                return i + (UINT32) __builtin_ctz(mask);
+            }
+        }
+    }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    {
+        uint8x16_t zero = vdupq_n_u8(0), one = vdupq_n_u8(1), match;
+        uint64x2_t match64;
+
+        for (; i + 16 + 2 <= length; i += 16) {
+            match = vandq_u8(vceqq_u8(vld1q_u8(pBuffer + i + 2), one),
+                             vandq_u8(vceqq_u8(vld1q_u8(pBuffer + i), zero), vceqq_u8(vld1q_u8(pBuffer + i + 1), zero)));
+            match64 = vreinterpretq_u64_u8(match);
+            // NEON has no movemask, the block with the match is rescanned which only happens once per NALU
+            if ((vgetq_lane_u64(match64, 0) | vgetq_lane_u64(match64, 1)) != 0) {
+                return findStartCodeScalar(pBuffer, i, i + 16 + 2);
+            }
+        }
+    }
+#endif
+
+    return findStartCodeScalar(pBuffer, i, length);
+}
+
+static STATUS addNaluIndexEntry(PNaluIndex pNaluIndex, UINT32 offset, UINT32 length)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PNaluIndexEntry pEntries = NULL;
+    UINT32 maxEntryCount;
+
+    if (pNaluIndex->entryCount == pNaluIndex->maxEntryCount) {
+        maxEntryCount = MAX(NALU_INDEX_DEFAULT_ENTRY_COUNT, pNaluIndex->maxEntryCount * 2);
+        pEntries = (PNaluIndexEntry) MEMREALLOC(pNaluIndex->pEntries, maxEntryCount * SIZEOF(NaluIndexEntry));
+        CHK(pEntries != NULL, STATUS_NOT_ENOUGH_MEMORY);
+        pNaluIndex->pEntries = pEntries;
+        pNaluIndex->maxEntryCount = maxEntryCount;
+    }
+
+    pNaluIndex->pEntries[pNaluIndex->entryCount].offset = offset;
+    pNaluIndex->pEntries[pNaluIndex->entryCount].length = length;
+    pNaluIndex->entryCount++;
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS nalu_index_build(PNaluIndex pNaluIndex, PBYTE pFrame, UINT32 frameLength)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 offset, naluStart, naluEnd, startCode;
+
+    CHK(pNaluIndex != NULL && pFrame != NULL, STATUS_NULL_ARG);
+    pNaluIndex->pFrame = pFrame;
+    pNaluIndex->frameLength = frameLength;
+    pNaluIndex->entryCount = 0;
+
+    // Same leading start code check as getNextNaluLength, 0x000001 or 0x00000001
+    for (offset = 0; offset < 4 && offset < frameLength && pFrame[offset] == 0; offset++)
+        ;
+    CHK(offset < frameLength && offset < 4 && offset >= 2 && pFrame[offset] == 1, STATUS_RTP_INVALID_NALU);
+
+    for (naluStart = offset + 1; naluStart < frameLength; naluStart = startCode + NALU_START_CODE_SIZE) {
+        startCode = nalu_index_findStartCode(pFrame, naluStart, frameLength);
+        naluEnd = startCode;
+        // The zero in front of a 4 byte start code does not belong to the NALU
+        if (startCode < frameLength && naluEnd > naluStart && pFrame[naluEnd - 1] == 0) {
+            naluEnd--;
+        }
+        CHK_STATUS(addNaluIndexEntry(pNaluIndex, naluStart, naluEnd - naluStart));
+    }
+
+CleanUp:
+    if (STATUS_FAILED(retStatus) && pNaluIndex != NULL) {
+        pNaluIndex->entryCount = 0;
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+VOID nalu_index_free(PNaluIndex pNaluIndex)
+{
+    if (pNaluIndex != NULL) {
+        SAFE_MEMFREE(pNaluIndex->pEntries);
+        pNaluIndex->entryCount = 0;
+        pNaluIndex->maxEntryCount = 0;
+    }
+}
@@ -0,0 +1,65 @@
+/*******************************************
+Annex-B NALU index include file
+*******************************************/
+#ifndef __KINESIS_VIDEO_WEBRTC_CLIENT_NALUINDEX_H
+#define __KINESIS_VIDEO_WEBRTC_CLIENT_NALUINDEX_H
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "kvs/error.h"
+#include "kvs/common_defs.h"
+#include "kvs/platform_utils.h"
+
+#define NALU_INDEX_DEFAULT_ENTRY_COUNT 16
+#define NALU_START_CODE_SIZE           3
+
+typedef struct {
+    UINT32 offset; //!< the offset of the NALU header in the frame, past the start code.
+    UINT32 length; //!< the length of the NALU without the zeros of the next start code, can be 0 for back to back start codes.
+} NaluIndexEntry, *PNaluIndexEntry;
+
+/**
+ * The NALUs of an Annex-B frame, so that the sizing pass and the filling pass of the packetizers do not scan the frame twice.
+ * The entries only grow, an index kept from frame to frame does not touch the heap in steady state.
+ */
+typedef struct {
+    PBYTE pFrame;
+    UINT32 frameLength;
+    PNaluIndexEntry pEntries;
+    UINT32 entryCount;
+    UINT32 maxEntryCount;
+} NaluIndex, *PNaluIndex;
+
+/**
+ * @brief find the next 0x000001 start code. SSE2, AVX2 or NEON is used when the target has it.
+ *
+ * @param[in] pBuffer the buffer.
+ * @param[in] offset where to start looking.
+ * @param[in] length the length of the buffer.
+ *
+ * @return UINT32 the offset of the first zero of the start code, length if there is none.
+ */
+UINT32 nalu_index_findStartCode(PBYTE, UINT32, UINT32);
+/**
+ * @brief index the NALUs of an Annex-B frame. The NALUs are the same as the ones getNextNaluLength walks through.
+ *
+ * @param[in, out] pNaluIndex the index, reset before the frame is scanned.
+ * @param[in] pFrame the frame, which has to outlive the use of the index.
+ * @param[in] frameLength the length of the frame.
+ *
+ * @return STATUS STATUS_RTP_INVALID_NALU if the frame does not start with a start code.
+ */
+STATUS nalu_index_build(PNaluIndex, PBYTE, UINT32);
+/**
+ * @brief release the entries of the index, the index itself belongs to the caller.
+ */
+VOID nalu_index_free(PNaluIndex);
+
+#ifdef __cplusplus
+}
+#endif
+#endif //__KINESIS_VIDEO_WEBRTC_CLIENT_NALUINDEX_H
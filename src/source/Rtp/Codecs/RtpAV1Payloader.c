@@ -0,0 +1,415 @@
+#define LOG_CLASS "RtpAV1Payloader"
+
+#include "../../Include_i.h"
+#include "RtpPacket.h"
+#include "RtpAV1Payloader.h"
+
+/**
+ * An OBU as it goes on the wire, its header without the size field flag followed by its payload.
+ */
+typedef struct {
+    BYTE header[2];
+    UINT32 headerLength;
+    PBYTE pPayload;
+    UINT32 payloadLength;
+} Av1ObuElement, *PAv1ObuElement;
+
+/**
+ * Where the packetizer is in the temporal unit, the OBU it is sending and how much of it already went out.
+ */
+typedef struct {
+    Av1ObuElement obu;
+    BOOL haveObu;
+    UINT32 sentLength;
+    UINT32 nextObuOffset;
+} Av1PacketizerState, *PAv1PacketizerState;
+
+static UINT32 getLeb128Size(UINT32 value)
+{
+    UINT32 size = 1;
+
+    while (value >= 0x80) {
+        value >>= 7;
+        size++;
+    }
+
+    return size;
+}
+
+static UINT32 putLeb128(PBYTE pBuffer, UINT32 value)
+{
+    UINT32 size = 0;
+
+    while (value >= 0x80) {
+        pBuffer[size++] = (BYTE) (0x80 | (value & 0x7F));
+        value >>= 7;
+    }
+    pBuffer[size++] = (BYTE) value;
+
+    return size;
+}
+
+/**
+ * LEB128 does not have to be minimal, the padded form lets the size be rewritten in place once the OBU is complete.
+ */
+static VOID putPaddedLeb128(PBYTE pBuffer, UINT32 value)
+{
+    UINT32 i;
+
+    for (i = 0; i < AV1_LEB128_PADDED_SIZE - 1; i++) {
+        pBuffer[i] = (BYTE) (0x80 | (value & 0x7F));
+        value >>= 7;
+    }
+    pBuffer[i] = (BYTE) (value & 0x7F);
+}
+
+static BOOL getLeb128(PBYTE pBuffer, UINT32 bufferLength, PUINT32 pValue, PUINT32 pSize)
+{
+    UINT64 value = 0;
+    UINT32 i;
+
+    for (i = 0; i < bufferLength && i < AV1_LEB128_MAX_SIZE; i++) {
+        value |= ((UINT64) (pBuffer[i] & 0x7F)) << (i * 7);
+        if ((pBuffer[i] & 0x80) == 0) {
+            *pValue = (UINT32) value;
+            *pSize = i + 1;
+            return value <= MAX_UINT32;
+        }
+    }
+
+    return FALSE;
+}
+
+/**
+ * Parses the OBU at *pOffset. The size field is optional for the last OBU of a temporal unit.
+ */
+static STATUS getAV1Obu(PBYTE pData, UINT32 dataLen, PUINT32 pOffset, PAv1ObuElement pObu)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 offset = *pOffset, obuSize = 0, lebSize = 0;
+    BYTE obuHeader = pData[offset];
+
+    pObu->headerLength = (obuHeader & AV1_OBU_EXTENSION_FLAG) != 0 ? 2 : 1;
+    CHK(pObu->headerLength <= dataLen - offset, STATUS_RTP_INVALID_OBU);
+    pObu->header[0] = obuHeader & ~AV1_OBU_HAS_SIZE_FIELD;
+    pObu->header[1] = pObu->headerLength == 2 ? pData[offset + 1] : 0;
+    offset += pObu->headerLength;
+
+    if ((obuHeader & AV1_OBU_HAS_SIZE_FIELD) != 0) {
+        CHK(getLeb128(pData + offset, dataLen - offset, &obuSize, &lebSize), STATUS_RTP_INVALID_OBU);
+        offset += lebSize;
+        CHK(obuSize <= dataLen - offset, STATUS_RTP_INVALID_OBU);
+    } else {
+        obuSize = dataLen - offset;
+    }
+
+    pObu->pPayload = pData + offset;
+    pObu->payloadLength = obuSize;
+    *pOffset = offset + obuSize;
+
+CleanUp:
+
+    return retStatus;
+}
+
+/**
+ * Moves to the next OBU which goes on the wire, temporal delimiters, tile lists and padding are not sent.
+ * https://aomediacodec.github.io/av1-rtp-spec/#5-packetization-rules
+ */
+static STATUS nextAV1PacketizerObu(PBYTE pData, UINT32 dataLen, PAv1PacketizerState pState)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT8 obuType;
+
+    pState->haveObu = FALSE;
+    pState->sentLength = 0;
+    while (!pState->haveObu && pState->nextObuOffset < dataLen) {
+        CHK_STATUS(getAV1Obu(pData, dataLen, &pState->nextObuOffset, &pState->obu));
+        obuType = AV1_OBU_TYPE(pState->obu.header[0]);
+        pState->haveObu = obuType != AV1_OBU_TEMPORAL_DELIMITER && obuType != AV1_OBU_TILE_LIST && obuType != AV1_OBU_PADDING;
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+static VOID copyAV1ObuElement(PAv1ObuElement pObu, UINT32 offset, UINT32 length, PBYTE pBuffer)
+{
+    UINT32 headerPart = 0;
+
+    if (offset < pObu->headerLength) {
+        headerPart = MIN(pObu->headerLength - offset, length);
+        MEMCPY(pBuffer, pObu->header + offset, headerPart);
+        offset = 0;
+    } else {
+        offset -= pObu->headerLength;
+    }
+
+    MEMCPY(pBuffer + headerPart, pObu->pPayload + offset, length - headerPart);
+}
+
+STATUS createPayloadForAV1(UINT32 mtu, PBYTE pData, UINT32 dataLen, PBYTE payloadBuffer, PUINT32 pPayloadLength, PUINT32 pPayloadSubLength,
+                           PUINT32 pPayloadSubLenSize)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    BOOL sizeCalculationOnly = (payloadBuffer == NULL), newSequence = FALSE, lastFragmented;
+    Av1PacketizerState state, packetStart;
+    UINT32 payloadLength = 0, payloadSubLenSize = 0, elementCount, elementLength, remaining, space, fragmentLength, packetLength, i, w;
+    PBYTE pPacket = payloadBuffer, pCurPtr = NULL;
+
+    CHK(pData != NULL && pPayloadSubLenSize != NULL && pPayloadLength != NULL && (sizeCalculationOnly || pPayloadSubLength != NULL), STATUS_NULL_ARG);
+    // Room for the aggregation header and an OBU header with its extension
+    CHK(mtu > AV1_AGGREGATION_HEADER_SIZE + 2, STATUS_RTP_INPUT_MTU_TOO_SMALL);
+
+    // A sequence header starts a new coded video sequence, which the receiver learns from the N bit of the first packet
+    MEMSET(&state, 0x00, SIZEOF(Av1PacketizerState));
+    do {
+        CHK_STATUS(nextAV1PacketizerObu(pData, dataLen, &state));
+        newSequence = state.haveObu && AV1_OBU_TYPE(state.obu.header[0]) == AV1_OBU_SEQUENCE_HEADER;
+    } while (state.haveObu && !newSequence);
+
+    MEMSET(&state, 0x00, SIZEOF(Av1PacketizerState));
+    CHK_STATUS(nextAV1PacketizerObu(pData, dataLen, &state));
+
+    while (state.haveObu) {
+        // Decide how many OBU elements go in the packet, every element is counted with its length so that the packet fits
+        // whatever the W field ends up being. Whatever does not fit is fragmented into the rest of the packet.
+        packetStart = state;
+        elementCount = 0;
+        fragmentLength = 0;
+        lastFragmented = FALSE;
+        space = mtu - AV1_AGGREGATION_HEADER_SIZE;
+        while (state.haveObu) {
+            remaining = state.obu.headerLength + state.obu.payloadLength - state.sentLength;
+            if (getLeb128Size(remaining) + remaining <= space) {
+                space -= getLeb128Size(remaining) + remaining;
+                elementCount++;
+                CHK_STATUS(nextAV1PacketizerObu(pData, dataLen, &state));
+                continue;
+            }
+
+            fragmentLength = space > 1 ? space - getLeb128Size(space) : 0;
+            if (fragmentLength != 0 && getLeb128Size(fragmentLength) + fragmentLength > space) {
+                fragmentLength--;
+            }
+            // The first fragment carries the whole OBU header, otherwise the OBU starts in the next packet
+            if (fragmentLength != 0 && (state.sentLength != 0 || fragmentLength >= state.obu.headerLength)) {
+                elementCount++;
+                lastFragmented = TRUE;
+            }
+            break;
+        }
+
+        // Write the elements, the last one goes without its length when the W field carries the element count
+        state = packetStart;
+        w = elementCount <= AV1_MAX_W_ELEMENT_COUNT ? elementCount : 0;
+        packetLength = AV1_AGGREGATION_HEADER_SIZE;
+        pCurPtr = sizeCalculationOnly ? NULL : pPacket + AV1_AGGREGATION_HEADER_SIZE;
+        for (i = 0; i < elementCount; i++) {
+            remaining = state.obu.headerLength + state.obu.payloadLength - state.sentLength;
+            elementLength = (i == elementCount - 1 && lastFragmented) ? fragmentLength : remaining;
+            packetLength += elementLength + (w != 0 && i == elementCount - 1 ? 0 : getLeb128Size(elementLength));
+
+            if (!sizeCalculationOnly) {
+                CHK(payloadLength + packetLength <= *pPayloadLength && payloadSubLenSize < *pPayloadSubLenSize, STATUS_BUFFER_TOO_SMALL);
+                if (w == 0 || i != elementCount - 1) {
+                    pCurPtr += putLeb128(pCurPtr, elementLength);
+                }
+                copyAV1ObuElement(&state.obu, state.sentLength, elementLength, pCurPtr);
+                pCurPtr += elementLength;
+            }
+
+            if (elementLength == remaining) {
+                CHK_STATUS(nextAV1PacketizerObu(pData, dataLen, &state));
+            } else {
+                state.sentLength += elementLength;
+            }
+        }
+
+        if (!sizeCalculationOnly) {
+            pPacket[0] = (BYTE) ((packetStart.sentLength != 0 ? AV1_Z_BIT : 0) | (lastFragmented ? AV1_Y_BIT : 0) | (w << AV1_W_SHIFT) |
+                                 (payloadSubLenSize == 0 && newSequence ? AV1_N_BIT : 0));
+            pPayloadSubLength[payloadSubLenSize] = packetLength;
+            pPacket += packetLength;
+        }
+
+        payloadLength += packetLength;
+        payloadSubLenSize++;
+    }
+
+CleanUp:
+    if (STATUS_FAILED(retStatus) && sizeCalculationOnly) {
+        payloadLength = 0;
+        payloadSubLenSize = 0;
+    }
+
+    if (pPayloadSubLenSize != NULL && pPayloadLength != NULL) {
+        *pPayloadLength = payloadLength;
+        *pPayloadSubLenSize = payloadSubLenSize;
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Sizes or writes an OBU element of a packet back with a size field. The start of a fragmented OBU gets a padded size which
+ * mergeAV1ObuFragments rewrites, its continuations get a marker header so that they can be told apart from OBUs.
+ */
+static UINT32 depayAV1ObuElement(PBYTE pElement, UINT32 elementLength, BOOL continuation, BOOL fragmentStart, PBYTE pObuData)
+{
+    UINT32 headerLength, payloadOffset, obuSize = 0, lebSize = 0, length;
+
+    if (continuation) {
+        if (pObuData != NULL) {
+            pObuData[0] = AV1_OBU_FRAGMENT_MARKER;
+            putPaddedLeb128(pObuData + 1, elementLength);
+            MEMCPY(pObuData + 1 + AV1_LEB128_PADDED_SIZE, pElement, elementLength);
+        }
+        return 1 + AV1_LEB128_PADDED_SIZE + elementLength;
+    }
+
+    headerLength = (pElement[0] & AV1_OBU_EXTENSION_FLAG) != 0 ? 2 : 1;
+    if (headerLength > elementLength) {
+        return 0;
+    }
+
+    // The sender should have dropped the size field, the one it kept is only trusted when it matches the element
+    payloadOffset = headerLength;
+    if ((pElement[0] & AV1_OBU_HAS_SIZE_FIELD) != 0) {
+        if (!getLeb128(pElement + headerLength, elementLength - headerLength, &obuSize, &lebSize)) {
+            return 0;
+        }
+        payloadOffset += lebSize;
+        if (!fragmentStart && obuSize != elementLength - payloadOffset) {
+            return 0;
+        }
+    }
+
+    obuSize = elementLength - payloadOffset;
+    length = headerLength + (fragmentStart ? AV1_LEB128_PADDED_SIZE : getLeb128Size(obuSize)) + obuSize;
+    if (pObuData != NULL) {
+        pObuData[0] = pElement[0] | AV1_OBU_HAS_SIZE_FIELD;
+        if (headerLength == 2) {
+            pObuData[1] = pElement[1];
+        }
+        if (fragmentStart) {
+            putPaddedLeb128(pObuData + headerLength, obuSize);
+        } else {
+            putLeb128(pObuData + headerLength, obuSize);
+        }
+        MEMCPY(pObuData + length - obuSize, pElement + payloadOffset, obuSize);
+    }
+
+    return length;
+}
+
+STATUS depayAV1FromRtpPayload(PBYTE pRawPacket, UINT32 packetLength, PBYTE pAv1Data, PUINT32 pAv1Length, PBOOL pIsStart)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 av1Length = 0, offset = AV1_AGGREGATION_HEADER_SIZE, elementLength = 0, lebSize = 0, elementIndex = 0, w, length;
+    BOOL sizeCalculationOnly = (pAv1Data == NULL), lastElement;
+    BYTE aggregationHeader;
+
+    CHK(pRawPacket != NULL && pAv1Length != NULL, STATUS_NULL_ARG);
+    CHK(packetLength > AV1_AGGREGATION_HEADER_SIZE, STATUS_RTP_INPUT_PACKET_TOO_SMALL);
+
+    aggregationHeader = pRawPacket[0];
+    w = (aggregationHeader >> AV1_W_SHIFT) & AV1_W_MASK;
+
+    // A truncated packet keeps the elements which are complete
+    while (offset < packetLength) {
+        if (w != 0 && elementIndex == w - 1) {
+            elementLength = packetLength - offset;
+        } else {
+            if (!getLeb128(pRawPacket + offset, packetLength - offset, &elementLength, &lebSize) || elementLength > packetLength - offset - lebSize) {
+                break;
+            }
+            offset += lebSize;
+        }
+        lastElement = (offset + elementLength == packetLength);
+
+        if (elementLength != 0) {
+            length = depayAV1ObuElement(pRawPacket + offset, elementLength, elementIndex == 0 && (aggregationHeader & AV1_Z_BIT) != 0,
+                                        lastElement && (aggregationHeader & AV1_Y_BIT) != 0, NULL);
+            if (!sizeCalculationOnly && length != 0) {
+                CHK(av1Length + length <= *pAv1Length, STATUS_BUFFER_TOO_SMALL);
+                depayAV1ObuElement(pRawPacket + offset, elementLength, elementIndex == 0 && (aggregationHeader & AV1_Z_BIT) != 0,
+                                   lastElement && (aggregationHeader & AV1_Y_BIT) != 0, pAv1Data + av1Length);
+            }
+            av1Length += length;
+        }
+
+        offset += elementLength;
+        elementIndex++;
+    }
+
+CleanUp:
+    if (STATUS_FAILED(retStatus) && sizeCalculationOnly) {
+        av1Length = 0;
+    }
+
+    if (pAv1Length != NULL) {
+        *pAv1Length = av1Length;
+    }
+
+    if (pIsStart != NULL) {
+        *pIsStart = pRawPacket != NULL && packetLength > 0 && (pRawPacket[0] & AV1_Z_BIT) == 0;
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Turns the output of depayAV1FromRtpPayload for a whole temporal unit into OBUs with size fields, in place.
+ * The continuations of a fragmented OBU are appended to it and its padded size is rewritten.
+ */
+STATUS mergeAV1ObuFragments(PBYTE pAv1Data, UINT32 av1Length, PUINT32 pMergedLength)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 readOffset = 0, writeOffset = 0, headerLength, obuSize = 0, lebSize = 0, length;
+    UINT32 lastSizeOffset = 0, lastObuSize = 0;
+    BOOL mergeable = FALSE;
+
+    CHK(pAv1Data != NULL && pMergedLength != NULL, STATUS_NULL_ARG);
+
+    while (readOffset < av1Length) {
+        headerLength = (pAv1Data[readOffset] & AV1_OBU_EXTENSION_FLAG) != 0 ? 2 : 1;
+        CHK(headerLength < av1Length - readOffset, STATUS_RTP_INVALID_OBU);
+        CHK(getLeb128(pAv1Data + readOffset + headerLength, av1Length - readOffset - headerLength, &obuSize, &lebSize) &&
+                obuSize <= av1Length - readOffset - headerLength - lebSize,
+            STATUS_RTP_INVALID_OBU);
+
+        if (pAv1Data[readOffset] == AV1_OBU_FRAGMENT_MARKER) {
+            // A continuation whose start was dropped can not be decoded
+            if (mergeable && lastObuSize + obuSize <= AV1_LEB128_PADDED_MAX_VALUE) {
+                MEMMOVE(pAv1Data + writeOffset, pAv1Data + readOffset + headerLength + lebSize, obuSize);
+                writeOffset += obuSize;
+                lastObuSize += obuSize;
+                putPaddedLeb128(pAv1Data + lastSizeOffset, lastObuSize);
+            }
+        } else {
+            length = headerLength + lebSize + obuSize;
+            MEMMOVE(pAv1Data + writeOffset, pAv1Data + readOffset, length);
+            mergeable = lebSize == AV1_LEB128_PADDED_SIZE;
+            lastSizeOffset = writeOffset + headerLength;
+            lastObuSize = obuSize;
+            writeOffset += length;
+        }
+
+        readOffset += headerLength + lebSize + obuSize;
+    }
+
+CleanUp:
+    if (pMergedLength != NULL) {
+        *pMergedLength = STATUS_SUCCEEDED(retStatus) ? writeOffset : 0;
+    }
+
+    LEAVES();
+    return retStatus;
+}
@@ -0,0 +1,75 @@
+/*******************************************
+AV1 RTP Payloader include file
+*******************************************/
+#ifndef __KINESIS_VIDEO_WEBRTC_CLIENT_RTPAV1PAYLOADER_H
+#define __KINESIS_VIDEO_WEBRTC_CLIENT_RTPAV1PAYLOADER_H
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "RtpPacket.h"
+
+// https://aomediacodec.github.io/av1-rtp-spec/#44-av1-aggregation-header
+#define AV1_AGGREGATION_HEADER_SIZE 1
+#define AV1_Z_BIT                   0x80
+#define AV1_Y_BIT                   0x40
+#define AV1_W_SHIFT                 4
+#define AV1_W_MASK                  0x03
+#define AV1_N_BIT                   0x08
+// With W set to the element count, the last element goes without its length
+#define AV1_MAX_W_ELEMENT_COUNT 3
+
+// https://aomediacodec.github.io/av1-spec/#obu-header-syntax
+#define AV1_OBU_TYPE_SHIFT              3
+#define AV1_OBU_TYPE_MASK               0x0F
+#define AV1_OBU_EXTENSION_FLAG          0x04
+#define AV1_OBU_HAS_SIZE_FIELD          0x02
+#define AV1_OBU_TYPE(obuHeader)         (((obuHeader) >> AV1_OBU_TYPE_SHIFT) & AV1_OBU_TYPE_MASK)
+#define AV1_OBU_SEQUENCE_HEADER         1
+#define AV1_OBU_TEMPORAL_DELIMITER      2
+#define AV1_OBU_TILE_LIST               8
+#define AV1_OBU_PADDING                 15
+#define AV1_LEB128_MAX_SIZE             8
+#define AV1_LEB128_PADDED_SIZE          4
+#define AV1_LEB128_PADDED_MAX_VALUE     0x0FFFFFFF
+
+// The depayloader marks the continuation of a fragmented OBU with a reserved OBU type, mergeAV1ObuFragments stitches the OBU back together
+#define AV1_OBU_FRAGMENT_MARKER AV1_OBU_HAS_SIZE_FIELD
+
+/*
+ *  Aggregation header
+ *
+ *   0 1 2 3 4 5 6 7
+ *  +-+-+-+-+-+-+-+-+
+ *  |Z|Y| W |N|-|-|-|
+ *  +-+-+-+-+-+-+-+-+
+ *
+ *  Z: the first OBU element is the continuation of an OBU fragment from the previous packet
+ *  Y: the last OBU element continues in the next packet
+ *  W: the number of OBU elements, 0 when every element is preceded by its LEB128 length
+ *  N: the packet is the first packet of a coded video sequence
+ *
+ *  Payload
+ *
+ *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *  |Z|Y| W |N|-|-|-|  OBU element 1 size (leb128)  |               |
+ *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+               |
+ *  :                       OBU element 1 data                      :
+ *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *  :                              ...                              :
+ *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *  |                     OBU element N data                        |
+ *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ */
+
+STATUS createPayloadForAV1(UINT32, PBYTE, UINT32, PBYTE, PUINT32, PUINT32, PUINT32);
+STATUS depayAV1FromRtpPayload(PBYTE, UINT32, PBYTE, PUINT32, PBOOL);
+STATUS mergeAV1ObuFragments(PBYTE, UINT32, PUINT32);
+
+#ifdef __cplusplus
+}
+#endif
+#endif //__KINESIS_VIDEO_WEBRTC_CLIENT_RTPAV1PAYLOADER_H
@@ -3,23 +3,132 @@
 #include "../../Include_i.h"
 #include "endianness.h"
 #include "RtpPacket.h"
+#include "NaluIndex.h"
 #include "RtpH264Payloader.h"
 
+static BYTE start4ByteCode[] = {0x00, 0x00, 0x00, 0x01};
+
+/**
+ * STAP-A https://tools.ietf.org/html/rfc6184#section-5.7.1 and AP https://tools.ietf.org/html/rfc7798#section-4.4.2 share their layout,
+ * the NALUs follow the payload header of the packet and each one is prefixed with its size.
+ */
+static STATUS createAggregationPayload(UINT32 headerSize, AggregationHeaderFunc aggregationHeaderFn, PBYTE* ppNalus, PUINT32 pNaluLengths,
+                                       UINT32 naluCount, PPayloadArray pPayloadArray, PUINT32 filledLength, PUINT32 filledSubLenSize)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PBYTE pPayload = NULL;
+    UINT32 i, payloadLength = headerSize;
+    BOOL sizeCalculationOnly = (pPayloadArray == NULL);
+
+    for (i = 0; i < naluCount; i++) {
+        payloadLength += AGGREGATED_NALU_LENGTH_SIZE + pNaluLengths[i];
+    }
+
+    if (!sizeCalculationOnly) {
+        CHK(pPayloadArray->maxPayloadSubLenSize >= 1 && payloadLength <= pPayloadArray->maxPayloadLength, STATUS_BUFFER_TOO_SMALL);
+
+        pPayload = pPayloadArray->payloadBuffer + headerSize;
+        for (i = 0; i < naluCount; i++) {
+            putUnalignedInt16BigEndian(pPayload, (INT16) pNaluLengths[i]);
+            MEMCPY(pPayload + AGGREGATED_NALU_LENGTH_SIZE, ppNalus[i], pNaluLengths[i]);
+            pPayload += AGGREGATED_NALU_LENGTH_SIZE + pNaluLengths[i];
+        }
+
+        aggregationHeaderFn(ppNalus, naluCount, pPayloadArray->payloadBuffer);
+        pPayloadArray->payloadSubLength[0] = payloadLength;
+    }
+
+CleanUp:
+    *filledLength = STATUS_SUCCEEDED(retStatus) ? payloadLength : 0;
+    *filledSubLenSize = STATUS_SUCCEEDED(retStatus) ? 1 : 0;
+
+    return retStatus;
+}
+
+/**
+ * F is set if any of the NALUs has it and NRI is the highest NRI of the NALUs.
+ */
+static VOID writeStapAHeader(PBYTE* ppNalus, UINT32 naluCount, PBYTE pHeader)
+{
+    UINT32 i;
+    BYTE forbiddenBit = 0, naluRefIdc = 0;
+
+    for (i = 0; i < naluCount; i++) {
+        forbiddenBit |= *ppNalus[i] & 0x80;
+        naluRefIdc = MAX(naluRefIdc, *ppNalus[i] & 0x60);
+    }
+    pHeader[0] = forbiddenBit | naluRefIdc | STAP_A_INDICATOR;
+}
+
+STATUS appendNaluPayload(UINT32 mtu, UINT32 headerSize, NaluPayloadFunc naluPayloadFn, AggregationHeaderFunc aggregationHeaderFn, PBYTE* ppNalus,
+                         PUINT32 pNaluLengths, UINT32 naluCount, BOOL sizeCalculationOnly, PPayloadArray pPayloadArray)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 filledLength = 0;
+    UINT32 filledSubLenSize = 0;
+
+    if (naluCount == 1) {
+        CHK_STATUS(naluPayloadFn(mtu, ppNalus[0], pNaluLengths[0], sizeCalculationOnly ? NULL : pPayloadArray, &filledLength, &filledSubLenSize));
+    } else {
+        CHK_STATUS(createAggregationPayload(headerSize, aggregationHeaderFn, ppNalus, pNaluLengths, naluCount,
+                                            sizeCalculationOnly ? NULL : pPayloadArray, &filledLength, &filledSubLenSize));
+    }
+
+    if (sizeCalculationOnly) {
+        pPayloadArray->payloadLength += filledLength;
+        pPayloadArray->payloadSubLenSize += filledSubLenSize;
+    } else {
+        pPayloadArray->payloadBuffer += filledLength;
+        pPayloadArray->payloadSubLength += filledSubLenSize;
+        pPayloadArray->maxPayloadLength -= filledLength;
+        pPayloadArray->maxPayloadSubLenSize -= filledSubLenSize;
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
 STATUS createPayloadForH264(UINT32 mtu, PBYTE nalus, UINT32 nalusLength, PBYTE payloadBuffer, PUINT32 pPayloadLength, PUINT32 pPayloadSubLength,
                             PUINT32 pPayloadSubLenSize)
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
-    PBYTE curPtrInNalus = nalus;
-    UINT32 remainNalusLength = nalusLength;
-    UINT32 nextNaluLength = 0;
-    UINT32 startIndex = 0;
-    UINT32 singlePayloadLength = 0;
-    UINT32 singlePayloadSubLenSize = 0;
+    NaluIndex naluIndex;
+
+    MEMSET(&naluIndex, 0x00, SIZEOF(NaluIndex));
+    CHK(nalus != NULL && pPayloadSubLenSize != NULL && pPayloadLength != NULL, STATUS_NULL_ARG);
+
+    CHK_STATUS(nalu_index_build(&naluIndex, nalus, nalusLength));
+    CHK_STATUS(createPayloadForH264FromNaluIndex(mtu, &naluIndex, payloadBuffer, pPayloadLength, pPayloadSubLength, pPayloadSubLenSize));
+
+CleanUp:
+    if (STATUS_FAILED(retStatus) && payloadBuffer == NULL && pPayloadSubLenSize != NULL && pPayloadLength != NULL) {
+        *pPayloadLength = 0;
+        *pPayloadSubLenSize = 0;
+    }
+    nalu_index_free(&naluIndex);
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS createPayloadForH264FromNaluIndex(UINT32 mtu, PNaluIndex pNaluIndex, PBYTE payloadBuffer, PUINT32 pPayloadLength, PUINT32 pPayloadSubLength,
+                                         PUINT32 pPayloadSubLenSize)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PNaluIndexEntry pEntry = NULL;
+    UINT32 i;
+    PBYTE aggregatedNalus[STAP_A_MAX_NALU_COUNT];
+    UINT32 aggregatedNaluLengths[STAP_A_MAX_NALU_COUNT];
+    UINT32 aggregatedNaluCount = 0;
+    UINT32 aggregatedLength = 0;
     BOOL sizeCalculationOnly = (payloadBuffer == NULL);
     PayloadArray payloadArray;
 
-    CHK(nalus != NULL && pPayloadSubLenSize != NULL && pPayloadLength != NULL && (sizeCalculationOnly || pPayloadSubLength != NULL), STATUS_NULL_ARG);
+    CHK(pNaluIndex != NULL && pPayloadSubLenSize != NULL && pPayloadLength != NULL && (sizeCalculationOnly || pPayloadSubLength != NULL),
+        STATUS_NULL_ARG);
     CHK(mtu > FU_A_HEADER_SIZE, STATUS_RTP_INPUT_MTU_TOO_SMALL);
 
     if (sizeCalculationOnly) {
@@ -36,30 +145,34 @@ STATUS createPayloadForH264(UINT32 mtu, PBYTE nalus, UINT32 nalusLength, PBYTE p
     payloadArray.payloadBuffer = payloadBuffer;
     payloadArray.payloadSubLength = pPayloadSubLength;
 
-    do {
-        CHK_STATUS(getNextNaluLength(curPtrInNalus, remainNalusLength, &startIndex, &nextNaluLength));
-
-        curPtrInNalus += startIndex;
-
-        remainNalusLength -= startIndex;
+    // Consecutive NALUs are gathered for as long as they fit in a single STAP-A, so that SPS, PPS and SEI
+    // do not take a packet each and small slices share packets
+    for (i = 0; i < pNaluIndex->entryCount; i++) {
+        pEntry = &pNaluIndex->pEntries[i];
+        if (pEntry->length == 0) {
+            continue;
+        }
 
-        CHK(remainNalusLength != 0, retStatus);
+        if (aggregatedNaluCount != 0 &&
+            (aggregatedNaluCount == STAP_A_MAX_NALU_COUNT || aggregatedLength + STAP_A_NALU_LENGTH_SIZE + pEntry->length > mtu)) {
+            CHK_STATUS(appendNaluPayload(mtu, STAP_A_HEADER_SIZE, createPayloadFromNalu, writeStapAHeader, aggregatedNalus, aggregatedNaluLengths,
+                                         aggregatedNaluCount, sizeCalculationOnly, &payloadArray));
+            aggregatedNaluCount = 0;
+        }
 
-        if (sizeCalculationOnly) {
-            CHK_STATUS(createPayloadFromNalu(mtu, curPtrInNalus, nextNaluLength, NULL, &singlePayloadLength, &singlePayloadSubLenSize));
-            payloadArray.payloadLength += singlePayloadLength;
-            payloadArray.payloadSubLenSize += singlePayloadSubLenSize;
-        } else {
-            CHK_STATUS(createPayloadFromNalu(mtu, curPtrInNalus, nextNaluLength, &payloadArray, &singlePayloadLength, &singlePayloadSubLenSize));
-            payloadArray.payloadBuffer += singlePayloadLength;
-            payloadArray.payloadSubLength += singlePayloadSubLenSize;
-            payloadArray.maxPayloadLength -= singlePayloadLength;
-            payloadArray.maxPayloadSubLenSize -= singlePayloadSubLenSize;
+        if (aggregatedNaluCount == 0) {
+            aggregatedLength = STAP_A_HEADER_SIZE;
         }
+        aggregatedNalus[aggregatedNaluCount] = pNaluIndex->pFrame + pEntry->offset;
+        aggregatedNaluLengths[aggregatedNaluCount] = pEntry->length;
+        aggregatedNaluCount++;
+        aggregatedLength += STAP_A_NALU_LENGTH_SIZE + pEntry->length;
+    }
 
-        remainNalusLength -= nextNaluLength;
-        curPtrInNalus += nextNaluLength;
-    } while (remainNalusLength != 0);
+    if (aggregatedNaluCount != 0) {
+        CHK_STATUS(appendNaluPayload(mtu, STAP_A_HEADER_SIZE, createPayloadFromNalu, writeStapAHeader, aggregatedNalus, aggregatedNaluLengths,
+                                         aggregatedNaluCount, sizeCalculationOnly, &payloadArray));
+    }
 
 CleanUp:
     if (STATUS_FAILED(retStatus) && sizeCalculationOnly) {
@@ -227,6 +340,35 @@ CleanUp:
     return retStatus;
 }
 
+/**
+ * Sizes or copies out the NALUs of a STAP-A or STAP-B, each of them behind a start code.
+ * A truncated packet keeps the NALUs which are complete.
+ */
+static UINT32 depayAggregationPacket(PBYTE pRawPacket, UINT32 packetLength, UINT32 headerSize, PBYTE pNaluData)
+{
+    PBYTE pCurPtr = pRawPacket + headerSize;
+    PBYTE pEnd = pRawPacket + packetLength;
+    UINT32 naluLength = 0;
+    UINT16 subNaluSize = 0;
+
+    while (pCurPtr + STAP_A_NALU_LENGTH_SIZE <= pEnd) {
+        subNaluSize = (UINT16) getUnalignedInt16BigEndian(pCurPtr);
+        pCurPtr += STAP_A_NALU_LENGTH_SIZE;
+        if (subNaluSize == 0 || subNaluSize > pEnd - pCurPtr) {
+            break;
+        }
+
+        if (pNaluData != NULL) {
+            MEMCPY(pNaluData + naluLength, start4ByteCode, SIZEOF(start4ByteCode));
+            MEMCPY(pNaluData + naluLength + SIZEOF(start4ByteCode), pCurPtr, subNaluSize);
+        }
+        naluLength += SIZEOF(start4ByteCode) + subNaluSize;
+        pCurPtr += subNaluSize;
+    }
+
+    return naluLength;
+}
+
 STATUS depayH264FromRtpPayload(PBYTE pRawPacket, UINT32 packetLength, PBYTE pNaluData, PUINT32 pNaluLength, PBOOL pIsStart)
 {
     ENTERS();
@@ -238,13 +380,10 @@ STATUS depayH264FromRtpPayload(PBYTE pRawPacket, UINT32 packetLength, PBYTE pNal
     BOOL sizeCalculationOnly = (pNaluData == NULL);
     BOOL isStartingPacket = FALSE;
     PBYTE pCurPtr = pRawPacket;
-    static BYTE start4ByteCode[] = {0x00, 0x00, 0x00, 0x01};
-    UINT16 subNaluSize = 0;
 
     CHK(pRawPacket != NULL && pNaluLength != NULL, STATUS_NULL_ARG);
     CHK(packetLength > 0, retStatus);
 
-    // TODO: Add support for Aggregate Packets https://tools.ietf.org/html/rfc6184#section-5.7
     // indicator for types https://tools.ietf.org/html/rfc3984#section-5.2
     indicator = *pRawPacket & NAL_TYPE_MASK;
     switch (indicator) {
@@ -265,23 +404,11 @@ STATUS depayH264FromRtpPayload(PBYTE pRawPacket, UINT32 packetLength, PBYTE pNal
             naluLength = packetLength - FU_A_HEADER_SIZE + 1;
             break;
         case STAP_A_INDICATOR:
-            pCurPtr += STAP_A_HEADER_SIZE;
-            do {
-                subNaluSize = getUnalignedInt16BigEndian(pCurPtr);
-                pCurPtr += SIZEOF(UINT16);
-                naluLength += subNaluSize + SIZEOF(start4ByteCode);
-                pCurPtr += subNaluSize;
-            } while (subNaluSize > 0 && pCurPtr < pRawPacket + packetLength);
+            naluLength = depayAggregationPacket(pRawPacket, packetLength, STAP_A_HEADER_SIZE, NULL);
             isStartingPacket = TRUE;
             break;
         case STAP_B_INDICATOR:
-            pCurPtr += STAP_B_HEADER_SIZE;
-            do {
-                subNaluSize = getUnalignedInt16BigEndian(pCurPtr);
-                pCurPtr += SIZEOF(UINT16);
-                naluLength += subNaluSize + SIZEOF(start4ByteCode);
-                pCurPtr += subNaluSize;
-            } while (subNaluSize > 0 && pCurPtr < pRawPacket + packetLength);
+            naluLength = depayAggregationPacket(pRawPacket, packetLength, STAP_B_HEADER_SIZE, NULL);
             isStartingPacket = TRUE;
             break;
         default:
@@ -323,33 +450,11 @@ STATUS depayH264FromRtpPayload(PBYTE pRawPacket, UINT32 packetLength, PBYTE pNal
             }
             break;
         case STAP_A_INDICATOR:
-            naluLength = 0;
-            pCurPtr = pRawPacket + STAP_A_HEADER_SIZE;
-            do {
-                subNaluSize = getUnalignedInt16BigEndian(pCurPtr);
-                pCurPtr += SIZEOF(UINT16);
-                MEMCPY(pNaluData, start4ByteCode, SIZEOF(start4ByteCode));
-                pNaluData += SIZEOF(start4ByteCode);
-                MEMCPY(pNaluData, pCurPtr, subNaluSize);
-                pCurPtr += subNaluSize;
-                pNaluData += subNaluSize;
-                naluLength += SIZEOF(start4ByteCode) + subNaluSize;
-            } while (subNaluSize > 0 && pCurPtr < pRawPacket + packetLength);
+            depayAggregationPacket(pRawPacket, packetLength, STAP_A_HEADER_SIZE, pNaluData);
             DLOGS("STAP_A_INDICATOR starting packet %d len %d", isStartingPacket, naluLength);
             break;
         case STAP_B_INDICATOR:
-            naluLength = 0;
-            pCurPtr = pRawPacket + STAP_A_HEADER_SIZE;
-            do {
-                subNaluSize = getUnalignedInt16BigEndian(pCurPtr);
-                pCurPtr += SIZEOF(UINT16);
-                MEMCPY(pNaluData, start4ByteCode, SIZEOF(start4ByteCode));
-                pNaluData += SIZEOF(start4ByteCode);
-                MEMCPY(pNaluData, pCurPtr, subNaluSize);
-                pCurPtr += subNaluSize;
-                pNaluData += subNaluSize;
-                naluLength += SIZEOF(start4ByteCode) + subNaluSize;
-            } while (subNaluSize > 0 && pCurPtr < pRawPacket + packetLength);
+            depayAggregationPacket(pRawPacket, packetLength, STAP_B_HEADER_SIZE, pNaluData);
             DLOGS("STAP_B_INDICATOR starting packet %d len %d", isStartingPacket, naluLength);
             break;
         default:
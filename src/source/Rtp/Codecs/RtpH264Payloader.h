@@ -11,6 +11,7 @@ extern "C" {
 #endif
 
 #include "RtpPacket.h"
+#include "NaluIndex.h"
 
 #define FU_A_HEADER_SIZE     2
 #define FU_B_HEADER_SIZE     4
@@ -22,6 +23,12 @@ extern "C" {
 #define STAP_A_INDICATOR     24
 #define STAP_B_INDICATOR     25
 #define NAL_TYPE_MASK        31
+#define STAP_A_NALU_LENGTH_SIZE 2
+// The NALUs of the aggregation packets of H264 and H265 are prefixed with their size
+#define AGGREGATED_NALU_LENGTH_SIZE 2
+
+// The max number of NALUs put into a single STAP-A, parameter sets, SEIs and small slices are what gets aggregated in practice
+#define STAP_A_MAX_NALU_COUNT 16
 
 /*
  *   0                   1                   2                   3
@@ -37,9 +44,33 @@ extern "C" {
  *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
  */
 
+// Packetizes a lone NALU as a single NAL unit packet or as fragmentation units
+typedef STATUS (*NaluPayloadFunc)(UINT32, PBYTE, UINT32, PPayloadArray, PUINT32, PUINT32);
+// Writes the payload header of an aggregation packet from the NALUs it carries
+typedef VOID (*AggregationHeaderFunc)(PBYTE*, UINT32, PBYTE);
+
 STATUS createPayloadForH264(UINT32, PBYTE, UINT32, PBYTE, PUINT32, PUINT32, PUINT32);
+// Same as createPayloadForH264 for a frame indexed by nalu_index_build, the sizing and the filling calls share one scan
+STATUS createPayloadForH264FromNaluIndex(UINT32, PNaluIndex, PBYTE, PUINT32, PUINT32, PUINT32);
 STATUS getNextNaluLength(PBYTE, UINT32, PUINT32, PUINT32);
 STATUS createPayloadFromNalu(UINT32, PBYTE, UINT32, PPayloadArray, PUINT32, PUINT32);
+/**
+ * @brief packetize the NALUs gathered for a single packet and move the payload array past the packets. A lone NALU goes out through
+ *        naluPayloadFn, several NALUs share an aggregation packet behind a payload header of headerSize bytes.
+ *
+ * @param[in] mtu the max payload size.
+ * @param[in] headerSize the size of the payload header of an aggregation packet, STAP_A_HEADER_SIZE or H265_NAL_HEADER_SIZE.
+ * @param[in] naluPayloadFn packetizes a lone NALU.
+ * @param[in] aggregationHeaderFn writes the payload header of an aggregation packet.
+ * @param[in] ppNalus the NALUs.
+ * @param[in] pNaluLengths the length of every NALU.
+ * @param[in] naluCount the number of NALUs.
+ * @param[in] sizeCalculationOnly only add up the payload length and the number of packets.
+ * @param[in, out] pPayloadArray the payload array.
+ *
+ * @return STATUS status of execution
+ */
+STATUS appendNaluPayload(UINT32, UINT32, NaluPayloadFunc, AggregationHeaderFunc, PBYTE*, PUINT32, UINT32, BOOL, PPayloadArray);
 STATUS depayH264FromRtpPayload(PBYTE, UINT32, PBYTE, PUINT32, PBOOL);
 
 #ifdef __cplusplus
@@ -0,0 +1,333 @@
+#define LOG_CLASS "RtpH265Payloader"
+
+#include "../../Include_i.h"
+#include "endianness.h"
+#include "RtpPacket.h"
+#include "RtpH264Payloader.h"
+#include "NaluIndex.h"
+#include "RtpH265Payloader.h"
+
+static BYTE h265StartCode[] = {0x00, 0x00, 0x00, 0x01};
+
+/**
+ * Aggregation packet https://tools.ietf.org/html/rfc7798#section-4.4.2
+ * F is set if any of the NALUs has it, LayerId and TID are the lowest ones of the NALUs.
+ */
+static VOID writeH265ApHeader(PBYTE* ppNalus, UINT32 naluCount, PBYTE pHeader)
+{
+    UINT32 i;
+    PBYTE pNalu = NULL;
+    BYTE forbiddenBit = 0, layerId = 0x3F, tid = 0x07;
+
+    for (i = 0; i < naluCount; i++) {
+        pNalu = ppNalus[i];
+        forbiddenBit |= pNalu[0] & 0x80;
+        layerId = MIN(layerId, ((pNalu[0] & 0x01) << 5) | (pNalu[1] >> 3));
+        tid = MIN(tid, pNalu[1] & 0x07);
+    }
+    pHeader[0] = forbiddenBit | (H265_AP_TYPE << H265_NAL_TYPE_SHIFT) | (layerId >> 5);
+    pHeader[1] = ((layerId & 0x1F) << 3) | tid;
+}
+
+STATUS createPayloadForH265(UINT32 mtu, PBYTE nalus, UINT32 nalusLength, PBYTE payloadBuffer, PUINT32 pPayloadLength, PUINT32 pPayloadSubLength,
+                            PUINT32 pPayloadSubLenSize)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    NaluIndex naluIndex;
+
+    MEMSET(&naluIndex, 0x00, SIZEOF(NaluIndex));
+    CHK(nalus != NULL && pPayloadSubLenSize != NULL && pPayloadLength != NULL, STATUS_NULL_ARG);
+
+    // Annex-B start codes are the same as H264 ones
+    CHK_STATUS(nalu_index_build(&naluIndex, nalus, nalusLength));
+    CHK_STATUS(createPayloadForH265FromNaluIndex(mtu, &naluIndex, payloadBuffer, pPayloadLength, pPayloadSubLength, pPayloadSubLenSize));
+
+CleanUp:
+    if (STATUS_FAILED(retStatus) && payloadBuffer == NULL && pPayloadSubLenSize != NULL && pPayloadLength != NULL) {
+        *pPayloadLength = 0;
+        *pPayloadSubLenSize = 0;
+    }
+    nalu_index_free(&naluIndex);
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS createPayloadForH265FromNaluIndex(UINT32 mtu, PNaluIndex pNaluIndex, PBYTE payloadBuffer, PUINT32 pPayloadLength, PUINT32 pPayloadSubLength,
+                                         PUINT32 pPayloadSubLenSize)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PNaluIndexEntry pEntry = NULL;
+    UINT32 i;
+    PBYTE aggregatedNalus[H265_MAX_AGGREGATED_NALU_COUNT];
+    UINT32 aggregatedNaluLengths[H265_MAX_AGGREGATED_NALU_COUNT];
+    UINT32 aggregatedNaluCount = 0;
+    UINT32 aggregatedLength = 0;
+    BOOL sizeCalculationOnly = (payloadBuffer == NULL);
+    PayloadArray payloadArray;
+
+    CHK(pNaluIndex != NULL && pPayloadSubLenSize != NULL && pPayloadLength != NULL && (sizeCalculationOnly || pPayloadSubLength != NULL),
+        STATUS_NULL_ARG);
+    CHK(mtu > H265_FU_HEADER_SIZE, STATUS_RTP_INPUT_MTU_TOO_SMALL);
+
+    if (sizeCalculationOnly) {
+        payloadArray.payloadLength = 0;
+        payloadArray.payloadSubLenSize = 0;
+        payloadArray.maxPayloadLength = 0;
+        payloadArray.maxPayloadSubLenSize = 0;
+    } else {
+        payloadArray.payloadLength = *pPayloadLength;
+        payloadArray.payloadSubLenSize = *pPayloadSubLenSize;
+        payloadArray.maxPayloadLength = *pPayloadLength;
+        payloadArray.maxPayloadSubLenSize = *pPayloadSubLenSize;
+    }
+    payloadArray.payloadBuffer = payloadBuffer;
+    payloadArray.payloadSubLength = pPayloadSubLength;
+
+    // The NALUs are gathered for as long as they fit in a single aggregation packet, so that the
+    // parameter sets in front of an IRAP picture do not take a packet each
+    for (i = 0; i < pNaluIndex->entryCount; i++) {
+        pEntry = &pNaluIndex->pEntries[i];
+        // Back to back or trailing start codes leave empty entries, a single byte cannot hold the NAL unit header
+        if (pEntry->length == 0) {
+            continue;
+        }
+        CHK(pEntry->length >= H265_NAL_HEADER_SIZE, STATUS_RTP_INVALID_NALU);
+
+        if (aggregatedNaluCount != 0 &&
+            (aggregatedNaluCount == H265_MAX_AGGREGATED_NALU_COUNT || aggregatedLength + H265_AP_NALU_LENGTH_SIZE + pEntry->length > mtu)) {
+            CHK_STATUS(appendNaluPayload(mtu, H265_NAL_HEADER_SIZE, createPayloadFromH265Nalu, writeH265ApHeader, aggregatedNalus,
+                                         aggregatedNaluLengths, aggregatedNaluCount, sizeCalculationOnly, &payloadArray));
+            aggregatedNaluCount = 0;
+        }
+
+        if (aggregatedNaluCount == 0) {
+            aggregatedLength = H265_NAL_HEADER_SIZE;
+        }
+        aggregatedNalus[aggregatedNaluCount] = pNaluIndex->pFrame + pEntry->offset;
+        aggregatedNaluLengths[aggregatedNaluCount] = pEntry->length;
+        aggregatedNaluCount++;
+        aggregatedLength += H265_AP_NALU_LENGTH_SIZE + pEntry->length;
+    }
+
+    if (aggregatedNaluCount != 0) {
+        CHK_STATUS(appendNaluPayload(mtu, H265_NAL_HEADER_SIZE, createPayloadFromH265Nalu, writeH265ApHeader, aggregatedNalus, aggregatedNaluLengths,
+                                         aggregatedNaluCount, sizeCalculationOnly, &payloadArray));
+    }
+
+CleanUp:
+    if (STATUS_FAILED(retStatus) && sizeCalculationOnly) {
+        payloadArray.payloadLength = 0;
+        payloadArray.payloadSubLenSize = 0;
+    }
+
+    if (pPayloadSubLenSize != NULL && pPayloadLength != NULL) {
+        *pPayloadLength = payloadArray.payloadLength;
+        *pPayloadSubLenSize = payloadArray.payloadSubLenSize;
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS createPayloadFromH265Nalu(UINT32 mtu, PBYTE nalu, UINT32 naluLength, PPayloadArray pPayloadArray, PUINT32 filledLength,
+                                 PUINT32 filledSubLenSize)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PBYTE pPayload = NULL;
+    UINT8 naluType = 0;
+    UINT32 maxPayloadSize = 0;
+    UINT32 curPayloadSize = 0;
+    UINT32 remainingNaluLength = naluLength;
+    UINT32 payloadLength = 0;
+    UINT32 payloadSubLenSize = 0;
+    PBYTE pCurPtrInNalu = NULL;
+    BOOL sizeCalculationOnly = (pPayloadArray == NULL);
+
+    CHK(nalu != NULL && filledLength != NULL && filledSubLenSize != NULL, STATUS_NULL_ARG);
+    CHK(sizeCalculationOnly || (pPayloadArray->payloadSubLength != NULL && pPayloadArray->payloadBuffer != NULL), STATUS_NULL_ARG);
+    CHK(mtu > H265_FU_HEADER_SIZE, STATUS_RTP_INPUT_MTU_TOO_SMALL);
+    CHK(naluLength >= H265_NAL_HEADER_SIZE, STATUS_RTP_INVALID_NALU);
+
+    naluType = H265_NAL_TYPE(nalu);
+
+    if (!sizeCalculationOnly) {
+        pPayload = pPayloadArray->payloadBuffer;
+    }
+
+    if (naluLength <= mtu) {
+        payloadLength += naluLength;
+        payloadSubLenSize++;
+
+        if (!sizeCalculationOnly) {
+            CHK(payloadSubLenSize <= pPayloadArray->maxPayloadSubLenSize && payloadLength <= pPayloadArray->maxPayloadLength,
+                STATUS_BUFFER_TOO_SMALL);
+
+            // Single NAL unit packet https://tools.ietf.org/html/rfc7798#section-4.4.1
+            MEMCPY(pPayload, nalu, naluLength);
+            pPayloadArray->payloadSubLength[payloadSubLenSize - 1] = naluLength;
+            pPayload += pPayloadArray->payloadSubLength[payloadSubLenSize - 1];
+        }
+    } else {
+        // Fragmentation unit https://tools.ietf.org/html/rfc7798#section-4.4.3
+        maxPayloadSize = mtu - H265_FU_HEADER_SIZE;
+
+        // The NAL header is carried by the payload header and the FU header
+        remainingNaluLength -= H265_NAL_HEADER_SIZE;
+        pCurPtrInNalu = nalu + H265_NAL_HEADER_SIZE;
+
+        while (remainingNaluLength != 0) {
+            curPayloadSize = MIN(maxPayloadSize, remainingNaluLength);
+            payloadSubLenSize++;
+            payloadLength += H265_FU_HEADER_SIZE + curPayloadSize;
+
+            if (!sizeCalculationOnly) {
+                CHK(payloadSubLenSize <= pPayloadArray->maxPayloadSubLenSize && payloadLength <= pPayloadArray->maxPayloadLength,
+                    STATUS_BUFFER_TOO_SMALL);
+
+                MEMCPY(pPayload + H265_FU_HEADER_SIZE, pCurPtrInNalu, curPayloadSize);
+                pPayload[0] = (nalu[0] & H265_NAL_F_LAYER_ID_MASK) | (H265_FU_TYPE << H265_NAL_TYPE_SHIFT);
+                pPayload[1] = nalu[1];
+                pPayload[2] = naluType;
+                if (remainingNaluLength == naluLength - H265_NAL_HEADER_SIZE) {
+                    pPayload[2] |= H265_FU_START_BIT;
+                } else if (remainingNaluLength == curPayloadSize) {
+                    pPayload[2] |= H265_FU_END_BIT;
+                }
+
+                pPayloadArray->payloadSubLength[payloadSubLenSize - 1] = H265_FU_HEADER_SIZE + curPayloadSize;
+                pPayload += pPayloadArray->payloadSubLength[payloadSubLenSize - 1];
+            }
+
+            pCurPtrInNalu += curPayloadSize;
+            remainingNaluLength -= curPayloadSize;
+        }
+    }
+
+CleanUp:
+    if (STATUS_FAILED(retStatus) && sizeCalculationOnly) {
+        payloadLength = 0;
+        payloadSubLenSize = 0;
+    }
+
+    if (filledLength != NULL && filledSubLenSize != NULL) {
+        *filledLength = payloadLength;
+        *filledSubLenSize = payloadSubLenSize;
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+/**
+ * Sizes or copies out the NALUs of an aggregation packet, each of them behind a start code.
+ * A truncated packet keeps the NALUs which are complete.
+ */
+static UINT32 depayH265AggregationPacket(PBYTE pRawPacket, UINT32 packetLength, PBYTE pNaluData)
+{
+    PBYTE pCurPtr = pRawPacket + H265_NAL_HEADER_SIZE;
+    PBYTE pEnd = pRawPacket + packetLength;
+    UINT32 naluLength = 0;
+    UINT16 subNaluSize = 0;
+
+    while (pCurPtr + H265_AP_NALU_LENGTH_SIZE <= pEnd) {
+        subNaluSize = (UINT16) getUnalignedInt16BigEndian(pCurPtr);
+        pCurPtr += H265_AP_NALU_LENGTH_SIZE;
+        if (subNaluSize == 0 || subNaluSize > pEnd - pCurPtr) {
+            break;
+        }
+
+        if (pNaluData != NULL) {
+            MEMCPY(pNaluData + naluLength, h265StartCode, SIZEOF(h265StartCode));
+            MEMCPY(pNaluData + naluLength + SIZEOF(h265StartCode), pCurPtr, subNaluSize);
+        }
+        naluLength += SIZEOF(h265StartCode) + subNaluSize;
+        pCurPtr += subNaluSize;
+    }
+
+    return naluLength;
+}
+
+STATUS depayH265FromRtpPayload(PBYTE pRawPacket, UINT32 packetLength, PBYTE pNaluData, PUINT32 pNaluLength, PBOOL pIsStart)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 naluLength = 0;
+    UINT8 payloadType = 0;
+    BOOL sizeCalculationOnly = (pNaluData == NULL);
+    BOOL isStartingPacket = FALSE;
+    PBYTE pCurPtr = pNaluData;
+
+    CHK(pRawPacket != NULL && pNaluLength != NULL, STATUS_NULL_ARG);
+    CHK(packetLength >= H265_NAL_HEADER_SIZE, retStatus);
+
+    payloadType = H265_NAL_TYPE(pRawPacket);
+    switch (payloadType) {
+        case H265_AP_TYPE:
+            naluLength = depayH265AggregationPacket(pRawPacket, packetLength, NULL);
+            isStartingPacket = TRUE;
+            break;
+        case H265_FU_TYPE:
+            CHK(packetLength > H265_FU_HEADER_SIZE, retStatus);
+            isStartingPacket = (pRawPacket[2] & H265_FU_START_BIT) != 0;
+            naluLength = packetLength - H265_FU_HEADER_SIZE;
+            if (isStartingPacket) {
+                naluLength += SIZEOF(h265StartCode) + H265_NAL_HEADER_SIZE;
+            }
+            break;
+        case H265_PACI_TYPE:
+            // PACI is never negotiated, these packets are dropped as the RFC allows
+            DLOGW("Dropping an unsupported H265 PACI packet");
+            break;
+        default:
+            // Single NAL unit packet https://tools.ietf.org/html/rfc7798#section-4.4.1
+            naluLength = SIZEOF(h265StartCode) + packetLength;
+            isStartingPacket = TRUE;
+    }
+
+    // Only return size if given buffer is NULL
+    CHK(!sizeCalculationOnly, retStatus);
+    CHK(naluLength <= *pNaluLength, STATUS_BUFFER_TOO_SMALL);
+
+    switch (payloadType) {
+        case H265_AP_TYPE:
+            depayH265AggregationPacket(pRawPacket, packetLength, pNaluData);
+            break;
+        case H265_FU_TYPE:
+            if (isStartingPacket) {
+                MEMCPY(pCurPtr, h265StartCode, SIZEOF(h265StartCode));
+                pCurPtr += SIZEOF(h265StartCode);
+                // The NAL header is the payload header with the type of the fragmented NALU
+                pCurPtr[0] = (pRawPacket[0] & H265_NAL_F_LAYER_ID_MASK) | ((pRawPacket[2] & H265_FU_TYPE_MASK) << H265_NAL_TYPE_SHIFT);
+                pCurPtr[1] = pRawPacket[1];
+                pCurPtr += H265_NAL_HEADER_SIZE;
+            }
+            MEMCPY(pCurPtr, pRawPacket + H265_FU_HEADER_SIZE, packetLength - H265_FU_HEADER_SIZE);
+            break;
+        case H265_PACI_TYPE:
+            break;
+        default:
+            MEMCPY(pCurPtr, h265StartCode, SIZEOF(h265StartCode));
+            MEMCPY(pCurPtr + SIZEOF(h265StartCode), pRawPacket, packetLength);
+    }
+    DLOGS("Wrote H265 naluLength %d isStartingPacket %d", naluLength, isStartingPacket);
+
+CleanUp:
+    if (STATUS_FAILED(retStatus) && sizeCalculationOnly) {
+        naluLength = 0;
+    }
+
+    if (pNaluLength != NULL) {
+        *pNaluLength = naluLength;
+    }
+
+    if (pIsStart != NULL) {
+        *pIsStart = isStartingPacket;
+    }
+
+    LEAVES();
+    return retStatus;
+}
@@ -0,0 +1,74 @@
+/*******************************************
+H265 RTP Payloader include file
+*******************************************/
+#ifndef __KINESIS_VIDEO_WEBRTC_CLIENT_RTPH265PAYLOADER_H
+#define __KINESIS_VIDEO_WEBRTC_CLIENT_RTPH265PAYLOADER_H
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "RtpPacket.h"
+#include "NaluIndex.h"
+
+// https://tools.ietf.org/html/rfc7798#section-1.1.4
+#define H265_NAL_HEADER_SIZE      2
+#define H265_FU_HEADER_SIZE       3
+#define H265_AP_NALU_LENGTH_SIZE  2
+#define H265_AP_TYPE              48
+#define H265_FU_TYPE              49
+#define H265_PACI_TYPE            50
+#define H265_NAL_TYPE_SHIFT       1
+#define H265_NAL_TYPE_MASK        0x3F
+#define H265_NAL_F_LAYER_ID_MASK  0x81
+#define H265_FU_START_BIT         0x80
+#define H265_FU_END_BIT           0x40
+#define H265_FU_TYPE_MASK         0x3F
+#define H265_NAL_TYPE(pNalHeader) ((*(pNalHeader) >> H265_NAL_TYPE_SHIFT) & H265_NAL_TYPE_MASK)
+
+// The max number of NALUs put into a single aggregation packet, parameter sets and SEIs are what gets aggregated in practice
+#define H265_MAX_AGGREGATED_NALU_COUNT 16
+
+/*
+ *  Payload header shared by the NALUs, the aggregation packets and the fragmentation units
+ *
+ *  +---------------+---------------+
+ *  |0|1|2|3|4|5|6|7|0|1|2|3|4|5|6|7|
+ *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *  |F|   Type    |  LayerId  | TID |
+ *  +-------------+-----------------+
+ *
+ *  Fragmentation unit
+ *
+ *   0                   1                   2                   3
+ *   0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+ *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *  |    PayloadHdr (Type=49)       |   FU header   |               |
+ *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+               |
+ *  |                         FU payload                            |
+ *  |                                                               |
+ *  |                               +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *  |                               :...OPTIONAL RTP padding        |
+ *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *
+ *  FU header
+ *
+ *  +---------------+
+ *  |0|1|2|3|4|5|6|7|
+ *  +-+-+-+-+-+-+-+-+
+ *  |S|E|  FuType   |
+ *  +---------------+
+ */
+
+STATUS createPayloadForH265(UINT32, PBYTE, UINT32, PBYTE, PUINT32, PUINT32, PUINT32);
+// Same as createPayloadForH265 for a frame indexed by nalu_index_build
+STATUS createPayloadForH265FromNaluIndex(UINT32, PNaluIndex, PBYTE, PUINT32, PUINT32, PUINT32);
+STATUS createPayloadFromH265Nalu(UINT32, PBYTE, UINT32, PPayloadArray, PUINT32, PUINT32);
+STATUS depayH265FromRtpPayload(PBYTE, UINT32, PBYTE, PUINT32, PBOOL);
+
+#ifdef __cplusplus
+}
+#endif
+#endif //__KINESIS_VIDEO_WEBRTC_CLIENT_RTPH265PAYLOADER_H
@@ -74,3 +74,47 @@ CleanUp:
     LEAVES();
     return retStatus;
 }
+
+STATUS getOpusPacketDuration(PBYTE pPacket, UINT32 packetLength, PUINT32 pDuration)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    // The frame sizes of the SILK, hybrid and CELT configurations in samples at 48 kHz, https://www.rfc-editor.org/rfc/rfc6716#section-3.1
+    static const UINT32 silkFrameSizes[] = {480, 960, 1920, 2880};
+    static const UINT32 hybridFrameSizes[] = {480, 960};
+    static const UINT32 celtFrameSizes[] = {120, 240, 480, 960};
+    UINT32 config, frameSize, frameCount = 0;
+
+    CHK(pPacket != NULL && pDuration != NULL, STATUS_NULL_ARG);
+    CHK(packetLength > 0, STATUS_RTP_INVALID_OPUS_PACKET);
+
+    config = pPacket[0] >> OPUS_TOC_CONFIG_SHIFT;
+    if (config < OPUS_CONFIG_FIRST_HYBRID) {
+        frameSize = silkFrameSizes[config % ARRAY_SIZE(silkFrameSizes)];
+    } else if (config < OPUS_CONFIG_FIRST_CELT) {
+        frameSize = hybridFrameSizes[config % ARRAY_SIZE(hybridFrameSizes)];
+    } else {
+        frameSize = celtFrameSizes[config % ARRAY_SIZE(celtFrameSizes)];
+    }
+
+    switch (pPacket[0] & OPUS_TOC_CODE_MASK) {
+        case 0:
+            frameCount = 1;
+            break;
+        case 1:
+        case 2:
+            frameCount = 2;
+            break;
+        default:
+            // code 3 packets count their frames in the byte after the table of contents
+            CHK(packetLength > 1, STATUS_RTP_INVALID_OPUS_PACKET);
+            frameCount = pPacket[1] & OPUS_FRAME_COUNT_MASK;
+            break;
+    }
+    CHK(frameCount > 0 && frameCount * frameSize <= OPUS_MAX_PACKET_DURATION, STATUS_RTP_INVALID_OPUS_PACKET);
+
+    *pDuration = frameCount * frameSize;
+
+CleanUp:
+
+    return retStatus;
+}
@@ -10,8 +10,27 @@ Opus RTP Payloader include file
 extern "C" {
 #endif
 
+// https://www.rfc-editor.org/rfc/rfc6716#section-3.1 the table of contents byte of an Opus packet
+#define OPUS_TOC_CONFIG_SHIFT    3
+#define OPUS_TOC_CODE_MASK       0x03
+#define OPUS_FRAME_COUNT_MASK    0x3F
+#define OPUS_CONFIG_FIRST_HYBRID 12
+#define OPUS_CONFIG_FIRST_CELT   16
+// 120 ms at 48 kHz
+#define OPUS_MAX_PACKET_DURATION 5760
+
 STATUS createPayloadForOpus(UINT32, PBYTE, UINT32, PBYTE, PUINT32, PUINT32, PUINT32);
 STATUS depayOpusFromRtpPayload(PBYTE, UINT32, PBYTE, PUINT32, PBOOL);
+/**
+ * @brief the duration of an Opus packet from its table of contents byte.
+ *
+ * @param[in] pPacket the Opus packet.
+ * @param[in] packetLength the length of the packet.
+ * @param[out] pDuration the duration in samples at 48 kHz, the rtp clock rate of Opus.
+ *
+ * @return STATUS status of execution, STATUS_RTP_INVALID_OPUS_PACKET if the table of contents can not be parsed.
+ */
+STATUS getOpusPacketDuration(PBYTE, UINT32, PUINT32);
 
 #ifdef __cplusplus
 }
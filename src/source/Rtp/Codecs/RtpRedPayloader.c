@@ -0,0 +1,173 @@
+#define LOG_CLASS "RtpRedPayloader"
+
+#include "../../Include_i.h"
+#include "RtpRedPayloader.h"
+#include "RtpOpusPayloader.h"
+
+STATUS red_encoder_create(UINT8 payloadType, UINT32 redundancy, PRedEncoder* ppRedEncoder)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PRedEncoder pRedEncoder = NULL;
+
+    CHK(ppRedEncoder != NULL, STATUS_NULL_ARG);
+    CHK(redundancy > 0 && redundancy <= RED_MAX_REDUNDANCY, STATUS_INVALID_ARG);
+
+    pRedEncoder = (PRedEncoder) MEMCALLOC(1, SIZEOF(RedEncoder));
+    CHK(pRedEncoder != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    pRedEncoder->payloadType = payloadType;
+    pRedEncoder->redundancy = redundancy;
+
+CleanUp:
+
+    if (ppRedEncoder != NULL) {
+        *ppRedEncoder = pRedEncoder;
+    }
+
+    return retStatus;
+}
+
+STATUS red_encoder_free(PRedEncoder* ppRedEncoder)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+
+    CHK(ppRedEncoder != NULL, STATUS_NULL_ARG);
+    SAFE_MEMFREE(*ppRedEncoder);
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS createPayloadForRed(PRedEncoder pRedEncoder, UINT32 mtu, UINT32 timestamp, PBYTE frame, UINT32 frameLength, PBYTE payloadBuffer,
+                           PUINT32 pPayloadLength, PUINT32 pPayloadSubLength, PUINT32 pPayloadSubLenSize)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 i, k, primaryLength = 0, primarySubLength = 0, primarySubLenSize = 0, payloadLength = 0, offset, blockCount = 0;
+    UINT32 blocks[RED_MAX_REDUNDANCY];
+    PRedFrame pRedFrame;
+    PBYTE pCurPtr;
+    BOOL sizeCalculationOnly = (payloadBuffer == NULL);
+
+    CHK(pRedEncoder != NULL && frame != NULL && pPayloadSubLenSize != NULL && pPayloadLength != NULL &&
+            (sizeCalculationOnly || pPayloadSubLength != NULL),
+        STATUS_NULL_ARG);
+
+    CHK_STATUS(createPayloadForOpus(mtu, frame, frameLength, NULL, &primaryLength, NULL, &primarySubLenSize));
+    payloadLength = RED_PRIMARY_BLOCK_HEADER_LEN + primaryLength;
+
+    // The most recent frames are the most likely to still be of use, older ones are only added while they fit. The blocks are always the
+    // frames right before the primary one, the receiver tells their sequence numbers from how many blocks back they are
+    for (k = 0; k < pRedEncoder->redundancy; k++) {
+        pRedFrame = &pRedEncoder->history[k];
+        offset = timestamp - pRedFrame->timestamp;
+        if (pRedFrame->length == 0 || offset == 0 || offset > RED_MAX_TIMESTAMP_OFFSET ||
+            payloadLength + RED_BLOCK_HEADER_LEN + pRedFrame->length > mtu) {
+            break;
+        }
+        payloadLength += RED_BLOCK_HEADER_LEN + pRedFrame->length;
+        blocks[blockCount++] = k;
+    }
+
+    // Only return size if given buffer is NULL
+    CHK(!sizeCalculationOnly, retStatus);
+    CHK(payloadLength <= *pPayloadLength && 1 <= *pPayloadSubLenSize, STATUS_BUFFER_TOO_SMALL);
+
+    // The headers, then the data, both the oldest frame first
+    pCurPtr = payloadBuffer;
+    for (i = blockCount; i > 0; i--) {
+        pRedFrame = &pRedEncoder->history[blocks[i - 1]];
+        offset = timestamp - pRedFrame->timestamp;
+        *pCurPtr++ = RED_F_BIT | (pRedEncoder->payloadType & PAYLOAD_TYPE_MASK);
+        putUnalignedInt16BigEndian(pCurPtr, (UINT16) ((offset << 2) | (pRedFrame->length >> 8)));
+        pCurPtr += SIZEOF(UINT16);
+        *pCurPtr++ = (BYTE) pRedFrame->length;
+    }
+    *pCurPtr++ = pRedEncoder->payloadType & PAYLOAD_TYPE_MASK;
+    for (i = blockCount; i > 0; i--) {
+        pRedFrame = &pRedEncoder->history[blocks[i - 1]];
+        MEMCPY(pCurPtr, pRedFrame->data, pRedFrame->length);
+        pCurPtr += pRedFrame->length;
+    }
+    primarySubLenSize = 1;
+    CHK_STATUS(createPayloadForOpus(mtu, frame, frameLength, pCurPtr, &primaryLength, &primarySubLength, &primarySubLenSize));
+    pPayloadSubLength[0] = payloadLength;
+
+    // The frame is repeated by the next packets, unless it is too large for the length field of a block
+    for (k = pRedEncoder->redundancy - 1; k > 0; k--) {
+        pRedEncoder->history[k] = pRedEncoder->history[k - 1];
+    }
+    pRedEncoder->history[0].length = frameLength <= RED_MAX_BLOCK_LENGTH ? frameLength : 0;
+    pRedEncoder->history[0].timestamp = timestamp;
+    MEMCPY(pRedEncoder->history[0].data, frame, pRedEncoder->history[0].length);
+
+CleanUp:
+    if (STATUS_FAILED(retStatus) && sizeCalculationOnly) {
+        payloadLength = 0;
+    }
+
+    if (pPayloadSubLenSize != NULL && pPayloadLength != NULL) {
+        *pPayloadLength = payloadLength;
+        *pPayloadSubLenSize = payloadLength > 0 ? 1 : 0;
+    }
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS depayRedFromRtpPayload(PBYTE pPayload, UINT32 payloadLength, PRedBlock pBlocks, PUINT32 pBlockCount)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 i, blockCount = 0, headerLength = 0, dataLength = 0, field;
+    PBYTE pCurPtr = pPayload;
+    BOOL sizeCalculationOnly = (pBlocks == NULL);
+
+    CHK(pPayload != NULL && pBlockCount != NULL, STATUS_NULL_ARG);
+
+    // The number of blocks is only bounded by the length of the payload, the headers are checked before any block is filled in
+    while (TRUE) {
+        CHK(headerLength < payloadLength, STATUS_RTP_INVALID_RED_PACKET);
+        if ((pCurPtr[headerLength] & RED_F_BIT) == 0) {
+            headerLength += RED_PRIMARY_BLOCK_HEADER_LEN;
+            blockCount++;
+            break;
+        }
+        CHK(headerLength + RED_BLOCK_HEADER_LEN <= payloadLength, STATUS_RTP_INVALID_RED_PACKET);
+        field = ((UINT32) pCurPtr[headerLength + 2] << 8) | pCurPtr[headerLength + 3];
+        dataLength += field & RED_MAX_BLOCK_LENGTH;
+        headerLength += RED_BLOCK_HEADER_LEN;
+        blockCount++;
+    }
+    CHK(headerLength + dataLength <= payloadLength, STATUS_RTP_INVALID_RED_PACKET);
+
+    // Only return the count if no blocks are given
+    CHK(!sizeCalculationOnly, retStatus);
+    CHK(blockCount <= *pBlockCount, STATUS_BUFFER_TOO_SMALL);
+
+    for (i = 0, headerLength = 0; i < blockCount - 1; i++, headerLength += RED_BLOCK_HEADER_LEN) {
+        field = ((UINT32) pCurPtr[headerLength + 1] << 16) | ((UINT32) pCurPtr[headerLength + 2] << 8) | pCurPtr[headerLength + 3];
+        pBlocks[i].payloadType = pCurPtr[headerLength] & PAYLOAD_TYPE_MASK;
+        pBlocks[i].timestampOffset = field >> RED_TIMESTAMP_OFFSET_SHIFT;
+        pBlocks[i].length = field & RED_MAX_BLOCK_LENGTH;
+    }
+    pBlocks[i].payloadType = pCurPtr[headerLength] & PAYLOAD_TYPE_MASK;
+    pBlocks[i].timestampOffset = 0;
+    headerLength += RED_PRIMARY_BLOCK_HEADER_LEN;
+    // The primary block takes whatever follows the redundant ones
+    pBlocks[blockCount - 1].length = payloadLength - headerLength - dataLength;
+    pCurPtr += headerLength;
+    for (i = 0; i < blockCount; i++) {
+        pBlocks[i].pData = pCurPtr;
+        pCurPtr += pBlocks[i].length;
+    }
+
+CleanUp:
+
+    if (pBlockCount != NULL) {
+        *pBlockCount = STATUS_SUCCEEDED(retStatus) || retStatus == STATUS_BUFFER_TOO_SMALL ? blockCount : 0;
+    }
+
+    LEAVES();
+    return retStatus;
+}
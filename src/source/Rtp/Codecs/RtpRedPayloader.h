@@ -0,0 +1,103 @@
+/*******************************************
+RED RTP Payloader include file
+*******************************************/
+#ifndef __KINESIS_VIDEO_WEBRTC_CLIENT_RTPREDPAYLOADER_H
+#define __KINESIS_VIDEO_WEBRTC_CLIENT_RTPREDPAYLOADER_H
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "RtpPacket.h"
+
+// https://tools.ietf.org/html/rfc2198#section-3
+#define RED_MAX_REDUNDANCY           2
+#define RED_BLOCK_HEADER_LEN         4
+#define RED_PRIMARY_BLOCK_HEADER_LEN 1
+#define RED_F_BIT                    0x80
+#define RED_TIMESTAMP_OFFSET_SHIFT   10
+#define RED_MAX_TIMESTAMP_OFFSET     0x3FFF
+#define RED_MAX_BLOCK_LENGTH         0x3FF
+// The redundant blocks and the primary one
+#define RED_MAX_BLOCK_COUNT (RED_MAX_REDUNDANCY + 1)
+
+/*
+ *  Header of a redundant block
+ *
+ *   0                   1                   2                   3
+ *   0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+ *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *  |F|   block PT  |  timestamp offset         |   block length    |
+ *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+ *
+ *  Header of the primary block, the last one
+ *
+ *   0 1 2 3 4 5 6 7
+ *  +-+-+-+-+-+-+-+-+
+ *  |0|   Block PT  |
+ *  +-+-+-+-+-+-+-+-+
+ *
+ *  The headers of all the blocks come first, then their data in the same order, the oldest frame first and the primary frame last.
+ */
+
+typedef struct {
+    BYTE data[RED_MAX_BLOCK_LENGTH];
+    UINT32 length; //!< 0 while the slot is empty or the frame is too large to be repeated.
+    UINT32 timestamp;
+} RedFrame, *PRedFrame;
+
+/**
+ * Repeats the previous frames of an audio stream in each packet, so that a single lost packet is covered by the next one without a
+ * retransmission.
+ */
+typedef struct {
+    UINT8 payloadType;                    //!< the payload type of the blocks, the one of the codec.
+    UINT32 redundancy;                    //!< how many previous frames each packet repeats, at most RED_MAX_REDUNDANCY.
+    RedFrame history[RED_MAX_REDUNDANCY]; //!< history[0] is the previous frame.
+} RedEncoder, *PRedEncoder;
+
+typedef struct {
+    UINT8 payloadType;
+    UINT32 timestampOffset; //!< how far the frame of the block precedes the timestamp of the packet, 0 for the primary block.
+    PBYTE pData;
+    UINT32 length;
+} RedBlock, *PRedBlock;
+
+STATUS red_encoder_create(UINT8, UINT32, PRedEncoder*);
+STATUS red_encoder_free(PRedEncoder*);
+/**
+ * @brief wrap an Opus frame and the previous frames kept by the encoder into a single RED payload. The previous frames are dropped,
+ *        the oldest first, when the payload would not fit the mtu. Filling the payload moves the frame into the history.
+ *
+ * @param[in] pRedEncoder the encoder.
+ * @param[in] mtu the largest payload.
+ * @param[in] timestamp the rtp timestamp of the frame.
+ * @param[in] frame the Opus frame.
+ * @param[in] frameLength the length of the frame.
+ * @param[in, out] payloadBuffer the payload, NULL to only compute the lengths.
+ * @param[in, out] pPayloadLength the length of the payload buffer, then the length of the payload.
+ * @param[out] pPayloadSubLength the length of the single payload.
+ * @param[in, out] pPayloadSubLenSize the number of payloads, always 1.
+ *
+ * @return STATUS status of execution
+ */
+STATUS createPayloadForRed(PRedEncoder, UINT32, UINT32, PBYTE, UINT32, PBYTE, PUINT32, PUINT32, PUINT32);
+/**
+ * @brief split a RED payload into its blocks, they point into the payload.
+ *
+ * @param[in] pPayload the payload.
+ * @param[in] payloadLength the length of the payload.
+ * @param[out] pBlocks the blocks, the primary block last. NULL to only count the blocks.
+ * @param[in, out] pBlockCount the capacity of pBlocks, then the number of blocks.
+ *
+ * @return STATUS status of execution, STATUS_RTP_INVALID_RED_PACKET if the payload can not be parsed and STATUS_BUFFER_TOO_SMALL with
+ *         the number of blocks if pBlocks can not hold them.
+ */
+STATUS depayRedFromRtpPayload(PBYTE, UINT32, PRedBlock, PUINT32);
+
+#ifdef __cplusplus
+}
+#endif
+#endif //__KINESIS_VIDEO_WEBRTC_CLIENT_RTPREDPAYLOADER_H
@@ -0,0 +1,207 @@
+#define LOG_CLASS "RtpExtension"
+
+#include "endianness.h"
+#include "time_port.h"
+#include "RtpExtension.h"
+
+static PCHAR gRtpExtensionUris[RTP_EXTENSION_COUNT] = {TWCC_EXT_URL,          MID_EXT_URL,              RID_EXT_URL,
+                                                       RRID_EXT_URL,          ABS_SEND_TIME_EXT_URL,    ABS_CAPTURE_TIME_EXT_URL,
+                                                       VIDEO_ORIENTATION_EXT_URL};
+
+PCHAR rtp_extension_getUri(RTP_EXTENSION extension)
+{
+    return (UINT32) extension < RTP_EXTENSION_COUNT ? gRtpExtensionUris[extension] : NULL;
+}
+
+VOID rtp_extension_map_reset(PRtpExtensionMap pRtpExtensionMap)
+{
+    if (pRtpExtensionMap != NULL) {
+        MEMSET(pRtpExtensionMap, 0x00, SIZEOF(RtpExtensionMap));
+    }
+}
+
+STATUS rtp_extension_map_set(PRtpExtensionMap pRtpExtensionMap, RTP_EXTENSION extension, UINT8 id)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT8 other;
+
+    CHK(pRtpExtensionMap != NULL, STATUS_RTP_NULL_ARG);
+    CHK((UINT32) extension < RTP_EXTENSION_COUNT, STATUS_INVALID_ARG);
+
+    if (pRtpExtensionMap->ids[extension] != 0) {
+        pRtpExtensionMap->extensions[pRtpExtensionMap->ids[extension]] = 0;
+    }
+    if (id != 0 && (other = pRtpExtensionMap->extensions[id]) != 0) {
+        pRtpExtensionMap->ids[other - 1] = 0;
+    }
+    pRtpExtensionMap->ids[extension] = id;
+    if (id != 0) {
+        pRtpExtensionMap->extensions[id] = (UINT8) extension + 1;
+    }
+
+CleanUp:
+    return retStatus;
+}
+
+STATUS rtp_extension_parse(PRtpExtensionMap pRtpExtensionMap, PRtpPacket pRtpPacket, PRtpExtensionElements pElements)
+{
+    STATUS retStatus = STATUS_SUCCESS, status;
+    UINT32 offset = 0;
+    UINT8 id = 0, len = 0, extension;
+    PBYTE pData = NULL;
+
+    CHK(pRtpExtensionMap != NULL && pRtpPacket != NULL && pElements != NULL, STATUS_RTP_NULL_ARG);
+    MEMSET(pElements, 0x00, SIZEOF(RtpExtensionElements));
+
+    while (STATUS_SUCCEEDED(status = rtp_packet_nextExtension(pRtpPacket, &offset, &id, &pData, &len))) {
+        if ((extension = pRtpExtensionMap->extensions[id]) != 0) {
+            pElements->pData[extension - 1] = pData;
+            pElements->length[extension - 1] = len;
+        }
+    }
+    // a packet without an extension simply carries no element
+    CHK(status == STATUS_RTP_EXTENSION_NOT_FOUND, status);
+
+CleanUp:
+    return retStatus;
+}
+
+STATUS rtp_extension_layout_build(PRtpExtensionMap pRtpExtensionMap, PRtpExtensionElements pElements, PRtpExtensionLayout pRtpExtensionLayout)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 i, length = 0, headerLen;
+    UINT8 id;
+    BOOL twoByte = FALSE;
+
+    CHK(pRtpExtensionMap != NULL && pElements != NULL && pRtpExtensionLayout != NULL, STATUS_RTP_NULL_ARG);
+    MEMSET(pRtpExtensionLayout, 0x00, SIZEOF(RtpExtensionLayout));
+
+    // https://tools.ietf.org/html/rfc8285#section-4.1.2 a packet carries a single format, the two-byte one only if an element needs it
+    for (i = 0; i < RTP_EXTENSION_COUNT; i++) {
+        if (pRtpExtensionMap->ids[i] != 0 && pElements->length[i] > 0) {
+            twoByte = twoByte || pRtpExtensionMap->ids[i] > RTP_ONE_BYTE_EXTENSION_ID_MAX || pElements->length[i] > RTP_ONE_BYTE_EXTENSION_MAX_LEN;
+        }
+    }
+    headerLen = twoByte ? 2 : 1;
+
+    for (i = 0; i < RTP_EXTENSION_COUNT; i++) {
+        id = pRtpExtensionMap->ids[i];
+        if (id == 0 || pElements->length[i] == 0) {
+            continue;
+        }
+        CHK(length + headerLen + pElements->length[i] <= RTP_MAX_HEADER_EXTENSION_LEN, STATUS_RTP_BUFFER_TOO_SMALL);
+        if (twoByte) {
+            pRtpExtensionLayout->payload[length] = id;
+            pRtpExtensionLayout->payload[length + 1] = pElements->length[i];
+        } else {
+            pRtpExtensionLayout->payload[length] = (id << RTP_ONE_BYTE_EXTENSION_ID_SHIFT) | (pElements->length[i] - 1);
+        }
+        length += headerLen;
+        pRtpExtensionLayout->offsets[i] = length;
+        if (pElements->pData[i] != NULL) {
+            MEMCPY(pRtpExtensionLayout->payload + length, pElements->pData[i], pElements->length[i]);
+        }
+        length += pElements->length[i];
+    }
+
+    // the payload is zeroed, so the padding is already there
+    pRtpExtensionLayout->length = ROUND_UP(length, SIZEOF(UINT32));
+    CHK(pRtpExtensionLayout->length <= RTP_MAX_HEADER_EXTENSION_LEN, STATUS_RTP_BUFFER_TOO_SMALL);
+    pRtpExtensionLayout->profile = twoByte ? RTP_TWO_BYTE_EXTENSION_PROFILE : RTP_ONE_BYTE_EXTENSION_PROFILE;
+
+CleanUp:
+    if (STATUS_FAILED(retStatus) && pRtpExtensionLayout != NULL) {
+        MEMSET(pRtpExtensionLayout, 0x00, SIZEOF(RtpExtensionLayout));
+    }
+
+    return retStatus;
+}
+
+VOID rtp_extension_layout_apply(PRtpExtensionLayout pRtpExtensionLayout, PRtpPacket pRtpPacket)
+{
+    pRtpPacket->header.extension = pRtpExtensionLayout->length > 0;
+    pRtpPacket->header.extensionProfile = pRtpExtensionLayout->profile;
+    pRtpPacket->header.extensionPayload = pRtpExtensionLayout->length > 0 ? pRtpExtensionLayout->payload : NULL;
+    pRtpPacket->header.extensionLength = pRtpExtensionLayout->length;
+}
+
+STATUS rtp_extension_renameElement(PRtpPacket pRtpPacket, UINT8 id, UINT8 newId)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PBYTE pData = NULL;
+    UINT8 length = 0;
+
+    CHK(pRtpPacket != NULL, STATUS_RTP_NULL_ARG);
+    CHK(newId != 0, STATUS_INVALID_ARG);
+    CHK_STATUS(rtp_packet_getExtension(pRtpPacket, id, &pData, &length));
+
+    // The id sits in the byte before the length of a two-byte element, and in the high nibble of the single header byte otherwise
+    if (pRtpPacket->header.extensionProfile != RTP_ONE_BYTE_EXTENSION_PROFILE) {
+        pData[-2] = newId;
+    } else {
+        CHK(newId <= RTP_ONE_BYTE_EXTENSION_ID_MAX, STATUS_INVALID_ARG);
+        pData[-1] = (BYTE) ((newId << RTP_ONE_BYTE_EXTENSION_ID_SHIFT) | (pData[-1] & RTP_ONE_BYTE_EXTENSION_LEN_MASK));
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS rtp_extension_readAbsSendTime(PRtpExtensionElements pElements, PUINT64 pSendTime)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PBYTE pData;
+
+    CHK(pElements != NULL && pSendTime != NULL, STATUS_RTP_NULL_ARG);
+    pData = pElements->pData[RTP_EXTENSION_ABS_SEND_TIME];
+    CHK(pData != NULL && pElements->length[RTP_EXTENSION_ABS_SEND_TIME] == RTP_ABS_SEND_TIME_LEN, STATUS_RTP_EXTENSION_NOT_FOUND);
+
+    // 6.18 fixed point seconds
+    *pSendTime = ((((UINT64) pData[0] << 16) | ((UINT64) pData[1] << 8) | pData[2]) * HUNDREDS_OF_NANOS_IN_A_SECOND) >> 18;
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS rtp_extension_readAbsCaptureTime(PRtpExtensionElements pElements, PUINT64 pCaptureNtpTime, PINT64 pClockOffset)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PBYTE pData;
+    UINT8 length;
+
+    CHK(pElements != NULL && pCaptureNtpTime != NULL, STATUS_RTP_NULL_ARG);
+    pData = pElements->pData[RTP_EXTENSION_ABS_CAPTURE_TIME];
+    length = pElements->length[RTP_EXTENSION_ABS_CAPTURE_TIME];
+    CHK(pData != NULL && (length == RTP_ABS_CAPTURE_TIME_LEN || length == RTP_ABS_CAPTURE_TIME_WITH_OFFSET_LEN), STATUS_RTP_EXTENSION_NOT_FOUND);
+
+    *pCaptureNtpTime = (UINT64) getUnalignedInt64BigEndian(pData);
+    if (pClockOffset != NULL) {
+        *pClockOffset = length == RTP_ABS_CAPTURE_TIME_WITH_OFFSET_LEN ? (INT64) getUnalignedInt64BigEndian(pData + RTP_ABS_CAPTURE_TIME_LEN) : 0;
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS rtp_extension_readVideoOrientation(PRtpExtensionElements pElements, PUINT16 pRotation, PBOOL pFlip)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PBYTE pData;
+
+    CHK(pElements != NULL && pRotation != NULL, STATUS_RTP_NULL_ARG);
+    pData = pElements->pData[RTP_EXTENSION_VIDEO_ORIENTATION];
+    CHK(pData != NULL && pElements->length[RTP_EXTENSION_VIDEO_ORIENTATION] >= RTP_VIDEO_ORIENTATION_LEN, STATUS_RTP_EXTENSION_NOT_FOUND);
+
+    // C F R1 R0 in the low nibble, the camera bit does not change how the frame is shown
+    *pRotation = (UINT16) ((pData[0] & RTP_VIDEO_ORIENTATION_ROTATION_MASK) * RTP_VIDEO_ORIENTATION_ROTATION_DEGREE);
+    if (pFlip != NULL) {
+        *pFlip = (pData[0] & RTP_VIDEO_ORIENTATION_FLIP_BIT) != 0;
+    }
+
+CleanUp:
+
+    return retStatus;
+}
@@ -0,0 +1,197 @@
+/*
+ * Copyright 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+#ifndef __KINESIS_VIDEO_WEBRTC_CLIENT_RTP_RTPEXTENSION_H
+#define __KINESIS_VIDEO_WEBRTC_CLIENT_RTP_RTPEXTENSION_H
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/******************************************************************************
+ * HEADERS
+ ******************************************************************************/
+#include "kvs/error.h"
+#include "kvs/common_defs.h"
+#include "kvs/platform_utils.h"
+#include "RtpPacket.h"
+
+/******************************************************************************
+ * DEFINITIONS
+ ******************************************************************************/
+// https://tools.ietf.org/html/draft-holmer-rmcat-transport-wide-cc-extensions-01
+#define TWCC_EXT_URL (PCHAR) "http://www.ietf.org/id/draft-holmer-rmcat-transport-wide-cc-extensions-01"
+// https://tools.ietf.org/html/rfc8843#section-15.1 and https://tools.ietf.org/html/rfc8852#section-3
+#define MID_EXT_URL  (PCHAR) "urn:ietf:params:rtp-hdrext:sdes:mid"
+#define RID_EXT_URL  (PCHAR) "urn:ietf:params:rtp-hdrext:sdes:rtp-stream-id"
+#define RRID_EXT_URL (PCHAR) "urn:ietf:params:rtp-hdrext:sdes:repaired-rtp-stream-id"
+// http://www.webrtc.org/experiments/rtp-hdrext/abs-send-time and http://www.webrtc.org/experiments/rtp-hdrext/abs-capture-time
+#define ABS_SEND_TIME_EXT_URL    (PCHAR) "http://www.webrtc.org/experiments/rtp-hdrext/abs-send-time"
+#define ABS_CAPTURE_TIME_EXT_URL (PCHAR) "http://www.webrtc.org/experiments/rtp-hdrext/abs-capture-time"
+// https://www.3gpp.org/ftp/Specs/archive/26_series/26.114 section 7.4.5
+#define VIDEO_ORIENTATION_EXT_URL (PCHAR) "urn:3gpp:video-orientation"
+// The ids we offer, the answerer's choice wins once the remote description is set
+#define DEFAULT_TWCC_EXT_ID 3
+#define DEFAULT_MID_EXT_ID  4
+#define DEFAULT_RID_EXT_ID  10
+#define DEFAULT_RRID_EXT_ID 11
+
+// The transport-wide sequence number, the mid and the rid elements of a header extension, padded to 32-bit words
+#define RTP_MAX_HEADER_EXTENSION_LEN 40
+
+// 24 bits of seconds in 6.18 fixed point
+#define RTP_ABS_SEND_TIME_LEN 3
+// the 64-bit ntp timestamp of the capture, optionally followed by the 64-bit offset of the capture clock in 32.32 fixed point
+#define RTP_ABS_CAPTURE_TIME_LEN              8
+#define RTP_ABS_CAPTURE_TIME_WITH_OFFSET_LEN  16
+#define RTP_VIDEO_ORIENTATION_LEN             1
+#define RTP_VIDEO_ORIENTATION_CAMERA_BIT      0x08
+#define RTP_VIDEO_ORIENTATION_FLIP_BIT        0x04
+#define RTP_VIDEO_ORIENTATION_ROTATION_MASK   0x03
+#define RTP_VIDEO_ORIENTATION_ROTATION_DEGREE 90
+
+/**
+ * The header extensions this sdk knows about. The elements of a layout follow this order, so the transport-wide sequence number which is
+ * patched per packet comes first.
+ */
+typedef enum {
+    RTP_EXTENSION_TWCC, //!< the transport-wide sequence number.
+    RTP_EXTENSION_MID,  //!< the mid of the media section, https://www.rfc-editor.org/rfc/rfc8843
+    RTP_EXTENSION_RID,  //!< the rid of a simulcast encoding, https://www.rfc-editor.org/rfc/rfc8852
+    RTP_EXTENSION_RRID, //!< the rid a retransmission repairs, https://www.rfc-editor.org/rfc/rfc8852
+    RTP_EXTENSION_ABS_SEND_TIME,     //!< the send time of the packet, only read from received packets.
+    RTP_EXTENSION_ABS_CAPTURE_TIME,  //!< the ntp capture time of the frame, only read from received packets.
+    RTP_EXTENSION_VIDEO_ORIENTATION, //!< the rotation and the flip of the frame, only read from received packets.
+    RTP_EXTENSION_COUNT,
+} RTP_EXTENSION;
+
+/**
+ * The ids negotiated by the a=extmap lines, kept both ways so that a received element is resolved without a search.
+ */
+typedef struct {
+    UINT8 ids[RTP_EXTENSION_COUNT];                      //!< the negotiated id of every extension, 0 if not negotiated.
+    UINT8 extensions[RTP_TWO_BYTE_EXTENSION_ID_MAX + 1]; //!< the extension of every id plus one, 0 if the id is not negotiated.
+} RtpExtensionMap, *PRtpExtensionMap;
+
+/**
+ * The elements of the header extension of a packet, indexed by RTP_EXTENSION.
+ */
+typedef struct {
+    PBYTE pData[RTP_EXTENSION_COUNT]; //!< the value of every element, NULL if the packet does not carry it.
+    UINT8 length[RTP_EXTENSION_COUNT];
+} RtpExtensionElements, *PRtpExtensionElements;
+
+/**
+ * The header extension of the packets of a sender, laid out once per negotiation. The packets point at payload, so the per packet work is
+ * a store at the offset of the element.
+ */
+typedef struct {
+    UINT16 profile;                      //!< RTP_ONE_BYTE_EXTENSION_PROFILE or RTP_TWO_BYTE_EXTENSION_PROFILE.
+    UINT32 length;                       //!< the length of payload padded to 32-bit words, 0 if the packets carry no extension.
+    UINT32 offsets[RTP_EXTENSION_COUNT]; //!< the offset of the value of every element in payload, 0 if the element is not sent.
+    BYTE payload[RTP_MAX_HEADER_EXTENSION_LEN];
+} RtpExtensionLayout, *PRtpExtensionLayout;
+
+/******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+/**
+ * @return the uri of the extension in the a=extmap lines, NULL if it is out of range.
+ */
+PCHAR rtp_extension_getUri(RTP_EXTENSION);
+/**
+ * @brief forget every negotiated id.
+ */
+VOID rtp_extension_map_reset(PRtpExtensionMap);
+/**
+ * @brief negotiate the id of an extension, an id already taken by another extension is moved over.
+ *
+ * @param[in] pRtpExtensionMap the map.
+ * @param[in] extension the extension.
+ * @param[in] id the id, 0 to drop the extension.
+ *
+ * @return STATUS status of execution
+ */
+STATUS rtp_extension_map_set(PRtpExtensionMap, RTP_EXTENSION, UINT8);
+/**
+ * @brief read every negotiated element of a received packet in a single pass, the elements point into the extension payload of the packet.
+ *
+ * @param[in] pRtpExtensionMap the negotiated ids.
+ * @param[in] pRtpPacket the rtp packet.
+ * @param[out] pElements the elements.
+ *
+ * @return STATUS status of execution
+ */
+STATUS rtp_extension_parse(PRtpExtensionMap, PRtpPacket, PRtpExtensionElements);
+/**
+ * @brief lay out the elements with the one-byte header, or with the two-byte header if an id or a value does not fit into it.
+ *        An element whose id is not negotiated is left out.
+ *
+ * @param[in] pRtpExtensionMap the negotiated ids.
+ * @param[in] pElements the values of the elements, a length of 0 leaves the element out and a NULL value with a length reserves
+ *                      zeroes to be patched per packet.
+ * @param[out] pRtpExtensionLayout the layout.
+ *
+ * @return STATUS_RTP_BUFFER_TOO_SMALL if the elements do not fit into RTP_MAX_HEADER_EXTENSION_LEN.
+ */
+STATUS rtp_extension_layout_build(PRtpExtensionMap, PRtpExtensionElements, PRtpExtensionLayout);
+/**
+ * @brief point a packet at a layout, the packet carries no extension if the layout is empty.
+ */
+VOID rtp_extension_layout_apply(PRtpExtensionLayout, PRtpPacket);
+/**
+ * @brief give an element of a parsed packet another id in place, the element keeps its place and its value.
+ *
+ * @param[in] pRtpPacket the rtp packet, its extension payload is rewritten.
+ * @param[in] id the id of the element.
+ * @param[in] newId the new id.
+ *
+ * @return STATUS_RTP_EXTENSION_NOT_FOUND if the packet does not carry the element, STATUS_INVALID_ARG if newId does not fit into the one-byte header.
+ */
+STATUS rtp_extension_renameElement(PRtpPacket, UINT8, UINT8);
+/**
+ * @brief read the abs-send-time element of a parsed packet.
+ *
+ * @param[in] pElements the parsed elements.
+ * @param[out] pSendTime the send time in 100ns units, modulo 64 seconds.
+ *
+ * @return STATUS_RTP_EXTENSION_NOT_FOUND if the packet does not carry a well formed element.
+ */
+STATUS rtp_extension_readAbsSendTime(PRtpExtensionElements, PUINT64);
+/**
+ * @brief read the abs-capture-time element of a parsed packet.
+ *
+ * @param[in] pElements the parsed elements.
+ * @param[out] pCaptureNtpTime the 64-bit ntp timestamp of the capture.
+ * @param[out] pClockOffset the offset of the capture clock in 32.32 fixed point, 0 if the element does not carry it. Optional.
+ *
+ * @return STATUS_RTP_EXTENSION_NOT_FOUND if the packet does not carry a well formed element.
+ */
+STATUS rtp_extension_readAbsCaptureTime(PRtpExtensionElements, PUINT64, PINT64);
+/**
+ * @brief read the video orientation element of a parsed packet.
+ *
+ * @param[in] pElements the parsed elements.
+ * @param[out] pRotation the clockwise rotation in degrees, one of 0, 90, 180 and 270.
+ * @param[out] pFlip whether the frame is flipped horizontally. Optional.
+ *
+ * @return STATUS_RTP_EXTENSION_NOT_FOUND if the packet does not carry a well formed element.
+ */
+STATUS rtp_extension_readVideoOrientation(PRtpExtensionElements, PUINT16, PBOOL);
+
+#ifdef __cplusplus
+}
+#endif
+#endif //__KINESIS_VIDEO_WEBRTC_CLIENT_RTP_RTPEXTENSION_H
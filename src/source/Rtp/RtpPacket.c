@@ -2,6 +2,7 @@
 
 #include "endianness.h"
 #include "RtpPacket.h"
+#include "RtpPacketPool.h"
 
 STATUS rtp_packet_create(UINT8 version, BOOL padding, BOOL extension, UINT8 csrcCount, BOOL marker, UINT8 payloadType, UINT16 sequenceNumber,
                          UINT32 timestamp, UINT32 ssrc, PUINT32 csrcArray, UINT16 extensionProfile, UINT32 extensionLength, PBYTE extensionPayload,
@@ -9,10 +10,9 @@ STATUS rtp_packet_create(UINT8 version, BOOL padding, BOOL extension, UINT8 csrc
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
-    PRtpPacket pRtpPacket = (PRtpPacket) MEMALLOC(SIZEOF(RtpPacket));
+    PRtpPacket pRtpPacket = (PRtpPacket) MEMCALLOC(1, SIZEOF(RtpPacket));
     CHK(pRtpPacket != NULL, STATUS_NOT_ENOUGH_MEMORY);
-    pRtpPacket->pRawPacket = NULL;
-    pRtpPacket->rawPacketLength = 0;
+    pRtpPacket->refCount = 1;
     CHK_STATUS(rtp_packet_set(version, padding, extension, csrcCount, marker, payloadType, sequenceNumber, timestamp, ssrc, csrcArray,
                               extensionProfile, extensionLength, extensionPayload, payload, payloadLength, pRtpPacket));
 
@@ -70,12 +70,22 @@ STATUS rtp_packet_free(PRtpPacket* ppRtpPacket)
 
     STATUS retStatus = STATUS_SUCCESS;
 
+    PRtpPacket pRtpPacket = NULL;
+
     CHK(ppRtpPacket != NULL, STATUS_RTP_NULL_ARG);
+    pRtpPacket = *ppRtpPacket;
+    CHK(pRtpPacket != NULL, retStatus);
+    *ppRtpPacket = NULL;
+
+    // Other owners still hold the packet
+    CHK(ATOMIC_DECREMENT(&pRtpPacket->refCount) <= 1, retStatus);
 
-    if (*ppRtpPacket != NULL) {
-        SAFE_MEMFREE((*ppRtpPacket)->pRawPacket);
+    if (pRtpPacket->pPool != NULL) {
+        CHK_STATUS(rtp_packet_pool_put(pRtpPacket));
+    } else {
+        SAFE_MEMFREE(pRtpPacket->pRawPacket);
+        MEMFREE(pRtpPacket);
     }
-    SAFE_MEMFREE(*ppRtpPacket);
 
 CleanUp:
 
@@ -85,12 +95,24 @@ CleanUp:
     return retStatus;
 }
 
+STATUS rtp_packet_addRef(PRtpPacket pRtpPacket)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+
+    CHK(pRtpPacket != NULL, STATUS_RTP_NULL_ARG);
+    ATOMIC_INCREMENT(&pRtpPacket->refCount);
+
+CleanUp:
+    return retStatus;
+}
+
 STATUS rtp_packet_createFromBytes(PBYTE rawPacket, UINT32 packetLength, PRtpPacket* ppRtpPacket)
 {
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
-    PRtpPacket pRtpPacket = (PRtpPacket) MEMALLOC(SIZEOF(RtpPacket));
+    PRtpPacket pRtpPacket = (PRtpPacket) MEMCALLOC(1, SIZEOF(RtpPacket));
     CHK(pRtpPacket != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    pRtpPacket->refCount = 1;
     pRtpPacket->pRawPacket = rawPacket;
     pRtpPacket->rawPacketLength = packetLength;
     CHK_STATUS(rtp_packet_setPacketFromBytes(rawPacket, packetLength, pRtpPacket));
@@ -118,9 +140,10 @@ STATUS rtp_packet_constructRetransmitPacketFromBytes(PBYTE rawPacket, UINT32 pac
     ENTERS();
     STATUS retStatus = STATUS_SUCCESS;
     PBYTE pPayload = NULL;
-    PRtpPacket pRtpPacket = (PRtpPacket) MEMALLOC(SIZEOF(RtpPacket));
+    PRtpPacket pRtpPacket = (PRtpPacket) MEMCALLOC(1, SIZEOF(RtpPacket));
 
     CHK(pRtpPacket != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    pRtpPacket->refCount = 1;
     CHK_STATUS(rtp_packet_setPacketFromBytes(rawPacket, packetLength, pRtpPacket));
     pPayload = (PBYTE) MEMALLOC(pRtpPacket->payloadLength + SIZEOF(UINT16));
     CHK(pPayload != NULL, STATUS_NOT_ENOUGH_MEMORY);
@@ -347,3 +370,63 @@ CleanUp:
     LEAVES();
     return retStatus;
 }
+
+STATUS rtp_packet_nextExtension(PRtpPacket pRtpPacket, PUINT32 pOffset, PUINT8 pId, PBYTE* ppData, PUINT8 pDataLen)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PBYTE pPayload;
+    UINT32 offset, length;
+    UINT8 id = 0, len = 0;
+    BOOL twoByte;
+
+    CHK(pRtpPacket != NULL && pOffset != NULL && pId != NULL && ppData != NULL && pDataLen != NULL, STATUS_RTP_NULL_ARG);
+    CHK(pRtpPacket->header.extension && pRtpPacket->header.extensionPayload != NULL, STATUS_RTP_EXTENSION_NOT_FOUND);
+    twoByte = (pRtpPacket->header.extensionProfile & RTP_TWO_BYTE_EXTENSION_PROFILE_MASK) == RTP_TWO_BYTE_EXTENSION_PROFILE;
+    CHK(twoByte || pRtpPacket->header.extensionProfile == RTP_ONE_BYTE_EXTENSION_PROFILE, STATUS_RTP_EXTENSION_NOT_FOUND);
+
+    pPayload = pRtpPacket->header.extensionPayload;
+    length = pRtpPacket->header.extensionLength;
+    offset = *pOffset;
+    // padding bytes between the elements
+    while (offset < length && pPayload[offset] == 0) {
+        offset++;
+    }
+    CHK(offset < length, STATUS_RTP_EXTENSION_NOT_FOUND);
+
+    if (twoByte) {
+        CHK(offset + 2 <= length, STATUS_RTP_INVALID_EXTENSION_LEN);
+        id = pPayload[offset];
+        len = pPayload[offset + 1];
+        offset += 2;
+    } else {
+        id = pPayload[offset] >> RTP_ONE_BYTE_EXTENSION_ID_SHIFT;
+        len = (pPayload[offset] & RTP_ONE_BYTE_EXTENSION_LEN_MASK) + 1;
+        // id 15 terminates the processing of the extension
+        CHK(id <= RTP_ONE_BYTE_EXTENSION_ID_MAX, STATUS_RTP_EXTENSION_NOT_FOUND);
+        offset += 1;
+    }
+    CHK(offset + len <= length, STATUS_RTP_INVALID_EXTENSION_LEN);
+
+    *pId = id;
+    *ppData = pPayload + offset;
+    *pDataLen = len;
+    *pOffset = offset + len;
+
+CleanUp:
+    return retStatus;
+}
+
+STATUS rtp_packet_getExtension(PRtpPacket pRtpPacket, UINT8 extId, PBYTE* ppData, PUINT8 pDataLen)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 offset = 0;
+    UINT8 id = 0;
+
+    CHK(ppData != NULL && pDataLen != NULL, STATUS_RTP_NULL_ARG);
+    do {
+        CHK_STATUS(rtp_packet_nextExtension(pRtpPacket, &offset, &id, ppData, pDataLen));
+    } while (id != extId);
+
+CleanUp:
+    return retStatus;
+}
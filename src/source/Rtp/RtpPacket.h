@@ -26,6 +26,7 @@ extern "C" {
 #include "kvs/error.h"
 #include "kvs/common_defs.h"
 #include "kvs/platform_utils.h"
+#include "NaluIndex.h"
 /******************************************************************************
  * DEFINITIONS
  ******************************************************************************/
@@ -51,6 +52,18 @@ extern "C" {
 
 #define RTP_GET_RAW_PACKET_SIZE(pRtpPacket) (RTP_HEADER_LEN(pRtpPacket) + ((pRtpPacket)->payloadLength))
 
+// https://tools.ietf.org/html/rfc8285#section-4.2
+#define RTP_ONE_BYTE_EXTENSION_PROFILE  0xBEDE
+#define RTP_ONE_BYTE_EXTENSION_ID_SHIFT 4
+#define RTP_ONE_BYTE_EXTENSION_LEN_MASK 0xF
+#define RTP_ONE_BYTE_EXTENSION_ID_MAX   14
+#define RTP_ONE_BYTE_EXTENSION_MAX_LEN  16
+// https://tools.ietf.org/html/rfc8285#section-4.3, the low 4 bits are the appbits
+#define RTP_TWO_BYTE_EXTENSION_PROFILE      0x1000
+#define RTP_TWO_BYTE_EXTENSION_PROFILE_MASK 0xFFF0
+#define RTP_TWO_BYTE_EXTENSION_ID_MAX       255
+#define RTP_TWO_BYTE_EXTENSION_MAX_LEN      255
+
 #define GET_UINT16_SEQ_NUM(seqIndex) ((UINT16)((seqIndex) % (MAX_UINT16 + 1)))
 
 typedef STATUS (*DepayRtpPayloadFunc)(PBYTE, UINT32, PBYTE, PUINT32, PBOOL);
@@ -93,8 +106,11 @@ typedef struct __Payloads {
     PUINT32 payloadSubLength;
     UINT32 payloadSubLenSize;
     UINT32 maxPayloadSubLenSize;
+    NaluIndex naluIndex; //!< the NALUs of the current Annex-B frame, shared by the sizing and the filling passes of rtp_packetizeFrame.
 } PayloadArray, *PPayloadArray;
 
+struct __RtpPacketPool;
+
 typedef struct __RtpPacket {
     RtpPacketHeader header;
     PBYTE payload;
@@ -103,6 +119,10 @@ typedef struct __RtpPacket {
     UINT32 rawPacketLength;
     // used for jitterBufferDelay calculation
     UINT64 receivedTime;
+    // the pool the packet came from, NULL if the packet and its raw packet were allocated separately
+    struct __RtpPacketPool* pPool;
+    // the packet is released when the last owner calls rtp_packet_free
+    volatile SIZE_T refCount;
 } RtpPacket, *PRtpPacket;
 
 /******************************************************************************
@@ -110,7 +130,15 @@ typedef struct __RtpPacket {
  ******************************************************************************/
 STATUS rtp_packet_create(UINT8, BOOL, BOOL, UINT8, BOOL, UINT8, UINT16, UINT32, UINT32, PUINT32, UINT16, UINT32, PBYTE, PBYTE, UINT32, PRtpPacket*);
 STATUS rtp_packet_set(UINT8, BOOL, BOOL, UINT8, BOOL, UINT8, UINT16, UINT32, UINT32, PUINT32, UINT16, UINT32, PBYTE, PBYTE, UINT32, PRtpPacket);
+/**
+ * @brief drop one reference of the packet and set the pointer to NULL. The last reference frees the packet with its raw packet,
+ *        or gives it back to its pool.
+ */
 STATUS rtp_packet_free(PRtpPacket*);
+/**
+ * @brief take one more reference of the packet, every reference is dropped with rtp_packet_free.
+ */
+STATUS rtp_packet_addRef(PRtpPacket);
 /**
  * @brief send packets to the corresponding rtp receiver.
  *
@@ -126,6 +154,29 @@ STATUS rtp_packet_setPacketFromBytes(PBYTE, UINT32, PRtpPacket);
 STATUS rtp_packet_createBytesFromPacket(PRtpPacket, PBYTE, PUINT32);
 STATUS rtp_packet_setBytesFromPacket(PRtpPacket, PBYTE, UINT32);
 STATUS rtp_packet_constructPackets(PPayloadArray, UINT8, UINT16, UINT32, UINT32, PRtpPacket, UINT32);
+/**
+ * @brief walk the elements of a one-byte or a two-byte header extension, https://tools.ietf.org/html/rfc8285#section-4
+ *
+ * @param[in] pRtpPacket the rtp packet.
+ * @param[in, out] pOffset the offset of the next element in the extension payload, 0 for the first one.
+ * @param[out] pId the id of the element.
+ * @param[out] ppData the data of the element, it points into the extension payload of the packet.
+ * @param[out] pDataLen the length of the data.
+ *
+ * @return STATUS_RTP_EXTENSION_NOT_FOUND after the last element.
+ */
+STATUS rtp_packet_nextExtension(PRtpPacket, PUINT32, PUINT8, PBYTE*, PUINT8);
+/**
+ * @brief look up an element of a one-byte or a two-byte header extension, https://tools.ietf.org/html/rfc8285#section-4
+ *
+ * @param[in] pRtpPacket the rtp packet.
+ * @param[in] extId the negotiated id of the element.
+ * @param[out] ppData the data of the element, it points into the extension payload of the packet.
+ * @param[out] pDataLen the length of the data.
+ *
+ * @return STATUS_RTP_EXTENSION_NOT_FOUND if the packet does not carry the element.
+ */
+STATUS rtp_packet_getExtension(PRtpPacket, UINT8, PBYTE*, PUINT8);
 
 #ifdef __cplusplus
 }
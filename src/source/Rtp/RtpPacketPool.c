@@ -0,0 +1,240 @@
+/*
+ * Copyright 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+/******************************************************************************
+ * HEADERS
+ ******************************************************************************/
+#define LOG_CLASS "RtpPacketPool"
+
+#include "RtpPacketPool.h"
+
+/******************************************************************************
+ * DEFINITIONS
+ ******************************************************************************/
+#define RTP_PACKET_POOL_SLOT_STRIDE(slotSize) ROUND_UP(SIZEOF(RtpPacket) + (slotSize), SIZEOF(UINT64))
+#define RTP_PACKET_POOL_CHUNK_HEADER_LEN      ROUND_UP(SIZEOF(PBYTE), SIZEOF(UINT64))
+
+/******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+STATUS rtp_packet_pool_create(UINT32 slotCount, UINT32 slotSize, PRtpPacketPool* ppRtpPacketPool)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PRtpPacketPool pRtpPacketPool = NULL;
+
+    CHK(ppRtpPacketPool != NULL, STATUS_NULL_ARG);
+    CHK(slotCount != 0 && slotSize != 0, STATUS_INVALID_ARG);
+
+    pRtpPacketPool = (PRtpPacketPool) MEMCALLOC(1, SIZEOF(RtpPacketPool));
+    CHK(pRtpPacketPool != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    pRtpPacketPool->lock = MUTEX_CREATE(FALSE);
+    CHK(IS_VALID_MUTEX_VALUE(pRtpPacketPool->lock), STATUS_INVALID_OPERATION);
+    pRtpPacketPool->pFreePackets = (PRtpPacket*) MEMALLOC(slotCount * SIZEOF(PRtpPacket));
+    CHK(pRtpPacketPool->pFreePackets != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    pRtpPacketPool->slotCount = slotCount;
+    pRtpPacketPool->slotSize = slotSize;
+
+CleanUp:
+    if (STATUS_FAILED(retStatus)) {
+        rtp_packet_pool_free(&pRtpPacketPool);
+    }
+
+    if (ppRtpPacketPool != NULL) {
+        *ppRtpPacketPool = pRtpPacketPool;
+    }
+    LEAVES();
+    return retStatus;
+}
+
+STATUS rtp_packet_pool_free(PRtpPacketPool* ppRtpPacketPool)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PRtpPacketPool pRtpPacketPool = NULL;
+    PBYTE pSlotArena;
+
+    CHK(ppRtpPacketPool != NULL, STATUS_NULL_ARG);
+    pRtpPacketPool = *ppRtpPacketPool;
+    CHK(pRtpPacketPool != NULL, retStatus);
+
+    if (pRtpPacketPool->packetsInUse != 0) {
+        DLOGW("%u pooled rtp packets are still in use", pRtpPacketPool->packetsInUse);
+    }
+    if (IS_VALID_MUTEX_VALUE(pRtpPacketPool->lock)) {
+        MUTEX_FREE(pRtpPacketPool->lock);
+    }
+    while (pRtpPacketPool->pSlotArena != NULL) {
+        pSlotArena = pRtpPacketPool->pSlotArena;
+        pRtpPacketPool->pSlotArena = *(PBYTE*) pSlotArena;
+        MEMFREE(pSlotArena);
+    }
+    SAFE_MEMFREE(pRtpPacketPool->pFreePackets);
+    SAFE_MEMFREE(*ppRtpPacketPool);
+
+CleanUp:
+    CHK_LOG_ERR(retStatus);
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS rtp_packet_pool_reserve(PRtpPacketPool pRtpPacketPool, UINT32 count)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    BOOL locked = FALSE;
+    PRtpPacket* pFreePackets = NULL;
+
+    CHK(pRtpPacketPool != NULL, STATUS_NULL_ARG);
+    CHK(count != 0, retStatus);
+
+    MUTEX_LOCK(pRtpPacketPool->lock);
+    locked = TRUE;
+    // Only the free packet stack grows here, every packet of the pool has to fit on it once they are all released.
+    pFreePackets = (PRtpPacket*) MEMREALLOC(pRtpPacketPool->pFreePackets, (pRtpPacketPool->slotCount + count) * SIZEOF(PRtpPacket));
+    CHK(pFreePackets != NULL, STATUS_NOT_ENOUGH_MEMORY);
+    pRtpPacketPool->pFreePackets = pFreePackets;
+    pRtpPacketPool->slotCount += count;
+
+CleanUp:
+    if (locked) {
+        MUTEX_UNLOCK(pRtpPacketPool->lock);
+    }
+    CHK_LOG_ERR(retStatus);
+
+    LEAVES();
+    return retStatus;
+}
+
+static STATUS rtp_packet_pool_allocateSlots(PRtpPacketPool pRtpPacketPool)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    UINT32 i, slotStride, slotCount;
+    PBYTE pSlotArena = NULL;
+
+    // One allocation for all the slots which have not been carved out yet.
+    slotCount = pRtpPacketPool->slotCount - pRtpPacketPool->allocatedSlotCount;
+    slotStride = RTP_PACKET_POOL_SLOT_STRIDE(pRtpPacketPool->slotSize);
+    pSlotArena = (PBYTE) MEMALLOC(RTP_PACKET_POOL_CHUNK_HEADER_LEN + slotCount * slotStride);
+    CHK(pSlotArena != NULL, STATUS_NOT_ENOUGH_MEMORY);
+
+    for (i = 0; i < slotCount; i++) {
+        pRtpPacketPool->pFreePackets[pRtpPacketPool->freePacketCount++] =
+            (PRtpPacket) (pSlotArena + RTP_PACKET_POOL_CHUNK_HEADER_LEN + i * slotStride);
+    }
+    pRtpPacketPool->allocatedSlotCount += slotCount;
+    *(PBYTE*) pSlotArena = pRtpPacketPool->pSlotArena;
+    pRtpPacketPool->pSlotArena = pSlotArena;
+
+CleanUp:
+    return retStatus;
+}
+
+STATUS rtp_packet_pool_get(PRtpPacketPool pRtpPacketPool, UINT32 size, PRtpPacket* ppRtpPacket)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    BOOL locked = FALSE;
+    PRtpPacket pRtpPacket = NULL;
+    PBYTE pRawPacket = NULL;
+
+    CHK(pRtpPacketPool != NULL && ppRtpPacket != NULL, STATUS_NULL_ARG);
+
+    MUTEX_LOCK(pRtpPacketPool->lock);
+    locked = TRUE;
+    if (size <= pRtpPacketPool->slotSize) {
+        if (pRtpPacketPool->freePacketCount == 0 && pRtpPacketPool->allocatedSlotCount < pRtpPacketPool->slotCount) {
+            CHK_STATUS(rtp_packet_pool_allocateSlots(pRtpPacketPool));
+        }
+        if (pRtpPacketPool->freePacketCount > 0) {
+            pRtpPacket = pRtpPacketPool->pFreePackets[--pRtpPacketPool->freePacketCount];
+            pRtpPacketPool->packetsInUse++;
+            pRtpPacketPool->highWaterMark = MAX(pRtpPacketPool->highWaterMark, pRtpPacketPool->packetsInUse);
+        }
+    }
+    if (pRtpPacket == NULL) {
+        pRtpPacketPool->poolMisses++;
+    }
+    MUTEX_UNLOCK(pRtpPacketPool->lock);
+    locked = FALSE;
+
+    if (pRtpPacket != NULL) {
+        MEMSET(pRtpPacket, 0x00, SIZEOF(RtpPacket));
+        pRtpPacket->pPool = pRtpPacketPool;
+        pRtpPacket->pRawPacket = (PBYTE) (pRtpPacket + 1);
+    } else {
+        // Oversized packet or all the slots are in use, fall back to the heap.
+        pRtpPacket = (PRtpPacket) MEMCALLOC(1, SIZEOF(RtpPacket));
+        CHK(pRtpPacket != NULL, STATUS_NOT_ENOUGH_MEMORY);
+        pRawPacket = (PBYTE) MEMALLOC(size);
+        CHK(pRawPacket != NULL, STATUS_NOT_ENOUGH_MEMORY);
+        pRtpPacket->pRawPacket = pRawPacket;
+    }
+    pRtpPacket->refCount = 1;
+
+CleanUp:
+    if (locked) {
+        MUTEX_UNLOCK(pRtpPacketPool->lock);
+    }
+    if (STATUS_FAILED(retStatus)) {
+        SAFE_MEMFREE(pRtpPacket);
+    }
+    if (ppRtpPacket != NULL) {
+        *ppRtpPacket = pRtpPacket;
+    }
+    CHK_LOG_ERR(retStatus);
+
+    LEAVES();
+    return retStatus;
+}
+
+STATUS rtp_packet_pool_put(PRtpPacket pRtpPacket)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PRtpPacketPool pRtpPacketPool = NULL;
+
+    CHK(pRtpPacket != NULL && pRtpPacket->pPool != NULL, STATUS_NULL_ARG);
+    pRtpPacketPool = pRtpPacket->pPool;
+
+    MUTEX_LOCK(pRtpPacketPool->lock);
+    pRtpPacketPool->pFreePackets[pRtpPacketPool->freePacketCount++] = pRtpPacket;
+    pRtpPacketPool->packetsInUse--;
+    MUTEX_UNLOCK(pRtpPacketPool->lock);
+
+CleanUp:
+    LEAVES();
+    return retStatus;
+}
+
+STATUS rtp_packet_pool_getStats(PRtpPacketPool pRtpPacketPool, PRtcRtpPacketPoolStats pRtcRtpPacketPoolStats)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+
+    CHK(pRtpPacketPool != NULL && pRtcRtpPacketPoolStats != NULL, STATUS_NULL_ARG);
+
+    MUTEX_LOCK(pRtpPacketPool->lock);
+    pRtcRtpPacketPoolStats->capacity = pRtpPacketPool->slotCount;
+    pRtcRtpPacketPoolStats->packetSize = pRtpPacketPool->slotSize;
+    pRtcRtpPacketPoolStats->packetsInUse = pRtpPacketPool->packetsInUse;
+    pRtcRtpPacketPoolStats->highWaterMark = pRtpPacketPool->highWaterMark;
+    pRtcRtpPacketPoolStats->poolMisses = pRtpPacketPool->poolMisses;
+    MUTEX_UNLOCK(pRtpPacketPool->lock);
+
+CleanUp:
+    LEAVES();
+    return retStatus;
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2021 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+#ifndef __KINESIS_VIDEO_WEBRTC_CLIENT_RTP_RTPPACKETPOOL_H
+#define __KINESIS_VIDEO_WEBRTC_CLIENT_RTP_RTPPACKETPOOL_H
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+/******************************************************************************
+ * HEADERS
+ ******************************************************************************/
+#include "kvs/error.h"
+#include "kvs/common_defs.h"
+#include "kvs/platform_utils.h"
+#include "kvs/webrtc_client.h"
+#include "RtpPacket.h"
+
+/******************************************************************************
+ * DEFINITIONS
+ ******************************************************************************/
+/**
+ * Pool of refcounted rtp packets. The raw packet buffer of every pooled packet follows the RtpPacket in memory,
+ * so a packet and its bytes come from a single slot. The slots are carved out in one allocation the first time the pool runs dry,
+ * and again once more slots have been reserved with rtp_packet_pool_reserve, so a pool in steady state never allocates.
+ * When the pool is exhausted or the packet does not fit into a slot, the packet falls back to the heap and it is accounted as a pool miss.
+ */
+typedef struct __RtpPacketPool {
+    MUTEX lock;
+    // Max raw packet size of a pooled packet
+    UINT32 slotSize;
+    // Number of packets the pool may hold, grows with rtp_packet_pool_reserve
+    UINT32 slotCount;
+    // Number of slots carved out so far
+    UINT32 allocatedSlotCount;
+    // Last allocated chunk of slots, every chunk starts with the pointer to the chunk allocated before
+    PBYTE pSlotArena;
+    // Stack of free packets with room for slotCount packets
+    PRtpPacket* pFreePackets;
+    UINT32 freePacketCount;
+    // stats
+    UINT32 packetsInUse;
+    UINT32 highWaterMark;
+    UINT64 poolMisses;
+} RtpPacketPool, *PRtpPacketPool;
+
+/******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+/**
+ * @brief create the rtp packet pool. The slots are not allocated until the first rtp_packet_pool_get.
+ *
+ * @param[in] slotCount the base number of pooled packets.
+ * @param[in] slotSize the max raw packet size of a pooled packet.
+ * @param[out] ppRtpPacketPool the created pool.
+ *
+ * @return STATUS status of execution
+ */
+STATUS rtp_packet_pool_create(UINT32, UINT32, PRtpPacketPool*);
+/**
+ * @brief free the pool. All the pooled packets have to be released before.
+ */
+STATUS rtp_packet_pool_free(PRtpPacketPool*);
+/**
+ * @brief make room for count more pooled packets, for a buffer which is going to hold on to that many packets.
+ *        The slots themselves are allocated once the pool runs dry.
+ *
+ * @param[in] pRtpPacketPool the pool.
+ * @param[in] count the number of packets to reserve.
+ *
+ * @return STATUS status of execution
+ */
+STATUS rtp_packet_pool_reserve(PRtpPacketPool, UINT32);
+/**
+ * @brief get an empty packet with a single reference whose pRawPacket can hold at least size bytes.
+ *        The packet is given back with rtp_packet_free once every owner has dropped its reference.
+ *
+ * @param[in] pRtpPacketPool the pool.
+ * @param[in] size the required raw packet size.
+ * @param[out] ppRtpPacket the packet.
+ *
+ * @return STATUS status of execution
+ */
+STATUS rtp_packet_pool_get(PRtpPacketPool, UINT32, PRtpPacket*);
+/**
+ * @brief give a pooled packet without any reference left back to its pool. Called by rtp_packet_free.
+ */
+STATUS rtp_packet_pool_put(PRtpPacket);
+STATUS rtp_packet_pool_getStats(PRtpPacketPool, PRtcRtpPacketPoolStats);
+
+#ifdef __cplusplus
+}
+#endif
+#endif //__KINESIS_VIDEO_WEBRTC_CLIENT_RTP_RTPPACKETPOOL_H
@@ -52,6 +52,9 @@ typedef enum {
 extern StateMachineState ICE_AGENT_STATE_MACHINE_STATES[];
 extern UINT32 ICE_AGENT_STATE_MACHINE_STATE_COUNT;
 
+// The ip mtus the path mtu discovery probes, largest first. Ethernet, PPPoE, tunnels and the IPv6 minimum
+static const UINT16 gIcePathMtuProbeSizes[ICE_PATH_MTU_PROBE_COUNT] = {1500, 1492, 1450, 1400, 1280};
+
 /******************************************************************************
  * FUNCTIONS
  ******************************************************************************/
@@ -813,6 +816,22 @@ CleanUp:
     ICE_AGENT_LEAVE();
     return retStatus;
 }
+
+/**
+ * @brief sets the don't fragment bit on a udp socket the path mtu probes go out on, an oversized probe would otherwise get through
+ * fragmented and still get an answer. A tcp socket to a turn server is left as it is, the stream is segmented anyway.
+ *
+ * @param[in] pIceAgent IceAgent object
+ * @param[in] pSocketConnection the socket of a local candidate.
+ */
+static VOID ice_agent_setDontFragment(PIceAgent pIceAgent, PSocketConnection pSocketConnection)
+{
+    if (pIceAgent->kvsRtcConfiguration.enablePathMtuDiscovery && pSocketConnection->protocol == KVS_SOCKET_PROTOCOL_UDP &&
+        STATUS_FAILED(socket_connection_setDontFragment(pSocketConnection))) {
+        DLOGW("don't fragment is not available, the path mtu probes may get through fragmented");
+    }
+}
+
 /**
  * @brief gather local ip addresses and create a udp port. If port creation succeeded then create a new candidate
  * and store it in localCandidates. Ips that are already a local candidate will not be added again.
@@ -841,6 +860,11 @@ STATUS ice_agent_initHostCandidate(PIceAgent pIceAgent)
         if (pDuplicatedIceCandidate == NULL &&
             STATUS_SUCCEEDED(socket_connection_create(pIpAddress->family, KVS_SOCKET_PROTOCOL_UDP, pIpAddress, NULL, (UINT64) pIceAgent,
                                                       ice_agent_handleInboundData, pIceAgent->kvsRtcConfiguration.sendBufSize, &pSocketConnection))) {
+            if (pIceAgent->kvsRtcConfiguration.enableUdpSegmentOffload &&
+                STATUS_FAILED(socket_connection_enableUdpSegmentOffload(pSocketConnection))) {
+                DLOGW("udp segmentation offload is not available, packets are sent one at a time");
+            }
+            ice_agent_setDontFragment(pIceAgent, pSocketConnection);
             pTmpIceCandidate = MEMCALLOC(1, SIZEOF(IceCandidate));
             json_generateSafeString(pTmpIceCandidate->id, ARRAY_SIZE(pTmpIceCandidate->id));
             pTmpIceCandidate->isRemote = FALSE;
@@ -937,6 +961,7 @@ static STATUS ice_agent_initSrflxCandidate(PIceAgent pIceAgent)
                     CHK_STATUS(socket_connection_create(pCandidate->ipAddress.family, KVS_SOCKET_PROTOCOL_UDP, &pNewCandidate->ipAddress, NULL,
                                                         (UINT64) pIceAgent, ice_agent_handleInboundData, pIceAgent->kvsRtcConfiguration.sendBufSize,
                                                         &pNewCandidate->pSocketConnection));
+                    ice_agent_setDontFragment(pIceAgent, pNewCandidate->pSocketConnection);
                     ATOMIC_STORE_BOOL(&pNewCandidate->pSocketConnection->receiveData, TRUE);
                     // connectionListener will free the pSocketConnection at the end.
                     CHK_STATUS(connection_listener_add(pIceAgent->pConnectionListener, pNewCandidate->pSocketConnection));
@@ -1017,6 +1042,8 @@ static STATUS ice_agent_initRelayCandidate(PIceAgent pIceAgent, UINT32 iceServer
                                  ice_agent_handleInboundRelayedData, pIceAgent->kvsRtcConfiguration.sendBufSize,
                                  &pNewCandidate->pSocketConnection) == STATUS_SUCCESS,
         STATUS_ICE_AGENT_CREATE_TURN_SOCKET);
+    // The probes of a relayed pair go out on the socket to the turn server
+    ice_agent_setDontFragment(pIceAgent, pNewCandidate->pSocketConnection);
     // connectionListener will free the pSocketConnection at the end.
     CHK_STATUS(connection_listener_add(pIceAgent->pConnectionListener, pNewCandidate->pSocketConnection));
 
@@ -2089,6 +2116,90 @@ CleanUp:
     return retStatus;
 }
 
+STATUS ice_candidate_pair_sendMtuProbes(PIceAgent pIceAgent, PIceCandidatePair pIceCandidatePair)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    PStunPacket pProbe = NULL;
+    UINT32 i, packetSize = 0, paddingLen, passwordLen = (UINT32) STRLEN(pIceAgent->remotePassword) * SIZEOF(CHAR);
+    UINT32 overhead, probeSize;
+
+    CHK(pIceAgent->kvsRtcConfiguration.enablePathMtuDiscovery && pIceCandidatePair->state == ICE_CANDIDATE_PAIR_STATE_SUCCEEDED &&
+            pIceCandidatePair->mtuProbeRounds < ICE_PATH_MTU_PROBE_ROUNDS,
+        retStatus);
+    pIceCandidatePair->mtuProbeRounds++;
+
+    // The probe is the udp payload, the ip and udp headers and the turn framing of a relayed candidate take the rest of the ip mtu
+    overhead = ICE_UDP_HEADER_LEN + (IS_IPV4_ADDR(&pIceCandidatePair->local->ipAddress) ? ICE_IPV4_HEADER_LEN : ICE_IPV6_HEADER_LEN) +
+        (IS_CANN_PAIR_SENDING_FROM_RELAYED(pIceCandidatePair) ? ICE_TURN_SEND_OVERHEAD : 0);
+
+    for (i = 0; i < ICE_PATH_MTU_PROBE_COUNT; i++) {
+        probeSize = gIcePathMtuProbeSizes[i] - overhead;
+        CHK(probeSize > pIceCandidatePair->pathMtu, retStatus);
+
+        CHK_STATUS(stun_createPacket(STUN_PACKET_TYPE_BINDING_REQUEST, NULL, &pProbe));
+        CHK_STATUS(ice_utils_generateTransactionId(pProbe->header.transactionId, ARRAY_SIZE(pProbe->header.transactionId)));
+        CHK_STATUS(stun_attribute_appendUsername(pProbe, pIceAgent->combinedUserName));
+        CHK_STATUS(stun_attribute_appendPriority(pProbe, pIceCandidatePair->local->priority));
+        CHK_STATUS(stun_attribute_appendIceControlMode(
+            pProbe, pIceAgent->isControlling ? STUN_ATTRIBUTE_TYPE_ICE_CONTROLLING : STUN_ATTRIBUTE_TYPE_ICE_CONTROLLED, pIceAgent->tieBreaker));
+
+        // The size includes the message integrity and the fingerprint which follow the padding
+        CHK_STATUS(stun_serializePacket(pProbe, (PBYTE) pIceAgent->remotePassword, passwordLen, TRUE, TRUE, NULL, &packetSize));
+        CHK(packetSize + STUN_ATTRIBUTE_HEADER_LEN < probeSize, retStatus);
+        paddingLen = ROUND_DOWN(probeSize - packetSize - STUN_ATTRIBUTE_HEADER_LEN, 4);
+        CHK_STATUS(stun_attribute_appendPadding(pProbe, (UINT16) paddingLen));
+
+        pIceCandidatePair->mtuProbeSizes[i] = (UINT16) (packetSize + STUN_ATTRIBUTE_HEADER_LEN + paddingLen);
+        MEMCPY(pIceCandidatePair->mtuProbeTransactionIds[i], pProbe->header.transactionId, STUN_TRANSACTION_ID_LEN);
+
+        // Not through ice_agent_sendStunPacket, a probe larger than the mtu of the local link fails to send and that does not fail the pair
+        if (STATUS_FAILED(ice_utils_sendStunPacket(pProbe, (PBYTE) pIceAgent->remotePassword, passwordLen, &pIceCandidatePair->remote->ipAddress,
+                                                   pIceCandidatePair->local->pSocketConnection, pIceCandidatePair->local->pTurnConnection,
+                                                   IS_CANN_PAIR_SENDING_FROM_RELAYED(pIceCandidatePair)))) {
+            DLOGD("path mtu probe of %u bytes could not be sent", pIceCandidatePair->mtuProbeSizes[i]);
+        }
+
+        CHK_STATUS(stun_freePacket(&pProbe));
+    }
+
+CleanUp:
+
+    CHK_LOG_ERR(retStatus);
+
+    if (pProbe != NULL) {
+        stun_freePacket(&pProbe);
+    }
+
+    return retStatus;
+}
+
+BOOL ice_candidate_pair_handleMtuProbeResponse(PIceCandidatePair pIceCandidatePair, PBYTE pTransactionId, BOOL success)
+{
+    UINT32 i;
+
+    for (i = 0; i < ICE_PATH_MTU_PROBE_COUNT; i++) {
+        if (pIceCandidatePair->mtuProbeSizes[i] == 0 ||
+            MEMCMP(pIceCandidatePair->mtuProbeTransactionIds[i], pTransactionId, STUN_TRANSACTION_ID_LEN) != 0) {
+            continue;
+        }
+
+        if (!success) {
+            // The remote peer does not take the PADDING attribute, it would reject every probe
+            DLOGI("path mtu probe of candidate pair %s_%s is rejected, the configured mtu is kept", pIceCandidatePair->local->id,
+                  pIceCandidatePair->remote->id);
+            pIceCandidatePair->mtuProbeRounds = ICE_PATH_MTU_PROBE_ROUNDS;
+        } else if (pIceCandidatePair->mtuProbeSizes[i] > pIceCandidatePair->pathMtu) {
+            pIceCandidatePair->pathMtu = pIceCandidatePair->mtuProbeSizes[i];
+            DLOGI("path mtu of candidate pair %s_%s is at least %u bytes", pIceCandidatePair->local->id, pIceCandidatePair->remote->id,
+                  pIceCandidatePair->pathMtu);
+        }
+
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
 STATUS ice_candidate_pair_checkConnection(PStunPacket pStunBindingRequest, PIceAgent pIceAgent, PIceCandidatePair pIceCandidatePair)
 {
     STATUS retStatus = STATUS_SUCCESS;
@@ -2167,6 +2278,7 @@ STATUS ice_agent_checkCandidatePairConnection(PIceAgent pIceAgent)
             pIceCandidatePair->rtoSlot--;
             if (pIceCandidatePair->rtoSlot < 0) {
                 CHK_STATUS(ice_candidate_pair_checkConnection(pIceAgent->pBindingRequest, pIceAgent, pIceCandidatePair));
+                CHK_STATUS(ice_candidate_pair_sendMtuProbes(pIceAgent, pIceCandidatePair));
             }
         }
     }
@@ -2480,6 +2592,8 @@ STATUS ice_agent_handleInboundStunPacket(PIceAgent pIceAgent, PBYTE pBuffer, UIN
                          "Cannot find candidate pair with local candidate %s and remote candidate %s. Dropping STUN binding success response",
                          ipAddrStr2, ipAddrStr);
             }
+            // the path mtu probes are not in the store, their responses only tell the size which got through.
+            CHK(!ice_candidate_pair_handleMtuProbeResponse(pIceCandidatePair, pBuffer + STUN_PACKET_TRANSACTION_ID_OFFSET, TRUE), retStatus);
             // check the transation id of stun packet.
             CHK_WARN(transaction_id_store_isExisted(pIceCandidatePair->pTransactionIdStore, pBuffer + STUN_PACKET_TRANSACTION_ID_OFFSET),
                      STATUS_ICE_AGENT_NO_MATCH_TRANSACTION, "Dropping response packet because transaction id does not match");
@@ -2534,6 +2648,8 @@ STATUS ice_agent_handleInboundStunPacket(PIceAgent pIceAgent, PBYTE pBuffer, UIN
 
                     CHK_STATUS(hash_table_remove(pIceCandidatePair->requestSentTime, checkSum));
                 }
+                // probe right away, the controlling agent moves on to the nomination without another round of checks.
+                CHK_STATUS(ice_candidate_pair_sendMtuProbes(pIceAgent, pIceCandidatePair));
             }
 
             pIceCandidatePair->rtcIceCandidatePairDiagnostics.responsesReceived += connectivityCheckResponsesReceived;
@@ -2545,7 +2661,12 @@ STATUS ice_agent_handleInboundStunPacket(PIceAgent pIceAgent, PBYTE pBuffer, UIN
             break;
         case STUN_PACKET_TYPE_BINDING_RESPONSE_ERROR:
             // STUN_PACKET_IS_TYPE_ERROR(pBuffer), retStatus)
-            DLOGW("binding response error");
+            CHK_STATUS(
+                ice_candidate_pair_queryByLocalSocketConnectionAndRemoteAddr(pIceAgent, pSocketConnection, pSrcAddr, TRUE, &pIceCandidatePair));
+            if (pIceCandidatePair == NULL ||
+                !ice_candidate_pair_handleMtuProbeResponse(pIceCandidatePair, pBuffer + STUN_PACKET_TRANSACTION_ID_OFFSET, FALSE)) {
+                DLOGW("binding response error");
+            }
             break;
         default:
             CHK_STATUS(hexEncode(pBuffer, bufferLen, NULL, &hexStrLen));
@@ -2726,6 +2847,76 @@ CleanUp:
     return retStatus;
 }
 
+STATUS ice_agent_getPathMtu(PIceAgent pIceAgent, PUINT16 pPathMtu)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    BOOL locked = FALSE;
+
+    CHK(pIceAgent != NULL && pPathMtu != NULL, STATUS_ICE_AGENT_NULL_ARG);
+    *pPathMtu = 0;
+
+    MUTEX_LOCK(pIceAgent->lock);
+    locked = TRUE;
+
+    if (pIceAgent->pDataSendingIceCandidatePair != NULL) {
+        *pPathMtu = pIceAgent->pDataSendingIceCandidatePair->pathMtu;
+    }
+
+CleanUp:
+
+    if (locked) {
+        MUTEX_UNLOCK(pIceAgent->lock);
+    }
+
+    return retStatus;
+}
+
+STATUS ice_agent_getRoundTripTime(PIceAgent pIceAgent, PUINT64 pRoundTripTime)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    BOOL locked = FALSE;
+
+    CHK(pIceAgent != NULL && pRoundTripTime != NULL, STATUS_ICE_AGENT_NULL_ARG);
+    *pRoundTripTime = 0;
+
+    MUTEX_LOCK(pIceAgent->lock);
+    locked = TRUE;
+
+    if (pIceAgent->pDataSendingIceCandidatePair != NULL) {
+        *pRoundTripTime = pIceAgent->pDataSendingIceCandidatePair->roundTripTime;
+    }
+
+CleanUp:
+
+    if (locked) {
+        MUTEX_UNLOCK(pIceAgent->lock);
+    }
+
+    return retStatus;
+}
+
+STATUS ice_agent_isReadyToSend(PIceAgent pIceAgent, PBOOL pReady)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    BOOL locked = FALSE;
+
+    CHK(pIceAgent != NULL && pReady != NULL, STATUS_ICE_AGENT_NULL_ARG);
+
+    MUTEX_LOCK(pIceAgent->lock);
+    locked = TRUE;
+
+    *pReady = !ATOMIC_LOAD_BOOL(&pIceAgent->shutdown) && pIceAgent->pDataSendingIceCandidatePair != NULL &&
+        pIceAgent->pDataSendingIceCandidatePair->state == ICE_CANDIDATE_PAIR_STATE_SUCCEEDED;
+
+CleanUp:
+
+    if (locked) {
+        MUTEX_UNLOCK(pIceAgent->lock);
+    }
+
+    return retStatus;
+}
+
 STATUS ice_agent_send(PIceAgent pIceAgent, PBYTE pBuffer, UINT32 bufferLen)
 {
     STATUS retStatus = STATUS_SUCCESS;
@@ -2795,6 +2986,95 @@ CleanUp:
     return retStatus;
 }
 
+STATUS ice_agent_sendBatch(PIceAgent pIceAgent, PBYTE* ppBuffers, PUINT32 pBufferLens, UINT32 count, PUINT32 pSentCount, PUINT32 pDiscardedCount)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    BOOL locked = FALSE, isRelay = FALSE;
+    PTurnConnection pTurnConnection = NULL;
+    PKvsIpAddress pDestIp = NULL;
+    UINT32 packetsDiscarded = 0;
+    UINT32 bytesDiscarded = 0;
+    UINT32 bytesSent = 0;
+    UINT32 packetsSent = 0;
+    UINT32 i;
+
+    CHK(pIceAgent != NULL && ppBuffers != NULL && pBufferLens != NULL, STATUS_ICE_AGENT_NULL_ARG);
+    CHK(count != 0, STATUS_ICE_AGENT_INVALID_ARG);
+
+    MUTEX_LOCK(pIceAgent->lock);
+    locked = TRUE;
+
+    /* Do not proceed if ice is shutting down */
+    CHK(!ATOMIC_LOAD_BOOL(&pIceAgent->shutdown), retStatus);
+
+    CHK_WARN(pIceAgent->pDataSendingIceCandidatePair != NULL, retStatus, "No valid ice candidate pair available to send data");
+    CHK_WARN(pIceAgent->pDataSendingIceCandidatePair->state == ICE_CANDIDATE_PAIR_STATE_SUCCEEDED, retStatus,
+             "Invalid state for data sending candidate pair.");
+
+    pIceAgent->pDataSendingIceCandidatePair->lastDataSentTime = GETTIME();
+    pDestIp = &pIceAgent->pDataSendingIceCandidatePair->remote->ipAddress;
+
+    isRelay = IS_CANN_PAIR_SENDING_FROM_RELAYED(pIceAgent->pDataSendingIceCandidatePair);
+    if (isRelay) {
+        CHK_ERR(pIceAgent->pDataSendingIceCandidatePair->local->pTurnConnection != NULL, STATUS_ICE_AGENT_NULL_ARG,
+                "Candidate is relay but pTurnConnection is NULL");
+        pTurnConnection = pIceAgent->pDataSendingIceCandidatePair->local->pTurnConnection;
+
+        // turn wraps every packet into its own channel data message
+        for (; packetsSent < count; packetsSent++) {
+            retStatus = ice_utils_send(ppBuffers[packetsSent], pBufferLens[packetsSent], pDestIp, NULL, pTurnConnection, TRUE);
+            if (STATUS_FAILED(retStatus)) {
+                break;
+            }
+        }
+    } else {
+        retStatus = socket_connection_sendBatch(pIceAgent->pDataSendingIceCandidatePair->local->pSocketConnection, ppBuffers, pBufferLens, count,
+                                                pDestIp, &packetsSent);
+    }
+
+    for (i = 0; i < packetsSent; i++) {
+        bytesSent += pBufferLens[i];
+    }
+
+    if (STATUS_FAILED(retStatus)) {
+        DLOGW("ice_agent_sendBatch failed with 0x%08x after %u of %u packets", retStatus, packetsSent, count);
+        packetsDiscarded = count - packetsSent;
+        for (i = packetsSent; i < count; i++) {
+            bytesDiscarded += pBufferLens[i]; // This includes header and padding. TODO: update length to remove header and padding
+        }
+        if (retStatus == STATUS_SOCKET_CONN_CLOSED_ALREADY) {
+            DLOGW("IceAgent connection closed unexpectedly");
+            pIceAgent->iceAgentStatus = STATUS_SOCKET_CONN_CLOSED_ALREADY;
+            pIceAgent->pDataSendingIceCandidatePair->state = ICE_CANDIDATE_PAIR_STATE_FAILED;
+        }
+        retStatus = STATUS_SUCCESS;
+    }
+
+CleanUp:
+
+    if (STATUS_SUCCEEDED(retStatus) && pIceAgent->pDataSendingIceCandidatePair != NULL) {
+        pIceAgent->pDataSendingIceCandidatePair->rtcIceCandidatePairDiagnostics.packetsDiscardedOnSend += packetsDiscarded;
+        pIceAgent->pDataSendingIceCandidatePair->rtcIceCandidatePairDiagnostics.bytesDiscardedOnSend += bytesDiscarded;
+        pIceAgent->pDataSendingIceCandidatePair->rtcIceCandidatePairDiagnostics.state = pIceAgent->pDataSendingIceCandidatePair->state;
+        pIceAgent->pDataSendingIceCandidatePair->rtcIceCandidatePairDiagnostics.lastPacketSentTimestamp =
+            pIceAgent->pDataSendingIceCandidatePair->lastDataSentTime;
+        pIceAgent->pDataSendingIceCandidatePair->rtcIceCandidatePairDiagnostics.bytesSent += bytesSent;
+        pIceAgent->pDataSendingIceCandidatePair->rtcIceCandidatePairDiagnostics.packetsSent += packetsSent;
+    }
+    if (locked) {
+        MUTEX_UNLOCK(pIceAgent->lock);
+    }
+
+    if (pSentCount != NULL) {
+        *pSentCount = packetsSent;
+    }
+    if (pDiscardedCount != NULL) {
+        *pDiscardedCount = packetsDiscarded;
+    }
+
+    return retStatus;
+}
+
 STATUS ice_agent_sendCandidateNomination(PIceAgent pIceAgent)
 {
     STATUS retStatus = STATUS_SUCCESS;
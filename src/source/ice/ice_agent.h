@@ -63,6 +63,18 @@ extern "C" {
 #define KVS_ICE_ENTER_STATE_DISCONNECTION_GRACE_PERIOD 4 * KVS_ICE_SEND_KEEP_ALIVE_INTERVAL
 #define KVS_ICE_ENTER_STATE_FAILED_GRACE_PERIOD        15 * HUNDREDS_OF_NANOS_IN_A_SECOND
 
+// Path mtu discovery with padded binding requests, https://datatracker.ietf.org/doc/html/rfc8899#section-4.6.1
+// Number and largest of the ip mtus which are probed, see gIcePathMtuProbeSizes
+#define ICE_PATH_MTU_PROBE_COUNT    5
+#define ICE_PATH_MTU_MAX_PROBE_SIZE 1500
+// The probes which are not answered are sent again with the next connectivity checks of the pair, up to this many times in total
+#define ICE_PATH_MTU_PROBE_ROUNDS 3
+#define ICE_IPV4_HEADER_LEN       20
+#define ICE_IPV6_HEADER_LEN       40
+#define ICE_UDP_HEADER_LEN        8
+// A send indication to an ipv4 peer, a channel data message only takes 4 bytes
+#define ICE_TURN_SEND_OVERHEAD 36
+
 #define STUN_HEADER_MAGIC_BYTE_OFFSET 4
 
 #define KVS_ICE_MAX_RELAY_CANDIDATE_COUNT                  4
@@ -214,6 +226,10 @@ typedef struct {
     UINT64 responsesReceived;
     INT64 rtoSlot;
     RtcIceCandidatePairDiagnostics rtcIceCandidatePairDiagnostics;
+    UINT16 pathMtu;        //!< the size of the largest path mtu probe the remote peer answered, 0 if none was.
+    UINT32 mtuProbeRounds; //!< the number of times the path mtu probes were sent.
+    UINT16 mtuProbeSizes[ICE_PATH_MTU_PROBE_COUNT];
+    BYTE mtuProbeTransactionIds[ICE_PATH_MTU_PROBE_COUNT][STUN_TRANSACTION_ID_LEN];
 } IceCandidatePair, *PIceCandidatePair;
 
 struct __IceAgent {
@@ -375,6 +391,52 @@ STATUS ice_candidate_serialize(PIceCandidate, PCHAR, PUINT32);
  */
 STATUS ice_agent_send(PIceAgent pIceAgent, PBYTE pBuffer, UINT32 bufferLen);
 
+/**
+ * @brief   The path mtu found for the candidate pair data is sent on, see KvsRtcConfiguration.enablePathMtuDiscovery.
+ *
+ * @param[in] pIceAgent IceAgent object
+ * @param[out] pPathMtu the largest udp payload, turn framing excluded, which got through in a probe. 0 if no probe was answered.
+ *
+ * @return STATUS status of execution
+ */
+STATUS ice_agent_getPathMtu(PIceAgent pIceAgent, PUINT16 pPathMtu);
+
+/**
+ * @brief   The round trip time the connectivity checks and keep alives measured on the candidate pair data is sent on.
+ *
+ * @param[in] pIceAgent IceAgent object
+ * @param[out] pRoundTripTime the round trip time in 100ns. 0 if no pair is selected.
+ *
+ * @return STATUS status of execution
+ */
+STATUS ice_agent_getRoundTripTime(PIceAgent pIceAgent, PUINT64 pRoundTripTime);
+
+/**
+ * @brief   Whether ice_agent_send would hand data to a candidate pair, a pair is selected and has succeeded.
+ *
+ * @param[in] pIceAgent IceAgent object
+ * @param[out] pReady TRUE if data can be sent.
+ *
+ * @return STATUS status of execution
+ */
+STATUS ice_agent_isReadyToSend(PIceAgent pIceAgent, PBOOL pReady);
+
+/**
+ * @brief   Send a batch of buffers through selected connection while holding the agent lock once.
+ *          Buffers which can not be sent are accounted as discarded, same as ice_agent_send.
+ *
+ * @param[in] pIceAgent IceAgent object
+ * @param[in] ppBuffers buffers storing the data to be sent
+ * @param[in] pBufferLens length of each buffer
+ * @param[in] count number of buffers
+ * @param[out] pSentCount number of buffers which were sent. Optional.
+ * @param[out] pDiscardedCount number of buffers the selected candidate pair failed to send. The buffers given while no candidate pair
+ *             is selected are neither sent nor discarded. Optional.
+ *
+ * @return STATUS status of execution
+ */
+STATUS ice_agent_sendBatch(PIceAgent pIceAgent, PBYTE* ppBuffers, PUINT32 pBufferLens, UINT32 count, PUINT32 pSentCount, PUINT32 pDiscardedCount);
+
 /**
  * @brief Starting from given index, fillout PSdpMediaDescription->sdpAttributes with serialize local candidate strings.
  *
@@ -476,6 +538,27 @@ STATUS ice_candidate_pair_pruneUnconnected(PIceAgent);
  * @return STATUS status of execution.
  */
 STATUS ice_candidate_pair_checkConnection(PStunPacket pStunBindingRequest, PIceAgent pIceAgent, PIceCandidatePair pIceCandidatePair);
+/**
+ * @brief sends the padded binding requests of the path mtu discovery of a candidate pair which passed its connectivity check, the sizes all
+ * at once and largest first. A probe goes with the don't fragment bit, so it is dropped by the first link it does not fit, and the largest
+ * one the remote peer answers is the path mtu. Only the sizes above it are sent again by the next rounds.
+ *
+ * @param[in] pIceAgent the ice agent, its lock is held.
+ * @param[in] pIceCandidatePair the candidate pair.
+ *
+ * @return STATUS status of execution.
+ */
+STATUS ice_candidate_pair_sendMtuProbes(PIceAgent pIceAgent, PIceCandidatePair pIceCandidatePair);
+/**
+ * @brief records the answer to a path mtu probe of a candidate pair.
+ *
+ * @param[in] pIceCandidatePair the candidate pair the response came on.
+ * @param[in] pTransactionId the transaction id of the response.
+ * @param[in] success whether the response is a success response.
+ *
+ * @return TRUE if the response answers a probe.
+ */
+BOOL ice_candidate_pair_handleMtuProbeResponse(PIceCandidatePair pIceCandidatePair, PBYTE pTransactionId, BOOL success);
 
 /**
  * @brief send the request of server reflex.
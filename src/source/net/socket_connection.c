@@ -16,13 +16,24 @@
  * HEADERS
  ******************************************************************************/
 #define LOG_CLASS "SocketConnection"
+#ifdef KVSWEBRTC_HAVE_SENDMMSG
+// sendmmsg
+#define _GNU_SOURCE
+#endif
 
 #include "socket_connection.h"
 #include "ice_agent.h"
 #include <netdb.h>
+#if defined(KVSWEBRTC_HAVE_SENDMMSG) && defined(KVSWEBRTC_HAVE_UDP_SEGMENT)
+#include <netinet/udp.h>
+#endif
 
 /// internal function prototype
 STATUS socket_connection_sendWithRetry(PSocketConnection pSocketConnection, PBYTE buf, UINT32 bufLen, PKvsIpAddress pDestIp, PUINT32 pBytesWritten);
+#ifdef KVSWEBRTC_HAVE_SENDMMSG
+static STATUS socket_connection_sendmmsgWithRetry(PSocketConnection pSocketConnection, PBYTE* ppBufs, PUINT32 pBufLens, UINT32 count,
+                                                  PKvsIpAddress pDestIp, PUINT32 pSentCount);
+#endif
 
 STATUS socket_connection_create(KVS_IP_FAMILY_TYPE familyType, KVS_SOCKET_PROTOCOL protocol, PKvsIpAddress pBindAddr, PKvsIpAddress pPeerIpAddr,
                                 UINT64 customData, ConnectionDataAvailableFunc dataAvailableFn, UINT32 sendBufSize,
@@ -45,6 +56,9 @@ STATUS socket_connection_create(KVS_IP_FAMILY_TYPE familyType, KVS_SOCKET_PROTOC
     if (pBindAddr) {
         CHK_STATUS(net_bindSocket(pBindAddr, pSocketConnection->localSocket));
         pSocketConnection->hostIpAddr = *pBindAddr;
+    } else {
+        // The socket options which depend on the family still need it, e.g. socket_connection_setDontFragment
+        pSocketConnection->hostIpAddr.family = (UINT16) familyType;
     }
 
     pSocketConnection->bTlsSession = FALSE;
@@ -234,6 +248,118 @@ CleanUp:
     return retStatus;
 }
 
+STATUS socket_connection_sendBatch(PSocketConnection pSocketConnection, PBYTE* ppBufs, PUINT32 pBufLens, UINT32 count, PKvsIpAddress pDestIp,
+                                   PUINT32 pSentCount)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    BOOL locked = FALSE;
+    UINT32 sentCount = 0;
+
+    CHK(pSocketConnection != NULL && ppBufs != NULL && pBufLens != NULL, STATUS_SOCKET_CONN_NULL_ARG);
+    CHK((pSocketConnection->protocol == KVS_SOCKET_PROTOCOL_TCP || pDestIp != NULL), STATUS_SOCKET_CONN_INVALID_ARG);
+
+    // Using a single CHK_WARN might output too much spew in bad network conditions
+    if (ATOMIC_LOAD_BOOL(&pSocketConnection->connectionClosed)) {
+        DLOGE("Warning: Failed to send data. Socket closed already");
+        CHK(FALSE, STATUS_SOCKET_CONN_CLOSED_ALREADY);
+    }
+
+    MUTEX_LOCK(pSocketConnection->lock);
+    locked = TRUE;
+
+#ifdef KVSWEBRTC_HAVE_SENDMMSG
+    if (pSocketConnection->protocol == KVS_SOCKET_PROTOCOL_UDP) {
+        retStatus = socket_connection_sendmmsgWithRetry(pSocketConnection, ppBufs, pBufLens, count, pDestIp, &sentCount);
+        // The libc may provide sendmmsg without kernel support, the remaining datagrams go through sendto then.
+        CHK(retStatus == STATUS_NOT_IMPLEMENTED, retStatus);
+        retStatus = STATUS_SUCCESS;
+    }
+#endif
+
+    for (; sentCount < count; sentCount++) {
+        /* Should have a valid buffer */
+        CHK(ppBufs[sentCount] != NULL && pBufLens[sentCount] > 0, STATUS_SOCKET_CONN_INVALID_ARG);
+        if (pSocketConnection->protocol == KVS_SOCKET_PROTOCOL_TCP && pSocketConnection->bTlsSession) {
+            CHK_STATUS(tls_session_send(pSocketConnection->pTlsSession, ppBufs[sentCount], pBufLens[sentCount]));
+        } else if (pSocketConnection->protocol == KVS_SOCKET_PROTOCOL_TCP) {
+            CHK_STATUS(socket_connection_sendWithRetry(pSocketConnection, ppBufs[sentCount], pBufLens[sentCount], NULL, NULL));
+        } else if (pSocketConnection->protocol == KVS_SOCKET_PROTOCOL_UDP) {
+            CHK_STATUS(socket_connection_sendWithRetry(pSocketConnection, ppBufs[sentCount], pBufLens[sentCount], pDestIp, NULL));
+        } else {
+            CHECK_EXT(FALSE, "socket_connection_sendBatch should not reach here. Nothing is sent.");
+        }
+    }
+
+CleanUp:
+
+    if (locked) {
+        MUTEX_UNLOCK(pSocketConnection->lock);
+    }
+
+    if (pSentCount != NULL) {
+        *pSentCount = sentCount;
+    }
+
+    return retStatus;
+}
+
+STATUS socket_connection_enableUdpSegmentOffload(PSocketConnection pSocketConnection)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+#if defined(KVSWEBRTC_HAVE_SENDMMSG) && defined(KVSWEBRTC_HAVE_UDP_SEGMENT)
+    INT32 segmentSize = 0;
+    socklen_t optLen = SIZEOF(segmentSize);
+#endif
+
+    CHK(pSocketConnection != NULL, STATUS_SOCKET_CONN_NULL_ARG);
+    CHK(pSocketConnection->protocol == KVS_SOCKET_PROTOCOL_UDP, STATUS_SOCKET_CONN_INVALID_ARG);
+
+#if defined(KVSWEBRTC_HAVE_SENDMMSG) && defined(KVSWEBRTC_HAVE_UDP_SEGMENT)
+    // The headers may know UDP_SEGMENT while the running kernel (< 4.18) does not.
+    if (getsockopt(pSocketConnection->localSocket, IPPROTO_UDP, UDP_SEGMENT, &segmentSize, &optLen) < 0) {
+        DLOGI("udp segmentation offload is not supported, errno %s", net_getErrorString(net_getErrorCode()));
+        CHK(FALSE, STATUS_NOT_IMPLEMENTED);
+    }
+    ATOMIC_STORE_BOOL(&pSocketConnection->udpSegmentOffload, TRUE);
+#else
+    CHK(FALSE, STATUS_NOT_IMPLEMENTED);
+#endif
+
+CleanUp:
+
+    return retStatus;
+}
+
+STATUS socket_connection_setDontFragment(PSocketConnection pSocketConnection)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    INT32 level = 0, optionName = 0, optionValue = 0;
+
+    CHK(pSocketConnection != NULL, STATUS_SOCKET_CONN_NULL_ARG);
+    CHK(pSocketConnection->protocol == KVS_SOCKET_PROTOCOL_UDP, STATUS_SOCKET_CONN_INVALID_ARG);
+
+#if defined(IP_MTU_DISCOVER) && defined(IP_PMTUDISC_PROBE) && defined(IPV6_MTU_DISCOVER) && defined(IPV6_PMTUDISC_PROBE)
+    level = IS_IPV4_ADDR(&pSocketConnection->hostIpAddr) ? IPPROTO_IP : IPPROTO_IPV6;
+    optionName = IS_IPV4_ADDR(&pSocketConnection->hostIpAddr) ? IP_MTU_DISCOVER : IPV6_MTU_DISCOVER;
+    optionValue = IS_IPV4_ADDR(&pSocketConnection->hostIpAddr) ? IP_PMTUDISC_PROBE : IPV6_PMTUDISC_PROBE;
+#elif defined(IP_DONTFRAG) && defined(IPV6_DONTFRAG)
+    level = IS_IPV4_ADDR(&pSocketConnection->hostIpAddr) ? IPPROTO_IP : IPPROTO_IPV6;
+    optionName = IS_IPV4_ADDR(&pSocketConnection->hostIpAddr) ? IP_DONTFRAG : IPV6_DONTFRAG;
+    optionValue = 1;
+#else
+    CHK(FALSE, STATUS_NOT_IMPLEMENTED);
+#endif
+
+    if (setsockopt(pSocketConnection->localSocket, level, optionName, &optionValue, SIZEOF(optionValue)) < 0) {
+        DLOGW("setsockopt() don't fragment failed with errno %s", net_getErrorString(net_getErrorCode()));
+        CHK(FALSE, STATUS_NET_SOCKET_SET_DONT_FRAGMENT_FAILED);
+    }
+
+CleanUp:
+
+    return retStatus;
+}
+
 STATUS socket_connection_read(PSocketConnection pSocketConnection, PBYTE pBuf, UINT32 bufferLen, PUINT32 pDataLen)
 {
     STATUS retStatus = STATUS_SUCCESS;
@@ -359,30 +485,29 @@ STATUS socket_connection_sendWithRetry(PSocketConnection pSocketConnection, PBYT
     struct timeval tv;
     socklen_t addrLen = 0;
     struct sockaddr* destAddr = NULL;
-    struct sockaddr_in* pIpv4Addr = NULL;
-    struct sockaddr_in6* pIpv6Addr = NULL;
+    // kept on the stack, this runs for every outgoing packet
+    struct sockaddr_in ipv4Addr;
+    struct sockaddr_in6 ipv6Addr;
 
     CHK(pSocketConnection != NULL, STATUS_SOCKET_CONN_NULL_ARG);
     CHK(buf != NULL && bufLen > 0, STATUS_SOCKET_CONN_INVALID_ARG);
 
     if (pDestIp != NULL) {
         if (IS_IPV4_ADDR(pDestIp)) {
-            CHK(NULL != (pIpv4Addr = (struct sockaddr_in*) MEMALLOC(SIZEOF(struct sockaddr_in))), STATUS_SOCKET_CONN_NOT_ENOUGH_MEMORY);
             addrLen = SIZEOF(struct sockaddr_in);
-            MEMSET(pIpv4Addr, 0x00, SIZEOF(struct sockaddr_in));
-            pIpv4Addr->sin_family = AF_INET;
-            pIpv4Addr->sin_port = pDestIp->port;
-            MEMCPY(&pIpv4Addr->sin_addr, pDestIp->address, IPV4_ADDRESS_LENGTH);
-            destAddr = (struct sockaddr*) pIpv4Addr;
+            MEMSET(&ipv4Addr, 0x00, SIZEOF(struct sockaddr_in));
+            ipv4Addr.sin_family = AF_INET;
+            ipv4Addr.sin_port = pDestIp->port;
+            MEMCPY(&ipv4Addr.sin_addr, pDestIp->address, IPV4_ADDRESS_LENGTH);
+            destAddr = (struct sockaddr*) &ipv4Addr;
 
         } else {
-            CHK(NULL != (pIpv6Addr = (struct sockaddr_in6*) MEMALLOC(SIZEOF(struct sockaddr_in6))), STATUS_SOCKET_CONN_NOT_ENOUGH_MEMORY);
             addrLen = SIZEOF(struct sockaddr_in6);
-            MEMSET(pIpv6Addr, 0x00, SIZEOF(struct sockaddr_in6));
-            pIpv6Addr->sin6_family = AF_INET6;
-            pIpv6Addr->sin6_port = pDestIp->port;
-            MEMCPY(&pIpv6Addr->sin6_addr, pDestIp->address, IPV6_ADDRESS_LENGTH);
-            destAddr = (struct sockaddr*) pIpv6Addr;
+            MEMSET(&ipv6Addr, 0x00, SIZEOF(struct sockaddr_in6));
+            ipv6Addr.sin6_family = AF_INET6;
+            ipv6Addr.sin6_port = pDestIp->port;
+            MEMCPY(&ipv6Addr.sin6_addr, pDestIp->address, IPV6_ADDRESS_LENGTH);
+            destAddr = (struct sockaddr*) &ipv6Addr;
         }
     }
     // start sending the data.
@@ -437,8 +562,6 @@ STATUS socket_connection_sendWithRetry(PSocketConnection pSocketConnection, PBYT
     }
 
 CleanUp:
-    SAFE_MEMFREE(pIpv4Addr);
-    SAFE_MEMFREE(pIpv6Addr);
     // CHK_LOG_ERR might be too verbose in this case
     if (STATUS_FAILED(retStatus)) {
         DLOGD("Warning: Send data failed with 0x%08x", retStatus);
@@ -447,3 +570,170 @@ CleanUp:
 
     return retStatus;
 }
+
+#ifdef KVSWEBRTC_HAVE_SENDMMSG
+/**
+ * @brief send a batch of udp datagrams with as few sendmmsg calls as possible.
+ *
+ * @param[in] pSocketConnection the context of the socket.
+ * @param[in] ppBufs the datagrams.
+ * @param[in] pBufLens the length of each datagram.
+ * @param[in] count the number of datagrams.
+ * @param[in] pDestIp the ip address of destion.
+ * @param[out] pSentCount the number of datagrams sent.
+ *
+ * @return STATUS status of execution. STATUS_NOT_IMPLEMENTED if the kernel does not support sendmmsg.
+ */
+static STATUS socket_connection_sendmmsgWithRetry(PSocketConnection pSocketConnection, PBYTE* ppBufs, PUINT32 pBufLens, UINT32 count,
+                                                  PKvsIpAddress pDestIp, PUINT32 pSentCount)
+{
+    STATUS retStatus = STATUS_SUCCESS;
+    INT32 socketWriteAttempt = 0;
+    INT32 socketResult = 0;
+    UINT32 sentCount = 0, bufCount, msgCount, segCount, msgBytes, first, i;
+    INT32 errorNum = 0;
+    BOOL useUdpSegment = FALSE;
+
+    fd_set wfds;
+    struct timeval tv;
+    socklen_t addrLen = 0;
+    struct sockaddr* destAddr = NULL;
+    struct sockaddr_in ipv4Addr;
+    struct sockaddr_in6 ipv6Addr;
+    struct mmsghdr msgs[SOCKET_SEND_BATCH_SIZE];
+    struct iovec iovs[SOCKET_SEND_BATCH_SIZE];
+    UINT32 msgSegCounts[SOCKET_SEND_BATCH_SIZE];
+#ifdef KVSWEBRTC_HAVE_UDP_SEGMENT
+    struct cmsghdr* pCmsg = NULL;
+    union {
+        CHAR buf[CMSG_SPACE(SIZEOF(UINT16))];
+        struct cmsghdr align;
+    } cmsgBufs[SOCKET_SEND_BATCH_SIZE];
+
+    useUdpSegment = ATOMIC_LOAD_BOOL(&pSocketConnection->udpSegmentOffload);
+#endif
+
+    if (IS_IPV4_ADDR(pDestIp)) {
+        addrLen = SIZEOF(struct sockaddr_in);
+        MEMSET(&ipv4Addr, 0x00, SIZEOF(struct sockaddr_in));
+        ipv4Addr.sin_family = AF_INET;
+        ipv4Addr.sin_port = pDestIp->port;
+        MEMCPY(&ipv4Addr.sin_addr, pDestIp->address, IPV4_ADDRESS_LENGTH);
+        destAddr = (struct sockaddr*) &ipv4Addr;
+    } else {
+        addrLen = SIZEOF(struct sockaddr_in6);
+        MEMSET(&ipv6Addr, 0x00, SIZEOF(struct sockaddr_in6));
+        ipv6Addr.sin6_family = AF_INET6;
+        ipv6Addr.sin6_port = pDestIp->port;
+        MEMCPY(&ipv6Addr.sin6_addr, pDestIp->address, IPV6_ADDRESS_LENGTH);
+        destAddr = (struct sockaddr*) &ipv6Addr;
+    }
+
+    while (socketWriteAttempt < MAX_SOCKET_WRITE_RETRY && sentCount < count) {
+        // Every message carries one datagram, or a run of equal sized datagrams which the kernel segments when udp gso is on.
+        for (bufCount = 0, msgCount = 0; bufCount < SOCKET_SEND_BATCH_SIZE && sentCount + bufCount < count; msgCount++) {
+            first = sentCount + bufCount;
+            msgBytes = 0;
+            for (segCount = 0; bufCount + segCount < SOCKET_SEND_BATCH_SIZE && first + segCount < count; segCount++) {
+                i = first + segCount;
+                CHK(ppBufs[i] != NULL && pBufLens[i] > 0, STATUS_SOCKET_CONN_INVALID_ARG);
+                // Only the last segment of a run may be shorter than the first one
+                if (segCount > 0 &&
+                    (!useUdpSegment || pBufLens[i] > pBufLens[first] || pBufLens[i - 1] < pBufLens[first] ||
+                     msgBytes + pBufLens[i] > SOCKET_UDP_SEGMENT_MAX_BYTES)) {
+                    break;
+                }
+                iovs[bufCount + segCount].iov_base = ppBufs[i];
+                iovs[bufCount + segCount].iov_len = pBufLens[i];
+                msgBytes += pBufLens[i];
+            }
+
+            MEMSET(&msgs[msgCount], 0x00, SIZEOF(struct mmsghdr));
+            msgs[msgCount].msg_hdr.msg_name = destAddr;
+            msgs[msgCount].msg_hdr.msg_namelen = addrLen;
+            msgs[msgCount].msg_hdr.msg_iov = &iovs[bufCount];
+            msgs[msgCount].msg_hdr.msg_iovlen = segCount;
+#ifdef KVSWEBRTC_HAVE_UDP_SEGMENT
+            if (segCount > 1) {
+                msgs[msgCount].msg_hdr.msg_control = cmsgBufs[msgCount].buf;
+                msgs[msgCount].msg_hdr.msg_controllen = SIZEOF(cmsgBufs[msgCount].buf);
+                pCmsg = CMSG_FIRSTHDR(&msgs[msgCount].msg_hdr);
+                pCmsg->cmsg_level = IPPROTO_UDP;
+                pCmsg->cmsg_type = UDP_SEGMENT;
+                pCmsg->cmsg_len = CMSG_LEN(SIZEOF(UINT16));
+                *((PUINT16) CMSG_DATA(pCmsg)) = (UINT16) pBufLens[first];
+            }
+#endif
+            msgSegCounts[msgCount] = segCount;
+            bufCount += segCount;
+        }
+
+        socketResult = sendmmsg(pSocketConnection->localSocket, msgs, msgCount, NO_SIGNAL);
+        if (socketResult < 0) {
+            errorNum = net_getErrorCode();
+            if (errorNum == ENOSYS) {
+                CHK(FALSE, STATUS_NOT_IMPLEMENTED);
+            } else if (useUdpSegment && msgSegCounts[0] > 1 && (errorNum == EIO || errorNum == EINVAL || errorNum == EOPNOTSUPP)) {
+                // The egress device can not take the gso buffer (e.g. no tx checksum offload), stop using it on this socket.
+                DLOGW("udp gso send failed with errno %s, disabling udp segmentation offload", net_getErrorString(errorNum));
+                ATOMIC_STORE_BOOL(&pSocketConnection->udpSegmentOffload, FALSE);
+                useUdpSegment = FALSE;
+                socketResult = 0;
+                continue;
+            } else if (errorNum == EAGAIN || errorNum == EWOULDBLOCK) {
+                FD_ZERO(&wfds);
+                FD_SET(pSocketConnection->localSocket, &wfds);
+                tv.tv_sec = 0;
+                tv.tv_usec = SOCKET_SEND_RETRY_TIMEOUT_MICRO_SECOND;
+                socketResult = select(pSocketConnection->localSocket + 1, NULL, &wfds, NULL, &tv);
+
+                if (socketResult == 0) {
+                    /* loop back and try again */
+                    DLOGE("select() timed out");
+                } else if (socketResult < 0) {
+                    DLOGE("select() failed with errno %s", net_getErrorString(net_getErrorCode()));
+                    break;
+                }
+            } else if (errorNum == EINTR) {
+                /* nothing need to be done, just retry */
+            } else {
+                /* fatal error from send() */
+                DLOGE("sendmmsg() failed with errno %s", net_getErrorString(errorNum));
+                break;
+            }
+
+            // Indicate an attempt only on error
+            socketWriteAttempt++;
+        } else {
+            // A message is either sent as a whole or not at all
+            for (i = 0; i < (UINT32) socketResult; i++) {
+                sentCount += msgSegCounts[i];
+            }
+        }
+        if (socketWriteAttempt > 1) {
+            DLOGD("sendmmsg retry: %d/%d", socketWriteAttempt, MAX_SOCKET_WRITE_RETRY);
+        }
+    }
+
+    if (socketResult < 0) {
+        DLOGE("fail to send data and close the socket.");
+        CLOSE_SOCKET_IF_CANT_RETRY(errorNum, pSocketConnection);
+    }
+
+    if (sentCount < count) {
+        DLOGE("Failed to send data. Datagrams sent %u. Datagram count %u. Retry count %u", sentCount, count, socketWriteAttempt);
+        retStatus = STATUS_NET_SEND_DATA_FAILED;
+    }
+
+CleanUp:
+    if (pSentCount != NULL) {
+        *pSentCount = sentCount;
+    }
+    // CHK_LOG_ERR might be too verbose in this case
+    if (STATUS_FAILED(retStatus) && retStatus != STATUS_NOT_IMPLEMENTED) {
+        DLOGD("Warning: Send data failed with 0x%08x", retStatus);
+    }
+
+    return retStatus;
+}
+#endif
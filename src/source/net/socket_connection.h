@@ -31,6 +31,10 @@ extern "C" {
  ******************************************************************************/
 #define SOCKET_SEND_RETRY_TIMEOUT_MICRO_SECOND 500000
 #define MAX_SOCKET_WRITE_RETRY                 3
+// Number of datagrams handed to a single sendmmsg call
+#define SOCKET_SEND_BATCH_SIZE 32
+// Upper bound of a udp gso buffer, the kernel rejects anything above the max udp payload
+#define SOCKET_UDP_SEGMENT_MAX_BYTES 65000
 
 #define CLOSE_SOCKET_IF_CANT_RETRY(e, ps)                                                                                                            \
     if ((e) != EAGAIN && (e) != EWOULDBLOCK && (e) != EINTR && (e) != EINPROGRESS && (e) != EPERM && (e) != EALREADY && (e) != ENETUNREACH) {        \
@@ -50,6 +54,9 @@ struct __SocketConnection {
     /* Socket is in use and can't be freed */
     volatile ATOMIC_BOOL inUse;
 
+    /* Runs of equal sized udp datagrams are segmented by the kernel. See socket_connection_enableUdpSegmentOffload */
+    volatile ATOMIC_BOOL udpSegmentOffload;
+
     INT32 localSocket;
     KVS_SOCKET_PROTOCOL protocol;
     KvsIpAddress peerIpAddr;
@@ -122,6 +129,43 @@ STATUS socket_connection_initSecureConnection(PSocketConnection pSocketConnectio
  */
 STATUS socket_connection_send(PSocketConnection pSocketConnection, PBYTE pBuf, UINT32 bufLen, PKvsIpAddress pDestIp);
 
+/**
+ * @brief Same as socket_connection_send but for a batch of buffers which are sent in order while holding the connection lock once.
+ * UDP datagrams go out through sendmmsg when it is available, and through one sendto per datagram otherwise.
+ * Sending stops at the first buffer which can not be sent.
+ *
+ * @param[in] pSocketConnection the SocketConnection struct
+ * @param[in] ppBufs buffers containing unencrypted data
+ * @param[in] pBufLens length of each buffer
+ * @param[in] count number of buffers
+ * @param[in] pDestIp destination address. Required only if socket type is UDP.
+ * @param[out] pSentCount number of buffers sent. Optional.
+ *
+ * @return STATUS status of execution.
+ */
+STATUS socket_connection_sendBatch(PSocketConnection pSocketConnection, PBYTE* ppBufs, PUINT32 pBufLens, UINT32 count, PKvsIpAddress pDestIp,
+                                   PUINT32 pSentCount);
+
+/**
+ * @brief Let socket_connection_sendBatch hand runs of equal sized udp datagrams to the kernel as a single UDP_SEGMENT (gso) buffer.
+ * The kernel support is probed first. If the egress device later rejects gso buffers the socket falls back to one datagram per message.
+ *
+ * @param[in] pSocketConnection the SocketConnection struct of an udp socket
+ *
+ * @return STATUS status of execution. STATUS_NOT_IMPLEMENTED if the platform or the kernel does not support it.
+ */
+STATUS socket_connection_enableUdpSegmentOffload(PSocketConnection pSocketConnection);
+
+/**
+ * @brief Sets the don't fragment bit on the datagrams of an udp socket, so that a datagram larger than the path mtu is dropped instead of
+ * fragmented. The cached path mtu of the kernel is ignored where possible, the path mtu discovery of the ice agent does the probing.
+ *
+ * @param[in] pSocketConnection the SocketConnection struct of an udp socket
+ *
+ * @return STATUS status of execution. STATUS_NOT_IMPLEMENTED if the platform does not support it.
+ */
+STATUS socket_connection_setDontFragment(PSocketConnection pSocketConnection);
+
 /**
  * @brief This api only supports tls session. If PSocketConnection is not secure then nothing happens, otherwise assuming the bytes passed in are
  * encrypted, and the encryted data will be replaced with unencrypted data at function return.
@@ -357,6 +357,7 @@ STATUS stun_serializePacket(PStunPacket pStunPacket, PBYTE password, UINT32 pass
                 break;
 
             case STUN_ATTRIBUTE_TYPE_DATA:
+            case STUN_ATTRIBUTE_TYPE_PADDING:
 
                 pStunAttributeData = (PStunAttributeData) pStunAttributeHeader;
 
@@ -701,6 +702,7 @@ STATUS stun_deserializePacket(PBYTE pStunBuffer, UINT32 bufferSize, PBYTE passwo
                 break;
 
             case STUN_ATTRIBUTE_TYPE_DATA:
+            case STUN_ATTRIBUTE_TYPE_PADDING:
                 attributeSize = SIZEOF(StunAttributeData);
 
                 CHK(!fingerprintFound && !messaageIntegrityFound, STATUS_STUN_ATTRIBUTES_AFTER_FINGERPRINT_MESSAGE_INTEGRITY);
@@ -957,6 +959,7 @@ STATUS stun_deserializePacket(PBYTE pStunBuffer, UINT32 bufferSize, PBYTE passwo
                 break;
 
             case STUN_ATTRIBUTE_TYPE_DATA:
+            case STUN_ATTRIBUTE_TYPE_PADDING:
                 pStunAttributeData = (PStunAttributeData) pDestAttribute;
 
                 // Set the padded length
@@ -1653,6 +1656,41 @@ CleanUp:
     return retStatus;
 }
 
+STATUS stun_attribute_appendPadding(PStunPacket pStunPacket, UINT16 paddingLen)
+{
+    ENTERS();
+    STATUS retStatus = STATUS_SUCCESS;
+    PStunAttributeData pAttribute = NULL;
+    PStunAttributeHeader pAttributeHeader = NULL;
+    UINT16 paddedLength;
+
+    CHK_STATUS(stun_attribute_getFirstAvailability(pStunPacket, &pAttributeHeader));
+    pAttribute = (PStunAttributeData) pAttributeHeader;
+
+    paddedLength = (UINT16) ROUND_UP(paddingLen, 4);
+
+    // Validate the overall size
+    CHK((PBYTE) pStunPacket + pStunPacket->allocationSize >= (PBYTE) pAttribute + ROUND_UP(paddedLength + SIZEOF(StunAttributeData), 8),
+        STATUS_STUN_NOT_ENOUGH_MEMORY);
+
+    // Set up the new entry, the value of the padding does not matter
+    pStunPacket->attributeList[pStunPacket->attributesCount++] = (PStunAttributeHeader) pAttribute;
+
+    pAttribute->attribute.length = paddedLength;
+    pAttribute->attribute.type = STUN_ATTRIBUTE_TYPE_PADDING;
+    pAttribute->paddedLength = paddedLength;
+    pAttribute->data = (PBYTE)(pAttribute + 1);
+    MEMSET(pAttribute->data, 0x00, paddedLength);
+
+    // Fix-up the STUN header message length
+    pStunPacket->header.messageLength += paddedLength + STUN_ATTRIBUTE_HEADER_LEN;
+
+CleanUp:
+
+    LEAVES();
+    return retStatus;
+}
+
 STATUS stun_attribute_appendChannelNumber(PStunPacket pStunPacket, UINT16 channelNumber)
 {
     ENTERS();
@@ -1727,6 +1765,7 @@ UINT16 stun_attribute_getPackedSize(PStunAttributeHeader pStunAttributeHeader)
             length = SIZEOF(StunAttributeNonce) + ((PStunAttributeNonce) pStunAttributeHeader)->paddedLength;
             break;
         case STUN_ATTRIBUTE_TYPE_DATA:
+        case STUN_ATTRIBUTE_TYPE_PADDING:
             length = SIZEOF(StunAttributeData) + ((PStunAttributeData) pStunAttributeHeader)->paddedLength;
             break;
         case STUN_ATTRIBUTE_TYPE_USERNAME:
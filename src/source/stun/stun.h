@@ -248,6 +248,7 @@ typedef enum {
     STUN_ATTRIBUTE_TYPE_PRIORITY = (UINT16) 0x0024,      //!< https://datatracker.ietf.org/doc/html/rfc8445#section-7.1.1
                                                          //!< https://datatracker.ietf.org/doc/html/rfc8445#section-5.1.2
     STUN_ATTRIBUTE_TYPE_USE_CANDIDATE = (UINT16) 0x0025, //!< https://datatracker.ietf.org/doc/html/rfc8445#section-7.1.2
+    STUN_ATTRIBUTE_TYPE_PADDING = (UINT16) 0x0026,       //!< https://datatracker.ietf.org/doc/html/rfc5780#section-7.6
 
     STUN_ATTRIBUTE_TYPE_SOFTWARE = (UINT16) 0x8022,
     STUN_ATTRIBUTE_TYPE_ALTERNATE_SERVER = (UINT16) 0x8023,
@@ -468,6 +469,15 @@ STATUS stun_attribute_updateNonce(PStunPacket, PBYTE, UINT16);
 STATUS stun_attribute_appendErrorCode(PStunPacket, PCHAR, UINT16);
 STATUS stun_attribute_appendIceControlMode(PStunPacket, STUN_ATTRIBUTE_TYPE, UINT64);
 STATUS stun_attribute_appendData(PStunPacket, PBYTE, UINT16);
+/**
+ * @brief appends a PADDING attribute of paddingLen zero bytes, which grows the packet to the size a path mtu probe needs.
+ *
+ * @param[in] pStunPacket the stun packet.
+ * @param[in] paddingLen the length of the padding, rounded up to a multiple of 4.
+ *
+ * @return STATUS status of execution.
+ */
+STATUS stun_attribute_appendPadding(PStunPacket, UINT16);
 STATUS stun_attribute_appendChannelNumber(PStunPacket, UINT16);
 STATUS stun_attribute_appendChangeRequest(PStunPacket, UINT32);
 
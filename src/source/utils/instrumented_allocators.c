@@ -19,6 +19,7 @@
 #include "allocators.h"
 
 volatile SIZE_T gInstrumentedAllocatorsTotalAllocationSize = 0;
+volatile SIZE_T gInstrumentedAllocatorsTotalAllocationCount = 0;
 
 memAlloc gInstrumentedAllocatorsStoredMemAlloc = NULL;
 memAlignAlloc gInstrumentedAllocatorsStoredMemAlignAlloc = NULL;
@@ -95,6 +96,7 @@ CleanUp:
 
     // Reset the total size prior returning
     ATOMIC_STORE(&gInstrumentedAllocatorsTotalAllocationSize, 0);
+    ATOMIC_STORE(&gInstrumentedAllocatorsTotalAllocationCount, 0);
 
     return retStatus;
 }
@@ -111,6 +113,12 @@ SIZE_T getInstrumentedTotalAllocationSize()
     return totalRemainingSize;
 }
 
+SIZE_T getInstrumentedTotalAllocationCount()
+{
+    SIZE_T totalAllocationCount = ATOMIC_LOAD(&gInstrumentedAllocatorsTotalAllocationCount);
+    return totalAllocationCount;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Internal functionality
 ////////////////////////////////////////////////////////////////////////////////
@@ -129,6 +137,7 @@ PVOID instrumentedAllocatorsMemAlloc(SIZE_T size)
 
     // Add to the total book keeping
     ATOMIC_ADD(&gInstrumentedAllocatorsTotalAllocationSize, size);
+    ATOMIC_INCREMENT(&gInstrumentedAllocatorsTotalAllocationCount);
 
     return pAlloc + 1;
 }
@@ -155,6 +164,7 @@ PVOID instrumentedAllocatorsMemCalloc(SIZE_T num, SIZE_T size)
     *pAlloc = overallSize;
 
     ATOMIC_ADD(&gInstrumentedAllocatorsTotalAllocationSize, overallSize);
+    ATOMIC_INCREMENT(&gInstrumentedAllocatorsTotalAllocationCount);
 
     return pAlloc + 1;
 }
@@ -180,6 +190,7 @@ PVOID instrumentedAllocatorsMemRealloc(PVOID ptr, SIZE_T size)
         return NULL;
     }
 
+    ATOMIC_INCREMENT(&gInstrumentedAllocatorsTotalAllocationCount);
     if (existingSize > size) {
         ATOMIC_SUBTRACT(&gInstrumentedAllocatorsTotalAllocationSize, existingSize - size);
     } else {
@@ -80,6 +80,13 @@ STATUS resetInstrumentedAllocatorsNoop();
  */
 SIZE_T getInstrumentedTotalAllocationSize();
 
+/**
+ * Returns the number of allocation calls served since the allocators were set.
+ *
+ * @return - Total allocation count
+ */
+SIZE_T getInstrumentedTotalAllocationCount();
+
 #ifdef INSTRUMENTED_ALLOCATORS
 #define SET_INSTRUMENTED_ALLOCATORS()   setInstrumentedAllocators()
 #define RESET_INSTRUMENTED_ALLOCATORS() resetInstrumentedAllocators()
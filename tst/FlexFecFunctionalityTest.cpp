@@ -0,0 +1,214 @@
+#include "WebRTCClientTestFixture.h"
+
+namespace com {
+namespace amazonaws {
+namespace kinesis {
+namespace video {
+namespace webrtcclient {
+
+#define TEST_FLEXFEC_SSRC           0x12345678
+#define TEST_FLEXFEC_PROTECTED_SSRC 0x87654321
+#define TEST_FLEXFEC_PAYLOAD_TYPE   49
+#define TEST_FLEXFEC_MAX_PACKETS    64
+#define TEST_FLEXFEC_MAX_PACKET_LEN 256
+
+class FlexFecFunctionalityTest : public WebRtcClientTestBase {
+  protected:
+    BYTE packets[TEST_FLEXFEC_MAX_PACKETS][TEST_FLEXFEC_MAX_PACKET_LEN];
+    UINT32 packetLens[TEST_FLEXFEC_MAX_PACKETS];
+
+    // Media packets of one frame with distinct lengths and payloads, the last one carries the marker bit
+    VOID buildFrame(UINT32 packetCount, UINT16 firstSequenceNumber, UINT32 timestamp)
+    {
+        UINT32 i, j;
+
+        for (i = 0; i < packetCount; i++) {
+            packetLens[i] = MIN_HEADER_LENGTH + 20 + (i * 7) % 100;
+            packets[i][0] = 0x80;
+            packets[i][1] = (i == packetCount - 1 ? 0x80 : 0x00) | 102;
+            putUnalignedInt16BigEndian(packets[i] + SEQ_NUMBER_OFFSET, (UINT16) (firstSequenceNumber + i));
+            putUnalignedInt32BigEndian(packets[i] + TIMESTAMP_OFFSET, timestamp);
+            putUnalignedInt32BigEndian(packets[i] + SSRC_OFFSET, TEST_FLEXFEC_PROTECTED_SSRC);
+            for (j = MIN_HEADER_LENGTH; j < packetLens[i]; j++) {
+                packets[i][j] = (BYTE) (i * 31 + j);
+            }
+        }
+    }
+
+    UINT32 encodeFrame(PFlexFecEncoder pFlexFecEncoder, UINT32 packetCount)
+    {
+        UINT32 i, repairCount = 0;
+
+        EXPECT_EQ(STATUS_SUCCESS, flexfec_encoder_beginFrame(pFlexFecEncoder, packetCount));
+        for (i = 0; i < packetCount; i++) {
+            EXPECT_EQ(STATUS_SUCCESS, flexfec_encoder_addPacket(pFlexFecEncoder, packets[i], packetLens[i]));
+        }
+        EXPECT_EQ(STATUS_SUCCESS, flexfec_encoder_endFrame(pFlexFecEncoder, TEST_FLEXFEC_PAYLOAD_TYPE, 3000, &repairCount));
+        return repairCount;
+    }
+};
+
+TEST_F(FlexFecFunctionalityTest, noRepairPacketsWithoutReportedLoss)
+{
+    PFlexFecEncoder pFlexFecEncoder = NULL;
+
+    EXPECT_EQ(STATUS_SUCCESS, flexfec_encoder_create(TEST_FLEXFEC_SSRC, TEST_FLEXFEC_PROTECTED_SSRC, 50, &pFlexFecEncoder));
+    buildFrame(10, 1000, 3000);
+    EXPECT_EQ(0, encodeFrame(pFlexFecEncoder, 10));
+
+    flexfec_encoder_onLossReport(pFlexFecEncoder, 0.0);
+    EXPECT_EQ(0, encodeFrame(pFlexFecEncoder, 10));
+
+    EXPECT_EQ(STATUS_SUCCESS, flexfec_encoder_free(&pFlexFecEncoder));
+    EXPECT_EQ(NULL, pFlexFecEncoder);
+}
+
+TEST_F(FlexFecFunctionalityTest, protectionFollowsReportedLossUpToTheMaximum)
+{
+    PFlexFecEncoder pFlexFecEncoder = NULL;
+
+    EXPECT_EQ(STATUS_SUCCESS, flexfec_encoder_create(TEST_FLEXFEC_SSRC, TEST_FLEXFEC_PROTECTED_SSRC, 30, &pFlexFecEncoder));
+    buildFrame(10, 1000, 3000);
+
+    // 5% loss, 10% protection
+    flexfec_encoder_onLossReport(pFlexFecEncoder, 0.05);
+    EXPECT_EQ(1, encodeFrame(pFlexFecEncoder, 10));
+
+    // 40% loss is capped at 30% protection
+    flexfec_encoder_onLossReport(pFlexFecEncoder, 0.4);
+    EXPECT_EQ(3, encodeFrame(pFlexFecEncoder, 10));
+
+    EXPECT_EQ(STATUS_SUCCESS, flexfec_encoder_free(&pFlexFecEncoder));
+}
+
+TEST_F(FlexFecFunctionalityTest, singleLostPacketIsRecovered)
+{
+    PFlexFecEncoder pFlexFecEncoder = NULL;
+    PFlexFecReceiver pFlexFecReceiver = NULL;
+    PFlexFecRepairPacket pRepairPacket;
+    PBYTE pRecovered = NULL;
+    UINT32 i, lost, repairCount, recoveredLen = 0, recoveredCount = 0;
+
+    EXPECT_EQ(STATUS_SUCCESS, flexfec_encoder_create(TEST_FLEXFEC_SSRC, TEST_FLEXFEC_PROTECTED_SSRC, 50, &pFlexFecEncoder));
+    flexfec_encoder_onLossReport(pFlexFecEncoder, 0.25);
+
+    for (lost = 0; lost < 10; lost++) {
+        EXPECT_EQ(STATUS_SUCCESS, flexfec_receiver_create(TEST_FLEXFEC_PROTECTED_SSRC, &pFlexFecReceiver));
+        buildFrame(10, (UINT16) (65530 + lost * 10), 3000);
+        repairCount = encodeFrame(pFlexFecEncoder, 10);
+        EXPECT_EQ(5, repairCount);
+
+        for (i = 0; i < 10; i++) {
+            if (i != lost) {
+                EXPECT_EQ(STATUS_SUCCESS, flexfec_receiver_onMediaPacket(pFlexFecReceiver, packets[i], packetLens[i]));
+            }
+        }
+
+        recoveredCount = 0;
+        for (i = 0; i < repairCount; i++) {
+            pRepairPacket = &pFlexFecEncoder->pRepairPackets[i];
+            ASSERT_NE(0, pRepairPacket->packetLen);
+            EXPECT_EQ(STATUS_SUCCESS,
+                      flexfec_receiver_onRepairPacket(pFlexFecReceiver, pRepairPacket->pBuffer + MIN_HEADER_LENGTH,
+                                                      pRepairPacket->packetLen - MIN_HEADER_LENGTH, &pRecovered, &recoveredLen));
+            if (recoveredLen != 0) {
+                recoveredCount++;
+                EXPECT_EQ(packetLens[lost], recoveredLen);
+                EXPECT_EQ(0, MEMCMP(packets[lost], pRecovered, recoveredLen));
+            }
+        }
+        // Each media packet is protected by exactly one of the interleaved repair packets
+        EXPECT_EQ(1, recoveredCount);
+        EXPECT_EQ(STATUS_SUCCESS, flexfec_receiver_free(&pFlexFecReceiver));
+    }
+
+    EXPECT_EQ(STATUS_SUCCESS, flexfec_encoder_free(&pFlexFecEncoder));
+}
+
+TEST_F(FlexFecFunctionalityTest, twoLostPacketsOfOneRepairPacketAreNotRecovered)
+{
+    PFlexFecEncoder pFlexFecEncoder = NULL;
+    PFlexFecReceiver pFlexFecReceiver = NULL;
+    PFlexFecRepairPacket pRepairPacket;
+    PBYTE pRecovered = NULL;
+    UINT32 i, recoveredLen = 0;
+
+    EXPECT_EQ(STATUS_SUCCESS, flexfec_encoder_create(TEST_FLEXFEC_SSRC, TEST_FLEXFEC_PROTECTED_SSRC, 50, &pFlexFecEncoder));
+    EXPECT_EQ(STATUS_SUCCESS, flexfec_receiver_create(TEST_FLEXFEC_PROTECTED_SSRC, &pFlexFecReceiver));
+    flexfec_encoder_onLossReport(pFlexFecEncoder, 0.05);
+    buildFrame(10, 1000, 3000);
+    EXPECT_EQ(1, encodeFrame(pFlexFecEncoder, 10));
+
+    for (i = 2; i < 10; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, flexfec_receiver_onMediaPacket(pFlexFecReceiver, packets[i], packetLens[i]));
+    }
+    pRepairPacket = &pFlexFecEncoder->pRepairPackets[0];
+    EXPECT_EQ(STATUS_SUCCESS,
+              flexfec_receiver_onRepairPacket(pFlexFecReceiver, pRepairPacket->pBuffer + MIN_HEADER_LENGTH,
+                                              pRepairPacket->packetLen - MIN_HEADER_LENGTH, &pRecovered, &recoveredLen));
+    EXPECT_EQ(0, recoveredLen);
+
+    // Nothing lost, nothing to rebuild
+    for (i = 0; i < 2; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, flexfec_receiver_onMediaPacket(pFlexFecReceiver, packets[i], packetLens[i]));
+    }
+    EXPECT_EQ(STATUS_SUCCESS,
+              flexfec_receiver_onRepairPacket(pFlexFecReceiver, pRepairPacket->pBuffer + MIN_HEADER_LENGTH,
+                                              pRepairPacket->packetLen - MIN_HEADER_LENGTH, &pRecovered, &recoveredLen));
+    EXPECT_EQ(0, recoveredLen);
+
+    EXPECT_EQ(STATUS_SUCCESS, flexfec_receiver_free(&pFlexFecReceiver));
+    EXPECT_EQ(STATUS_SUCCESS, flexfec_encoder_free(&pFlexFecEncoder));
+}
+
+TEST_F(FlexFecFunctionalityTest, longMaskProtectsLargeBlocks)
+{
+    PFlexFecEncoder pFlexFecEncoder = NULL;
+    PFlexFecReceiver pFlexFecReceiver = NULL;
+    PFlexFecRepairPacket pRepairPacket;
+    PBYTE pRecovered = NULL;
+    UINT32 i, repairCount, recoveredLen = 0, lost = 40;
+
+    EXPECT_EQ(STATUS_SUCCESS, flexfec_encoder_create(TEST_FLEXFEC_SSRC, TEST_FLEXFEC_PROTECTED_SSRC, 50, &pFlexFecEncoder));
+    EXPECT_EQ(STATUS_SUCCESS, flexfec_receiver_create(TEST_FLEXFEC_PROTECTED_SSRC, &pFlexFecReceiver));
+    // A single repair packet for the whole block needs the long mask
+    flexfec_encoder_onLossReport(pFlexFecEncoder, 0.01);
+    buildFrame(FLEXFEC_MAX_BLOCK_SIZE, 1000, 3000);
+    repairCount = encodeFrame(pFlexFecEncoder, FLEXFEC_MAX_BLOCK_SIZE);
+    EXPECT_EQ(1, repairCount);
+    pRepairPacket = &pFlexFecEncoder->pRepairPackets[0];
+    EXPECT_EQ(FLEXFEC_LONG_HEADER_LEN, pRepairPacket->headerLen);
+
+    for (i = 0; i < FLEXFEC_MAX_BLOCK_SIZE; i++) {
+        if (i != lost) {
+            EXPECT_EQ(STATUS_SUCCESS, flexfec_receiver_onMediaPacket(pFlexFecReceiver, packets[i], packetLens[i]));
+        }
+    }
+    EXPECT_EQ(STATUS_SUCCESS,
+              flexfec_receiver_onRepairPacket(pFlexFecReceiver, pRepairPacket->pBuffer + MIN_HEADER_LENGTH,
+                                              pRepairPacket->packetLen - MIN_HEADER_LENGTH, &pRecovered, &recoveredLen));
+    EXPECT_EQ(packetLens[lost], recoveredLen);
+    EXPECT_EQ(0, MEMCMP(packets[lost], pRecovered, recoveredLen));
+
+    EXPECT_EQ(STATUS_SUCCESS, flexfec_receiver_free(&pFlexFecReceiver));
+    EXPECT_EQ(STATUS_SUCCESS, flexfec_encoder_free(&pFlexFecEncoder));
+}
+
+TEST_F(FlexFecFunctionalityTest, malformedRepairPacketIsRejected)
+{
+    PFlexFecReceiver pFlexFecReceiver = NULL;
+    BYTE payload[FLEXFEC_HEADER_LEN] = {0};
+    PBYTE pRecovered = NULL;
+    UINT32 recoveredLen = 0;
+
+    EXPECT_EQ(STATUS_SUCCESS, flexfec_receiver_create(TEST_FLEXFEC_PROTECTED_SSRC, &pFlexFecReceiver));
+    EXPECT_EQ(STATUS_RTP_INVALID_FEC_PACKET, flexfec_receiver_onRepairPacket(pFlexFecReceiver, payload, 8, &pRecovered, &recoveredLen));
+    EXPECT_EQ(0, recoveredLen);
+    EXPECT_EQ(STATUS_SUCCESS, flexfec_receiver_free(&pFlexFecReceiver));
+}
+
+} // namespace webrtcclient
+} // namespace video
+} // namespace kinesis
+} // namespace amazonaws
+} // namespace com
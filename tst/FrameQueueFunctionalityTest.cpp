@@ -0,0 +1,159 @@
+#include "WebRTCClientTestFixture.h"
+
+namespace com {
+namespace amazonaws {
+namespace kinesis {
+namespace video {
+namespace webrtcclient {
+
+class FrameQueueFunctionalityTest : public WebRtcClientTestBase {
+};
+
+static UINT32 frameQueueWriteCount;
+static UINT32 frameQueueWrittenIndexes[16];
+static UINT32 frameQueueDroppedFrames;
+static UINT64 frameQueueDroppedBytes;
+static UINT32 frameQueueKeyFrameRequests;
+
+static STATUS testFrameQueueWrite(UINT64 customData, PFrame pFrame)
+{
+    UNUSED_PARAM(customData);
+    // Every test frame starts with its index
+    EXPECT_EQ((BYTE) pFrame->index, pFrame->frameData[0]);
+    if (frameQueueWriteCount < ARRAY_SIZE(frameQueueWrittenIndexes)) {
+        frameQueueWrittenIndexes[frameQueueWriteCount] = pFrame->index;
+    }
+    frameQueueWriteCount++;
+    return STATUS_SUCCESS;
+}
+
+static VOID testFrameQueueOnDrop(UINT64 customData, UINT32 frameCount, UINT64 frameBytes, BOOL keyFrameNeeded)
+{
+    UNUSED_PARAM(customData);
+    frameQueueDroppedFrames += frameCount;
+    frameQueueDroppedBytes += frameBytes;
+    if (keyFrameNeeded) {
+        frameQueueKeyFrameRequests++;
+    }
+}
+
+static PFrameQueue createTestFrameQueue(UINT32 queueSize, FRAME_QUEUE_DROP_POLICY dropPolicy)
+{
+    PFrameQueue pFrameQueue = NULL;
+
+    frameQueueWriteCount = 0;
+    frameQueueDroppedFrames = 0;
+    frameQueueDroppedBytes = 0;
+    frameQueueKeyFrameRequests = 0;
+    EXPECT_EQ(STATUS_SUCCESS, frame_queue_create(queueSize, dropPolicy, testFrameQueueWrite, testFrameQueueOnDrop, 0, &pFrameQueue));
+    return pFrameQueue;
+}
+
+static VOID enqueueTestFrame(PFrameQueue pFrameQueue, UINT32 index, BOOL keyFrame)
+{
+    BYTE frameData[32];
+    Frame frame;
+
+    MEMSET(&frame, 0x00, SIZEOF(Frame));
+    MEMSET(frameData, (BYTE) index, SIZEOF(frameData));
+    frame.index = index;
+    frame.flags = keyFrame ? FRAME_FLAG_KEY_FRAME : FRAME_FLAG_NONE;
+    frame.frameData = frameData;
+    frame.size = 10 + index;
+    EXPECT_EQ(STATUS_SUCCESS, frame_queue_enqueue(pFrameQueue, &frame));
+    // The queue keeps its own copy
+    MEMSET(frameData, 0xFF, SIZEOF(frameData));
+}
+
+TEST_F(FrameQueueFunctionalityTest, dropOldestKeepsTheNewestFrames)
+{
+    PFrameQueue pFrameQueue = createTestFrameQueue(3, FRAME_QUEUE_DROP_POLICY_DROP_OLDEST);
+    BOOL written = FALSE;
+    UINT32 i;
+
+    EXPECT_NE(STATUS_SUCCESS, frame_queue_enqueue(pFrameQueue, NULL));
+    for (i = 0; i < 5; i++) {
+        enqueueTestFrame(pFrameQueue, i, i == 0);
+    }
+    EXPECT_EQ(2, frameQueueDroppedFrames);
+    EXPECT_EQ(10 + 11, frameQueueDroppedBytes);
+    EXPECT_EQ(0, frameQueueKeyFrameRequests);
+
+    for (i = 0; i < 3; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, frame_queue_writeNext(pFrameQueue, &written));
+        EXPECT_TRUE(written);
+    }
+    EXPECT_EQ(STATUS_SUCCESS, frame_queue_writeNext(pFrameQueue, &written));
+    EXPECT_FALSE(written);
+    EXPECT_EQ(3, frameQueueWriteCount);
+    EXPECT_EQ(2, frameQueueWrittenIndexes[0]);
+    EXPECT_EQ(3, frameQueueWrittenIndexes[1]);
+    EXPECT_EQ(4, frameQueueWrittenIndexes[2]);
+
+    EXPECT_EQ(STATUS_SUCCESS, frame_queue_free(&pFrameQueue));
+    EXPECT_EQ(NULL, pFrameQueue);
+}
+
+TEST_F(FrameQueueFunctionalityTest, dropUntilKeyFrameFlushesTheQueue)
+{
+    PFrameQueue pFrameQueue = createTestFrameQueue(2, FRAME_QUEUE_DROP_POLICY_DROP_UNTIL_KEY_FRAME);
+    BOOL written = FALSE;
+
+    enqueueTestFrame(pFrameQueue, 0, TRUE);
+    enqueueTestFrame(pFrameQueue, 1, FALSE);
+    // The queued frames and the delta frame which did not fit all go, and a key frame is requested once
+    enqueueTestFrame(pFrameQueue, 2, FALSE);
+    EXPECT_EQ(3, frameQueueDroppedFrames);
+    EXPECT_EQ(10 + 11 + 12, frameQueueDroppedBytes);
+    EXPECT_EQ(1, frameQueueKeyFrameRequests);
+    EXPECT_EQ(0, pFrameQueue->frameCount);
+
+    enqueueTestFrame(pFrameQueue, 3, FALSE);
+    EXPECT_EQ(4, frameQueueDroppedFrames);
+    EXPECT_EQ(1, frameQueueKeyFrameRequests);
+    EXPECT_EQ(0, pFrameQueue->frameCount);
+
+    enqueueTestFrame(pFrameQueue, 4, TRUE);
+    enqueueTestFrame(pFrameQueue, 5, FALSE);
+    EXPECT_EQ(4, frameQueueDroppedFrames);
+    EXPECT_EQ(2, pFrameQueue->frameCount);
+
+    EXPECT_EQ(STATUS_SUCCESS, frame_queue_writeNext(pFrameQueue, &written));
+    EXPECT_EQ(STATUS_SUCCESS, frame_queue_writeNext(pFrameQueue, &written));
+    EXPECT_EQ(2, frameQueueWriteCount);
+    EXPECT_EQ(4, frameQueueWrittenIndexes[0]);
+    EXPECT_EQ(5, frameQueueWrittenIndexes[1]);
+
+    EXPECT_EQ(STATUS_SUCCESS, frame_queue_free(&pFrameQueue));
+}
+
+TEST_F(FrameQueueFunctionalityTest, workerWritesTheFramesInOrder)
+{
+    PFrameQueue pFrameQueue = createTestFrameQueue(8, FRAME_QUEUE_DROP_POLICY_DROP_OLDEST);
+    UINT32 i;
+    UINT64 timeToWait;
+
+    EXPECT_EQ(STATUS_SUCCESS, frame_queue_start(pFrameQueue));
+    for (i = 0; i < 4; i++) {
+        enqueueTestFrame(pFrameQueue, i, i == 0);
+    }
+
+    timeToWait = GETTIME() + HUNDREDS_OF_NANOS_IN_A_SECOND;
+    while (frameQueueWriteCount < 4 && GETTIME() < timeToWait) {
+        THREAD_SLEEP(10 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND);
+    }
+    EXPECT_EQ(4, frameQueueWriteCount);
+    for (i = 0; i < 4; i++) {
+        EXPECT_EQ(i, frameQueueWrittenIndexes[i]);
+    }
+    EXPECT_EQ(0, frameQueueDroppedFrames);
+
+    // Stops the worker
+    EXPECT_EQ(STATUS_SUCCESS, frame_queue_free(&pFrameQueue));
+}
+
+} // namespace webrtcclient
+} // namespace video
+} // namespace kinesis
+} // namespace amazonaws
+} // namespace com
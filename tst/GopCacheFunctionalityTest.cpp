@@ -0,0 +1,297 @@
+#include "WebRTCClientTestFixture.h"
+
+namespace com {
+namespace amazonaws {
+namespace kinesis {
+namespace video {
+namespace webrtcclient {
+
+#define TEST_GOP_CACHE_FRAME_SIZE 3000
+#define TEST_GOP_CACHE_FPS        25
+
+class GopCacheFunctionalityTest : public WebRtcClientTestBase {
+  protected:
+    BYTE frameData[TEST_GOP_CACHE_FRAME_SIZE];
+
+    VOID initFrame(PFrame pFrame, UINT32 index, BOOL keyFrame)
+    {
+        MEMSET(pFrame, 0x00, SIZEOF(Frame));
+        MEMSET(frameData, (BYTE) index, SIZEOF(frameData));
+        pFrame->frameData = frameData;
+        pFrame->size = SIZEOF(frameData);
+        pFrame->flags = keyFrame ? FRAME_FLAG_KEY_FRAME : FRAME_FLAG_NONE;
+        pFrame->presentationTs = index * HUNDREDS_OF_NANOS_IN_A_SECOND / TEST_GOP_CACHE_FPS;
+        pFrame->decodingTs = pFrame->presentationTs;
+    }
+
+    VOID initVideoTransceiver(PRtcPeerConnection* ppRtcPeerConnection, PRtcRtpTransceiver* ppRtcRtpTransceiver)
+    {
+        RtcConfiguration config{};
+        RtcMediaStreamTrack track{};
+        PKvsRtpTransceiver pKvsRtpTransceiver;
+
+        config.kvsRtcConfiguration.enableGopCache = TRUE;
+        track.kind = MEDIA_STREAM_TRACK_KIND_VIDEO;
+        track.codec = RTC_CODEC_VP8;
+        STRNCPY(track.streamId, "myKvsVideoStream", MAX_MEDIA_STREAM_ID_LEN);
+        STRNCPY(track.trackId, "myVideoTrack", MAX_MEDIA_STREAM_ID_LEN);
+
+        ASSERT_EQ(STATUS_SUCCESS, pc_create(&config, ppRtcPeerConnection));
+        ASSERT_EQ(STATUS_SUCCESS, pc_addTransceiver(*ppRtcPeerConnection, &track, nullptr, ppRtcRtpTransceiver));
+        pKvsRtpTransceiver = (PKvsRtpTransceiver) *ppRtcRtpTransceiver;
+        ASSERT_TRUE(pKvsRtpTransceiver->pGopCache != NULL);
+        pKvsRtpTransceiver->sender.payloadType = DEFAULT_PAYLOAD_VP8;
+        pKvsRtpTransceiver->sender.rtxPayloadType = DEFAULT_PAYLOAD_VP8;
+        ASSERT_EQ(STATUS_SUCCESS,
+                  rtp_rolling_buffer_create(DEFAULT_ROLLING_BUFFER_DURATION_IN_SECONDS * HIGHEST_EXPECTED_BIT_RATE / 8 / DEFAULT_MTU_SIZE,
+                                            &pKvsRtpTransceiver->sender.packetBuffer));
+    }
+
+    // No ice candidate pair is selected, so the packets are serialized and encrypted but never hit the socket
+    VOID initSrtpSession(PRtcPeerConnection pRtcPeerConnection)
+    {
+        BYTE srtpKey[30] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+                            0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D};
+
+        ASSERT_EQ(STATUS_SUCCESS,
+                  srtp_session_init(srtpKey, srtpKey, KVS_SRTP_PROFILE_AES128_CM_HMAC_SHA1_80,
+                                    &((PKvsPeerConnection) pRtcPeerConnection)->pSrtpSession));
+    }
+
+    // The packets the cached frames make at the mtu of the transceiver
+    UINT32 countCachedPackets(PKvsRtpTransceiver pKvsRtpTransceiver)
+    {
+        PayloadArray payloadArray{};
+        UINT32 i, packetCount = 0;
+
+        for (i = 0; i < pKvsRtpTransceiver->pGopCache->frameCount; i++) {
+            EXPECT_EQ(STATUS_SUCCESS,
+                      rtp_packetizeFrame(RTC_CODEC_VP8, rtp_transceiver_getPayloadMtu(pKvsRtpTransceiver, &pKvsRtpTransceiver->sender),
+                                         &pKvsRtpTransceiver->pGopCache->pFrames[i].frame, &payloadArray));
+            packetCount += payloadArray.payloadSubLenSize;
+        }
+        SAFE_MEMFREE(payloadArray.payloadBuffer);
+        SAFE_MEMFREE(payloadArray.payloadSubLength);
+        nalu_index_free(&payloadArray.naluIndex);
+
+        return packetCount;
+    }
+};
+
+TEST_F(GopCacheFunctionalityTest, framesBeforeTheFirstKeyFrameAreDropped)
+{
+    PGopCache pGopCache = NULL;
+    Frame frame;
+
+    EXPECT_EQ(STATUS_INVALID_ARG, gop_cache_create(0, &pGopCache));
+    EXPECT_EQ(STATUS_SUCCESS, gop_cache_create(DEFAULT_GOP_CACHE_MAX_SIZE, &pGopCache));
+
+    initFrame(&frame, 0, FALSE);
+    EXPECT_EQ(STATUS_SUCCESS, gop_cache_addFrame(pGopCache, &frame));
+    EXPECT_EQ(0, pGopCache->frameCount);
+
+    initFrame(&frame, 1, TRUE);
+    EXPECT_EQ(STATUS_SUCCESS, gop_cache_addFrame(pGopCache, &frame));
+    initFrame(&frame, 2, FALSE);
+    EXPECT_EQ(STATUS_SUCCESS, gop_cache_addFrame(pGopCache, &frame));
+    EXPECT_EQ(2, pGopCache->frameCount);
+    EXPECT_EQ(2 * TEST_GOP_CACHE_FRAME_SIZE, pGopCache->byteCount);
+    // The cache keeps its own copy of the frame data
+    EXPECT_TRUE(pGopCache->pFrames[1].frame.frameData != frameData);
+    EXPECT_EQ(0, MEMCMP(frameData, pGopCache->pFrames[1].frame.frameData, TEST_GOP_CACHE_FRAME_SIZE));
+    EXPECT_EQ(frame.presentationTs, pGopCache->pFrames[1].frame.presentationTs);
+
+    EXPECT_EQ(STATUS_SUCCESS, gop_cache_free(&pGopCache));
+    EXPECT_TRUE(pGopCache == NULL);
+    EXPECT_EQ(STATUS_SUCCESS, gop_cache_free(&pGopCache));
+}
+
+TEST_F(GopCacheFunctionalityTest, keyFrameReplacesTheCachedGop)
+{
+    PGopCache pGopCache = NULL;
+    Frame frame;
+    UINT32 i;
+
+    EXPECT_EQ(STATUS_SUCCESS, gop_cache_create(DEFAULT_GOP_CACHE_MAX_SIZE, &pGopCache));
+    for (i = 0; i < 5; i++) {
+        initFrame(&frame, i, i == 0);
+        EXPECT_EQ(STATUS_SUCCESS, gop_cache_addFrame(pGopCache, &frame));
+    }
+    EXPECT_EQ(5, pGopCache->frameCount);
+
+    initFrame(&frame, i, TRUE);
+    EXPECT_EQ(STATUS_SUCCESS, gop_cache_addFrame(pGopCache, &frame));
+    EXPECT_EQ(1, pGopCache->frameCount);
+    EXPECT_EQ(frame.presentationTs, pGopCache->pFrames[0].frame.presentationTs);
+    EXPECT_EQ(TEST_GOP_CACHE_FRAME_SIZE, pGopCache->byteCount);
+
+    EXPECT_EQ(STATUS_SUCCESS, gop_cache_free(&pGopCache));
+}
+
+TEST_F(GopCacheFunctionalityTest, gopLargerThanTheCapWaitsForTheNextKeyFrame)
+{
+    PGopCache pGopCache = NULL;
+    Frame frame;
+
+    // Room for two frames
+    EXPECT_EQ(STATUS_SUCCESS, gop_cache_create(2 * TEST_GOP_CACHE_FRAME_SIZE + 100, &pGopCache));
+    initFrame(&frame, 0, TRUE);
+    EXPECT_EQ(STATUS_SUCCESS, gop_cache_addFrame(pGopCache, &frame));
+    initFrame(&frame, 1, FALSE);
+    EXPECT_EQ(STATUS_SUCCESS, gop_cache_addFrame(pGopCache, &frame));
+    EXPECT_EQ(2, pGopCache->frameCount);
+
+    initFrame(&frame, 2, FALSE);
+    EXPECT_EQ(STATUS_SUCCESS, gop_cache_addFrame(pGopCache, &frame));
+    EXPECT_EQ(0, pGopCache->frameCount);
+    EXPECT_EQ(0, pGopCache->byteCount);
+    initFrame(&frame, 3, FALSE);
+    EXPECT_EQ(STATUS_SUCCESS, gop_cache_addFrame(pGopCache, &frame));
+    EXPECT_EQ(0, pGopCache->frameCount);
+
+    initFrame(&frame, 4, TRUE);
+    EXPECT_EQ(STATUS_SUCCESS, gop_cache_addFrame(pGopCache, &frame));
+    EXPECT_EQ(1, pGopCache->frameCount);
+
+    EXPECT_EQ(STATUS_SUCCESS, gop_cache_free(&pGopCache));
+}
+
+TEST_F(GopCacheFunctionalityTest, takenFramesKeepTheirDataAndLeaveTheCacheEmpty)
+{
+    PGopCache pGopCache = NULL, pCopyGopCache = NULL;
+    PCachedFrame pFrames = NULL;
+    Frame frame;
+    UINT32 i, frameCount = 0;
+
+    EXPECT_EQ(STATUS_SUCCESS, gop_cache_create(DEFAULT_GOP_CACHE_MAX_SIZE, &pGopCache));
+    EXPECT_EQ(STATUS_SUCCESS, gop_cache_create(DEFAULT_GOP_CACHE_MAX_SIZE, &pCopyGopCache));
+    for (i = 0; i < 3; i++) {
+        initFrame(&frame, i, i == 0);
+        EXPECT_EQ(STATUS_SUCCESS, gop_cache_addFrame(pGopCache, &frame));
+    }
+
+    // A copy starts with the key frame of the source, whatever the destination held before
+    initFrame(&frame, 10, TRUE);
+    EXPECT_EQ(STATUS_SUCCESS, gop_cache_addFrame(pCopyGopCache, &frame));
+    EXPECT_EQ(STATUS_SUCCESS, gop_cache_copyFrames(pCopyGopCache, pGopCache));
+    EXPECT_EQ(3, pCopyGopCache->frameCount);
+    EXPECT_EQ(3 * TEST_GOP_CACHE_FRAME_SIZE, pCopyGopCache->byteCount);
+    EXPECT_TRUE(pCopyGopCache->pFrames[0].frame.frameData != pGopCache->pFrames[0].frame.frameData);
+    EXPECT_EQ(0, pCopyGopCache->pFrames[0].frame.frameData[0]);
+
+    pFrames = (PCachedFrame) MEMCALLOC(GOP_CACHE_MAX_FRAME_COUNT, SIZEOF(CachedFrame));
+    ASSERT_TRUE(pFrames != NULL);
+    EXPECT_EQ(STATUS_SUCCESS, gop_cache_takeFrames(pGopCache, pFrames, &frameCount));
+    EXPECT_EQ(3, frameCount);
+    EXPECT_EQ(0, pGopCache->frameCount);
+    EXPECT_EQ(0, pGopCache->byteCount);
+    for (i = 0; i < frameCount; i++) {
+        EXPECT_EQ(i, pFrames[i].frame.frameData[TEST_GOP_CACHE_FRAME_SIZE - 1]);
+    }
+
+    // The frames added meanwhile do not touch the taken ones
+    initFrame(&frame, 20, TRUE);
+    EXPECT_EQ(STATUS_SUCCESS, gop_cache_addFrame(pGopCache, &frame));
+    EXPECT_EQ(0, pFrames[0].frame.frameData[0]);
+    EXPECT_EQ(20, pGopCache->pFrames[0].frame.frameData[0]);
+
+    gop_cache_freeFrames(pFrames, frameCount);
+    SAFE_MEMFREE(pFrames);
+    EXPECT_EQ(STATUS_SUCCESS, gop_cache_free(&pCopyGopCache));
+    EXPECT_EQ(STATUS_SUCCESS, gop_cache_free(&pGopCache));
+}
+
+TEST_F(GopCacheFunctionalityTest, cachedGopIsSentOnceTheSrtpSessionIsUp)
+{
+    PRtcPeerConnection pRtcPeerConnection = nullptr;
+    PRtcRtpTransceiver pRtcRtpTransceiver = nullptr;
+    PKvsRtpTransceiver pKvsRtpTransceiver = nullptr;
+    Frame frame;
+    UINT32 i, cachedPacketCount = 0;
+    UINT16 sequenceNumber;
+
+    initVideoTransceiver(&pRtcPeerConnection, &pRtcRtpTransceiver);
+    pKvsRtpTransceiver = (PKvsRtpTransceiver) pRtcRtpTransceiver;
+
+    // The frames are kept while the srtp session is not up, the delta frame before the key frame does not decode
+    for (i = 0; i < 4; i++) {
+        initFrame(&frame, i, i == 1);
+        EXPECT_EQ(STATUS_SRTP_NOT_READY_YET, rtp_writeFrame(pRtcRtpTransceiver, &frame));
+    }
+    EXPECT_EQ(3, pKvsRtpTransceiver->pGopCache->frameCount);
+    EXPECT_EQ(0, pKvsRtpTransceiver->outboundStats.framesEncoded);
+    cachedPacketCount = countCachedPackets(pKvsRtpTransceiver);
+
+    initSrtpSession(pRtcPeerConnection);
+    sequenceNumber = pKvsRtpTransceiver->sender.sequenceNumber;
+    EXPECT_EQ(STATUS_SUCCESS, rtp_transceiver_flushGopCache(pKvsRtpTransceiver));
+    EXPECT_TRUE(pKvsRtpTransceiver->pGopCache->flushed);
+    EXPECT_EQ(0, pKvsRtpTransceiver->pGopCache->frameCount);
+    EXPECT_EQ(3, pKvsRtpTransceiver->outboundStats.framesEncoded);
+    EXPECT_EQ(1, pKvsRtpTransceiver->outboundStats.keyFramesEncoded);
+    // The sequence numbers follow on from the sender, without the gaps of the dropped frames
+    EXPECT_EQ(GET_UINT16_SEQ_NUM(sequenceNumber + cachedPacketCount), pKvsRtpTransceiver->sender.sequenceNumber);
+
+    // The live frames go out as they come from then on
+    initFrame(&frame, i + 1, FALSE);
+    EXPECT_EQ(STATUS_SUCCESS, rtp_writeFrame(pRtcRtpTransceiver, &frame));
+    EXPECT_EQ(4, pKvsRtpTransceiver->outboundStats.framesEncoded);
+    EXPECT_EQ(STATUS_SUCCESS, rtp_transceiver_flushGopCache(pKvsRtpTransceiver));
+    EXPECT_EQ(4, pKvsRtpTransceiver->outboundStats.framesEncoded);
+
+    EXPECT_EQ(STATUS_SUCCESS, pc_free(&pRtcPeerConnection));
+}
+
+TEST_F(GopCacheFunctionalityTest, viewerJoiningMidGopGetsTheGopOfTheSource)
+{
+    PRtcPeerConnection pRtcPeerConnections[2] = {nullptr, nullptr};
+    PRtcRtpTransceiver pRtcRtpTransceivers[2] = {nullptr, nullptr};
+    PKvsRtpTransceiver pKvsRtpTransceiver = nullptr;
+    PRtcBroadcastGroup pRtcBroadcastGroup = nullptr;
+    PKvsBroadcastGroup pKvsBroadcastGroup = nullptr;
+    Frame frame;
+    UINT32 i;
+
+    for (i = 0; i < ARRAY_SIZE(pRtcPeerConnections); i++) {
+        initVideoTransceiver(&pRtcPeerConnections[i], &pRtcRtpTransceivers[i]);
+        initSrtpSession(pRtcPeerConnections[i]);
+    }
+    ASSERT_EQ(STATUS_SUCCESS, rtp_broadcast_group_create(&pRtcBroadcastGroup));
+    pKvsBroadcastGroup = (PKvsBroadcastGroup) pRtcBroadcastGroup;
+
+    // The first viewer is connected before the source starts, it gets the frames live
+    EXPECT_EQ(STATUS_SUCCESS, rtp_broadcast_group_addTransceiver(pRtcBroadcastGroup, pRtcRtpTransceivers[0]));
+    ASSERT_TRUE(pKvsBroadcastGroup->pGopCache != NULL);
+    EXPECT_EQ(STATUS_SUCCESS, rtp_transceiver_flushGopCache((PKvsRtpTransceiver) pRtcRtpTransceivers[0]));
+    for (i = 0; i < 4; i++) {
+        initFrame(&frame, i, i == 1);
+        EXPECT_EQ(STATUS_SUCCESS, rtp_broadcast_group_writeFrame(pRtcBroadcastGroup, &frame));
+    }
+    EXPECT_EQ(4, ((PKvsRtpTransceiver) pRtcRtpTransceivers[0])->outboundStats.framesEncoded);
+    EXPECT_EQ(3, pKvsBroadcastGroup->pGopCache->frameCount);
+
+    // The second viewer joins mid-gop on another peer connection, it gets the key frame and the frames after it right away
+    pKvsRtpTransceiver = (PKvsRtpTransceiver) pRtcRtpTransceivers[1];
+    EXPECT_EQ(STATUS_SUCCESS, rtp_broadcast_group_addTransceiver(pRtcBroadcastGroup, pRtcRtpTransceivers[1]));
+    EXPECT_TRUE(pKvsRtpTransceiver->pGopCache->flushed);
+    EXPECT_EQ(0, pKvsRtpTransceiver->pGopCache->frameCount);
+    EXPECT_EQ(3, pKvsRtpTransceiver->outboundStats.framesEncoded);
+    EXPECT_EQ(1, pKvsRtpTransceiver->outboundStats.keyFramesEncoded);
+
+    initFrame(&frame, i, FALSE);
+    EXPECT_EQ(STATUS_SUCCESS, rtp_broadcast_group_writeFrame(pRtcBroadcastGroup, &frame));
+    EXPECT_EQ(5, ((PKvsRtpTransceiver) pRtcRtpTransceivers[0])->outboundStats.framesEncoded);
+    EXPECT_EQ(4, pKvsRtpTransceiver->outboundStats.framesEncoded);
+    EXPECT_EQ(4, pKvsBroadcastGroup->pGopCache->frameCount);
+
+    EXPECT_EQ(STATUS_SUCCESS, rtp_broadcast_group_free(&pRtcBroadcastGroup));
+    for (i = 0; i < ARRAY_SIZE(pRtcPeerConnections); i++) {
+        EXPECT_EQ(STATUS_SUCCESS, pc_free(&pRtcPeerConnections[i]));
+    }
+}
+
+} // namespace webrtcclient
+} // namespace video
+} // namespace kinesis
+} // namespace amazonaws
+} // namespace com
@@ -708,6 +708,220 @@ TEST_F(IceFunctionalityTest, IceAgentCandidateGatheringTest)
 
     deinitializeSignalingClient();
 }
+
+TEST_F(IceFunctionalityTest, socketConnectionSendBatchDeliversEveryDatagram)
+{
+    PSocketConnection pSenderSocketConnection = NULL, pReceiverSocketConnection = NULL;
+    KvsIpAddress senderAddr, receiverAddr;
+    BYTE datagrams[SOCKET_SEND_BATCH_SIZE + 8][100];
+    PBYTE ppBufs[SOCKET_SEND_BATCH_SIZE + 8];
+    UINT32 bufLens[SOCKET_SEND_BATCH_SIZE + 8];
+    BYTE recvBuf[200];
+    UINT32 i, sentCount = 0, receivedCount = 0;
+
+    MEMSET(&senderAddr, 0x00, SIZEOF(KvsIpAddress));
+    senderAddr.family = KVS_IP_FAMILY_TYPE_IPV4;
+    // 127.0.0.1
+    senderAddr.address[0] = 0x7f;
+    senderAddr.address[3] = 0x01;
+    receiverAddr = senderAddr;
+
+    EXPECT_EQ(STATUS_SUCCESS,
+              socket_connection_create(KVS_IP_FAMILY_TYPE_IPV4, KVS_SOCKET_PROTOCOL_UDP, &senderAddr, NULL, 0, NULL, 0, &pSenderSocketConnection));
+    EXPECT_EQ(STATUS_SUCCESS,
+              socket_connection_create(KVS_IP_FAMILY_TYPE_IPV4, KVS_SOCKET_PROTOCOL_UDP, &receiverAddr, NULL, 0, NULL, 0,
+                                       &pReceiverSocketConnection));
+
+    // More datagrams than a single sendmmsg call takes
+    for (i = 0; i < ARRAY_SIZE(ppBufs); i++) {
+        MEMSET(datagrams[i], (BYTE) i, SIZEOF(datagrams[i]));
+        ppBufs[i] = datagrams[i];
+        bufLens[i] = SIZEOF(datagrams[i]) - i;
+    }
+
+    EXPECT_NE(STATUS_SUCCESS, socket_connection_sendBatch(NULL, ppBufs, bufLens, ARRAY_SIZE(ppBufs), &receiverAddr, &sentCount));
+    EXPECT_NE(STATUS_SUCCESS, socket_connection_sendBatch(pSenderSocketConnection, ppBufs, bufLens, ARRAY_SIZE(ppBufs), NULL, &sentCount));
+
+    EXPECT_EQ(STATUS_SUCCESS,
+              socket_connection_sendBatch(pSenderSocketConnection, ppBufs, bufLens, ARRAY_SIZE(ppBufs), &receiverAddr, &sentCount));
+    EXPECT_EQ(ARRAY_SIZE(ppBufs), sentCount);
+
+    // Loopback datagrams are queued by the time the send returns and they arrive in order
+    for (i = 0; i < ARRAY_SIZE(ppBufs); i++) {
+        if (recv(pReceiverSocketConnection->localSocket, recvBuf, SIZEOF(recvBuf), MSG_DONTWAIT) == (INT32) bufLens[i] && recvBuf[0] == (BYTE) i) {
+            receivedCount++;
+        }
+    }
+    EXPECT_EQ(ARRAY_SIZE(ppBufs), receivedCount);
+
+    EXPECT_EQ(STATUS_SUCCESS, socket_connection_free(&pSenderSocketConnection));
+    EXPECT_EQ(STATUS_SUCCESS, socket_connection_free(&pReceiverSocketConnection));
+}
+
+TEST_F(IceFunctionalityTest, socketConnectionSendBatchWithUdpSegmentOffload)
+{
+    PSocketConnection pSenderSocketConnection = NULL, pReceiverSocketConnection = NULL;
+    KvsIpAddress senderAddr, receiverAddr;
+    BYTE datagrams[SOCKET_SEND_BATCH_SIZE + 8][1000];
+    PBYTE ppBufs[SOCKET_SEND_BATCH_SIZE + 8];
+    UINT32 bufLens[SOCKET_SEND_BATCH_SIZE + 8];
+    BYTE recvBuf[2000];
+    UINT32 i, sentCount = 0, receivedCount = 0;
+
+    MEMSET(&senderAddr, 0x00, SIZEOF(KvsIpAddress));
+    senderAddr.family = KVS_IP_FAMILY_TYPE_IPV4;
+    // 127.0.0.1
+    senderAddr.address[0] = 0x7f;
+    senderAddr.address[3] = 0x01;
+    receiverAddr = senderAddr;
+
+    EXPECT_EQ(STATUS_SUCCESS,
+              socket_connection_create(KVS_IP_FAMILY_TYPE_IPV4, KVS_SOCKET_PROTOCOL_UDP, &senderAddr, NULL, 0, NULL, 0, &pSenderSocketConnection));
+    EXPECT_EQ(STATUS_SUCCESS,
+              socket_connection_create(KVS_IP_FAMILY_TYPE_IPV4, KVS_SOCKET_PROTOCOL_UDP, &receiverAddr, NULL, 0, NULL, 0,
+                                       &pReceiverSocketConnection));
+
+    EXPECT_NE(STATUS_SUCCESS, socket_connection_enableUdpSegmentOffload(NULL));
+    if (STATUS_SUCCEEDED(socket_connection_enableUdpSegmentOffload(pSenderSocketConnection))) {
+        EXPECT_TRUE(ATOMIC_LOAD_BOOL(&pSenderSocketConnection->udpSegmentOffload));
+    }
+
+    // Runs of full sized datagrams, each closed by a shorter one, as produced by the payloaders
+    for (i = 0; i < ARRAY_SIZE(ppBufs); i++) {
+        MEMSET(datagrams[i], (BYTE) i, SIZEOF(datagrams[i]));
+        ppBufs[i] = datagrams[i];
+        bufLens[i] = (i % 10 == 9) ? SIZEOF(datagrams[i]) / 2 + i : SIZEOF(datagrams[i]);
+    }
+
+    EXPECT_EQ(STATUS_SUCCESS,
+              socket_connection_sendBatch(pSenderSocketConnection, ppBufs, bufLens, ARRAY_SIZE(ppBufs), &receiverAddr, &sentCount));
+    EXPECT_EQ(ARRAY_SIZE(ppBufs), sentCount);
+
+    // Whether or not gso is available, the receiver sees the original datagrams
+    for (i = 0; i < ARRAY_SIZE(ppBufs); i++) {
+        if (recv(pReceiverSocketConnection->localSocket, recvBuf, SIZEOF(recvBuf), MSG_DONTWAIT) == (INT32) bufLens[i] && recvBuf[0] == (BYTE) i) {
+            receivedCount++;
+        }
+    }
+    EXPECT_EQ(ARRAY_SIZE(ppBufs), receivedCount);
+
+    EXPECT_EQ(STATUS_SUCCESS, socket_connection_free(&pSenderSocketConnection));
+    EXPECT_EQ(STATUS_SUCCESS, socket_connection_free(&pReceiverSocketConnection));
+}
+
+TEST_F(IceFunctionalityTest, pathMtuProbesAreSentLargestFirstAndTheLargestAnswerWins)
+{
+    IceAgent iceAgent;
+    IceCandidate localCandidate, remoteCandidate;
+    IceCandidatePair iceCandidatePair;
+    PSocketConnection pReceiverSocketConnection = NULL;
+    KvsIpAddress loopbackAddr;
+    BYTE recvBuf[2000];
+    // The ip mtus of the probes less the ipv4 and udp headers
+    UINT32 expectedSizes[ICE_PATH_MTU_PROBE_COUNT] = {1472, 1464, 1422, 1372, 1252};
+    UINT32 i;
+    INT32 recvLen;
+
+    MEMSET(&iceAgent, 0x00, SIZEOF(IceAgent));
+    MEMSET(&localCandidate, 0x00, SIZEOF(IceCandidate));
+    MEMSET(&remoteCandidate, 0x00, SIZEOF(IceCandidate));
+    MEMSET(&iceCandidatePair, 0x00, SIZEOF(IceCandidatePair));
+    MEMSET(&loopbackAddr, 0x00, SIZEOF(KvsIpAddress));
+    loopbackAddr.family = KVS_IP_FAMILY_TYPE_IPV4;
+    // 127.0.0.1
+    loopbackAddr.address[0] = 0x7f;
+    loopbackAddr.address[3] = 0x01;
+    localCandidate.ipAddress = loopbackAddr;
+    remoteCandidate.ipAddress = loopbackAddr;
+    localCandidate.iceCandidateType = ICE_CANDIDATE_TYPE_HOST;
+
+    iceAgent.kvsRtcConfiguration.enablePathMtuDiscovery = TRUE;
+    STRCPY(iceAgent.remotePassword, "remotePassword");
+    STRCPY(iceAgent.combinedUserName, "remote:local");
+    EXPECT_EQ(STATUS_SUCCESS,
+              socket_connection_create(KVS_IP_FAMILY_TYPE_IPV4, KVS_SOCKET_PROTOCOL_UDP, &localCandidate.ipAddress, NULL, 0, NULL, 0,
+                                       &localCandidate.pSocketConnection));
+    EXPECT_EQ(STATUS_SUCCESS,
+              socket_connection_create(KVS_IP_FAMILY_TYPE_IPV4, KVS_SOCKET_PROTOCOL_UDP, &remoteCandidate.ipAddress, NULL, 0, NULL, 0,
+                                       &pReceiverSocketConnection));
+    // The probes go out with the don't fragment bit, the loopback mtu takes them all
+    EXPECT_NE(STATUS_SUCCESS, socket_connection_setDontFragment(NULL));
+    EXPECT_EQ(STATUS_SUCCESS, socket_connection_setDontFragment(localCandidate.pSocketConnection));
+    iceCandidatePair.local = &localCandidate;
+    iceCandidatePair.remote = &remoteCandidate;
+
+    // Only a pair which passed its connectivity check is probed
+    iceCandidatePair.state = ICE_CANDIDATE_PAIR_STATE_IN_PROGRESS;
+    EXPECT_EQ(STATUS_SUCCESS, ice_candidate_pair_sendMtuProbes(&iceAgent, &iceCandidatePair));
+    EXPECT_EQ(0, iceCandidatePair.mtuProbeRounds);
+
+    iceCandidatePair.state = ICE_CANDIDATE_PAIR_STATE_SUCCEEDED;
+    EXPECT_EQ(STATUS_SUCCESS, ice_candidate_pair_sendMtuProbes(&iceAgent, &iceCandidatePair));
+    EXPECT_EQ(1, iceCandidatePair.mtuProbeRounds);
+    for (i = 0; i < ICE_PATH_MTU_PROBE_COUNT; i++) {
+        // The padding goes in words of 4 bytes
+        EXPECT_GE(expectedSizes[i], iceCandidatePair.mtuProbeSizes[i]);
+        EXPECT_LT(expectedSizes[i] - 4, iceCandidatePair.mtuProbeSizes[i]);
+        recvLen = recv(pReceiverSocketConnection->localSocket, recvBuf, SIZEOF(recvBuf), MSG_DONTWAIT);
+        EXPECT_EQ((INT32) iceCandidatePair.mtuProbeSizes[i], recvLen);
+        EXPECT_EQ(0, MEMCMP(recvBuf + STUN_PACKET_TRANSACTION_ID_OFFSET, iceCandidatePair.mtuProbeTransactionIds[i], STUN_TRANSACTION_ID_LEN));
+    }
+    EXPECT_GT(0, recv(pReceiverSocketConnection->localSocket, recvBuf, SIZEOF(recvBuf), MSG_DONTWAIT));
+
+    // A response to another request is not an answer to a probe
+    MEMSET(recvBuf, 0xFF, STUN_TRANSACTION_ID_LEN);
+    EXPECT_FALSE(ice_candidate_pair_handleMtuProbeResponse(&iceCandidatePair, recvBuf, TRUE));
+    EXPECT_EQ(0, iceCandidatePair.pathMtu);
+
+    // The largest answered probe is the path mtu, whatever the order the answers come in
+    EXPECT_TRUE(ice_candidate_pair_handleMtuProbeResponse(&iceCandidatePair, iceCandidatePair.mtuProbeTransactionIds[3], TRUE));
+    EXPECT_EQ(iceCandidatePair.mtuProbeSizes[3], iceCandidatePair.pathMtu);
+    EXPECT_TRUE(ice_candidate_pair_handleMtuProbeResponse(&iceCandidatePair, iceCandidatePair.mtuProbeTransactionIds[1], TRUE));
+    EXPECT_TRUE(ice_candidate_pair_handleMtuProbeResponse(&iceCandidatePair, iceCandidatePair.mtuProbeTransactionIds[2], TRUE));
+    EXPECT_EQ(iceCandidatePair.mtuProbeSizes[1], iceCandidatePair.pathMtu);
+
+    // The next round only sends the sizes above the path mtu
+    EXPECT_EQ(STATUS_SUCCESS, ice_candidate_pair_sendMtuProbes(&iceAgent, &iceCandidatePair));
+    EXPECT_EQ(2, iceCandidatePair.mtuProbeRounds);
+    EXPECT_EQ((INT32) iceCandidatePair.mtuProbeSizes[0], recv(pReceiverSocketConnection->localSocket, recvBuf, SIZEOF(recvBuf), MSG_DONTWAIT));
+    EXPECT_GT(0, recv(pReceiverSocketConnection->localSocket, recvBuf, SIZEOF(recvBuf), MSG_DONTWAIT));
+
+    // A peer which rejects the padding rejects every probe, the pair is not probed again
+    EXPECT_TRUE(ice_candidate_pair_handleMtuProbeResponse(&iceCandidatePair, iceCandidatePair.mtuProbeTransactionIds[0], FALSE));
+    EXPECT_EQ(iceCandidatePair.mtuProbeSizes[1], iceCandidatePair.pathMtu);
+    EXPECT_EQ(ICE_PATH_MTU_PROBE_ROUNDS, iceCandidatePair.mtuProbeRounds);
+    EXPECT_EQ(STATUS_SUCCESS, ice_candidate_pair_sendMtuProbes(&iceAgent, &iceCandidatePair));
+    EXPECT_GT(0, recv(pReceiverSocketConnection->localSocket, recvBuf, SIZEOF(recvBuf), MSG_DONTWAIT));
+
+    EXPECT_EQ(STATUS_SUCCESS, socket_connection_free(&localCandidate.pSocketConnection));
+    EXPECT_EQ(STATUS_SUCCESS, socket_connection_free(&pReceiverSocketConnection));
+}
+
+TEST_F(IceFunctionalityTest, pathMtuProbesAreNotSentWithoutDiscovery)
+{
+    IceAgent iceAgent;
+    IceCandidatePair iceCandidatePair;
+
+    MEMSET(&iceAgent, 0x00, SIZEOF(IceAgent));
+    MEMSET(&iceCandidatePair, 0x00, SIZEOF(IceCandidatePair));
+    iceCandidatePair.state = ICE_CANDIDATE_PAIR_STATE_SUCCEEDED;
+
+    EXPECT_EQ(STATUS_SUCCESS, ice_candidate_pair_sendMtuProbes(&iceAgent, &iceCandidatePair));
+    EXPECT_EQ(0, iceCandidatePair.mtuProbeRounds);
+    EXPECT_EQ(0, iceCandidatePair.mtuProbeSizes[0]);
+}
+
+TEST_F(IceFunctionalityTest, dontFragmentIsSetOnSocketsWithoutABoundAddress)
+{
+    PSocketConnection pSocketConnection = NULL;
+
+    // The socket of a relayed candidate is not bound, it still knows its family
+    EXPECT_EQ(STATUS_SUCCESS, socket_connection_create(KVS_IP_FAMILY_TYPE_IPV4, KVS_SOCKET_PROTOCOL_UDP, NULL, NULL, 0, NULL, 0, &pSocketConnection));
+    EXPECT_EQ(KVS_IP_FAMILY_TYPE_IPV4, pSocketConnection->hostIpAddr.family);
+    EXPECT_EQ(STATUS_SUCCESS, socket_connection_setDontFragment(pSocketConnection));
+    EXPECT_EQ(STATUS_SUCCESS, socket_connection_free(&pSocketConnection));
+}
+
 } // namespace webrtcclient
 } // namespace video
 } // namespace kinesis
@@ -1,4 +1,5 @@
 #include "WebRTCClientTestFixture.h"
+#include <ctime>
 
 namespace com {
 namespace amazonaws {
@@ -772,6 +773,452 @@ TEST_F(JitterBufferFunctionalityTest, pushFrameArrivingLate)
     clearJitterBufferForTest();
 }
 
+TEST_F(JitterBufferFunctionalityTest, stalledHeadKeepsMorePacketsThanTheRing)
+{
+    // A frame per packet, all of them held back by the missing second packet
+    const UINT32 packetCount = JITTER_BUFFER_MIN_RING_SIZE * 2 + 100;
+    PJitterBuffer pJitterBuffer = NULL;
+    PRtpPacket pRtpPacket = NULL;
+    UINT32 i, seq, counts[2] = {0, 0};
+
+    auto onFrameReady = [](UINT64 customData, UINT16 startIndex, UINT16 endIndex, UINT32 frameSize) -> STATUS {
+        UNUSED_PARAM(startIndex);
+        UNUSED_PARAM(endIndex);
+        UNUSED_PARAM(frameSize);
+        ((PUINT32) customData)[0]++;
+        return STATUS_SUCCESS;
+    };
+    auto onFrameDropped = [](UINT64 customData, UINT16 startIndex, UINT16 endIndex, UINT32 timestamp) -> STATUS {
+        UNUSED_PARAM(startIndex);
+        UNUSED_PARAM(endIndex);
+        UNUSED_PARAM(timestamp);
+        ((PUINT32) customData)[1]++;
+        return STATUS_SUCCESS;
+    };
+
+    ASSERT_EQ(STATUS_SUCCESS,
+              jitter_buffer_create(onFrameReady, onFrameDropped, testDepayRtpFunc, DEFAULT_JITTER_BUFFER_MAX_LATENCY, TEST_JITTER_BUFFER_CLOCK_RATE,
+                                   (UINT64) counts, &pJitterBuffer));
+    EXPECT_EQ(JITTER_BUFFER_MIN_RING_SIZE - 1, pJitterBuffer->ringMask);
+    for (i = 0; i < packetCount; i++) {
+        // The second packet comes last
+        seq = i == 0 ? 0 : i == packetCount - 1 ? 1 : i + 1;
+        ASSERT_EQ(STATUS_SUCCESS,
+                  rtp_packet_create(2, FALSE, FALSE, 0, FALSE, 96, (UINT16) seq, 5000 + seq, 0x1234ABCD, NULL, 0, 0, NULL, NULL, 0, &pRtpPacket));
+        pRtpPacket->payloadLength = 1;
+        pRtpPacket->payload = (PBYTE) MEMALLOC(pRtpPacket->payloadLength + 1);
+        pRtpPacket->payload[0] = (BYTE) seq;
+        pRtpPacket->payload[1] = 1; // First packet of a frame
+        pRtpPacket->pRawPacket = pRtpPacket->payload;
+        EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_push(pJitterBuffer, pRtpPacket, NULL));
+        if (i < packetCount - 1) {
+            EXPECT_EQ(0, counts[0]);
+        }
+    }
+    EXPECT_LT(JITTER_BUFFER_MIN_RING_SIZE - 1, pJitterBuffer->ringMask);
+
+    // Every frame but the last one, which waits for the next frame or the close
+    EXPECT_EQ(packetCount - 1, counts[0]);
+    EXPECT_EQ(0, counts[1]);
+    EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_free(&pJitterBuffer));
+    EXPECT_EQ(packetCount, counts[0]);
+}
+
+TEST_F(JitterBufferFunctionalityTest, stalledHeadDepaysEachPacketOnce)
+{
+    // A frame per packet, all of them held back by the first one which misses its start until it expires
+    const UINT32 packetCount = 200;
+    static UINT32 sizeCalculationCount;
+    PJitterBuffer pJitterBuffer = NULL;
+    PRtpPacket pRtpPacket = NULL;
+    UINT32 i, counts[2] = {0, 0};
+
+    auto onFrameReady = [](UINT64 customData, UINT16 startIndex, UINT16 endIndex, UINT32 frameSize) -> STATUS {
+        UNUSED_PARAM(startIndex);
+        UNUSED_PARAM(endIndex);
+        UNUSED_PARAM(frameSize);
+        ((PUINT32) customData)[0]++;
+        return STATUS_SUCCESS;
+    };
+    auto onFrameDropped = [](UINT64 customData, UINT16 startIndex, UINT16 endIndex, UINT32 timestamp) -> STATUS {
+        UNUSED_PARAM(startIndex);
+        UNUSED_PARAM(endIndex);
+        UNUSED_PARAM(timestamp);
+        ((PUINT32) customData)[1]++;
+        return STATUS_SUCCESS;
+    };
+    auto depay = [](PBYTE payload, UINT32 payloadLength, PBYTE outBuffer, PUINT32 pBufferSize, PBOOL pIsStart) -> STATUS {
+        if (outBuffer == NULL) {
+            sizeCalculationCount++;
+        }
+        return testDepayRtpFunc(payload, payloadLength, outBuffer, pBufferSize, pIsStart);
+    };
+
+    sizeCalculationCount = 0;
+    ASSERT_EQ(STATUS_SUCCESS,
+              jitter_buffer_create(onFrameReady, onFrameDropped, depay, DEFAULT_JITTER_BUFFER_MAX_LATENCY, TEST_JITTER_BUFFER_CLOCK_RATE,
+                                   (UINT64) counts, &pJitterBuffer));
+    for (i = 0; i < packetCount; i++) {
+        ASSERT_EQ(STATUS_SUCCESS,
+                  rtp_packet_create(2, FALSE, FALSE, 0, FALSE, 96, (UINT16) i, 5000 + i, 0x1234ABCD, NULL, 0, 0, NULL, NULL, 0, &pRtpPacket));
+        pRtpPacket->payloadLength = 1;
+        pRtpPacket->payload = (PBYTE) MEMALLOC(pRtpPacket->payloadLength + 1);
+        pRtpPacket->payload[0] = (BYTE) i;
+        pRtpPacket->payload[1] = i != 0; // First packet of a frame but for the first frame
+        pRtpPacket->pRawPacket = pRtpPacket->payload;
+        EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_push(pJitterBuffer, pRtpPacket, NULL));
+        // The packets behind the stalled head are not looked at again, each one is sized when it is pushed
+        EXPECT_EQ(i + 1, sizeCalculationCount);
+    }
+    EXPECT_EQ(0, counts[0]);
+    EXPECT_EQ(0, counts[1]);
+
+    EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_free(&pJitterBuffer));
+    EXPECT_EQ(packetCount - 1, counts[0]);
+    EXPECT_EQ(1, counts[1]);
+    EXPECT_EQ(packetCount, sizeCalculationCount);
+}
+
+TEST_F(JitterBufferFunctionalityTest, frameWithoutStartAfterDroppedFrameIsDropped)
+{
+    UINT32 i;
+    UINT32 pktCount = 4;
+    initializeJitterBuffer(1, 2, pktCount);
+
+    // First frame "1" "2" at timestamp 100 - rtp packet #0 #1, the next packet #2 is not received
+    mPRtpPackets[0]->payloadLength = 1;
+    mPRtpPackets[0]->payload = (PBYTE) MEMALLOC(mPRtpPackets[0]->payloadLength + 1);
+    mPRtpPackets[0]->payload[0] = 1;
+    mPRtpPackets[0]->payload[1] = 1; // First packet of a frame
+    mPRtpPackets[0]->header.timestamp = 100;
+    mPRtpPackets[0]->header.sequenceNumber = 0;
+    mPRtpPackets[1]->payloadLength = 1;
+    mPRtpPackets[1]->payload = (PBYTE) MEMALLOC(mPRtpPackets[1]->payloadLength + 1);
+    mPRtpPackets[1]->payload[0] = 2;
+    mPRtpPackets[1]->payload[1] = 0; // Following packet of a frame
+    mPRtpPackets[1]->header.timestamp = 100;
+    mPRtpPackets[1]->header.sequenceNumber = 1;
+
+    // Second frame "4" at timestamp 200 - rtp packet #3, its first packet #2 is not received
+    mPRtpPackets[2]->payloadLength = 1;
+    mPRtpPackets[2]->payload = (PBYTE) MEMALLOC(mPRtpPackets[2]->payloadLength + 1);
+    mPRtpPackets[2]->payload[0] = 4;
+    mPRtpPackets[2]->payload[1] = 0; // Following packet of a frame
+    mPRtpPackets[2]->header.timestamp = 200;
+    mPRtpPackets[2]->header.sequenceNumber = 3;
+
+    // Both are dropped once they expire, the second one has no start to be handed over with
+    mExpectedDroppedFrameTimestampArr[0] = 100;
+    mExpectedDroppedFrameTimestampArr[1] = 200;
+
+    // Third frame "5" at timestamp 3000 - rtp packet #4
+    mPRtpPackets[3]->payloadLength = 1;
+    mPRtpPackets[3]->payload = (PBYTE) MEMALLOC(mPRtpPackets[3]->payloadLength + 1);
+    mPRtpPackets[3]->payload[0] = 5;
+    mPRtpPackets[3]->payload[1] = 1; // First packet of a frame
+    mPRtpPackets[3]->header.timestamp = 3000;
+    mPRtpPackets[3]->header.sequenceNumber = 4;
+
+    // Expected to get frame "5" at close
+    mPExpectedFrameArr[0] = (PBYTE) MEMALLOC(1);
+    mPExpectedFrameArr[0][0] = 5;
+    mExpectedFrameSizeArr[0] = 1;
+
+    setPayloadToFree();
+
+    for (i = 0; i < pktCount; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_push(mJitterBuffer, mPRtpPackets[i], nullptr));
+        EXPECT_EQ(0, mReadyFrameIndex);
+        EXPECT_EQ(i == pktCount - 1 ? 2 : 0, mDroppedFrameIndex);
+    }
+
+    clearJitterBufferForTest();
+}
+
+TEST_F(JitterBufferFunctionalityTest, latePacketBehindTheHeadIsDiscarded)
+{
+    UINT32 i;
+    UINT32 pktCount = 4;
+    BOOL discarded;
+    initializeJitterBuffer(3, 0, pktCount);
+
+    // Frames "1" "2" "3" at timestamps 100 200 300 - rtp packets #0 #1 #3
+    for (i = 0; i < pktCount; i++) {
+        mPRtpPackets[i]->payloadLength = 1;
+        mPRtpPackets[i]->payload = (PBYTE) MEMALLOC(mPRtpPackets[i]->payloadLength + 1);
+        mPRtpPackets[i]->payload[1] = 1; // First packet of a frame
+    }
+    mPRtpPackets[0]->payload[0] = 1;
+    mPRtpPackets[0]->header.timestamp = 100;
+    mPRtpPackets[0]->header.sequenceNumber = 0;
+    mPRtpPackets[1]->payload[0] = 2;
+    mPRtpPackets[1]->header.timestamp = 200;
+    mPRtpPackets[1]->header.sequenceNumber = 1;
+    mPRtpPackets[3]->payload[0] = 3;
+    mPRtpPackets[3]->header.timestamp = 300;
+    mPRtpPackets[3]->header.sequenceNumber = 2;
+
+    // Packet #2 is a retransmission of the first frame, which is gone by then
+    mPRtpPackets[2]->payload[0] = 1;
+    mPRtpPackets[2]->header.timestamp = 100;
+    mPRtpPackets[2]->header.sequenceNumber = 0;
+
+    // Expected to get frames "1" "2" and "3" at close, the late packet neither makes a frame nor holds one back
+    for (i = 0; i < 3; i++) {
+        mPExpectedFrameArr[i] = (PBYTE) MEMALLOC(1);
+        mPExpectedFrameArr[i][0] = (BYTE) (i + 1);
+        mExpectedFrameSizeArr[i] = 1;
+    }
+
+    setPayloadToFree();
+
+    for (i = 0; i < pktCount; i++) {
+        discarded = FALSE;
+        EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_push(mJitterBuffer, mPRtpPackets[i], &discarded));
+        EXPECT_EQ(i == 2, discarded);
+        EXPECT_EQ(i == 0 ? 0 : i == 3 ? 2 : 1, mReadyFrameIndex);
+        EXPECT_EQ(0, mDroppedFrameIndex);
+    }
+
+    clearJitterBufferForTest();
+}
+
+TEST_F(JitterBufferFunctionalityTest, sequenceNumberJumpBackRestartsTheBuffer)
+{
+    UINT32 i;
+    UINT32 pktCount = 4;
+    UINT16 sequenceNumbers[] = {30000, 30001, 100, 101};
+    initializeJitterBuffer(4, 0, pktCount);
+
+    // Frames "1" "2" "3" "4" at timestamps 100 200 300 400, the sender starts over at sequence number 100 with frame "3"
+    for (i = 0; i < pktCount; i++) {
+        mPRtpPackets[i]->payloadLength = 1;
+        mPRtpPackets[i]->payload = (PBYTE) MEMALLOC(mPRtpPackets[i]->payloadLength + 1);
+        mPRtpPackets[i]->payload[0] = (BYTE) (i + 1);
+        mPRtpPackets[i]->payload[1] = 1; // First packet of a frame
+        mPRtpPackets[i]->header.timestamp = (i + 1) * 100;
+        mPRtpPackets[i]->header.sequenceNumber = sequenceNumbers[i];
+
+        mPExpectedFrameArr[i] = (PBYTE) MEMALLOC(1);
+        mPExpectedFrameArr[i][0] = (BYTE) (i + 1);
+        mExpectedFrameSizeArr[i] = 1;
+    }
+
+    setPayloadToFree();
+
+    // Frame "2" is flushed as soon as the jump shows, the frames after it follow the new sequence numbers
+    for (i = 0; i < pktCount; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_push(mJitterBuffer, mPRtpPackets[i], nullptr));
+        EXPECT_EQ(i, mReadyFrameIndex);
+        EXPECT_EQ(0, mDroppedFrameIndex);
+    }
+
+    clearJitterBufferForTest();
+}
+
+TEST_F(JitterBufferFunctionalityTest, adaptiveDelayFollowsJitter)
+{
+    // A single packet frame every 33 ms, received right on time
+    const UINT32 frameInterval = 33, steadyFrameCount = 300;
+    PJitterBuffer pJitterBuffer = NULL;
+    UINT32 i, timestamp = 5000, counts[2] = {0, 0};
+
+    auto onFrameReady = [](UINT64 customData, UINT16 startIndex, UINT16 endIndex, UINT32 frameSize) -> STATUS {
+        UNUSED_PARAM(startIndex);
+        UNUSED_PARAM(endIndex);
+        UNUSED_PARAM(frameSize);
+        ((PUINT32) customData)[0]++;
+        return STATUS_SUCCESS;
+    };
+    auto onFrameDropped = [](UINT64 customData, UINT16 startIndex, UINT16 endIndex, UINT32 timestamp) -> STATUS {
+        UNUSED_PARAM(startIndex);
+        UNUSED_PARAM(endIndex);
+        UNUSED_PARAM(timestamp);
+        ((PUINT32) customData)[1]++;
+        return STATUS_SUCCESS;
+    };
+    // The clock rate is 1000, so a timestamp is a millisecond
+    auto push = [](PJitterBuffer pJitterBuffer, UINT16 seq, UINT32 timestamp, BOOL isStart) -> STATUS {
+        PRtpPacket pRtpPacket = NULL;
+        STATUS retStatus = rtp_packet_create(2, FALSE, FALSE, 0, FALSE, 96, seq, timestamp, 0x1234ABCD, NULL, 0, 0, NULL, NULL, 0, &pRtpPacket);
+        if (STATUS_SUCCEEDED(retStatus)) {
+            pRtpPacket->payloadLength = 1;
+            pRtpPacket->payload = (PBYTE) MEMALLOC(pRtpPacket->payloadLength + 1);
+            pRtpPacket->payload[0] = (BYTE) seq;
+            pRtpPacket->payload[1] = isStart;
+            pRtpPacket->pRawPacket = pRtpPacket->payload;
+            pRtpPacket->receivedTime = (UINT64) timestamp * HUNDREDS_OF_NANOS_IN_A_MILLISECOND;
+            retStatus = jitter_buffer_push(pJitterBuffer, pRtpPacket, NULL);
+        }
+        return retStatus;
+    };
+
+    ASSERT_EQ(STATUS_SUCCESS,
+              jitter_buffer_create(onFrameReady, onFrameDropped, testDepayRtpFunc, DEFAULT_JITTER_BUFFER_MAX_LATENCY, TEST_JITTER_BUFFER_CLOCK_RATE,
+                                   (UINT64) counts, &pJitterBuffer));
+    EXPECT_EQ(STATUS_NULL_ARG, jitter_buffer_enableAdaptiveDelay(NULL, 0));
+    EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_enableAdaptiveDelay(pJitterBuffer, 0));
+    EXPECT_EQ(DEFAULT_JITTER_BUFFER_MIN_TARGET_DELAY, pJitterBuffer->targetDelay);
+
+    // Without jitter and with frames of the same size the target delay falls to its floor
+    for (i = 0; i < steadyFrameCount; i++, timestamp += frameInterval) {
+        EXPECT_EQ(STATUS_SUCCESS, push(pJitterBuffer, (UINT16) i, timestamp, TRUE));
+    }
+    EXPECT_EQ(steadyFrameCount - 1, counts[0]);
+    EXPECT_EQ(0, pJitterBuffer->minimumDelay);
+    EXPECT_LE(DEFAULT_JITTER_BUFFER_MIN_TARGET_DELAY, pJitterBuffer->targetDelay);
+    EXPECT_GT(DEFAULT_JITTER_BUFFER_MIN_TARGET_DELAY + 5 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND, pJitterBuffer->targetDelay);
+
+    // A frame missing its second packet is dropped as soon as the next frame is more than the target delay later
+    EXPECT_EQ(STATUS_SUCCESS, push(pJitterBuffer, (UINT16) i, timestamp, TRUE));
+    timestamp += frameInterval;
+    EXPECT_EQ(STATUS_SUCCESS, push(pJitterBuffer, (UINT16) (i + 2), timestamp, TRUE));
+    timestamp += frameInterval;
+    EXPECT_EQ(steadyFrameCount, counts[0]);
+    EXPECT_EQ(1, counts[1]);
+
+    // 100 ms of interarrival jitter raise the target delay at once
+    pJitterBuffer->jitter = 100;
+    EXPECT_EQ(STATUS_SUCCESS, push(pJitterBuffer, (UINT16) (i + 3), timestamp, TRUE));
+    EXPECT_EQ(steadyFrameCount + 1, counts[0]);
+    EXPECT_EQ(JITTER_BUFFER_JITTER_MULTIPLIER * 100 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND, pJitterBuffer->minimumDelay);
+    EXPECT_EQ(pJitterBuffer->minimumDelay, pJitterBuffer->targetDelay);
+
+    EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_free(&pJitterBuffer));
+    EXPECT_EQ(steadyFrameCount + 2, counts[0]);
+    EXPECT_EQ(1, counts[1]);
+}
+
+TEST_F(JitterBufferFunctionalityTest, playoutHoldsCompleteFramesUntilTheTargetDelay)
+{
+    // A single packet frame every 33 ms, the sixth one 35 ms late
+    const UINT32 frameCount = 7;
+    const UINT32 timestamps[] = {5000, 5033, 5066, 5099, 5132, 5165, 5198};
+    const UINT32 arrivals[] = {5000, 5033, 5066, 5099, 5132, 5200, 5232};
+    // Every frame goes 100 ms after the arrival its timestamp calls for, so the late one does not hold back the frames after it
+    const UINT32 expectedReadyCounts[] = {0, 0, 0, 0, 1, 4, 5};
+    PJitterBuffer pJitterBuffer = NULL;
+    UINT32 i, counts[2] = {0, 0};
+
+    auto onFrameReady = [](UINT64 customData, UINT16 startIndex, UINT16 endIndex, UINT32 frameSize) -> STATUS {
+        UNUSED_PARAM(startIndex);
+        UNUSED_PARAM(endIndex);
+        UNUSED_PARAM(frameSize);
+        ((PUINT32) customData)[0]++;
+        return STATUS_SUCCESS;
+    };
+    auto onFrameDropped = [](UINT64 customData, UINT16 startIndex, UINT16 endIndex, UINT32 timestamp) -> STATUS {
+        UNUSED_PARAM(startIndex);
+        UNUSED_PARAM(endIndex);
+        UNUSED_PARAM(timestamp);
+        ((PUINT32) customData)[1]++;
+        return STATUS_SUCCESS;
+    };
+    // The clock rate is 1000, so a timestamp is a millisecond
+    auto push = [](PJitterBuffer pJitterBuffer, UINT16 seq, UINT32 timestamp, UINT32 arrival) -> STATUS {
+        PRtpPacket pRtpPacket = NULL;
+        STATUS retStatus = rtp_packet_create(2, FALSE, FALSE, 0, FALSE, 96, seq, timestamp, 0x1234ABCD, NULL, 0, 0, NULL, NULL, 0, &pRtpPacket);
+        if (STATUS_SUCCEEDED(retStatus)) {
+            pRtpPacket->payloadLength = 1;
+            pRtpPacket->payload = (PBYTE) MEMALLOC(pRtpPacket->payloadLength + 1);
+            pRtpPacket->payload[0] = (BYTE) seq;
+            pRtpPacket->payload[1] = TRUE;
+            pRtpPacket->pRawPacket = pRtpPacket->payload;
+            pRtpPacket->receivedTime = (UINT64) arrival * HUNDREDS_OF_NANOS_IN_A_MILLISECOND;
+            retStatus = jitter_buffer_push(pJitterBuffer, pRtpPacket, NULL);
+        }
+        return retStatus;
+    };
+
+    ASSERT_EQ(STATUS_SUCCESS,
+              jitter_buffer_create(onFrameReady, onFrameDropped, testDepayRtpFunc, DEFAULT_JITTER_BUFFER_MAX_LATENCY, TEST_JITTER_BUFFER_CLOCK_RATE,
+                                   (UINT64) counts, &pJitterBuffer));
+    EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_enableAdaptiveDelay(pJitterBuffer, 100 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND));
+
+    for (i = 0; i < frameCount; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, push(pJitterBuffer, (UINT16) i, timestamps[i], arrivals[i]));
+        EXPECT_EQ(expectedReadyCounts[i], counts[0]);
+        EXPECT_EQ(100 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND, pJitterBuffer->targetDelay);
+    }
+
+    // The held frames go when the buffer is freed
+    EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_free(&pJitterBuffer));
+    EXPECT_EQ(frameCount, counts[0]);
+    EXPECT_EQ(0, counts[1]);
+}
+
+TEST_F(JitterBufferFunctionalityTest, reorderedPushThroughput)
+{
+    // 30 frames per second of 3 packets each, every other pair of packets swapped
+    const UINT32 frameCount = 10000, packetsPerFrame = 3, packetCount = frameCount * packetsPerFrame;
+    PRtpPacket* pPackets = (PRtpPacket*) MEMALLOC(SIZEOF(PRtpPacket) * packetCount);
+    PJitterBuffer pJitterBuffer = NULL;
+    UINT32 i, arrival, ringMask;
+    // the frames handed over, the frames handed over with other bounds than expected and the dropped frames
+    UINT32 counts[3] = {0, 0, 0};
+    UINT64 start, pushTime;
+    SIZE_T allocationCount;
+    std::clock_t cpuStart, pushCpu;
+
+    auto onFrameReady = [](UINT64 customData, UINT16 startIndex, UINT16 endIndex, UINT32 frameSize) -> STATUS {
+        PUINT32 counts = (PUINT32) customData;
+        UINT16 expectedStart = (UINT16) (counts[0] * 3);
+        if (startIndex != expectedStart || endIndex != (UINT16) (expectedStart + 2) || frameSize != 3) {
+            counts[1]++;
+        }
+        counts[0]++;
+        return STATUS_SUCCESS;
+    };
+    auto onFrameDropped = [](UINT64 customData, UINT16 startIndex, UINT16 endIndex, UINT32 timestamp) -> STATUS {
+        UNUSED_PARAM(startIndex);
+        UNUSED_PARAM(endIndex);
+        UNUSED_PARAM(timestamp);
+        ((PUINT32) customData)[2]++;
+        return STATUS_SUCCESS;
+    };
+
+    for (i = 0; i < packetCount; i++) {
+        arrival = (i % 4 == 1) ? i + 1 : (i % 4 == 2) ? i - 1 : i;
+        ASSERT_EQ(STATUS_SUCCESS,
+                  rtp_packet_create(2, FALSE, FALSE, 0, FALSE, 96, (UINT16) arrival, arrival / packetsPerFrame * 33, 0x1234ABCD, NULL, 0, 0,
+                                    NULL, NULL, 0, pPackets + i));
+        pPackets[i]->payloadLength = 1;
+        pPackets[i]->payload = (PBYTE) MEMALLOC(pPackets[i]->payloadLength + 1);
+        pPackets[i]->payload[0] = (BYTE) arrival;
+        pPackets[i]->payload[1] = arrival % packetsPerFrame == 0;
+        pPackets[i]->pRawPacket = pPackets[i]->payload;
+    }
+
+    ASSERT_EQ(STATUS_SUCCESS,
+              jitter_buffer_create(onFrameReady, onFrameDropped, testDepayRtpFunc, DEFAULT_JITTER_BUFFER_MAX_LATENCY, TEST_JITTER_BUFFER_CLOCK_RATE,
+                                   (UINT64) counts, &pJitterBuffer));
+    ringMask = pJitterBuffer->ringMask;
+
+    // A push stores the packet in its slot and walks the frames it completes, nothing is allocated
+    allocationCount = getInstrumentedTotalAllocationCount();
+    start = GETTIME();
+    cpuStart = std::clock();
+    for (i = 0; i < packetCount; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_push(pJitterBuffer, pPackets[i], NULL));
+    }
+    pushCpu = std::clock() - cpuStart;
+    pushTime = GETTIME() - start;
+    EXPECT_EQ(allocationCount, getInstrumentedTotalAllocationCount());
+    EXPECT_EQ(ringMask, pJitterBuffer->ringMask);
+
+    // Every frame but the last one, which waits for the next frame to be known as complete, is handed over in order and whole
+    EXPECT_EQ(frameCount - 1, counts[0]);
+    EXPECT_EQ(STATUS_SUCCESS, jitter_buffer_free(&pJitterBuffer));
+    EXPECT_EQ(frameCount, counts[0]);
+    EXPECT_EQ(0, counts[1]);
+    EXPECT_EQ(0, counts[2]);
+
+    DLOGI("Pushed %u reordered packets, %" PRIu64 " packets/s, %" PRIu64 " ms cpu", packetCount,
+          (UINT64) packetCount * HUNDREDS_OF_NANOS_IN_A_SECOND / MAX(pushTime, 1), (UINT64) pushCpu * 1000 / CLOCKS_PER_SEC);
+
+    MEMFREE(pPackets);
+}
+
 } // namespace webrtcclient
 } // namespace video
 } // namespace kinesis
@@ -0,0 +1,162 @@
+#include "WebRTCClientTestFixture.h"
+
+namespace com {
+namespace amazonaws {
+namespace kinesis {
+namespace video {
+namespace webrtcclient {
+
+class NackGeneratorFunctionalityTest : public WebRtcClientTestBase {
+};
+
+#define NACK_TEST_START_TIME (10 * HUNDREDS_OF_NANOS_IN_A_SECOND)
+#define NACK_TEST_MS(t)      (NACK_TEST_START_TIME + (t) * HUNDREDS_OF_NANOS_IN_A_MILLISECOND)
+
+TEST_F(NackGeneratorFunctionalityTest, nacksLostPacketsAfterReorderGraceTime)
+{
+    PNackGenerator pNackGenerator = NULL;
+    BYTE nack[NACK_MAX_LEN];
+    UINT32 i, nackLen = 0;
+    UINT16 seqNums[] = {65533, 65535, 2, 20, 40};
+
+    EXPECT_EQ(STATUS_NULL_ARG, nack_generator_create(0x1111, 0x1234ABCD, NULL));
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_create(0x1111, 0x1234ABCD, &pNackGenerator));
+    // 65534, 0, 1, 3 to 19 and 21 to 39 are missing
+    for (i = 0; i < ARRAY_SIZE(seqNums); i++) {
+        EXPECT_EQ(STATUS_SUCCESS, nack_generator_onPacketReceived(pNackGenerator, seqNums[i], NACK_TEST_MS(0)));
+    }
+    EXPECT_EQ(39, pNackGenerator->missingCount);
+
+    // Not yet, the packets may only be reordered
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_createNack(pNackGenerator, NACK_TEST_MS(5), 0, nack, &nackLen));
+    EXPECT_EQ(0, nackLen);
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_onPacketReceived(pNackGenerator, 0, NACK_TEST_MS(6)));
+
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_createNack(pNackGenerator, NACK_TEST_MS(10), 0, nack, &nackLen));
+    EXPECT_EQ(RTCP_PACKET_HEADER_LEN + NACK_HEADER_LEN + 3 * NACK_ITEM_LEN, nackLen);
+    EXPECT_EQ(RTCP_FEEDBACK_MESSAGE_TYPE_NACK, nack[0] & 0x1F);
+    EXPECT_EQ(RTCP_PACKET_TYPE_GENERIC_RTP_FEEDBACK, nack[RTCP_PACKET_TYPE_OFFSET]);
+    EXPECT_EQ(nackLen / RTCP_PACKET_LEN_WORD_SIZE - 1, getUnalignedInt16BigEndian(nack + RTCP_PACKET_LEN_OFFSET));
+    EXPECT_EQ(0x1111, getUnalignedInt32BigEndian(nack + RTCP_PACKET_HEADER_LEN));
+    EXPECT_EQ(0x1234ABCD, getUnalignedInt32BigEndian(nack + RTCP_PACKET_HEADER_LEN + 4));
+    // 65534 with 1 and 3 to 14, 15 with 16 to 19 and 21 to 31, 32 with 33 to 39
+    EXPECT_EQ(65534, (UINT16) getUnalignedInt16BigEndian(nack + RTCP_PACKET_HEADER_LEN + NACK_HEADER_LEN));
+    EXPECT_EQ(0xFFF4, (UINT16) getUnalignedInt16BigEndian(nack + RTCP_PACKET_HEADER_LEN + NACK_HEADER_LEN + 2));
+    EXPECT_EQ(15, getUnalignedInt16BigEndian(nack + RTCP_PACKET_HEADER_LEN + NACK_HEADER_LEN + 4));
+    EXPECT_EQ(0xFFEF, (UINT16) getUnalignedInt16BigEndian(nack + RTCP_PACKET_HEADER_LEN + NACK_HEADER_LEN + 6));
+    EXPECT_EQ(32, getUnalignedInt16BigEndian(nack + RTCP_PACKET_HEADER_LEN + NACK_HEADER_LEN + 8));
+    EXPECT_EQ(0x007F, (UINT16) getUnalignedInt16BigEndian(nack + RTCP_PACKET_HEADER_LEN + NACK_HEADER_LEN + 10));
+
+    // Asked for again a round trip time later
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_createNack(pNackGenerator, NACK_TEST_MS(20), 50 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND, nack, &nackLen));
+    EXPECT_EQ(0, nackLen);
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_onPacketReceived(pNackGenerator, 65534, NACK_TEST_MS(30)));
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_createNack(pNackGenerator, NACK_TEST_MS(60), 50 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND, nack, &nackLen));
+    EXPECT_EQ(RTCP_PACKET_HEADER_LEN + NACK_HEADER_LEN + 3 * NACK_ITEM_LEN, nackLen);
+    EXPECT_EQ(1, getUnalignedInt16BigEndian(nack + RTCP_PACKET_HEADER_LEN + NACK_HEADER_LEN));
+    EXPECT_EQ(0xFFFE, (UINT16) getUnalignedInt16BigEndian(nack + RTCP_PACKET_HEADER_LEN + NACK_HEADER_LEN + 2));
+
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_free(&pNackGenerator));
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_free(&pNackGenerator));
+}
+
+TEST_F(NackGeneratorFunctionalityTest, givesUpOnPacketsAfterRetriesOrAge)
+{
+    PNackGenerator pNackGenerator = NULL;
+    BYTE nack[NACK_MAX_LEN];
+    UINT32 t, nackLen = 0, nackCount = 0;
+
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_create(0x1111, 0x1234ABCD, &pNackGenerator));
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_onPacketReceived(pNackGenerator, 0, NACK_TEST_MS(0)));
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_onPacketReceived(pNackGenerator, 2, NACK_TEST_MS(0)));
+    for (t = 10; t < 500; t += 10) {
+        EXPECT_EQ(STATUS_SUCCESS,
+                  nack_generator_createNack(pNackGenerator, NACK_TEST_MS(t), 10 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND, nack, &nackLen));
+        nackCount += nackLen > 0 ? 1 : 0;
+    }
+    EXPECT_EQ(NACK_MAX_RETRIES, nackCount);
+    EXPECT_EQ(0, pNackGenerator->missingCount);
+
+    // A retransmission asked for now would arrive too late
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_onPacketReceived(pNackGenerator, 4, NACK_TEST_MS(1000)));
+    EXPECT_EQ(STATUS_SUCCESS,
+              nack_generator_createNack(pNackGenerator, NACK_TEST_MS(1010), 600 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND, nack, &nackLen));
+    EXPECT_LT(0, nackLen);
+    EXPECT_EQ(STATUS_SUCCESS,
+              nack_generator_createNack(pNackGenerator, NACK_TEST_MS(1610), 600 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND, nack, &nackLen));
+    EXPECT_EQ(0, nackLen);
+    EXPECT_EQ(0, pNackGenerator->missingCount);
+
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_free(&pNackGenerator));
+}
+
+TEST_F(NackGeneratorFunctionalityTest, leavesLargeGapsToKeyFrames)
+{
+    PNackGenerator pNackGenerator = NULL;
+    BYTE nack[NACK_MAX_LEN];
+    UINT32 nackLen = 0;
+
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_create(0x1111, 0x1234ABCD, &pNackGenerator));
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_onPacketReceived(pNackGenerator, 100, NACK_TEST_MS(0)));
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_onPacketReceived(pNackGenerator, 100 + NACK_MAX_MISSING_PACKETS, NACK_TEST_MS(0)));
+    EXPECT_EQ(NACK_MAX_MISSING_PACKETS - 1, pNackGenerator->missingCount);
+    // The oldest lost packet makes room for the newest one
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_onPacketReceived(pNackGenerator, 103 + NACK_MAX_MISSING_PACKETS, NACK_TEST_MS(0)));
+    EXPECT_EQ(NACK_MAX_MISSING_PACKETS, pNackGenerator->missingCount);
+    EXPECT_EQ(102, pNackGenerator->missingPackets[0].sequenceNumber);
+
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_onPacketReceived(pNackGenerator, 104 + 2 * NACK_MAX_MISSING_PACKETS, NACK_TEST_MS(0)));
+    EXPECT_EQ(0, pNackGenerator->missingCount);
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_createNack(pNackGenerator, NACK_TEST_MS(100), 0, nack, &nackLen));
+    EXPECT_EQ(0, nackLen);
+
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_free(&pNackGenerator));
+}
+
+TEST_F(NackGeneratorFunctionalityTest, measuresRoundTripTimeOnNackedPackets)
+{
+    PNackGenerator pNackGenerator = NULL;
+    BYTE nack[NACK_MAX_LEN];
+    UINT32 nackLen = 0;
+    UINT64 roundTripTime = 1;
+    UINT16 seqNum;
+
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_create(0x1111, 0x1234ABCD, &pNackGenerator));
+    EXPECT_EQ(STATUS_NULL_ARG, nack_generator_getRoundTripTime(NULL, &roundTripTime));
+    EXPECT_EQ(STATUS_NULL_ARG, nack_generator_getRoundTripTime(pNackGenerator, NULL));
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_getRoundTripTime(pNackGenerator, &roundTripTime));
+    EXPECT_EQ(0, roundTripTime);
+
+    // 1, 3 and 5 are missing and asked for once
+    for (seqNum = 0; seqNum <= 6; seqNum += 2) {
+        EXPECT_EQ(STATUS_SUCCESS, nack_generator_onPacketReceived(pNackGenerator, seqNum, NACK_TEST_MS(0)));
+    }
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_createNack(pNackGenerator, NACK_TEST_MS(10), 0, nack, &nackLen));
+    EXPECT_LT(0, nackLen);
+
+    // The first retransmission is taken as is, the next ones are smoothed
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_onPacketReceived(pNackGenerator, 1, NACK_TEST_MS(50)));
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_getRoundTripTime(pNackGenerator, &roundTripTime));
+    EXPECT_EQ(40 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND, roundTripTime);
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_onPacketReceived(pNackGenerator, 3, NACK_TEST_MS(90)));
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_getRoundTripTime(pNackGenerator, &roundTripTime));
+    EXPECT_EQ(45 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND, roundTripTime);
+
+    // A packet asked for twice may answer either nack, one never asked for was only reordered
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_createNack(pNackGenerator, NACK_TEST_MS(110), 50 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND, nack, &nackLen));
+    EXPECT_LT(0, nackLen);
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_onPacketReceived(pNackGenerator, 5, NACK_TEST_MS(120)));
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_onPacketReceived(pNackGenerator, 8, NACK_TEST_MS(130)));
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_onPacketReceived(pNackGenerator, 7, NACK_TEST_MS(132)));
+    EXPECT_EQ(0, pNackGenerator->missingCount);
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_getRoundTripTime(pNackGenerator, &roundTripTime));
+    EXPECT_EQ(45 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND, roundTripTime);
+
+    EXPECT_EQ(STATUS_SUCCESS, nack_generator_free(&pNackGenerator));
+}
+
+} // namespace webrtcclient
+} // namespace video
+} // namespace kinesis
+} // namespace amazonaws
+} // namespace com
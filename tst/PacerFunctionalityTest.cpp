@@ -0,0 +1,225 @@
+#include "WebRTCClientTestFixture.h"
+
+namespace com {
+namespace amazonaws {
+namespace kinesis {
+namespace video {
+namespace webrtcclient {
+
+class PacerFunctionalityTest : public WebRtcClientTestBase {
+};
+
+static UINT32 pacerSendCallCount;
+static UINT32 pacerSentPacketCount;
+static UINT32 pacerDiscardedPacketCount;
+static UINT32 pacerUnsentPacketCount;
+static UINT64 pacerTotalSendDelay;
+static BOOL pacerCandidatePairSelected;
+static UINT32 pacerSocketCapacity;
+
+// Sends up to pacerSocketCapacity packets of every batch and fails the rest, nothing at all without a selected candidate pair
+static STATUS testPacerSend(UINT64 customData, PBYTE* ppBufs, PUINT32 pBufLens, UINT32 count, PUINT32 pSentCount, PUINT32 pDiscardedCount)
+{
+    UNUSED_PARAM(customData);
+    UNUSED_PARAM(ppBufs);
+    UNUSED_PARAM(pBufLens);
+    pacerSendCallCount++;
+    *pSentCount = 0;
+    *pDiscardedCount = 0;
+    if (pacerCandidatePairSelected) {
+        *pSentCount = MIN(count, pacerSocketCapacity);
+        *pDiscardedCount = count - *pSentCount;
+    }
+    return STATUS_SUCCESS;
+}
+
+static VOID testPacerOnPacketSent(UINT64 customData, PRtpPacket pRtpPacket, UINT32 packetLen, UINT64 sendDelay, BOOL sent, BOOL discarded)
+{
+    UNUSED_PARAM(customData);
+    UNUSED_PARAM(pRtpPacket);
+    UNUSED_PARAM(packetLen);
+    EXPECT_FALSE(sent && discarded);
+    if (sent) {
+        pacerSentPacketCount++;
+        pacerTotalSendDelay += sendDelay;
+    } else if (discarded) {
+        pacerDiscardedPacketCount++;
+    } else {
+        pacerUnsentPacketCount++;
+    }
+}
+
+static PPacer createTestPacer(TIMER_QUEUE_HANDLE timerQueueHandle, UINT32 queueSize)
+{
+    PPacer pPacer = NULL;
+
+    pacerSendCallCount = 0;
+    pacerSentPacketCount = 0;
+    pacerDiscardedPacketCount = 0;
+    pacerUnsentPacketCount = 0;
+    pacerTotalSendDelay = 0;
+    pacerCandidatePairSelected = TRUE;
+    pacerSocketCapacity = MAX_UINT32;
+    EXPECT_EQ(STATUS_SUCCESS, pacer_create(queueSize, 1.0, timerQueueHandle, testPacerSend, testPacerOnPacketSent, 0, &pPacer));
+    // The test drives the pacer clock
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_cancelTimer(timerQueueHandle, pPacer->timerId, (UINT64) pPacer));
+    pPacer->timerId = MAX_UINT32;
+    // 500 bytes every drain interval
+    EXPECT_EQ(STATUS_SUCCESS, pacer_setTargetBitrate(pPacer, 800000));
+    return pPacer;
+}
+
+TEST_F(PacerFunctionalityTest, packetsLeaveAtTheTargetBitrate)
+{
+    TIMER_QUEUE_HANDLE timerQueueHandle = INVALID_TIMER_QUEUE_HANDLE_VALUE;
+    PRtpPacketPool pRtpPacketPool = NULL;
+    PPacer pPacer = NULL;
+    PRtpPacket pRtpPackets[10] = {NULL};
+    UINT32 packetLens[10];
+    UINT32 i, queuedCount = 0;
+    UINT64 now = GETTIME();
+
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_create(&timerQueueHandle));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_create(ARRAY_SIZE(pRtpPackets), 1000, &pRtpPacketPool));
+    pPacer = createTestPacer(timerQueueHandle, DEFAULT_PACER_QUEUE_SIZE);
+
+    for (i = 0; i < ARRAY_SIZE(pRtpPackets); i++) {
+        EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_get(pRtpPacketPool, 1000, &pRtpPackets[i]));
+        packetLens[i] = 1000;
+    }
+    EXPECT_EQ(STATUS_SUCCESS, pacer_enqueue(pPacer, 0, pRtpPackets, packetLens, ARRAY_SIZE(pRtpPackets), &queuedCount));
+    EXPECT_EQ(ARRAY_SIZE(pRtpPackets), queuedCount);
+    // The pacer holds its own references
+    for (i = 0; i < ARRAY_SIZE(pRtpPackets); i++) {
+        EXPECT_EQ(STATUS_SUCCESS, rtp_packet_free(&pRtpPackets[i]));
+    }
+
+    // A packet overshoots the budget of an interval, so the next interval only pays it back
+    EXPECT_EQ(STATUS_SUCCESS, pacer_drain(pPacer, now));
+    EXPECT_EQ(1, pacerSentPacketCount);
+    EXPECT_EQ(STATUS_SUCCESS, pacer_drain(pPacer, now + PACER_DRAIN_INTERVAL));
+    EXPECT_EQ(1, pacerSentPacketCount);
+    EXPECT_EQ(STATUS_SUCCESS, pacer_drain(pPacer, now + 2 * PACER_DRAIN_INTERVAL));
+    EXPECT_EQ(2, pacerSentPacketCount);
+    EXPECT_EQ(8, pPacer->packetCount);
+
+    // A late drain does not make up for the whole gap, the budget is capped to PACER_MAX_BURST_DURATION
+    EXPECT_EQ(STATUS_SUCCESS, pacer_drain(pPacer, now + 2 * PACER_DRAIN_INTERVAL + 80 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND));
+    EXPECT_EQ(3, pacerSentPacketCount);
+    for (i = 1; i <= 20 && pacerSentPacketCount < ARRAY_SIZE(pRtpPackets); i++) {
+        EXPECT_EQ(STATUS_SUCCESS,
+                  pacer_drain(pPacer, now + 2 * PACER_DRAIN_INTERVAL + 80 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND + i * PACER_DRAIN_INTERVAL));
+    }
+    EXPECT_EQ(ARRAY_SIZE(pRtpPackets), pacerSentPacketCount);
+    EXPECT_EQ(0, pacerDiscardedPacketCount);
+    EXPECT_EQ(0, pPacer->packetCount);
+
+    EXPECT_EQ(STATUS_SUCCESS, pacer_free(&pPacer));
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_free(&timerQueueHandle));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_free(&pRtpPacketPool));
+}
+
+TEST_F(PacerFunctionalityTest, idlePacerDoesNotBurst)
+{
+    TIMER_QUEUE_HANDLE timerQueueHandle = INVALID_TIMER_QUEUE_HANDLE_VALUE;
+    PPacer pPacer = NULL;
+    UINT64 now = GETTIME();
+
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_create(&timerQueueHandle));
+    pPacer = createTestPacer(timerQueueHandle, DEFAULT_PACER_QUEUE_SIZE);
+
+    EXPECT_EQ(STATUS_SUCCESS, pacer_drain(pPacer, now));
+    EXPECT_EQ(STATUS_SUCCESS, pacer_drain(pPacer, now + HUNDREDS_OF_NANOS_IN_A_SECOND));
+    // Capped at PACER_MAX_BURST_DURATION worth of bytes
+    EXPECT_EQ(1000, pPacer->budget);
+    EXPECT_EQ(0, pacerSendCallCount);
+
+    EXPECT_EQ(STATUS_SUCCESS, pacer_free(&pPacer));
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_free(&timerQueueHandle));
+}
+
+TEST_F(PacerFunctionalityTest, fullQueueRejectsPacketsAndFreeReleasesQueued)
+{
+    TIMER_QUEUE_HANDLE timerQueueHandle = INVALID_TIMER_QUEUE_HANDLE_VALUE;
+    PRtpPacketPool pRtpPacketPool = NULL;
+    PPacer pPacer = NULL;
+    PRtpPacket pRtpPackets[6] = {NULL};
+    UINT32 packetLens[6];
+    RtcRtpPacketPoolStats stats;
+    UINT32 i, queuedCount = 0;
+
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_create(&timerQueueHandle));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_create(ARRAY_SIZE(pRtpPackets), 1000, &pRtpPacketPool));
+    pPacer = createTestPacer(timerQueueHandle, 4);
+
+    EXPECT_NE(STATUS_SUCCESS, pacer_enqueue(NULL, 0, pRtpPackets, packetLens, ARRAY_SIZE(pRtpPackets), &queuedCount));
+    for (i = 0; i < ARRAY_SIZE(pRtpPackets); i++) {
+        EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_get(pRtpPacketPool, 1000, &pRtpPackets[i]));
+        packetLens[i] = 1000;
+    }
+    EXPECT_EQ(STATUS_SUCCESS, pacer_enqueue(pPacer, 0, pRtpPackets, packetLens, ARRAY_SIZE(pRtpPackets), &queuedCount));
+    EXPECT_EQ(4, queuedCount);
+    for (i = 0; i < ARRAY_SIZE(pRtpPackets); i++) {
+        EXPECT_EQ(STATUS_SUCCESS, rtp_packet_free(&pRtpPackets[i]));
+    }
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_getStats(pRtpPacketPool, &stats));
+    EXPECT_EQ(4, stats.packetsInUse);
+
+    EXPECT_EQ(STATUS_SUCCESS, pacer_free(&pPacer));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_getStats(pRtpPacketPool, &stats));
+    EXPECT_EQ(0, stats.packetsInUse);
+    EXPECT_EQ(0, pacerSendCallCount);
+
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_free(&timerQueueHandle));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_free(&pRtpPacketPool));
+}
+
+TEST_F(PacerFunctionalityTest, onlySocketFailuresAreDiscarded)
+{
+    TIMER_QUEUE_HANDLE timerQueueHandle = INVALID_TIMER_QUEUE_HANDLE_VALUE;
+    PRtpPacketPool pRtpPacketPool = NULL;
+    PPacer pPacer = NULL;
+    PRtpPacket pRtpPackets[4] = {NULL};
+    UINT32 packetLens[4];
+    UINT32 i, queuedCount = 0;
+    UINT64 now = GETTIME();
+
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_create(&timerQueueHandle));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_create(ARRAY_SIZE(pRtpPackets), 100, &pRtpPacketPool));
+    pPacer = createTestPacer(timerQueueHandle, DEFAULT_PACER_QUEUE_SIZE);
+
+    for (i = 0; i < ARRAY_SIZE(pRtpPackets); i++) {
+        EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_get(pRtpPacketPool, 100, &pRtpPackets[i]));
+        packetLens[i] = 100;
+    }
+
+    // Without a selected candidate pair the packets leave the queue unsent, they are not discarded by the transport
+    pacerCandidatePairSelected = FALSE;
+    EXPECT_EQ(STATUS_SUCCESS, pacer_enqueue(pPacer, 0, pRtpPackets, packetLens, 2, &queuedCount));
+    EXPECT_EQ(STATUS_SUCCESS, pacer_drain(pPacer, now));
+    EXPECT_EQ(0, pacerSentPacketCount);
+    EXPECT_EQ(0, pacerDiscardedPacketCount);
+    EXPECT_EQ(2, pacerUnsentPacketCount);
+
+    // The packets the socket fails to send are discarded
+    pacerCandidatePairSelected = TRUE;
+    pacerSocketCapacity = 1;
+    EXPECT_EQ(STATUS_SUCCESS, pacer_enqueue(pPacer, 0, pRtpPackets + 2, packetLens + 2, 2, &queuedCount));
+    EXPECT_EQ(STATUS_SUCCESS, pacer_drain(pPacer, now + PACER_DRAIN_INTERVAL));
+    EXPECT_EQ(1, pacerSentPacketCount);
+    EXPECT_EQ(1, pacerDiscardedPacketCount);
+    EXPECT_EQ(2, pacerUnsentPacketCount);
+
+    for (i = 0; i < ARRAY_SIZE(pRtpPackets); i++) {
+        EXPECT_EQ(STATUS_SUCCESS, rtp_packet_free(&pRtpPackets[i]));
+    }
+    EXPECT_EQ(STATUS_SUCCESS, pacer_free(&pPacer));
+    EXPECT_EQ(STATUS_SUCCESS, timer_queue_free(&timerQueueHandle));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_free(&pRtpPacketPool));
+}
+
+} // namespace webrtcclient
+} // namespace video
+} // namespace kinesis
+} // namespace amazonaws
+} // namespace com
@@ -296,6 +296,253 @@ TEST_F(RtcpFunctionalityTest, onpli)
     pc_free(&pRtcPeerConnection);
 }
 
+TEST_F(RtcpFunctionalityTest, receiveStatisticsReportBlock)
+{
+    ReceiveStatistics receiveStatistics{};
+    BYTE reportBlock[RTCP_PACKET_RECEIVER_REPORT_BLOCK_LEN];
+    UINT64 now = 10 * HUNDREDS_OF_NANOS_IN_A_SECOND;
+
+    EXPECT_EQ(STATUS_INVALID_OPERATION, receive_statistics_createReportBlock(&receiveStatistics, 0x1234, 0, now, reportBlock));
+
+    // 0 and 1 are missing across the wrap
+    receive_statistics_onPacket(&receiveStatistics, 65534);
+    receive_statistics_onPacket(&receiveStatistics, 65535);
+    receive_statistics_onPacket(&receiveStatistics, 2);
+    receive_statistics_onPacket(&receiveStatistics, 3);
+    receive_statistics_onSenderReport(&receiveStatistics, 0x0123456789ABCDEFULL, now);
+    EXPECT_EQ(2, receive_statistics_getPacketsLost(&receiveStatistics));
+
+    EXPECT_EQ(STATUS_SUCCESS,
+              receive_statistics_createReportBlock(&receiveStatistics, 0x1234, 77, now + HUNDREDS_OF_NANOS_IN_A_SECOND / 2, reportBlock));
+    EXPECT_EQ(0x1234, getUnalignedInt32BigEndian(reportBlock));
+    // 2 of 6 lost is 85/256
+    EXPECT_EQ(0x55000002, getUnalignedInt32BigEndian(reportBlock + 4));
+    EXPECT_EQ(0x00010003, getUnalignedInt32BigEndian(reportBlock + 8));
+    EXPECT_EQ(77, getUnalignedInt32BigEndian(reportBlock + 12));
+    EXPECT_EQ(0x456789AB, getUnalignedInt32BigEndian(reportBlock + 16));
+    // half a second in 1/65536 seconds
+    EXPECT_EQ(0x8000, getUnalignedInt32BigEndian(reportBlock + 20));
+
+    // The late packet makes up for the loss of the interval, the fraction lost is not negative
+    receive_statistics_onPacket(&receiveStatistics, 1);
+    receive_statistics_onPacket(&receiveStatistics, 4);
+    EXPECT_EQ(STATUS_SUCCESS, receive_statistics_createReportBlock(&receiveStatistics, 0x1234, 77, now, reportBlock));
+    EXPECT_EQ(0x00000001, getUnalignedInt32BigEndian(reportBlock + 4));
+    EXPECT_EQ(0x00010004, getUnalignedInt32BigEndian(reportBlock + 8));
+
+    // Duplicates make the cumulative loss negative
+    receive_statistics_onPacket(&receiveStatistics, 4);
+    receive_statistics_onPacket(&receiveStatistics, 4);
+    EXPECT_EQ(-1, receive_statistics_getPacketsLost(&receiveStatistics));
+    EXPECT_EQ(STATUS_SUCCESS, receive_statistics_createReportBlock(&receiveStatistics, 0x1234, 77, now, reportBlock));
+    EXPECT_EQ(0x00FFFFFF, getUnalignedInt32BigEndian(reportBlock + 4));
+
+    // A large jump is a stray packet, unless the next one follows on from it
+    receive_statistics_onPacket(&receiveStatistics, 40000);
+    EXPECT_EQ(-1, receive_statistics_getPacketsLost(&receiveStatistics));
+    receive_statistics_onPacket(&receiveStatistics, 40001);
+    EXPECT_EQ(0, receive_statistics_getPacketsLost(&receiveStatistics));
+    EXPECT_EQ(STATUS_SUCCESS, receive_statistics_createReportBlock(&receiveStatistics, 0x1234, 77, now, reportBlock));
+    EXPECT_EQ(40001, getUnalignedInt32BigEndian(reportBlock + 8));
+}
+
+TEST_F(RtcpFunctionalityTest, onSenderReportWithReportBlock)
+{
+    BYTE rawPacket[RTCP_PACKET_HEADER_LEN + RTCP_PACKET_SENDER_REPORT_MINLEN + RTCP_PACKET_RECEIVER_REPORT_BLOCK_LEN] = {0};
+    initTransceiver(4242);
+    pKvsRtpTransceiver->jitterBufferSsrc = 0xAABBCCDD;
+
+    // The remote peer sends 0xAABBCCDD and reports a fraction lost of 4/256 on 4242
+    rawPacket[0] = (RTCP_PACKET_VERSION_VAL << 6) | 1;
+    rawPacket[RTCP_PACKET_TYPE_OFFSET] = RTCP_PACKET_TYPE_SENDER_REPORT;
+    putUnalignedInt16BigEndian(rawPacket + RTCP_PACKET_LEN_OFFSET, SIZEOF(rawPacket) / RTCP_PACKET_LEN_WORD_SIZE - 1);
+    putUnalignedInt32BigEndian(rawPacket + 4, 0xAABBCCDD);
+    putUnalignedInt64BigEndian(rawPacket + 8, 0x0123456789ABCDEFULL);
+    putUnalignedInt32BigEndian(rawPacket + 28, 4242);
+    putUnalignedInt32BigEndian(rawPacket + 32, 0x04000002);
+
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_onInboundPacket(pKvsPeerConnection, rawPacket, SIZEOF(rawPacket)));
+    EXPECT_EQ(0x456789AB, pKvsRtpTransceiver->receiveStatistics.lastSenderReport);
+
+    RtcRemoteInboundRtpStreamStats stats{};
+    EXPECT_EQ(STATUS_SUCCESS, metrics_getRtpRemoteInboundStats(pRtcPeerConnection, pRtcRtpTransceiver, &stats));
+    EXPECT_EQ(1, stats.reportsReceived);
+    EXPECT_EQ(4.0 / 255.0, stats.fractionLost);
+    pc_free(&pRtcPeerConnection);
+}
+
+TEST_F(RtcpFunctionalityTest, createKeyFrameRequest)
+{
+    BYTE packet[RTCP_PACKET_FIR_LEN];
+    BYTE pli[] = {0x81, 0xCE, 0x00, 0x02, 0x00, 0x00, 0x11, 0x11, 0x12, 0x34, 0xAB, 0xCD};
+    BYTE fir[] = {0x84, 0xCE, 0x00, 0x04, 0x00, 0x00, 0x11, 0x11, 0x00, 0x00, 0x00, 0x00, 0x12, 0x34, 0xAB, 0xCD, 0x01, 0x00, 0x00, 0x00};
+    UINT8 firSequenceNumber = 0;
+    UINT32 packetLen = 0;
+    RtcpPacket rtcpPacket{};
+
+    EXPECT_EQ(STATUS_NULL_ARG, rtcp_packet_createKeyFrameRequest(FALSE, 0x1111, 0x1234ABCD, NULL, NULL, &packetLen));
+    EXPECT_EQ(STATUS_NULL_ARG, rtcp_packet_createKeyFrameRequest(FALSE, 0x1111, 0x1234ABCD, NULL, packet, NULL));
+    EXPECT_EQ(STATUS_NULL_ARG, rtcp_packet_createKeyFrameRequest(TRUE, 0x1111, 0x1234ABCD, NULL, packet, &packetLen));
+
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_packet_createKeyFrameRequest(FALSE, 0x1111, 0x1234ABCD, NULL, packet, &packetLen));
+    ASSERT_EQ(SIZEOF(pli), packetLen);
+    EXPECT_EQ(0, MEMCMP(pli, packet, packetLen));
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_packet_setFromBytes(packet, packetLen, &rtcpPacket));
+    EXPECT_EQ(RTCP_PACKET_TYPE_PAYLOAD_SPECIFIC_FEEDBACK, rtcpPacket.header.packetType);
+    EXPECT_EQ(RTCP_PSFB_PLI, rtcpPacket.header.receptionReportCount);
+
+    // Every full intra request numbers itself one up from the last one
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_packet_createKeyFrameRequest(TRUE, 0x1111, 0x1234ABCD, &firSequenceNumber, packet, &packetLen));
+    ASSERT_EQ(SIZEOF(fir), packetLen);
+    EXPECT_EQ(0, MEMCMP(fir, packet, packetLen));
+    EXPECT_EQ(1, firSequenceNumber);
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_packet_createKeyFrameRequest(TRUE, 0x1111, 0x1234ABCD, &firSequenceNumber, packet, &packetLen));
+    EXPECT_EQ(2, packet[16]);
+    EXPECT_EQ(0, MEMCMP(fir, packet, 16));
+    EXPECT_EQ(0, MEMCMP(fir + 17, packet + 17, 3));
+    firSequenceNumber = 0xFF;
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_packet_createKeyFrameRequest(TRUE, 0x1111, 0x1234ABCD, &firSequenceNumber, packet, &packetLen));
+    EXPECT_EQ(0, packet[16]);
+    EXPECT_EQ(0, firSequenceNumber);
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_packet_setFromBytes(packet, packetLen, &rtcpPacket));
+    EXPECT_EQ(RTCP_PSFB_FIR, rtcpPacket.header.receptionReportCount);
+}
+
+TEST_F(RtcpFunctionalityTest, keyFrameIsRequestedOnLossAtMostOncePerInterval)
+{
+    BYTE srtpKey[30] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+                        0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D};
+    RtcConfiguration config{};
+    RtcMediaStreamTrack track{};
+    UINT64 customData;
+    UINT16 seqNums[] = {10, 11, 20, 21};
+    UINT32 i;
+
+    // A single packet vp8 frame, the packets stay in the jitter buffer as they share a timestamp and 12 to 19 are missing
+    auto push = [](PJitterBuffer pJitterBuffer, UINT16 seq) -> STATUS {
+        PRtpPacket pRtpPacket = NULL;
+        STATUS retStatus = rtp_packet_create(2, FALSE, FALSE, 0, FALSE, 96, seq, 1000, 0x1234ABCD, NULL, 0, 0, NULL, NULL, 0, &pRtpPacket);
+        if (STATUS_SUCCEEDED(retStatus)) {
+            pRtpPacket->payloadLength = 2;
+            pRtpPacket->payload = (PBYTE) MEMALLOC(pRtpPacket->payloadLength);
+            pRtpPacket->payload[0] = 0x10;
+            pRtpPacket->payload[1] = (BYTE) seq;
+            pRtpPacket->pRawPacket = pRtpPacket->payload;
+            pRtpPacket->receivedTime = GETTIME();
+            retStatus = jitter_buffer_push(pJitterBuffer, pRtpPacket, NULL);
+        }
+        return retStatus;
+    };
+
+    track.kind = MEDIA_STREAM_TRACK_KIND_VIDEO;
+    track.codec = RTC_CODEC_VP8;
+    ASSERT_EQ(STATUS_SUCCESS, pc_create(&config, &pRtcPeerConnection));
+    pKvsPeerConnection = reinterpret_cast<PKvsPeerConnection>(pRtcPeerConnection);
+    ASSERT_EQ(STATUS_SUCCESS, ::pc_addTransceiver(pRtcPeerConnection, &track, nullptr, &pRtcRtpTransceiver));
+    pKvsRtpTransceiver = reinterpret_cast<PKvsRtpTransceiver>(pRtcRtpTransceiver);
+    customData = (UINT64) pKvsRtpTransceiver;
+    pKvsRtpTransceiver->jitterBufferSsrc = 0x1234ABCD;
+    pKvsRtpTransceiver->remoteAcceptsPli = TRUE;
+    // No ice candidate pair is selected, so the requests are built and encrypted but never hit the socket
+    ASSERT_EQ(STATUS_SUCCESS, srtp_session_init(srtpKey, srtpKey, KVS_SRTP_PROFILE_AES128_CM_HMAC_SHA1_80, &pKvsPeerConnection->pSrtpSession));
+    pKvsPeerConnection->keyFrameRequestInterval = HUNDREDS_OF_NANOS_IN_A_SECOND;
+    ATOMIC_STORE(&pKvsPeerConnection->roundTripTime, 0);
+    for (i = 0; i < ARRAY_SIZE(seqNums); i++) {
+        ASSERT_EQ(STATUS_SUCCESS, push(pKvsRtpTransceiver->pJitterBuffer, seqNums[i]));
+    }
+
+    // Frames which follow on from each other need no key frame
+    EXPECT_EQ(STATUS_SUCCESS, pc_onFrameReady(customData, 10, 10, 1));
+    EXPECT_EQ(STATUS_SUCCESS, pc_onFrameReady(customData, 11, 11, 1));
+    EXPECT_EQ(0, pKvsRtpTransceiver->inboundStats.pliCount);
+    EXPECT_TRUE(pKvsRtpTransceiver->frameChainStarted);
+    EXPECT_EQ(12, pKvsRtpTransceiver->nextFrameStartIndex);
+
+    // A frame after a gap may reference what was lost
+    EXPECT_EQ(STATUS_SUCCESS, pc_onFrameReady(customData, 20, 20, 1));
+    EXPECT_EQ(1, pKvsRtpTransceiver->inboundStats.pliCount);
+    EXPECT_NE(0, pKvsRtpTransceiver->lastKeyFrameRequestTime);
+    EXPECT_EQ(21, pKvsRtpTransceiver->nextFrameStartIndex);
+
+    // A dropped frame asks again, but not within the interval
+    EXPECT_EQ(STATUS_SUCCESS, pc_onFrameDrop(customData, 21, 21, 1000));
+    EXPECT_EQ(1, pKvsRtpTransceiver->inboundStats.pliCount);
+    EXPECT_EQ(22, pKvsRtpTransceiver->nextFrameStartIndex);
+
+    // Nor within a round trip time longer than the interval
+    pKvsRtpTransceiver->lastKeyFrameRequestTime -= 2 * HUNDREDS_OF_NANOS_IN_A_SECOND;
+    ATOMIC_STORE(&pKvsPeerConnection->roundTripTime, 10 * HUNDREDS_OF_NANOS_IN_A_SECOND);
+    EXPECT_EQ(STATUS_SUCCESS, pc_onFrameDrop(customData, 21, 21, 1000));
+    EXPECT_EQ(1, pKvsRtpTransceiver->inboundStats.pliCount);
+    ATOMIC_STORE(&pKvsPeerConnection->roundTripTime, 0);
+    EXPECT_EQ(STATUS_SUCCESS, pc_onFrameDrop(customData, 21, 21, 1000));
+    EXPECT_EQ(2, pKvsRtpTransceiver->inboundStats.pliCount);
+
+    // A remote peer which only takes full intra requests gets those
+    pKvsRtpTransceiver->remoteAcceptsPli = FALSE;
+    pKvsRtpTransceiver->remoteAcceptsFir = TRUE;
+    pKvsRtpTransceiver->lastKeyFrameRequestTime -= 2 * HUNDREDS_OF_NANOS_IN_A_SECOND;
+    EXPECT_EQ(STATUS_SUCCESS, pc_onFrameReady(customData, 10, 10, 1));
+    EXPECT_EQ(2, pKvsRtpTransceiver->inboundStats.pliCount);
+    EXPECT_EQ(1, pKvsRtpTransceiver->inboundStats.firCount);
+    EXPECT_EQ(1, pKvsRtpTransceiver->firSequenceNumber);
+
+    pc_free(&pRtcPeerConnection);
+}
+
+TEST_F(RtcpFunctionalityTest, nackCallbackSendsTheNacksOfEveryTransceiver)
+{
+    BYTE srtpKey[30] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+                        0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D};
+    PKvsRtpTransceiver pTransceivers[2];
+    IceCandidate localCandidate{}, remoteCandidate{};
+    IceCandidatePair iceCandidatePair{};
+    UINT64 customData, start = 10 * HUNDREDS_OF_NANOS_IN_A_SECOND;
+    UINT32 i;
+
+    initTransceiver(4242);
+    pTransceivers[0] = pKvsRtpTransceiver;
+    pTransceivers[1] = (PKvsRtpTransceiver) pc_addTransceiver(4343);
+    customData = (UINT64) pKvsPeerConnection;
+    // Packet 1 of each stream is lost
+    for (i = 0; i < ARRAY_SIZE(pTransceivers); i++) {
+        ASSERT_EQ(STATUS_SUCCESS, nack_generator_create(pTransceivers[i]->sender.ssrc, 0x1234ABCD + i, &pTransceivers[i]->pNackGenerator));
+        EXPECT_EQ(STATUS_SUCCESS, nack_generator_onPacketReceived(pTransceivers[i]->pNackGenerator, 0, start));
+        EXPECT_EQ(STATUS_SUCCESS, nack_generator_onPacketReceived(pTransceivers[i]->pNackGenerator, 2, start));
+    }
+
+    // Nothing is asked for, and no retry used up, before the srtp session and a candidate pair are there
+    EXPECT_EQ(STATUS_SUCCESS, pc_nackCallback(0, start + NACK_INTERVAL, customData));
+    ASSERT_EQ(STATUS_SUCCESS, srtp_session_init(srtpKey, srtpKey, KVS_SRTP_PROFILE_AES128_CM_HMAC_SHA1_80, &pKvsPeerConnection->pSrtpSession));
+    EXPECT_EQ(STATUS_SUCCESS, pc_nackCallback(0, start + NACK_INTERVAL, customData));
+    for (i = 0; i < ARRAY_SIZE(pTransceivers); i++) {
+        EXPECT_EQ(0, pTransceivers[i]->pNackGenerator->missingPackets[0].retries);
+    }
+
+    // A relayed pair without a turn connection fails every send, the first failure does not keep the second transceiver from its nack
+    localCandidate.iceCandidateType = ICE_CANDIDATE_TYPE_RELAYED;
+    iceCandidatePair.local = &localCandidate;
+    iceCandidatePair.remote = &remoteCandidate;
+    iceCandidatePair.state = ICE_CANDIDATE_PAIR_STATE_SUCCEEDED;
+    pKvsPeerConnection->pIceAgent->pDataSendingIceCandidatePair = &iceCandidatePair;
+    EXPECT_EQ(STATUS_SUCCESS, pc_nackCallback(0, start + NACK_INTERVAL, customData));
+    for (i = 0; i < ARRAY_SIZE(pTransceivers); i++) {
+        EXPECT_EQ(1, pTransceivers[i]->pNackGenerator->missingPackets[0].retries);
+        EXPECT_EQ(0, pTransceivers[i]->inboundStats.nackCount);
+    }
+
+    // Once the sends go through both streams ask again a round trip time later
+    localCandidate.iceCandidateType = ICE_CANDIDATE_TYPE_HOST;
+    EXPECT_EQ(STATUS_SUCCESS, pc_nackCallback(0, start + NACK_INTERVAL + NACK_DEFAULT_ROUND_TRIP_TIME, customData));
+    for (i = 0; i < ARRAY_SIZE(pTransceivers); i++) {
+        EXPECT_EQ(2, pTransceivers[i]->pNackGenerator->missingPackets[0].retries);
+        EXPECT_EQ(1, pTransceivers[i]->inboundStats.nackCount);
+    }
+
+    pKvsPeerConnection->pIceAgent->pDataSendingIceCandidatePair = NULL;
+    pc_free(&pRtcPeerConnection);
+}
+
 } // namespace webrtcclient
 } // namespace video
 } // namespace kinesis
@@ -11,6 +11,45 @@ namespace webrtcclient {
 BYTE start4ByteCode[] = {0x00, 0x00, 0x00, 0x01};
 
 class RtpFunctionalityTest : public WebRtcClientTestBase {
+  public:
+    PRtcPeerConnection pRtcPeerConnection = nullptr;
+    PKvsPeerConnection pKvsPeerConnection = nullptr;
+    PRtcRtpTransceiver pRtcRtpTransceiver = nullptr;
+    PKvsRtpTransceiver pKvsRtpTransceiver = nullptr;
+
+    // A video transceiver sending the "h" and "l" encodings, negotiated with rtx and the mid and rid extensions
+    VOID initSimulcastTransceiver()
+    {
+        RtcConfiguration config{};
+        RtcMediaStreamTrack track{};
+        BYTE srtpKey[30] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+                            0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D};
+
+        track.kind = MEDIA_STREAM_TRACK_KIND_VIDEO;
+        track.codec = RTC_CODEC_VP8;
+        STRNCPY(track.streamId, "myKvsVideoStream", MAX_MEDIA_STREAM_ID_LEN);
+        STRNCPY(track.trackId, "myVideoTrack", MAX_MEDIA_STREAM_ID_LEN);
+
+        ASSERT_EQ(STATUS_SUCCESS, pc_create(&config, &pRtcPeerConnection));
+        pKvsPeerConnection = (PKvsPeerConnection) pRtcPeerConnection;
+        ASSERT_EQ(STATUS_SUCCESS, pc_addTransceiver(pRtcPeerConnection, &track, nullptr, &pRtcRtpTransceiver));
+        pKvsRtpTransceiver = (PKvsRtpTransceiver) pRtcRtpTransceiver;
+        ASSERT_EQ(STATUS_SUCCESS, rtp_transceiver_addSimulcastEncoding(pRtcRtpTransceiver, (PCHAR) "h"));
+        ASSERT_EQ(STATUS_SUCCESS, rtp_transceiver_addSimulcastEncoding(pRtcRtpTransceiver, (PCHAR) "l"));
+
+        ASSERT_EQ(STATUS_SUCCESS, hashTableUpsert(pKvsPeerConnection->pCodecTable, RTC_CODEC_VP8, DEFAULT_PAYLOAD_VP8));
+        ASSERT_EQ(STATUS_SUCCESS, hashTableUpsert(pKvsPeerConnection->pRtxTable, RTC_RTX_CODEC_VP8, DEFAULT_PAYLOAD_VP8 + 1));
+        ASSERT_EQ(STATUS_SUCCESS,
+                  sdp_setTransceiverPayloadTypes(pKvsPeerConnection->pCodecTable, pKvsPeerConnection->pRtxTable,
+                                                 pKvsPeerConnection->pRtpPacketPool, pKvsPeerConnection->pTransceivers));
+        ASSERT_EQ(STATUS_SUCCESS, rtp_extension_map_set(&pKvsPeerConnection->extensionMap, RTP_EXTENSION_MID, DEFAULT_MID_EXT_ID));
+        ASSERT_EQ(STATUS_SUCCESS, rtp_extension_map_set(&pKvsPeerConnection->extensionMap, RTP_EXTENSION_RID, DEFAULT_RID_EXT_ID));
+        ASSERT_EQ(STATUS_SUCCESS, rtp_extension_map_set(&pKvsPeerConnection->extensionMap, RTP_EXTENSION_RRID, DEFAULT_RRID_EXT_ID));
+        pKvsRtpTransceiver->simulcastNegotiated = TRUE;
+        ASSERT_EQ(STATUS_SUCCESS, rtp_transceiver_updateExtensionLayouts(pKvsRtpTransceiver));
+        // No ice candidate pair is selected, so the packets are serialized and encrypted but never hit the socket
+        ASSERT_EQ(STATUS_SUCCESS, srtp_session_init(srtpKey, srtpKey, KVS_SRTP_PROFILE_AES128_CM_HMAC_SHA1_80, &pKvsPeerConnection->pSrtpSession));
+    }
 };
 
 TEST_F(RtpFunctionalityTest, packetUnderflow)
@@ -167,19 +206,21 @@ TEST_F(RtpFunctionalityTest, marshallUnmarshallH264Data)
 TEST_F(RtpFunctionalityTest, packingUnpackingVerifySameH264Frame)
 {
     PBYTE payload = (PBYTE) MEMCALLOC(1, 200000); // Assuming this is enough
-    PBYTE depayload = (PBYTE) MEMCALLOC(1, 1500); // This is more than max mtu
-    UINT32 depayloadSize = 1500;
+    // Every start code of the depayloaded frame has 4 bytes, while the frame files mostly use 3 bytes ones
+    PBYTE depayload = (PBYTE) MEMCALLOC(1, 400000);
+    UINT32 depayloadSize = 400000;
     UINT32 payloadLen = 0;
     UINT32 fileIndex = 0;
     PayloadArray payloadArray;
     UINT32 i = 0;
     UINT32 offset = 0;
-    UINT32 newPayloadLen = 0, newPayloadSubLen = 0;
+    UINT32 newPayloadLen = 0, newPayloadSubLen = 0, filledPayloadSubLen = 0;
     BOOL isStartPacket = FALSE;
-    PBYTE pCurPtrInPayload = NULL;
-    UINT32 remainPayloadLen = 0;
+    PBYTE pCurPtrInPayload = NULL, pCurPtrInDepayload = NULL;
+    UINT32 remainPayloadLen = 0, remainDepayloadLen = 0;
     UINT32 startIndex = 0, naluLength = 0;
-    UINT32 startLen = 0;
+    UINT32 newStartIndex = 0, newNaluLength = 0;
+    UINT32 aggregationPacketCount = 0;
 
     payloadArray.maxPayloadLength = 0;
     payloadArray.maxPayloadSubLenSize = 0;
@@ -217,44 +258,50 @@ TEST_F(RtpFunctionalityTest, packingUnpackingVerifySameH264Frame)
         EXPECT_LT(0, payloadArray.payloadSubLenSize);
 
         offset = 0;
+        newPayloadLen = 0;
 
         for (i = 0; i < payloadArray.payloadSubLenSize; i++) {
+            EXPECT_GE(DEFAULT_MTU_SIZE, payloadArray.payloadSubLength[i]);
+            if ((payloadArray.payloadBuffer[offset] & NAL_TYPE_MASK) == STAP_A_INDICATOR) {
+                aggregationPacketCount++;
+            }
+
             EXPECT_EQ(STATUS_SUCCESS,
                       depayH264FromRtpPayload(payloadArray.payloadBuffer + offset, payloadArray.payloadSubLength[i], NULL, &newPayloadSubLen,
                                               &isStartPacket));
-            newPayloadLen += newPayloadSubLen;
-            if (isStartPacket) {
-                newPayloadLen -= SIZEOF(start4ByteCode);
-            }
             EXPECT_LT(0, newPayloadSubLen);
+            EXPECT_GE(depayloadSize - newPayloadLen, newPayloadSubLen);
+
+            filledPayloadSubLen = newPayloadSubLen;
+            EXPECT_EQ(STATUS_SUCCESS,
+                      depayH264FromRtpPayload(payloadArray.payloadBuffer + offset, payloadArray.payloadSubLength[i], depayload + newPayloadLen,
+                                              &filledPayloadSubLen, NULL));
+            EXPECT_EQ(newPayloadSubLen, filledPayloadSubLen);
+            newPayloadLen += filledPayloadSubLen;
             offset += payloadArray.payloadSubLength[i];
         }
-        EXPECT_LE(newPayloadLen, payloadLen);
 
-        offset = 0;
-        newPayloadLen = 0;
-        isStartPacket = FALSE;
+        // The depayloaded frame carries the same NALUs in the same order
         pCurPtrInPayload = payload;
         remainPayloadLen = payloadLen;
-        for (i = 0; i < payloadArray.payloadSubLenSize; i++) {
-            newPayloadSubLen = depayloadSize;
-            EXPECT_EQ(STATUS_SUCCESS,
-                      depayH264FromRtpPayload(payloadArray.payloadBuffer + offset, payloadArray.payloadSubLength[i], depayload, &newPayloadSubLen,
-                                              &isStartPacket));
-            if (isStartPacket) {
-                EXPECT_EQ(STATUS_SUCCESS, getNextNaluLength(pCurPtrInPayload, remainPayloadLen, &startIndex, &naluLength));
-                pCurPtrInPayload += startIndex;
-                startLen = SIZEOF(start4ByteCode);
-            } else {
-                startLen = 0;
-            }
-            EXPECT_TRUE(MEMCMP(pCurPtrInPayload, depayload + startLen, newPayloadSubLen - startLen) == 0);
-            pCurPtrInPayload += newPayloadSubLen - startLen;
-            remainPayloadLen -= newPayloadSubLen;
-            offset += payloadArray.payloadSubLength[i];
+        pCurPtrInDepayload = depayload;
+        remainDepayloadLen = newPayloadLen;
+        while (remainPayloadLen != 0) {
+            ASSERT_EQ(STATUS_SUCCESS, getNextNaluLength(pCurPtrInPayload, remainPayloadLen, &startIndex, &naluLength));
+            ASSERT_EQ(STATUS_SUCCESS, getNextNaluLength(pCurPtrInDepayload, remainDepayloadLen, &newStartIndex, &newNaluLength));
+            ASSERT_EQ(naluLength, newNaluLength);
+            EXPECT_TRUE(MEMCMP(pCurPtrInPayload + startIndex, pCurPtrInDepayload + newStartIndex, naluLength) == 0);
+            pCurPtrInPayload += startIndex + naluLength;
+            remainPayloadLen -= startIndex + naluLength;
+            pCurPtrInDepayload += newStartIndex + newNaluLength;
+            remainDepayloadLen -= newStartIndex + newNaluLength;
         }
+        EXPECT_EQ(0, remainDepayloadLen);
     }
 
+    // The frame files start with an access unit delimiter and most of them have several slices
+    EXPECT_LT(0, aggregationPacketCount);
+
     MEMFREE(payloadArray.payloadBuffer);
     MEMFREE(payloadArray.payloadSubLength);
     MEMFREE(payload);
@@ -316,6 +363,156 @@ TEST_F(RtpFunctionalityTest, packingUnpackingVerifySameOpusFrame)
     MEMFREE(depayload);
 }
 
+TEST_F(RtpFunctionalityTest, packingUnpackingVerifySameRedFrames)
+{
+    BYTE frames[3][5] = {{0x00, 0x01, 0x02}, {0x10, 0x11, 0x12, 0x13}, {0x20, 0x21, 0x22, 0x23, 0x24}};
+    UINT32 frameLengths[3] = {3, 4, 5}, timestamps[3] = {960, 1920, 2880};
+    BYTE payloadBuffer[64];
+    UINT32 i, payloadLength, payloadSubLength, payloadSubLenSize, blockCount;
+    PRedEncoder pRedEncoder = NULL;
+    RedBlock blocks[RED_MAX_BLOCK_COUNT];
+
+    EXPECT_EQ(STATUS_INVALID_ARG, red_encoder_create(111, RED_MAX_REDUNDANCY + 1, &pRedEncoder));
+    EXPECT_EQ(STATUS_SUCCESS, red_encoder_create(111, RED_MAX_REDUNDANCY, &pRedEncoder));
+
+    for (i = 0; i < 3; i++) {
+        // First call for payload size, which leaves the history alone
+        payloadLength = 0;
+        payloadSubLenSize = 0;
+        EXPECT_EQ(STATUS_SUCCESS,
+                  createPayloadForRed(pRedEncoder, DEFAULT_MTU_SIZE, timestamps[i], frames[i], frameLengths[i], NULL, &payloadLength, NULL,
+                                      &payloadSubLenSize));
+        EXPECT_EQ(1, payloadSubLenSize);
+        EXPECT_GE(SIZEOF(payloadBuffer), payloadLength);
+
+        EXPECT_EQ(STATUS_SUCCESS,
+                  createPayloadForRed(pRedEncoder, DEFAULT_MTU_SIZE, timestamps[i], frames[i], frameLengths[i], payloadBuffer, &payloadLength,
+                                      &payloadSubLength, &payloadSubLenSize));
+        EXPECT_EQ(payloadLength, payloadSubLength);
+    }
+
+    // The last packet carries both previous frames, the oldest first, and the primary frame last
+    EXPECT_EQ(RED_PRIMARY_BLOCK_HEADER_LEN + 2 * RED_BLOCK_HEADER_LEN + 3 + 4 + 5, payloadLength);
+    blockCount = RED_MAX_BLOCK_COUNT;
+    EXPECT_EQ(STATUS_SUCCESS, depayRedFromRtpPayload(payloadBuffer, payloadLength, blocks, &blockCount));
+    EXPECT_EQ(3, blockCount);
+    for (i = 0; i < blockCount; i++) {
+        EXPECT_EQ(111, blocks[i].payloadType);
+        EXPECT_EQ(timestamps[2] - timestamps[i], blocks[i].timestampOffset);
+        EXPECT_EQ(frameLengths[i], blocks[i].length);
+        EXPECT_EQ(0, MEMCMP(frames[i], blocks[i].pData, blocks[i].length));
+    }
+
+    EXPECT_EQ(STATUS_SUCCESS, red_encoder_free(&pRedEncoder));
+    EXPECT_TRUE(pRedEncoder == NULL);
+}
+
+TEST_F(RtpFunctionalityTest, redDropsTheOldestFramesWhichDoNotFit)
+{
+    BYTE frames[3][5] = {{0x00, 0x01, 0x02}, {0x10, 0x11, 0x12, 0x13}, {0x20, 0x21, 0x22, 0x23, 0x24}};
+    UINT32 frameLengths[3] = {3, 4, 5}, timestamps[3] = {960, 1920, 2880};
+    BYTE payloadBuffer[64];
+    UINT32 i, payloadLength, payloadSubLength, payloadSubLenSize, blockCount;
+    PRedEncoder pRedEncoder = NULL;
+    RedBlock blocks[RED_MAX_BLOCK_COUNT];
+
+    EXPECT_EQ(STATUS_SUCCESS, red_encoder_create(111, RED_MAX_REDUNDANCY, &pRedEncoder));
+    for (i = 0; i < 3; i++) {
+        payloadLength = SIZEOF(payloadBuffer);
+        payloadSubLenSize = 1;
+        // Room for the primary frame and the one before it only
+        EXPECT_EQ(STATUS_SUCCESS,
+                  createPayloadForRed(pRedEncoder, 18, timestamps[i], frames[i], frameLengths[i], payloadBuffer, &payloadLength, &payloadSubLength,
+                                      &payloadSubLenSize));
+    }
+
+    blockCount = RED_MAX_BLOCK_COUNT;
+    EXPECT_EQ(STATUS_SUCCESS, depayRedFromRtpPayload(payloadBuffer, payloadLength, blocks, &blockCount));
+    EXPECT_EQ(2, blockCount);
+    EXPECT_EQ(timestamps[2] - timestamps[1], blocks[0].timestampOffset);
+    EXPECT_EQ(0, MEMCMP(frames[1], blocks[0].pData, frameLengths[1]));
+    EXPECT_EQ(0, MEMCMP(frames[2], blocks[1].pData, frameLengths[2]));
+
+    EXPECT_EQ(STATUS_SUCCESS, red_encoder_free(&pRedEncoder));
+}
+
+TEST_F(RtpFunctionalityTest, depayRedRejectsMalformedPayload)
+{
+    // A redundant block of 16 bytes, which the packet is too short to hold
+    BYTE truncated[] = {0x80 | 111, 0x0F, 0x00, 0x10, 111, 0x01, 0x02};
+    // Redundant block headers only
+    BYTE headersOnly[] = {0x80 | 111, 0x0F, 0x00, 0x01};
+    RedBlock blocks[RED_MAX_BLOCK_COUNT];
+    UINT32 blockCount = RED_MAX_BLOCK_COUNT;
+
+    EXPECT_EQ(STATUS_RTP_INVALID_RED_PACKET, depayRedFromRtpPayload(truncated, SIZEOF(truncated), blocks, &blockCount));
+    EXPECT_EQ(0, blockCount);
+    blockCount = RED_MAX_BLOCK_COUNT;
+    EXPECT_EQ(STATUS_RTP_INVALID_RED_PACKET, depayRedFromRtpPayload(headersOnly, SIZEOF(headersOnly), blocks, &blockCount));
+    blockCount = 1;
+    EXPECT_EQ(STATUS_RTP_INVALID_RED_PACKET, depayRedFromRtpPayload(truncated, SIZEOF(truncated), blocks, &blockCount));
+}
+
+TEST_F(RtpFunctionalityTest, depayRedTakesAnyBlockCountWhichFits)
+{
+    // Four redundant 20 ms frames of 2 bytes each and a primary frame of 3 bytes, more than our encoder ever sends
+    BYTE payload[4 * RED_BLOCK_HEADER_LEN + RED_PRIMARY_BLOCK_HEADER_LEN + 4 * 2 + 3];
+    RedBlock blocks[5];
+    UINT32 i, field, blockCount = 0;
+
+    for (i = 0; i < 4; i++) {
+        field = (4 - i) * 960 << RED_TIMESTAMP_OFFSET_SHIFT | 2;
+        payload[i * RED_BLOCK_HEADER_LEN] = RED_F_BIT | 111;
+        payload[i * RED_BLOCK_HEADER_LEN + 1] = (BYTE) (field >> 16);
+        payload[i * RED_BLOCK_HEADER_LEN + 2] = (BYTE) (field >> 8);
+        payload[i * RED_BLOCK_HEADER_LEN + 3] = (BYTE) field;
+        payload[4 * RED_BLOCK_HEADER_LEN + RED_PRIMARY_BLOCK_HEADER_LEN + i * 2] = (BYTE) i;
+        payload[4 * RED_BLOCK_HEADER_LEN + RED_PRIMARY_BLOCK_HEADER_LEN + i * 2 + 1] = (BYTE) i;
+    }
+    payload[4 * RED_BLOCK_HEADER_LEN] = 111;
+    MEMSET(payload + SIZEOF(payload) - 3, 0x42, 3);
+
+    // The headers are counted first, so that the caller can size the blocks
+    EXPECT_EQ(STATUS_SUCCESS, depayRedFromRtpPayload(payload, SIZEOF(payload), NULL, &blockCount));
+    EXPECT_EQ(5, blockCount);
+    blockCount = RED_MAX_BLOCK_COUNT;
+    EXPECT_EQ(STATUS_BUFFER_TOO_SMALL, depayRedFromRtpPayload(payload, SIZEOF(payload), blocks, &blockCount));
+    EXPECT_EQ(5, blockCount);
+
+    EXPECT_EQ(STATUS_SUCCESS, depayRedFromRtpPayload(payload, SIZEOF(payload), blocks, &blockCount));
+    EXPECT_EQ(5, blockCount);
+    for (i = 0; i < 4; i++) {
+        EXPECT_EQ(111, blocks[i].payloadType);
+        EXPECT_EQ((4 - i) * 960, blocks[i].timestampOffset);
+        EXPECT_EQ(2, blocks[i].length);
+        EXPECT_EQ(i, blocks[i].pData[0]);
+    }
+    EXPECT_EQ(0, blocks[4].timestampOffset);
+    EXPECT_EQ(3, blocks[4].length);
+    EXPECT_EQ(0x42, blocks[4].pData[0]);
+}
+
+TEST_F(RtpFunctionalityTest, opusPacketDurationFollowsTheTableOfContents)
+{
+    // SILK 20 ms, hybrid 10 ms twice, CELT 2.5 ms with three frames in a code 3 packet
+    BYTE silk[] = {1 << OPUS_TOC_CONFIG_SHIFT, 0x00};
+    BYTE hybrid[] = {12 << OPUS_TOC_CONFIG_SHIFT | 1, 0x00};
+    BYTE celt[] = {16 << OPUS_TOC_CONFIG_SHIFT | 3, 0x03, 0x00};
+    // 60 ms frames, three of them are more than a packet may hold
+    BYTE tooLong[] = {3 << OPUS_TOC_CONFIG_SHIFT | 3, 0x03};
+    UINT32 duration = 0;
+
+    EXPECT_EQ(STATUS_SUCCESS, getOpusPacketDuration(silk, SIZEOF(silk), &duration));
+    EXPECT_EQ(960, duration);
+    EXPECT_EQ(STATUS_SUCCESS, getOpusPacketDuration(hybrid, SIZEOF(hybrid), &duration));
+    EXPECT_EQ(960, duration);
+    EXPECT_EQ(STATUS_SUCCESS, getOpusPacketDuration(celt, SIZEOF(celt), &duration));
+    EXPECT_EQ(360, duration);
+    EXPECT_EQ(STATUS_RTP_INVALID_OPUS_PACKET, getOpusPacketDuration(tooLong, SIZEOF(tooLong), &duration));
+    EXPECT_EQ(STATUS_RTP_INVALID_OPUS_PACKET, getOpusPacketDuration(celt, 1, &duration));
+    EXPECT_EQ(STATUS_RTP_INVALID_OPUS_PACKET, getOpusPacketDuration(silk, 0, &duration));
+}
+
 TEST_F(RtpFunctionalityTest, packingUnpackingVerifySameShortG711Frame)
 {
     BYTE payload[] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05};
@@ -445,6 +642,279 @@ TEST_F(RtpFunctionalityTest, packingUnpackingVerifySameLongG711Frame)
     MEMFREE(depayload);
 }
 
+TEST_F(RtpFunctionalityTest, stapAAggregatesSmallNalus)
+{
+    // SEI, SPS and PPS followed by an IDR slice larger than the MTU
+    BYTE frame[1600];
+    BYTE payload[1700];
+    UINT32 payloadSubLength[4];
+    UINT32 payloadLength = 0, payloadSubLenSize = 0, naluLength = 0;
+    BYTE depayload[64];
+    BOOL isStartPacket = FALSE;
+    BYTE sei[] = {0x00, 0x00, 0x00, 0x01, 0x06, 0x05, 0x01, 0x80};
+    BYTE sps[] = {0x00, 0x00, 0x00, 0x01, 0x67, 0x42, 0xe0, 0x1f};
+    BYTE pps[] = {0x00, 0x00, 0x01, 0x68, 0xce, 0x3c, 0x80};
+
+    MEMSET(frame, 0x33, SIZEOF(frame));
+    MEMCPY(frame, sei, SIZEOF(sei));
+    MEMCPY(frame + SIZEOF(sei), sps, SIZEOF(sps));
+    MEMCPY(frame + SIZEOF(sei) + SIZEOF(sps), pps, SIZEOF(pps));
+    MEMCPY(frame + SIZEOF(sei) + SIZEOF(sps) + SIZEOF(pps), start4ByteCode, SIZEOF(start4ByteCode));
+    frame[SIZEOF(sei) + SIZEOF(sps) + SIZEOF(pps) + SIZEOF(start4ByteCode)] = 0x65;
+
+    EXPECT_EQ(STATUS_SUCCESS, createPayloadForH264(DEFAULT_MTU_SIZE, frame, SIZEOF(frame), NULL, &payloadLength, NULL, &payloadSubLenSize));
+    EXPECT_EQ(3, payloadSubLenSize);
+    EXPECT_GE(SIZEOF(payload), payloadLength);
+    EXPECT_EQ(STATUS_SUCCESS,
+              createPayloadForH264(DEFAULT_MTU_SIZE, frame, SIZEOF(frame), payload, &payloadLength, payloadSubLength, &payloadSubLenSize));
+
+    // NRI is the highest one of the aggregated NALUs
+    EXPECT_EQ(0x60 | STAP_A_INDICATOR, payload[0]);
+    EXPECT_EQ(STAP_A_HEADER_SIZE + 3 * STAP_A_NALU_LENGTH_SIZE + 4 + 4 + 4, payloadSubLength[0]);
+    EXPECT_EQ(FU_A_INDICATOR, payload[payloadSubLength[0]] & NAL_TYPE_MASK);
+
+    naluLength = SIZEOF(depayload);
+    EXPECT_EQ(STATUS_SUCCESS, depayH264FromRtpPayload(payload, payloadSubLength[0], depayload, &naluLength, &isStartPacket));
+    EXPECT_TRUE(isStartPacket);
+    EXPECT_EQ(3 * SIZEOF(start4ByteCode) + 4 + 4 + 4, naluLength);
+    EXPECT_EQ(0, MEMCMP(depayload, frame, SIZEOF(sei) + SIZEOF(sps)));
+    EXPECT_EQ(0, MEMCMP(depayload + SIZEOF(sei) + SIZEOF(sps) + SIZEOF(start4ByteCode), pps + 3, SIZEOF(pps) - 3));
+
+    // A truncated STAP-A keeps the complete NALUs
+    naluLength = 0;
+    EXPECT_EQ(STATUS_SUCCESS, depayH264FromRtpPayload(payload, payloadSubLength[0] - 1, NULL, &naluLength, NULL));
+    EXPECT_EQ(2 * SIZEOF(start4ByteCode) + 4 + 4, naluLength);
+}
+
+static UINT32 appendTestH265Nalu(PBYTE pFrame, UINT32 offset, UINT8 naluType, UINT32 naluLength, UINT8 layerId, UINT8 tid)
+{
+    UINT32 i;
+
+    MEMCPY(pFrame + offset, start4ByteCode, SIZEOF(start4ByteCode));
+    offset += SIZEOF(start4ByteCode);
+    pFrame[offset] = (naluType << 1) | (layerId >> 5);
+    pFrame[offset + 1] = ((layerId & 0x1F) << 3) | tid;
+    for (i = H265_NAL_HEADER_SIZE; i < naluLength; i++) {
+        // Never 0, so that the body does not look like a start code
+        pFrame[offset + i] = (BYTE)(i | 0x10);
+    }
+
+    return offset + naluLength;
+}
+
+TEST_F(RtpFunctionalityTest, packingUnpackingVerifySameH265Frame)
+{
+    BYTE frame[8000];
+    BYTE depayload[8000];
+    UINT32 frameLength = 0, depayloadLength = 0, naluLength = 0;
+    UINT32 i, offset = 0;
+    BOOL isStartPacket = FALSE;
+    PayloadArray payloadArray;
+
+    // VPS, SPS and PPS in front of an IDR slice which has to be fragmented
+    frameLength = appendTestH265Nalu(frame, frameLength, 32, 24, 0, 1);
+    frameLength = appendTestH265Nalu(frame, frameLength, 33, 40, 0, 1);
+    frameLength = appendTestH265Nalu(frame, frameLength, 34, 8, 0, 1);
+    frameLength = appendTestH265Nalu(frame, frameLength, 19, 5000, 0, 1);
+
+    MEMSET(&payloadArray, 0x00, SIZEOF(PayloadArray));
+    EXPECT_EQ(STATUS_SUCCESS,
+              createPayloadForH265(DEFAULT_MTU_SIZE, frame, frameLength, NULL, &payloadArray.payloadLength, NULL, &payloadArray.payloadSubLenSize));
+    payloadArray.payloadBuffer = (PBYTE) MEMALLOC(payloadArray.payloadLength);
+    payloadArray.payloadSubLength = (PUINT32) MEMALLOC(payloadArray.payloadSubLenSize * SIZEOF(UINT32));
+    EXPECT_EQ(STATUS_SUCCESS,
+              createPayloadForH265(DEFAULT_MTU_SIZE, frame, frameLength, payloadArray.payloadBuffer, &payloadArray.payloadLength,
+                                   payloadArray.payloadSubLength, &payloadArray.payloadSubLenSize));
+
+    // The parameter sets share an aggregation packet, the slice goes out as fragmentation units
+    EXPECT_EQ(6, payloadArray.payloadSubLenSize);
+    EXPECT_EQ(H265_AP_TYPE, H265_NAL_TYPE(payloadArray.payloadBuffer));
+    EXPECT_EQ(H265_NAL_HEADER_SIZE + 3 * H265_AP_NALU_LENGTH_SIZE + 24 + 40 + 8, payloadArray.payloadSubLength[0]);
+
+    for (i = 0; i < payloadArray.payloadSubLenSize; i++) {
+        EXPECT_GE(DEFAULT_MTU_SIZE, payloadArray.payloadSubLength[i]);
+        if (i > 0) {
+            EXPECT_EQ(H265_FU_TYPE, H265_NAL_TYPE(payloadArray.payloadBuffer + offset));
+        }
+
+        EXPECT_EQ(STATUS_SUCCESS,
+                  depayH265FromRtpPayload(payloadArray.payloadBuffer + offset, payloadArray.payloadSubLength[i], NULL, &naluLength, &isStartPacket));
+        EXPECT_EQ(i <= 1, isStartPacket);
+        EXPECT_GE(SIZEOF(depayload) - depayloadLength, naluLength);
+        EXPECT_EQ(STATUS_SUCCESS,
+                  depayH265FromRtpPayload(payloadArray.payloadBuffer + offset, payloadArray.payloadSubLength[i], depayload + depayloadLength,
+                                          &naluLength, NULL));
+        depayloadLength += naluLength;
+        offset += payloadArray.payloadSubLength[i];
+    }
+
+    EXPECT_EQ(frameLength, depayloadLength);
+    EXPECT_EQ(0, MEMCMP(frame, depayload, frameLength));
+
+    MEMFREE(payloadArray.payloadBuffer);
+    MEMFREE(payloadArray.payloadSubLength);
+}
+
+TEST_F(RtpFunctionalityTest, h265AggregationPacketHeader)
+{
+    BYTE frame[64];
+    BYTE payload[64];
+    UINT32 payloadSubLength[2];
+    UINT32 frameLength = 0, payloadLength = 0, payloadSubLenSize = 0;
+    UINT32 naluLength = 0;
+    BYTE truncated[] = {H265_AP_TYPE << 1, 0x01, 0x00, 0x03, 0x40, 0x01, 0x02, 0x00, 0x09, 0x01};
+
+    frameLength = appendTestH265Nalu(frame, frameLength, 39, 10, 3, 2);
+    frameLength = appendTestH265Nalu(frame, frameLength, 39, 10, 1, 3);
+    EXPECT_EQ(STATUS_SUCCESS, createPayloadForH265(DEFAULT_MTU_SIZE, frame, frameLength, NULL, &payloadLength, NULL, &payloadSubLenSize));
+    EXPECT_EQ(1, payloadSubLenSize);
+    EXPECT_GE(SIZEOF(payload), payloadLength);
+    EXPECT_EQ(STATUS_SUCCESS,
+              createPayloadForH265(DEFAULT_MTU_SIZE, frame, frameLength, payload, &payloadLength, payloadSubLength, &payloadSubLenSize));
+
+    // F is cleared, LayerId 1 and TID 2 are the lowest of the aggregated NALUs
+    EXPECT_EQ(H265_AP_TYPE << 1, payload[0]);
+    EXPECT_EQ((1 << 3) | 2, payload[1]);
+
+    // Only the complete NALUs of a truncated aggregation packet are kept
+    EXPECT_EQ(STATUS_SUCCESS, depayH265FromRtpPayload(truncated, SIZEOF(truncated), NULL, &naluLength, NULL));
+    EXPECT_EQ(SIZEOF(start4ByteCode) + 3, naluLength);
+}
+
+TEST_F(RtpFunctionalityTest, h265EmptyNaluIsSkipped)
+{
+    BYTE frame[64];
+    BYTE payload[64];
+    UINT32 payloadSubLength[2];
+    UINT32 frameLength = 0, payloadLength = 0, payloadSubLenSize = 0;
+
+    // Back to back start codes leave an empty NALU between the two real ones, like H264 it is left out
+    frameLength = appendTestH265Nalu(frame, frameLength, 39, 10, 0, 1);
+    MEMCPY(frame + frameLength, start4ByteCode, SIZEOF(start4ByteCode));
+    frameLength += SIZEOF(start4ByteCode);
+    frameLength = appendTestH265Nalu(frame, frameLength, 39, 10, 0, 1);
+    EXPECT_EQ(STATUS_SUCCESS, createPayloadForH265(DEFAULT_MTU_SIZE, frame, frameLength, NULL, &payloadLength, NULL, &payloadSubLenSize));
+    EXPECT_EQ(1, payloadSubLenSize);
+    EXPECT_EQ(H265_NAL_HEADER_SIZE + 2 * (H265_AP_NALU_LENGTH_SIZE + 10), payloadLength);
+    EXPECT_EQ(STATUS_SUCCESS,
+              createPayloadForH265(DEFAULT_MTU_SIZE, frame, frameLength, payload, &payloadLength, payloadSubLength, &payloadSubLenSize));
+    EXPECT_EQ(H265_AP_TYPE, H265_NAL_TYPE(payload));
+    EXPECT_EQ(10, getUnalignedInt16BigEndian(payload + H265_NAL_HEADER_SIZE));
+    EXPECT_EQ(10, getUnalignedInt16BigEndian(payload + H265_NAL_HEADER_SIZE + H265_AP_NALU_LENGTH_SIZE + 10));
+
+    // A single byte cannot hold the NAL unit header
+    frameLength = appendTestH265Nalu(frame, 0, 39, 10, 0, 1);
+    MEMCPY(frame + frameLength, start4ByteCode, SIZEOF(start4ByteCode));
+    frameLength += SIZEOF(start4ByteCode);
+    frame[frameLength++] = 39 << 1;
+    frameLength = appendTestH265Nalu(frame, frameLength, 39, 10, 0, 1);
+    EXPECT_EQ(STATUS_RTP_INVALID_NALU, createPayloadForH265(DEFAULT_MTU_SIZE, frame, frameLength, NULL, &payloadLength, NULL, &payloadSubLenSize));
+}
+
+static UINT32 appendTestAV1Obu(PBYTE pTemporalUnit, UINT32 offset, UINT8 obuType, UINT32 obuSize, BOOL paddedSize)
+{
+    UINT32 i;
+
+    pTemporalUnit[offset++] = (obuType << AV1_OBU_TYPE_SHIFT) | AV1_OBU_HAS_SIZE_FIELD;
+    if (paddedSize) {
+        for (i = 0; i < AV1_LEB128_PADDED_SIZE; i++) {
+            pTemporalUnit[offset++] = ((obuSize >> (7 * i)) & 0x7F) | (i < AV1_LEB128_PADDED_SIZE - 1 ? 0x80 : 0x00);
+        }
+    } else {
+        for (; obuSize >= 0x80; obuSize >>= 7) {
+            pTemporalUnit[offset++] = (obuSize & 0x7F) | 0x80;
+        }
+        pTemporalUnit[offset++] = obuSize;
+    }
+    for (i = 0; i < obuSize; i++) {
+        pTemporalUnit[offset++] = (BYTE) i;
+    }
+
+    return offset;
+}
+
+TEST_F(RtpFunctionalityTest, packingUnpackingVerifySameAV1TemporalUnit)
+{
+    BYTE temporalUnit[8000];
+    BYTE depayload[8000];
+    UINT32 temporalUnitLength = 0, depayloadLength = 0, obuLength = 0, mergedLength = 0;
+    UINT32 i, offset = 0, temporalDelimiterLength;
+    BOOL isStartPacket = FALSE;
+    PayloadArray payloadArray;
+
+    // The merged fragments keep a 4 byte size field, the frame OBU uses one so that the temporal unit comes back unchanged
+    temporalDelimiterLength = appendTestAV1Obu(temporalUnit, temporalUnitLength, AV1_OBU_TEMPORAL_DELIMITER, 0, FALSE);
+    temporalUnitLength = appendTestAV1Obu(temporalUnit, temporalDelimiterLength, AV1_OBU_SEQUENCE_HEADER, 12, FALSE);
+    temporalUnitLength = appendTestAV1Obu(temporalUnit, temporalUnitLength, 6, 5000, TRUE);
+
+    MEMSET(&payloadArray, 0x00, SIZEOF(PayloadArray));
+    EXPECT_EQ(STATUS_SUCCESS,
+              createPayloadForAV1(DEFAULT_MTU_SIZE, temporalUnit, temporalUnitLength, NULL, &payloadArray.payloadLength, NULL,
+                                  &payloadArray.payloadSubLenSize));
+    payloadArray.payloadBuffer = (PBYTE) MEMALLOC(payloadArray.payloadLength);
+    payloadArray.payloadSubLength = (PUINT32) MEMALLOC(payloadArray.payloadSubLenSize * SIZEOF(UINT32));
+    EXPECT_EQ(STATUS_SUCCESS,
+              createPayloadForAV1(DEFAULT_MTU_SIZE, temporalUnit, temporalUnitLength, payloadArray.payloadBuffer, &payloadArray.payloadLength,
+                                  payloadArray.payloadSubLength, &payloadArray.payloadSubLenSize));
+
+    EXPECT_LT(1, payloadArray.payloadSubLenSize);
+    for (i = 0; i < payloadArray.payloadSubLenSize; i++) {
+        EXPECT_GE(DEFAULT_MTU_SIZE, payloadArray.payloadSubLength[i]);
+        // Every packet but the first continues the frame OBU, every packet but the last leaves it unfinished
+        EXPECT_EQ(i > 0, (payloadArray.payloadBuffer[offset] & AV1_Z_BIT) != 0);
+        EXPECT_EQ(i < payloadArray.payloadSubLenSize - 1, (payloadArray.payloadBuffer[offset] & AV1_Y_BIT) != 0);
+        EXPECT_EQ(i == 0, (payloadArray.payloadBuffer[offset] & AV1_N_BIT) != 0);
+
+        EXPECT_EQ(STATUS_SUCCESS,
+                  depayAV1FromRtpPayload(payloadArray.payloadBuffer + offset, payloadArray.payloadSubLength[i], NULL, &obuLength, &isStartPacket));
+        EXPECT_EQ(i == 0, isStartPacket);
+        EXPECT_GE(SIZEOF(depayload) - depayloadLength, obuLength);
+        EXPECT_EQ(STATUS_SUCCESS,
+                  depayAV1FromRtpPayload(payloadArray.payloadBuffer + offset, payloadArray.payloadSubLength[i], depayload + depayloadLength,
+                                         &obuLength, NULL));
+        depayloadLength += obuLength;
+        offset += payloadArray.payloadSubLength[i];
+    }
+
+    // The temporal delimiter is not sent
+    EXPECT_EQ(STATUS_SUCCESS, mergeAV1ObuFragments(depayload, depayloadLength, &mergedLength));
+    EXPECT_EQ(temporalUnitLength - temporalDelimiterLength, mergedLength);
+    EXPECT_EQ(0, MEMCMP(temporalUnit + temporalDelimiterLength, depayload, mergedLength));
+
+    MEMFREE(payloadArray.payloadBuffer);
+    MEMFREE(payloadArray.payloadSubLength);
+}
+
+TEST_F(RtpFunctionalityTest, av1AggregationHeader)
+{
+    BYTE temporalUnit[64];
+    BYTE payload[64];
+    UINT32 payloadSubLength[2];
+    UINT32 temporalUnitLength = 0, payloadLength = 0, payloadSubLenSize = 0;
+    UINT32 obuLength = 0;
+    // W is 0 and the second element claims more bytes than the packet has
+    BYTE truncated[] = {0x00, 0x02, 0x30, 0x01, 0x05, 0x30, 0x01};
+
+    temporalUnitLength = appendTestAV1Obu(temporalUnit, temporalUnitLength, AV1_OBU_SEQUENCE_HEADER, 10, FALSE);
+    temporalUnitLength = appendTestAV1Obu(temporalUnit, temporalUnitLength, 6, 20, FALSE);
+    EXPECT_EQ(STATUS_SUCCESS,
+              createPayloadForAV1(DEFAULT_MTU_SIZE, temporalUnit, temporalUnitLength, NULL, &payloadLength, NULL, &payloadSubLenSize));
+    EXPECT_EQ(1, payloadSubLenSize);
+    EXPECT_GE(SIZEOF(payload), payloadLength);
+    EXPECT_EQ(STATUS_SUCCESS,
+              createPayloadForAV1(DEFAULT_MTU_SIZE, temporalUnit, temporalUnitLength, payload, &payloadLength, payloadSubLength, &payloadSubLenSize));
+
+    // W counts the two elements and N flags the sequence header, the size fields are dropped from the OBU headers
+    EXPECT_EQ((2 << AV1_W_SHIFT) | AV1_N_BIT, payload[0]);
+    EXPECT_EQ(1 + 10, payload[1]);
+    EXPECT_EQ(AV1_OBU_SEQUENCE_HEADER << AV1_OBU_TYPE_SHIFT, payload[2]);
+    EXPECT_EQ(AV1_AGGREGATION_HEADER_SIZE + 1 + 1 + 10 + 1 + 20, payloadLength);
+
+    // Only the complete OBUs of a truncated packet are kept
+    EXPECT_EQ(STATUS_SUCCESS, depayAV1FromRtpPayload(truncated, SIZEOF(truncated), NULL, &obuLength, NULL));
+    EXPECT_EQ(1 + 1 + 1, obuLength);
+}
+
 TEST_F(RtpFunctionalityTest, invalidNaluParse)
 {
     BYTE data[] = {0x01, 0x00, 0x02};
@@ -486,6 +956,510 @@ TEST_F(RtpFunctionalityTest, trailingZerosWouldBeReturned)
     EXPECT_EQ(7, naluLength);
 }
 
+TEST_F(RtpFunctionalityTest, naluIndexMatchesNextNaluLength)
+{
+    PBYTE payload = (PBYTE) MEMALLOC(200000);
+    UINT32 payloadLen = 0, remainLen, startIndex, naluLength, fileIndex, i, offset;
+    PBYTE pCurPtr = NULL;
+    NaluIndex naluIndex;
+    BYTE buffer[100];
+
+    MEMSET(&naluIndex, 0x00, SIZEOF(NaluIndex));
+    for (fileIndex = 1; fileIndex <= NUMBER_OF_FRAME_FILES; fileIndex++) {
+        ASSERT_EQ(STATUS_SUCCESS, readFrameData(payload, &payloadLen, fileIndex, (PCHAR) "../samples/h264SampleFrames"));
+        ASSERT_EQ(STATUS_SUCCESS, nalu_index_build(&naluIndex, payload, payloadLen));
+
+        pCurPtr = payload;
+        remainLen = payloadLen;
+        for (i = 0; remainLen != 0; i++) {
+            ASSERT_EQ(STATUS_SUCCESS, getNextNaluLength(pCurPtr, remainLen, &startIndex, &naluLength));
+            pCurPtr += startIndex;
+            remainLen -= startIndex;
+            if (remainLen == 0) {
+                break;
+            }
+            ASSERT_LT(i, naluIndex.entryCount);
+            EXPECT_EQ((UINT32) (pCurPtr - payload), naluIndex.pEntries[i].offset);
+            EXPECT_EQ(naluLength, naluIndex.pEntries[i].length);
+            pCurPtr += naluLength;
+            remainLen -= naluLength;
+        }
+        EXPECT_EQ(i, naluIndex.entryCount);
+    }
+
+    // A start code on either side of every vector block boundary
+    for (offset = 0; offset + 3 <= SIZEOF(buffer); offset++) {
+        MEMSET(buffer, 0x02, SIZEOF(buffer));
+        buffer[offset] = 0x00;
+        buffer[offset + 1] = 0x00;
+        buffer[offset + 2] = 0x01;
+        EXPECT_EQ(offset, nalu_index_findStartCode(buffer, 0, SIZEOF(buffer)));
+        EXPECT_EQ(SIZEOF(buffer), nalu_index_findStartCode(buffer, offset + 1, SIZEOF(buffer)));
+    }
+
+    BYTE invalid[] = {0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x02};
+    EXPECT_EQ(STATUS_RTP_INVALID_NALU, nalu_index_build(&naluIndex, invalid, SIZEOF(invalid)));
+    EXPECT_EQ(0, naluIndex.entryCount);
+
+    nalu_index_free(&naluIndex);
+    MEMFREE(payload);
+}
+
+TEST_F(RtpFunctionalityTest, naluIndexScanThroughput)
+{
+    // The sample frames are all a few KB
+    PBYTE payload = (PBYTE) MEMALLOC(NUMBER_OF_FRAME_FILES * 10000);
+    PUINT32 payloadLens = (PUINT32) MEMALLOC(NUMBER_OF_FRAME_FILES * SIZEOF(UINT32));
+    PBYTE pFrame = NULL, pCurPtr = NULL;
+    UINT32 remainLen, startIndex, naluLength, fileIndex, round, totalLen = 0, nextNaluCount = 0, indexedNaluCount = 0;
+    UINT64 start, nextNaluTime, indexTime;
+    NaluIndex naluIndex;
+
+    MEMSET(&naluIndex, 0x00, SIZEOF(NaluIndex));
+    pFrame = payload;
+    for (fileIndex = 0; fileIndex < NUMBER_OF_FRAME_FILES; fileIndex++) {
+        ASSERT_EQ(STATUS_SUCCESS, readFrameData(pFrame, &payloadLens[fileIndex], fileIndex + 1, (PCHAR) "../samples/h264SampleFrames"));
+        pFrame += payloadLens[fileIndex];
+        totalLen += payloadLens[fileIndex];
+    }
+
+    start = GETTIME();
+    for (round = 0; round < 10; round++) {
+        for (pFrame = payload, fileIndex = 0; fileIndex < NUMBER_OF_FRAME_FILES; pFrame += payloadLens[fileIndex++]) {
+            pCurPtr = pFrame;
+            remainLen = payloadLens[fileIndex];
+            while (remainLen != 0 && STATUS_SUCCEEDED(getNextNaluLength(pCurPtr, remainLen, &startIndex, &naluLength)) && remainLen != startIndex) {
+                pCurPtr += startIndex + naluLength;
+                remainLen -= startIndex + naluLength;
+                nextNaluCount++;
+            }
+        }
+    }
+    nextNaluTime = GETTIME() - start;
+
+    start = GETTIME();
+    for (round = 0; round < 10; round++) {
+        for (pFrame = payload, fileIndex = 0; fileIndex < NUMBER_OF_FRAME_FILES; pFrame += payloadLens[fileIndex++]) {
+            EXPECT_EQ(STATUS_SUCCESS, nalu_index_build(&naluIndex, pFrame, payloadLens[fileIndex]));
+            indexedNaluCount += naluIndex.entryCount;
+        }
+    }
+    indexTime = GETTIME() - start;
+
+    EXPECT_EQ(nextNaluCount, indexedNaluCount);
+    DLOGI("Scanned %u bytes 10 times, getNextNaluLength %" PRIu64 " MB/s, nalu_index_build %" PRIu64 " MB/s", totalLen,
+          (UINT64) totalLen * 10 * HUNDREDS_OF_NANOS_IN_A_SECOND / MAX(nextNaluTime, 1) / 1000000,
+          (UINT64) totalLen * 10 * HUNDREDS_OF_NANOS_IN_A_SECOND / MAX(indexTime, 1) / 1000000);
+
+    nalu_index_free(&naluIndex);
+    MEMFREE(payloadLens);
+    MEMFREE(payload);
+}
+
+TEST_F(RtpFunctionalityTest, writeFrameDoesNotAllocateAfterWarmUp)
+{
+    RtcConfiguration config{};
+    RtcMediaStreamTrack track{};
+    PRtcPeerConnection pRtcPeerConnection = nullptr;
+    PKvsPeerConnection pKvsPeerConnection = nullptr;
+    PRtcRtpTransceiver pRtcRtpTransceiver = nullptr;
+    PKvsRtpTransceiver pKvsRtpTransceiver = nullptr;
+    BYTE srtpKey[30] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+                        0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D};
+    std::vector<BYTE> frameData(32 * 1024, 0x5A);
+    Frame frame{};
+    RtcStats rtcStats{};
+    SIZE_T allocationCount;
+    UINT32 i;
+
+    track.kind = MEDIA_STREAM_TRACK_KIND_VIDEO;
+    track.codec = RTC_CODEC_VP8;
+    STRNCPY(track.streamId, "myKvsVideoStream", MAX_MEDIA_STREAM_ID_LEN);
+    STRNCPY(track.trackId, "myVideoTrack", MAX_MEDIA_STREAM_ID_LEN);
+
+    ASSERT_EQ(STATUS_SUCCESS, pc_create(&config, &pRtcPeerConnection));
+    pKvsPeerConnection = (PKvsPeerConnection) pRtcPeerConnection;
+    ASSERT_EQ(STATUS_SUCCESS, pc_addTransceiver(pRtcPeerConnection, &track, nullptr, &pRtcRtpTransceiver));
+    pKvsRtpTransceiver = (PKvsRtpTransceiver) pRtcRtpTransceiver;
+    pKvsRtpTransceiver->sender.payloadType = DEFAULT_PAYLOAD_VP8;
+    pKvsRtpTransceiver->sender.rtxPayloadType = DEFAULT_PAYLOAD_VP8;
+    ASSERT_EQ(STATUS_SUCCESS,
+              rtp_rolling_buffer_create(DEFAULT_ROLLING_BUFFER_DURATION_IN_SECONDS * HIGHEST_EXPECTED_BIT_RATE / 8 / DEFAULT_MTU_SIZE,
+                                        &pKvsRtpTransceiver->sender.packetBuffer));
+    // No ice candidate pair is selected, so the packets are serialized and encrypted but never hit the socket
+    ASSERT_EQ(STATUS_SUCCESS, srtp_session_init(srtpKey, srtpKey, KVS_SRTP_PROFILE_AES128_CM_HMAC_SHA1_80, &pKvsPeerConnection->pSrtpSession));
+
+    frame.frameData = frameData.data();
+    frame.size = (UINT32) frameData.size();
+
+    // The first frame sizes the reusable buffers and allocates the packet pool
+    for (i = 0; i < 5; i++) {
+        frame.presentationTs = i * HUNDREDS_OF_NANOS_IN_A_SECOND / DEFAULT_FPS_VALUE;
+        EXPECT_EQ(STATUS_SUCCESS, rtp_writeFrame(pRtcRtpTransceiver, &frame));
+    }
+
+    // Enough frames to wrap the rolling buffer several times
+    allocationCount = getInstrumentedTotalAllocationCount();
+    for (; i < 300; i++) {
+        frame.presentationTs = i * HUNDREDS_OF_NANOS_IN_A_SECOND / DEFAULT_FPS_VALUE;
+        EXPECT_EQ(STATUS_SUCCESS, rtp_writeFrame(pRtcRtpTransceiver, &frame));
+    }
+    EXPECT_EQ(allocationCount, getInstrumentedTotalAllocationCount());
+
+    // The rolling buffer is full and holds pooled packets only
+    rtcStats.requestedTypeOfStats = RTC_STATS_TYPE_RTP_PACKET_POOL;
+    EXPECT_EQ(STATUS_SUCCESS, metrics_get(pRtcPeerConnection, nullptr, &rtcStats));
+    EXPECT_EQ(DEFAULT_RTP_PACKET_POOL_SIZE, rtcStats.rtcStatsObject.rtpPacketPoolStats.capacity);
+    EXPECT_EQ(pKvsRtpTransceiver->sender.packetBuffer->pRollingBuffer->capacity, rtcStats.rtcStatsObject.rtpPacketPoolStats.packetsInUse);
+    // A whole frame is held by the sender until the batch send returns
+    EXPECT_EQ(rtcStats.rtcStatsObject.rtpPacketPoolStats.packetsInUse + pKvsRtpTransceiver->sender.payloadArray.payloadSubLenSize,
+              rtcStats.rtcStatsObject.rtpPacketPoolStats.highWaterMark);
+    EXPECT_EQ(0, rtcStats.rtcStatsObject.rtpPacketPoolStats.poolMisses);
+
+    EXPECT_EQ(STATUS_SUCCESS, pc_free(&pRtcPeerConnection));
+}
+
+TEST_F(RtpFunctionalityTest, broadcastGroupPacketizesOnceForEveryTransceiver)
+{
+    RtcConfiguration config{};
+    RtcMediaStreamTrack track{}, audioTrack{};
+    PRtcPeerConnection pRtcPeerConnections[3] = {nullptr};
+    PRtcRtpTransceiver pRtcRtpTransceivers[3] = {nullptr};
+    PRtcRtpTransceiver pAudioTransceiver = nullptr;
+    PKvsRtpTransceiver pKvsRtpTransceiver = nullptr;
+    PRtcBroadcastGroup pRtcBroadcastGroup = nullptr;
+    PKvsBroadcastGroup pKvsBroadcastGroup = nullptr;
+    BYTE srtpKey[30] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+                        0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x1B, 0x1C, 0x1D};
+    std::vector<BYTE> frameData(16 * 1024, 0x5A);
+    UINT16 startSequenceNumbers[3];
+    Frame frame{};
+    UINT32 i, j, packetCount = 0;
+
+    track.kind = MEDIA_STREAM_TRACK_KIND_VIDEO;
+    track.codec = RTC_CODEC_VP8;
+    STRNCPY(track.streamId, "myKvsVideoStream", MAX_MEDIA_STREAM_ID_LEN);
+    STRNCPY(track.trackId, "myVideoTrack", MAX_MEDIA_STREAM_ID_LEN);
+    audioTrack.kind = MEDIA_STREAM_TRACK_KIND_AUDIO;
+    audioTrack.codec = RTC_CODEC_OPUS;
+    STRNCPY(audioTrack.streamId, "myKvsVideoStream", MAX_MEDIA_STREAM_ID_LEN);
+    STRNCPY(audioTrack.trackId, "myAudioTrack", MAX_MEDIA_STREAM_ID_LEN);
+
+    for (i = 0; i < ARRAY_SIZE(pRtcPeerConnections); i++) {
+        // The last viewer has the smallest mtu
+        config.kvsRtcConfiguration.maximumTransmissionUnit = i == ARRAY_SIZE(pRtcPeerConnections) - 1 ? 800 : 0;
+        ASSERT_EQ(STATUS_SUCCESS, pc_create(&config, &pRtcPeerConnections[i]));
+        ASSERT_EQ(STATUS_SUCCESS, pc_addTransceiver(pRtcPeerConnections[i], &track, nullptr, &pRtcRtpTransceivers[i]));
+        pKvsRtpTransceiver = (PKvsRtpTransceiver) pRtcRtpTransceivers[i];
+        pKvsRtpTransceiver->sender.payloadType = DEFAULT_PAYLOAD_VP8;
+        pKvsRtpTransceiver->sender.rtxPayloadType = DEFAULT_PAYLOAD_VP8;
+        startSequenceNumbers[i] = pKvsRtpTransceiver->sender.sequenceNumber;
+        ASSERT_EQ(STATUS_SUCCESS,
+                  rtp_rolling_buffer_create(DEFAULT_ROLLING_BUFFER_DURATION_IN_SECONDS * HIGHEST_EXPECTED_BIT_RATE / 8 / DEFAULT_MTU_SIZE,
+                                            &pKvsRtpTransceiver->sender.packetBuffer));
+        // No ice candidate pair is selected, so the packets are serialized and encrypted but never hit the socket
+        ASSERT_EQ(STATUS_SUCCESS,
+                  srtp_session_init(srtpKey, srtpKey, KVS_SRTP_PROFILE_AES128_CM_HMAC_SHA1_80,
+                                    &((PKvsPeerConnection) pRtcPeerConnections[i])->pSrtpSession));
+    }
+    ASSERT_EQ(STATUS_SUCCESS, pc_addTransceiver(pRtcPeerConnections[0], &audioTrack, nullptr, &pAudioTransceiver));
+
+    ASSERT_EQ(STATUS_SUCCESS, rtp_broadcast_group_create(&pRtcBroadcastGroup));
+    pKvsBroadcastGroup = (PKvsBroadcastGroup) pRtcBroadcastGroup;
+    for (i = 0; i < ARRAY_SIZE(pRtcRtpTransceivers); i++) {
+        EXPECT_EQ(STATUS_SUCCESS, rtp_broadcast_group_addTransceiver(pRtcBroadcastGroup, pRtcRtpTransceivers[i]));
+    }
+    // Adding a transceiver twice is a no-op, a transceiver of another codec can not share the payloads
+    EXPECT_EQ(STATUS_SUCCESS, rtp_broadcast_group_addTransceiver(pRtcBroadcastGroup, pRtcRtpTransceivers[0]));
+    EXPECT_NE(STATUS_SUCCESS, rtp_broadcast_group_addTransceiver(pRtcBroadcastGroup, pAudioTransceiver));
+    EXPECT_EQ(ARRAY_SIZE(pRtcRtpTransceivers), pKvsBroadcastGroup->transceiverCount);
+
+    frame.frameData = frameData.data();
+    frame.size = (UINT32) frameData.size();
+    for (i = 0; i < 3; i++) {
+        frame.presentationTs = i * HUNDREDS_OF_NANOS_IN_A_SECOND / DEFAULT_FPS_VALUE;
+        EXPECT_EQ(STATUS_SUCCESS, rtp_broadcast_group_writeFrame(pRtcBroadcastGroup, &frame));
+        packetCount += pKvsBroadcastGroup->payloadArray.payloadSubLenSize;
+    }
+
+    // The payloads fit the smallest mtu of the group
+    for (j = 0; j < pKvsBroadcastGroup->payloadArray.payloadSubLenSize; j++) {
+        EXPECT_GE(rtp_getPayloadMtu((PKvsPeerConnection) pRtcPeerConnections[2]), pKvsBroadcastGroup->payloadArray.payloadSubLength[j]);
+    }
+    for (i = 0; i < ARRAY_SIZE(pRtcRtpTransceivers); i++) {
+        pKvsRtpTransceiver = (PKvsRtpTransceiver) pRtcRtpTransceivers[i];
+        // Every sender numbers the shared payloads on its own and never packetizes the frames itself
+        EXPECT_EQ(GET_UINT16_SEQ_NUM(startSequenceNumbers[i] + packetCount), pKvsRtpTransceiver->sender.sequenceNumber);
+        EXPECT_EQ(NULL, pKvsRtpTransceiver->sender.payloadArray.payloadBuffer);
+        EXPECT_EQ(3, pKvsRtpTransceiver->outboundStats.framesSent);
+    }
+
+    EXPECT_EQ(STATUS_SUCCESS, rtp_broadcast_group_removeTransceiver(pRtcBroadcastGroup, pRtcRtpTransceivers[1]));
+    EXPECT_EQ(STATUS_NOT_FOUND, rtp_broadcast_group_removeTransceiver(pRtcBroadcastGroup, pRtcRtpTransceivers[1]));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_broadcast_group_writeFrame(pRtcBroadcastGroup, &frame));
+    EXPECT_EQ(4, ((PKvsRtpTransceiver) pRtcRtpTransceivers[0])->outboundStats.framesSent);
+    EXPECT_EQ(3, ((PKvsRtpTransceiver) pRtcRtpTransceivers[1])->outboundStats.framesSent);
+    EXPECT_EQ(4, ((PKvsRtpTransceiver) pRtcRtpTransceivers[2])->outboundStats.framesSent);
+
+    EXPECT_EQ(STATUS_SUCCESS, rtp_broadcast_group_free(&pRtcBroadcastGroup));
+    EXPECT_EQ(nullptr, pRtcBroadcastGroup);
+    for (i = 0; i < ARRAY_SIZE(pRtcPeerConnections); i++) {
+        EXPECT_EQ(STATUS_SUCCESS, pc_free(&pRtcPeerConnections[i]));
+    }
+}
+
+TEST_F(RtpFunctionalityTest, headerExtensionLayoutRoundTripsInBothFormats)
+{
+    RtpExtensionMap extensionMap;
+    RtpExtensionElements elements, parsed;
+    RtpExtensionLayout layout;
+    RtpPacket rtpPacket;
+    PBYTE pData = NULL;
+    UINT8 dataLen = 0;
+    CHAR mid[] = "0", rid[] = "hi";
+
+    rtp_extension_map_reset(&extensionMap);
+    EXPECT_EQ(STATUS_SUCCESS, rtp_extension_map_set(&extensionMap, RTP_EXTENSION_TWCC, DEFAULT_TWCC_EXT_ID));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_extension_map_set(&extensionMap, RTP_EXTENSION_MID, DEFAULT_MID_EXT_ID));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_extension_map_set(&extensionMap, RTP_EXTENSION_RID, DEFAULT_RID_EXT_ID));
+    EXPECT_NE(STATUS_SUCCESS, rtp_extension_map_set(&extensionMap, RTP_EXTENSION_COUNT, 1));
+
+    MEMSET(&elements, 0x00, SIZEOF(RtpExtensionElements));
+    elements.length[RTP_EXTENSION_TWCC] = SIZEOF(UINT16);
+    elements.pData[RTP_EXTENSION_MID] = (PBYTE) mid;
+    elements.length[RTP_EXTENSION_MID] = (UINT8) STRLEN(mid);
+    elements.pData[RTP_EXTENSION_RID] = (PBYTE) rid;
+    elements.length[RTP_EXTENSION_RID] = (UINT8) STRLEN(rid);
+    // The rrid is left out until it is negotiated
+    elements.pData[RTP_EXTENSION_RRID] = (PBYTE) rid;
+    elements.length[RTP_EXTENSION_RRID] = (UINT8) STRLEN(rid);
+
+    // All the ids fit a nibble, the twcc element comes first so the per packet patch lands right after its header byte
+    EXPECT_EQ(STATUS_SUCCESS, rtp_extension_layout_build(&extensionMap, &elements, &layout));
+    EXPECT_EQ(RTP_ONE_BYTE_EXTENSION_PROFILE, layout.profile);
+    EXPECT_EQ(8, layout.length);
+    EXPECT_EQ(1, layout.offsets[RTP_EXTENSION_TWCC]);
+    EXPECT_EQ(0, layout.offsets[RTP_EXTENSION_RRID]);
+    putUnalignedInt16BigEndian(layout.payload + layout.offsets[RTP_EXTENSION_TWCC], 0xBEEF);
+
+    MEMSET(&rtpPacket, 0x00, SIZEOF(RtpPacket));
+    rtp_extension_layout_apply(&layout, &rtpPacket);
+    EXPECT_EQ(STATUS_SUCCESS, rtp_extension_parse(&extensionMap, &rtpPacket, &parsed));
+    EXPECT_EQ(0xBEEF, getUnalignedInt16BigEndian(parsed.pData[RTP_EXTENSION_TWCC]));
+    EXPECT_EQ(0, MEMCMP(parsed.pData[RTP_EXTENSION_RID], rid, STRLEN(rid)));
+    EXPECT_EQ(NULL, parsed.pData[RTP_EXTENSION_RRID]);
+
+    // An id past 14 takes the two-byte header for every element, the id it took over is dropped
+    EXPECT_EQ(STATUS_SUCCESS, rtp_extension_map_set(&extensionMap, RTP_EXTENSION_RRID, DEFAULT_RID_EXT_ID));
+    EXPECT_EQ(0, extensionMap.ids[RTP_EXTENSION_RID]);
+    EXPECT_EQ(STATUS_SUCCESS, rtp_extension_map_set(&extensionMap, RTP_EXTENSION_RID, 100));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_extension_layout_build(&extensionMap, &elements, &layout));
+    EXPECT_EQ(RTP_TWO_BYTE_EXTENSION_PROFILE, layout.profile);
+    EXPECT_EQ(16, layout.length);
+    EXPECT_EQ(2, layout.offsets[RTP_EXTENSION_TWCC]);
+
+    rtp_extension_layout_apply(&layout, &rtpPacket);
+    EXPECT_EQ(STATUS_SUCCESS, rtp_extension_parse(&extensionMap, &rtpPacket, &parsed));
+    EXPECT_EQ(STRLEN(mid), parsed.length[RTP_EXTENSION_MID]);
+    EXPECT_EQ(0, MEMCMP(parsed.pData[RTP_EXTENSION_RID], rid, STRLEN(rid)));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_getExtension(&rtpPacket, 100, &pData, &dataLen));
+    EXPECT_EQ(STRLEN(rid), dataLen);
+    EXPECT_EQ(STATUS_RTP_EXTENSION_NOT_FOUND, rtp_packet_getExtension(&rtpPacket, 99, &pData, &dataLen));
+}
+
+TEST_F(RtpFunctionalityTest, receivedTimingAndOrientationElementsAreRead)
+{
+    RtpExtensionMap extensionMap;
+    RtpExtensionElements elements, parsed;
+    RtpExtensionLayout layout;
+    RtpPacket rtpPacket;
+    // 1.5 seconds, an ntp capture time with an offset of -1 second and a flipped frame rotated by 270 degrees
+    BYTE sendTime[] = {0x06, 0x00, 0x00};
+    BYTE captureTime[] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00};
+    BYTE orientation[] = {RTP_VIDEO_ORIENTATION_CAMERA_BIT | RTP_VIDEO_ORIENTATION_FLIP_BIT | 0x03};
+    UINT64 time = 0;
+    INT64 offset = 0;
+    UINT16 rotation = 0;
+    BOOL flip = FALSE;
+
+    rtp_extension_map_reset(&extensionMap);
+    EXPECT_EQ(STATUS_SUCCESS, rtp_extension_map_set(&extensionMap, RTP_EXTENSION_ABS_SEND_TIME, 2));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_extension_map_set(&extensionMap, RTP_EXTENSION_ABS_CAPTURE_TIME, 5));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_extension_map_set(&extensionMap, RTP_EXTENSION_VIDEO_ORIENTATION, 13));
+    EXPECT_STREQ(VIDEO_ORIENTATION_EXT_URL, rtp_extension_getUri(RTP_EXTENSION_VIDEO_ORIENTATION));
+
+    MEMSET(&elements, 0x00, SIZEOF(RtpExtensionElements));
+    elements.pData[RTP_EXTENSION_ABS_SEND_TIME] = sendTime;
+    elements.length[RTP_EXTENSION_ABS_SEND_TIME] = SIZEOF(sendTime);
+    elements.pData[RTP_EXTENSION_ABS_CAPTURE_TIME] = captureTime;
+    elements.length[RTP_EXTENSION_ABS_CAPTURE_TIME] = SIZEOF(captureTime);
+    elements.pData[RTP_EXTENSION_VIDEO_ORIENTATION] = orientation;
+    elements.length[RTP_EXTENSION_VIDEO_ORIENTATION] = SIZEOF(orientation);
+    EXPECT_EQ(STATUS_SUCCESS, rtp_extension_layout_build(&extensionMap, &elements, &layout));
+
+    MEMSET(&rtpPacket, 0x00, SIZEOF(RtpPacket));
+    rtp_extension_layout_apply(&layout, &rtpPacket);
+    EXPECT_EQ(STATUS_SUCCESS, rtp_extension_parse(&extensionMap, &rtpPacket, &parsed));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_extension_readAbsSendTime(&parsed, &time));
+    EXPECT_EQ(15 * HUNDREDS_OF_NANOS_IN_A_SECOND / 10, time);
+    EXPECT_EQ(STATUS_SUCCESS, rtp_extension_readAbsCaptureTime(&parsed, &time, &offset));
+    EXPECT_EQ(0x0102030405060708ULL, time);
+    EXPECT_EQ(-(1LL << 32), offset);
+    EXPECT_EQ(STATUS_SUCCESS, rtp_extension_readVideoOrientation(&parsed, &rotation, &flip));
+    EXPECT_EQ(270, rotation);
+    EXPECT_TRUE(flip);
+
+    // The capture time may come without the offset, a malformed or missing element is not read
+    parsed.length[RTP_EXTENSION_ABS_CAPTURE_TIME] = RTP_ABS_CAPTURE_TIME_LEN;
+    EXPECT_EQ(STATUS_SUCCESS, rtp_extension_readAbsCaptureTime(&parsed, &time, &offset));
+    EXPECT_EQ(0, offset);
+    parsed.length[RTP_EXTENSION_ABS_SEND_TIME] = 2;
+    EXPECT_EQ(STATUS_RTP_EXTENSION_NOT_FOUND, rtp_extension_readAbsSendTime(&parsed, &time));
+    parsed.pData[RTP_EXTENSION_VIDEO_ORIENTATION] = NULL;
+    EXPECT_EQ(STATUS_RTP_EXTENSION_NOT_FOUND, rtp_extension_readVideoOrientation(&parsed, &rotation, NULL));
+}
+
+TEST_F(RtpFunctionalityTest, ridIsRenamedToRridInBothFormats)
+{
+    RtpExtensionMap extensionMap;
+    RtpExtensionElements elements;
+    RtpExtensionLayout layout;
+    RtpPacket rtpPacket;
+    PBYTE pData = NULL;
+    UINT8 dataLen = 0;
+    CHAR mid[] = "0", rid[] = "hi";
+
+    rtp_extension_map_reset(&extensionMap);
+    EXPECT_EQ(STATUS_SUCCESS, rtp_extension_map_set(&extensionMap, RTP_EXTENSION_MID, DEFAULT_MID_EXT_ID));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_extension_map_set(&extensionMap, RTP_EXTENSION_RID, DEFAULT_RID_EXT_ID));
+    MEMSET(&elements, 0x00, SIZEOF(RtpExtensionElements));
+    elements.pData[RTP_EXTENSION_MID] = (PBYTE) mid;
+    elements.length[RTP_EXTENSION_MID] = (UINT8) STRLEN(mid);
+    elements.pData[RTP_EXTENSION_RID] = (PBYTE) rid;
+    elements.length[RTP_EXTENSION_RID] = (UINT8) STRLEN(rid);
+
+    EXPECT_EQ(STATUS_SUCCESS, rtp_extension_layout_build(&extensionMap, &elements, &layout));
+    EXPECT_EQ(RTP_ONE_BYTE_EXTENSION_PROFILE, layout.profile);
+    MEMSET(&rtpPacket, 0x00, SIZEOF(RtpPacket));
+    rtp_extension_layout_apply(&layout, &rtpPacket);
+
+    // The one-byte header has no room for an id past 14, the element keeps its id
+    EXPECT_EQ(STATUS_INVALID_ARG, rtp_extension_renameElement(&rtpPacket, DEFAULT_RID_EXT_ID, 15));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_getExtension(&rtpPacket, DEFAULT_RID_EXT_ID, &pData, &dataLen));
+    EXPECT_EQ(STATUS_RTP_EXTENSION_NOT_FOUND, rtp_extension_renameElement(&rtpPacket, DEFAULT_RRID_EXT_ID, DEFAULT_RID_EXT_ID));
+
+    // Only the id changes, the value and the neighbouring elements stay where they are
+    EXPECT_EQ(STATUS_SUCCESS, rtp_extension_renameElement(&rtpPacket, DEFAULT_RID_EXT_ID, DEFAULT_RRID_EXT_ID));
+    EXPECT_EQ(STATUS_RTP_EXTENSION_NOT_FOUND, rtp_packet_getExtension(&rtpPacket, DEFAULT_RID_EXT_ID, &pData, &dataLen));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_getExtension(&rtpPacket, DEFAULT_RRID_EXT_ID, &pData, &dataLen));
+    EXPECT_EQ(STRLEN(rid), dataLen);
+    EXPECT_EQ(0, MEMCMP(pData, rid, STRLEN(rid)));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_getExtension(&rtpPacket, DEFAULT_MID_EXT_ID, &pData, &dataLen));
+    EXPECT_EQ(0, MEMCMP(pData, mid, STRLEN(mid)));
+
+    // The two-byte header takes any id
+    EXPECT_EQ(STATUS_SUCCESS, rtp_extension_map_set(&extensionMap, RTP_EXTENSION_RID, 100));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_extension_layout_build(&extensionMap, &elements, &layout));
+    EXPECT_EQ(RTP_TWO_BYTE_EXTENSION_PROFILE, layout.profile);
+    rtp_extension_layout_apply(&layout, &rtpPacket);
+    EXPECT_EQ(STATUS_SUCCESS, rtp_extension_renameElement(&rtpPacket, 100, 200));
+    EXPECT_EQ(STATUS_RTP_EXTENSION_NOT_FOUND, rtp_packet_getExtension(&rtpPacket, 100, &pData, &dataLen));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_getExtension(&rtpPacket, 200, &pData, &dataLen));
+    EXPECT_EQ(STRLEN(rid), dataLen);
+    EXPECT_EQ(0, MEMCMP(pData, rid, STRLEN(rid)));
+}
+
+TEST_F(RtpFunctionalityTest, simulcastFrameIsWrittenToItsEncoding)
+{
+    PRtcRtpSender pLowSender = nullptr;
+    PRtpPacket pRtpPacket = nullptr;
+    RtpExtensionElements elements;
+    std::vector<BYTE> frameData(100, 0x5A);
+    Frame frame{};
+    UINT16 highSequenceNumber, lowSequenceNumber;
+    UINT64 index = 0;
+    UINT32 indexCount = 1;
+
+    initSimulcastTransceiver();
+    pLowSender = rtp_transceiver_getSender(pKvsRtpTransceiver, 1);
+    ASSERT_NE(nullptr, pLowSender);
+    EXPECT_EQ(nullptr, rtp_transceiver_getSender(pKvsRtpTransceiver, 2));
+    EXPECT_NE(pKvsRtpTransceiver->sender.ssrc, pLowSender->ssrc);
+    EXPECT_NE(pKvsRtpTransceiver->sender.packetBuffer, pLowSender->packetBuffer);
+
+    frame.frameData = frameData.data();
+    frame.size = (UINT32) frameData.size();
+    frame.flags = FRAME_FLAG_KEY_FRAME;
+    EXPECT_EQ(STATUS_INVALID_ARG, rtp_writeSimulcastFrame(pRtcRtpTransceiver, 2, &frame));
+
+    // Every encoding numbers its own packets
+    highSequenceNumber = pKvsRtpTransceiver->sender.sequenceNumber;
+    lowSequenceNumber = pLowSender->sequenceNumber;
+    EXPECT_EQ(STATUS_SUCCESS, rtp_writeSimulcastFrame(pRtcRtpTransceiver, 1, &frame));
+    EXPECT_EQ(highSequenceNumber, pKvsRtpTransceiver->sender.sequenceNumber);
+    EXPECT_EQ(GET_UINT16_SEQ_NUM(lowSequenceNumber + 1), pLowSender->sequenceNumber);
+    EXPECT_EQ(STATUS_SUCCESS, rtp_writeSimulcastFrame(pRtcRtpTransceiver, 0, &frame));
+    EXPECT_EQ(GET_UINT16_SEQ_NUM(highSequenceNumber + 1), pKvsRtpTransceiver->sender.sequenceNumber);
+    EXPECT_EQ(GET_UINT16_SEQ_NUM(lowSequenceNumber + 1), pLowSender->sequenceNumber);
+
+    // The packet is kept by the rolling buffer of its encoding, in the clear since the rtx packets are built from it
+    ASSERT_EQ(STATUS_SUCCESS, rtp_rolling_buffer_getValidSeqIndexList(pLowSender->packetBuffer, &lowSequenceNumber, 1, &index, &indexCount));
+    ASSERT_EQ(1, indexCount);
+    ASSERT_EQ(STATUS_SUCCESS, rtp_rolling_buffer_getRtpPacket(pLowSender->packetBuffer, index, &pRtpPacket));
+    ASSERT_NE(nullptr, pRtpPacket);
+    EXPECT_EQ(pLowSender->ssrc, pRtpPacket->header.ssrc);
+    EXPECT_EQ(pLowSender->payloadType, pRtpPacket->header.payloadType);
+    EXPECT_EQ(STATUS_SUCCESS, rtp_extension_parse(&pKvsPeerConnection->extensionMap, pRtpPacket, &elements));
+    ASSERT_EQ(STRLEN("l"), elements.length[RTP_EXTENSION_RID]);
+    EXPECT_EQ(0, MEMCMP(elements.pData[RTP_EXTENSION_RID], "l", STRLEN("l")));
+    EXPECT_EQ(nullptr, elements.pData[RTP_EXTENSION_RRID]);
+    rtp_packet_free(&pRtpPacket);
+
+    // Without simulcast in the answer only the first encoding is sent
+    pKvsRtpTransceiver->simulcastNegotiated = FALSE;
+    EXPECT_EQ(STATUS_SUCCESS, rtp_writeSimulcastFrame(pRtcRtpTransceiver, 1, &frame));
+    EXPECT_EQ(GET_UINT16_SEQ_NUM(lowSequenceNumber + 1), pLowSender->sequenceNumber);
+
+    EXPECT_EQ(STATUS_SUCCESS, pc_free(&pRtcPeerConnection));
+}
+
+TEST_F(RtpFunctionalityTest, simulcastNackIsRepairedOnTheRtxStreamOfItsEncoding)
+{
+    PRtcRtpSender pLowSender = nullptr;
+    std::vector<BYTE> frameData(100, 0x5A);
+    Frame frame{};
+    RtcOutboundRtpStreamStats stats{};
+    BYTE nack[] = {0x81, 0xcd, 0x00, 0x03, 0x2c, 0xd1, 0xa0, 0xde, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+    UINT16 highRtxSequenceNumber, lowRtxSequenceNumber;
+
+    initSimulcastTransceiver();
+    pLowSender = rtp_transceiver_getSender(pKvsRtpTransceiver, 1);
+    ASSERT_NE(nullptr, pLowSender);
+    EXPECT_NE(pLowSender->payloadType, pLowSender->rtxPayloadType);
+    EXPECT_NE(pKvsRtpTransceiver->sender.rtxSsrc, pLowSender->rtxSsrc);
+
+    frame.frameData = frameData.data();
+    frame.size = (UINT32) frameData.size();
+    frame.flags = FRAME_FLAG_KEY_FRAME;
+    EXPECT_EQ(STATUS_SUCCESS, rtp_writeSimulcastFrame(pRtcRtpTransceiver, 0, &frame));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_writeSimulcastFrame(pRtcRtpTransceiver, 1, &frame));
+
+    // The media ssrc of the nack picks the encoding, the lost packet is resent on the rtx stream of that encoding only
+    putUnalignedInt32BigEndian(nack + 8, pLowSender->ssrc);
+    putUnalignedInt16BigEndian(nack + 12, GET_UINT16_SEQ_NUM(pLowSender->sequenceNumber - 1));
+    highRtxSequenceNumber = pKvsRtpTransceiver->sender.rtxSequenceNumber;
+    lowRtxSequenceNumber = pLowSender->rtxSequenceNumber;
+    EXPECT_EQ(STATUS_SUCCESS, rtcp_onInboundPacket(pKvsPeerConnection, nack, SIZEOF(nack)));
+    EXPECT_EQ(highRtxSequenceNumber, pKvsRtpTransceiver->sender.rtxSequenceNumber);
+    EXPECT_EQ(GET_UINT16_SEQ_NUM(lowRtxSequenceNumber + 1), pLowSender->rtxSequenceNumber);
+
+    EXPECT_EQ(STATUS_SUCCESS, metrics_getRtpOutboundStats(pRtcPeerConnection, nullptr, &stats));
+    EXPECT_EQ(1, stats.nackCount);
+    EXPECT_EQ(1, stats.retransmittedPacketsSent);
+
+    EXPECT_EQ(STATUS_SUCCESS, pc_free(&pRtcPeerConnection));
+}
+
 } // namespace webrtcclient
 } // namespace video
 } // namespace kinesis
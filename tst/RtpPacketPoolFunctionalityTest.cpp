@@ -0,0 +1,160 @@
+#include "WebRTCClientTestFixture.h"
+
+namespace com {
+namespace amazonaws {
+namespace kinesis {
+namespace video {
+namespace webrtcclient {
+
+class RtpPacketPoolFunctionalityTest : public WebRtcClientTestBase {
+};
+
+TEST_F(RtpPacketPoolFunctionalityTest, packetsAreRecycledWithoutAllocation)
+{
+    PRtpPacketPool pRtpPacketPool = NULL;
+    PRtpPacket pRtpPacket = NULL, pPooledPacket = NULL;
+    PRtpRollingBuffer pRtpRollingBuffer = NULL;
+    RtcRtpPacketPoolStats stats;
+    SIZE_T allocationCount;
+    UINT32 i;
+
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_create(4, 64, &pRtpPacketPool));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_rolling_buffer_create(3, &pRtpRollingBuffer));
+    EXPECT_EQ(STATUS_SUCCESS, createRtpPacketWithSeqNum(0, &pRtpPacket));
+
+    // The first packet allocates the slots
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_get(pRtpPacketPool, 64, &pPooledPacket));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_free(&pPooledPacket));
+
+    allocationCount = getInstrumentedTotalAllocationCount();
+    for (i = 0; i < 100; i++) {
+        pRtpPacket->header.sequenceNumber = GET_UINT16_SEQ_NUM(i);
+        EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_get(pRtpPacketPool, 64, &pPooledPacket));
+        EXPECT_EQ(pRtpPacketPool, pPooledPacket->pPool);
+        EXPECT_EQ(1, pPooledPacket->refCount);
+        pPooledPacket->rawPacketLength = 64;
+        EXPECT_EQ(STATUS_SUCCESS, rtp_packet_createBytesFromPacket(pRtpPacket, pPooledPacket->pRawPacket, &pPooledPacket->rawPacketLength));
+        EXPECT_EQ(STATUS_SUCCESS, rtp_packet_setPacketFromBytes(pPooledPacket->pRawPacket, pPooledPacket->rawPacketLength, pPooledPacket));
+        EXPECT_EQ(STATUS_SUCCESS, rtp_rolling_buffer_commitRtpPacket(pRtpRollingBuffer, pPooledPacket));
+    }
+    EXPECT_EQ(allocationCount, getInstrumentedTotalAllocationCount());
+    EXPECT_EQ(99, pRtpRollingBuffer->lastIndex);
+
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_getStats(pRtpPacketPool, &stats));
+    EXPECT_EQ(4, stats.capacity);
+    EXPECT_EQ(64, stats.packetSize);
+    EXPECT_EQ(3, stats.packetsInUse);
+    EXPECT_EQ(4, stats.highWaterMark);
+    EXPECT_EQ(0, stats.poolMisses);
+
+    EXPECT_EQ(STATUS_SUCCESS, rtp_rolling_buffer_free(&pRtpRollingBuffer));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_getStats(pRtpPacketPool, &stats));
+    EXPECT_EQ(0, stats.packetsInUse);
+
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_free(&pRtpPacket));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_free(&pRtpPacketPool));
+}
+
+TEST_F(RtpPacketPoolFunctionalityTest, packetIsReleasedWithLastReference)
+{
+    PRtpPacketPool pRtpPacketPool = NULL;
+    PRtpPacket pRtpPacket = NULL, pSecondRef = NULL;
+    RtcRtpPacketPoolStats stats;
+
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_create(2, 64, &pRtpPacketPool));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_get(pRtpPacketPool, 32, &pRtpPacket));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_addRef(pRtpPacket));
+    pSecondRef = pRtpPacket;
+
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_free(&pRtpPacket));
+    EXPECT_EQ((PRtpPacket) NULL, pRtpPacket);
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_getStats(pRtpPacketPool, &stats));
+    EXPECT_EQ(1, stats.packetsInUse);
+
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_free(&pSecondRef));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_getStats(pRtpPacketPool, &stats));
+    EXPECT_EQ(0, stats.packetsInUse);
+    EXPECT_EQ(1, stats.highWaterMark);
+
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_free(&pRtpPacketPool));
+}
+
+TEST_F(RtpPacketPoolFunctionalityTest, exhaustedPoolFallsBackToHeap)
+{
+    PRtpPacketPool pRtpPacketPool = NULL;
+    PRtpPacket pRtpPackets[3] = {NULL};
+    PRtpPacket pOversizedPacket = NULL;
+    RtcRtpPacketPoolStats stats;
+    UINT32 i;
+
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_create(2, 64, &pRtpPacketPool));
+    for (i = 0; i < ARRAY_SIZE(pRtpPackets); i++) {
+        EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_get(pRtpPacketPool, 64, &pRtpPackets[i]));
+        EXPECT_TRUE(pRtpPackets[i] != NULL && pRtpPackets[i]->pRawPacket != NULL);
+    }
+    EXPECT_EQ((PRtpPacketPool) NULL, pRtpPackets[2]->pPool);
+
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_get(pRtpPacketPool, 128, &pOversizedPacket));
+    EXPECT_EQ((PRtpPacketPool) NULL, pOversizedPacket->pPool);
+
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_getStats(pRtpPacketPool, &stats));
+    EXPECT_EQ(2, stats.packetsInUse);
+    EXPECT_EQ(2, stats.highWaterMark);
+    EXPECT_EQ(2, stats.poolMisses);
+
+    for (i = 0; i < ARRAY_SIZE(pRtpPackets); i++) {
+        EXPECT_EQ(STATUS_SUCCESS, rtp_packet_free(&pRtpPackets[i]));
+    }
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_free(&pOversizedPacket));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_getStats(pRtpPacketPool, &stats));
+    EXPECT_EQ(0, stats.packetsInUse);
+
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_free(&pRtpPacketPool));
+}
+
+TEST_F(RtpPacketPoolFunctionalityTest, reservedPacketsAreServedByThePool)
+{
+    PRtpPacketPool pRtpPacketPool = NULL;
+    PRtpPacket pRtpPackets[5] = {NULL};
+    RtcRtpPacketPoolStats stats;
+    UINT32 i;
+
+    EXPECT_EQ(STATUS_NULL_ARG, rtp_packet_pool_reserve(NULL, 1));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_create(2, 64, &pRtpPacketPool));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_get(pRtpPacketPool, 64, &pRtpPackets[0]));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_get(pRtpPacketPool, 64, &pRtpPackets[1]));
+
+    // The reservation is carved out once the slots allocated so far are in use
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_reserve(pRtpPacketPool, 3));
+    for (i = 2; i < ARRAY_SIZE(pRtpPackets); i++) {
+        EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_get(pRtpPacketPool, 64, &pRtpPackets[i]));
+        EXPECT_EQ(pRtpPacketPool, pRtpPackets[i]->pPool);
+    }
+
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_getStats(pRtpPacketPool, &stats));
+    EXPECT_EQ(5, stats.capacity);
+    EXPECT_EQ(5, stats.packetsInUse);
+    EXPECT_EQ(0, stats.poolMisses);
+
+    // Every packet of both allocations goes back to the pool
+    for (i = 0; i < ARRAY_SIZE(pRtpPackets); i++) {
+        EXPECT_EQ(STATUS_SUCCESS, rtp_packet_free(&pRtpPackets[i]));
+    }
+    for (i = 0; i < ARRAY_SIZE(pRtpPackets); i++) {
+        EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_get(pRtpPacketPool, 64, &pRtpPackets[i]));
+        EXPECT_EQ(pRtpPacketPool, pRtpPackets[i]->pPool);
+    }
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_getStats(pRtpPacketPool, &stats));
+    EXPECT_EQ(0, stats.poolMisses);
+
+    for (i = 0; i < ARRAY_SIZE(pRtpPackets); i++) {
+        EXPECT_EQ(STATUS_SUCCESS, rtp_packet_free(&pRtpPackets[i]));
+    }
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_free(&pRtpPacketPool));
+}
+
+} // namespace webrtcclient
+} // namespace video
+} // namespace kinesis
+} // namespace amazonaws
+} // namespace com
@@ -155,6 +155,39 @@ TEST_F(RtpRollingBufferFunctionalityTest, getIndexForSeqListReturnCorrectIndexsW
     EXPECT_EQ(STATUS_SUCCESS, rtp_packet_free(&pRtpPacket));
 }
 
+TEST_F(RtpRollingBufferFunctionalityTest, getRtpPacketKeepsPacketAliveAfterEviction)
+{
+    PRtpRollingBuffer pRtpRollingBuffer;
+    PRtpPacket pRtpPacket = NULL, pBufferedPacket = NULL;
+
+    // add 0 1 2, capacity is 3, all of them are in
+    pushConsecutiveRtpPacketsIntoBuffer(3, 3, &pRtpRollingBuffer, &pRtpPacket);
+
+    EXPECT_EQ(STATUS_SUCCESS, rtp_rolling_buffer_getRtpPacket(pRtpRollingBuffer, 0, &pBufferedPacket));
+    ASSERT_TRUE(pBufferedPacket != NULL);
+    EXPECT_EQ(0, pBufferedPacket->header.sequenceNumber);
+    EXPECT_EQ(2, pBufferedPacket->refCount);
+
+    // 3 evicts 0, the extra reference keeps it alive
+    updateRtpPacketSeqNum(pRtpPacket, 3);
+    EXPECT_EQ(STATUS_SUCCESS, rtp_rolling_buffer_addRtpPacket(pRtpRollingBuffer, pRtpPacket));
+    EXPECT_EQ(1, pBufferedPacket->refCount);
+    EXPECT_EQ(0, pBufferedPacket->header.sequenceNumber);
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_free(&pBufferedPacket));
+    EXPECT_EQ((PRtpPacket) NULL, pBufferedPacket);
+
+    // index 0 is gone, index 3 is in
+    EXPECT_EQ(STATUS_SUCCESS, rtp_rolling_buffer_getRtpPacket(pRtpRollingBuffer, 0, &pBufferedPacket));
+    EXPECT_EQ((PRtpPacket) NULL, pBufferedPacket);
+    EXPECT_EQ(STATUS_SUCCESS, rtp_rolling_buffer_getRtpPacket(pRtpRollingBuffer, 3, &pBufferedPacket));
+    ASSERT_TRUE(pBufferedPacket != NULL);
+    EXPECT_EQ(3, pBufferedPacket->header.sequenceNumber);
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_free(&pBufferedPacket));
+
+    EXPECT_EQ(STATUS_SUCCESS, rtp_rolling_buffer_free(&pRtpRollingBuffer));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_free(&pRtpPacket));
+}
+
 } // namespace webrtcclient
 } // namespace video
 } // namespace kinesis
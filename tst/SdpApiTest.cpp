@@ -222,7 +222,10 @@ TEST_F(SdpApiTest, setTransceiverPayloadTypes_NoRtxType)
     PHashTable pCodecTable;
     PHashTable pRtxTable;
     PDoubleList pTransceivers;
+    PRtpPacketPool pRtpPacketPool;
+    RtcRtpPacketPoolStats stats;
     KvsRtpTransceiver transceiver;
+    MEMSET(&transceiver, 0x00, SIZEOF(KvsRtpTransceiver));
     transceiver.sender.track.codec = RTC_CODEC_H264_PROFILE_42E01F_LEVEL_ASYMMETRY_ALLOWED_PACKETIZATION_MODE;
     transceiver.transceiver.direction = RTC_RTP_TRANSCEIVER_DIRECTION_SENDRECV;
     transceiver.sender.packetBuffer = NULL;
@@ -232,14 +235,18 @@ TEST_F(SdpApiTest, setTransceiverPayloadTypes_NoRtxType)
     EXPECT_EQ(STATUS_SUCCESS, hashTableCreate(&pRtxTable));
     EXPECT_EQ(STATUS_SUCCESS, double_list_create(&pTransceivers));
     EXPECT_EQ(STATUS_SUCCESS, double_list_insertItemHead(pTransceivers, (UINT64)(&transceiver)));
-    EXPECT_EQ(STATUS_SUCCESS, sdp_setTransceiverPayloadTypes(pCodecTable, pRtxTable, pTransceivers));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_create(DEFAULT_RTP_PACKET_POOL_SIZE, RTP_PACKET_SLOT_SIZE(DEFAULT_MTU_SIZE), &pRtpPacketPool));
+    EXPECT_EQ(STATUS_SUCCESS, sdp_setTransceiverPayloadTypes(pCodecTable, pRtxTable, pRtpPacketPool, pTransceivers));
     EXPECT_EQ(1, transceiver.sender.payloadType);
     EXPECT_NE((PRtpRollingBuffer) NULL, transceiver.sender.packetBuffer);
     EXPECT_NE((PRetransmitter) NULL, transceiver.sender.retransmitter);
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_getStats(pRtpPacketPool, &stats));
+    EXPECT_EQ(DEFAULT_RTP_PACKET_POOL_SIZE + DEFAULT_ROLLING_BUFFER_CAPACITY, stats.capacity);
     hash_table_free(pCodecTable);
     hash_table_free(pRtxTable);
     rtp_rolling_buffer_free(&transceiver.sender.packetBuffer);
     retransmitter_free(&transceiver.sender.retransmitter);
+    rtp_packet_pool_free(&pRtpPacketPool);
     doubleListFree(pTransceivers);
 }
 
@@ -248,7 +255,10 @@ TEST_F(SdpApiTest, setTransceiverPayloadTypes_HasRtxType)
     PHashTable pCodecTable;
     PHashTable pRtxTable;
     PDoubleList pTransceivers;
+    PRtpPacketPool pRtpPacketPool;
+    RtcRtpPacketPoolStats stats;
     KvsRtpTransceiver transceiver;
+    MEMSET(&transceiver, 0x00, SIZEOF(KvsRtpTransceiver));
     transceiver.sender.track.codec = RTC_CODEC_H264_PROFILE_42E01F_LEVEL_ASYMMETRY_ALLOWED_PACKETIZATION_MODE;
     transceiver.transceiver.direction = RTC_RTP_TRANSCEIVER_DIRECTION_SENDRECV;
     transceiver.sender.packetBuffer = NULL;
@@ -259,15 +269,53 @@ TEST_F(SdpApiTest, setTransceiverPayloadTypes_HasRtxType)
     EXPECT_EQ(STATUS_SUCCESS, hash_table_put(pRtxTable, RTC_RTX_CODEC_H264_PROFILE_42E01F_LEVEL_ASYMMETRY_ALLOWED_PACKETIZATION_MODE, 2));
     EXPECT_EQ(STATUS_SUCCESS, double_list_create(&pTransceivers));
     EXPECT_EQ(STATUS_SUCCESS, double_list_insertItemHead(pTransceivers, (UINT64)(&transceiver)));
-    EXPECT_EQ(STATUS_SUCCESS, sdp_setTransceiverPayloadTypes(pCodecTable, pRtxTable, pTransceivers));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_create(DEFAULT_RTP_PACKET_POOL_SIZE, RTP_PACKET_SLOT_SIZE(DEFAULT_MTU_SIZE), &pRtpPacketPool));
+    EXPECT_EQ(STATUS_SUCCESS, sdp_setTransceiverPayloadTypes(pCodecTable, pRtxTable, pRtpPacketPool, pTransceivers));
     EXPECT_EQ(1, transceiver.sender.payloadType);
     EXPECT_EQ(2, transceiver.sender.rtxPayloadType);
     EXPECT_NE((PRtpRollingBuffer) NULL, transceiver.sender.packetBuffer);
     EXPECT_NE((PRetransmitter) NULL, transceiver.sender.retransmitter);
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_pool_getStats(pRtpPacketPool, &stats));
+    EXPECT_EQ(DEFAULT_RTP_PACKET_POOL_SIZE + DEFAULT_ROLLING_BUFFER_CAPACITY, stats.capacity);
     hash_table_free(pCodecTable);
     hash_table_free(pRtxTable);
     rtp_rolling_buffer_free(&transceiver.sender.packetBuffer);
     retransmitter_free(&transceiver.sender.retransmitter);
+    rtp_packet_pool_free(&pRtpPacketPool);
+    doubleListFree(pTransceivers);
+}
+
+TEST_F(SdpApiTest, setReceiversSsrc_KeyFrameRequestFeedback)
+{
+    std::string remoteSessionDescription = R"(v=0
+o=- 1904080082932320671 2 IN IP4 127.0.0.1
+s=-
+t=0 0
+m=video 9 UDP/TLS/RTP/SAVPF 96
+a=rtpmap:96 H264/90000
+a=rtcp-fb:96 nack
+a=rtcp-fb:96 ccm fir
+a=ssrc:1234 cname:remote
+)";
+
+    SessionDescription sessionDescription;
+    PDoubleList pTransceivers;
+    KvsRtpTransceiver transceiver;
+    MEMSET(&sessionDescription, 0x00, SIZEOF(SessionDescription));
+    MEMSET(&transceiver, 0x00, SIZEOF(KvsRtpTransceiver));
+    transceiver.sender.track.codec = RTC_CODEC_H264_PROFILE_42E01F_LEVEL_ASYMMETRY_ALLOWED_PACKETIZATION_MODE;
+    transceiver.transceiver.receiver.track.kind = MEDIA_STREAM_TRACK_KIND_VIDEO;
+    auto converted = lfToCRLF((PCHAR) remoteSessionDescription.c_str(), remoteSessionDescription.size());
+    EXPECT_EQ(STATUS_SUCCESS, deserializeSessionDescription(&sessionDescription, (PCHAR) converted.c_str()));
+    EXPECT_EQ(STATUS_SUCCESS, double_list_create(&pTransceivers));
+    EXPECT_EQ(STATUS_SUCCESS, double_list_insertItemHead(pTransceivers, (UINT64)(&transceiver)));
+    EXPECT_EQ(STATUS_SUCCESS, sdp_setReceiversSsrc(&sessionDescription, pTransceivers));
+
+    // A remote peer without "nack pli" gets full intra requests
+    EXPECT_EQ(1234, transceiver.jitterBufferSsrc);
+    EXPECT_TRUE(transceiver.remoteAcceptsNack);
+    EXPECT_FALSE(transceiver.remoteAcceptsPli);
+    EXPECT_TRUE(transceiver.remoteAcceptsFir);
     doubleListFree(pTransceivers);
 }
 
@@ -302,6 +350,119 @@ TEST_F(SdpApiTest, populateSingleMediaSection_TestTxSendRecv)
     pc_free(&offerPc);
 }
 
+TEST_F(SdpApiTest, populateSingleMediaSection_TestTransportWideCongestionControl)
+{
+    PRtcPeerConnection offerPc = NULL;
+    RtcConfiguration configuration;
+    RtcSessionDescriptionInit sessionDescriptionInit;
+    RtcMediaStreamTrack track;
+    PRtcRtpTransceiver pTransceiver;
+    RtcRtpTransceiverInit rtcRtpTransceiverInit;
+    BOOL disableTwcc;
+
+    rtcRtpTransceiverInit.direction = RTC_RTP_TRANSCEIVER_DIRECTION_SENDRECV;
+    MEMSET(&track, 0x00, SIZEOF(RtcMediaStreamTrack));
+    track.kind = MEDIA_STREAM_TRACK_KIND_VIDEO;
+    track.codec = RTC_CODEC_H264_PROFILE_42E01F_LEVEL_ASYMMETRY_ALLOWED_PACKETIZATION_MODE;
+    STRCPY(track.streamId, "myKvsVideoStream");
+    STRCPY(track.trackId, "myTrack");
+
+    for (disableTwcc = FALSE; disableTwcc <= TRUE; disableTwcc++) {
+        MEMSET(&configuration, 0x00, SIZEOF(RtcConfiguration));
+        // The extension is negotiated unless both the estimation and the feedback are disabled
+        configuration.kvsRtcConfiguration.disableSenderSideBandwidthEstimation = disableTwcc;
+        configuration.kvsRtcConfiguration.disableTwccFeedback = disableTwcc;
+        EXPECT_EQ(pc_create(&configuration, &offerPc), STATUS_SUCCESS);
+        EXPECT_EQ(STATUS_SUCCESS, pc_addTransceiver(offerPc, &track, &rtcRtpTransceiverInit, &pTransceiver));
+        EXPECT_EQ(STATUS_SUCCESS, pc_createOffer(offerPc, &sessionDescriptionInit));
+
+        if (disableTwcc) {
+            EXPECT_PRED_FORMAT2(testing::IsNotSubstring, TWCC_EXT_URL, sessionDescriptionInit.sdp);
+            EXPECT_PRED_FORMAT2(testing::IsNotSubstring, "transport-cc", sessionDescriptionInit.sdp);
+        } else {
+            EXPECT_PRED_FORMAT2(testing::IsSubstring, TWCC_EXT_URL, sessionDescriptionInit.sdp);
+            EXPECT_PRED_FORMAT2(testing::IsSubstring, "rtcp-fb:* transport-cc", sessionDescriptionInit.sdp);
+        }
+
+        pc_close(offerPc);
+        pc_free(&offerPc);
+    }
+}
+
+TEST_F(SdpApiTest, populateSingleMediaSection_TestFlexFec)
+{
+    PRtcPeerConnection offerPc = NULL;
+    RtcConfiguration configuration;
+    RtcSessionDescriptionInit sessionDescriptionInit;
+    RtcMediaStreamTrack track;
+    PRtcRtpTransceiver pTransceiver;
+    RtcRtpTransceiverInit rtcRtpTransceiverInit;
+    BOOL enableFlexFec;
+
+    rtcRtpTransceiverInit.direction = RTC_RTP_TRANSCEIVER_DIRECTION_SENDRECV;
+    MEMSET(&track, 0x00, SIZEOF(RtcMediaStreamTrack));
+    track.kind = MEDIA_STREAM_TRACK_KIND_VIDEO;
+    track.codec = RTC_CODEC_H264_PROFILE_42E01F_LEVEL_ASYMMETRY_ALLOWED_PACKETIZATION_MODE;
+    STRCPY(track.streamId, "myKvsVideoStream");
+    STRCPY(track.trackId, "myTrack");
+
+    for (enableFlexFec = FALSE; enableFlexFec <= TRUE; enableFlexFec++) {
+        MEMSET(&configuration, 0x00, SIZEOF(RtcConfiguration));
+        configuration.kvsRtcConfiguration.enableFlexFec = enableFlexFec;
+        EXPECT_EQ(pc_create(&configuration, &offerPc), STATUS_SUCCESS);
+        EXPECT_EQ(STATUS_SUCCESS, pc_addTransceiver(offerPc, &track, &rtcRtpTransceiverInit, &pTransceiver));
+        EXPECT_EQ(STATUS_SUCCESS, pc_createOffer(offerPc, &sessionDescriptionInit));
+
+        if (enableFlexFec) {
+            EXPECT_PRED_FORMAT2(testing::IsSubstring, FLEXFEC_VALUE, sessionDescriptionInit.sdp);
+            EXPECT_PRED_FORMAT2(testing::IsSubstring, "ssrc-group:FEC-FR", sessionDescriptionInit.sdp);
+        } else {
+            EXPECT_PRED_FORMAT2(testing::IsNotSubstring, FLEXFEC_VALUE, sessionDescriptionInit.sdp);
+            EXPECT_PRED_FORMAT2(testing::IsNotSubstring, "FEC-FR", sessionDescriptionInit.sdp);
+        }
+
+        pc_close(offerPc);
+        pc_free(&offerPc);
+    }
+}
+
+TEST_F(SdpApiTest, populateSingleMediaSection_TestRed)
+{
+    PRtcPeerConnection offerPc = NULL;
+    RtcConfiguration configuration;
+    RtcSessionDescriptionInit sessionDescriptionInit;
+    RtcMediaStreamTrack track;
+    PRtcRtpTransceiver pTransceiver;
+    RtcRtpTransceiverInit rtcRtpTransceiverInit;
+    UINT32 opusRedundancy;
+
+    rtcRtpTransceiverInit.direction = RTC_RTP_TRANSCEIVER_DIRECTION_SENDRECV;
+    MEMSET(&track, 0x00, SIZEOF(RtcMediaStreamTrack));
+    track.kind = MEDIA_STREAM_TRACK_KIND_AUDIO;
+    track.codec = RTC_CODEC_OPUS;
+    STRCPY(track.streamId, "myKvsAudioStream");
+    STRCPY(track.trackId, "myTrack");
+
+    for (opusRedundancy = 0; opusRedundancy <= 1; opusRedundancy++) {
+        MEMSET(&configuration, 0x00, SIZEOF(RtcConfiguration));
+        configuration.kvsRtcConfiguration.opusRedundancy = opusRedundancy;
+        EXPECT_EQ(pc_create(&configuration, &offerPc), STATUS_SUCCESS);
+        EXPECT_EQ(STATUS_SUCCESS, pc_addTransceiver(offerPc, &track, &rtcRtpTransceiverInit, &pTransceiver));
+        EXPECT_EQ(STATUS_SUCCESS, pc_createOffer(offerPc, &sessionDescriptionInit));
+
+        if (opusRedundancy != 0) {
+            EXPECT_PRED_FORMAT2(testing::IsSubstring, "m=audio 9 UDP/TLS/RTP/SAVPF 111 63", sessionDescriptionInit.sdp);
+            EXPECT_PRED_FORMAT2(testing::IsSubstring, "a=rtpmap:63 red/48000/2", sessionDescriptionInit.sdp);
+            EXPECT_PRED_FORMAT2(testing::IsSubstring, "a=fmtp:63 111/111", sessionDescriptionInit.sdp);
+        } else {
+            EXPECT_PRED_FORMAT2(testing::IsNotSubstring, RED_VALUE, sessionDescriptionInit.sdp);
+        }
+
+        pc_close(offerPc);
+        pc_free(&offerPc);
+    }
+}
+
 TEST_F(SdpApiTest, populateSingleMediaSection_TestTxSendRecvMaxTransceivers)
 {
     PRtcPeerConnection offerPc = NULL;
@@ -848,6 +1009,314 @@ a=fmtp:102 strange
     });
 }
 
+TEST_F(SdpApiTest, populateSingleMediaSection_TestH265)
+{
+    CHAR remoteSessionDescription[] = R"(v=0
+o=- 7732334361409071710 2 IN IP4 127.0.0.1
+s=-
+t=0 0
+a=group:BUNDLE 0
+a=msid-semantic: WMS
+m=video 16485 UDP/TLS/RTP/SAVPF 96 98 99
+c=IN IP4 205.251.233.176
+a=rtcp:9 IN IP4 0.0.0.0
+a=ice-ufrag:9YRc
+a=ice-pwd:/ELMEiczRSsx2OEi2ynq+TbZ
+a=ice-options:trickle
+a=fingerprint:sha-256 51:04:F9:20:45:5C:9D:85:AF:D7:AF:FB:2B:F8:DB:24:66:7B:6A:E3:E3:EF:EC:72:93:6E:01:B8:C9:53:A6:31
+a=setup:actpass
+a=mid:1
+a=recvonly
+a=rtcp-mux
+a=rtcp-rsize
+a=rtpmap:96 VP8/90000
+a=rtpmap:98 H265/90000
+a=fmtp:98 level-id=120;profile-id=1;tier-flag=0;tx-mode=SRST
+a=rtpmap:99 rtx/90000
+a=fmtp:99 apt=98
+)";
+
+    assertLFAndCRLF(remoteSessionDescription, ARRAY_SIZE(remoteSessionDescription) - 1, [](PCHAR sdp) {
+        PRtcPeerConnection pRtcPeerConnection = NULL;
+        PRtcRtpTransceiver pRtcRtpTransceiver = NULL;
+        RtcConfiguration rtcConfiguration;
+        RtcMediaStreamTrack rtcMediaStreamTrack;
+        RtcRtpTransceiverInit rtcRtpTransceiverInit;
+        RtcSessionDescriptionInit rtcSessionDescriptionInit;
+
+        MEMSET(&rtcConfiguration, 0x00, SIZEOF(RtcConfiguration));
+        MEMSET(&rtcMediaStreamTrack, 0x00, SIZEOF(RtcMediaStreamTrack));
+        MEMSET(&rtcSessionDescriptionInit, 0x00, SIZEOF(RtcSessionDescriptionInit));
+
+        EXPECT_EQ(pc_create(&rtcConfiguration, &pRtcPeerConnection), STATUS_SUCCESS);
+        EXPECT_EQ(pc_addSupportedCodec(pRtcPeerConnection, RTC_CODEC_H265), STATUS_SUCCESS);
+
+        rtcRtpTransceiverInit.direction = RTC_RTP_TRANSCEIVER_DIRECTION_SENDONLY;
+        rtcMediaStreamTrack.kind = MEDIA_STREAM_TRACK_KIND_VIDEO;
+        rtcMediaStreamTrack.codec = RTC_CODEC_H265;
+        STRCPY(rtcMediaStreamTrack.streamId, "myKvsVideoStream");
+        STRCPY(rtcMediaStreamTrack.trackId, "myTrack");
+        EXPECT_EQ(pc_addTransceiver(pRtcPeerConnection, &rtcMediaStreamTrack, &rtcRtpTransceiverInit, &pRtcRtpTransceiver), STATUS_SUCCESS);
+
+        STRCPY(rtcSessionDescriptionInit.sdp, (PCHAR) sdp);
+        rtcSessionDescriptionInit.type = SDP_TYPE_OFFER;
+        EXPECT_EQ(pc_setRemoteDescription(pRtcPeerConnection, &rtcSessionDescriptionInit), STATUS_SUCCESS);
+        EXPECT_EQ(pc_createAnswer(pRtcPeerConnection, &rtcSessionDescriptionInit), STATUS_SUCCESS);
+        // The payload type and the profile of the offer are kept, the retransmissions use the rtx payload type
+        EXPECT_PRED_FORMAT2(testing::IsSubstring, "video 9 UDP/TLS/RTP/SAVPF 98 99", rtcSessionDescriptionInit.sdp);
+        EXPECT_PRED_FORMAT2(testing::IsSubstring, "rtpmap:98 H265/90000", rtcSessionDescriptionInit.sdp);
+        EXPECT_PRED_FORMAT2(testing::IsSubstring, "fmtp:98 level-id=120;profile-id=1;tier-flag=0;tx-mode=SRST", rtcSessionDescriptionInit.sdp);
+        EXPECT_PRED_FORMAT2(testing::IsSubstring, "fmtp:99 apt=98", rtcSessionDescriptionInit.sdp);
+        EXPECT_EQ(99, ((PKvsRtpTransceiver) pRtcRtpTransceiver)->sender.rtxPayloadType);
+        pc_close(pRtcPeerConnection);
+        pc_free(&pRtcPeerConnection);
+    });
+}
+
+TEST_F(SdpApiTest, populateSingleMediaSection_TestH265Offer)
+{
+    PRtcPeerConnection offerPc = NULL;
+    RtcConfiguration configuration;
+    RtcSessionDescriptionInit sessionDescriptionInit;
+    RtcMediaStreamTrack track;
+    PRtcRtpTransceiver pTransceiver;
+    RtcRtpTransceiverInit rtcRtpTransceiverInit;
+
+    MEMSET(&configuration, 0x00, SIZEOF(RtcConfiguration));
+    MEMSET(&track, 0x00, SIZEOF(RtcMediaStreamTrack));
+    rtcRtpTransceiverInit.direction = RTC_RTP_TRANSCEIVER_DIRECTION_SENDRECV;
+    track.kind = MEDIA_STREAM_TRACK_KIND_VIDEO;
+    track.codec = RTC_CODEC_H265;
+    STRCPY(track.streamId, "myKvsVideoStream");
+    STRCPY(track.trackId, "myTrack");
+
+    EXPECT_EQ(pc_create(&configuration, &offerPc), STATUS_SUCCESS);
+    EXPECT_EQ(STATUS_SUCCESS, pc_addTransceiver(offerPc, &track, &rtcRtpTransceiverInit, &pTransceiver));
+    EXPECT_EQ(STATUS_SUCCESS, pc_createOffer(offerPc, &sessionDescriptionInit));
+    EXPECT_PRED_FORMAT2(testing::IsSubstring, "rtpmap:127 H265/90000", sessionDescriptionInit.sdp);
+    EXPECT_PRED_FORMAT2(testing::IsSubstring, "fmtp:127 profile-id=1;tier-flag=0;level-id=93;tx-mode=SRST", sessionDescriptionInit.sdp);
+
+    pc_close(offerPc);
+    pc_free(&offerPc);
+}
+
+TEST_F(SdpApiTest, populateSingleMediaSection_TestAV1)
+{
+    CHAR remoteSessionDescription[] = R"(v=0
+o=- 7732334361409071710 2 IN IP4 127.0.0.1
+s=-
+t=0 0
+a=group:BUNDLE 0
+a=msid-semantic: WMS
+m=video 16485 UDP/TLS/RTP/SAVPF 96 41 42
+c=IN IP4 205.251.233.176
+a=rtcp:9 IN IP4 0.0.0.0
+a=ice-ufrag:9YRc
+a=ice-pwd:/ELMEiczRSsx2OEi2ynq+TbZ
+a=ice-options:trickle
+a=fingerprint:sha-256 51:04:F9:20:45:5C:9D:85:AF:D7:AF:FB:2B:F8:DB:24:66:7B:6A:E3:E3:EF:EC:72:93:6E:01:B8:C9:53:A6:31
+a=setup:actpass
+a=mid:1
+a=recvonly
+a=rtcp-mux
+a=rtcp-rsize
+a=rtpmap:96 VP8/90000
+a=rtpmap:41 AV1/90000
+a=fmtp:41 level-idx=5;profile=0;tier=0
+a=rtpmap:42 rtx/90000
+a=fmtp:42 apt=41
+)";
+
+    assertLFAndCRLF(remoteSessionDescription, ARRAY_SIZE(remoteSessionDescription) - 1, [](PCHAR sdp) {
+        PRtcPeerConnection pRtcPeerConnection = NULL;
+        PRtcRtpTransceiver pRtcRtpTransceiver = NULL;
+        RtcConfiguration rtcConfiguration;
+        RtcMediaStreamTrack rtcMediaStreamTrack;
+        RtcRtpTransceiverInit rtcRtpTransceiverInit;
+        RtcSessionDescriptionInit rtcSessionDescriptionInit;
+
+        MEMSET(&rtcConfiguration, 0x00, SIZEOF(RtcConfiguration));
+        MEMSET(&rtcMediaStreamTrack, 0x00, SIZEOF(RtcMediaStreamTrack));
+        MEMSET(&rtcSessionDescriptionInit, 0x00, SIZEOF(RtcSessionDescriptionInit));
+
+        EXPECT_EQ(pc_create(&rtcConfiguration, &pRtcPeerConnection), STATUS_SUCCESS);
+        EXPECT_EQ(pc_addSupportedCodec(pRtcPeerConnection, RTC_CODEC_AV1), STATUS_SUCCESS);
+
+        rtcRtpTransceiverInit.direction = RTC_RTP_TRANSCEIVER_DIRECTION_SENDONLY;
+        rtcMediaStreamTrack.kind = MEDIA_STREAM_TRACK_KIND_VIDEO;
+        rtcMediaStreamTrack.codec = RTC_CODEC_AV1;
+        STRCPY(rtcMediaStreamTrack.streamId, "myKvsVideoStream");
+        STRCPY(rtcMediaStreamTrack.trackId, "myTrack");
+        EXPECT_EQ(pc_addTransceiver(pRtcPeerConnection, &rtcMediaStreamTrack, &rtcRtpTransceiverInit, &pRtcRtpTransceiver), STATUS_SUCCESS);
+
+        STRCPY(rtcSessionDescriptionInit.sdp, (PCHAR) sdp);
+        rtcSessionDescriptionInit.type = SDP_TYPE_OFFER;
+        EXPECT_EQ(pc_setRemoteDescription(pRtcPeerConnection, &rtcSessionDescriptionInit), STATUS_SUCCESS);
+        EXPECT_EQ(pc_createAnswer(pRtcPeerConnection, &rtcSessionDescriptionInit), STATUS_SUCCESS);
+        EXPECT_PRED_FORMAT2(testing::IsSubstring, "video 9 UDP/TLS/RTP/SAVPF 41 42", rtcSessionDescriptionInit.sdp);
+        EXPECT_PRED_FORMAT2(testing::IsSubstring, "rtpmap:41 AV1/90000", rtcSessionDescriptionInit.sdp);
+        EXPECT_PRED_FORMAT2(testing::IsSubstring, "fmtp:41 level-idx=5;profile=0;tier=0", rtcSessionDescriptionInit.sdp);
+        EXPECT_PRED_FORMAT2(testing::IsSubstring, "fmtp:42 apt=41", rtcSessionDescriptionInit.sdp);
+        pc_close(pRtcPeerConnection);
+        pc_free(&pRtcPeerConnection);
+    });
+}
+
+TEST_F(SdpApiTest, populateSingleMediaSection_TestSimulcastOffer)
+{
+    PRtcPeerConnection offerPc = NULL;
+    RtcConfiguration configuration;
+    RtcSessionDescriptionInit sessionDescriptionInit;
+    RtcMediaStreamTrack track;
+    PRtcRtpTransceiver pTransceiver;
+    RtcRtpTransceiverInit rtcRtpTransceiverInit;
+
+    MEMSET(&configuration, 0x00, SIZEOF(RtcConfiguration));
+    MEMSET(&track, 0x00, SIZEOF(RtcMediaStreamTrack));
+    rtcRtpTransceiverInit.direction = RTC_RTP_TRANSCEIVER_DIRECTION_SENDONLY;
+    track.kind = MEDIA_STREAM_TRACK_KIND_VIDEO;
+    track.codec = RTC_CODEC_H264_PROFILE_42E01F_LEVEL_ASYMMETRY_ALLOWED_PACKETIZATION_MODE;
+    STRCPY(track.streamId, "myKvsVideoStream");
+    STRCPY(track.trackId, "myTrack");
+
+    EXPECT_EQ(pc_create(&configuration, &offerPc), STATUS_SUCCESS);
+    EXPECT_EQ(STATUS_SUCCESS, pc_addTransceiver(offerPc, &track, &rtcRtpTransceiverInit, &pTransceiver));
+    EXPECT_EQ(STATUS_RTP_INVALID_RID, rtp_transceiver_addSimulcastEncoding(pTransceiver, (PCHAR) ""));
+    EXPECT_EQ(STATUS_RTP_INVALID_RID, rtp_transceiver_addSimulcastEncoding(pTransceiver, (PCHAR) "h;l"));
+    EXPECT_EQ(STATUS_RTP_INVALID_RID, rtp_transceiver_addSimulcastEncoding(pTransceiver, (PCHAR) "a-rid-which-is-too-long"));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_transceiver_addSimulcastEncoding(pTransceiver, (PCHAR) "h"));
+    EXPECT_EQ(STATUS_RTP_INVALID_RID, rtp_transceiver_addSimulcastEncoding(pTransceiver, (PCHAR) "h"));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_transceiver_addSimulcastEncoding(pTransceiver, (PCHAR) "m"));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_transceiver_addSimulcastEncoding(pTransceiver, (PCHAR) "l"));
+    EXPECT_EQ(STATUS_RTP_MAX_ENCODINGS_EXCEEDED, rtp_transceiver_addSimulcastEncoding(pTransceiver, (PCHAR) "q"));
+    EXPECT_EQ(3, rtp_transceiver_getEncodingCount((PKvsRtpTransceiver) pTransceiver));
+    EXPECT_NE(rtp_transceiver_getSender((PKvsRtpTransceiver) pTransceiver, 1)->ssrc,
+              rtp_transceiver_getSender((PKvsRtpTransceiver) pTransceiver, 2)->ssrc);
+
+    EXPECT_EQ(STATUS_SUCCESS, pc_createOffer(offerPc, &sessionDescriptionInit));
+    EXPECT_PRED_FORMAT2(testing::IsSubstring, "a=extmap:4 " MID_EXT_URL, sessionDescriptionInit.sdp);
+    EXPECT_PRED_FORMAT2(testing::IsSubstring, "a=extmap:10 " RID_EXT_URL, sessionDescriptionInit.sdp);
+    EXPECT_PRED_FORMAT2(testing::IsSubstring, "a=rid:h send", sessionDescriptionInit.sdp);
+    EXPECT_PRED_FORMAT2(testing::IsSubstring, "a=rid:m send", sessionDescriptionInit.sdp);
+    EXPECT_PRED_FORMAT2(testing::IsSubstring, "a=rid:l send", sessionDescriptionInit.sdp);
+    EXPECT_PRED_FORMAT2(testing::IsSubstring, "a=simulcast:send h;m;l", sessionDescriptionInit.sdp);
+    EXPECT_PRED_FORMAT2(testing::IsNotSubstring, ABS_SEND_TIME_EXT_URL, sessionDescriptionInit.sdp);
+    // Nothing is negotiated before the answer
+    EXPECT_FALSE(((PKvsRtpTransceiver) pTransceiver)->simulcastNegotiated);
+
+    pc_close(offerPc);
+    pc_free(&offerPc);
+
+    // Simulcast is video only
+    track.kind = MEDIA_STREAM_TRACK_KIND_AUDIO;
+    track.codec = RTC_CODEC_OPUS;
+    EXPECT_EQ(pc_create(&configuration, &offerPc), STATUS_SUCCESS);
+    EXPECT_EQ(STATUS_SUCCESS, pc_addTransceiver(offerPc, &track, &rtcRtpTransceiverInit, &pTransceiver));
+    EXPECT_EQ(STATUS_INVALID_OPERATION, rtp_transceiver_addSimulcastEncoding(pTransceiver, (PCHAR) "h"));
+    EXPECT_EQ(STATUS_SUCCESS, pc_createOffer(offerPc, &sessionDescriptionInit));
+    EXPECT_PRED_FORMAT2(testing::IsNotSubstring, "a=simulcast", sessionDescriptionInit.sdp);
+    EXPECT_PRED_FORMAT2(testing::IsNotSubstring, RID_EXT_URL, sessionDescriptionInit.sdp);
+
+    pc_close(offerPc);
+    pc_free(&offerPc);
+}
+
+TEST_F(SdpApiTest, populateSingleMediaSection_TestSimulcastAnswer)
+{
+    CHAR remoteSessionDescription[] = R"(v=0
+o=- 7732334361409071710 2 IN IP4 127.0.0.1
+s=-
+t=0 0
+a=group:BUNDLE 0
+a=msid-semantic: WMS
+m=video 16485 UDP/TLS/RTP/SAVPF 125 126
+c=IN IP4 205.251.233.176
+a=rtcp:9 IN IP4 0.0.0.0
+a=ice-ufrag:9YRc
+a=ice-pwd:/ELMEiczRSsx2OEi2ynq+TbZ
+a=ice-options:trickle
+a=fingerprint:sha-256 51:04:F9:20:45:5C:9D:85:AF:D7:AF:FB:2B:F8:DB:24:66:7B:6A:E3:E3:EF:EC:72:93:6E:01:B8:C9:53:A6:31
+a=setup:actpass
+a=mid:0
+a=extmap:3 urn:ietf:params:rtp-hdrext:sdes:mid
+a=extmap:5 urn:ietf:params:rtp-hdrext:sdes:rtp-stream-id
+a=extmap:6 urn:ietf:params:rtp-hdrext:sdes:repaired-rtp-stream-id
+a=extmap:2 http://www.webrtc.org/experiments/rtp-hdrext/abs-send-time
+a=extmap:13 urn:3gpp:video-orientation
+a=recvonly
+a=rtcp-mux
+a=rtcp-rsize
+a=rtpmap:125 H264/90000
+a=fmtp:125 level-asymmetry-allowed=1;packetization-mode=1;profile-level-id=42e01f
+a=rtpmap:126 rtx/90000
+a=fmtp:126 apt=125
+a=rid:h recv
+a=rid:l recv
+a=simulcast:recv h;l
+)";
+
+    assertLFAndCRLF(remoteSessionDescription, ARRAY_SIZE(remoteSessionDescription) - 1, [](PCHAR sdp) {
+        PRtcPeerConnection pRtcPeerConnection = NULL;
+        PRtcRtpTransceiver pRtcRtpTransceiver = NULL;
+        RtcConfiguration rtcConfiguration;
+        RtcMediaStreamTrack rtcMediaStreamTrack;
+        RtcRtpTransceiverInit rtcRtpTransceiverInit;
+        RtcSessionDescriptionInit rtcSessionDescriptionInit;
+        PKvsRtpTransceiver pKvsRtpTransceiver;
+        BOOL missingRid;
+
+        MEMSET(&rtcMediaStreamTrack, 0x00, SIZEOF(RtcMediaStreamTrack));
+        rtcRtpTransceiverInit.direction = RTC_RTP_TRANSCEIVER_DIRECTION_SENDONLY;
+        rtcMediaStreamTrack.kind = MEDIA_STREAM_TRACK_KIND_VIDEO;
+        rtcMediaStreamTrack.codec = RTC_CODEC_H264_PROFILE_42E01F_LEVEL_ASYMMETRY_ALLOWED_PACKETIZATION_MODE;
+        STRCPY(rtcMediaStreamTrack.streamId, "myKvsVideoStream");
+        STRCPY(rtcMediaStreamTrack.trackId, "myTrack");
+
+        // The answer only sends simulcast when the offer receives every rid
+        for (missingRid = FALSE; missingRid <= TRUE; missingRid++) {
+            MEMSET(&rtcConfiguration, 0x00, SIZEOF(RtcConfiguration));
+            MEMSET(&rtcSessionDescriptionInit, 0x00, SIZEOF(RtcSessionDescriptionInit));
+            EXPECT_EQ(pc_create(&rtcConfiguration, &pRtcPeerConnection), STATUS_SUCCESS);
+            EXPECT_EQ(pc_addTransceiver(pRtcPeerConnection, &rtcMediaStreamTrack, &rtcRtpTransceiverInit, &pRtcRtpTransceiver), STATUS_SUCCESS);
+            pKvsRtpTransceiver = (PKvsRtpTransceiver) pRtcRtpTransceiver;
+            EXPECT_EQ(STATUS_SUCCESS, rtp_transceiver_addSimulcastEncoding(pRtcRtpTransceiver, (PCHAR) "h"));
+            EXPECT_EQ(STATUS_SUCCESS, rtp_transceiver_addSimulcastEncoding(pRtcRtpTransceiver, (PCHAR) (missingRid ? "m" : "l")));
+
+            STRCPY(rtcSessionDescriptionInit.sdp, (PCHAR) sdp);
+            rtcSessionDescriptionInit.type = SDP_TYPE_OFFER;
+            EXPECT_EQ(pc_setRemoteDescription(pRtcPeerConnection, &rtcSessionDescriptionInit), STATUS_SUCCESS);
+            // The buffers of the encodings exist once the payload types are known
+            EXPECT_NE((PRtpRollingBuffer) NULL, rtp_transceiver_getSender(pKvsRtpTransceiver, 1)->packetBuffer);
+            EXPECT_EQ(STATUS_INVALID_OPERATION, rtp_transceiver_addSimulcastEncoding(pRtcRtpTransceiver, (PCHAR) "q"));
+            EXPECT_EQ(pc_createAnswer(pRtcPeerConnection, &rtcSessionDescriptionInit), STATUS_SUCCESS);
+            // The extensions which are only read are accepted with the ids of the offer
+            EXPECT_PRED_FORMAT2(testing::IsSubstring, "a=extmap:2 " ABS_SEND_TIME_EXT_URL, rtcSessionDescriptionInit.sdp);
+            EXPECT_PRED_FORMAT2(testing::IsSubstring, "a=extmap:13 " VIDEO_ORIENTATION_EXT_URL, rtcSessionDescriptionInit.sdp);
+            EXPECT_PRED_FORMAT2(testing::IsNotSubstring, ABS_CAPTURE_TIME_EXT_URL, rtcSessionDescriptionInit.sdp);
+            EXPECT_EQ(13, ((PKvsPeerConnection) pRtcPeerConnection)->extensionMap.ids[RTP_EXTENSION_VIDEO_ORIENTATION]);
+
+            if (missingRid) {
+                EXPECT_FALSE(pKvsRtpTransceiver->simulcastNegotiated);
+                EXPECT_PRED_FORMAT2(testing::IsNotSubstring, "a=simulcast", rtcSessionDescriptionInit.sdp);
+                EXPECT_PRED_FORMAT2(testing::IsNotSubstring, RID_EXT_URL, rtcSessionDescriptionInit.sdp);
+            } else {
+                EXPECT_TRUE(pKvsRtpTransceiver->simulcastNegotiated);
+                EXPECT_PRED_FORMAT2(testing::IsSubstring, "a=extmap:3 " MID_EXT_URL, rtcSessionDescriptionInit.sdp);
+                EXPECT_PRED_FORMAT2(testing::IsSubstring, "a=extmap:5 " RID_EXT_URL, rtcSessionDescriptionInit.sdp);
+                EXPECT_PRED_FORMAT2(testing::IsSubstring, "a=extmap:6 " RRID_EXT_URL, rtcSessionDescriptionInit.sdp);
+                EXPECT_PRED_FORMAT2(testing::IsSubstring, "a=rid:h send", rtcSessionDescriptionInit.sdp);
+                EXPECT_PRED_FORMAT2(testing::IsSubstring, "a=simulcast:send h;l", rtcSessionDescriptionInit.sdp);
+                // The packets of the encodings leave room for the mid and rid elements
+                EXPECT_GT(rtp_getPayloadMtu((PKvsPeerConnection) pRtcPeerConnection),
+                          rtp_transceiver_getPayloadMtu(pKvsRtpTransceiver, rtp_transceiver_getSender(pKvsRtpTransceiver, 1)));
+            }
+
+            pc_close(pRtcPeerConnection);
+            pc_free(&pRtcPeerConnection);
+        }
+    });
+}
+
 } // namespace webrtcclient
 } // namespace video
 } // namespace kinesis
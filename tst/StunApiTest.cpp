@@ -221,6 +221,36 @@ TEST_F(StunApiTest, appendStunAttributeValidityTests)
     EXPECT_NE(STATUS_SUCCESS, stun_attribute_appendUsername(pStunPacket, NULL));
 
     EXPECT_NE(STATUS_SUCCESS, stun_attribute_appendPriority(NULL, 0));
+    EXPECT_NE(STATUS_SUCCESS, stun_attribute_appendPadding(NULL, 4));
+}
+
+TEST_F(StunApiTest, paddedPacketRoundTrip)
+{
+    PStunPacket pStunPacket = NULL, pDeserializedPacket = NULL;
+    PStunAttributeHeader pAttribute = NULL;
+    BYTE buffer[STUN_PACKET_ALLOCATION_SIZE];
+    UINT32 size = SIZEOF(buffer), unpaddedSize = 0, passwordLen = STRLEN(TEST_STUN_PASSWORD) * SIZEOF(CHAR);
+
+    EXPECT_EQ(STATUS_SUCCESS, stun_createPacket(STUN_PACKET_TYPE_BINDING_REQUEST, NULL, &pStunPacket));
+    EXPECT_EQ(STATUS_SUCCESS, stun_attribute_appendUsername(pStunPacket, (PCHAR) "abc:def"));
+    EXPECT_EQ(STATUS_SUCCESS, stun_serializePacket(pStunPacket, (PBYTE) TEST_STUN_PASSWORD, passwordLen, TRUE, TRUE, NULL, &unpaddedSize));
+
+    // The padding is rounded up to a multiple of 4 and does not fit beyond the allocation of the packet
+    EXPECT_EQ(STATUS_STUN_NOT_ENOUGH_MEMORY, stun_attribute_appendPadding(pStunPacket, STUN_PACKET_ALLOCATION_SIZE));
+    EXPECT_EQ(STATUS_SUCCESS, stun_attribute_appendPadding(pStunPacket, 1001));
+    EXPECT_EQ(STATUS_SUCCESS, stun_serializePacket(pStunPacket, (PBYTE) TEST_STUN_PASSWORD, passwordLen, TRUE, TRUE, buffer, &size));
+    EXPECT_EQ(unpaddedSize + STUN_ATTRIBUTE_HEADER_LEN + 1004, size);
+
+    // The message integrity and the fingerprint cover the padding
+    EXPECT_EQ(STATUS_SUCCESS, stun_deserializePacket(buffer, size, (PBYTE) TEST_STUN_PASSWORD, passwordLen, &pDeserializedPacket));
+    EXPECT_EQ(STATUS_SUCCESS, stun_attribute_getByType(pDeserializedPacket, STUN_ATTRIBUTE_TYPE_PADDING, &pAttribute));
+    EXPECT_TRUE(pAttribute != NULL);
+    if (pAttribute != NULL) {
+        EXPECT_EQ(1004, pAttribute->length);
+    }
+
+    EXPECT_EQ(STATUS_SUCCESS, stun_freePacket(&pDeserializedPacket));
+    EXPECT_EQ(STATUS_SUCCESS, stun_freePacket(&pStunPacket));
 }
 
 } // namespace webrtcclient
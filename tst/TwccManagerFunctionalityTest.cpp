@@ -0,0 +1,302 @@
+#include "WebRTCClientTestFixture.h"
+
+namespace com {
+namespace amazonaws {
+namespace kinesis {
+namespace video {
+namespace webrtcclient {
+
+class TwccManagerFunctionalityTest : public WebRtcClientTestBase {
+};
+
+#define TWCC_TEST_START_TIME  (10 * HUNDREDS_OF_NANOS_IN_A_SECOND)
+#define TWCC_TEST_PACKET_SIZE 250
+
+static UINT32 twccTargetBitrateCallCount;
+static UINT64 twccLastTargetBitrate;
+
+static VOID testTwccOnTargetBitrate(UINT64 customData, UINT64 targetBitrate)
+{
+    UNUSED_PARAM(customData);
+    twccTargetBitrateCallCount++;
+    twccLastTargetBitrate = targetBitrate;
+}
+
+// Builds a feedback out of two-bit status vector chunks with large deltas, a negative receive time marks a lost packet
+static UINT32 buildTwccFeedback(PBYTE pBuffer, UINT16 baseSeqNum, PINT64 pReceiveTimes, UINT16 count)
+{
+    UINT32 i, j, offset = TWCC_FEEDBACK_HEADER_LEN;
+    UINT16 chunk;
+    INT64 referenceTime = -1, prevReceiveTime;
+
+    for (i = 0; i < count && referenceTime < 0; i++) {
+        if (pReceiveTimes[i] >= 0) {
+            referenceTime = pReceiveTimes[i] / TWCC_FEEDBACK_REFERENCE_TIME_UNIT;
+        }
+    }
+    referenceTime = MAX(referenceTime, 0);
+    prevReceiveTime = referenceTime * TWCC_FEEDBACK_REFERENCE_TIME_UNIT;
+
+    putUnalignedInt32BigEndian(pBuffer, 0x12345678);
+    putUnalignedInt32BigEndian(pBuffer + 4, 0x1234ABCD);
+    putUnalignedInt16BigEndian(pBuffer + 8, baseSeqNum);
+    putUnalignedInt16BigEndian(pBuffer + 10, count);
+    putUnalignedInt32BigEndian(pBuffer + 12, (UINT32) (referenceTime << 8));
+
+    for (i = 0; i < count; i += 7) {
+        chunk = TWCC_FEEDBACK_CHUNK_TYPE_MASK | TWCC_FEEDBACK_SYMBOL_SIZE_MASK;
+        for (j = 0; j < 7 && i + j < count; j++) {
+            if (pReceiveTimes[i + j] >= 0) {
+                chunk |= TWCC_PACKET_STATUS_LARGE_DELTA << (12 - 2 * j);
+            }
+        }
+        putUnalignedInt16BigEndian(pBuffer + offset, chunk);
+        offset += TWCC_FEEDBACK_CHUNK_LEN;
+    }
+
+    for (i = 0; i < count; i++) {
+        if (pReceiveTimes[i] >= 0) {
+            putUnalignedInt16BigEndian(pBuffer + offset, (UINT16) ((pReceiveTimes[i] - prevReceiveTime) / TWCC_FEEDBACK_DELTA_UNIT));
+            prevReceiveTime = pReceiveTimes[i];
+            offset += 2;
+        }
+    }
+
+    return offset;
+}
+
+// Sends 10 packets 10ms apart and feeds back their arrival 100ms later, every packet queues delayGrowth longer than the one before it
+static VOID runTwccRound(PTwccManager pTwccManager, UINT32 round, INT64 delayGrowth, BOOL loseHalf, PINT64 pDelay)
+{
+    BYTE feedback[256];
+    INT64 receiveTimes[10];
+    UINT64 sendTime;
+    UINT16 baseSeqNum = (UINT16) (round * ARRAY_SIZE(receiveTimes));
+    UINT32 i, feedbackLen;
+
+    for (i = 0; i < ARRAY_SIZE(receiveTimes); i++) {
+        sendTime = TWCC_TEST_START_TIME + (round * ARRAY_SIZE(receiveTimes) + i) * 10 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND;
+        EXPECT_EQ(STATUS_SUCCESS, twcc_manager_onPacketSent(pTwccManager, baseSeqNum + i, TWCC_TEST_PACKET_SIZE, sendTime));
+        *pDelay += delayGrowth;
+        receiveTimes[i] = loseHalf && (i % 2) == 1 ? -1 : (INT64) sendTime + 20 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND + *pDelay;
+    }
+
+    feedbackLen = buildTwccFeedback(feedback, baseSeqNum, receiveTimes, ARRAY_SIZE(receiveTimes));
+    EXPECT_EQ(STATUS_SUCCESS,
+              twcc_manager_onFeedback(pTwccManager, feedback, feedbackLen,
+                                      TWCC_TEST_START_TIME + (round + 1) * 100 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND + *pDelay));
+}
+
+TEST_F(TwccManagerFunctionalityTest, sequenceNumberRoundTripsThroughTheHeaderExtension)
+{
+    PRtpPacket pRtpPacket = NULL, pParsedRtpPacket = NULL;
+    BYTE payload[] = {0x01, 0x02, 0x03, 0x04};
+    BYTE extPayload[TWCC_EXT_PAYLOAD_LEN] = {0};
+    BYTE rawPacket[128];
+    UINT32 packetLen = ARRAY_SIZE(rawPacket);
+    UINT16 seqNum = 0;
+
+    // A padding byte in front of the element is skipped
+    extPayload[1] = (DEFAULT_TWCC_EXT_ID << RTP_ONE_BYTE_EXTENSION_ID_SHIFT) | 1;
+    putUnalignedInt16BigEndian(extPayload + 2, 0xBEEF);
+
+    EXPECT_EQ(STATUS_SUCCESS,
+              rtp_packet_create(2, FALSE, TRUE, 0, FALSE, 96, 1, 1000, 0x1234ABCD, NULL, RTP_ONE_BYTE_EXTENSION_PROFILE, ARRAY_SIZE(extPayload),
+                                extPayload, payload, ARRAY_SIZE(payload), &pRtpPacket));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_createBytesFromPacket(pRtpPacket, rawPacket, &packetLen));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_createFromBytes(rawPacket, packetLen, &pParsedRtpPacket));
+
+    EXPECT_EQ(STATUS_SUCCESS, twcc_manager_getSequenceNumber(pParsedRtpPacket, DEFAULT_TWCC_EXT_ID, &seqNum));
+    EXPECT_EQ(0xBEEF, seqNum);
+    EXPECT_EQ(STATUS_RTP_EXTENSION_NOT_FOUND, twcc_manager_getSequenceNumber(pParsedRtpPacket, DEFAULT_TWCC_EXT_ID + 1, &seqNum));
+
+    // The raw packet lives on the stack
+    pParsedRtpPacket->pRawPacket = NULL;
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_free(&pParsedRtpPacket));
+    EXPECT_EQ(STATUS_SUCCESS, rtp_packet_free(&pRtpPacket));
+}
+
+TEST_F(TwccManagerFunctionalityTest, feedbackMarksReceivedAndLostPackets)
+{
+    PTwccManager pTwccManager = NULL;
+    UINT32 i;
+    // base seq 65530 wraps, 10 packets at the reference time of 64ms: a two-bit status vector of seven with seq 65532 and 65535 lost,
+    // then a run of three small deltas
+    BYTE feedback[] = {0x12, 0x34, 0x56, 0x78, 0x12, 0x34, 0xAB, 0xCD, 0xFF, 0xFA, 0x00, 0x0A, 0x00, 0x00, 0x01, 0x00,
+                       0xD4, 0x51, 0x20, 0x03, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x00, 0x00, 0x00};
+
+    EXPECT_EQ(STATUS_SUCCESS, twcc_manager_create(NULL, 0, &pTwccManager));
+    for (i = 0; i < 10; i++) {
+        EXPECT_EQ(STATUS_SUCCESS,
+                  twcc_manager_onPacketSent(pTwccManager, (UINT16) (65530 + i), 1000, TWCC_TEST_START_TIME + i * HUNDREDS_OF_NANOS_IN_A_MILLISECOND));
+    }
+
+    EXPECT_EQ(STATUS_RTCP_INPUT_TWCC_INVALID, twcc_manager_onFeedback(pTwccManager, feedback, TWCC_FEEDBACK_HEADER_LEN + 2, GETTIME()));
+    EXPECT_EQ(STATUS_SUCCESS, twcc_manager_onFeedback(pTwccManager, feedback, ARRAY_SIZE(feedback), GETTIME()));
+
+    for (i = 0; i < 10; i++) {
+        PTwccPacketInfo pPacketInfo = &pTwccManager->history[(UINT16) (65530 + i) % TWCC_SEND_HISTORY_SIZE];
+        EXPECT_TRUE(pPacketInfo->reported);
+        EXPECT_EQ((BOOL) (i != 2 && i != 5), pPacketInfo->received);
+    }
+    // Every received packet arrived 1ms after the one before it
+    EXPECT_EQ(64 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND + 1 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND,
+              pTwccManager->history[65530 % TWCC_SEND_HISTORY_SIZE].receiveTime);
+    EXPECT_EQ(64 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND + 8 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND,
+              pTwccManager->history[(UINT16) (65530 + 9) % TWCC_SEND_HISTORY_SIZE].receiveTime);
+    EXPECT_DOUBLE_EQ(0.2, pTwccManager->fractionLost);
+
+    EXPECT_EQ(STATUS_SUCCESS, twcc_manager_free(&pTwccManager));
+    EXPECT_EQ(NULL, pTwccManager);
+}
+
+TEST_F(TwccManagerFunctionalityTest, targetBitrateFollowsTheQueuingDelay)
+{
+    PTwccManager pTwccManager = NULL;
+    UINT32 round;
+    INT64 delay = 0;
+    UINT64 steadyBitrate;
+
+    twccTargetBitrateCallCount = 0;
+    twccLastTargetBitrate = 0;
+    EXPECT_EQ(STATUS_SUCCESS, twcc_manager_create(testTwccOnTargetBitrate, 0, &pTwccManager));
+
+    // The path keeps up, the estimate grows
+    for (round = 0; round < 30; round++) {
+        runTwccRound(pTwccManager, round, 0, FALSE, &delay);
+    }
+    EXPECT_EQ(TWCC_BANDWIDTH_USAGE_NORMAL, pTwccManager->usage);
+    EXPECT_LT(TWCC_DEFAULT_START_BITRATE, pTwccManager->targetBitrate);
+    EXPECT_LT(0, twccTargetBitrateCallCount);
+    steadyBitrate = pTwccManager->targetBitrate;
+
+    // The queues build up, the estimate backs off below the acked bitrate
+    for (; round < 40; round++) {
+        runTwccRound(pTwccManager, round, 2 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND, FALSE, &delay);
+    }
+    EXPECT_GT(steadyBitrate, pTwccManager->targetBitrate);
+    EXPECT_GT(pTwccManager->ackedBitrate, (DOUBLE) pTwccManager->targetBitrate);
+    EXPECT_GT(steadyBitrate, twccLastTargetBitrate);
+
+    EXPECT_EQ(STATUS_SUCCESS, twcc_manager_free(&pTwccManager));
+}
+
+TEST_F(TwccManagerFunctionalityTest, targetBitrateBacksOffOnLoss)
+{
+    PTwccManager pTwccManager = NULL;
+    UINT32 round;
+    INT64 delay = 0;
+
+    twccTargetBitrateCallCount = 0;
+    twccLastTargetBitrate = 0;
+    EXPECT_EQ(STATUS_SUCCESS, twcc_manager_create(testTwccOnTargetBitrate, 0, &pTwccManager));
+
+    for (round = 0; round < 10; round++) {
+        runTwccRound(pTwccManager, round, 0, TRUE, &delay);
+    }
+    EXPECT_DOUBLE_EQ(0.5, pTwccManager->fractionLost);
+    EXPECT_EQ(TWCC_DEFAULT_MIN_BITRATE, pTwccManager->targetBitrate);
+    EXPECT_GT(TWCC_DEFAULT_START_BITRATE / 2, twccLastTargetBitrate);
+
+    EXPECT_EQ(STATUS_SUCCESS, twcc_manager_free(&pTwccManager));
+}
+
+
+TEST_F(TwccManagerFunctionalityTest, receiverFeedbackIsUnderstoodBySender)
+{
+    PTwccManager pTwccManager = NULL;
+    PTwccReceiver pTwccReceiver = NULL;
+    BYTE feedback[TWCC_FEEDBACK_MAX_LEN];
+    UINT32 i, feedbackLen = 0;
+    BOOL more = TRUE;
+    // 65534 is lost and 1 arrives late, out of order
+    UINT16 seqNums[] = {65530, 65531, 65532, 65533, 65535, 0, 2, 3, 1};
+    UINT64 arrivalTimes[] = {1, 2, 3, 40, 41, 42, 50, 51, 52};
+
+    EXPECT_EQ(STATUS_SUCCESS, twcc_manager_create(NULL, 0, &pTwccManager));
+    EXPECT_EQ(STATUS_SUCCESS, twcc_receiver_create(&pTwccReceiver));
+
+    // Nothing to report yet
+    EXPECT_EQ(STATUS_SUCCESS, twcc_receiver_createFeedback(pTwccReceiver, feedback, &feedbackLen, &more));
+    EXPECT_EQ(0, feedbackLen);
+    EXPECT_FALSE(more);
+
+    for (i = 65530; i < 65530 + 10; i++) {
+        EXPECT_EQ(STATUS_SUCCESS, twcc_manager_onPacketSent(pTwccManager, (UINT16) i, 1000, TWCC_TEST_START_TIME + i));
+    }
+    for (i = 0; i < ARRAY_SIZE(seqNums); i++) {
+        EXPECT_EQ(STATUS_SUCCESS,
+                  twcc_receiver_onPacketReceived(pTwccReceiver, 0x1234ABCD, seqNums[i],
+                                                 TWCC_TEST_START_TIME + arrivalTimes[i] * HUNDREDS_OF_NANOS_IN_A_MILLISECOND));
+    }
+
+    EXPECT_EQ(STATUS_SUCCESS, twcc_receiver_createFeedback(pTwccReceiver, feedback, &feedbackLen, &more));
+    EXPECT_FALSE(more);
+    EXPECT_EQ(0, feedbackLen % RTCP_PACKET_LEN_WORD_SIZE);
+    EXPECT_EQ(TWCC_FEEDBACK_FMT, feedback[0] & 0x1F);
+    EXPECT_EQ(RTCP_PACKET_TYPE_GENERIC_RTP_FEEDBACK, feedback[RTCP_PACKET_TYPE_OFFSET]);
+    EXPECT_EQ(feedbackLen / RTCP_PACKET_LEN_WORD_SIZE - 1, getUnalignedInt16BigEndian(feedback + RTCP_PACKET_LEN_OFFSET));
+    EXPECT_EQ(0x1234ABCD, getUnalignedInt32BigEndian(feedback + RTCP_PACKET_HEADER_LEN + 4));
+    EXPECT_EQ(65530, getUnalignedInt16BigEndian(feedback + RTCP_PACKET_HEADER_LEN + 8));
+    EXPECT_EQ(10, getUnalignedInt16BigEndian(feedback + RTCP_PACKET_HEADER_LEN + 10));
+
+    EXPECT_EQ(STATUS_SUCCESS,
+              twcc_manager_onFeedback(pTwccManager, feedback + RTCP_PACKET_HEADER_LEN, feedbackLen - RTCP_PACKET_HEADER_LEN, GETTIME()));
+    for (i = 0; i < 10; i++) {
+        EXPECT_EQ((BOOL) (i != 4), pTwccManager->history[(UINT16) (65530 + i) % TWCC_SEND_HISTORY_SIZE].received);
+    }
+    // The sender sees the arrival times relative to each other
+    EXPECT_EQ(38 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND,
+              pTwccManager->history[65533 % TWCC_SEND_HISTORY_SIZE].receiveTime - pTwccManager->history[65531 % TWCC_SEND_HISTORY_SIZE].receiveTime);
+    EXPECT_EQ(10 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND,
+              pTwccManager->history[1].receiveTime - pTwccManager->history[0].receiveTime);
+    EXPECT_EQ(-2 * HUNDREDS_OF_NANOS_IN_A_MILLISECOND,
+              pTwccManager->history[2].receiveTime - pTwccManager->history[1].receiveTime);
+
+    // Everything is reported, a late duplicate is not reported again
+    EXPECT_EQ(STATUS_SUCCESS, twcc_receiver_onPacketReceived(pTwccReceiver, 0x1234ABCD, 65534, TWCC_TEST_START_TIME));
+    EXPECT_EQ(STATUS_SUCCESS, twcc_receiver_createFeedback(pTwccReceiver, feedback, &feedbackLen, &more));
+    EXPECT_EQ(0, feedbackLen);
+
+    EXPECT_EQ(STATUS_SUCCESS, twcc_receiver_free(&pTwccReceiver));
+    EXPECT_EQ(STATUS_SUCCESS, twcc_manager_free(&pTwccManager));
+}
+
+TEST_F(TwccManagerFunctionalityTest, receiverSplitsLongRangesIntoSeveralFeedbacks)
+{
+    PTwccReceiver pTwccReceiver = NULL;
+    BYTE feedback[TWCC_FEEDBACK_MAX_LEN];
+    UINT32 i, feedbackLen = 0, feedbackCount = 0, statusCount = 0;
+    BOOL more = TRUE;
+
+    EXPECT_EQ(STATUS_SUCCESS, twcc_receiver_create(&pTwccReceiver));
+    // Every third packet is lost, a packet arrives far too late now and then so that the deltas run out of range
+    for (i = 0; i < 600; i++) {
+        if (i % 3 != 0) {
+            EXPECT_EQ(STATUS_SUCCESS,
+                      twcc_receiver_onPacketReceived(pTwccReceiver, 0x1234ABCD, (UINT16) i,
+                                                     TWCC_TEST_START_TIME + i * (i % 50 == 1 ? 100 : 1) * HUNDREDS_OF_NANOS_IN_A_MILLISECOND));
+        }
+    }
+
+    while (more) {
+        EXPECT_EQ(STATUS_SUCCESS, twcc_receiver_createFeedback(pTwccReceiver, feedback, &feedbackLen, &more));
+        EXPECT_GE(TWCC_FEEDBACK_MAX_LEN, feedbackLen);
+        // Packet 0 is lost, the first feedback starts at the first received packet
+        EXPECT_EQ(1 + statusCount, getUnalignedInt16BigEndian(feedback + RTCP_PACKET_HEADER_LEN + 8));
+        EXPECT_EQ(feedbackCount, feedback[RTCP_PACKET_HEADER_LEN + 15]);
+        statusCount += getUnalignedInt16BigEndian(feedback + RTCP_PACKET_HEADER_LEN + 10);
+        feedbackCount++;
+    }
+    EXPECT_LT(1, feedbackCount);
+    // Up to the highest received packet, 599
+    EXPECT_EQ(599, statusCount);
+
+    EXPECT_EQ(STATUS_SUCCESS, twcc_receiver_free(&pTwccReceiver));
+}
+
+} // namespace webrtcclient
+} // namespace video
+} // namespace kinesis
+} // namespace amazonaws
+} // namespace com